@@ -195,7 +195,19 @@ int SlicerAppMain(int argc, char* argv[])
   if (app.commandOptions()->verbose())
     {
     qDebug() << "Number of loaded modules:" << moduleManager->modulesNames().count();
+    if (moduleFactoryManager->loadModulesOnDemand())
+      {
+      qDebug() << "Number of modules loaded on demand:"
+               << moduleFactoryManager->deferredModuleNames().count();
+      }
     }
+  if (app.commandOptions()->displayModuleStartupProfile())
+    {
+    moduleFactoryManager->printStartupProfile();
+    }
+  // Decide next time which modules can be loaded on demand
+  app.revisionUserSettings()->setValue(
+    "Modules/Metadata", moduleFactoryManager->modulesMetadata());
 
   splashMessage(splashScreen, QString());
 
@@ -217,7 +229,12 @@ int SlicerAppMain(int argc, char* argv[])
 
   // Look at QApplication::exec() documentation, it is recommended to connect
   // clean up code to the aboutToQuit() signal
-  return app.exec();
+  int res = app.exec();
+
+  // Include the modules loaded on demand during the session
+  app.revisionUserSettings()->setValue(
+    "Modules/Metadata", moduleFactoryManager->modulesMetadata());
+  return res;
 }
 
 } // end of anonymous namespace
@@ -1034,6 +1034,9 @@ void qSlicerAppMainWindow::onFileRecentLoadedActionTriggered()
       static_cast<qSlicerIO::IOFileType>(
         fileProperties.find("fileType").value().toString());
 
+  // the user can follow and cancel the load
+  fileProperties["interactive"] = true;
+
   qSlicerApplication* app = qSlicerApplication::application();
   app->coreIOManager()->loadNodes(fileType, fileProperties);
 }
@@ -22,6 +22,8 @@
 
 // STD includes
 #include <cassert>
+#include <map>
+#include <queue>
 
 #ifdef linux
 #include "unistd.h"
@@ -51,10 +53,44 @@ vtkStandardNewMacro ( vtkDataIOManagerLogic );
 
 typedef std::pair< vtkDataTransfer *, vtkMRMLNode * > TransferNodePair;
 
+//----------------------------------------------------------------------------
+class PendingDownloadQueue
+  : public std::queue<std::vector<vtkSmartPointer<vtkDataTransfer> > > {};
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct DownloadBatch
+{
+  std::vector<vtkDataTransfer*> Transfers;
+  std::vector<size_t> Groups;
+  std::vector<std::string> Sources;
+  std::vector<std::string> Destinations;
+};
+
+//----------------------------------------------------------------------------
+struct DownloadState
+{
+  vtkDataIOManagerLogic* Logic;
+  int AsynchronousIO;
+  DownloadBatch* Batch;
+  /// First transfer of each group, NULL if it is not downloaded
+  std::vector<vtkDataTransfer*> StorageNodeTransfers;
+  std::vector<int> RemainingFiles;
+  size_t NumberOfFiles;
+  size_t NumberOfFilesInPreviousBatches;
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkDataIOManagerLogic::vtkDataIOManagerLogic()
 {
   this->DataIOManager = NULL;
+  this->InternalPendingDownloads = new PendingDownloadQueue;
+  this->PendingDownloadsLock = itk::MutexLock::New();
+  this->DownloadProgress = 1.;
 
   this->DataIOObserverManager = vtkObserverManager::New();
   this->DataIOObserverManager->GetCallbackCommand()->SetClientData(this);
@@ -78,6 +114,7 @@ vtkDataIOManagerLogic::~vtkDataIOManagerLogic()
     {
     this->DataIOObserverManager->Delete();
     }
+  delete this->InternalPendingDownloads;
 }
 
 
@@ -384,115 +421,87 @@ int vtkDataIOManagerLogic::QueueRead ( vtkMRMLNode *node )
     return 0;
     }
 
-  //--- construct and add a record of the transfer
+  //--- construct and add a record of the transfer of each file
   //--- which includes the ID of associated node
-  vtkNew<vtkDataTransfer> transfer0;
-  transfer0->SetTransferID ( this->GetDataIOManager()->GetUniqueTransferID() );
-  transfer0->SetTransferNodeID ( node->GetID() );
-  transfer0->SetSourceURI ( source );
-  transfer0->SetDestinationURI ( dest );
-  transfer0->SetHandler ( handler );
-  transfer0->SetTransferType ( vtkDataTransfer::RemoteDownload );
-  transfer0->SetTransferStatus ( vtkDataTransfer::Idle );
-  transfer0->SetCancelRequested ( 0 );
-  //--- Add the data transfer to the collection, and
-  //--- the resulting mrml call will trigger an event
-  //--- that causes GUI to refresh.
-  this->AddNewDataTransfer ( transfer0.GetPointer(), node );
-  this->GetDataIOManager()->InvokeEvent ( vtkDataIOManager::RefreshDisplayEvent );
+  vtkMRMLStorageNode *storageNode = dnode->GetNthStorageNode(storageNodeIndex);
+  std::vector<vtkSmartPointer<vtkDataTransfer> > transfers;
+  for (int n = -1; n < storageNode->GetNumberOfURIs(); n++)
+    {
+    //--- the storage node URI comes first, then any other file in the storage node
+    const char *sourceN = ( n < 0 ? source : storageNode->GetNthURI(n) );
+    const char *destN = ( n < 0 ? dest : storageNode->GetNthFileName(n) );
+
+    vtkNew<vtkDataTransfer> transfer;
+    transfer->SetTransferID ( this->GetDataIOManager()->GetUniqueTransferID() );
+    transfer->SetTransferNodeID ( node->GetID() );
+    transfer->SetSourceURI ( sourceN );
+    transfer->SetDestinationURI ( destN );
+    // use one handler for all files in the storage node
+    transfer->SetHandler ( handler );
+    transfer->SetTransferType ( vtkDataTransfer::RemoteDownload );
+    transfer->SetTransferStatus ( vtkDataTransfer::Idle );
+    transfer->SetCancelRequested ( 0 );
+    //--- Add the data transfer to the collection, and
+    //--- the resulting mrml call will trigger an event
+    //--- that causes GUI to refresh.
+    this->AddNewDataTransfer ( transfer.GetPointer(), node );
+    this->GetDataIOManager()->InvokeEvent ( vtkDataIOManager::RefreshDisplayEvent );
+    transfers.push_back ( transfer.GetPointer() );
+    }
 
   vtkDebugMacro("QueueRead: asynchronous enabled = " << this->GetDataIOManager()->GetEnableAsynchronousIO());
 
   if ( this->GetDataIOManager()->GetEnableAsynchronousIO() )
     {
-    vtkDebugMacro("QueueRead: Schedule an ASYNCHRONOUS data transfer");
+    vtkDebugMacro("QueueRead: Schedule an ASYNCHRONOUS data transfer of " << transfers.size() << " files");
     //---
-    //--- Schedule an ASYNCHRONOUS data transfer
+    //--- Schedule an ASYNCHRONOUS data transfer: the files are queued
+    //--- and downloaded together with the files of the other nodes
+    //--- queued before the networking thread gets to them.
     //---
+    for (size_t n = 0; n < transfers.size(); n++)
+      {
+      transfers[n]->SetTransferStatus ( vtkDataTransfer::Pending );
+      }
+    this->PendingDownloadsLock->Lock();
+    (*this->InternalPendingDownloads).push( transfers );
+    this->PendingDownloadsLock->Unlock();
+
     vtkNew<vtkSlicerTask> task;
     task->SetTypeToNetworking();
-    transfer0->SetTransferStatus ( vtkDataTransfer::Pending );
     task->SetTaskFunction(this, (vtkSlicerTask::TaskFunctionPointer)
-                          &vtkDataIOManagerLogic::ApplyTransfer, transfer0.GetPointer());
+                          &vtkDataIOManagerLogic::ApplyPendingDownloads, NULL);
 
     // Schedule the transfer
     if ( ! this->GetApplicationLogic()->ScheduleTask( task.GetPointer() ) )
       {
-      transfer0->SetTransferStatus( vtkDataTransfer::CompletedWithErrors);
+      //--- the transfers are left in the queue but are not pending anymore
+      for (size_t n = 0; n < transfers.size(); n++)
+        {
+        transfers[n]->SetTransferStatus( vtkDataTransfer::CompletedWithErrors);
+        }
       return 0;
       }
     }
   else
     {
-    vtkDebugMacro("QueueRead: Schedule a SYNCHRONOUS data transfer");
+    vtkDebugMacro("QueueRead: Schedule a SYNCHRONOUS data transfer of " << transfers.size() << " files");
     //---
     //--- Execute a SYNCHRONOUS data transfer
     //---
-    transfer0->SetTransferStatus( vtkDataTransfer::Running);
-    this->ApplyTransfer ( transfer0.GetPointer() );
-    transfer0->SetTransferStatus( vtkDataTransfer::Completed);
-    // now set the node's storage node state to ready
-    vtkDebugMacro("QueueRead: setting storage node state to transferdone: " << dnode->GetNthStorageNode(storageNodeIndex)->GetURI());
-    if (dnode->GetNthStorageNode(storageNodeIndex)->GetNumberOfURIs() == 0)
+    std::vector<std::vector<vtkDataTransfer*> > groups(1);
+    for (size_t n = 0; n < transfers.size(); n++)
       {
-      // done
-      dnode->GetNthStorageNode(storageNodeIndex)->SetReadStateTransferDone();
+      transfers[n]->SetTransferStatus( vtkDataTransfer::Running);
+      groups[0].push_back ( transfers[n] );
       }
+    this->ApplyDownloads ( groups );
+    // now set the node's storage node state to ready
+    vtkDebugMacro("QueueRead: setting storage node state to transferdone after synchronous transfer of all files: " << storageNode->GetURI());
+    storageNode->SetReadStateTransferDone();
     }
 //  this->DebugOff();
 
-  // loop over any other files in the storage node
-  for (int n = 0; n < dnode->GetNthStorageNode(storageNodeIndex)->GetNumberOfURIs(); n++)
-    {
-    const char *sourceN =  dnode->GetNthStorageNode(storageNodeIndex)->GetNthURI(n);
-    const char *destN = dnode->GetNthStorageNode(storageNodeIndex)->GetNthFileName(n);
-
-    vtkNew<vtkDataTransfer> transfer1;
-    transfer1->SetTransferID ( this->GetDataIOManager()->GetUniqueTransferID() );
-    transfer1->SetTransferNodeID ( node->GetID() );
-    transfer1->SetSourceURI ( sourceN );
-    transfer1->SetDestinationURI ( destN );
-    // use one handler for all files in the storage node
-    transfer1->SetHandler ( handler );
-    transfer1->SetTransferType ( vtkDataTransfer::RemoteDownload );
-    transfer1->SetTransferStatus ( vtkDataTransfer::Idle );
-    transfer1->SetCancelRequested ( 0 );
-    this->AddNewDataTransfer ( transfer1.GetPointer(), node );
-    this->GetDataIOManager()->InvokeEvent ( vtkDataIOManager::RefreshDisplayEvent );
-
-    if ( this->GetDataIOManager()->GetEnableAsynchronousIO() )
-      {
-      vtkDebugMacro("QueueRead: Schedule an ASYNCHRONOUS data transfer, n = " << n);
-      vtkNew<vtkSlicerTask> task;
-      task->SetTypeToNetworking();
-      transfer1->SetTransferStatus ( vtkDataTransfer::Pending );
-      task->SetTaskFunction(this, (vtkSlicerTask::TaskFunctionPointer)
-                            &vtkDataIOManagerLogic::ApplyTransfer, transfer1.GetPointer());
-
-      // Schedule the transfer
-      if ( ! this->GetApplicationLogic()->ScheduleTask( task.GetPointer() ) )
-        {
-        transfer1->SetTransferStatus( vtkDataTransfer::CompletedWithErrors);
-        return 0;
-        }
-      }
-    else
-      {
-      vtkDebugMacro("QueueRead: Schedule a SYNCHRONOUS data transfer, n = " << n);
-      transfer1->SetTransferStatus( vtkDataTransfer::Running);
-      this->ApplyTransfer ( transfer1.GetPointer() );
-      transfer1->SetTransferStatus( vtkDataTransfer::Completed);
-      // now set the node's storage node state to ready
-
-      }
-    }
-  if ( dnode->GetNthStorageNode(storageNodeIndex)->GetNumberOfURIs() > 0 &&
-       !this->GetDataIOManager()->GetEnableAsynchronousIO())
-    {
-    vtkDebugMacro("QueueRead: setting storage node state to transferdone after synchronous transfer of all files: " << dnode->GetNthStorageNode(storageNodeIndex)->GetURI());
-    dnode->GetNthStorageNode(storageNodeIndex)->SetReadStateTransferDone();
-    }
-
   return 1;
 }
 
@@ -717,48 +726,23 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
         dt->SetTransferStatusNoModify ( vtkDataTransfer::Running );
         this->GetApplicationLogic()->RequestModified( dt );
         handler->StageFileRead( source, dest);
-        dt->SetTransferStatusNoModify ( vtkDataTransfer::Completed );
-        this->GetApplicationLogic()->RequestModified( dt );
-
-        vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast( node );
-        if ( !storableNode )
+        //--- record the download in the cache index
+        if ( iom != NULL && iom->GetCacheManager() != NULL )
           {
-          vtkErrorMacro( "ApplyTransfer: could not get storable node for scheduled data transfer" );
-          return;
+          iom->GetCacheManager()->AddToCache ( dest, source );
           }
-        // find the storage node that's been scheduled  and we're working on it
-        int storageNodeIndex = -1;
-        for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); i++)
-          {
-          if (storableNode->GetNthStorageNode(i)->GetReadState() == vtkMRMLStorageNode::Transferring &&
-              strcmp(storableNode->GetNthStorageNode(i)->GetURI(),source) == 0)
-            {
-            vtkDebugMacro("ApplyTransfer: found a working storage node who's uri matches source " << source << " at " << i);
-            storageNodeIndex = i;
-            break;
-            }
-          }
-        if (storageNodeIndex == -1)
-          {
-          vtkErrorMacro("ApplyTransfer: unable to find a storage node in scheduled state.");
-          }
-        vtkMRMLStorageNode *storageNode = storableNode->GetNthStorageNode(storageNodeIndex);
-        if ( !storageNode )
-          {
-          vtkErrorMacro( "ApplyTransfer: no storage node for scheduled data transfer" );
-          return;
-          }
-        storageNode->SetDisableModifiedEvent( 1 );
-        // let the storage node know that the remote transfer is done
-        vtkDebugMacro("ApplyTransfer: setting storage node read state to transfer done for uri " << storageNode->GetURI());
-        storageNode->SetReadStateTransferDone();
-        storageNode->SetDisableModifiedEvent( 0 );
-        this->GetApplicationLogic()->RequestReadData( node->GetID(), dest, 0, 0 );
+        dt->SetTransferStatusNoModify ( vtkDataTransfer::Completed );
+        this->GetApplicationLogic()->RequestModified( dt );
+        this->RemoteReadTransferDone ( dt );
         }
       else
         {
         vtkDebugMacro("ApplyTransfer: stage file read on the handler..., source = " << source << ", dest = " << dest);
         handler->StageFileRead( source, dest);
+        if ( iom != NULL && iom->GetCacheManager() != NULL )
+          {
+          iom->GetCacheManager()->AddToCache ( dest, source );
+          }
         }
       }
     }
@@ -826,6 +810,214 @@ void vtkDataIOManagerLogic::ApplyTransfer( void *clientdata )
 
 
 
+//----------------------------------------------------------------------------
+void vtkDataIOManagerLogic::RemoteReadTransferDone ( vtkDataTransfer *dt )
+{
+  const char *source = dt->GetSourceURI();
+  const char *dest = dt->GetDestinationURI();
+  vtkMRMLNode *node = this->GetMRMLScene()->GetNodeByID ((dt->GetTransferNodeID() ));
+  vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast( node );
+  if ( !storableNode )
+    {
+    vtkErrorMacro( "RemoteReadTransferDone: could not get storable node for scheduled data transfer" );
+    return;
+    }
+  // find the storage node that's been scheduled  and we're working on it
+  int storageNodeIndex = -1;
+  for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); i++)
+    {
+    if (storableNode->GetNthStorageNode(i)->GetReadState() == vtkMRMLStorageNode::Transferring &&
+        strcmp(storableNode->GetNthStorageNode(i)->GetURI(),source) == 0)
+      {
+      vtkDebugMacro("RemoteReadTransferDone: found a working storage node who's uri matches source " << source << " at " << i);
+      storageNodeIndex = i;
+      break;
+      }
+    }
+  if (storageNodeIndex == -1)
+    {
+    vtkErrorMacro("RemoteReadTransferDone: unable to find a storage node in scheduled state.");
+    }
+  vtkMRMLStorageNode *storageNode = storableNode->GetNthStorageNode(storageNodeIndex);
+  if ( !storageNode )
+    {
+    vtkErrorMacro( "RemoteReadTransferDone: no storage node for scheduled data transfer" );
+    return;
+    }
+  storageNode->SetDisableModifiedEvent( 1 );
+  // let the storage node know that the remote transfer is done
+  vtkDebugMacro("RemoteReadTransferDone: setting storage node read state to transfer done for uri " << storageNode->GetURI());
+  storageNode->SetReadStateTransferDone();
+  storageNode->SetDisableModifiedEvent( 0 );
+  this->GetApplicationLogic()->RequestReadData( node->GetID(), dest, 0, 0 );
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManagerLogic::ApplyPendingDownloads( void * vtkNotUsed(clientdata) )
+{
+  //--- take all the downloads queued so far, the tasks
+  //--- scheduled after them will find the queue empty.
+  std::vector<std::vector<vtkSmartPointer<vtkDataTransfer> > > pending;
+  this->PendingDownloadsLock->Lock();
+  while (!(*this->InternalPendingDownloads).empty())
+    {
+    pending.push_back ( (*this->InternalPendingDownloads).front() );
+    (*this->InternalPendingDownloads).pop();
+    }
+  this->PendingDownloadsLock->Unlock();
+
+  //--- skip the transfers cancelled or failed to be scheduled, the
+  //--- files of a storage node are not needed without its main file.
+  std::vector<std::vector<vtkDataTransfer*> > groups;
+  for (size_t g = 0; g < pending.size(); g++)
+    {
+    if ( pending[g].empty() ||
+         pending[g][0]->GetTransferStatus() != vtkDataTransfer::Pending )
+      {
+      continue;
+      }
+    std::vector<vtkDataTransfer*> group;
+    for (size_t n = 0; n < pending[g].size(); n++)
+      {
+      if ( pending[g][n]->GetTransferStatus() == vtkDataTransfer::Pending )
+        {
+        group.push_back ( pending[g][n] );
+        }
+      }
+    groups.push_back ( group );
+    }
+  if ( !groups.empty() )
+    {
+    this->ApplyDownloads ( groups );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManagerLogic::ApplyDownloads(
+  const std::vector<std::vector<vtkDataTransfer*> >& groups )
+{
+  //assume synchronous io if no data manager exists.
+  vtkDataIOManager *iom = this->GetDataIOManager();
+  DownloadState state;
+  state.Logic = this;
+  state.AsynchronousIO = ( iom != NULL ? iom->GetEnableAsynchronousIO() : 0 );
+  state.Batch = NULL;
+  state.NumberOfFiles = 0;
+  state.NumberOfFilesInPreviousBatches = 0;
+
+  //--- each handler downloads all its files at once
+  std::map<vtkURIHandler*, DownloadBatch> batches;
+  for (size_t g = 0; g < groups.size(); g++)
+    {
+    state.StorageNodeTransfers.push_back ( NULL );
+    state.RemainingFiles.push_back ( 0 );
+    for (size_t n = 0; n < groups[g].size(); n++)
+      {
+      vtkDataTransfer *dt = groups[g][n];
+      if ( dt->GetHandler() == NULL || dt->GetSourceURI() == NULL || dt->GetDestinationURI() == NULL )
+        {
+        vtkErrorMacro("ApplyDownloads: either no handler, or source or dest are null.");
+        continue;
+        }
+      if ( n == 0 )
+        {
+        state.StorageNodeTransfers[g] = dt;
+        }
+      DownloadBatch& batch = batches[dt->GetHandler()];
+      batch.Transfers.push_back ( dt );
+      batch.Groups.push_back ( g );
+      batch.Sources.push_back ( dt->GetSourceURI() );
+      batch.Destinations.push_back ( dt->GetDestinationURI() );
+      ++state.RemainingFiles[g];
+      ++state.NumberOfFiles;
+      }
+    }
+
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback ( vtkDataIOManagerLogic::DownloadCallback );
+  callback->SetClientData ( &state );
+  this->PendingDownloadsLock->Lock();
+  this->DownloadProgress = 0.;
+  this->PendingDownloadsLock->Unlock();
+  for (std::map<vtkURIHandler*, DownloadBatch>::iterator it = batches.begin();
+       it != batches.end(); ++it)
+    {
+    vtkURIHandler *handler = it->first;
+    DownloadBatch& batch = it->second;
+    if ( state.AsynchronousIO )
+      {
+      for (size_t n = 0; n < batch.Transfers.size(); n++)
+        {
+        batch.Transfers[n]->SetTransferStatusNoModify ( vtkDataTransfer::Running );
+        this->GetApplicationLogic()->RequestModified( batch.Transfers[n] );
+        }
+      }
+    vtkDebugMacro("ApplyDownloads: stage " << batch.Sources.size() << " file reads on the handler");
+    state.Batch = &batch;
+    unsigned long doneTag = handler->AddObserver ( vtkURIHandler::StageFileReadDoneEvent, callback.GetPointer() );
+    unsigned long progressTag = handler->AddObserver ( vtkCommand::ProgressEvent, callback.GetPointer() );
+    handler->StageFileReads ( batch.Sources, batch.Destinations );
+    handler->RemoveObserver ( doneTag );
+    handler->RemoveObserver ( progressTag );
+    state.NumberOfFilesInPreviousBatches += batch.Sources.size();
+    }
+  this->PendingDownloadsLock->Lock();
+  this->DownloadProgress = 1.;
+  this->PendingDownloadsLock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManagerLogic::DownloadCallback(
+  vtkObject* vtkNotUsed(caller), unsigned long eid, void* clientData, void* callData)
+{
+  DownloadState *state = reinterpret_cast<DownloadState *>(clientData);
+  vtkDataIOManagerLogic *self = state->Logic;
+  if ( eid == vtkCommand::ProgressEvent )
+    {
+    double batchProgress = *reinterpret_cast<double *>(callData);
+    self->PendingDownloadsLock->Lock();
+    self->DownloadProgress =
+      ( state->NumberOfFilesInPreviousBatches + batchProgress * state->Batch->Transfers.size() )
+      / state->NumberOfFiles;
+    self->PendingDownloadsLock->Unlock();
+    return;
+    }
+
+  int *done = reinterpret_cast<int *>(callData);
+  vtkDataTransfer *dt = state->Batch->Transfers[done[0]];
+  int status = ( done[1] ? vtkDataTransfer::Completed : vtkDataTransfer::CompletedWithErrors );
+  //--- record the download in the cache index
+  vtkDataIOManager *iom = self->GetDataIOManager();
+  if ( done[1] && iom != NULL && iom->GetCacheManager() != NULL )
+    {
+    iom->GetCacheManager()->AddToCache ( dt->GetDestinationURI(), dt->GetSourceURI() );
+    }
+  if ( !state->AsynchronousIO )
+    {
+    dt->SetTransferStatus ( status );
+    return;
+    }
+  dt->SetTransferStatusNoModify ( status );
+  self->GetApplicationLogic()->RequestModified( dt );
+
+  //--- the data is read once all the files of the storage node are there
+  size_t group = state->Batch->Groups[done[0]];
+  if ( --state->RemainingFiles[group] == 0 &&
+       state->StorageNodeTransfers[group] != NULL )
+    {
+    self->RemoteReadTransferDone ( state->StorageNodeTransfers[group] );
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkDataIOManagerLogic::GetDownloadProgress()
+{
+  this->PendingDownloadsLock->Lock();
+  double progress = this->DownloadProgress;
+  this->PendingDownloadsLock->Unlock();
+  return progress;
+}
+
 //----------------------------------------------------------------------------
 void vtkDataIOManagerLogic::ProgressCallback ( void * vtkNotUsed(who) )
 {
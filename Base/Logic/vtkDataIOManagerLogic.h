@@ -15,6 +15,13 @@
 #include "vtkDataIOManager.h"
 #include "vtkMRMLNode.h"
 
+// ITK includes
+#include <itkMutexLock.h>
+
+// STD includes
+#include <vector>
+
+class PendingDownloadQueue;
 
 #ifndef vtkObjectPointer
 #define vtkObjectPointer(xx) (reinterpret_cast <vtkObject **>( (xx) ))
@@ -45,6 +52,16 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkDataIOManagerLogic : public vtkSlicerModul
   /// The method that executes the data transfer in another thread
   virtual void ApplyTransfer(void *clientdata);
 
+  ///
+  /// The method that executes all the queued downloads in another thread.
+  /// The downloads are handed over to the URI handlers together, that
+  /// can transfer them concurrently.
+  virtual void ApplyPendingDownloads(void *clientdata);
+
+  ///
+  /// Overall progress (from 0 to 1) of the downloads being executed.
+  double GetDownloadProgress();
+
   /// Description
   /// Communicates progress back to the DataIOManager
   static void ProgressCallback ( void * );
@@ -70,6 +87,21 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkDataIOManagerLogic : public vtkSlicerModul
   vtkObserverManager* DataIOObserverManager;
   static void DataIOManagerCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData);
   virtual void ProcessDataIOManagerEvents( vtkObject *caller, unsigned long event, void *calldata );
+
+  ///
+  /// Downloads the files of the transfers, grouped by storage node. The
+  /// first transfer of a group is the storage node URI, its data is read
+  /// once all the files of the group are downloaded.
+  void ApplyDownloads(const std::vector<std::vector<vtkDataTransfer*> >& groups);
+  static void DownloadCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData);
+
+  ///
+  /// Lets the storage node of an asynchronous download read the data.
+  void RemoteReadTransferDone(vtkDataTransfer *transfer);
+
+  PendingDownloadQueue* InternalPendingDownloads;
+  itk::MutexLock::Pointer PendingDownloadsLock;
+  double DownloadProgress;
 };
 
 #endif
@@ -29,6 +29,9 @@
 #include <vtkMRMLTableNode.h>
 #include <vtkMRMLRemoteIOLogic.h>
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -333,7 +336,9 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
       ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
                     this);
 
-    // Start four network threads (TODO: make the number of threads a setting)
+    // Start the network thread. Downloads queued together are transferred
+    // concurrently by the URI handlers (see vtkURIHandler::StageFileReads),
+    // a single thread is enough to keep several connections busy.
     this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
           ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
                     this) );
@@ -446,6 +451,7 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessProcessingTasks()
 {
+  vtkTracer::GetInstance()->SetThreadName("Processing");
   int active = true;
   vtkSmartPointer<vtkSlicerTask> task = 0;
 
@@ -528,6 +534,7 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
 {
+  vtkTracer::GetInstance()->SetThreadName("Networking");
   int active = true;
   vtkSmartPointer<vtkSlicerTask> task = 0;
 
@@ -75,6 +75,34 @@
 #include "itkTranslationTransform.h"
 #include "itkTransformFactory.h"
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Set the points to the RAS position of each node of a regular grid
+void GetGridPoints_RAS(vtkPoints* points_RAS, vtkMatrix4x4* gridToRAS, int* gridSize)
+{
+  points_RAS->SetDataTypeToDouble();
+  points_RAS->SetNumberOfPoints(gridSize[0]*gridSize[1]*gridSize[2]);
+
+  double point_RAS[4] = {0,0,0,1};
+  double point_Grid[4]={0,0,0,1};
+  vtkIdType sampleIndex=0;
+  for (point_Grid[2]=0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
+    {
+    for (point_Grid[1]=0; point_Grid[1]<gridSize[1]; point_Grid[1]++)
+      {
+      for (point_Grid[0]=0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
+        {
+        gridToRAS->MultiplyPoint(point_Grid, point_RAS);
+        points_RAS->SetPoint(sampleIndex++, point_RAS);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
 vtkStandardNewMacro(vtkSlicerTransformLogic);
 
 //----------------------------------------------------------------------------
@@ -104,9 +132,7 @@ bool vtkSlicerTransformLogic::hardenTransform(vtkMRMLTransformableNode* transfor
     }
   else
     {
-    vtkNew<vtkGeneralTransform> hardeningTransform;
-    transformNode->GetTransformToWorld(hardeningTransform.GetPointer());
-    transformableNode->ApplyTransform(hardeningTransform.GetPointer());
+    transformableNode->ApplyTransform(transformNode->GetCompiledTransformToWorld());
     }
 
   transformableNode->SetAndObserveTransformNodeID(NULL);
@@ -227,11 +253,13 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
     return;
     }
 
-  int numOfSamples=gridSize[0]*gridSize[1]*gridSize[2];
-
   //Will contain all the points that are to be rendered
   vtkNew<vtkPoints> samplePositions_RAS;
-  samplePositions_RAS->SetNumberOfPoints(numOfSamples);
+  GetGridPoints_RAS(samplePositions_RAS.GetPointer(), gridToRAS, gridSize);
+  vtkIdType numOfSamples=samplePositions_RAS->GetNumberOfPoints();
+
+  vtkNew<vtkPoints> transformedSamplePositions_RAS;
+  inputTransformNode->TransformPointsToWorld(samplePositions_RAS.GetPointer(), transformedSamplePositions_RAS.GetPointer());
 
   //Will contain the corresponding vectors for outputPointSet
   vtkNew<vtkDoubleArray> sampleVectors_RAS;
@@ -240,33 +268,12 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
   sampleVectors_RAS->SetNumberOfTuples(numOfSamples);
   sampleVectors_RAS->SetName("DisplacementVector");
 
-  vtkNew<vtkGeneralTransform> inputTransform;
-  inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-
-  double point_RAS[4] = {0,0,0,1};
-  double transformedPoint_RAS[4] = {0,0,0,1};
-  double pointDislocationVector_RAS[4] = {0,0,0,1};
-  double point_Grid[4]={0,0,0,1};
-  int sampleIndex=0;
-  for (point_Grid[2]=0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
+  const double* point_RAS=static_cast<double*>(samplePositions_RAS->GetVoidPointer(0));
+  const double* transformedPoint_RAS=static_cast<double*>(transformedSamplePositions_RAS->GetVoidPointer(0));
+  double* pointDislocationVector_RAS=sampleVectors_RAS->GetPointer(0);
+  for (vtkIdType i=0; i<3*numOfSamples; i++)
     {
-    for (point_Grid[1]=0; point_Grid[1]<gridSize[1]; point_Grid[1]++)
-      {
-      for (point_Grid[0]=0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
-        {
-        gridToRAS->MultiplyPoint(point_Grid, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-        samplePositions_RAS->SetPoint(sampleIndex, point_RAS[0], point_RAS[1], point_RAS[2]);
-        sampleVectors_RAS->SetTuple3(sampleIndex,pointDislocationVector_RAS[0], pointDislocationVector_RAS[1], pointDislocationVector_RAS[2]);
-        sampleIndex++;
-        }
-      }
+    pointDislocationVector_RAS[i] = transformedPoint_RAS[i] - point_RAS[i];
     }
 
   outputPointSet->SetPoints(samplePositions_RAS.GetPointer());
@@ -348,9 +355,6 @@ void vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImag
     {
     return;
     }
-  vtkNew<vtkGeneralTransform> inputTransform;
-  inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-
   int* extent=magnitudeImage->GetExtent();
   int imageSize[3]={extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
 
@@ -365,33 +369,27 @@ void vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImag
   magnitudeImage->AllocateScalars(VTK_FLOAT, 1);
 #endif
 
-  double point_RAS[4] = {0,0,0,1};
-  double transformedPoint_RAS[4] = {0,0,0,1};
-  double pointDislocationVector_RAS[4] = {0,0,0,1};
-  double point_IJK[4]={0,0,0,1};
+  vtkNew<vtkPoints> points_RAS;
+  GetGridPoints_RAS(points_RAS.GetPointer(), ijkToRAS, imageSize);
+  vtkNew<vtkPoints> transformedPoints_RAS;
+  inputTransformNode->TransformPointsToWorld(points_RAS.GetPointer(), transformedPoints_RAS.GetPointer());
+
+  const double* point_RAS=static_cast<double*>(points_RAS->GetVoidPointer(0));
+  const double* transformedPoint_RAS=static_cast<double*>(transformedPoints_RAS->GetVoidPointer(0));
   float* voxelPtr=static_cast<float*>(magnitudeImage->GetScalarPointer());
-  for (point_IJK[2]=0; point_IJK[2]<imageSize[2]; point_IJK[2]++)
+  vtkIdType numberOfVoxels=points_RAS->GetNumberOfPoints();
+  for (vtkIdType i=0; i<numberOfVoxels; i++, point_RAS+=3, transformedPoint_RAS+=3)
     {
-    for (point_IJK[1]=0; point_IJK[1]<imageSize[1]; point_IJK[1]++)
+    double pointDislocationVector_RAS[3] =
       {
-      for (point_IJK[0]=0; point_IJK[0]<imageSize[0]; point_IJK[0]++)
-        {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-        float mag=sqrt(
-          pointDislocationVector_RAS[0]*pointDislocationVector_RAS[0]+
-          pointDislocationVector_RAS[1]*pointDislocationVector_RAS[1]+
-          pointDislocationVector_RAS[2]*pointDislocationVector_RAS[2]);
-
-        *(voxelPtr++)=mag;
-        }
-      }
+      transformedPoint_RAS[0] - point_RAS[0],
+      transformedPoint_RAS[1] - point_RAS[1],
+      transformedPoint_RAS[2] - point_RAS[2]
+      };
+    *(voxelPtr++)=sqrt(
+      pointDislocationVector_RAS[0]*pointDislocationVector_RAS[0]+
+      pointDislocationVector_RAS[1]*pointDislocationVector_RAS[1]+
+      pointDislocationVector_RAS[2]*pointDislocationVector_RAS[2]);
     }
 }
 
@@ -504,9 +502,6 @@ void vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
     {
     return;
     }
-  vtkNew<vtkGeneralTransform> inputTransform;
-  inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-
   int* extent=vectorImage->GetExtent();
   int imageSize[3]={extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
 
@@ -521,26 +516,19 @@ void vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
   vectorImage->AllocateScalars(VTK_FLOAT, 3);
 #endif
 
-  double point_RAS[4] = {0,0,0,1};
-  double transformedPoint_RAS[4] = {0,0,0,1};
-  double point_IJK[4]={0,0,0,1};
+  vtkNew<vtkPoints> points_RAS;
+  GetGridPoints_RAS(points_RAS.GetPointer(), ijkToRAS, imageSize);
+  vtkNew<vtkPoints> transformedPoints_RAS;
+  inputTransformNode->TransformPointsToWorld(points_RAS.GetPointer(), transformedPoints_RAS.GetPointer());
+
+  // store the pointDislocationVector_RAS components in the image
+  const double* point_RAS=static_cast<double*>(points_RAS->GetVoidPointer(0));
+  const double* transformedPoint_RAS=static_cast<double*>(transformedPoints_RAS->GetVoidPointer(0));
   float* voxelPtr=static_cast<float*>(vectorImage->GetScalarPointer());
-  for (point_IJK[2]=0; point_IJK[2]<imageSize[2]; point_IJK[2]++)
+  vtkIdType numberOfValues=3*points_RAS->GetNumberOfPoints();
+  for (vtkIdType i=0; i<numberOfValues; i++)
     {
-    for (point_IJK[1]=0; point_IJK[1]<imageSize[1]; point_IJK[1]++)
-      {
-      for (point_IJK[0]=0; point_IJK[0]<imageSize[0]; point_IJK[0]++)
-        {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        // store the pointDislocationVector_RAS components in the image
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
-        }
-      }
+    voxelPtr[i] = static_cast<float>(transformedPoint_RAS[i] - point_RAS[i]);
     }
 }
 
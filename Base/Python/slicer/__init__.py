@@ -4,6 +4,7 @@ import ctk
 import logging
 import qt
 import sys
+import types
 
 #-----------------------------------------------------------------------------
 class _LogReverseLevelFilter(logging.Filter):
@@ -87,10 +88,31 @@ initLogging(logging.getLogger())
 
 
 #-----------------------------------------------------------------------------
-def _createModule(name, globals, docstring):
+class _ModulesNamespace(types.ModuleType):
+  """
+  Loads the Slicer modules loaded on demand the first time they are accessed.
+  """
+  def __getattr__(self, name):
+    # Only called if the module has not been loaded yet
+    import slicer
+    if not name.startswith('_') and hasattr(slicer, 'app'):
+      moduleManager = slicer.app.moduleManager()
+      if hasattr(moduleManager, 'factoryManager'):
+        for moduleName in moduleManager.factoryManager().deferredModuleNames():
+          if moduleName.lower() == name:
+            # Loading the module sets the attribute
+            moduleManager.module(moduleName)
+            break
+    try:
+      return self.__dict__[name]
+    except KeyError:
+      raise AttributeError(name)
+
+#-----------------------------------------------------------------------------
+def _createModule(name, globals, docstring, moduleType=None):
   import imp
   moduleName = name.split('.')[-1]
-  module = imp.new_module( moduleName )
+  module = moduleType(moduleName) if moduleType else imp.new_module( moduleName )
   module.__file__ = __file__
   module.__doc__ = docstring
   sys.modules[name] = module
@@ -104,7 +126,8 @@ _createModule('slicer.modules', globals(),
 
 The module attributes are the lower-cased Slicer module names, the
 associated value is an instance of ``qSlicerAbstractCoreModule``.
-""")
+Modules loaded on demand are loaded when their attribute is first accessed.
+""", _ModulesNamespace)
 
 _createModule('slicer.moduleNames', globals(),
 """This module provides an access to all instantiated Slicer module names.
@@ -43,6 +43,8 @@
 #ifdef Slicer_USE_PYTHONQT
 # include <ctkPythonConsole.h>
 #endif
+#include <ctkSettingsDialog.h>
+#include <ctkSettingsPanel.h>
 
 // MRMLWidgets includes
 #include <qMRMLEventLoggerWidget.h>
@@ -54,6 +56,22 @@
 # include "qSlicerSettingsPythonPanel.h"
 #endif
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+int settingsPanelCount()
+{
+  qSlicerApplication* app = qSlicerApplication::application();
+  if (!app || !app->settingsDialog())
+    {
+    return 0;
+    }
+  return app->settingsDialog()->findChildren<ctkSettingsPanel*>().count();
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 qSlicerApplicationHelper::qSlicerApplicationHelper(QObject * parent) : Superclass(parent)
 {
@@ -154,6 +172,14 @@ void qSlicerApplicationHelper::setupModuleFactoryManager(qSlicerModuleFactoryMan
     app->revisionUserSettings()->value("Modules/IgnoreModules").toStringList();
   moduleFactoryManager->setModulesToIgnore(ignoreModules);
   moduleFactoryManager->setVerboseModuleDiscovery(app->commandOptions()->verboseModuleDiscovery());
+  moduleFactoryManager->setLoadModulesOnDemand(
+    options->loadModulesOnDemand() ||
+    app->userSettings()->value("Modules/LoadOnDemand", false).toBool());
+  // Metadata recorded when the modules were last loaded
+  moduleFactoryManager->setModulesMetadata(
+    app->revisionUserSettings()->value("Modules/Metadata").toMap());
+  // Modules adding settings panels are loaded at startup
+  moduleFactoryManager->addPluginCounter(settingsPanelCount);
 }
 
 //----------------------------------------------------------------------------
@@ -31,6 +31,9 @@
 #include <vtkMRMLModelStorageNode.h>
 #include <vtkMRMLTransformNode.h>
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkIntArray.h>
@@ -859,6 +862,9 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     return;
     }
 
+  vtkTraceZoneWithDetailMacro("ApplyTask", "vtkSlicerCLIModuleLogic",
+                              node0->GetModuleDescription().GetTitle().c_str());
+
   // Set the callback for progress.  This will only be used for the
   // scope of this function.
   LogicNodePair lnp( this, node0 );
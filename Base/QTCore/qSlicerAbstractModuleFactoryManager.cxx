@@ -20,11 +20,15 @@
 
 // Qt includes
 #include <QDir>
+#include <QElapsedTimer>
 
 // SlicerQt includes
 #include "qSlicerAbstractModuleFactoryManager.h"
 #include "qSlicerAbstractCoreModule.h"
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // STD includes
 #include <csignal>
 #include <typeinfo>
@@ -54,6 +58,7 @@ public:
   QMap<qSlicerModuleFactory*, int> Factories;
   QMap<QString, qSlicerModuleFactory*> RegisteredModules;
   QMap<QString, QStringList> ModuleDependees;
+  QHash<QString, double> InstantiationTimes;
 
   bool Verbose;
 };
@@ -232,6 +237,7 @@ QStringList qSlicerAbstractModuleFactoryManager::ignoredModuleNames()const
 void qSlicerAbstractModuleFactoryManager::registerModules()
 {
   Q_D(qSlicerAbstractModuleFactoryManager);
+  vtkTraceZoneMacro("Register modules", "Modules");
   // Register "regular" factories first
   // \todo: don't support factories other than filebased factories
   foreach(qSlicerModuleFactory* factory, d->notFileBasedFactories())
@@ -262,6 +268,7 @@ void qSlicerAbstractModuleFactoryManager::registerModules()
 //-----------------------------------------------------------------------------
 void qSlicerAbstractModuleFactoryManager::registerModules(const QString& path)
 {
+  vtkTraceZoneWithDetailMacro("Register modules", "Modules", qPrintable(path));
   QDir directory(path);
   /// \tbd recursive search ?
   foreach (const QFileInfo& file,
@@ -355,6 +362,10 @@ void qSlicerAbstractModuleFactoryManager::instantiateModules()
   Q_D(qSlicerAbstractModuleFactoryManager);
   foreach (const QString& moduleName, d->RegisteredModules.keys())
     {
+    if (this->isInstantiatedOnDemand(moduleName))
+      {
+      continue;
+      }
     this->instantiateModule(moduleName);
     }
 
@@ -378,9 +389,13 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
   Q_D(qSlicerAbstractModuleFactoryManager);
   Q_ASSERT(d->RegisteredModules.contains(moduleName));
   qSlicerModuleFactory* factory = d->RegisteredModules[moduleName];
+  vtkTraceZoneWithDetailMacro("Instantiate module", "Modules", qPrintable(moduleName));
+  QElapsedTimer timer;
+  timer.start();
   qSlicerAbstractCoreModule* module = factory->instantiate(moduleName);
   if (module)
     {
+    d->InstantiationTimes[moduleName] = timer.elapsed();
     module->setName(moduleName);
     module->setObjectName(QString("%1Module").arg(moduleName));
     foreach(const QString& dependency, module->dependencies())
@@ -400,6 +415,20 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
   return module;
 }
 
+//-----------------------------------------------------------------------------
+bool qSlicerAbstractModuleFactoryManager::isInstantiatedOnDemand(const QString& name)const
+{
+  Q_UNUSED(name);
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+double qSlicerAbstractModuleFactoryManager::moduleInstantiationTime(const QString& moduleName)const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->InstantiationTimes.value(moduleName, -1.);
+}
+
 //-----------------------------------------------------------------------------
 QStringList qSlicerAbstractModuleFactoryManager::registeredModuleNames() const
 {
@@ -446,6 +475,7 @@ void qSlicerAbstractModuleFactoryManager::uninstantiateModule(const QString& mod
   Q_ASSERT(d->RegisteredModules.contains(moduleName));
   emit moduleAboutToBeUninstantiated(moduleName);
   d->RegisteredModules[moduleName]->uninstantiate(moduleName);
+  d->InstantiationTimes.remove(moduleName);
   emit moduleUninstantiated(moduleName);
 }
 
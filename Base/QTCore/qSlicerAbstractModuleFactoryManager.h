@@ -155,7 +155,9 @@ public:
   /// Return true if a module has been registered, false otherwise
   Q_INVOKABLE bool isRegistered(const QString& name)const;
 
-  /// Instanciate all previously registered modules.
+  /// Instanciate all previously registered modules, except the ones
+  /// instantiated on demand.
+  /// \sa isInstantiatedOnDemand()
   virtual void instantiateModules();
 
   /// List of registered and instantiated modules
@@ -167,6 +169,10 @@ public:
   /// Return the instance of a module if already instantiated, 0 otherwise
   Q_INVOKABLE qSlicerAbstractCoreModule* moduleInstance(const QString& moduleName)const;
 
+  /// Return the time in ms spent to instantiate the module, -1 if the
+  /// module has not been instantiated.
+  Q_INVOKABLE double moduleInstantiationTime(const QString& moduleName)const;
+
   /// Uninstantiate all instantiated modules
   void uninstantiateModules();
 
@@ -217,6 +223,11 @@ protected:
   /// Instantiate a module given its \a name
   qSlicerAbstractCoreModule* instantiateModule(const QString& name);
 
+  /// Return true if the module \a name is not instantiated by
+  /// instantiateModules() but only when it is requested.
+  /// Returns false by default.
+  virtual bool isInstantiatedOnDemand(const QString& name)const;
+
   /// Uninstantiate a module given its \a moduleName
   virtual void uninstantiateModule(const QString& moduleName);
 
@@ -90,6 +90,9 @@
 #endif
 #include <vtkMRMLScene.h>
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkNew.h>
 #include <vtksys/SystemTools.hxx>
@@ -203,6 +206,17 @@ void qSlicerCoreApplicationPrivate::init()
 
   this->parseArguments();
 
+  // Trace as early as possible to include the startup
+  QString traceFileName =
+    this->CoreCommandOptions ? this->CoreCommandOptions->traceFileName() : QString();
+  if (!traceFileName.isEmpty())
+    {
+    vtkTracer* tracer = vtkTracer::GetInstance();
+    tracer->SetFileName(traceFileName.toLocal8Bit().constData());
+    tracer->SetThreadName("Main");
+    tracer->EnabledOn();
+    }
+
   this->SlicerHome = this->discoverSlicerHomeDirectory();
   this->setEnvironmentVariable("SLICER_HOME", this->SlicerHome);
 
@@ -712,6 +726,11 @@ qSlicerCoreApplication::qSlicerCoreApplication(
 //-----------------------------------------------------------------------------
 qSlicerCoreApplication::~qSlicerCoreApplication()
 {
+  vtkTracer* tracer = vtkTracer::GetInstance();
+  if (tracer->GetEnabled() && tracer->GetFileName())
+    {
+    tracer->WriteTrace();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -287,6 +287,27 @@ bool qSlicerCoreCommandOptions::verboseModuleDiscovery() const
   return d->ParsedArgs.value("verbose-module-discovery").toBool();
 }
 
+//-----------------------------------------------------------------------------
+bool qSlicerCoreCommandOptions::loadModulesOnDemand() const
+{
+  Q_D(const qSlicerCoreCommandOptions);
+  return d->ParsedArgs.value("load-modules-on-demand").toBool();
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerCoreCommandOptions::displayModuleStartupProfile() const
+{
+  Q_D(const qSlicerCoreCommandOptions);
+  return d->ParsedArgs.value("module-startup-profile").toBool();
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCoreCommandOptions::traceFileName() const
+{
+  Q_D(const qSlicerCoreCommandOptions);
+  return d->ParsedArgs.value("trace-file").toString();
+}
+
 //-----------------------------------------------------------------------------
 bool qSlicerCoreCommandOptions::verbose()const
 {
@@ -417,6 +438,16 @@ void qSlicerCoreCommandOptions::addArguments()
   this->addArgument("verbose-module-discovery", "", QVariant::Bool,
                     "Enable verbose output during module discovery process.");
 
+  this->addArgument("load-modules-on-demand", "", QVariant::Bool,
+                    "Only load at startup the modules that need to be set up, the others are loaded when first used.");
+
+  this->addArgument("module-startup-profile", "", QVariant::Bool,
+                    "Display the time spent loading each module at startup and the time saved by the modules loaded on demand.");
+
+  this->addArgument("trace-file", "", QVariant::String,
+                    "Record the time spent in startup, scene, storage, rendering and CLI operations into the given "
+                    "file, in the Chrome trace format (see chrome://tracing or https://ui.perfetto.dev).");
+
   this->addArgument("disable-settings", "", QVariant::Bool,
                     "Start application ignoring user settings.");
 
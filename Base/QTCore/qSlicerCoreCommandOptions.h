@@ -52,6 +52,9 @@ class Q_SLICER_BASE_QTCORE_EXPORT qSlicerCoreCommandOptions : public ctkCommandL
   Q_PROPERTY(bool displayTemporaryPathAndExit READ displayTemporaryPathAndExit CONSTANT)
   Q_PROPERTY(bool displayMessageAndExit READ displayMessageAndExit STORED false CONSTANT)
   Q_PROPERTY(bool verboseModuleDiscovery READ verboseModuleDiscovery CONSTANT)
+  Q_PROPERTY(bool loadModulesOnDemand READ loadModulesOnDemand CONSTANT)
+  Q_PROPERTY(bool displayModuleStartupProfile READ displayModuleStartupProfile CONSTANT)
+  Q_PROPERTY(QString traceFileName READ traceFileName CONSTANT)
   Q_PROPERTY(bool disableMessageHandlers READ disableMessageHandlers CONSTANT)
   Q_PROPERTY(bool testingEnabled READ isTestingEnabled CONSTANT)
 #ifdef Slicer_USE_PYTHONQT
@@ -149,6 +152,21 @@ public:
   /// Return True if slicer should display details regarding the module discovery process
   bool verboseModuleDiscovery()const;
 
+  /// Return True if the modules that do not need to be set up at startup
+  /// should only be loaded when first used.
+  /// \sa qSlicerModuleFactoryManager::setLoadModulesOnDemand()
+  bool loadModulesOnDemand()const;
+
+  /// Return True if slicer should display the time spent loading each module
+  /// at startup.
+  /// \sa qSlicerModuleFactoryManager::printStartupProfile()
+  bool displayModuleStartupProfile()const;
+
+  /// Return the file where the trace of the session is written, empty if
+  /// the session is not traced.
+  /// \sa vtkTracer
+  QString traceFileName()const;
+
   /// Return True if slicer should display information at startup
   bool verbose()const;
 
@@ -60,11 +60,15 @@ public:
   QList<qSlicerFileReader*> Readers;
   QList<qSlicerFileWriter*> Writers;
   QMap<qSlicerIO::IOFileType, QStringList> FileTypes;
+
+  /// True while a reader loads a file with the "interactive" property.
+  bool InteractiveLoading;
 };
 
 //-----------------------------------------------------------------------------
 qSlicerCoreIOManagerPrivate::qSlicerCoreIOManagerPrivate()
 {
+  this->InteractiveLoading = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -470,6 +474,13 @@ bool qSlicerCoreIOManager::loadNodes(const qSlicerIO::IOFileType& fileType,
   Q_D(qSlicerCoreIOManager);
 
   Q_ASSERT(parameters.contains("fileName"));
+  if (d->InteractiveLoading)
+    {
+    // The reader processes the application events while loading
+    qWarning() << "Can't load" << parameters["fileName"]
+               << "while another file is loading";
+    return false;
+    }
   if (parameters["fileName"].type() == QVariant::StringList)
     {
     bool res = true;
@@ -493,6 +504,9 @@ bool qSlicerCoreIOManager::loadNodes(const qSlicerIO::IOFileType& fileType,
 
   qSlicerIO::IOProperties loadedFileParameters = parameters;
   loadedFileParameters.insert("fileType", fileType);
+  // only valid for this load, e.g. not when reloading a recent file
+  loadedFileParameters.remove("interactive");
+  bool interactive = parameters.value("interactive", false).toBool();
 
   const QList<qSlicerFileReader*>& readers = this->readers(fileType);
 
@@ -507,7 +521,10 @@ bool qSlicerCoreIOManager::loadNodes(const qSlicerIO::IOFileType& fileType,
       {
       continue;
       }
-    if (!reader->load(parameters))
+    d->InteractiveLoading = interactive;
+    bool loaded = reader->load(parameters);
+    d->InteractiveLoading = false;
+    if (!loaded)
       {
       continue;
       }
@@ -534,6 +551,13 @@ bool qSlicerCoreIOManager::loadNodes(const qSlicerIO::IOFileType& fileType,
   return success;
 }
 
+//-----------------------------------------------------------------------------
+bool qSlicerCoreIOManager::isLoadingInteractively()const
+{
+  Q_D(const qSlicerCoreIOManager);
+  return d->InteractiveLoading;
+}
+
 //-----------------------------------------------------------------------------
 bool qSlicerCoreIOManager::
 loadNodes(const QList<qSlicerIO::IOProperties>& files,
@@ -597,6 +621,12 @@ bool qSlicerCoreIOManager::saveNodes(qSlicerIO::IOFileType fileType,
   Q_D(qSlicerCoreIOManager);
 
   Q_ASSERT(parameters.contains("fileName"));
+  if (d->InteractiveLoading)
+    {
+    qWarning() << "Can't save" << parameters.value("fileName")
+               << "while a file is loading";
+    return false;
+    }
 
   // HACK - See http://www.na-mic.org/Bug/view.php?id=3322
   //        Sort writers to ensure generic ones are last.
@@ -731,3 +761,10 @@ void qSlicerCoreIOManager::registerIO(qSlicerIO* io)
     io->setParent(this);
     }
 }
+
+//-----------------------------------------------------------------------------
+int qSlicerCoreIOManager::registeredIOCount()const
+{
+  Q_D(const qSlicerCoreIOManager);
+  return d->Readers.count() + d->Writers.count();
+}
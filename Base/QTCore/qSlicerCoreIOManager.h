@@ -92,8 +92,13 @@ public:
   /// fileName (QString or QStringList) or fileNames (QStringList).
   /// More specific parameters could also be set. For example, the volume reader qSlicerVolumesIO
   /// could also be called with the following parameters: LabelMap (bool), Center (bool)
+  /// If interactive (bool) is true, the reader may process the application
+  /// events while loading (e.g. scenes are then loaded step by step, see
+  /// vtkMRMLSceneLoader): other files can't be loaded or saved until it is
+  /// done. qSlicerIOManager sets it for the files chosen by the user.
   /// \note Make also sure the case of parameter name is respected
-  /// \sa qSlicerIO::IOProperties, qSlicerIO::IOFileType, saveNodes()
+  /// \sa qSlicerIO::IOProperties, qSlicerIO::IOFileType, saveNodes(),
+  /// isLoadingInteractively()
 #if QT_VERSION < 0x040700
   Q_INVOKABLE virtual bool loadNodes(const qSlicerIO::IOFileType& fileType,
                                      const QVariantMap& parameters,
@@ -109,6 +114,11 @@ public:
   virtual bool loadNodes(const QList<qSlicerIO::IOProperties>& files,
                          vtkCollection* loadedNodes = 0);
 
+  /// Return true while a file is loaded with the interactive property.
+  /// Loading and saving files fail meanwhile.
+  /// \sa loadNodes()
+  Q_INVOKABLE bool isLoadingInteractively()const;
+
   /// Load a list of node corresponding to \a fileType and return the first loaded node.
   /// This function is provided for convenience and is equivalent to call loadNodes
   /// with a vtkCollection parameter and retrieve the first element.
@@ -149,6 +159,10 @@ public:
   /// Note also that the IOManager takes ownership of \a io
   void registerIO(qSlicerIO* io);
 
+  /// Return the number of registered readers and writers
+  /// \sa registerIO()
+  Q_INVOKABLE int registeredIOCount()const;
+
   /// Create and add default storage node
   Q_INVOKABLE static vtkMRMLStorageNode* createAndAddDefaultStorageNode(vtkMRMLStorableNode* node);
 
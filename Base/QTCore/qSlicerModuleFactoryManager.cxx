@@ -18,9 +18,24 @@
 
 ==============================================================================*/
 
+// Qt includes
+#include <QElapsedTimer>
+
 // SlicerQt includes
 #include "qSlicerModuleFactoryManager.h"
 #include "qSlicerAbstractCoreModule.h"
+#include "qSlicerCoreApplication.h"
+#include "qSlicerCoreIOManager.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLSliceViewDisplayableManagerFactory.h>
+#include <vtkMRMLThreeDViewDisplayableManagerFactory.h>
+
+// vtkAddon includes
+#include <vtkTracer.h>
 
 // STD includes
 #include <algorithm>
@@ -34,9 +49,27 @@ protected:
 public:
   qSlicerModuleFactoryManagerPrivate(qSlicerModuleFactoryManager& object);
 
+  /// Return true if the module must be loaded at startup according to its
+  /// metadata.
+  bool isLoadedAtStartup(const QString& name)const;
+
+  /// Number of node classes, readers/writers, displayable managers and
+  /// plugins registered so far, used to detect the modules that register
+  /// some.
+  /// \sa qSlicerModuleFactoryManager::addPluginCounter()
+  int registeredClassCount()const;
+
+  void updateMetadata(qSlicerAbstractCoreModule* module, bool registeredClasses);
+
   QStringList LoadedModules;
   vtkSlicerApplicationLogic* AppLogic;
   vtkMRMLScene* MRMLScene;
+
+  bool LoadModulesOnDemand;
+  QVariantMap ModulesMetadata;
+  QStringList DeferredModules;
+  QHash<QString, double> LoadTimes;
+  QList<qSlicerModuleFactoryManager::PluginCounter> PluginCounters;
 };
 
 //-----------------------------------------------------------------------------
@@ -47,6 +80,61 @@ qSlicerModuleFactoryManagerPrivate
 {
   this->AppLogic = 0;
   this->MRMLScene = 0;
+  this->LoadModulesOnDemand = false;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerModuleFactoryManagerPrivate::isLoadedAtStartup(const QString& name)const
+{
+  if (!this->ModulesMetadata.contains(name))
+    {
+    return true;
+    }
+  return this->ModulesMetadata.value(name).toMap().value("loadAtStartup", true).toBool();
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerModuleFactoryManagerPrivate::registeredClassCount()const
+{
+  int count = 0;
+  if (this->MRMLScene)
+    {
+    count += this->MRMLScene->GetNumberOfRegisteredNodeClasses();
+    }
+  qSlicerCoreApplication* app = qSlicerCoreApplication::application();
+  if (app && app->coreIOManager())
+    {
+    count += app->coreIOManager()->registeredIOCount();
+    }
+  count += vtkMRMLThreeDViewDisplayableManagerFactory::GetInstance()
+    ->GetRegisteredDisplayableManagerCount();
+  count += vtkMRMLSliceViewDisplayableManagerFactory::GetInstance()
+    ->GetRegisteredDisplayableManagerCount();
+  foreach(qSlicerModuleFactoryManager::PluginCounter counter, this->PluginCounters)
+    {
+    count += (*counter)();
+    }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerModuleFactoryManagerPrivate::updateMetadata(
+  qSlicerAbstractCoreModule* module, bool registeredClasses)
+{
+  QVariantMap metadata;
+  metadata["title"] = module->title();
+  metadata["categories"] = module->categories();
+  metadata["index"] = module->index();
+  metadata["hidden"] = module->isHidden();
+  metadata["builtIn"] = module->isBuiltIn();
+  metadata["dependencies"] = module->dependencies();
+  // Hidden modules are never shown, they would never be loaded on demand.
+  // Scripted modules can register plugins from python (e.g. DICOM plugins or
+  // editor effects), which can't be detected.
+  metadata["loadAtStartup"] = module->isHidden() || registeredClasses ||
+    module->inherits("qSlicerScriptedLoadableModule");
+  metadata["loadTime"] = this->LoadTimes.value(module->name());
+  this->ModulesMetadata[module->name()] = metadata;
 }
 
 //-----------------------------------------------------------------------------
@@ -123,8 +211,7 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
     }
 
   // A module should be registered when attempting to load it
-  if (!this->isRegistered(name) ||
-      !this->isInstantiated(name))
+  if (!this->isRegistered(name))
     {
     //Q_ASSERT(d->ModuleFactoryManager.isRegistered(name));
     return false;
@@ -136,6 +223,16 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
     return true;
     }
 
+  // Modules loaded on demand are instantiated when first requested
+  if (!this->isInstantiated(name) && this->isDeferred(name))
+    {
+    this->instantiateModule(name);
+    }
+  if (!this->isInstantiated(name))
+    {
+    return false;
+    }
+
   if (this->Superclass::isVerbose())
     {
     qDebug() << "Loading module" << name;
@@ -165,6 +262,14 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
 
   // Update internal Map
   d->LoadedModules << name;
+  d->DeferredModules.removeOne(name);
+
+  // Modules registering node classes or readers/writers must be loaded at
+  // startup the next time.
+  int registeredClassCount = d->registeredClassCount();
+  QElapsedTimer timer;
+  timer.start();
+  vtkTraceZoneWithDetailMacro("Load module", "Modules", qPrintable(name));
 
   // Initialize module
   instance->initialize(d->AppLogic);
@@ -180,6 +285,9 @@ bool qSlicerModuleFactoryManager::loadModule(const QString& name, const QString&
   // Set the MRML scene
   instance->setMRMLScene(d->MRMLScene);
 
+  d->LoadTimes[name] = qMax(this->moduleInstantiationTime(name), 0.) + timer.elapsed();
+  d->updateMetadata(instance, d->registeredClassCount() != registeredClassCount);
+
   // Module should also be aware if current MRML scene has changed
   this->connect(this,SIGNAL(mrmlSceneChanged(vtkMRMLScene*)),
                 instance, SLOT(setMRMLScene(vtkMRMLScene*)));
@@ -242,6 +350,7 @@ void qSlicerModuleFactoryManager::unloadModule(const QString& name)
     }
   emit this->moduleAboutToBeUnloaded(name);
   d->LoadedModules.removeOne(name);
+  d->LoadTimes.remove(name);
   this->uninstantiateModule(name);
   emit this->moduleUnloaded(name);
 }
@@ -314,3 +423,119 @@ vtkMRMLScene* qSlicerModuleFactoryManager::mrmlScene()const
   Q_D(const qSlicerModuleFactoryManager);
   return d->MRMLScene;
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerModuleFactoryManager::setLoadModulesOnDemand(bool enable)
+{
+  Q_D(qSlicerModuleFactoryManager);
+  d->LoadModulesOnDemand = enable;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerModuleFactoryManager::loadModulesOnDemand()const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  return d->LoadModulesOnDemand;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerModuleFactoryManager::setModulesMetadata(const QVariantMap& metadata)
+{
+  Q_D(qSlicerModuleFactoryManager);
+  d->ModulesMetadata = metadata;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerModuleFactoryManager::addPluginCounter(PluginCounter counter)
+{
+  Q_D(qSlicerModuleFactoryManager);
+  if (counter && !d->PluginCounters.contains(counter))
+    {
+    d->PluginCounters << counter;
+    }
+}
+
+//-----------------------------------------------------------------------------
+QVariantMap qSlicerModuleFactoryManager::modulesMetadata()const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  return d->ModulesMetadata;
+}
+
+//-----------------------------------------------------------------------------
+QVariantMap qSlicerModuleFactoryManager::moduleMetadata(const QString& name)const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  return d->ModulesMetadata.value(name).toMap();
+}
+
+//-----------------------------------------------------------------------------
+QStringList qSlicerModuleFactoryManager::deferredModuleNames()const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  return d->DeferredModules;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerModuleFactoryManager::isDeferred(const QString& name)const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  return d->DeferredModules.contains(name);
+}
+
+//-----------------------------------------------------------------------------
+double qSlicerModuleFactoryManager::moduleLoadTime(const QString& name)const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  return d->LoadTimes.value(name, -1.);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerModuleFactoryManager::instantiateModules()
+{
+  Q_D(qSlicerModuleFactoryManager);
+  d->DeferredModules.clear();
+  if (d->LoadModulesOnDemand)
+    {
+    foreach(const QString& name, this->registeredModuleNames())
+      {
+      if (!this->isInstantiated(name) && !d->isLoadedAtStartup(name))
+        {
+        d->DeferredModules << name;
+        }
+      }
+    }
+  this->Superclass::instantiateModules();
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerModuleFactoryManager::isInstantiatedOnDemand(const QString& name)const
+{
+  return this->isDeferred(name);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerModuleFactoryManager::printStartupProfile()const
+{
+  Q_D(const qSlicerModuleFactoryManager);
+  double loadTime = 0.;
+  double savedTime = 0.;
+  qDebug() << "Module startup profile:";
+  foreach(const QString& name, d->LoadedModules)
+    {
+    double moduleTime = this->moduleLoadTime(name);
+    loadTime += moduleTime;
+    qDebug() << qPrintable(QString("  %1 loaded in %2 ms")
+                           .arg(name, -40).arg(moduleTime, 8, 'f', 1));
+    }
+  foreach(const QString& name, d->DeferredModules)
+    {
+    double moduleTime = this->moduleMetadata(name).value("loadTime").toDouble();
+    savedTime += moduleTime;
+    qDebug() << qPrintable(QString("  %1 deferred, saved %2 ms")
+                           .arg(name, -40).arg(moduleTime, 8, 'f', 1));
+    }
+  qDebug() << qPrintable(QString("%1 modules loaded in %2 ms, %3 modules deferred saving %4 ms")
+                         .arg(d->LoadedModules.count()).arg(loadTime, 0, 'f', 1)
+                         .arg(d->DeferredModules.count()).arg(savedTime, 0, 'f', 1));
+}
@@ -23,6 +23,7 @@
 
 // Qt includes
 #include <QStringList>
+#include <QVariantMap>
 
 // Slicer includes
 #include "qSlicerAbstractModuleFactoryManager.h"
@@ -85,9 +86,64 @@ public:
   Q_INVOKABLE bool loadModules(const QStringList& modules);
 
   /// Load module identified by \a name
+  /// Modules loaded on demand are instantiated first.
   /// \todo move it as protected
   bool loadModule(const QString& name);
 
+  /// If enabled, instantiateModules() only instantiates the modules that
+  /// must be set up at startup, the other modules are instantiated and
+  /// loaded by loadModule() when they are first requested: shown, referenced
+  /// as a dependency or accessed from python.
+  /// A module is loaded at startup if it has no metadata (e.g. it was never
+  /// loaded before), if it is hidden or scripted, or if it registered MRML
+  /// node classes, readers/writers, displayable managers or plugins the last
+  /// time it was loaded.
+  /// Disabled by default.
+  /// \sa setModulesMetadata(), deferredModuleNames(), addPluginCounter()
+  void setLoadModulesOnDemand(bool enable);
+  bool loadModulesOnDemand()const;
+
+  /// Function returning the number of plugins of a registry that modules
+  /// populate when they are set up (e.g. subject hierarchy plugins or
+  /// settings panels).
+  typedef int (*PluginCounter)();
+
+  /// Add a registry of plugins: the modules registering plugins in it are
+  /// loaded at startup, their plugins must be available before the modules
+  /// are requested.
+  /// \sa setLoadModulesOnDemand()
+  void addPluginCounter(PluginCounter counter);
+
+  /// Metadata of the modules, indexed by module name and updated each time
+  /// a module is loaded. The metadata of a module is a QVariantMap with the
+  /// keys "title", "categories", "index", "hidden", "builtIn", "dependencies",
+  /// "loadAtStartup" and "loadTime" (in ms).
+  /// Metadata of a previous session are used to decide which modules can be
+  /// loaded on demand and to list them before they are loaded.
+  /// \sa setLoadModulesOnDemand()
+  void setModulesMetadata(const QVariantMap& metadata);
+  QVariantMap modulesMetadata()const;
+  Q_INVOKABLE QVariantMap moduleMetadata(const QString& name)const;
+
+  /// Return the list of the modules loaded on demand and not loaded yet.
+  Q_INVOKABLE QStringList deferredModuleNames()const;
+
+  /// Return true if module \a name is loaded on demand and not loaded yet.
+  Q_INVOKABLE bool isDeferred(const QString& name)const;
+
+  /// Return the time in ms spent to instantiate and load the module during
+  /// this session, -1 if the module has not been loaded.
+  Q_INVOKABLE double moduleLoadTime(const QString& name)const;
+
+  /// Print the time spent to load each loaded module and, for the modules
+  /// loaded on demand and not loaded yet, the time saved according to their
+  /// metadata.
+  Q_INVOKABLE void printStartupProfile()const;
+
+  /// Reimplemented to record the modules loaded on demand.
+  /// \sa setLoadModulesOnDemand()
+  virtual void instantiateModules();
+
 public slots:
   /// Set the MRML scene to pass to modules at "load" time.
   void setMRMLScene(vtkMRMLScene* mrmlScene);
@@ -117,6 +173,10 @@ protected:
 
   /// Reimplemented to ensure order
   virtual void uninstantiateModules();
+
+  /// Reimplemented to not instantiate the deferred modules.
+  /// \sa isDeferred()
+  virtual bool isInstantiatedOnDemand(const QString& name)const;
 private:
   Q_DECLARE_PRIVATE(qSlicerModuleFactoryManager);
   Q_DISABLE_COPY(qSlicerModuleFactoryManager);
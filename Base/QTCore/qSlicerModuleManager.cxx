@@ -72,6 +72,11 @@ qSlicerModuleFactoryManager* qSlicerModuleManager::factoryManager()const
 qSlicerAbstractCoreModule* qSlicerModuleManager::module(const QString& name)const
 {
   Q_D(const qSlicerModuleManager);
+  // Modules loaded on demand are loaded when first requested
+  if (d->ModuleFactoryManager->isDeferred(name))
+    {
+    d->ModuleFactoryManager->loadModule(name);
+    }
   return d->ModuleFactoryManager->loadedModule(name);
 }
 
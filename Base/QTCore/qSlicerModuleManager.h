@@ -53,6 +53,8 @@ public:
   Q_INVOKABLE QStringList modulesNames()const;
 
   /// Return the loaded module identified by \a name
+  /// Modules loaded on demand are loaded first.
+  /// \sa qSlicerModuleFactoryManager::isDeferred()
   Q_INVOKABLE qSlicerAbstractCoreModule* module(const QString& name)const;
 
 signals:
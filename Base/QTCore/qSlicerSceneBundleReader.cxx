@@ -19,6 +19,7 @@
 ==============================================================================*/
 
 // Qt includes
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QDateTime>
@@ -33,7 +34,7 @@
 #include <vtkMRMLScene.h>
 
 // MRML Logic includes
-#include <vtkMRMLApplicationLogic.h>
+#include <vtkMRMLSceneLoader.h>
 
 // VTK includes
 #include <vtkNew.h>
@@ -41,9 +42,31 @@
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+//-----------------------------------------------------------------------------
+class qSlicerSceneBundleReaderPrivate
+{
+public:
+  qSlicerSceneBundleReaderPrivate();
+
+  /// Loader of the bundle being loaded, 0 if none.
+  vtkMRMLSceneLoader* Loader;
+};
+
+//-----------------------------------------------------------------------------
+qSlicerSceneBundleReaderPrivate::qSlicerSceneBundleReaderPrivate()
+{
+  this->Loader = 0;
+}
+
 //-----------------------------------------------------------------------------
 qSlicerSceneBundleReader::qSlicerSceneBundleReader(QObject* _parent)
   : Superclass(_parent)
+  , d_ptr(new qSlicerSceneBundleReaderPrivate)
+{
+}
+
+//-----------------------------------------------------------------------------
+qSlicerSceneBundleReader::~qSlicerSceneBundleReader()
 {
 }
 
@@ -68,7 +91,14 @@ QStringList qSlicerSceneBundleReader::extensions()const
 //-----------------------------------------------------------------------------
 bool qSlicerSceneBundleReader::load(const qSlicerIO::IOProperties& properties)
 {
+  Q_D(qSlicerSceneBundleReader);
   Q_ASSERT(properties.contains("fileName"));
+  if (d->Loader)
+    {
+    qWarning() << "Can't load" << properties["fileName"].toString()
+               << "while another bundle is loading";
+    return false;
+    }
   QString file = properties["fileName"].toString();
 
   // check for a relative path as the unzip will need an absolute one
@@ -99,27 +129,35 @@ bool qSlicerSceneBundleReader::load(const qSlicerIO::IOProperties& properties)
     return false;
     }
 
-  vtkNew<vtkMRMLApplicationLogic> appLogic;
-  appLogic->SetMRMLScene( this->mrmlScene() );
-  std::string mrmlFile = appLogic->UnpackSlicerDataBundle(
-                                          file.toLatin1(), unpackPath.toLatin1() );
-
-  this->mrmlScene()->SetURL(mrmlFile.c_str());
-
   bool clear = false;
   if (properties.contains("clear"))
     {
     clear = properties["clear"].toBool();
     }
-  int res = 0;
-  if (clear)
+
+  vtkNew<vtkMRMLSceneLoader> loader;
+  loader->SetMRMLScene(this->mrmlScene());
+  loader->SetFileName(file.toLatin1());
+  loader->SetTemporaryDirectory(unpackPath.toLatin1());
+  loader->SetClear(clear);
+  bool res = false;
+  if (!properties.value("interactive", false).toBool())
     {
-    res = this->mrmlScene()->Connect();
+    res = loader->Run();
     }
-  else
+  // The bundle is extracted and the data read step by step, the views are
+  // rendered and the load can be canceled between two steps.
+  else if (loader->Start())
     {
-    res = this->mrmlScene()->Import();
+    d->Loader = loader.GetPointer();
+    while (loader->Step())
+      {
+      QCoreApplication::processEvents();
+      }
+    d->Loader = 0;
+    res = loader->IsSuccessful();
     }
+  loader->SetMRMLScene(0);
 
   if (!ctk::removeDirRecursively(unpackPath))
     {
@@ -138,3 +176,13 @@ bool qSlicerSceneBundleReader::load(const qSlicerIO::IOProperties& properties)
   // MRBs come with default scene views, but the paths of storage nodes in there can be still pointing to the bundle extraction directory that was removed. Clear out the file lists at least so that they get reset
   return res;
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerSceneBundleReader::cancel()
+{
+  Q_D(qSlicerSceneBundleReader);
+  if (d->Loader)
+    {
+    d->Loader->Cancel();
+    }
+}
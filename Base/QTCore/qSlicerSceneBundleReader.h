@@ -24,12 +24,15 @@
 // QtCore includes
 #include "qSlicerFileReader.h"
 
+class qSlicerSceneBundleReaderPrivate;
+
 ///
 /// qSlicerSceneBundleReader is the IO class that handle MRML scene
 /// embedded in a zip file (called a Slicer Data Bundle).  The extension
 /// is mrb (for Medical Reality Bundle)
-/// It internally calls vtkMRMLScene::Connect() or vtkMRMLScene::Import()
-/// depending on the clear flag.
+/// It internally uses vtkMRMLSceneLoader to clear (or not depending on the
+/// clear flag) and load the scene step by step: the application events are
+/// processed while the bundle is extracted and the data is read.
 class Q_SLICER_BASE_QTCORE_EXPORT qSlicerSceneBundleReader
   : public qSlicerFileReader
 {
@@ -37,6 +40,7 @@ class Q_SLICER_BASE_QTCORE_EXPORT qSlicerSceneBundleReader
 public:
   typedef qSlicerFileReader Superclass;
   qSlicerSceneBundleReader(QObject* _parent = 0);
+  virtual ~qSlicerSceneBundleReader();
 
   virtual QString description()const;
   /// Support QString("SceneFile")
@@ -48,7 +52,23 @@ public:
   /// the supported properties are:
   /// QString fileName: the path of the mrml scene to load
   /// bool clear: wether the current should be cleared or not
+  /// bool interactive: if true, the application events are processed while
+  /// the data is read and the load can be canceled, see vtkMRMLSceneLoader.
+  /// False by default.
   virtual bool load(const qSlicerIO::IOProperties& properties);
+
+public slots:
+  /// Stop loading the bundle, the nodes whose data is not read yet are
+  /// removed from the scene. load() then returns false. Only interactive
+  /// loads can be canceled.
+  void cancel();
+
+protected:
+  QScopedPointer<qSlicerSceneBundleReaderPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qSlicerSceneBundleReader);
+  Q_DISABLE_COPY(qSlicerSceneBundleReader);
 };
 
 
@@ -14,6 +14,7 @@
 /// SlicerQt includes
 #include "qSlicerIOManager.h"
 #include "qSlicerDataDialog.h"
+#include "qSlicerFileReader.h"
 #include "qSlicerModelsDialog.h"
 #include "qSlicerSaveDataDialog.h"
 #include "qSlicerApplication.h"
@@ -60,6 +61,9 @@ public:
 
   QSharedPointer<ctkScreenshotDialog> ScreenshotDialog;
   QProgressDialog*                    ProgressDialog;
+  /// True while the files chosen by the user in a dialog are loaded,
+  /// they are loaded with the "interactive" property.
+  bool                                UserLoad;
 };
 
 //-----------------------------------------------------------------------------
@@ -70,6 +74,7 @@ qSlicerIOManagerPrivate::qSlicerIOManagerPrivate(qSlicerIOManager& object)
   :q_ptr(&object)
 {
   this->ProgressDialog = 0;
+  this->UserLoad = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -97,12 +102,22 @@ bool qSlicerIOManagerPrivate::startProgressDialog(int steps)
   this->ProgressDialog->setWindowModality(Qt::WindowModal);
   this->ProgressDialog->setMinimumDuration(1000);
   this->ProgressDialog->setValue(0);
+  QObject::connect(this->ProgressDialog, SIGNAL(canceled()),
+                   q, SLOT(cancelLoading()));
 
   if (steps == 1)
     {
     q->qvtkConnect(qSlicerCoreApplication::application()->mrmlScene(),
                     vtkMRMLScene::NodeAddedEvent,
                     q, SLOT(updateProgressDialog()));
+    // Readers loading the data step by step (e.g. scenes) report their
+    // progress and can be canceled.
+    q->qvtkConnect(qSlicerCoreApplication::application()->mrmlScene(),
+                    vtkMRMLScene::StartReadDataEvent,
+                    q, SLOT(onReadDataStarted()));
+    q->qvtkConnect(qSlicerCoreApplication::application()->mrmlScene(),
+                    vtkMRMLScene::ProgressReadDataEvent,
+                    q, SLOT(updateReadDataProgress(vtkObject*,void*)));
     }
   return true;
 }
@@ -120,6 +135,12 @@ void qSlicerIOManagerPrivate::stopProgressDialog()
   q->qvtkDisconnect(qSlicerCoreApplication::application()->mrmlScene(),
                     vtkMRMLScene::NodeAddedEvent,
                     q, SLOT(updateProgressDialog()));
+  q->qvtkDisconnect(qSlicerCoreApplication::application()->mrmlScene(),
+                    vtkMRMLScene::StartReadDataEvent,
+                    q, SLOT(onReadDataStarted()));
+  q->qvtkDisconnect(qSlicerCoreApplication::application()->mrmlScene(),
+                    vtkMRMLScene::ProgressReadDataEvent,
+                    q, SLOT(updateReadDataProgress(vtkObject*,void*)));
   delete this->ProgressDialog;
   this->ProgressDialog = 0;
 }
@@ -234,6 +255,11 @@ bool qSlicerIOManager::openDialog(qSlicerIO::IOFileType fileType,
                                   vtkCollection* loadedNodes)
 {
   Q_D(qSlicerIOManager);
+  if (this->isLoadingInteractively())
+    {
+    qWarning() << "Can't open a dialog while a file is loading";
+    return false;
+    }
   bool deleteDialog = false;
   if (properties["objectName"].toString().isEmpty())
     {
@@ -250,7 +276,10 @@ bool qSlicerIOManager::openDialog(qSlicerIO::IOFileType fileType,
     standardDialog->setAction(action);
     dialog = standardDialog;
     }
+  bool wasUserLoad = d->UserLoad;
+  d->UserLoad = true;
   bool res = dialog->exec(properties);
+  d->UserLoad = wasUserLoad;
   if (loadedNodes)
     {
     foreach(const QString& nodeID, dialog->loadedNodes())
@@ -287,6 +316,10 @@ void qSlicerIOManager::dragEnterEvent(QDragEnterEvent *event)
 void qSlicerIOManager::dropEvent(QDropEvent *event)
 {
   Q_D(qSlicerIOManager);
+  if (this->isLoadingInteractively())
+    {
+    return;
+    }
   QStringList supportedReaders;
   QStringList genericReaders; // those must be last in the choice menu
   foreach(qSlicerFileDialog* dialog, d->ReadDialogs)
@@ -334,7 +367,10 @@ void qSlicerIOManager::dropEvent(QDropEvent *event)
       dialog->dropEvent(event);
       if (event->isAccepted())
         {
+        bool wasUserLoad = d->UserLoad;
+        d->UserLoad = true;
         dialog->exec();
+        d->UserLoad = wasUserLoad;
         break;
         }
       }
@@ -418,7 +454,13 @@ bool qSlicerIOManager::loadNodes(const qSlicerIO::IOFileType& fileType,
     d->ProgressDialog->setValue(25);
     }
 
-  bool res = this->qSlicerCoreIOManager::loadNodes(fileType, parameters, loadedNodes);
+  qSlicerIO::IOProperties loadParameters = parameters;
+  if (d->UserLoad && !loadParameters.contains("interactive"))
+    {
+    // The user can follow and cancel the load
+    loadParameters["interactive"] = true;
+    }
+  bool res = this->qSlicerCoreIOManager::loadNodes(fileType, loadParameters, loadedNodes);
   if (needStop)
     {
     d->stopProgressDialog();
@@ -473,6 +515,54 @@ void qSlicerIOManager::updateProgressDialog()
   //qApp->processEvents();
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerIOManager::onReadDataStarted()
+{
+  Q_D(qSlicerIOManager);
+  if (!d->ProgressDialog)
+    {
+    return;
+    }
+  // The nodes are shown while their data is read: the views can be used
+  // and the load canceled.
+  d->ProgressDialog->setCancelButtonText(tr("Cancel"));
+  bool visible = d->ProgressDialog->isVisible();
+  // The modality of a visible window can't be changed
+  d->ProgressDialog->hide();
+  d->ProgressDialog->setWindowModality(Qt::NonModal);
+  if (visible)
+    {
+    d->ProgressDialog->show();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerIOManager::updateReadDataProgress(vtkObject* scene, void* callData)
+{
+  Q_D(qSlicerIOManager);
+  Q_UNUSED(scene);
+  if (!d->ProgressDialog)
+    {
+    return;
+    }
+  int progress = static_cast<int>(reinterpret_cast<long long>(callData));
+  d->ProgressDialog->setValue(
+    qMin(qMax(progress, d->ProgressDialog->value()), d->ProgressDialog->maximum() - 1));
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerIOManager::cancelLoading()
+{
+  // Only the readers loading step by step have a cancel() slot.
+  foreach(qSlicerFileReader* reader, this->readers())
+    {
+    if (reader->metaObject()->indexOfSlot("cancel()") != -1)
+      {
+      QMetaObject::invokeMethod(reader, "cancel");
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerIOManager::openScreenshotDialog()
 {
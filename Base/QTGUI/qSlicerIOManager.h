@@ -22,6 +22,7 @@ class QDropEvent;
 class QWidget;
 
 class qSlicerIOManagerPrivate;
+class vtkObject;
 
 class Q_SLICER_BASE_QTGUI_EXPORT qSlicerIOManager : public qSlicerCoreIOManager
 {
@@ -61,6 +62,10 @@ public:
   /// There is no way to know in advance how long the loading will take, so the
   /// progress dialog listens to the scene and increment the progress anytime
   /// a node is added.
+  /// The files chosen by the user in a dialog (see openDialog() and
+  /// dropEvent()) are loaded with the "interactive" property: scenes are
+  /// then loaded step by step and can be canceled, no dialog can be opened
+  /// meanwhile.
   Q_INVOKABLE virtual bool loadNodes(const qSlicerIO::IOFileType& fileType,
                                      const qSlicerIO::IOProperties& parameters,
                                      vtkCollection* loadedNodes = 0);
@@ -103,6 +108,9 @@ public slots:
 
 protected slots:
   void updateProgressDialog();
+  void onReadDataStarted();
+  void updateReadDataProgress(vtkObject* scene, void* callData);
+  void cancelLoading();
 
 protected:
   friend class qSlicerFileDialog;
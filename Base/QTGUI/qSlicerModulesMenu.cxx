@@ -24,6 +24,7 @@
 
 // CTK includes
 #include "qSlicerAbstractModule.h"
+#include "qSlicerModuleFactoryManager.h"
 #include "qSlicerModuleManager.h"
 
 // SlicerQt includes
@@ -42,6 +43,13 @@ public:
   void addModuleAction(QMenu* menu, QAction* moduleAction, bool useIndex = true, bool builtIn = true);
   QMenu* menu(QMenu* parentMenu, QStringList subCategories, bool builtIn = true);
 
+  /// Return true if a module with the given properties should be listed
+  bool isModuleListed(bool hidden, const QStringList& categories)const;
+  /// Add an action for a module loaded on demand and not loaded yet.
+  /// The module is loaded when the action is selected.
+  void addDeferredModuleAction(const QString& moduleName, const QVariantMap& metadata);
+  void removeDeferredModuleAction(const QString& moduleName);
+
   QAction* action(const QVariant& actionData, const QMenu* parentMenu)const;
   QAction* action(const QString& text, const QMenu* parentMenu)const;
   QMenu*   actionMenu(QAction* action, QMenu* parentMenu)const;
@@ -266,6 +274,82 @@ QMenu* qSlicerModulesMenuPrivate::menu(QMenu* menu, QStringList subCategories, b
   return this->menu(subMenu, subCategories, builtIn);
 }
 
+//---------------------------------------------------------------------------
+bool qSlicerModulesMenuPrivate::isModuleListed(bool hidden, const QStringList& categories)const
+{
+  if (hidden && !this->ShowHiddenModules)
+    {
+    // ignore hidden modules
+    return false;
+    }
+
+  // Only show modules in Testing category if developer mode is enabled
+  // to not clutter the module list for regular users with tests
+  QSettings settings;
+  bool developerModeEnabled = settings.value("Developer/DeveloperMode", false).toBool();
+  if (!developerModeEnabled)
+    {
+    bool testOnlyModule = true;
+    foreach(const QString& category, categories)
+      {
+      if (category.split('.').takeFirst()!="Testing")
+        {
+        testOnlyModule = false;
+        }
+      }
+    if (testOnlyModule)
+      {
+      // This module only appears in the Testing category but we are not in developer mode,
+      // so do not add this module to the module menu
+      return false;
+      }
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void qSlicerModulesMenuPrivate::addDeferredModuleAction(
+  const QString& moduleName, const QVariantMap& metadata)
+{
+  Q_Q(qSlicerModulesMenu);
+  QStringList categories = metadata.value("categories").toStringList();
+  if (metadata.isEmpty() ||
+      !this->isModuleListed(metadata.value("hidden").toBool(), categories))
+    {
+    return;
+    }
+  bool builtIn = metadata.value("builtIn", true).toBool();
+  QAction* moduleAction = new QAction(metadata.value("title").toString(), q);
+  moduleAction->setData(moduleName);
+  moduleAction->setProperty("index", metadata.value("index"));
+  moduleAction->setProperty("deferred", true);
+  QObject::connect(moduleAction, SIGNAL(triggered(bool)),
+                   q, SLOT(onActionTriggered()));
+  foreach(const QString& category, categories)
+    {
+    QMenu* menu = this->menu(q, category.split('.'), builtIn);
+    this->addModuleAction(menu, moduleAction, true, builtIn);
+    }
+  this->addModuleAction(this->AllModulesMenu, moduleAction, false, true);
+}
+
+//---------------------------------------------------------------------------
+void qSlicerModulesMenuPrivate::removeDeferredModuleAction(const QString& moduleName)
+{
+  QAction* moduleAction = this->action(QVariant(moduleName), this->AllModulesMenu);
+  if (!moduleAction || !moduleAction->property("deferred").toBool())
+    {
+    return;
+    }
+  // The action is in all the menus of its categories
+  foreach(QWidget* widget, moduleAction->associatedWidgets())
+    {
+    widget->removeAction(moduleAction);
+    }
+  // The action may be the one being triggered
+  moduleAction->deleteLater();
+}
+
 //---------------------------------------------------------------------------
 QMenu* qSlicerModulesMenuPrivate::actionMenu(QAction* action, QMenu* parentMenu)const
 {
@@ -384,6 +468,13 @@ void qSlicerModulesMenu::setModuleManager(qSlicerModuleManager* moduleManager)
                    SIGNAL(moduleAboutToBeUnloaded(QString)),
                    this, SLOT(removeModule(QString)));
   this->addModules(d->ModuleManager->modulesNames());
+
+  // Modules loaded on demand are listed from their metadata
+  qSlicerModuleFactoryManager* factoryManager = d->ModuleManager->factoryManager();
+  foreach(const QString& moduleName, factoryManager->deferredModuleNames())
+    {
+    d->addDeferredModuleAction(moduleName, factoryManager->moduleMetadata(moduleName));
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -417,33 +508,13 @@ void qSlicerModulesMenu::addModule(qSlicerAbstractCoreModule* moduleToAdd)
     qWarning() << "A module needs a QAction to be handled by qSlicerModulesMenu";
     return;
     }
-  if (module->isHidden() && !d->ShowHiddenModules)
+  if (!d->isModuleListed(module->isHidden(), module->categories()))
     {
-    // ignore hidden modules
     return;
     }
 
-  // Only show modules in Testing category if developer mode is enabled
-  // to not clutter the module list for regular users with tests
-  QSettings settings;
-  bool developerModeEnabled = settings.value("Developer/DeveloperMode", false).toBool();
-  if (!developerModeEnabled)
-    {
-    bool testOnlyModule = true;
-    foreach(const QString& category, module->categories())
-      {
-      if (category.split('.').takeFirst()!="Testing")
-        {
-        testOnlyModule = false;
-        }
-      }
-    if (testOnlyModule)
-      {
-      // This module only appears in the Testing category but we are not in developer mode,
-      // so do not add this module to the module menu
-      return;
-      }
-    }
+  // A module loaded on demand replaces the action listing it
+  d->removeDeferredModuleAction(module->name());
 
   QAction* moduleAction = module->action();
   Q_ASSERT(moduleAction);
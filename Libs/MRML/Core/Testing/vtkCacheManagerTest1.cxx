@@ -0,0 +1,297 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkCacheManager.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Write a file in the cache directory without adding it to the cache.
+std::string WriteFile(vtkCacheManager* cacheManager, const char* name, int size, char seed)
+{
+  std::string fileName = std::string(cacheManager->GetRemoteCacheDirectory()) + "/" + name;
+  std::ofstream output(fileName.c_str(), std::ios::out | std::ios::binary);
+  for (int i = 0; i < size; ++i)
+    {
+    output.put(static_cast<char>(seed + i % 97));
+    }
+  output.close();
+  return fileName;
+}
+
+//----------------------------------------------------------------------------
+std::string WriteCachedFile(vtkCacheManager* cacheManager, const char* name, int size, char seed)
+{
+  std::string fileName = WriteFile(cacheManager, name, size, seed);
+  std::string uri = std::string("http://www.example.com/data/") + name;
+  cacheManager->AddToCache(fileName.c_str(), uri.c_str());
+  return fileName;
+}
+
+//----------------------------------------------------------------------------
+bool CheckCacheSize(int line, vtkCacheManager* cacheManager, vtkTypeInt64 expected)
+{
+  if (cacheManager->GetCacheSizeInBytes() != expected)
+    {
+    std::cerr << "Line " << line << " - Cache size is " << cacheManager->GetCacheSizeInBytes()
+              << " bytes instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckFileExists(int line, const std::string& fileName, bool expected)
+{
+  if (vtksys::SystemTools::FileExists(fileName.c_str()) != expected)
+    {
+    std::cerr << "Line " << line << " - " << fileName
+              << (expected ? " was removed" : " was not removed") << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestIndex(const std::string& cacheDirectory)
+{
+  const int fileSize = 400000;
+  std::string file1, file2, file3, duplicate;
+  {
+  vtkNew<vtkCacheManager> cacheManager;
+  cacheManager->SetRemoteCacheDirectory(cacheDirectory.c_str());
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 0))
+    {
+    return false;
+    }
+
+  file1 = WriteCachedFile(cacheManager.GetPointer(), "file1.nrrd", fileSize, 'a');
+  file2 = WriteCachedFile(cacheManager.GetPointer(), "file2.nrrd", fileSize, 'b');
+  file3 = WriteCachedFile(cacheManager.GetPointer(), "file3.nrrd", fileSize, 'c');
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 3 * fileSize))
+    {
+    return false;
+    }
+
+  // Same content as file2, stored once
+  duplicate = WriteCachedFile(cacheManager.GetPointer(), "duplicate.nrrd", fileSize, 'b');
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 3 * fileSize) ||
+      !CheckFileExists(__LINE__, duplicate, true))
+    {
+    return false;
+    }
+
+  // Least recently used first: file2, file3, duplicate, file1
+  cacheManager->TouchCachedFile(file1.c_str());
+
+  // Evict down to 1MB: removing file2 frees nothing as its content is
+  // shared with duplicate, removing file3 gets below the limit.
+  cacheManager->SetRemoteCacheLimit(1);
+  cacheManager->SetRemoteCacheFreeBufferSize(0);
+  cacheManager->CacheSizeCheck();
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 2 * fileSize) ||
+      !CheckFileExists(__LINE__, file1, true) ||
+      !CheckFileExists(__LINE__, file2, false) ||
+      !CheckFileExists(__LINE__, file3, false) ||
+      !CheckFileExists(__LINE__, duplicate, true))
+    {
+    return false;
+    }
+  if (cacheManager->GetCachedFiles().size() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << cacheManager->GetCachedFiles().size()
+              << " cached files instead of 2" << std::endl;
+    return false;
+    }
+  cacheManager->UpdateCacheInformation();
+  }
+
+  // The index is read back by another cache manager
+  {
+  vtkNew<vtkCacheManager> cacheManager;
+  cacheManager->SetRemoteCacheDirectory(cacheDirectory.c_str());
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 2 * fileSize))
+    {
+    return false;
+    }
+  // file1 was used last, duplicate is evicted first
+  cacheManager->EvictLeastRecentlyUsedFiles(fileSize);
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), fileSize) ||
+      !CheckFileExists(__LINE__, file1, true) ||
+      !CheckFileExists(__LINE__, duplicate, false))
+    {
+    return false;
+    }
+
+  // Without index, the directory is scanned
+  cacheManager->RebuildCacheIndex();
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), fileSize))
+    {
+    return false;
+    }
+
+  cacheManager->DeleteFromCache(file1.c_str());
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 0) ||
+      !CheckFileExists(__LINE__, file1, false))
+    {
+    return false;
+    }
+  if (!cacheManager->ClearCache() || !cacheManager->ClearCacheCheck())
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to clear the cache" << std::endl;
+    return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestRebuildIndex(const std::string& cacheDirectory)
+{
+  const int fileSize = 100000;
+  vtkNew<vtkCacheManager> cacheManager;
+  cacheManager->SetRemoteCacheDirectory(cacheDirectory.c_str());
+  cacheManager->ClearCache();
+  WriteCachedFile(cacheManager.GetPointer(), "file1.nrrd", fileSize, 'a');
+  WriteCachedFile(cacheManager.GetPointer(), "duplicate.nrrd", fileSize, 'a');
+  WriteCachedFile(cacheManager.GetPointer(), "file2.nrrd", fileSize, 'b');
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 2 * fileSize))
+    {
+    return false;
+    }
+
+  // The hashes of the indexed files are kept
+  cacheManager->RebuildCacheIndex();
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 2 * fileSize))
+    {
+    return false;
+    }
+
+  // Files copied into the cache directory are hashed and deduplicated
+  std::string copy = WriteFile(cacheManager.GetPointer(), "copy.nrrd", fileSize, 'b');
+  std::string other = WriteFile(cacheManager.GetPointer(), "other.nrrd", fileSize, 'c');
+  cacheManager->RebuildCacheIndex();
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 3 * fileSize) ||
+      !CheckFileExists(__LINE__, copy, true) ||
+      !CheckFileExists(__LINE__, other, true))
+    {
+    return false;
+    }
+  if (cacheManager->GetCachedFiles().size() != 5)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << cacheManager->GetCachedFiles().size()
+              << " cached files instead of 5" << std::endl;
+    return false;
+    }
+
+  // Without deduplication, the copies are counted
+  cacheManager->EnableDeduplicationOff();
+  WriteFile(cacheManager.GetPointer(), "copy2.nrrd", fileSize, 'c');
+  cacheManager->RebuildCacheIndex();
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), 4 * fileSize))
+    {
+    return false;
+    }
+  cacheManager->ClearCache();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestBenchmark(const std::string& cacheDirectory, int numberOfFiles)
+{
+  vtkNew<vtkCacheManager> cacheManager;
+  cacheManager->SetRemoteCacheDirectory(cacheDirectory.c_str());
+  cacheManager->ClearCache();
+  cacheManager->SetRemoteCacheLimit(1000);
+  for (int i = 0; i < numberOfFiles; ++i)
+    {
+    std::stringstream name;
+    name << "file" << i << ".vtk";
+    WriteCachedFile(cacheManager.GetPointer(), name.str().c_str(), 1000 + i, static_cast<char>(i % 26));
+    }
+  cacheManager->UpdateCacheInformation();
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < 1000; ++i)
+    {
+    cacheManager->CacheSizeCheck();
+    cacheManager->GetFreeCacheSpaceRemaining();
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkCacheManager-CacheSizeCheck-" << numberOfFiles
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  vtkTypeInt64 expectedSize = 0;
+  for (int i = 0; i < numberOfFiles; ++i)
+    {
+    expectedSize += 1000 + i;
+    }
+  if (!CheckCacheSize(__LINE__, cacheManager.GetPointer(), expectedSize))
+    {
+    return false;
+    }
+
+  timer->StartTimer();
+  vtkNew<vtkCacheManager> reloadedCacheManager;
+  reloadedCacheManager->SetRemoteCacheDirectory(cacheDirectory.c_str());
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkCacheManager-LoadIndex-" << numberOfFiles
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  if (!CheckCacheSize(__LINE__, reloadedCacheManager.GetPointer(), expectedSize))
+    {
+    return false;
+    }
+  cacheManager->ClearCache();
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkCacheManagerTest1(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string cacheDirectory = std::string(argv[1]) + "/vtkCacheManagerTest1";
+  vtksys::SystemTools::RemoveADirectory(cacheDirectory.c_str());
+
+  bool res = true;
+  res = res && TestIndex(cacheDirectory);
+  res = res && TestRebuildIndex(cacheDirectory);
+  res = res && TestBenchmark(cacheDirectory, 2000);
+
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
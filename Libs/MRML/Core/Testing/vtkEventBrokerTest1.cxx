@@ -0,0 +1,175 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+void CountEvent(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkEventBrokerTest1(int argc, char * argv[] )
+{
+  int numberOfSubjects = 10000;
+  if (argc > 1)
+    {
+    numberOfSubjects = atoi(argv[1]);
+    }
+
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  int initialNumberOfObservations = broker->GetNumberOfObservations();
+
+  int calls = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountEvent);
+  callback->SetClientData(&calls);
+
+  vtkNew<vtkObject> observer;
+  std::vector<vtkSmartPointer<vtkObject> > subjects;
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    subjects.push_back(vtkSmartPointer<vtkObject>::New());
+    }
+
+  //
+  // Add/remove many observations
+  //
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    broker->AddObservation(subjects[i], vtkCommand::ModifiedEvent,
+                           observer.GetPointer(), callback.GetPointer());
+    broker->AddObservation(subjects[i], vtkCommand::StartEvent,
+                           observer.GetPointer(), callback.GetPointer());
+    }
+  if (broker->GetNumberOfObservations() != initialNumberOfObservations + 2 * numberOfSubjects)
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected "
+              << initialNumberOfObservations + 2 * numberOfSubjects << " observations, got "
+              << broker->GetNumberOfObservations() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    if (!broker->GetObservationExist(subjects[i], vtkCommand::ModifiedEvent,
+                                     observer.GetPointer(), callback.GetPointer()) ||
+        broker->GetObservationExist(subjects[i], vtkCommand::EndEvent,
+                                    observer.GetPointer()))
+      {
+      std::cerr << "Line " << __LINE__ << " - GetObservationExist failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    broker->RemoveObservations(subjects[i], vtkCommand::StartEvent, observer.GetPointer());
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkEventBroker-AddFindRemove-" << numberOfSubjects
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  //
+  // Dispatch statistics
+  //
+  broker->DispatchStatisticsOn();
+  broker->ResetDispatchStatistics();
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    subjects[i]->Modified();
+    subjects[i]->InvokeEvent(vtkCommand::StartEvent);
+    }
+  if (calls != numberOfSubjects ||
+      broker->GetNumberOfDispatches(vtkCommand::ModifiedEvent) != static_cast<unsigned long>(numberOfSubjects) ||
+      broker->GetNumberOfDispatches(vtkCommand::StartEvent) != 0 ||
+      broker->GetTotalDispatchTime(vtkCommand::ModifiedEvent) < broker->GetMaximumDispatchTime(vtkCommand::ModifiedEvent))
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong dispatch: " << calls << " calls, "
+              << broker->GetNumberOfDispatches(vtkCommand::ModifiedEvent) << " dispatches"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->PrintDispatchStatistics(std::cout);
+  broker->DispatchStatisticsOff();
+
+  //
+  // Asynchronous mode: removed observations are not invoked
+  //
+  calls = 0;
+  broker->SetEventModeToAsynchronous();
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    subjects[i]->Modified();
+    subjects[i]->Modified();
+    }
+  if (calls != 0 || broker->GetNumberOfQueuedObservations() != numberOfSubjects)
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected " << numberOfSubjects
+              << " queued observations, got " << broker->GetNumberOfQueuedObservations()
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StartTimer();
+  for (int i = 0; i < numberOfSubjects; i += 2)
+    {
+    broker->RemoveObservations(subjects[i], observer.GetPointer());
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkEventBroker-RemoveQueued-" << numberOfSubjects
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  int expectedCalls = numberOfSubjects / 2;
+  if (broker->GetNumberOfQueuedObservations() != expectedCalls ||
+      broker->GetNthQueuedObservation(0)->GetSubject() != subjects[1])
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected " << expectedCalls
+              << " queued observations, got " << broker->GetNumberOfQueuedObservations()
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->SetEventModeToSynchronous();
+  if (calls != expectedCalls || broker->GetNumberOfQueuedObservations() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected " << expectedCalls
+              << " calls, got " << calls << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Deleting the subjects removes their observations
+  //
+  subjects.clear();
+  if (broker->GetNumberOfObservations() != initialNumberOfObservations)
+    {
+    std::cerr << "Line " << __LINE__ << " - Observations of deleted subjects were not removed: "
+              << broker->GetNumberOfObservations() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
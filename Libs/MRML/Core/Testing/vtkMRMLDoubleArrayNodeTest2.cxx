@@ -0,0 +1,255 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLDoubleArrayNode.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void PrintElapsedTime(const char* name, int numberOfPoints, vtkTimerLog* timer)
+{
+  std::cout << "<DartMeasurement name=\"vtkMRMLDoubleArrayNode-" << name << "-" << numberOfPoints
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool CheckValue(int line, const char* what, double value, double expected)
+{
+  if (fabs(value - expected) > 1e-9)
+    {
+    std::cerr << "Line " << line << " - " << what << ": "
+              << value << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestInterpolation()
+{
+  vtkNew<vtkMRMLDoubleArrayNode> node;
+  // empty array
+  if (!CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(1.), 0.))
+    {
+    return false;
+    }
+
+  // sorted
+  double x[4] = {0., 1., 3., 4.};
+  double y[4] = {10., 20., 0., 5.};
+  node->SetXYValues(x, y, NULL, 4);
+  if (!CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(0.5), 15.) ||
+      !CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(2.), 10.) ||
+      !CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(3.), 0.) ||
+      !CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(-1.), 10.) ||
+      !CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(10.), 5.))
+    {
+    return false;
+    }
+
+  // unsorted, the same points in a different order
+  double unsortedX[4] = {3., 0., 4., 1.};
+  double unsortedY[4] = {0., 10., 5., 20.};
+  node->SetXYValues(unsortedX, unsortedY, NULL, 4);
+  if (!CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(0.5), 15.) ||
+      !CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(2.), 10.) ||
+      !CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(3.5), 2.5))
+    {
+    return false;
+    }
+
+  // modifying a point invalidates the sort order
+  node->SetXYValue(0, 2., 30.);
+  if (!CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(1.5), 25.))
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestRanges()
+{
+  vtkNew<vtkMRMLDoubleArrayNode> node;
+  double x[3] = {1., 2., 3.};
+  double y[3] = {5., -1., 2.};
+  double yerr[3] = {1., 2., 0.5};
+  node->SetXYValues(x, y, yerr, 3);
+
+  double rangeX[2];
+  double rangeY[2];
+  node->GetRange(rangeX, rangeY);
+  if (!CheckValue(__LINE__, "X min", rangeX[0], 1.) || !CheckValue(__LINE__, "X max", rangeX[1], 3.) ||
+      !CheckValue(__LINE__, "Y min with error", rangeY[0], -3.) ||
+      !CheckValue(__LINE__, "Y max with error", rangeY[1], 6.))
+    {
+    return false;
+    }
+  node->GetYRange(rangeY, 0);
+  if (!CheckValue(__LINE__, "Y min", rangeY[0], -1.) || !CheckValue(__LINE__, "Y max", rangeY[1], 5.))
+    {
+    return false;
+    }
+
+  // the cached ranges follow the modifications
+  node->AddXYValue(-4., 8., 0.);
+  node->GetRange(rangeX, rangeY, 0);
+  if (!CheckValue(__LINE__, "X min after add", rangeX[0], -4.) ||
+      !CheckValue(__LINE__, "Y max after add", rangeY[1], 8.))
+    {
+    return false;
+    }
+  node->SetXYValue(3, 0., 0., 0.);
+  node->GetRange(rangeX, rangeY, 0);
+  if (!CheckValue(__LINE__, "X min after set", rangeX[0], 0.) ||
+      !CheckValue(__LINE__, "Y max after set", rangeY[1], 5.))
+    {
+    return false;
+    }
+  // Modifying the array directly is followed by a node Modified()
+  node->GetArray()->SetComponent(0, 1, 100.);
+  node->Modified();
+  node->GetYRange(rangeY, 0);
+  if (!CheckValue(__LINE__, "Y max after direct modification", rangeY[1], 100.))
+    {
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestBenchmark(int numberOfPoints)
+{
+  std::vector<double> x(numberOfPoints);
+  std::vector<double> y(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    x[i] = 0.1 * i;
+    y[i] = sin(0.001 * i);
+    }
+
+  vtkNew<vtkTimerLog> timer;
+
+  // Append one point at a time
+  vtkNew<vtkMRMLDoubleArrayNode> streamedNode;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    streamedNode->AddXYValue(x[i], y[i]);
+    }
+  timer->StopTimer();
+  PrintElapsedTime("AddXYValue", numberOfPoints, timer.GetPointer());
+
+  // Append blocks of points
+  const int blockSize = 1000;
+  vtkNew<vtkMRMLDoubleArrayNode> blockNode;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; i += blockSize)
+    {
+    blockNode->AddXYValues(&x[i], &y[i], NULL, std::min(blockSize, numberOfPoints - i));
+    }
+  timer->StopTimer();
+  PrintElapsedTime("AddXYValues", numberOfPoints, timer.GetPointer());
+
+  // Bulk import
+  vtkNew<vtkMRMLDoubleArrayNode> node;
+  timer->StartTimer();
+  node->SetXYValues(&x[0], &y[0], NULL, numberOfPoints);
+  timer->StopTimer();
+  PrintElapsedTime("SetXYValues", numberOfPoints, timer.GetPointer());
+
+  if (static_cast<int>(streamedNode->GetSize()) != numberOfPoints ||
+      static_cast<int>(blockNode->GetSize()) != numberOfPoints ||
+      static_cast<int>(node->GetSize()) != numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong number of points" << std::endl;
+    return false;
+    }
+
+  // Ranges, the first call computes them, the next ones are cached
+  double rangeX[2];
+  double rangeY[2];
+  timer->StartTimer();
+  node->GetRange(rangeX, rangeY);
+  timer->StopTimer();
+  PrintElapsedTime("GetRange", numberOfPoints, timer.GetPointer());
+  timer->StartTimer();
+  for (int i = 0; i < 1000; ++i)
+    {
+    node->GetRange(rangeX, rangeY);
+    }
+  timer->StopTimer();
+  PrintElapsedTime("GetRangeCached", numberOfPoints, timer.GetPointer());
+  double streamedRangeX[2];
+  double streamedRangeY[2];
+  streamedNode->GetRange(streamedRangeX, streamedRangeY);
+  if (rangeX[0] != streamedRangeX[0] || rangeX[1] != streamedRangeX[1] ||
+      rangeY[0] != streamedRangeY[0] || rangeY[1] != streamedRangeY[1])
+    {
+    std::cerr << "Line " << __LINE__ << " - Ranges of the streamed array differ" << std::endl;
+    return false;
+    }
+
+  // Interpolation
+  const int numberOfQueries = 100000;
+  double maxX = x[numberOfPoints - 1];
+  double sum = 0.;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    sum += node->GetYAxisValue(maxX * i / numberOfQueries);
+    }
+  timer->StopTimer();
+  PrintElapsedTime("GetYAxisValue", numberOfPoints, timer.GetPointer());
+  std::cout << "Sum of interpolated values: " << sum << std::endl;
+  int index = numberOfPoints / 3;
+  if (!CheckValue(__LINE__, "GetYAxisValue", node->GetYAxisValue(x[index] + 0.05),
+                  0.5 * (y[index] + y[index + 1])))
+    {
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLDoubleArrayNodeTest2(int argc, char * argv[])
+{
+  int numberOfPoints = 1000000;
+  if (argc > 1)
+    {
+    numberOfPoints = atoi(argv[1]);
+    }
+
+  bool res = true;
+  res = res && TestInterpolation();
+  res = res && TestRanges();
+  res = res && TestBenchmark(numberOfPoints);
+
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,267 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSceneEventRecorder.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+void CountEvent(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+//---------------------------------------------------------------------------
+void CountNodesModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                        void* clientData, void* callData)
+{
+  vtkCollection* nodes = reinterpret_cast<vtkCollection*>(callData);
+  *reinterpret_cast<int*>(clientData) = (nodes ? nodes->GetNumberOfItems() : -1);
+}
+
+//---------------------------------------------------------------------------
+void ModifyDisplayNodes(const std::vector<vtkSmartPointer<vtkMRMLModelDisplayNode> >& nodes,
+                        double value)
+{
+  for (size_t i = 0; i < nodes.size(); ++i)
+    {
+    nodes[i]->SetColor(value, 0.5, 0.5);
+    nodes[i]->SetOpacity(value);
+    nodes[i]->SetSliceIntersectionThickness(static_cast<int>(value * 10) + 1);
+    }
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+// Compare the number of callbacks invoked by bulk operations with and
+// without vtkMRMLScene::StartModify()/EndModify().
+int vtkMRMLSceneModifyTest(int argc, char * argv[] )
+{
+  int numberOfNodes = 1000;
+  if (argc > 1)
+    {
+    numberOfNodes = atoi(argv[1]);
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSceneEventRecorder> sceneRecorder;
+  scene->AddObserver(vtkCommand::AnyEvent, sceneRecorder.GetPointer());
+
+  int nodeModifiedEvents = 0;
+  vtkNew<vtkCallbackCommand> nodeCallback;
+  nodeCallback->SetCallback(CountEvent);
+  nodeCallback->SetClientData(&nodeModifiedEvents);
+
+  int batchedModifiedNodes = 0;
+  vtkNew<vtkCallbackCommand> nodesModifiedCallback;
+  nodesModifiedCallback->SetCallback(CountNodesModified);
+  nodesModifiedCallback->SetClientData(&batchedModifiedNodes);
+  scene->AddObserver(vtkMRMLScene::NodesModifiedEvent, nodesModifiedCallback.GetPointer());
+
+  std::vector<vtkSmartPointer<vtkMRMLModelDisplayNode> > nodes;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkSmartPointer<vtkMRMLModelDisplayNode> node = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
+    node->AddObserver(vtkCommand::ModifiedEvent, nodeCallback.GetPointer());
+    nodes.push_back(node);
+    }
+
+  //---------------------------------------------------------------------------
+  // Add nodes
+  //---------------------------------------------------------------------------
+  int wasModifying = scene->StartModify();
+  if (wasModifying != 0 || !scene->GetModifyingNodes())
+    {
+    std::cerr << "Line " << __LINE__ << " - StartModify failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned long sceneMTime = scene->GetMTime();
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    scene->AddNode(nodes[i]);
+    }
+  if (nodeModifiedEvents != 0 ||
+      sceneRecorder->CalledEvents[vtkCommand::ModifiedEvent] != 0 ||
+      sceneRecorder->CalledEvents[vtkMRMLScene::NodeAboutToBeAddedEvent] != static_cast<unsigned int>(numberOfNodes) ||
+      sceneRecorder->CalledEvents[vtkMRMLScene::NodeAddedEvent] != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Events fired while modifying the scene: "
+              << nodeModifiedEvents << " node modified events, "
+              << sceneRecorder->CalledEvents[vtkCommand::ModifiedEvent] << " scene modified events, "
+              << sceneRecorder->CalledEvents[vtkMRMLScene::NodeAddedEvent] << " node added events"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (scene->GetMTime() <= sceneMTime)
+    {
+    std::cerr << "Line " << __LINE__ << " - Scene MTime not updated while modifying the scene" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndModify(wasModifying);
+  if (nodeModifiedEvents > numberOfNodes ||
+      sceneRecorder->CalledEvents[vtkMRMLScene::NodeAddedEvent] != static_cast<unsigned int>(numberOfNodes) ||
+      sceneRecorder->CalledEvents[vtkCommand::ModifiedEvent] != 1 ||
+      sceneRecorder->CalledEvents[vtkMRMLScene::StartBatchProcessEvent] != 1 ||
+      sceneRecorder->CalledEvents[vtkMRMLScene::EndBatchProcessEvent] != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong events fired by EndModify: "
+              << nodeModifiedEvents << " node modified events, "
+              << sceneRecorder->CalledEvents[vtkCommand::ModifiedEvent] << " scene modified events"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //---------------------------------------------------------------------------
+  // Modify nodes one by one
+  //---------------------------------------------------------------------------
+  vtkNew<vtkTimerLog> timer;
+  nodeModifiedEvents = 0;
+  timer->StartTimer();
+  ModifyDisplayNodes(nodes, 0.2);
+  timer->StopTimer();
+  int unbatchedEvents = nodeModifiedEvents;
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-Unbatched-" << numberOfNodes
+            << "-Time\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-Unbatched-" << numberOfNodes
+            << "-Callbacks\" type=\"numeric/integer\">"
+            << unbatchedEvents << "</DartMeasurement>" << std::endl;
+
+  //---------------------------------------------------------------------------
+  // Modify nodes within StartModify/EndModify
+  //---------------------------------------------------------------------------
+  nodeModifiedEvents = 0;
+  sceneRecorder->CalledEvents.clear();
+  timer->StartTimer();
+  wasModifying = scene->StartModify();
+  ModifyDisplayNodes(nodes, 0.8);
+  int nestedWasModifying = scene->StartModify();
+  ModifyDisplayNodes(nodes, 0.6);
+  scene->EndModify(nestedWasModifying);
+  if (nodeModifiedEvents != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Nested EndModify fired "
+              << nodeModifiedEvents << " events" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int modifiedNodes = scene->EndModify(wasModifying);
+  timer->StopTimer();
+  int batchedEvents = nodeModifiedEvents;
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-Batched-" << numberOfNodes
+            << "-Time\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-Batched-" << numberOfNodes
+            << "-Callbacks\" type=\"numeric/integer\">"
+            << batchedEvents << "</DartMeasurement>" << std::endl;
+
+  if (sceneRecorder->CalledEvents[vtkMRMLScene::NodesModifiedEvent] != 1 ||
+      batchedModifiedNodes != numberOfNodes)
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected one NodesModifiedEvent with " << numberOfNodes
+              << " nodes, got " << sceneRecorder->CalledEvents[vtkMRMLScene::NodesModifiedEvent]
+              << " events with " << batchedModifiedNodes << " nodes" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (batchedEvents != numberOfNodes ||
+      modifiedNodes != numberOfNodes ||
+      unbatchedEvents != 3 * numberOfNodes)
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected " << numberOfNodes
+              << " batched and " << 3 * numberOfNodes << " unbatched callbacks, got "
+              << batchedEvents << " and " << unbatchedEvents << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (nodes[0]->GetOpacity() != 0.6 || nodes[0]->GetDisableModifiedEvent())
+    {
+    std::cerr << "Line " << __LINE__ << " - Nodes not restored after EndModify" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //---------------------------------------------------------------------------
+  // Remove a node being modified
+  //---------------------------------------------------------------------------
+  nodeModifiedEvents = 0;
+  wasModifying = scene->StartModify();
+  nodes[0]->SetOpacity(0.1);
+  scene->RemoveNode(nodes[0]);
+  if (nodeModifiedEvents != 1 || nodes[0]->GetDisableModifiedEvent())
+    {
+    std::cerr << "Line " << __LINE__ << " - RemoveNode did not flush the node events" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndModify(wasModifying);
+  if (nodeModifiedEvents != 1 || scene->GetModifyingNodes())
+    {
+    std::cerr << "Line " << __LINE__ << " - Removed node notified twice" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //---------------------------------------------------------------------------
+  // Node references are updated at EndModify
+  //---------------------------------------------------------------------------
+  vtkNew<vtkMRMLModelNode> modelNode;
+  scene->AddNode(modelNode.GetPointer());
+  modelNode->SetAndObserveDisplayNodeID(nodes[1]->GetID());
+  wasModifying = scene->StartModify();
+  scene->RemoveNode(nodes[1]);
+  if (modelNode->GetNumberOfNodeReferences("display") != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - References updated while modifying the scene" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndModify(wasModifying);
+  if (modelNode->GetNumberOfNodeReferences("display") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - References not updated by EndModify" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //---------------------------------------------------------------------------
+  // Deleting the scene restores the nodes being modified
+  //---------------------------------------------------------------------------
+  vtkSmartPointer<vtkMRMLScene> deletedScene = vtkSmartPointer<vtkMRMLScene>::New();
+  deletedScene->StartModify();
+  vtkNew<vtkMRMLModelDisplayNode> deletedSceneNode;
+  deletedScene->AddNode(deletedSceneNode.GetPointer());
+  deletedScene = 0;
+  if (deletedSceneNode->GetDisableModifiedEvent())
+    {
+    std::cerr << "Line " << __LINE__ << " - Node still modified after the scene is deleted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
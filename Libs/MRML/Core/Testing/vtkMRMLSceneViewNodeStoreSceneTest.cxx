@@ -23,13 +23,43 @@
 #include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLSceneViewNode.h"
+#include "vtkMRMLStorageNode.h"
 
 // VTK includes
 #include <vtkCollection.h>
 #include <vtkNew.h>
+#include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Display node counting its instances, i.e. the copies made by scene views.
+class vtkMRMLDisplayNodeTestHelper : public vtkMRMLScalarVolumeDisplayNode
+{
+public:
+  static vtkMRMLDisplayNodeTestHelper *New();
+  vtkTypeMacro(vtkMRMLDisplayNodeTestHelper, vtkMRMLScalarVolumeDisplayNode);
+
+  virtual vtkMRMLNode* CreateNodeInstance();
+  virtual const char* GetNodeTagName() { return "DisplayTestHelper"; }
+
+  static int InstanceCount;
+
+protected:
+  vtkMRMLDisplayNodeTestHelper() { ++InstanceCount; }
+  ~vtkMRMLDisplayNodeTestHelper() {}
+  vtkMRMLDisplayNodeTestHelper(const vtkMRMLDisplayNodeTestHelper&);
+  void operator=(const vtkMRMLDisplayNodeTestHelper&);
+};
+
+int vtkMRMLDisplayNodeTestHelper::InstanceCount = 0;
+
+//---------------------------------------------------------------------------
+vtkMRMLNodeNewMacro(vtkMRMLDisplayNodeTestHelper);
+
 namespace
 {
 
@@ -42,6 +72,11 @@ bool storeAndRestoreTwice();
 bool storeTwiceAndRemoveVolume();
 bool references();
 bool storePerformance();
+bool storeAndRestoreViewsPerformance();
+bool deleteSharingSceneView();
+bool modifyStoredScene();
+bool modifyWithoutModifiedTime();
+bool writeAndReadSharedNodes();
 
 } // end of anonymous namespace
 
@@ -89,6 +124,31 @@ int vtkMRMLSceneViewNodeStoreSceneTest(int vtkNotUsed(argc),
     std::cerr << "updateNodeIDs call not successful." << std::endl;
     return EXIT_FAILURE;
     }
+  if (!storeAndRestoreViewsPerformance())
+    {
+    std::cerr << "storeAndRestoreViewsPerformance call not successful." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!deleteSharingSceneView())
+    {
+    std::cerr << "deleteSharingSceneView call not successful." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!modifyStoredScene())
+    {
+    std::cerr << "modifyStoredScene call not successful." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!modifyWithoutModifiedTime())
+    {
+    std::cerr << "modifyWithoutModifiedTime call not successful." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!writeAndReadSharedNodes())
+    {
+    std::cerr << "writeAndReadSharedNodes call not successful." << std::endl;
+    return EXIT_FAILURE;
+    }
 
   return EXIT_SUCCESS;
 }
@@ -379,4 +439,337 @@ bool storePerformance()
   return true;
 }
 
+//---------------------------------------------------------------------------
+bool storeAndRestoreViewsPerformance()
+{
+  // 5000 nodes, each scene view changes the opacity of one display node
+  vtkNew<vtkMRMLScene> scene;
+  const int displayNodePairCount = 2500;
+  const int sceneViewCount = 50;
+
+  for (int i = 0; i < displayNodePairCount; ++i)
+    {
+    vtkNew<vtkMRMLDisplayNodeTestHelper> displayNode;
+    scene->AddNode(displayNode.GetPointer());
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    scene->AddNode(volumeNode.GetPointer());
+    volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+    }
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(
+    scene->GetNthNodeByClass(0, "vtkMRMLDisplayNodeTestHelper"));
+
+  std::vector<vtkSmartPointer<vtkMRMLSceneViewNode> > sceneViewNodes;
+  const int instanceCount = vtkMRMLDisplayNodeTestHelper::InstanceCount;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < sceneViewCount; ++i)
+    {
+    displayNode->SetOpacity(static_cast<double>(i) / sceneViewCount);
+    vtkNew<vtkMRMLSceneViewNode> sceneViewNode;
+    scene->AddNode(sceneViewNode.GetPointer());
+    sceneViewNode->StoreScene();
+    sceneViewNodes.push_back(sceneViewNode.GetPointer());
+    }
+  timer->StopTimer();
+  std::cout<< "<DartMeasurement name=\"vtkMRMLSceneViewNode-StoreViewsPerformance-"
+           << sceneViewCount << "\" type=\"numeric/double\">"
+           << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // Unmodified nodes are shared by the scene views: the first scene view
+  // copies all the display nodes, the next ones only the modified one.
+  const int copyCount = vtkMRMLDisplayNodeTestHelper::InstanceCount - instanceCount;
+  std::cout<< "<DartMeasurement name=\"vtkMRMLSceneViewNode-StoredDisplayNodeCopies-"
+           << sceneViewCount << "\" type=\"numeric/integer\">"
+           << copyCount << "</DartMeasurement>" << std::endl;
+  if (copyCount != displayNodePairCount + sceneViewCount - 1)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::StoreScene() failed, "
+              << copyCount << " display node copies for " << sceneViewCount
+              << " scene views of " << displayNodePairCount << " display nodes" << std::endl;
+    return false;
+    }
+
+  timer->StartTimer();
+  for (int i = sceneViewCount - 1; i >= 0; --i)
+    {
+    sceneViewNodes[i]->RestoreScene();
+    if (displayNode->GetOpacity() != static_cast<double>(i) / sceneViewCount)
+      {
+      std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+                << "opacity " << displayNode->GetOpacity() << " instead of "
+                << static_cast<double>(i) / sceneViewCount << std::endl;
+      return false;
+      }
+    }
+  timer->StopTimer();
+  std::cout<< "<DartMeasurement name=\"vtkMRMLSceneViewNode-RestoreViewsPerformance-"
+           << sceneViewCount << "\" type=\"numeric/double\">"
+           << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // Modifications are restored
+  displayNode->SetOpacity(1.);
+  sceneViewNodes[1]->RestoreScene();
+  if (displayNode->GetOpacity() != 1. / sceneViewCount)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+              << "opacity " << displayNode->GetOpacity() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+// Return the display node stored by sceneViewNode if it is referenced by the
+// stored volume node, 0 otherwise.
+vtkMRMLDisplayNode* getStoredDisplayNode(vtkMRMLSceneViewNode* sceneViewNode)
+{
+  vtkMRMLScene* storedScene = sceneViewNode->GetStoredScene();
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(
+    storedScene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    storedScene->GetNodeByID("vtkMRMLScalarVolumeNode1"));
+  if (!displayNode || !volumeNode ||
+      displayNode->GetScene() != storedScene ||
+      volumeNode->GetScene() != storedScene ||
+      volumeNode->GetDisplayNode() != displayNode)
+    {
+    return 0;
+    }
+  return displayNode;
+}
+
+//---------------------------------------------------------------------------
+bool deleteSharingSceneView()
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer());
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  displayNode->SetOpacity(0.2);
+
+  vtkSmartPointer<vtkMRMLSceneViewNode> sceneViewNode1 =
+    vtkSmartPointer<vtkMRMLSceneViewNode>::New();
+  scene->AddNode(sceneViewNode1);
+  sceneViewNode1->StoreScene();
+  // All the nodes are shared with the first scene view
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode2;
+  scene->AddNode(sceneViewNode2.GetPointer());
+  sceneViewNode2->StoreScene();
+
+  // Delete the first scene view, the second one still uses the shared nodes
+  scene->RemoveNode(sceneViewNode1);
+  sceneViewNode1 = 0;
+
+  displayNode->SetOpacity(0.8);
+  sceneViewNode2->RestoreScene();
+  if (displayNode->GetOpacity() != 0.2)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+              << "opacity " << displayNode->GetOpacity() << " instead of 0.2" << std::endl;
+    return false;
+    }
+
+  // The stored nodes belong to the stored scene of the second scene view
+  vtkMRMLDisplayNode* storedDisplayNode = getStoredDisplayNode(sceneViewNode2.GetPointer());
+  if (!storedDisplayNode || storedDisplayNode->GetOpacity() != 0.2)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::GetStoredScene() failed, "
+              << "the stored nodes are not in the stored scene" << std::endl;
+    return false;
+    }
+  vtkCollection* storedNodes = sceneViewNode2->GetStoredScene()->GetNodes();
+  for (int i = 0; i < storedNodes->GetNumberOfItems(); ++i)
+    {
+    vtkMRMLNode* storedNode = vtkMRMLNode::SafeDownCast(storedNodes->GetItemAsObject(i));
+    if (storedNode->GetScene() != sceneViewNode2->GetStoredScene())
+      {
+      std::cout << __LINE__ << ": vtkMRMLSceneViewNode::GetStoredScene() failed, "
+                << storedNode->GetID() << " is not in the stored scene" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool modifyStoredScene()
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer());
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  displayNode->SetOpacity(0.2);
+
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode1;
+  scene->AddNode(sceneViewNode1.GetPointer());
+  sceneViewNode1->StoreScene();
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode2;
+  scene->AddNode(sceneViewNode2.GetPointer());
+  sceneViewNode2->StoreScene();
+
+  // Modify the nodes stored by the first scene view, like when annotations
+  // are converted into markups: the second scene view must not change.
+  vtkMRMLDisplayNode* storedDisplayNode1 = getStoredDisplayNode(sceneViewNode1.GetPointer());
+  if (!storedDisplayNode1)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::GetStoredScene() failed" << std::endl;
+    return false;
+    }
+  storedDisplayNode1->SetOpacity(0.5);
+  sceneViewNode1->UpdateStoredScene();
+
+  displayNode->SetOpacity(0.8);
+  sceneViewNode2->RestoreScene();
+  if (displayNode->GetOpacity() != 0.2)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+              << "opacity " << displayNode->GetOpacity() << " instead of 0.2" << std::endl;
+    return false;
+    }
+  sceneViewNode1->RestoreScene();
+  if (displayNode->GetOpacity() != 0.5)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+              << "opacity " << displayNode->GetOpacity() << " instead of 0.5" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool modifyWithoutModifiedTime()
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer());
+
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode1;
+  scene->AddNode(sceneViewNode1.GetPointer());
+  // creates the storage node of the volume
+  sceneViewNode1->StoreScene();
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeNode1"));
+  vtkMRMLStorageNode* storageNode = volumeNode->GetStorageNode();
+  if (!storageNode || storageNode->GetNumberOfFileNames() != 0)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::StoreScene() failed, "
+              << "no storage node" << std::endl;
+    return false;
+    }
+
+  // AddFileName() doesn't change the modification time of the node
+  storageNode->AddFileName("volume2.nrrd");
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode2;
+  scene->AddNode(sceneViewNode2.GetPointer());
+  sceneViewNode2->StoreScene();
+
+  storageNode->ResetFileNameList();
+  sceneViewNode2->RestoreScene();
+  if (storageNode->GetNumberOfFileNames() != 1)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+              << storageNode->GetNumberOfFileNames() << " file names instead of 1"
+              << std::endl;
+    return false;
+    }
+  sceneViewNode1->RestoreScene();
+  if (storageNode->GetNumberOfFileNames() != 0)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed, "
+              << storageNode->GetNumberOfFileNames() << " file names instead of 0"
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool writeAndReadSharedNodes()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNodeToRegister;
+  scene->RegisterNodeClass(sceneViewNodeToRegister.GetPointer());
+  populateScene(scene.GetPointer());
+  vtkMRMLDisplayNode* displayNode = vtkMRMLDisplayNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+
+  // The second scene view shares all the nodes but the display node
+  displayNode->SetOpacity(0.2);
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode1;
+  scene->AddNode(sceneViewNode1.GetPointer());
+  sceneViewNode1->StoreScene();
+  displayNode->SetOpacity(0.8);
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode2;
+  scene->AddNode(sceneViewNode2.GetPointer());
+  sceneViewNode2->StoreScene();
+
+  scene->SetSaveToXMLString(1);
+  scene->Commit();
+  std::string xmlScene = scene->GetSceneXMLString();
+
+  // Writing the scene views doesn't copy their shared nodes, neither does
+  // getting the nodes of another class.
+  std::vector<vtkMRMLNode*> storedDisplayNodes;
+  sceneViewNode2->GetNodesByClass("vtkMRMLDisplayNode", storedDisplayNodes);
+  for (int i = 0; i < sceneViewNode2->GetNumberOfStoredNodes(); ++i)
+    {
+    vtkMRMLNode* storedNode = sceneViewNode2->GetNthStoredNode(i);
+    bool copied = storedNode->GetScene() != 0;
+    if (copied != (storedNode->IsA("vtkMRMLDisplayNode") != 0))
+      {
+      std::cout << __LINE__ << ": vtkMRMLSceneViewNode::WriteXML() failed, "
+                << storedNode->GetID() << (copied ? " is" : " is not")
+                << " copied" << std::endl;
+      return false;
+      }
+    }
+
+  // Writing the scene views doesn't change what they restore
+  sceneViewNode1->RestoreScene();
+  if (displayNode->GetOpacity() != 0.2)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed after writing, "
+              << "opacity " << displayNode->GetOpacity() << " instead of 0.2" << std::endl;
+    return false;
+    }
+  sceneViewNode2->RestoreScene();
+  if (displayNode->GetOpacity() != 0.8)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed after writing, "
+              << "opacity " << displayNode->GetOpacity() << " instead of 0.8" << std::endl;
+    return false;
+    }
+
+  // Each scene view is read with its own nodes
+  vtkNew<vtkMRMLScene> scene2;
+  scene2->RegisterNodeClass(sceneViewNodeToRegister.GetPointer());
+  scene2->SetLoadFromXMLString(1);
+  scene2->SetSceneXMLString(xmlScene);
+  scene2->Import();
+  const double opacities[2] = {0.2, 0.8};
+  for (int i = 0; i < 2; ++i)
+    {
+    vtkMRMLSceneViewNode* sceneViewNode = vtkMRMLSceneViewNode::SafeDownCast(
+      scene2->GetNthNodeByClass(i, "vtkMRMLSceneViewNode"));
+    vtkMRMLDisplayNode* storedDisplayNode =
+      sceneViewNode ? getStoredDisplayNode(sceneViewNode) : 0;
+    if (!storedDisplayNode || storedDisplayNode->GetOpacity() != opacities[i])
+      {
+      std::cout << __LINE__ << ": reading scene view " << i << " failed" << std::endl
+                << xmlScene << std::endl;
+      return false;
+      }
+    }
+  vtkMRMLSceneViewNode::SafeDownCast(
+    scene2->GetNthNodeByClass(0, "vtkMRMLSceneViewNode"))->RestoreScene();
+  vtkMRMLDisplayNode* displayNode2 = vtkMRMLDisplayNode::SafeDownCast(
+    scene2->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  if (!displayNode2 || displayNode2->GetOpacity() != 0.2)
+    {
+    std::cout << __LINE__ << ": vtkMRMLSceneViewNode::RestoreScene() failed after reading"
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
 } // end of anonymous namespace
@@ -0,0 +1,213 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLGridTransformNode.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkOrientedGridTransform.h"
+
+// VTK includes
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool ComparePoints(vtkPoints* points, vtkGeneralTransform* transform, vtkPoints* transformedPoints)
+{
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+    double expected[3] = {0, 0, 0};
+    transform->TransformPoint(points->GetPoint(i), expected);
+    double* actual = transformedPoints->GetPoint(i);
+    if (vtkMath::Distance2BetweenPoints(expected, actual) > 1e-8)
+      {
+      std::cerr << "Line " << __LINE__ << " - Point " << i << " mismatch: expected ("
+                << expected[0] << ", " << expected[1] << ", " << expected[2] << "), got ("
+                << actual[0] << ", " << actual[1] << ", " << actual[2] << ")" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLTransformNodeTransformPointsTest(int argc, char * argv[] )
+{
+  int numberOfPoints = 200000;
+  if (argc > 1)
+    {
+    numberOfPoints = atoi(argv[1]);
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+
+  // Two linear transforms on top of a grid transform
+  vtkNew<vtkMRMLLinearTransformNode> grandParentNode;
+  scene->AddNode(grandParentNode.GetPointer());
+  vtkNew<vtkMatrix4x4> grandParentMatrix;
+  grandParentMatrix->SetElement(0, 3, 10.);
+  grandParentMatrix->SetElement(0, 1, 0.2);
+  grandParentNode->SetMatrixTransformToParent(grandParentMatrix.GetPointer());
+
+  vtkNew<vtkMRMLLinearTransformNode> parentNode;
+  scene->AddNode(parentNode.GetPointer());
+  parentNode->SetAndObserveTransformNodeID(grandParentNode->GetID());
+  vtkNew<vtkMatrix4x4> parentMatrix;
+  parentMatrix->SetElement(1, 1, 2.);
+  parentMatrix->SetElement(2, 3, -5.);
+  parentNode->SetMatrixTransformToParent(parentMatrix.GetPointer());
+
+  vtkNew<vtkImageData> displacementGrid;
+  displacementGrid->SetExtent(0, 9, 0, 9, 0, 9);
+  displacementGrid->SetOrigin(-50, -50, -50);
+  displacementGrid->SetSpacing(10, 10, 10);
+#if (VTK_MAJOR_VERSION <= 5)
+  displacementGrid->SetScalarTypeToDouble();
+  displacementGrid->SetNumberOfScalarComponents(3);
+  displacementGrid->AllocateScalars();
+#else
+  displacementGrid->AllocateScalars(VTK_DOUBLE, 3);
+#endif
+  double* displacement = static_cast<double*>(displacementGrid->GetScalarPointer());
+  for (int i = 0; i < 10 * 10 * 10 * 3; ++i)
+    {
+    displacement[i] = (i % 7) * 0.5;
+    }
+  vtkNew<vtkOrientedGridTransform> gridTransform;
+#if (VTK_MAJOR_VERSION <= 5)
+  gridTransform->SetDisplacementGrid(displacementGrid.GetPointer());
+#else
+  gridTransform->SetDisplacementGridData(displacementGrid.GetPointer());
+#endif
+  vtkNew<vtkMRMLGridTransformNode> gridNode;
+  scene->AddNode(gridNode.GetPointer());
+  gridNode->SetAndObserveTransformNodeID(parentNode->GetID());
+  gridNode->SetAndObserveTransformToParent(gridTransform.GetPointer());
+
+  // Linear transforms are merged
+  vtkGeneralTransform* compiledTransform = gridNode->GetCompiledTransformToWorld();
+  if (compiledTransform == NULL
+    || compiledTransform->GetNumberOfConcatenatedTransforms() != 2
+    || gridNode->GetCompiledTransformToWorld() != compiledTransform)
+    {
+    std::cerr << "Line " << __LINE__ << " - GetCompiledTransformToWorld failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned long compiledMTime = compiledTransform->GetMTime();
+  gridNode->GetCompiledTransformToWorld();
+  if (compiledTransform->GetMTime() != compiledMTime)
+    {
+    std::cerr << "Line " << __LINE__ << " - Compiled transform rebuilt although"
+              << " the transforms were not modified" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    points->SetPoint(i, (i % 97) - 48., ((i / 97) % 89) - 44., (i % 83) - 41.);
+    }
+
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  gridNode->GetTransformToWorld(transformToWorld.GetPointer());
+  vtkNew<vtkPoints> expectedPoints;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  transformToWorld->TransformPoints(points.GetPointer(), expectedPoints.GetPointer());
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkGeneralTransform-TransformPoints-" << numberOfPoints
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  vtkNew<vtkPoints> transformedPoints;
+  timer->StartTimer();
+  gridNode->TransformPointsToWorld(points.GetPointer(), transformedPoints.GetPointer());
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLTransformNode-TransformPointsToWorld-" << numberOfPoints
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  if (transformedPoints->GetNumberOfPoints() != numberOfPoints
+    || !ComparePoints(points.GetPointer(), transformToWorld.GetPointer(), transformedPoints.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - TransformPointsToWorld failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modifying a parent transform updates the compiled transform
+  grandParentMatrix->SetElement(1, 3, 3.);
+  grandParentNode->SetMatrixTransformToParent(grandParentMatrix.GetPointer());
+  transformToWorld->Identity();
+  gridNode->GetTransformToWorld(transformToWorld.GetPointer());
+  gridNode->TransformPointsToWorld(points.GetPointer(), transformedPoints.GetPointer());
+  if (!ComparePoints(points.GetPointer(), transformToWorld.GetPointer(), transformedPoints.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Compiled transform not updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Changing the parent updates the compiled transform, in-place transform
+  gridNode->SetAndObserveTransformNodeID(grandParentNode->GetID());
+  transformToWorld->Identity();
+  gridNode->GetTransformToWorld(transformToWorld.GetPointer());
+  transformedPoints->DeepCopy(points.GetPointer());
+  gridNode->TransformPointsToWorld(transformedPoints.GetPointer(), transformedPoints.GetPointer());
+  if (!ComparePoints(points.GetPointer(), transformToWorld.GetPointer(), transformedPoints.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Compiled transform not updated after reparenting" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The compiled transform from world, used to resample volumes, is the
+  // inverse of the compiled transform to world, it is updated with it
+  vtkAbstractTransform* compiledTransformFromWorld = gridNode->GetCompiledTransformFromWorld();
+  if (compiledTransformFromWorld == NULL
+    || gridNode->GetCompiledTransformFromWorld() != compiledTransformFromWorld)
+    {
+    std::cerr << "Line " << __LINE__ << " - GetCompiledTransformFromWorld failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // The grid inverse is iterative, check a subset of the points
+  for (vtkIdType i = 0; i < 1000 && i < numberOfPoints; ++i)
+    {
+    double point[3] = {0, 0, 0};
+    compiledTransformFromWorld->TransformPoint(transformedPoints->GetPoint(i), point);
+    if (vtkMath::Distance2BetweenPoints(point, points->GetPoint(i)) > 1e-4)
+      {
+      std::cerr << "Line " << __LINE__ << " - Point " << i
+                << " not inverted by GetCompiledTransformFromWorld" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
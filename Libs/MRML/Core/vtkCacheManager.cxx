@@ -5,15 +5,71 @@
 #include "vtkMRMLStorageNode.h"
 
 #include <vtksys/Directory.hxx>
+#include <vtksys/MD5.h>
 #include <vtksys/SystemTools.hxx>
 
 #include <vtkCallbackCommand.h>
+#include <vtkCriticalSection.h>
 #include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <unistd.h>
+#endif
 
 vtkStandardNewMacro ( vtkCacheManager );
 
 #define MB 1000000.0
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+std::string ComputeFileHash ( const std::string& fileName )
+{
+  std::ifstream input ( fileName.c_str(), std::ios::in | std::ios::binary );
+  if ( !input )
+    {
+    return std::string();
+    }
+  vtksysMD5 *md5 = vtksysMD5_New();
+  vtksysMD5_Initialize ( md5 );
+  std::vector<char> buffer ( 65536 );
+  while ( input )
+    {
+    input.read ( &buffer[0], static_cast<std::streamsize>(buffer.size()) );
+    std::streamsize length = input.gcount();
+    if ( length > 0 )
+      {
+      vtksysMD5_Append ( md5, reinterpret_cast<unsigned char const*>(&buffer[0]),
+                         static_cast<int>(length) );
+      }
+    }
+  char hash[33];
+  vtksysMD5_FinalizeHex ( md5, hash );
+  hash[32] = 0;
+  vtksysMD5_Delete ( md5 );
+  return std::string ( hash );
+}
+
+//----------------------------------------------------------------------------
+bool LinkCachedFile ( const std::string& target, const std::string& linkName )
+{
+#ifdef _WIN32
+  return CreateHardLinkA ( linkName.c_str(), target.c_str(), NULL ) != 0;
+#else
+  return link ( target.c_str(), linkName.c_str() ) == 0;
+#endif
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkCacheManager::vtkCacheManager()
 {
@@ -26,14 +82,24 @@ vtkCacheManager::vtkCacheManager()
   this->CurrentCacheSize = 0;
   this->EnableForceRedownload = 0;
   this->InsufficientFreeBufferNotificationFlag = 0;
+  this->EnableAutomaticEviction = 1;
+  this->EnableDeduplication = 1;
   // this->EnableRemoteCacheOverwriting = 1;
   this->uriMap.clear();
+  this->CacheSizeInBytes = 0;
+  this->CacheIndexModified = false;
+  this->CacheIndexLock = vtkCriticalSection::New();
 }
 
 
 //----------------------------------------------------------------------------
 vtkCacheManager::~vtkCacheManager()
 {
+  if ( this->CacheIndexModified )
+    {
+    this->SaveCacheIndex();
+    }
+  this->CacheIndexLock->Delete();
 
   this->MRMLScene = NULL;
   this->uriMap.clear();
@@ -133,7 +199,13 @@ void vtkCacheManager::SetRemoteCacheDirectory (const char *dir )
     {
     vtksys::SystemTools::MakeDirectory(this->RemoteCacheDirectory.c_str());
     }
-  // scan files in cache, it calls Modified
+  //--- read the index of the files in cache, scan the
+  //--- directory only if it has no index yet.
+  if ( !this->LoadCacheIndex() )
+    {
+    this->RebuildCacheIndex();
+    }
+  // list files in cache, it calls Modified
   this->UpdateCacheInformation();
 }
 
@@ -254,6 +326,9 @@ void vtkCacheManager::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "RemoteCacheFreeBufferSize: " << this->GetRemoteCacheFreeBufferSize() << "\n";
   //os << indent << "EnableRemoteCacheOverwriting: " << this->GetEnableRemoteCacheOverwriting() << "\n";
   os << indent << "EnableForceRedownload: " << this->GetEnableForceRedownload() << "\n";
+  os << indent << "EnableAutomaticEviction: " << this->GetEnableAutomaticEviction() << "\n";
+  os << indent << "EnableDeduplication: " << this->GetEnableDeduplication() << "\n";
+  os << indent << "CacheSizeInBytes: " << this->GetCacheSizeInBytes() << "\n";
 }
 
 
@@ -508,15 +583,21 @@ const char* vtkCacheManager::GetFilenameFromURI ( const char *uri )
 //----------------------------------------------------------------------------
 void vtkCacheManager::UpdateCacheInformation ( )
 {
-  //--- now recompute cache size
-  // this->CurrentCacheSize = ?;
-
-  //--- recompute free buffer size
-  // this->RemoteCacheFreeBufferSize = ?;
-
-  //--- and refresh list of cached files.
+  //--- the cache size is kept up to date by the cache index,
+  //--- refresh list of cached files from it and save it if needed.
+  this->CacheIndexLock->Lock();
   this->CachedFileList.clear();
-  this->GetCachedFileList ( this->GetRemoteCacheDirectory() );
+  for ( std::map<std::string, CacheEntry>::const_iterator it = this->CacheIndex.begin();
+        it != this->CacheIndex.end(); ++it )
+    {
+    this->CachedFileList.push_back ( vtksys::SystemTools::GetFilenameName ( it->first ) );
+    }
+  this->CurrentCacheSize = static_cast<float>(this->CacheSizeInBytes / MB);
+  if ( this->CacheIndexModified )
+    {
+    this->SaveCacheIndex();
+    }
+  this->CacheIndexLock->Unlock();
   this->Modified();
 }
 
@@ -569,6 +650,7 @@ void vtkCacheManager::DeleteFromCache( const char *target )
   if ( str.c_str() != NULL )
     {
     this->MarkNodesBeforeDeletingDataFromCache ( target );
+    std::string relativePath = this->GetRelativeCachePath ( str.c_str() );
 
     //--- remove the file or directory in str....
     vtkDebugMacro ( "Removing " << str.c_str() << " from disk and from record of cached files." );
@@ -580,6 +662,9 @@ void vtkCacheManager::DeleteFromCache( const char *target )
         }
       else
         {
+        this->CacheIndexLock->Lock();
+        this->RemoveCacheEntries ( relativePath );
+        this->CacheIndexLock->Unlock();
         this->UpdateCacheInformation ( );
         this->InvokeEvent ( vtkCacheManager::CacheDeleteEvent );
         }
@@ -592,6 +677,9 @@ void vtkCacheManager::DeleteFromCache( const char *target )
         }
       else
         {
+        this->CacheIndexLock->Lock();
+        this->RemoveCacheEntry ( relativePath );
+        this->CacheIndexLock->Unlock();
         this->UpdateCacheInformation ( );
         this->InvokeEvent ( vtkCacheManager::CacheDeleteEvent );
         }
@@ -648,6 +736,10 @@ int vtkCacheManager::ClearCache()
     vtkWarningMacro ( "Cache cleared: Error: unable to recreate cache directory after deleting its contents." );
     return 0;
     }
+  //--- the index file went away with the directory.
+  this->CacheIndexLock->Lock();
+  this->ClearCacheIndex();
+  this->CacheIndexLock->Unlock();
   this->UpdateCacheInformation();
   this->InvokeEvent ( vtkCacheManager::CacheClearEvent );
   return 1;
@@ -658,12 +750,7 @@ int vtkCacheManager::ClearCache()
 //----------------------------------------------------------------------------
 float vtkCacheManager::GetCurrentCacheSize ()
 {
-  if ( this->RemoteCacheDirectory.c_str() == NULL )
-    {
-    return (0.0);
-    }
-  float size = this->ComputeCacheSize ( this->RemoteCacheDirectory.c_str(), 0 );
-  this->SetCurrentCacheSize ( size );
+  this->CurrentCacheSize = static_cast<float>(this->GetCacheSizeInBytes() / MB);
   return ( this->CurrentCacheSize );
 
 }
@@ -676,6 +763,10 @@ void vtkCacheManager::MarkNode ( std::string str )
   //--- If such a node exists, mark it as modified since read,
   //--- so that a user will be prompted to save the
   //--- data elsewhere (since it'll be deleted from cache.)
+  if ( this->MRMLScene == NULL )
+    {
+    return;
+    }
   int nnodes = this->MRMLScene->GetNumberOfNodesByClass ( "vtkMRMLStorableNode" );
   vtkMRMLStorableNode *node;
   std::string uri;
@@ -768,52 +859,10 @@ void vtkCacheManager::MarkNodesBeforeDeletingDataFromCache (const char *target )
 float vtkCacheManager::ComputeCacheSize( const char *dirName, unsigned long sz )
 {
 
-  //--- Traverses cache directory and computes the combined size
-  //--- of all files. I guess this is a reasonable guess to the cache size,
+  //--- The size of the cache directory is kept by the cache index,
+  //--- other directories are traversed to sum the size of their files,
   //--- subdirectory size notwithstanding.
-  //--- TODO: is there a more accurate way to assess?
-
-  unsigned long cachesize = sz;
-  std::string testFile;
-  std::string longName;;
-  std::string subdirString;
-  if ( vtksys::SystemTools::FileIsDirectory ( dirName ) )
-    {
-    vtkDebugMacro("FindCachedFile: dirName is a directory: " << dirName);
-    vtksys::Directory dir;
-    dir.Load( dirName );
-    size_t fileNum;
-    cachesize += vtksys::SystemTools::FileLength (dirName );
-
-    //--- get files in cache dir and add to vector of strings.
-    for ( fileNum = 0; fileNum < dir.GetNumberOfFiles(); ++fileNum )
-      {
-      if (strcmp(dir.GetFile(static_cast<unsigned long>(fileNum)),".") &&
-          strcmp(dir.GetFile(static_cast<unsigned long>(fileNum)),".."))
-        {
-        //--- test to see if the file is a directory;
-        //--- if so, go inside and count up file sizes, return value
-        subdirString = dirName;
-        subdirString += "/";
-        subdirString += dir.GetFile  (static_cast<unsigned long>(fileNum));
-        if (vtksys::SystemTools::FileIsDirectory(subdirString.c_str()))
-          {
-          ///---compute dir and filename for recursive hunt
-          cachesize += (long unsigned int)ceil(this->ComputeCacheSize (subdirString.c_str(), 0));
-          }
-        else
-          {
-          longName = dirName;
-          longName += "/";
-          testFile = dir.GetFile (static_cast<unsigned long>(fileNum));
-          longName += testFile;
-          //--- get its size
-          cachesize += vtksys::SystemTools::FileLength (longName.c_str() );
-          }
-        }
-      }
-    }
-  else
+  if ( dirName == NULL || !vtksys::SystemTools::FileIsDirectory ( dirName ) )
     {
     vtkDebugMacro ( "vtkCacheManager::ComputeCacheSize: Cache Directory "
                     << this->GetRemoteCacheDirectory() <<
@@ -821,22 +870,61 @@ float vtkCacheManager::ComputeCacheSize( const char *dirName, unsigned long sz )
     return (-1);
     }
 
-  int byteSize = static_cast<int>(cachesize );
-  this->CurrentCacheSize =  (float)byteSize / MB;
+  vtkTypeInt64 cachesize = sz;
+  if ( this->IsCacheDirectory ( dirName ) )
+    {
+    cachesize += this->GetCacheSizeInBytes();
+    }
+  else
+    {
+    cachesize += this->ComputeDirectorySize ( dirName );
+    }
+  this->CurrentCacheSize = static_cast<float>(cachesize / MB);
   return (this->CurrentCacheSize);
 }
 
 //----------------------------------------------------------------------------
-void vtkCacheManager::CacheSizeCheck()
+vtkTypeInt64 vtkCacheManager::ComputeDirectorySize ( const char *dirName )
 {
+  vtkTypeInt64 size = 0;
+  vtksys::Directory dir;
+  dir.Load( dirName );
+  for ( unsigned long fileNum = 0; fileNum < dir.GetNumberOfFiles(); ++fileNum )
+    {
+    if (strcmp(dir.GetFile(fileNum),".") &&
+        strcmp(dir.GetFile(fileNum),".."))
+      {
+      std::string longName = dirName;
+      longName += "/";
+      longName += dir.GetFile(fileNum);
+      if (vtksys::SystemTools::FileIsDirectory(longName.c_str()))
+        {
+        size += this->ComputeDirectorySize ( longName.c_str() );
+        }
+      else
+        {
+        size += vtksys::SystemTools::FileLength ( longName.c_str() );
+        }
+      }
+    }
+  return size;
+}
 
-  //--- Compute size of the current cache
-  this->ComputeCacheSize(this->RemoteCacheDirectory.c_str(), 0);
-  //--- Invoke an event if cache size is exceeded.
-  if ( this->CurrentCacheSize > (float) (this->RemoteCacheLimit) )
+//----------------------------------------------------------------------------
+void vtkCacheManager::CacheSizeCheck()
+{
+  //--- Make room for the free buffer by removing the least recently used files
+  vtkTypeInt64 usableSize = static_cast<vtkTypeInt64>(
+    (this->RemoteCacheLimit - this->RemoteCacheFreeBufferSize) * MB );
+  if ( this->EnableAutomaticEviction &&
+       this->GetCacheSizeInBytes() > usableSize )
+    {
+    this->EvictLeastRecentlyUsedFiles ( usableSize > 0 ? usableSize : 0 );
+    }
+  //--- Invoke an event if cache size is still exceeded.
+  if ( this->GetCurrentCacheSize() > (float) (this->RemoteCacheLimit) )
     {
-    // remove the file just downloaded?
-     this->InvokeEvent ( vtkCacheManager::CacheLimitExceededEvent );
+    this->InvokeEvent ( vtkCacheManager::CacheLimitExceededEvent );
     }
 }
 
@@ -844,7 +932,7 @@ void vtkCacheManager::CacheSizeCheck()
 float vtkCacheManager::GetFreeCacheSpaceRemaining()
 {
 
-  float cachesize = this->ComputeCacheSize(this->RemoteCacheDirectory.c_str(), 0);
+  float cachesize = this->GetCurrentCacheSize();
   // cache limit - current cache size = total space left in cache.
   // total space in cache - free buffer size = amount that can be used.
   float diff = ( float (this->RemoteCacheLimit) - cachesize );
@@ -997,3 +1085,443 @@ const char* vtkCacheManager::FindCachedFile ( const char * target, const char *d
     }
 
 }
+
+//----------------------------------------------------------------------------
+const char* vtkCacheManager::GetCacheIndexFileName()
+{
+  return ".SlicerCacheIndex";
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkCacheManager::GetCacheSizeInBytes()
+{
+  this->CacheIndexLock->Lock();
+  vtkTypeInt64 size = this->CacheSizeInBytes;
+  this->CacheIndexLock->Unlock();
+  return size;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkCacheManager::GetRelativeCachePath ( const char *filename )
+{
+  //--- Returns the path of filename relative to the cache directory,
+  //--- or an empty string if the file is not in the cache directory.
+  if ( filename == NULL || this->RemoteCacheDirectory.empty() )
+    {
+    return std::string();
+    }
+  std::string cacheDirectory =
+    vtksys::SystemTools::CollapseFullPath ( this->RemoteCacheDirectory.c_str() );
+  std::string fullPath =
+    vtksys::SystemTools::CollapseFullPath ( filename, cacheDirectory.c_str() );
+  cacheDirectory += "/";
+  if ( fullPath.size() <= cacheDirectory.size() ||
+       fullPath.compare ( 0, cacheDirectory.size(), cacheDirectory ) != 0 )
+    {
+    return std::string();
+    }
+  return fullPath.substr ( cacheDirectory.size() );
+}
+
+//----------------------------------------------------------------------------
+bool vtkCacheManager::IsCacheDirectory ( const char *dirname )
+{
+  return !this->RemoteCacheDirectory.empty() &&
+    vtksys::SystemTools::CollapseFullPath ( dirname ) ==
+    vtksys::SystemTools::CollapseFullPath ( this->RemoteCacheDirectory.c_str() );
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::AddToCache ( const char *filename, const char *uri )
+{
+  std::string relativePath = this->GetRelativeCachePath ( filename );
+  if ( relativePath.empty() )
+    {
+    vtkDebugMacro ( "AddToCache: " << (filename ? filename : "(null)")
+                    << " is not in the cache directory." );
+    return;
+    }
+  std::string fullPath = this->RemoteCacheDirectory + "/" + relativePath;
+  if ( !vtksys::SystemTools::FileExists ( fullPath.c_str() ) ||
+       vtksys::SystemTools::FileIsDirectory ( fullPath.c_str() ) )
+    {
+    vtkDebugMacro ( "AddToCache: " << fullPath << " is not a file." );
+    return;
+    }
+
+  CacheEntry entry;
+  entry.Size = vtksys::SystemTools::FileLength ( fullPath.c_str() );
+  entry.LastAccess = vtkTimerLog::GetUniversalTime();
+  entry.URI = ( uri ? uri : "" );
+  if ( this->EnableDeduplication )
+    {
+    //--- hash outside of the lock, it reads the whole file.
+    entry.Hash = ComputeFileHash ( fullPath );
+    }
+
+  this->CacheIndexLock->Lock();
+  this->RemoveCacheEntry ( relativePath );
+  this->ShareCachedContent ( relativePath, entry );
+  this->InsertCacheEntry ( relativePath, entry );
+  this->CacheIndexLock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::ShareCachedContent ( const std::string& relativePath, CacheEntry& entry )
+{
+  //--- the caller holds the lock.
+  std::map<std::string, std::set<std::string> >::const_iterator content =
+    this->ContentIndex.find ( entry.Hash );
+  if ( entry.Hash.empty() || content == this->ContentIndex.end() )
+    {
+    return;
+    }
+  //--- the same content is already in cache, keep a single copy
+  //--- and link the file to it.
+  std::string fullPath = this->RemoteCacheDirectory + "/" + relativePath;
+  std::string existingPath = this->RemoteCacheDirectory + "/" + *content->second.begin();
+  //--- files linked before the index was rebuilt are already shared.
+  bool linked = vtksys::SystemTools::SameFile ( existingPath.c_str(), fullPath.c_str() );
+  if ( !linked &&
+       static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength ( existingPath.c_str() )) == entry.Size &&
+       vtksys::SystemTools::RemoveFile ( fullPath.c_str() ) )
+    {
+    linked = LinkCachedFile ( existingPath, fullPath );
+    if ( !linked )
+      {
+      vtksys::SystemTools::CopyFileAlways ( existingPath.c_str(), fullPath.c_str() );
+      }
+    }
+  if ( linked )
+    {
+    vtkDebugMacro ( "ShareCachedContent: " << fullPath << " is a duplicate of " << existingPath );
+    }
+  else
+    {
+    //--- not shared, the copy is accounted separately.
+    entry.Hash.clear();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::TouchCachedFile ( const char *filename )
+{
+  std::string relativePath = this->GetRelativeCachePath ( filename );
+  this->CacheIndexLock->Lock();
+  std::map<std::string, CacheEntry>::iterator it = this->CacheIndex.find ( relativePath );
+  if ( it != this->CacheIndex.end() )
+    {
+    this->AccessOrder.splice ( this->AccessOrder.end(), this->AccessOrder, it->second.AccessPosition );
+    it->second.LastAccess = vtkTimerLog::GetUniversalTime();
+    this->CacheIndexModified = true;
+    }
+  this->CacheIndexLock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+int vtkCacheManager::EvictLeastRecentlyUsedFiles ( vtkTypeInt64 sizeInBytes )
+{
+  int numberOfEvictedFiles = 0;
+  this->CacheIndexLock->Lock();
+  //--- files that can't be removed go to the back of the list,
+  //--- try each file at most once.
+  size_t numberOfCandidates = this->AccessOrder.size();
+  while ( numberOfCandidates-- > 0 && this->CacheSizeInBytes > sizeInBytes )
+    {
+    std::string relativePath = this->AccessOrder.front();
+    std::string fullPath = this->RemoteCacheDirectory + "/" + relativePath;
+    this->CacheIndexLock->Unlock();
+
+    vtkDebugMacro ( "EvictLeastRecentlyUsedFiles: removing " << fullPath );
+    this->MarkNodesBeforeDeletingDataFromCache ( fullPath.c_str() );
+    bool removed = !vtksys::SystemTools::FileExists ( fullPath.c_str() ) ||
+      vtksys::SystemTools::RemoveFile ( fullPath.c_str() );
+
+    this->CacheIndexLock->Lock();
+    std::map<std::string, CacheEntry>::iterator it = this->CacheIndex.find ( relativePath );
+    if ( removed )
+      {
+      this->RemoveCacheEntry ( relativePath );
+      ++numberOfEvictedFiles;
+      }
+    else if ( it != this->CacheIndex.end() )
+      {
+      vtkWarningMacro ( "Unable to remove cached file " << fullPath << " from disk." );
+      this->AccessOrder.splice ( this->AccessOrder.end(), this->AccessOrder, it->second.AccessPosition );
+      }
+    }
+  this->CacheIndexLock->Unlock();
+
+  if ( numberOfEvictedFiles > 0 )
+    {
+    this->UpdateCacheInformation();
+    this->InvokeEvent ( vtkCacheManager::CacheDeleteEvent );
+    }
+  return numberOfEvictedFiles;
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::InsertCacheEntry ( const std::string& relativePath, CacheEntry entry )
+{
+  //--- the caller holds the lock.
+  entry.AccessPosition = this->AccessOrder.insert ( this->AccessOrder.end(), relativePath );
+  if ( entry.Hash.empty() )
+    {
+    this->CacheSizeInBytes += entry.Size;
+    }
+  else
+    {
+    std::set<std::string>& paths = this->ContentIndex[entry.Hash];
+    if ( paths.empty() )
+      {
+      this->CacheSizeInBytes += entry.Size;
+      }
+    paths.insert ( relativePath );
+    }
+  this->CacheIndex[relativePath] = entry;
+  this->CacheIndexModified = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::RemoveCacheEntry ( const std::string& relativePath )
+{
+  //--- the caller holds the lock.
+  std::map<std::string, CacheEntry>::iterator it = this->CacheIndex.find ( relativePath );
+  if ( it == this->CacheIndex.end() )
+    {
+    return;
+    }
+  const CacheEntry& entry = it->second;
+  this->AccessOrder.erase ( entry.AccessPosition );
+  if ( entry.Hash.empty() )
+    {
+    this->CacheSizeInBytes -= entry.Size;
+    }
+  else
+    {
+    std::set<std::string>& paths = this->ContentIndex[entry.Hash];
+    paths.erase ( relativePath );
+    if ( paths.empty() )
+      {
+      this->CacheSizeInBytes -= entry.Size;
+      this->ContentIndex.erase ( entry.Hash );
+      }
+    }
+  this->CacheIndex.erase ( it );
+  this->CacheIndexModified = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::RemoveCacheEntries ( const std::string& relativePath )
+{
+  //--- removes the entries of the files in a directory, the caller holds the lock.
+  std::string prefix = relativePath + "/";
+  std::vector<std::string> paths;
+  for ( std::map<std::string, CacheEntry>::const_iterator it = this->CacheIndex.lower_bound ( prefix );
+        it != this->CacheIndex.end() && it->first.compare ( 0, prefix.size(), prefix ) == 0; ++it )
+    {
+    paths.push_back ( it->first );
+    }
+  for ( size_t i = 0; i < paths.size(); ++i )
+    {
+    this->RemoveCacheEntry ( paths[i] );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::ClearCacheIndex ( )
+{
+  //--- the caller holds the lock.
+  this->CacheIndex.clear();
+  this->AccessOrder.clear();
+  this->ContentIndex.clear();
+  this->CacheSizeInBytes = 0;
+  this->CacheIndexModified = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::RebuildCacheIndex ( )
+{
+  typedef std::multimap<double, std::pair<std::string, CacheEntry> > EntryMap;
+  EntryMap entries;
+  if ( vtksys::SystemTools::FileIsDirectory ( this->RemoteCacheDirectory.c_str() ) )
+    {
+    this->ScanCacheDirectory ( this->RemoteCacheDirectory, std::string(), entries );
+    }
+
+  //--- keep what the current index knows about the files: their URI and
+  //--- their hash, unless the file changed.
+  std::map<vtkTypeInt64, int> numberOfFilesBySize;
+  this->CacheIndexLock->Lock();
+  for ( EntryMap::iterator it = entries.begin(); it != entries.end(); ++it )
+    {
+    CacheEntry& entry = it->second.second;
+    std::map<std::string, CacheEntry>::const_iterator indexed =
+      this->CacheIndex.find ( it->second.first );
+    if ( indexed != this->CacheIndex.end() && indexed->second.Size == entry.Size )
+      {
+      entry.URI = indexed->second.URI;
+      entry.Hash = indexed->second.Hash;
+      }
+    ++numberOfFilesBySize[entry.Size];
+    }
+  this->CacheIndexLock->Unlock();
+
+  if ( this->EnableDeduplication )
+    {
+    //--- only files of the same size can have the same content, hash them
+    //--- (outside of the lock) so that duplicates are linked and counted once.
+    for ( EntryMap::iterator it = entries.begin(); it != entries.end(); ++it )
+      {
+      CacheEntry& entry = it->second.second;
+      if ( entry.Hash.empty() && entry.Size > 0 && numberOfFilesBySize[entry.Size] > 1 )
+        {
+        entry.Hash = ComputeFileHash ( this->RemoteCacheDirectory + "/" + it->second.first );
+        }
+      }
+    }
+
+  this->CacheIndexLock->Lock();
+  this->ClearCacheIndex();
+  //--- the modification time stands for the last access.
+  for ( EntryMap::iterator it = entries.begin(); it != entries.end(); ++it )
+    {
+    this->ShareCachedContent ( it->second.first, it->second.second );
+    this->InsertCacheEntry ( it->second.first, it->second.second );
+    }
+  this->CacheIndexModified = true;
+  this->CacheIndexLock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::ScanCacheDirectory ( const std::string& dirname, const std::string& relativeDirectory,
+                                           std::multimap<double, std::pair<std::string, CacheEntry> >& entries )
+{
+  vtksys::Directory dir;
+  dir.Load ( dirname.c_str() );
+  for ( unsigned long fileNum = 0; fileNum < dir.GetNumberOfFiles(); ++fileNum )
+    {
+    std::string name = dir.GetFile ( fileNum );
+    if ( name == "." || name == ".." ||
+         ( relativeDirectory.empty() && name == vtkCacheManager::GetCacheIndexFileName() ) )
+      {
+      continue;
+      }
+    std::string fullName = dirname + "/" + name;
+    std::string relativePath = relativeDirectory.empty() ? name : relativeDirectory + "/" + name;
+    if ( vtksys::SystemTools::FileIsDirectory ( fullName.c_str() ) )
+      {
+      this->ScanCacheDirectory ( fullName, relativePath, entries );
+      }
+    else
+      {
+      CacheEntry entry;
+      entry.Size = vtksys::SystemTools::FileLength ( fullName.c_str() );
+      entry.LastAccess = static_cast<double>(vtksys::SystemTools::ModifiedTime ( fullName.c_str() ));
+      entries.insert ( std::make_pair ( entry.LastAccess, std::make_pair ( relativePath, entry ) ) );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkCacheManager::LoadCacheIndex ( )
+{
+  //--- Each line of the index is:
+  //--- size <tab> last access <tab> hash <tab> uri <tab> relative path
+  std::string indexFileName = this->RemoteCacheDirectory + "/" + vtkCacheManager::GetCacheIndexFileName();
+  std::ifstream input ( indexFileName.c_str() );
+  if ( !input )
+    {
+    return false;
+    }
+  std::multimap<double, std::pair<std::string, CacheEntry> > entries;
+  bool missingFiles = false;
+  std::string line;
+  while ( std::getline ( input, line ) )
+    {
+    if ( line.empty() || line[0] == '#' )
+      {
+      continue;
+      }
+    std::vector<std::string> fields;
+    std::string::size_type start = 0;
+    for ( int field = 0; field < 4; ++field )
+      {
+      std::string::size_type end = line.find ( '\t', start );
+      if ( end == std::string::npos )
+        {
+        break;
+        }
+      fields.push_back ( line.substr ( start, end - start ) );
+      start = end + 1;
+      }
+    if ( fields.size() != 4 )
+      {
+      vtkWarningMacro ( "LoadCacheIndex: ignoring invalid line in " << indexFileName << ": " << line );
+      continue;
+      }
+    std::string relativePath = line.substr ( start );
+    std::string fullPath = this->RemoteCacheDirectory + "/" + relativePath;
+    if ( !vtksys::SystemTools::FileExists ( fullPath.c_str() ) )
+      {
+      missingFiles = true;
+      continue;
+      }
+    CacheEntry entry;
+    std::istringstream ( fields[0] ) >> entry.Size;
+    std::istringstream ( fields[1] ) >> entry.LastAccess;
+    entry.Hash = fields[2];
+    entry.URI = fields[3];
+    entries.insert ( std::make_pair ( entry.LastAccess, std::make_pair ( relativePath, entry ) ) );
+    }
+
+  this->CacheIndexLock->Lock();
+  this->ClearCacheIndex();
+  for ( std::multimap<double, std::pair<std::string, CacheEntry> >::const_iterator it = entries.begin();
+        it != entries.end(); ++it )
+    {
+    this->InsertCacheEntry ( it->second.first, it->second.second );
+    }
+  //--- save it again without the files removed behind our back.
+  this->CacheIndexModified = missingFiles;
+  this->CacheIndexLock->Unlock();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::SaveCacheIndex ( )
+{
+  //--- the caller holds the lock.
+  if ( this->RemoteCacheDirectory.empty() )
+    {
+    return;
+    }
+  std::string indexFileName = this->RemoteCacheDirectory + "/" + vtkCacheManager::GetCacheIndexFileName();
+  if ( this->CacheIndex.empty() )
+    {
+    //--- an empty cache has no index, ClearCacheCheck expects no file.
+    if ( vtksys::SystemTools::FileExists ( indexFileName.c_str() ) )
+      {
+      vtksys::SystemTools::RemoveFile ( indexFileName.c_str() );
+      }
+    this->CacheIndexModified = false;
+    return;
+    }
+  std::ofstream output ( indexFileName.c_str() );
+  if ( !output )
+    {
+    vtkWarningMacro ( "SaveCacheIndex: unable to write " << indexFileName );
+    return;
+    }
+  output << "# size\tlast access\thash\turi\tpath\n";
+  output.setf ( std::ios::fixed );
+  output.precision ( 3 );
+  for ( std::list<std::string>::const_iterator it = this->AccessOrder.begin();
+        it != this->AccessOrder.end(); ++it )
+    {
+    const CacheEntry& entry = this->CacheIndex[*it];
+    output << entry.Size << "\t" << entry.LastAccess << "\t" << entry.Hash << "\t"
+           << entry.URI << "\t" << *it << "\n";
+    }
+  this->CacheIndexModified = false;
+}
@@ -4,15 +4,18 @@
 // MRML includes
 #include "vtkMRML.h"
 class vtkCallbackCommand;
+class vtkCriticalSection;
 class vtkMRMLScene;
 
 // VTK includes
 #include <vtkObject.h>
 
 // STD includes
+#include <list>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
-#include <map>
 
 #ifndef vtkObjectPointer
 #define vtkObjectPointer(xx) (reinterpret_cast <vtkObject **>( (xx) ))
@@ -108,12 +111,59 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   const char* AddCachePathToFilename ( const char *filename );
   const char* EncodeURI ( const char *uri );
 
+  ///
+  /// Checks the size of the cache against the RemoteCacheLimit.
+  /// If EnableAutomaticEviction is set and the free buffer is used,
+  /// least recently used files are removed until the free buffer is
+  /// available again. CacheLimitExceededEvent is invoked if the cache
+  /// is still larger than the limit.
   void CacheSizeCheck();
   void FreeCacheBufferCheck();
+  ///
+  /// Returns the size in MB of the files in dirname plus size bytes.
+  /// The size of the cache directory is read from the cache index,
+  /// other directories are traversed.
   float ComputeCacheSize( const char *dirname, unsigned long size );
   float GetCurrentCacheSize();
   float GetFreeCacheSpaceRemaining();
 
+  ///
+  /// Size in bytes of the files in cache, as recorded in the cache index.
+  /// Content shared by deduplicated files is counted once.
+  vtkTypeInt64 GetCacheSizeInBytes();
+
+  ///
+  /// Records a file downloaded in the cache directory into the cache index,
+  /// with the URI it was downloaded from, as the most recently used file.
+  /// If EnableDeduplication is set and a cached file has the same content,
+  /// the new file is replaced by a hard link to it.
+  /// Can be called from the thread that downloaded the file.
+  void AddToCache ( const char *filename, const char *uri );
+
+  ///
+  /// Marks a cached file as the most recently used one, it is then the
+  /// last candidate for eviction.
+  void TouchCachedFile ( const char *filename );
+
+  ///
+  /// Removes least recently used files from cache until the cache size
+  /// is at most sizeInBytes. The nodes that reference the removed files
+  /// are marked as modified. Returns the number of removed files.
+  int EvictLeastRecentlyUsedFiles ( vtkTypeInt64 sizeInBytes );
+
+  ///
+  /// Discards the cache index and rebuilds it by scanning the cache
+  /// directory. Called when the cache directory has no index yet.
+  /// The URIs and hashes of the files already indexed are kept. If
+  /// EnableDeduplication is set, the files that have the same size as
+  /// another file are hashed, and files with the same content are linked
+  /// and counted once, as in AddToCache.
+  void RebuildCacheIndex ( );
+
+  ///
+  /// Name of the file, in the cache directory, that holds the cache index.
+  static const char* GetCacheIndexFileName();
+
   std::vector< std::string > GetCachedFiles()const;
 
   ///
@@ -124,6 +174,14 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   vtkSetMacro ( RemoteCacheFreeBufferSize, int );
   vtkGetMacro ( EnableForceRedownload, int );
   vtkSetMacro ( EnableForceRedownload, int );
+  /// Remove least recently used files when the cache gets full. On by default.
+  vtkGetMacro ( EnableAutomaticEviction, int );
+  vtkSetMacro ( EnableAutomaticEviction, int );
+  vtkBooleanMacro ( EnableAutomaticEviction, int );
+  /// Store identical files only once. On by default.
+  vtkGetMacro ( EnableDeduplication, int );
+  vtkSetMacro ( EnableDeduplication, int );
+  vtkBooleanMacro ( EnableDeduplication, int );
   //vtkGetMacro ( EnableRemoteCacheOverwriting, int );
   //vtkSetMacro ( EnableRemoteCacheOverwriting, int );
   void SetMRMLScene ( vtkMRMLScene *scene )
@@ -160,6 +218,8 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   float CurrentCacheSize;
   int RemoteCacheFreeBufferSize;
   int EnableForceRedownload;
+  int EnableAutomaticEviction;
+  int EnableDeduplication;
   //int EnableRemoteCacheOverwriting;
   vtkMRMLScene *MRMLScene;
 
@@ -172,6 +232,43 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   /// with every download, remove from cache, and clearcache call.
   std::vector< std::string > CachedFileList;
 
+  /// Record of a file in the cache index.
+  struct CacheEntry
+    {
+    vtkTypeInt64 Size;
+    /// Time of the last access, in seconds since the epoch.
+    double LastAccess;
+    std::string URI;
+    /// MD5 of the file content, empty if not computed.
+    std::string Hash;
+    std::list<std::string>::iterator AccessPosition;
+    };
+  /// Cached files indexed by path relative to the cache directory.
+  std::map<std::string, CacheEntry> CacheIndex;
+  /// Relative paths of the cached files, least recently used first.
+  std::list<std::string> AccessOrder;
+  /// Relative paths of the cached files sharing a content hash.
+  std::map<std::string, std::set<std::string> > ContentIndex;
+  vtkTypeInt64 CacheSizeInBytes;
+  bool CacheIndexModified;
+  /// Guards the cache index, files are added from download threads.
+  vtkCriticalSection *CacheIndexLock;
+
+  std::string GetRelativeCachePath ( const char *filename );
+  bool IsCacheDirectory ( const char *dirname );
+  vtkTypeInt64 ComputeDirectorySize ( const char *dirname );
+  void ScanCacheDirectory ( const std::string& dirname, const std::string& relativeDirectory,
+                            std::multimap<double, std::pair<std::string, CacheEntry> >& entries );
+  bool LoadCacheIndex ( );
+  void SaveCacheIndex ( );
+  void ClearCacheIndex ( );
+  void InsertCacheEntry ( const std::string& relativePath, CacheEntry entry );
+  /// Replace the file by a link to a cached file with the same hash, if
+  /// any. The hash of the entry is cleared if the file can't be linked.
+  void ShareCachedContent ( const std::string& relativePath, CacheEntry& entry );
+  void RemoveCacheEntry ( const std::string& relativePath );
+  void RemoveCacheEntries ( const std::string& relativePath );
+
  protected:
   vtkCacheManager();
   virtual ~vtkCacheManager();
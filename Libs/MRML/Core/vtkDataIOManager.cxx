@@ -383,6 +383,11 @@ void vtkDataIOManager::QueueRead ( vtkMRMLNode *node )
       this->GetCacheManager()->DeleteFromCache ( dest );
       }
 
+    //--- the requested file is the most recently used one, then
+    //--- least recently used files are evicted to free the buffer.
+    cm->TouchCachedFile ( dest );
+    cm->CacheSizeCheck();
+
     //---
     //--- WJPtest
     //--- Test for space to download the file. If no space,
@@ -22,6 +22,10 @@
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <algorithm>
+#include <cstring>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
 //----------------------------------------------------------------------------
@@ -99,6 +103,9 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
+  this->NumberOfObservations = 0;
+  this->NumberOfQueuedObservations = 0;
+  this->DispatchStatistics = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -106,6 +113,10 @@ vtkEventBroker::~vtkEventBroker()
 {
   /// fast and dangerous but ok because we are in the destructor.
   this->DetachObservations();
+  while (!this->EventQueue.empty())
+    {
+    this->PopEventQueue();
+    }
 
   // close the event log if needed
   if ( this->LogFile.is_open() )
@@ -141,6 +152,57 @@ void vtkEventBroker::DetachObservations()
       }
     }
   this->SubjectMap.clear();
+  this->ObserverMap.clear();
+  this->SubjectEventMap.clear();
+  this->NumberOfObservations = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::IndexObservation (vtkObservation *observation)
+{
+  this->SubjectMap[observation->GetSubject()].insert( observation );
+  if ( observation->GetObserver() )
+    {
+    this->ObserverMap[observation->GetObserver()].insert( observation );
+    }
+  this->SubjectEventMap[SubjectEventType(observation->GetSubject(), observation->GetEvent())].insert( observation );
+  ++this->NumberOfObservations;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::UnindexObservation (vtkObservation *observation)
+{
+  // Empty sets are erased so that the maps don't grow with the
+  // subjects and observers that have been deleted.
+  ObjectToObservationVectorMap::iterator subjectIt = this->SubjectMap.find(observation->GetSubject());
+  if ( subjectIt != this->SubjectMap.end() &&
+       subjectIt->second.erase(observation) )
+    {
+    --this->NumberOfObservations;
+    if ( subjectIt->second.empty() )
+      {
+      this->SubjectMap.erase(subjectIt);
+      }
+    }
+  ObjectToObservationVectorMap::iterator observerIt = this->ObserverMap.find(observation->GetObserver());
+  if ( observerIt != this->ObserverMap.end() )
+    {
+    observerIt->second.erase(observation);
+    if ( observerIt->second.empty() )
+      {
+      this->ObserverMap.erase(observerIt);
+      }
+    }
+  SubjectEventToObservationVectorMap::iterator subjectEventIt = this->SubjectEventMap.find(
+    SubjectEventType(observation->GetSubject(), observation->GetEvent()));
+  if ( subjectEventIt != this->SubjectEventMap.end() )
+    {
+    subjectEventIt->second.erase(observation);
+    if ( subjectEventIt->second.empty() )
+      {
+      this->SubjectEventMap.erase(subjectEventIt);
+      }
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -151,13 +213,12 @@ vtkObservation *vtkEventBroker::AddObservation (
 
   vtkObservation *observation = vtkObservation::New();
   observation->SetEventBroker( this );
-  this->SubjectMap[subject].insert( observation );
-  this->ObserverMap[observer].insert( observation );
   observation->AssignSubject( subject );
   observation->SetEvent( event );
   observation->AssignObserver( observer );
   observation->SetCallbackCommand( notify );
   observation->SetPriority( priority );
+  this->IndexObservation( observation );
 
   this->AttachObservation( observation );
 
@@ -182,7 +243,6 @@ vtkObservation *vtkEventBroker::AddObservation (
 {
   vtkObservation *observation = vtkObservation::New();
   observation->SetEventBroker( this );
-  this->SubjectMap[subject].insert( observation );
   observation->AssignSubject( subject );
 
   // figure out event either as a predefined string, or
@@ -194,6 +254,7 @@ vtkObservation *vtkEventBroker::AddObservation (
     }
   observation->SetEvent( eventID );
   observation->SetScript( script );
+  this->IndexObservation( observation );
 
   this->AttachObservation( observation );
 
@@ -282,50 +343,21 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
 {
   // remove passed observations from:
   // - broker's observation maps
-  // -- remove each from list of observations per subject
-  // -- remove each from list of observations per obserer
-  // - current event queue
+  // - current event queue (flagged as removed, the queue releases them later)
   // - detach from subject (and observer)
   // - delete the observation
 
-  ObservationVector::iterator inObsIter;
-
-  for(inObsIter=observations.begin(); inObsIter != observations.end(); inObsIter++)
-    {
-    vtkObservation *inObs = (*inObsIter);
-    ObservationVector& subjectObservations = this->SubjectMap[(*inObsIter)->GetSubject()];
-    subjectObservations.erase(subjectObservations.find(inObs));
-    }
-
-  for(inObsIter=observations.begin(); inObsIter != observations.end(); inObsIter++)
-    {
-    vtkObservation *inObs = (*inObsIter);
-    ObservationVector& observerObservations = this->ObserverMap[inObs->GetObserver()];
-    observerObservations.erase(observerObservations.find(inObs));
-    }
-
-  // remove from event queue
-  std::deque< vtkObservation *>::iterator queueIter;
-  for(queueIter=this->EventQueue.begin(); queueIter != this->EventQueue.end();)
+  for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
     {
-    // foreach of the broker's observations see if it is in the list of items to be removed
-    if (observations.find(*queueIter)!=observations.end())
-      {
-      // these event is related to the observations to be deleted
-      queueIter=this->EventQueue.erase(queueIter);
-      }
-    else
+    vtkObservation *observation = (*removeIter);
+    this->UnindexObservation( observation );
+    if ( observation->GetInEventQueue() )
       {
-      ++queueIter;
+      observation->SetInEventQueue( 0 );
+      --this->NumberOfQueuedObservations;
       }
-    }
-
-  // detach and delete each of the observations
-  for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
-    {
-    (*removeIter)->SetInEventQueue( 0 );
-    this->DetachObservation( *removeIter );
-    (*removeIter)->Delete();
+    this->DetachObservation( observation );
+    observation->Delete();
     }
 }
 
@@ -364,9 +396,12 @@ vtkEventBroker::ObservationVector vtkEventBroker
 ::GetSubjectObservations (vtkObject *observer)
 {
   // find matching observations to remove
-  ObservationVector observationList = this->ObserverMap[observer];
-
-  return( observationList );
+  ObjectToObservationVectorMap::iterator it = this->ObserverMap.find(observer);
+  if ( it == this->ObserverMap.end() )
+    {
+    return ObservationVector();
+    }
+  return( it->second );
 }
 
 //----------------------------------------------------------------------------
@@ -381,15 +416,48 @@ vtkEventBroker::ObservationVector vtkEventBroker::GetObservations (
     observationList = this->GetSubjectObservations(subject);
     return observationList;
     }
-  // find matching observations to remove
-  ObservationVector& subjectList = this->SubjectMap[subject];
+  // Only go through the smallest list of candidates: the observations of
+  // the subject for the event, or the observations of the subject or of
+  // the observer.
+  const ObservationVector* candidates = 0;
+  if (event != 0)
+    {
+    SubjectEventToObservationVectorMap::iterator it =
+      this->SubjectEventMap.find(SubjectEventType(subject, event));
+    if (it == this->SubjectEventMap.end())
+      {
+      return observationList;
+      }
+    candidates = &it->second;
+    }
+  else
+    {
+    ObjectToObservationVectorMap::iterator it = this->SubjectMap.find(subject);
+    if (it == this->SubjectMap.end())
+      {
+      return observationList;
+      }
+    candidates = &it->second;
+    }
+  if (observer != 0)
+    {
+    ObjectToObservationVectorMap::iterator it = this->ObserverMap.find(observer);
+    if (it == this->ObserverMap.end())
+      {
+      return observationList;
+      }
+    if (it->second.size() < candidates->size())
+      {
+      candidates = &it->second;
+      }
+    }
 
-  for(ObservationVector::iterator obsIter = subjectList.begin();
-      obsIter != subjectList.end();
+  for(ObservationVector::const_iterator obsIter = candidates->begin();
+      obsIter != candidates->end();
       ++obsIter)
     {
     if ( (observer == 0 || (*obsIter)->GetObserver() == observer) &&
-         //(subject == 0 || (*obsIter)->GetSubject() == subject) &&
+         (*obsIter)->GetSubject() == subject &&
          (event == 0 || (*obsIter)->GetEvent() == event) &&
          (notify == 0 || (*obsIter)->GetCallbackCommand() == notify))
       {
@@ -419,14 +487,22 @@ vtkEventBroker::ObservationVector vtkEventBroker::GetObservationsForSubjectByTag
 {
   // find matching observations to remove
   // - all tags match 0
-  ObservationVector& subjectList = this->SubjectMap[subject];
   ObservationVector observationList;
+  ObjectToObservationVectorMap::iterator it = this->SubjectMap.find(subject);
+  if ( it == this->SubjectMap.end() )
+    {
+    return observationList;
+    }
+  if ( tag == 0 )
+    {
+    return it->second;
+    }
+  ObservationVector& subjectList = it->second;
   for (ObservationVector::iterator obsIter = subjectList.begin();
        obsIter != subjectList.end(); obsIter++)
     {
     vtkObservation *obs = *obsIter;
-    if ( ( obs->GetSubject() == subject ) &&
-         ( (tag == 0) || (obs->GetEventTag() == tag) ) )
+    if ( obs->GetEventTag() == tag )
       {
       observationList.insert( obs );
       }
@@ -438,14 +514,15 @@ vtkEventBroker::ObservationVector vtkEventBroker::GetObservationsForSubjectByTag
 vtkCollection *vtkEventBroker::GetObservationsForSubject ( vtkObject *subject )
 {
   vtkCollection *collection = vtkCollection::New();
-  ObservationVector& subjectList = this->SubjectMap[subject];
-  for(ObservationVector::iterator iter=subjectList.begin();
-      iter != subjectList.end(); iter++)
+  ObjectToObservationVectorMap::iterator it = this->SubjectMap.find(subject);
+  if ( it == this->SubjectMap.end() )
     {
-    if ( (*iter)->GetSubject() == subject )
-      {
-      collection->AddItem( *iter );
-      }
+    return collection;
+    }
+  for(ObservationVector::iterator iter=it->second.begin();
+      iter != it->second.end(); iter++)
+    {
+    collection->AddItem( *iter );
     }
   return collection;
 }
@@ -454,14 +531,15 @@ vtkCollection *vtkEventBroker::GetObservationsForSubject ( vtkObject *subject )
 vtkCollection *vtkEventBroker::GetObservationsForObserver ( vtkObject *observer )
 {
   vtkCollection *collection = vtkCollection::New();
-  ObservationVector& observerList = this->ObserverMap[observer];
-  for (ObservationVector::iterator iter = observerList.begin();
-       iter != observerList.end(); iter++)
+  ObjectToObservationVectorMap::iterator it = this->ObserverMap.find(observer);
+  if ( it == this->ObserverMap.end() )
     {
-    if ( (*iter)->GetObserver() == observer )
-      {
-      collection->AddItem( *iter );
-      }
+    return collection;
+    }
+  for (ObservationVector::iterator iter = it->second.begin();
+       iter != it->second.end(); iter++)
+    {
+    collection->AddItem( *iter );
     }
   return collection;
 }
@@ -488,13 +566,7 @@ vtkCollection *vtkEventBroker::GetObservationsForCallback ( vtkCallbackCommand *
 //----------------------------------------------------------------------------
 int vtkEventBroker::GetNumberOfObservations ( )
 {
-  size_t count = 0;
-  ObjectToObservationVectorMap::iterator iter;
-  for(iter=this->SubjectMap.begin(); iter != this->SubjectMap.end(); iter++)
-    {
-    count += iter->second.size();
-    }
-  return static_cast<int>(count);
+  return this->NumberOfObservations;
 }
 
 //----------------------------------------------------------------------------
@@ -707,11 +779,12 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
   if ( eid == vtkCommand::DeleteEvent )
     {
     // iterate list of observations for the deleted object (caller) as subject
-    ObservationVector::iterator obsIter;
-    ObservationVector& subjectList = this->SubjectMap[caller];
-    for(obsIter=subjectList.begin(); obsIter != subjectList.end(); ++obsIter)
+    SubjectEventToObservationVectorMap::iterator deleteObservationsIt =
+      this->SubjectEventMap.find(SubjectEventType(caller, vtkCommand::DeleteEvent));
+    if ( deleteObservationsIt != this->SubjectEventMap.end() )
       {
-      if ( (*obsIter)->GetEvent() == vtkCommand::DeleteEvent )
+      size_t numberOfDeleteObservations = deleteObservationsIt->second.size();
+      for (size_t i = 0; i < numberOfDeleteObservations; ++i)
         {
         this->InvokeObservation( observation, eid, callData );
         }
@@ -777,15 +850,19 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
 
   if ( !observation->GetInEventQueue() )
     {
+    // the queue keeps the observation alive until it is popped, even if it
+    // gets removed from the broker in the meantime.
+    observation->Register( this );
     this->EventQueue.push_back( observation );
     observation->SetInEventQueue(1);
+    ++this->NumberOfQueuedObservations;
     }
 }
 
 //----------------------------------------------------------------------------
 int vtkEventBroker::GetNumberOfQueuedObservations ()
 {
-  return static_cast<int>( this->EventQueue.size() );
+  return this->NumberOfQueuedObservations;
 }
 
 //----------------------------------------------------------------------------
@@ -795,15 +872,46 @@ vtkObservation *vtkEventBroker::GetNthQueuedObservation ( int n )
     {
     return NULL;
     }
-  return (this->EventQueue[n]);
+  // skip the removed observations
+  std::deque< vtkObservation * >::iterator it;
+  for ( it = this->EventQueue.begin(); it != this->EventQueue.end(); ++it )
+    {
+    if ( (*it)->GetInEventQueue() && n-- == 0 )
+      {
+      return (*it);
+      }
+    }
+  return NULL;
 }
 
 //----------------------------------------------------------------------------
-vtkObservation *vtkEventBroker::DequeueObservation ()
+void vtkEventBroker::PopEventQueue ()
 {
   vtkObservation *observation = this->EventQueue.front();
   this->EventQueue.pop_front();
-  observation->SetInEventQueue(0);
+  if ( observation->GetInEventQueue() )
+    {
+    observation->SetInEventQueue(0);
+    --this->NumberOfQueuedObservations;
+    }
+  observation->UnRegister( this );
+}
+
+//----------------------------------------------------------------------------
+vtkObservation *vtkEventBroker::DequeueObservation ()
+{
+  // discard the observations that have been removed from the broker
+  while ( !this->EventQueue.empty() && !this->EventQueue.front()->GetInEventQueue() )
+    {
+    this->PopEventQueue();
+    }
+  if ( this->EventQueue.empty() )
+    {
+    return NULL;
+    }
+  // the broker still references the observation, it is not deleted here
+  vtkObservation *observation = this->EventQueue.front();
+  this->PopEventQueue();
   return( observation );
 }
 
@@ -813,7 +921,9 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
 {
   this->EventNestingLevel++;
 
-  double startTime = this->TimerLog->GetUniversalTime();
+  // Only query the time if it is reported
+  bool timed = this->DispatchStatistics || this->EventLogging;
+  double startTime = timed ? this->TimerLog->GetUniversalTime() : 0.;
 
   // Register so observation won't be deleted while callback is running
   observation->Register(this);
@@ -839,10 +949,20 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
     }
 
   // Record timing and write the to the log file if enabled
-  double elapsedTime = this->TimerLog->GetUniversalTime() - startTime;
-  observation->SetTotalElapsedTime (observation->GetTotalElapsedTime() + elapsedTime);
-  observation->SetLastElapsedTime (elapsedTime);
-  this->LogEvent (observation);
+  if ( timed )
+    {
+    double elapsedTime = this->TimerLog->GetUniversalTime() - startTime;
+    observation->SetTotalElapsedTime (observation->GetTotalElapsedTime() + elapsedTime);
+    observation->SetLastElapsedTime (elapsedTime);
+    if ( this->DispatchStatistics )
+      {
+      DispatchStatisticsType& statistics = this->DispatchStatisticsMap[eid];
+      ++statistics.NumberOfDispatches;
+      statistics.TotalTime += elapsedTime;
+      statistics.MaximumTime = std::max(statistics.MaximumTime, elapsedTime);
+      }
+    this->LogEvent (observation);
+    }
 
   // clear reference to observation (may cause delete)
   observation->Delete();
@@ -857,29 +977,26 @@ void vtkEventBroker::ProcessEventQueue ()
   // invoke it with each of the stored callData pointers
   // - register your pointer to the observation in case it
   //   gets deleted during handling of the event
-  // - if the observation is no longer in the queue, stop processing events
-  // - unregister before after dequeing in case the observation should go away
+  // - if the observation is no longer in the queue (it has been removed
+  //   from the broker), stop processing its events
   //
-  while ( this->GetNumberOfQueuedObservations() > 0 )
+  while ( !this->EventQueue.empty() )
     {
     vtkObservation *observation = this->EventQueue.front();
     observation->Register( this );
-    int finished = 0;
-    while ( !finished )
+    while ( observation->GetInEventQueue() &&
+            !observation->GetCallDataList()->empty() )
       {
       vtkObservation::CallType call = observation->GetCallDataList()->front();
       observation->GetCallDataList()->pop_front();
-      finished = (observation->GetCallDataList()->size() == 0);
       this->InvokeObservation( observation, call.EventID, call.CallData );
-      if ( !observation->GetInEventQueue() )
-        {
-        observation->GetCallDataList()->clear();
-        finished = 1;
-        break;
-        }
       }
-    this->DequeueObservation();
-    observation->Delete();
+    observation->GetCallDataList()->clear();
+    if ( !this->EventQueue.empty() && this->EventQueue.front() == observation )
+      {
+      this->PopEventQueue();
+      }
+    observation->UnRegister( this );
     }
 }
 
@@ -895,6 +1012,62 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
+  os << indent << "DispatchStatistics: " << this->DispatchStatistics << "\n";
+  if ( this->DispatchStatistics )
+    {
+    this->PrintDispatchStatistics(os);
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkEventBroker::GetNumberOfDispatches(unsigned long event)
+{
+  std::map< unsigned long, DispatchStatisticsType >::iterator it =
+    this->DispatchStatisticsMap.find(event);
+  return it != this->DispatchStatisticsMap.end() ? it->second.NumberOfDispatches : 0;
+}
+
+//----------------------------------------------------------------------------
+double vtkEventBroker::GetTotalDispatchTime(unsigned long event)
+{
+  std::map< unsigned long, DispatchStatisticsType >::iterator it =
+    this->DispatchStatisticsMap.find(event);
+  return it != this->DispatchStatisticsMap.end() ? it->second.TotalTime : 0.;
+}
+
+//----------------------------------------------------------------------------
+double vtkEventBroker::GetMaximumDispatchTime(unsigned long event)
+{
+  std::map< unsigned long, DispatchStatisticsType >::iterator it =
+    this->DispatchStatisticsMap.find(event);
+  return it != this->DispatchStatisticsMap.end() ? it->second.MaximumTime : 0.;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetDispatchStatistics()
+{
+  this->DispatchStatisticsMap.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintDispatchStatistics(ostream& os)
+{
+  std::vector< std::pair<double, unsigned long> > events;
+  std::map< unsigned long, DispatchStatisticsType >::iterator it;
+  for (it = this->DispatchStatisticsMap.begin(); it != this->DispatchStatisticsMap.end(); ++it)
+    {
+    events.push_back(std::make_pair(it->second.TotalTime, it->first));
+    }
+  std::sort(events.rbegin(), events.rend());
+  for (size_t i = 0; i < events.size(); ++i)
+    {
+    const DispatchStatisticsType& statistics = this->DispatchStatisticsMap[events[i].second];
+    const char* eventString = vtkCommand::GetStringFromEventId(events[i].second);
+    os << (strcmp(eventString, "NoEvent") ? eventString : "") << " (" << events[i].second << "): "
+       << statistics.NumberOfDispatches << " dispatches, "
+       << statistics.TotalTime << "s total, "
+       << statistics.MaximumTime << "s max\n";
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -20,6 +20,7 @@
 
 // VTK includes
 #include <vtkObject.h>
+#include <vtksys/hash_map.hxx>
 class vtkTimerLog;
 
 // STD includes
@@ -28,6 +29,7 @@ class vtkTimerLog;
 #include <set>
 #include <map>
 #include <fstream>
+#include <utility>
 
 class vtkCollection;
 class vtkCallbackCommand;
@@ -128,6 +130,7 @@ public:
 
   ///
   /// Accessors for Observations
+  /// GetNumberOfObservations() is constant time, GetNthObservation() is linear.
   int GetNumberOfObservations();
   vtkObservation *GetNthObservation(int n);
 
@@ -135,9 +138,35 @@ public:
   /// Process any event that comes from either subject or observer
   void ProcessEvent (vtkObservation *observation, vtkObject *caller, unsigned long eid, void *callData);
 
+  /// Dispatch statistics
+  ///
+  /// When DispatchStatistics is on, the number of invocations and the time
+  /// spent in the callbacks (children included in synchronous mode) are
+  /// accumulated per event id. It is off by default and, unlike EventLogging,
+  /// doesn't write anything to disk.
+  vtkBooleanMacro (DispatchStatistics, int);
+  vtkSetMacro (DispatchStatistics, int);
+  vtkGetMacro (DispatchStatistics, int);
+
+  ///
+  /// Number of invocations of observations of \a event
+  unsigned long GetNumberOfDispatches(unsigned long event);
+  ///
+  /// Total and maximum time in seconds spent invoking observations of \a event
+  double GetTotalDispatchTime(unsigned long event);
+  double GetMaximumDispatchTime(unsigned long event);
+  ///
+  /// Clear the dispatch statistics of all the events
+  void ResetDispatchStatistics();
+  ///
+  /// Print the dispatch statistics of all the events, the most time
+  /// consuming first
+  void PrintDispatchStatistics(ostream& os);
+
   /// Event Logging
   ///
   /// Turn on event tracing (requires TraceFile)
+  /// \sa DispatchStatistics for a lightweight alternative
   vtkBooleanMacro (EventLogging, int);
   vtkSetMacro (EventLogging, int);
   vtkGetMacro (EventLogging, int);
@@ -266,14 +295,57 @@ protected:
 
 
   ///
-  typedef std::map< vtkObject*, ObservationVector > ObjectToObservationVectorMap;
+  /// Hash function of the observation indices
+  struct ObservationKeyHash
+    {
+    size_t operator()(const vtkObject* object) const
+      {
+      return reinterpret_cast<size_t>(object);
+      }
+    size_t operator()(const std::pair<vtkObject*, unsigned long>& subjectEvent) const
+      {
+      return reinterpret_cast<size_t>(subjectEvent.first) ^
+        (static_cast<size_t>(subjectEvent.second) * 2654435761u);
+      }
+    };
+  typedef vtksys::hash_map< vtkObject*, ObservationVector,
+                            ObservationKeyHash > ObjectToObservationVectorMap;
+  typedef std::pair< vtkObject*, unsigned long > SubjectEventType;
+  typedef vtksys::hash_map< SubjectEventType, ObservationVector,
+                            ObservationKeyHash > SubjectEventToObservationVectorMap;
 
   /// maps to manage quick lookup by object
   ObjectToObservationVectorMap SubjectMap;
   ObjectToObservationVectorMap ObserverMap;
+  /// map to manage quick lookup by subject and event
+  SubjectEventToObservationVectorMap SubjectEventMap;
+  int NumberOfObservations;
 
-  /// The event queue of triggered but not-yet-invoked observations
+  ///
+  /// Add/remove an observation to/from the lookup maps.
+  void IndexObservation(vtkObservation *observation);
+  void UnindexObservation(vtkObservation *observation);
+
+  /// The event queue of triggered but not-yet-invoked observations.
+  /// The queue holds a reference on its observations. Removed observations
+  /// are not erased from the queue but flagged with InEventQueue = 0 and
+  /// skipped when the queue is processed.
   std::deque< vtkObservation * > EventQueue;
+  int NumberOfQueuedObservations;
+
+  ///
+  /// Pop the observation at the front of the queue and release it.
+  void PopEventQueue();
+
+  struct DispatchStatisticsType
+    {
+    DispatchStatisticsType() : NumberOfDispatches(0), TotalTime(0.), MaximumTime(0.) {}
+    unsigned long NumberOfDispatches;
+    double TotalTime;
+    double MaximumTime;
+    };
+  std::map< unsigned long, DispatchStatisticsType > DispatchStatisticsMap;
+  int DispatchStatistics;
 
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
@@ -21,9 +21,30 @@ Version:   $Revision: 1.2 $
 #include <vtkObjectFactory.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 #include <vector>
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Order point indices by the X value of the points
+class XLess
+{
+public:
+  XLess(const double* values, int numberOfComponents)
+    : Values(values), NumberOfComponents(numberOfComponents) {}
+  bool operator()(int i, int j)const
+    {
+    return this->Values[i * this->NumberOfComponents] < this->Values[j * this->NumberOfComponents];
+    }
+  const double* Values;
+  int NumberOfComponents;
+};
+
+} // end of anonymous namespace
+
 //------------------------------------------------------------------------------
 vtkCxxSetObjectMacro(vtkMRMLDoubleArrayNode, Array, vtkDoubleArray)
 
@@ -38,6 +59,13 @@ vtkMRMLDoubleArrayNode::vtkMRMLDoubleArrayNode()
 
   this->Unit.resize(3);
 
+  this->CacheArray = NULL;
+  this->CacheNumberOfPoints = 0;
+  this->CacheXRange[0] = this->CacheXRange[1] = 0.0;
+  this->CacheYRange[0] = this->CacheYRange[1] = 0.0;
+  this->CacheYRangeWithError[0] = this->CacheYRangeWithError[1] = 0.0;
+  this->CacheXSorted = true;
+
   this->HideFromEditorsOff();
 }
 
@@ -157,39 +185,13 @@ void vtkMRMLDoubleArrayNode::ReadXMLAttributes(const char** atts)
       }
     }
 
-  if (valueYErr.size() > 0)  // if Y error values have loaded
+  // Y error values are optional
+  if (valueX.size() == valueY.size() &&
+      (valueYErr.size() == 0 || valueYErr.size() == valueY.size()))
     {
-    if (valueX.size() == valueY.size() && valueY.size() == valueYErr.size())
-      {
-      size_t n = valueX.size();
-      this->Array->SetNumberOfComponents(3);
-      this->Array->SetNumberOfTuples(n);
-      for (size_t i = 0; i < n; i ++)
-        {
-        double xy[3];
-        xy[0] = valueX[i];
-        xy[1] = valueY[i];
-        xy[2] = valueYErr[i];
-        this->Array->SetTupleValue(i, xy);
-        }
-      }
-    }
-  else
-    {
-    if (valueX.size() == valueY.size())
-      {
-      size_t n = valueX.size();
-      this->Array->SetNumberOfComponents(3);
-      this->Array->SetNumberOfTuples(n);
-      for (size_t i = 0; i < n; i ++)
-        {
-        double xy[3];
-        xy[0] = valueX[i];
-        xy[1] = valueY[i];
-        xy[2] = 0.0;
-        this->Array->SetTupleValue(i, xy);
-        }
-      }
+    int n = static_cast<int>(valueX.size());
+    this->SetXYValues(n ? &valueX[0] : NULL, n ? &valueY[0] : NULL,
+                      valueYErr.size() ? &valueYErr[0] : NULL, n);
     }
 
   this->EndModify(disabledModify);
@@ -248,6 +250,7 @@ void vtkMRMLDoubleArrayNode::SetSize(unsigned int n)
 {
   this->Array->SetNumberOfComponents(3);
   this->Array->SetNumberOfTuples(n);
+  this->Array->Modified();
   this->Modified();
 }
 
@@ -283,22 +286,58 @@ double vtkMRMLDoubleArrayNode::GetValue(int index, int component, int& success)
     success = 0;
     return -1;
     }
-  std::vector<double> tuple(this->Array->GetNumberOfComponents());
-  success = this->GetValues(index, &tuple[0]);
-
-  return tuple[component];
+  success = 1;
+  return this->Array->GetPointer(0)[index * this->Array->GetNumberOfComponents() + component];
 }
 
 
 //----------------------------------------------------------------------------
-double vtkMRMLDoubleArrayNode::GetYAxisValue(double vtkNotUsed(x), int vtkNotUsed(interp))
+double vtkMRMLDoubleArrayNode::GetYAxisValue(double x, int vtkNotUsed(interp))
 {
-  // not implemented yet
-  //  double xy[2];
-  //
-  //  this->Modified();
-  //  return 1;
-  return 0.0;
+  int nComp = this->Array ? this->Array->GetNumberOfComponents() : 0;
+  int n = this->Array ? this->Array->GetNumberOfTuples() : 0;
+  if (nComp < 2 || n == 0)
+    {
+    return 0.0;
+    }
+  this->UpdateSortedIndices();
+
+  const double* values = this->Array->GetPointer(0);
+  const int* indices = this->CacheXSorted ? NULL : &this->SortedIndices[0];
+
+  // Binary search of the first point with a X value greater or equal to x
+  int low = 0;
+  int high = n;
+  while (low < high)
+    {
+    int middle = low + (high - low) / 2;
+    int middleIndex = indices ? indices[middle] : middle;
+    if (values[middleIndex * nComp] < x)
+      {
+      low = middle + 1;
+      }
+    else
+      {
+      high = middle;
+      }
+    }
+
+  // Outside of the range, return the closest end point
+  if (low == 0 || low == n)
+    {
+    int endIndex = (low == 0 ? 0 : n - 1);
+    endIndex = indices ? indices[endIndex] : endIndex;
+    return values[endIndex * nComp + 1];
+    }
+
+  // Linear interpolation between the points around x
+  const double* xy0 = values + (indices ? indices[low - 1] : low - 1) * nComp;
+  const double* xy1 = values + (indices ? indices[low] : low) * nComp;
+  if (xy1[0] <= xy0[0])
+    {
+    return xy1[1];
+    }
+  return xy0[1] + (xy1[1] - xy0[1]) * (x - xy0[0]) / (xy1[0] - xy0[0]);
 }
 
 
@@ -312,13 +351,11 @@ int vtkMRMLDoubleArrayNode::GetXYValue(int index, double* x, double* y)
     return 0;
     }
 
-  std::vector<double> tuple(this->Array->GetNumberOfComponents());
-  int success = this->GetValues(index, &tuple[0]);
-  
+  const double* tuple = this->Array->GetPointer(index * this->Array->GetNumberOfComponents());
   *x = tuple[0];
   *y = tuple[1];
-  
-  return success;
+
+  return 1;
 }
 
 
@@ -332,14 +369,12 @@ int vtkMRMLDoubleArrayNode::GetXYValue(int index, double* x, double* y, double*
     return 0;
     }
 
-  std::vector<double> tuple(this->Array->GetNumberOfComponents());
-  int success = this->GetValues(index, &tuple[0]);
-
+  const double* tuple = this->Array->GetPointer(index * this->Array->GetNumberOfComponents());
   *x = tuple[0];
   *y = tuple[1];
   *yerr = tuple[2];
 
-  return success;
+  return 1;
 }
 
 
@@ -352,6 +387,7 @@ int vtkMRMLDoubleArrayNode::SetValues(int index, double* values)
     return 0;
     }
   this->Array->SetTupleValue(index, values);
+  this->Array->Modified();
   this->Modified();
   return 1;
 }
@@ -414,8 +450,11 @@ int vtkMRMLDoubleArrayNode::SetXYValue(int index, double x, double y, double yer
 //----------------------------------------------------------------------------
 int vtkMRMLDoubleArrayNode::AddValues(double* values)
 {
+  bool cacheUpToDate = this->IsCacheUpToDate();
+  int start = this->Array->GetNumberOfTuples();
   this->Array->InsertNextTuple(values);
-  this->Modified();
+  this->Array->Modified();
+  this->ModifiedWithNewValues(cacheUpToDate, start);
   return 1;
 }
 
@@ -467,177 +506,206 @@ int vtkMRMLDoubleArrayNode::AddXYValue(double x, double y, double yerr)
 
 
 //----------------------------------------------------------------------------
-void vtkMRMLDoubleArrayNode::GetRange(double* rangeX, double* rangeY, int fIncludeError)
+void vtkMRMLDoubleArrayNode::SetXYValues(const double* x, const double* y, const double* yerr, int n)
 {
-  rangeX[0] = 0.0;
-  rangeX[1] = 0.0;
-  rangeY[0] = 0.0;
-  rangeY[1] = 0.0;
-
-  if (!this->Array)
+  if (n < 0 || (n > 0 && (!x || !y)))
     {
+    vtkErrorMacro("SetXYValues: invalid values");
     return;
     }
+  this->Array->SetNumberOfComponents(3);
+  this->Array->SetNumberOfTuples(n);
+  double* values = this->Array->GetPointer(0);
+  for (int i = 0; i < n; i ++)
+    {
+    *(values++) = x[i];
+    *(values++) = y[i];
+    *(values++) = yerr ? yerr[i] : 0.0;
+    }
+  this->Array->Modified();
+  this->Modified();
+}
 
-  int nTuples = this->Array->GetNumberOfTuples();
-  int nComp   = this->Array->GetNumberOfComponents();
-
-  double xy[3];
-  double c;
-
-  // Consider error value in the range calculation,
-  // if fIncludeError=1 and number of components is larger than 3
 
-  if (fIncludeError && nComp > 2)
+//----------------------------------------------------------------------------
+void vtkMRMLDoubleArrayNode::AddXYValues(const double* x, const double* y, const double* yerr, int n)
+{
+  int nComp = this->Array->GetNumberOfComponents();
+  if (nComp < 2 || n < 0 || (n > 0 && (!x || !y)))
     {
-    c = 1.0;
+    vtkErrorMacro("AddXYValues: invalid values");
+    return;
     }
-  else
+  if (n == 0)
     {
-    xy[2] = 0.0;
-    c     = 0.0;
+    return;
     }
-
-  if (nTuples > 0)
+  bool cacheUpToDate = this->IsCacheUpToDate();
+  int start = this->Array->GetNumberOfTuples();
+  // WritePointer extends the array (at least doubling its capacity)
+  double* values = this->Array->WritePointer(start * nComp, n * nComp);
+  for (int i = 0; i < n; i ++)
     {
-    // Get the first values as an initial value
-    this->Array->GetTupleValue(0, xy);
-    rangeX[0] = xy[0];
-    rangeX[1] = xy[0];
-    rangeY[0] = xy[1] - c * xy[2];
-    rangeY[1] = xy[1] + c * xy[2];
-
-    // Search the array
-    for (int i = 1; i < nTuples; i ++)
+    values[0] = x[i];
+    values[1] = y[i];
+    for (int c = 2; c < nComp; c ++)
       {
-      this->Array->GetTupleValue(i, xy);
-
-      // X value
-      if (xy[0] < rangeX[0])
-        {
-        rangeX[0] = xy[0];
-        }
-      else if (xy[0] > rangeX[1])
-        {
-        rangeX[1] = xy[0];
-        }
-
-      // Y and error
-      double low  = xy[1] - c * xy[2];
-      double high = xy[1] + c * xy[2];
-
-      if (low < rangeY[0])
-        {
-        rangeY[0] = low;
-        }
-      if (high > rangeY[1])
-        {
-        rangeY[1] = high;
-        }
+      values[c] = 0.0;
       }
-
+    if (yerr && nComp > 2)
+      {
+      values[2] = yerr[i];
+      }
+    values += nComp;
     }
-
+  this->Array->Modified();
+  this->ModifiedWithNewValues(cacheUpToDate, start);
 }
 
 
 //----------------------------------------------------------------------------
-void vtkMRMLDoubleArrayNode::GetXRange(double* range)
+void vtkMRMLDoubleArrayNode::ModifiedWithNewValues(bool cacheUpToDate, int start)
 {
-  range[0] = 0.0;
-  range[1] = 0.0;
-
-  if (!this->Array)
+  unsigned long arrayMTime = this->Array->GetMTime();
+  this->Modified();
+  // The node modification invalidates the cache and observers may have
+  // rebuilt it already, extending it with the new values again is harmless.
+  if (cacheUpToDate && this->Array->GetMTime() == arrayMTime)
     {
-    return;
+    this->UpdateCache(start);
     }
+}
 
-  int nTuples = this->Array->GetNumberOfTuples();
-  double xy[3];
-
-  if (this->Array->GetNumberOfComponents() >= 2 && nTuples > 0)
-    {
 
-    // Get the first values as an initial value
-    this->Array->GetTupleValue(0, xy);
-    range[0] = xy[0];
-    range[1] = xy[0];
+//----------------------------------------------------------------------------
+void vtkMRMLDoubleArrayNode::GetRange(double* rangeX, double* rangeY, int fIncludeError)
+{
+  this->GetXRange(rangeX);
+  this->GetYRange(rangeY, fIncludeError);
+}
 
-    // Search the array
-    for (int i = 1; i < nTuples; i ++)
-      {
-      this->Array->GetTupleValue(i, xy);
-      if (xy[0] < range[0])
-        {
-        range[0] = xy[0];
-        }
-      else if (xy[0] > range[1])
-        {
-        range[1] = xy[0];
-        }
-      }
 
-    }
+//----------------------------------------------------------------------------
+void vtkMRMLDoubleArrayNode::GetXRange(double* range)
+{
+  this->UpdateCache();
+  range[0] = this->CacheXRange[0];
+  range[1] = this->CacheXRange[1];
 }
 
 
 //----------------------------------------------------------------------------
 void vtkMRMLDoubleArrayNode::GetYRange(double* range, int fIncludeError)
 {
-  range[0] = 0.0;
-  range[1] = 0.0;
+  this->UpdateCache();
+  // Consider error value in the range calculation,
+  // if fIncludeError=1 and number of components is larger than 3
+  double* cachedRange = fIncludeError ? this->CacheYRangeWithError : this->CacheYRange;
+  range[0] = cachedRange[0];
+  range[1] = cachedRange[1];
+}
 
-  if (!this->Array)
+
+//----------------------------------------------------------------------------
+bool vtkMRMLDoubleArrayNode::IsCacheUpToDate()
+{
+  // The array can be modified directly (GetArray()), the node or the array
+  // must then be marked as modified
+  return this->Array &&
+    this->CacheArray == this->Array &&
+    this->CacheTime.GetMTime() > this->GetMTime() &&
+    this->CacheTime.GetMTime() > this->Array->GetMTime() &&
+    this->CacheNumberOfPoints == this->Array->GetNumberOfTuples();
+}
+
+
+//----------------------------------------------------------------------------
+void vtkMRMLDoubleArrayNode::UpdateCache()
+{
+  if (this->IsCacheUpToDate())
     {
     return;
     }
+  this->UpdateCache(0);
+}
 
-  int nTuples = this->Array->GetNumberOfTuples();
-  int nComp   = this->Array->GetNumberOfComponents();
-
-  double xy[3];
-  double c;
-
-  // Consider error value in the range calculation,
-  // if fIncludeError=1 and number of components is larger than 3
 
-  if (fIncludeError && nComp > 2)
+//----------------------------------------------------------------------------
+void vtkMRMLDoubleArrayNode::UpdateCache(int start)
+{
+  if (start == 0)
     {
-    c = 1.0;
+    this->CacheXRange[0] = this->CacheXRange[1] = 0.0;
+    this->CacheYRange[0] = this->CacheYRange[1] = 0.0;
+    this->CacheYRangeWithError[0] = this->CacheYRangeWithError[1] = 0.0;
+    this->CacheXSorted = true;
+    this->SortedIndices.clear();
     }
-  else
+  this->CacheArray = this->Array;
+  if (!this->Array)
     {
-    xy[2] = 0.0;
-    c     = 0.0;
+    this->CacheNumberOfPoints = 0;
+    return;
     }
 
-  if (nTuples > 0)
-    {
-
-    // Get the first values as an initial value
-    this->Array->GetTupleValue(0, xy);
-    range[0] = xy[1] - c * xy[2];
-    range[1] = xy[1] + c * xy[2];
+  int nTuples = this->Array->GetNumberOfTuples();
+  int nComp   = this->Array->GetNumberOfComponents();
+  bool wasSorted = this->CacheXSorted;
 
-    // Search the array
-    for (int i = 1; i < nTuples; i ++)
+  if (nComp >= 2)
+    {
+    // Single pass over the raw values
+    const double* values = this->Array->GetPointer(0);
+    for (int i = start; i < nTuples; i ++)
       {
-      this->Array->GetTupleValue(i, xy);
-      double low  = xy[1] - c * xy[2];
-      double high = xy[1] + c * xy[2];
-
-      if (low < range[0])
+      const double* xy = values + i * nComp;
+      double err = (nComp > 2 ? xy[2] : 0.0);
+      if (i == 0)
         {
-        range[0] = low;
-        }
-      if (high > range[1])
-        {
-        range[1] = high;
+        // Get the first values as an initial value
+        this->CacheXRange[0] = this->CacheXRange[1] = xy[0];
+        this->CacheYRange[0] = this->CacheYRange[1] = xy[1];
+        this->CacheYRangeWithError[0] = xy[1] - err;
+        this->CacheYRangeWithError[1] = xy[1] + err;
+        continue;
         }
+      this->CacheXSorted = this->CacheXSorted && (xy[0] >= xy[-nComp]);
+      this->CacheXRange[0] = std::min(this->CacheXRange[0], xy[0]);
+      this->CacheXRange[1] = std::max(this->CacheXRange[1], xy[0]);
+      this->CacheYRange[0] = std::min(this->CacheYRange[0], xy[1]);
+      this->CacheYRange[1] = std::max(this->CacheYRange[1], xy[1]);
+      this->CacheYRangeWithError[0] = std::min(this->CacheYRangeWithError[0], xy[1] - err);
+      this->CacheYRangeWithError[1] = std::max(this->CacheYRangeWithError[1], xy[1] + err);
       }
+    }
 
+  if (!wasSorted || !this->CacheXSorted)
+    {
+    // the sorted indices are rebuilt on demand
+    this->SortedIndices.clear();
     }
+  this->CacheTime.Modified();
+  this->CacheNumberOfPoints = nTuples;
+}
+
 
+//----------------------------------------------------------------------------
+void vtkMRMLDoubleArrayNode::UpdateSortedIndices()
+{
+  this->UpdateCache();
+  int nTuples = this->Array ? this->Array->GetNumberOfTuples() : 0;
+  if (this->CacheXSorted ||
+      static_cast<int>(this->SortedIndices.size()) == nTuples)
+    {
+    return;
+    }
+  this->SortedIndices.resize(nTuples);
+  for (int i = 0; i < nTuples; i ++)
+    {
+    this->SortedIndices[i] = i;
+    }
+  std::stable_sort(this->SortedIndices.begin(), this->SortedIndices.end(),
+                   XLess(this->Array->GetPointer(0), this->Array->GetNumberOfComponents()));
 }
 
 void vtkMRMLDoubleArrayNode::SetLabels(const LabelsVectorType &labels)
@@ -86,8 +86,11 @@ public:
 
   ///
   /// Get Y value by X. If X is between two data points, it interpolates the value
-  /// by using the method specified by 'interp'.
-  /// NOTE: TO BE IMPLEMENTED.
+  /// by using the method specified by 'interp'. Outside of the X range, the Y
+  /// value of the closest end point is returned. Returns 0 if the array is empty.
+  /// The data points are found by binary search: if the X values are not sorted,
+  /// an index of the points sorted by X is built and kept until the array is
+  /// modified.
   double GetYAxisValue(double x, int interp=INTERP_LINEAR);
 
   /// \bug Fix function GetXYAxisValue(int index, double* x, double* y);
@@ -150,10 +153,25 @@ public:
   /// at the end of the array
   int AddXYValue(double x, double y, double yerr);
 
+  ///
+  /// Replace the content of the array by 'n' data points. 'yerr' can be NULL,
+  /// the errors are then set to 0. The values are copied in a single pass and
+  /// only one Modified event is invoked.
+  void SetXYValues(const double* x, const double* y, const double* yerr, int n);
+
+  ///
+  /// Add 'n' data points at the end of the array, e.g. a block of samples of a
+  /// live acquisition. 'yerr' can be NULL. The memory of the array grows
+  /// geometrically and the cached ranges and sort order are updated with the
+  /// new points only. Only one Modified event is invoked.
+  void AddXYValues(const double* x, const double* y, const double* yerr, int n);
+
   ///
   /// Search min and maximum value of X and Y in the array. The result is stored in 'range'.
   /// (range[0]: minimum value, range[1]: maximum value)
   /// if fIncludeError=1 is specified, the range takes account of errors.
+  /// The ranges are cached until the array is modified: call
+  /// GetArray()->Modified() after changing the values of the array directly.
   void GetRange(double* rangeX, double* rangeY, int fIncludeError=1);
 
   ///
@@ -190,6 +208,31 @@ public:
   vtkMRMLDoubleArrayNode(const vtkMRMLDoubleArrayNode&);
   void operator=(const vtkMRMLDoubleArrayNode&);
 
+  ///
+  /// Return true if the cached ranges and sort order describe the array:
+  /// neither the node nor the array were modified since they were computed.
+  bool IsCacheUpToDate();
+
+  ///
+  /// Recompute the cached ranges and sort order if the array has been
+  /// modified since they were computed.
+  void UpdateCache();
+
+  ///
+  /// Extend the cached ranges and sort order with the points of the array
+  /// from 'start' to the end. The cache must be up to date for the points
+  /// before 'start'.
+  void UpdateCache(int start);
+
+  ///
+  /// Call Modified() after values were added from 'start', the cache is
+  /// extended with them if it was up to date before they were added.
+  void ModifiedWithNewValues(bool cacheUpToDate, int start);
+
+  ///
+  /// Index of the points sorted by X, built on demand if X is not sorted.
+  void UpdateSortedIndices();
+
 
  protected:
   //----------------------------------------------------------------
@@ -201,6 +244,23 @@ public:
   std::vector< std::string > Unit;
   std::vector< std::string > Labels;
 
+  //----------------------------------------------------------------
+  /// Cache, valid as long as Array is unchanged and neither the node nor
+  /// Array were modified since CacheTime
+  //----------------------------------------------------------------
+
+  vtkDoubleArray* CacheArray;
+  vtkTimeStamp    CacheTime;
+  int             CacheNumberOfPoints;
+  double          CacheXRange[2];
+  double          CacheYRange[2];
+  double          CacheYRangeWithError[2];
+  /// True if the X values are in increasing order
+  bool            CacheXSorted;
+  /// Indices of the points sorted by X, only used if CacheXSorted is false.
+  /// Empty if not built yet.
+  std::vector<int> SortedIndices;
+
 
 };
 
@@ -23,23 +23,111 @@ Version:   $Revision: 1.14 $
 
 // STD includes
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 
-vtkCxxSetReferenceStringMacro(vtkMRMLHierarchyNode, ParentNodeIDReference);
-vtkCxxSetReferenceStringMacro(vtkMRMLHierarchyNode, AssociatedNodeIDReference);
-
-typedef std::map<std::string, std::vector< vtkMRMLHierarchyNode *> > HierarchyChildrenNodesType;
+typedef std::map<std::string, std::set< vtkMRMLHierarchyNode *> > HierarchyChildrenNodesType;
 
 std::map< vtkMRMLScene*, HierarchyChildrenNodesType> vtkMRMLHierarchyNode::SceneHierarchyChildrenNodes = std::map< vtkMRMLScene*, HierarchyChildrenNodesType>();
-std::map< vtkMRMLScene*, unsigned long> vtkMRMLHierarchyNode::SceneHierarchyChildrenNodesMTime = std::map< vtkMRMLScene*, unsigned long>();
 
 double vtkMRMLHierarchyNode::MaximumSortingValue = 0;
 
-typedef std::map<std::string, vtkMRMLHierarchyNode *> AssociatedHierarchyNodesType;
+typedef std::map<std::string, std::vector< vtkMRMLHierarchyNode *> > AssociatedHierarchyNodesType;
 
 std::map< vtkMRMLScene*, AssociatedHierarchyNodesType> vtkMRMLHierarchyNode::SceneAssociatedHierarchyNodes = std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>();
 
-std::map< vtkMRMLScene*, unsigned long> vtkMRMLHierarchyNode::SceneAssociatedHierarchyNodesMTime = std::map< vtkMRMLScene*, unsigned long>();;
+namespace
+{
+
+//----------------------------------------------------------------------------
+void AddToChildrenIndex(vtkMRMLScene* scene, const char* parentID, vtkMRMLHierarchyNode* node,
+                        std::map< vtkMRMLScene*, HierarchyChildrenNodesType>& sceneIndices)
+{
+  if (scene == NULL || parentID == NULL)
+    {
+    return;
+    }
+  sceneIndices[scene][parentID].insert(node);
+}
+
+//----------------------------------------------------------------------------
+void RemoveFromChildrenIndex(vtkMRMLScene* scene, const char* parentID, vtkMRMLHierarchyNode* node,
+                             std::map< vtkMRMLScene*, HierarchyChildrenNodesType>& sceneIndices)
+{
+  if (scene == NULL || parentID == NULL)
+    {
+    return;
+    }
+  std::map< vtkMRMLScene*, HierarchyChildrenNodesType>::iterator siter = sceneIndices.find(scene);
+  if (siter == sceneIndices.end())
+    {
+    return;
+    }
+  HierarchyChildrenNodesType::iterator iter = siter->second.find(parentID);
+  if (iter == siter->second.end())
+    {
+    return;
+    }
+  iter->second.erase(node);
+  if (iter->second.empty())
+    {
+    siter->second.erase(iter);
+    if (siter->second.empty())
+      {
+      sceneIndices.erase(siter);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void AddToAssociatedIndex(vtkMRMLScene* scene, const char* associatedID, vtkMRMLHierarchyNode* node,
+                          std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>& sceneIndices)
+{
+  if (scene == NULL || associatedID == NULL)
+    {
+    return;
+    }
+  sceneIndices[scene][associatedID].push_back(node);
+}
+
+//----------------------------------------------------------------------------
+void RemoveFromAssociatedIndex(vtkMRMLScene* scene, const char* associatedID, vtkMRMLHierarchyNode* node,
+                               std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>& sceneIndices)
+{
+  if (scene == NULL || associatedID == NULL)
+    {
+    return;
+    }
+  std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>::iterator siter = sceneIndices.find(scene);
+  if (siter == sceneIndices.end())
+    {
+    return;
+    }
+  AssociatedHierarchyNodesType::iterator iter = siter->second.find(associatedID);
+  if (iter == siter->second.end())
+    {
+    return;
+    }
+  // there is usually a single hierarchy node per associated node
+  iter->second.erase(std::remove(iter->second.begin(), iter->second.end(), node), iter->second.end());
+  if (iter->second.empty())
+    {
+    siter->second.erase(iter);
+    if (siter->second.empty())
+      {
+      sceneIndices.erase(siter);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool IsSameID(const char* id1, const char* id2)
+{
+  return (id1 == NULL && id2 == NULL) ||
+         (id1 != NULL && id2 != NULL && !strcmp(id1, id2));
+}
+
+} // end of anonymous namespace
 
 typedef vtkMRMLHierarchyNode* const vtkMRMLHierarchyNodePointer;
 bool vtkMRMLHierarchyNodeSortPredicate(vtkMRMLHierarchyNodePointer d1, vtkMRMLHierarchyNodePointer d2);
@@ -68,6 +156,9 @@ vtkMRMLHierarchyNode::vtkMRMLHierarchyNode()
 //----------------------------------------------------------------------------
 vtkMRMLHierarchyNode::~vtkMRMLHierarchyNode()
 {
+  // the node may not have been added to its scene
+  this->RemoveFromHierarchyIndices();
+
   if (this->ParentNodeIDReference)
     {
     delete [] this->ParentNodeIDReference;
@@ -203,6 +294,61 @@ vtkMRMLHierarchyNode* vtkMRMLHierarchyNode::GetParentNode()
   return node;
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLHierarchyNode::SetScene(vtkMRMLScene* scene)
+{
+  if (scene == this->Scene)
+    {
+    return;
+    }
+  this->RemoveFromHierarchyIndices();
+  this->Superclass::SetScene(scene);
+  this->AddToHierarchyIndices();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLHierarchyNode::AddToHierarchyIndices()
+{
+  AddToChildrenIndex(this->Scene, this->ParentNodeIDReference, this, SceneHierarchyChildrenNodes);
+  AddToAssociatedIndex(this->Scene, this->AssociatedNodeIDReference, this, SceneAssociatedHierarchyNodes);
+  if (this->Scene && this->SortingValue > MaximumSortingValue)
+    {
+    // nodes read from a file keep sorting after the existing ones
+    MaximumSortingValue = this->SortingValue;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLHierarchyNode::RemoveFromHierarchyIndices()
+{
+  RemoveFromChildrenIndex(this->Scene, this->ParentNodeIDReference, this, SceneHierarchyChildrenNodes);
+  RemoveFromAssociatedIndex(this->Scene, this->AssociatedNodeIDReference, this, SceneAssociatedHierarchyNodes);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLHierarchyNode::SetParentNodeIDReference(const char* _arg)
+{
+  if (IsSameID(this->ParentNodeIDReference, _arg))
+    {
+    return;
+    }
+  RemoveFromChildrenIndex(this->Scene, this->ParentNodeIDReference, this, SceneHierarchyChildrenNodes);
+  vtkSetReferenceStringBodyMacro(ParentNodeIDReference);
+  AddToChildrenIndex(this->Scene, this->ParentNodeIDReference, this, SceneHierarchyChildrenNodes);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLHierarchyNode::SetAssociatedNodeIDReference(const char* _arg)
+{
+  if (IsSameID(this->AssociatedNodeIDReference, _arg))
+    {
+    return;
+    }
+  RemoveFromAssociatedIndex(this->Scene, this->AssociatedNodeIDReference, this, SceneAssociatedHierarchyNodes);
+  vtkSetReferenceStringBodyMacro(AssociatedNodeIDReference);
+  AddToAssociatedIndex(this->Scene, this->AssociatedNodeIDReference, this, SceneAssociatedHierarchyNodes);
+}
+
 //-----------------------------------------------------------
 void vtkMRMLHierarchyNode::SetSceneReferences()
 {
@@ -264,7 +410,6 @@ void vtkMRMLHierarchyNode::SetParentNodeID(const char* ref)
   this->SetParentNodeIDReference(ref);
   this->SetSortingValue(++MaximumSortingValue);
 
-  this->HierarchyIsModified(this->GetScene());
   if (this->GetScene())
     {
     this->GetScene()->AddReferencedNodeID(ref, this);
@@ -309,26 +454,11 @@ vtkMRMLHierarchyNode* vtkMRMLHierarchyNode::GetTopParentNode()
 //----------------------------------------------------------------------------
 void vtkMRMLHierarchyNode::GetAllChildrenNodes(std::vector< vtkMRMLHierarchyNode *> &childrenNodes)
 {
-  if (this->GetScene() == NULL)
-    {
-    return;
-    }
-
-  this->UpdateChildrenMap();
-
-  std::map< vtkMRMLScene*, HierarchyChildrenNodesType>::iterator siter =
-        SceneHierarchyChildrenNodes.find(this->GetScene());
-
-  HierarchyChildrenNodesType::iterator iter =
-    siter->second.find(std::string(this->GetID()));
-  if (iter == siter->second.end())
-    {
-    return;
-    }
-  for (unsigned int i=0; i<iter->second.size(); i++)
+  std::vector< vtkMRMLHierarchyNode *> children = this->GetChildrenNodes();
+  for (unsigned int i=0; i<children.size(); i++)
     {
-    childrenNodes.push_back(iter->second[i]);
-    iter->second[i]->GetAllChildrenNodes(childrenNodes);
+    childrenNodes.push_back(children[i]);
+    children[i]->GetAllChildrenNodes(childrenNodes);
     }
 }
 
@@ -336,26 +466,23 @@ void vtkMRMLHierarchyNode::GetAllChildrenNodes(std::vector< vtkMRMLHierarchyNode
 std::vector< vtkMRMLHierarchyNode *> vtkMRMLHierarchyNode::GetChildrenNodes()
 {
   std::vector< vtkMRMLHierarchyNode *> childrenNodes;
-  if (this->GetScene() == NULL)
+  if (this->GetScene() == NULL || this->GetID() == NULL)
     {
     return childrenNodes;
     }
 
-  this->UpdateChildrenMap();
-
-  std::map< vtkMRMLScene*, HierarchyChildrenNodesType>::iterator siter =
+  std::map< vtkMRMLScene*, HierarchyChildrenNodesType>::const_iterator siter =
         SceneHierarchyChildrenNodes.find(this->GetScene());
-
-  HierarchyChildrenNodesType::iterator iter =
-    siter->second.find(std::string(this->GetID()));
-  if (iter == siter->second.end())
+  if (siter == SceneHierarchyChildrenNodes.end())
     {
     return childrenNodes;
     }
-  for (unsigned int i=0; i<iter->second.size(); i++)
+  HierarchyChildrenNodesType::const_iterator iter = siter->second.find(this->GetID());
+  if (iter == siter->second.end())
     {
-    childrenNodes.push_back(iter->second[i]);
+    return childrenNodes;
     }
+  childrenNodes.assign(iter->second.begin(), iter->second.end());
 
   // Sort the vector using predicate and std::sort
   std::sort(childrenNodes.begin(), childrenNodes.end(), vtkMRMLHierarchyNodeSortPredicate);
@@ -480,8 +607,6 @@ void vtkMRMLHierarchyNode::MoveInParent(int increment)
       childrenNodes[index1]->SortingValue = sortValue2;
       childrenNodes[index2]->SortingValue = sortValue1;
 
-      // update the cache
-      pnode->UpdateChildrenMap();
       index1 += incr1;
       index2 += incr1;
       }
@@ -542,96 +667,6 @@ void vtkMRMLHierarchyNode::RemoveAllHierarchyChildrenNodes()
 }
 
 //----------------------------------------------------------------------------
-void vtkMRMLHierarchyNode::UpdateChildrenMap()
-{
-  if (this->GetScene() == NULL)
-    {
-    this->SceneHierarchyChildrenNodes.clear();
-    this->SceneHierarchyChildrenNodesMTime.clear();
-    return;
-    }
-
-  std::map< vtkMRMLScene*, HierarchyChildrenNodesType>::iterator siter =
-        SceneHierarchyChildrenNodes.find(this->GetScene());
-  if (siter == SceneHierarchyChildrenNodes.end())
-    {
-    HierarchyChildrenNodesType h;
-    SceneHierarchyChildrenNodes[this->GetScene()] = h;
-    siter = SceneHierarchyChildrenNodes.find(this->GetScene());
-    SceneHierarchyChildrenNodesMTime[this->GetScene()] = 0;
-    }
-
-  std::map< vtkMRMLScene*, unsigned long>::iterator titer =
-        SceneHierarchyChildrenNodesMTime.find(this->GetScene());
-
-  std::map<std::string, std::vector< vtkMRMLHierarchyNode *> >::iterator iter;
-  if (this->GetScene() == 0)
-    {
-    for (iter  = siter->second.begin();
-         iter != siter->second.end();
-         iter++)
-      {
-      iter->second.clear();
-      }
-    siter->second.clear();
-    }
-
-  if (this->GetScene()->GetNodes()->GetMTime() > titer->second)
-  {
-    for (iter  = siter->second.begin();
-         iter != siter->second.end();
-         iter++)
-      {
-      iter->second.clear();
-      }
-    siter->second.clear();
-
-    std::vector<vtkMRMLNode *> nodes;
-    int nnodes = this->GetScene()->GetNodesByClass("vtkMRMLHierarchyNode", nodes);
-
-    double maxSortingValue = this->MaximumSortingValue;
-
-    for (int i=0; i<nnodes; i++)
-      {
-      vtkMRMLHierarchyNode *node =  vtkMRMLHierarchyNode::SafeDownCast(nodes[i]);
-      if (node)
-        {
-        vtkMRMLHierarchyNode *pnode = vtkMRMLHierarchyNode::SafeDownCast(node->GetParentNode());
-        if (pnode)
-          {
-          if (pnode->GetSortingValue() > maxSortingValue)
-            {
-            maxSortingValue = pnode->GetSortingValue();
-            }
-          iter = siter->second.find(std::string(pnode->GetID()));
-          if (iter == siter->second.end())
-            {
-            std::vector< vtkMRMLHierarchyNode *> children;
-            children.push_back(node);
-            siter->second[std::string(pnode->GetID())] = children;
-            }
-          else
-            {
-            iter->second.push_back(node);
-            }
-          }
-        }
-      }
-    titer->second = this->GetScene()->GetNodes()->GetMTime();
-    this->MaximumSortingValue = maxSortingValue;
-  }
-}
-
-void vtkMRMLHierarchyNode::HierarchyIsModified(vtkMRMLScene *scene)
-{
-  if (scene == NULL)
-    {
-    return;
-    }
-
-  SceneHierarchyChildrenNodesMTime[scene] = 0;
-}
-
 void vtkMRMLHierarchyNode::GetAssociatedChildrenNodes(vtkCollection *children,
                                                       const char* childClass)
 {
@@ -690,22 +725,19 @@ vtkMRMLHierarchyNode* vtkMRMLHierarchyNode::GetAssociatedHierarchyNode(vtkMRMLSc
     return NULL;
     }
 
-  vtkMRMLHierarchyNode::UpdateAssociatedToHierarchyMap(scene);
-
-  std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>::iterator siter =
+  std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>::const_iterator siter =
         SceneAssociatedHierarchyNodes.find(scene);
   if (siter == SceneAssociatedHierarchyNodes.end())
     {
-    std::cerr << "GetAssociatedHierarchyNode: didn't find an associated hierarchy node type associated with the scene" << std::endl;
+    // no hierarchy node in the scene
     return NULL;
     }
 
-  std::map<std::string, vtkMRMLHierarchyNode *>::iterator iter;
-
-  iter = siter->second.find(associatedNodeID);
+  AssociatedHierarchyNodesType::const_iterator iter = siter->second.find(associatedNodeID);
   if (iter != siter->second.end())
     {
-    return iter->second;
+    // the last associated hierarchy node
+    return iter->second.back();
     }
   else
     {
@@ -713,53 +745,6 @@ vtkMRMLHierarchyNode* vtkMRMLHierarchyNode::GetAssociatedHierarchyNode(vtkMRMLSc
     }
 }
 
-//----------------------------------------------------------------------------
-int vtkMRMLHierarchyNode::UpdateAssociatedToHierarchyMap(vtkMRMLScene *scene)
-{
-  if (scene == 0)
-    {
-    SceneAssociatedHierarchyNodes.clear();
-    SceneAssociatedHierarchyNodesMTime.clear();
-    return 0;
-    }
-
-  std::map< vtkMRMLScene*, AssociatedHierarchyNodesType>::iterator siter =
-        SceneAssociatedHierarchyNodes.find(scene);
-  if (siter == SceneAssociatedHierarchyNodes.end())
-    {
-    AssociatedHierarchyNodesType h;
-    SceneAssociatedHierarchyNodes[scene] = h;
-    siter = SceneAssociatedHierarchyNodes.find(scene);
-    SceneAssociatedHierarchyNodesMTime[scene] = 0;
-    }
-
-  std::map< vtkMRMLScene*, unsigned long>::iterator titer =
-        SceneAssociatedHierarchyNodesMTime.find(scene);
-
-  if (scene->GetNodes()->GetMTime() > titer->second)
-  {
-    siter->second.clear();
-
-    std::vector<vtkMRMLNode *> nodes;
-    int nnodes = scene->GetNodesByClass("vtkMRMLHierarchyNode", nodes);
-
-    for (int i=0; i<nnodes; i++)
-      {
-      vtkMRMLHierarchyNode *node =  vtkMRMLHierarchyNode::SafeDownCast(nodes[i]);
-      if (node)
-        {
-        vtkMRMLNode *mnode = node->vtkMRMLHierarchyNode::GetAssociatedNode();
-        if (mnode)
-          {
-          siter->second[std::string(mnode->GetID())] = node;
-          }
-        }
-      }
-    titer->second = scene->GetNodes()->GetMTime();
-  }
-  return static_cast<int>(siter->second.size());
-}
-
 //----------------------------------------------------------------------------
 vtkMRMLNode* vtkMRMLHierarchyNode::GetAssociatedNode()
 {
@@ -778,7 +763,6 @@ void vtkMRMLHierarchyNode::SetAssociatedNodeID(const char* ref)
       (this->AssociatedNodeIDReference != ref))
     {
     this->SetAssociatedNodeIDReference(ref);
-    this->AssociatedHierarchyIsModified(this->GetScene());
     if (this->Scene)
       {
       this->Scene->AddReferencedNodeID(ref, this);
@@ -792,17 +776,6 @@ void vtkMRMLHierarchyNode::SetAssociatedNodeID(const char* ref)
     }
 }
 
-//----------------------------------------------------------------------------
-void vtkMRMLHierarchyNode::AssociatedHierarchyIsModified(vtkMRMLScene *scene)
-{
-  if (scene == NULL)
-    {
-    return;
-    }
-
-  SceneAssociatedHierarchyNodesMTime[scene] = 0;
-}
-
 //----------------------------------------------------------------------------
 void vtkMRMLHierarchyNode::SetSortingValue(double value)
 {
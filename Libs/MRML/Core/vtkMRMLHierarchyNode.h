@@ -22,9 +22,18 @@
 class vtkCollection;
 
 // STD includes
+#include <set>
 #include <vector>
 
 /// \brief Abstract class representing a hierarchy member.
+///
+/// The children and the associated nodes of the hierarchy nodes of a scene
+/// are indexed. The indices are updated when a hierarchy node is added to or
+/// removed from a scene and when its parent or associated node is changed,
+/// they are never rebuilt: looking up children or the hierarchy node of an
+/// associated node doesn't depend on the number of nodes in the scene and
+/// doesn't modify the indices (concurrent lookups are safe as long as no
+/// hierarchy is modified at the same time).
 class VTK_MRML_EXPORT vtkMRMLHierarchyNode : public vtkMRMLNode
 {
 public:
@@ -66,6 +75,10 @@ public:
   /// Update the stored reference to another node in the scene
   virtual void UpdateReferenceID(const char *oldID, const char *newID);
 
+  ///
+  /// Reimplemented to index the node in the hierarchy of its scene
+  virtual void SetScene(vtkMRMLScene* scene);
+
   ///
   /// Associated prent MRML node
   vtkMRMLHierarchyNode* GetParentNode();
@@ -85,6 +98,7 @@ public:
 
   ///
   /// Given this hierarchy node returns all it's children recursively.
+  /// The children of a node are sorted by SortingValue.
   void GetAllChildrenNodes(std::vector< vtkMRMLHierarchyNode *> &childrenNodes);
 
   ///
@@ -179,14 +193,8 @@ protected:
 
   char *ParentNodeIDReference;
 
-  /// Mark hierarchy as modified when you
-  static void HierarchyIsModified(vtkMRMLScene *scene);
-
-
   ///////////////////////
 
-  /// Mark hierarchy as modified
-  static void AssociatedHierarchyIsModified(vtkMRMLScene *scene);
   ///
   /// String ID of the associated MRML node
   char *AssociatedNodeIDReference;
@@ -194,29 +202,28 @@ protected:
   void SetAssociatedNodeIDReference(const char*);
   vtkGetStringMacro(AssociatedNodeIDReference);
 
-  typedef std::map<std::string, std::vector< vtkMRMLHierarchyNode *> > HierarchyChildrenNodesType;
+  /// Hierarchy nodes of a scene indexed by the ID of their parent node
+  typedef std::map<std::string, std::set< vtkMRMLHierarchyNode *> > HierarchyChildrenNodesType;
 
   static std::map< vtkMRMLScene*, HierarchyChildrenNodesType> SceneHierarchyChildrenNodes;
-  static std::map< vtkMRMLScene*, unsigned long> SceneHierarchyChildrenNodesMTime;
 
   ////////////////////////////
-  ///
-  /// Create Associated to hierarchy map,
-  /// return number of Associated hierarchy nodes
-  static int UpdateAssociatedToHierarchyMap(vtkMRMLScene *scene);
 
-  typedef std::map<std::string, vtkMRMLHierarchyNode *> AssociatedHierarchyNodesType;
+  /// Hierarchy nodes of a scene indexed by the ID of their associated node,
+  /// in the order they were associated
+  typedef std::map<std::string, std::vector< vtkMRMLHierarchyNode *> > AssociatedHierarchyNodesType;
 
   static std::map< vtkMRMLScene*, AssociatedHierarchyNodesType> SceneAssociatedHierarchyNodes;
 
-  static std::map< vtkMRMLScene*, unsigned long> SceneAssociatedHierarchyNodesMTime;
+  /// Add/remove the node to/from the children and associated node indices
+  /// of its scene.
+  void AddToHierarchyIndices();
+  void RemoveFromHierarchyIndices();
 
   double SortingValue;
 
   static double MaximumSortingValue;
 
-  void UpdateChildrenMap();
-
   /// is this a node that's only supposed to have one child?
   int AllowMultipleChildren;
 
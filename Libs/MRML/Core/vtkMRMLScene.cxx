@@ -75,11 +75,15 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLVectorVolumeNode.h"
 #endif
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 
@@ -106,6 +110,8 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 //------------------------------------------------------------------------------
 vtkMRMLScene::vtkMRMLScene()
 {
+  this->ModifyingNodes = 0;
+  this->ModifiedEventPending = 0;
   this->NodeIDsMTime = 0;
   this->SceneModifiedTime = 0;
 
@@ -220,6 +226,19 @@ vtkMRMLScene::vtkMRMLScene()
 //------------------------------------------------------------------------------
 vtkMRMLScene::~vtkMRMLScene()
 {
+  // Restore the modify state of the nodes queued by StartModify() as they
+  // may outlive the scene. Their pending events are not invoked from the
+  // destructor, observers could otherwise access the scene being deleted.
+  std::map<vtkMRMLNode*, int>::iterator modifyStateIt;
+  for (modifyStateIt = this->NodesModifyStates.begin();
+       modifyStateIt != this->NodesModifyStates.end(); ++modifyStateIt)
+    {
+    modifyStateIt->first->SetDisableModifiedEvent(modifyStateIt->second);
+    }
+  this->NodesModifyStates.clear();
+  this->NodesAddedWhileModifying.clear();
+  this->NodesRemovedWhileModifying.clear();
+
   this->ClearUndoStack ( );
   this->ClearRedoStack ( );
 
@@ -613,6 +632,95 @@ void vtkMRMLScene::EndState(unsigned long state)
     }
 }
 
+//------------------------------------------------------------------------------
+int vtkMRMLScene::StartModify()
+{
+  int wasModifying = this->ModifyingNodes;
+  this->StartState(vtkMRMLScene::BatchProcessState);
+  this->ModifyingNodes = 1;
+  if (!wasModifying)
+    {
+    vtkMRMLNode* node = 0;
+    vtkCollectionSimpleIterator it;
+    for (this->Nodes->InitTraversal(it);
+         (node = vtkMRMLNode::SafeDownCast(this->Nodes->GetNextItemAsObject(it))) ;)
+      {
+      this->NodesModifyStates[node] = node->StartModify();
+      }
+    }
+  return wasModifying;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLScene::EndModify(int previousModifyingState)
+{
+  this->ModifyingNodes = previousModifyingState;
+  int modifiedNodes = 0;
+  if (!previousModifyingState)
+    {
+    // Observers may add, remove or modify nodes while the pending events
+    // are invoked, the pending nodes must therefore be copied first.
+    std::vector<vtkSmartPointer<vtkMRMLNode> > removedNodes;
+    removedNodes.swap(this->NodesRemovedWhileModifying);
+    for (size_t i = 0; i < removedNodes.size(); ++i)
+      {
+      // Skip the nodes that have been added back in the meantime
+      if (removedNodes[i]->GetScene() != this)
+        {
+        this->UpdateReferencesOfRemovedNode(removedNodes[i]);
+        }
+      }
+
+    std::vector<vtkSmartPointer<vtkMRMLNode> > addedNodes;
+    addedNodes.swap(this->NodesAddedWhileModifying);
+    for (size_t i = 0; i < addedNodes.size(); ++i)
+      {
+      this->InvokeEvent(vtkMRMLScene::NodeAddedEvent, addedNodes[i]);
+      }
+
+    std::vector<std::pair<vtkSmartPointer<vtkMRMLNode>, int> > nodesToNotify;
+    std::map<vtkMRMLNode*, int>::iterator it;
+    for (it = this->NodesModifyStates.begin(); it != this->NodesModifyStates.end(); ++it)
+      {
+      nodesToNotify.push_back(std::make_pair(vtkSmartPointer<vtkMRMLNode>(it->first), it->second));
+      }
+    this->NodesModifyStates.clear();
+    vtkNew<vtkCollection> nodesWithPendingEvents;
+    for (size_t i = 0; i < nodesToNotify.size(); ++i)
+      {
+      if (nodesToNotify[i].first->EndModify(nodesToNotify[i].second) > 0)
+        {
+        nodesWithPendingEvents->AddItem(nodesToNotify[i].first);
+        ++modifiedNodes;
+        }
+      }
+    if (modifiedNodes > 0)
+      {
+      this->InvokeEvent(vtkMRMLScene::NodesModifiedEvent, nodesWithPendingEvents.GetPointer());
+      }
+    if (this->ModifiedEventPending)
+      {
+      this->ModifiedEventPending = 0;
+      this->InvokeEvent(vtkCommand::ModifiedEvent, NULL);
+      }
+    }
+  this->EndState(vtkMRMLScene::BatchProcessState);
+  return modifiedNodes;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::Modified()
+{
+  if (this->ModifyingNodes)
+    {
+    // Keep GetMTime() up-to-date, only the event is deferred
+    this->MTime.Modified();
+    ++this->ModifiedEventPending;
+    return;
+    }
+  this->Superclass::Modified();
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ProgressState(unsigned long state, int progress)
 {
@@ -656,6 +764,7 @@ int vtkMRMLScene::Connect()
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Import()
 {
+  vtkTraceZoneWithDetailMacro("Import", "MRML", this->GetURL());
 #ifdef MRMLSCENE_VERBOSE
   vtkTimerLog* addNodesTimer = vtkTimerLog::New();
   vtkTimerLog* updateSceneTimer = vtkTimerLog::New();
@@ -775,6 +884,7 @@ int vtkMRMLScene::Import()
   timer->Delete();
 #endif
   this->StoredTime.Modified();
+  vtkTraceCounterMacro("Nodes", this->GetNumberOfNodes());
   return returnCode;
 }
 
@@ -853,6 +963,7 @@ int vtkMRMLScene::LoadIntoScene(vtkCollection* nodeCollection)
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Commit(const char* url)
 {
+  vtkTraceZoneWithDetailMacro("Commit", "MRML", url ? url : this->GetURL());
   if (url == NULL)
     {
     if (this->URL != "")
@@ -1127,6 +1238,12 @@ vtkMRMLNode*  vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
 
   //n->OnNodeAddedToScene();
 
+  if (this->ModifyingNodes)
+    {
+    // Keep the events of the node queued until EndModify()
+    this->NodesModifyStates[n] = wasModifying;
+    return n;
+    }
   n->EndModify(wasModifying);
   return n;
 }
@@ -1176,7 +1293,12 @@ vtkMRMLNode*  vtkMRMLScene::AddNode(vtkMRMLNode *n)
   vtkMRMLNode* node = this->AddNodeNoNotify(n);
   // If the node is a singleton, the returned node is the existing singleton
   assert( add || node != n);
-  if (add)
+  if (add && this->ModifyingNodes)
+    {
+    // NodeAddedEvent is invoked by EndModify()
+    this->NodesAddedWhileModifying.push_back(n);
+    }
+  else if (add)
     {
     this->InvokeEvent(this->NodeAddedEvent, n);
     }
@@ -1244,6 +1366,23 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
 #endif
 
   n->Register(this);
+
+  // Flush the events queued by StartModify() before the node leaves the scene
+  std::vector<vtkSmartPointer<vtkMRMLNode> >::iterator addedNodeIt =
+    std::find(this->NodesAddedWhileModifying.begin(), this->NodesAddedWhileModifying.end(), n);
+  if (addedNodeIt != this->NodesAddedWhileModifying.end())
+    {
+    this->NodesAddedWhileModifying.erase(addedNodeIt);
+    this->InvokeEvent(vtkMRMLScene::NodeAddedEvent, n);
+    }
+  std::map<vtkMRMLNode*, int>::iterator modifyStateIt = this->NodesModifyStates.find(n);
+  if (modifyStateIt != this->NodesModifyStates.end())
+    {
+    int previousModifyState = modifyStateIt->second;
+    this->NodesModifyStates.erase(modifyStateIt);
+    n->EndModify(previousModifyState);
+    }
+
   this->InvokeEvent(vtkMRMLScene::NodeAboutToBeRemovedEvent, n);
 
   if (n->GetScene() == this) // extra precaution that might not be useful
@@ -1252,35 +1391,22 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     }
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
 
-  std::string nid=n->GetID();
   this->RemoveNodeID(n->GetID());
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
-  if (!this->IsBatchProcessing() && !this->IsClosing())
+  // The batch processing of StartModify() defers the reference updates
+  // to EndModify(), other batch processes update all the references at the end.
+  bool onlyModifyingNodes = (this->ModifyingNodes &&
+    this->GetStates() == vtkMRMLScene::BatchProcessState);
+  if (onlyModifyingNodes)
+    {
+    this->NodesRemovedWhileModifying.push_back(n);
+    }
+  else if (!this->IsBatchProcessing() && !this->IsClosing())
     {
     // We are not doing batch processing, so update the node references now.
-    // Node references will be all removed for the removed node and for
-    // all the nodes that the deleted node referred to.
-    this->RemoveNodeReferences(n);
-    // Notify nodes that referred to the deleted node to update their references
-    NodeReferencesType::iterator referencedNodeIdIt=this->NodeReferences.find(nid);
-    if (referencedNodeIdIt!=this->NodeReferences.end())
-      {
-      // make a copy of the referring node list, as the list may change as a result of UpdateReferences calls
-      std::set<std::string> referringNodes=referencedNodeIdIt->second;
-      for (NodeReferencesType::value_type::second_type::iterator referringNodesIt = referringNodes.begin();
-        referringNodesIt != referringNodes.end();
-        ++referringNodesIt)
-        {
-        vtkMRMLNode* node=this->GetNodeByID(*referringNodesIt);
-        if (node)
-          {
-          node->UpdateReferences();
-          }
-        }
-      }
-    this->RemoveReferencesToNode(n);
+    this->UpdateReferencesOfRemovedNode(n);
     }
 
   n->UnRegister(this);
@@ -1289,6 +1415,33 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
   this->Modified();
 }
 
+//------------------------------------------------------------------------------
+void vtkMRMLScene::UpdateReferencesOfRemovedNode(vtkMRMLNode *n)
+{
+  // Node references will be all removed for the removed node and for
+  // all the nodes that the deleted node referred to.
+  std::string nid=n->GetID();
+  this->RemoveNodeReferences(n);
+  // Notify nodes that referred to the deleted node to update their references
+  NodeReferencesType::iterator referencedNodeIdIt=this->NodeReferences.find(nid);
+  if (referencedNodeIdIt!=this->NodeReferences.end())
+    {
+    // make a copy of the referring node list, as the list may change as a result of UpdateReferences calls
+    std::set<std::string> referringNodes=referencedNodeIdIt->second;
+    for (NodeReferencesType::value_type::second_type::iterator referringNodesIt = referringNodes.begin();
+      referringNodesIt != referringNodes.end();
+      ++referringNodesIt)
+      {
+      vtkMRMLNode* node=this->GetNodeByID(*referringNodesIt);
+      if (node)
+        {
+        node->UpdateReferences();
+        }
+      }
+    }
+  this->RemoveReferencesToNode(n);
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::RemoveReferencedNodeID(const char *id, vtkMRMLNode *referencingNode)
 {
@@ -318,6 +318,10 @@ public:
 
   void RemoveReferencesToNode(vtkMRMLNode *node);
 
+  /// Remove the references of a node that has been removed from the scene
+  /// and update the nodes that referenced it.
+  void UpdateReferencesOfRemovedNode(vtkMRMLNode *node);
+
   /// \brief Notify nodes about node ID changes.
   ///
   /// vtkMRMLNode::UpdateReferenceID() is called for all the nodes that refer
@@ -468,13 +472,23 @@ public:
   /// * ...
   /// * \link vtkMRMLScene::EndImportEvent EndImportEvent \endlink,
   /// * \link vtkMRMLScene::EndBatchProcessEvent EndBatchProcessEvent \endlink
+  ///
+  /// \link vtkMRMLScene::ReadDataState ReadDataState \endlink is not a
+  /// batch process state: it is set by loaders that read the data of the
+  /// nodes after the scene is imported (e.g. vtkMRMLSceneLoader), nodes
+  /// are displayed as soon as their data is read. It starts before the
+  /// scene is imported and ends after the data is read: the observers of
+  /// EndImportEvent get nodes without data (e.g. volumes without image
+  /// data), they must wait for EndReadDataEvent or observe the nodes
+  /// (e.g. vtkMRMLVolumeNode::ImageDataModifiedEvent) to use the data.
   enum StateType
     {
     BatchProcessState = 0x0001,
     CloseState = 0x0002 | BatchProcessState,
     ImportState = 0x0004 | BatchProcessState,
     RestoreState = 0x0008 | BatchProcessState,
-    SaveState = 0x0010
+    SaveState = 0x0010,
+    ReadDataState = 0x0020
     };
 
   /// \brief Returns the current state of the scene.
@@ -482,7 +496,7 @@ public:
   /// It is a combination of all current states.
   /// Returns 0 if the scene has no current state flag.
   ///
-  /// \sa IsBatchProcessing, IsClosing, IsImporting, IsRestoring
+  /// \sa IsBatchProcessing, IsClosing, IsImporting, IsRestoring, IsReadingData
   /// \sa StartState, EndState
   int GetStates()const;
 
@@ -494,6 +508,8 @@ public:
   inline bool IsImporting()const;
   /// Return true if the scene is in Restore state, false otherwise
   inline bool IsRestoring()const;
+  /// Return true if the scene is in ReadData state, false otherwise
+  inline bool IsReadingData()const;
 
   /// \brief Flag the scene as being in a \a state mode.
   ///
@@ -541,9 +557,65 @@ public:
   /// EndState() internally pops the state out of the stack.
   void EndState(unsigned long state);
 
-  /// TODO: Report progress of the current state.
+  /// \brief Report the progress of the current \a state.
+  ///
+  /// Fires the \a state progress event with \a progress as call data,
+  /// e.g. vtkMRMLScene::ProgressReadDataEvent if state is
+  /// \link vtkMRMLScene::ReadDataState ReadDataState \endlink.
+  /// \a progress is relative to the anticipatedMaxProgress given to
+  /// StartState().
   void ProgressState(unsigned long state, int progress = 0);
 
+  /// \brief Start modifying the nodes of the scene.
+  ///
+  /// This is the scene-wide equivalent of vtkMRMLNode::StartModify(): until
+  /// the matching EndModify(), the vtkCommand::ModifiedEvent and the custom
+  /// modified events of every node in the scene, including the nodes added in
+  /// the meantime, are queued instead of being invoked. The NodeAddedEvent of
+  /// the added nodes, the node reference updates of the removed nodes and the
+  /// scene vtkCommand::ModifiedEvent are deferred as well (GetMTime() is
+  /// still updated). The scene is also in
+  /// \link vtkMRMLScene::BatchProcessState BatchProcessState \endlink so that
+  /// observers can ignore the NodeRemovedEvent and synchronize once at
+  /// \link vtkMRMLScene::EndBatchProcessEvent EndBatchProcessEvent \endlink.
+  ///
+  /// Returns the previous modifying state that must be passed to EndModify().
+  ///
+  /// Example:
+  /// \code
+  /// int wasModifying = scene->StartModify();
+  /// for (...)
+  ///   {
+  ///   displayNode->SetColor(...);
+  ///   displayNode->SetOpacity(...);
+  ///   }
+  /// scene->EndModify(wasModifying);
+  /// // fires one ModifiedEvent per modified display node, one
+  /// // NodesModifiedEvent, one scene ModifiedEvent and EndBatchProcessEvent
+  /// \endcode
+  /// \sa EndModify(), GetModifyingNodes(), vtkMRMLNode::StartModify()
+  int StartModify();
+
+  /// \brief End modifying the nodes of the scene.
+  ///
+  /// If \a previousModifyingState is 0, the references of the removed nodes
+  /// are updated, NodeAddedEvent is invoked for the added nodes and each node
+  /// modified since StartModify() invokes its pending events once. Then the
+  /// scene invokes \link vtkMRMLScene::NodesModifiedEvent NodesModifiedEvent \endlink
+  /// with all these nodes, its own pending vtkCommand::ModifiedEvent and
+  /// leaves the batch process state.
+  ///
+  /// Returns the number of nodes that had pending events.
+  /// \sa StartModify()
+  int EndModify(int previousModifyingState);
+
+  /// Return nonzero if the scene is between StartModify() and EndModify().
+  vtkGetMacro(ModifyingNodes, int);
+
+  /// \brief Customized version of Modified() to compress
+  /// vtkCommand::ModifiedEvent between StartModify() and EndModify().
+  virtual void Modified();
+
   enum SceneEventType
     {
     NodeAboutToBeAddedEvent = 0x2000,
@@ -555,6 +627,12 @@ public:
     MetadataAddedEvent = 66032, // ### Slicer 4.5: Simplify - Do not explicitly set for backward compat. See issue #3472
     ImportProgressFeedbackEvent,
     SaveProgressFeedbackEvent,
+    /// Invoked once by EndModify() after the nodes modified since StartModify()
+    /// invoked their pending events, while the scene is still batch processing.
+    /// The call data is a vtkCollection of the modified nodes. Observers that
+    /// handle this event can ignore the node events while the scene is
+    /// batch processing.
+    NodesModifiedEvent,
 
     /// \internal
     /// not to be used directly
@@ -574,7 +652,7 @@ public:
 
     StartImportEvent = StateEvent | StartEvent | ImportState,
     EndImportEvent = StateEvent | EndEvent | ImportState,
-    ProgressImportEvent = StateEvent | EndEvent | ImportState,
+    ProgressImportEvent = StateEvent | ProgressEvent | ImportState,
 
     StartRestoreEvent = StateEvent | StartEvent | RestoreState,
     EndRestoreEvent = StateEvent | EndEvent | RestoreState,
@@ -583,6 +661,10 @@ public:
     StartSaveEvent = StateEvent | StartEvent | SaveState,
     EndSaveEvent = StateEvent | EndEvent | SaveState,
     ProgressSaveEvent = StateEvent | ProgressEvent | SaveState,
+
+    StartReadDataEvent = StateEvent | StartEvent | ReadDataState,
+    EndReadDataEvent = StateEvent | EndEvent | ReadDataState,
+    ProgressReadDataEvent = StateEvent | ProgressEvent | ReadDataState,
     };
 
   /// The version of the last loaded scene file.
@@ -691,6 +773,19 @@ protected:
 
   std::vector<unsigned long> States;
 
+  /// 1 between StartModify() and EndModify(), 0 otherwise. Nested calls
+  /// restore the state returned by StartModify() instead of counting.
+  int ModifyingNodes;
+  /// Number of scene modified events queued since StartModify()
+  int ModifiedEventPending;
+  /// Nodes whose modified events are queued until EndModify(), with their
+  /// DisableModifiedEvent state to restore.
+  std::map<vtkMRMLNode*, int> NodesModifyStates;
+  /// Nodes added since StartModify() whose NodeAddedEvent is not invoked yet
+  std::vector<vtkSmartPointer<vtkMRMLNode> > NodesAddedWhileModifying;
+  /// Nodes removed since StartModify() whose references are not updated yet
+  std::vector<vtkSmartPointer<vtkMRMLNode> > NodesRemovedWhileModifying;
+
   int  UndoStackSize;
   bool UndoFlag;
   bool InUndo;
@@ -773,4 +868,11 @@ bool vtkMRMLScene::IsRestoring()const
          == vtkMRMLScene::RestoreState;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLScene::IsReadingData()const
+{
+  return (this->GetStates() & vtkMRMLScene::ReadDataState)
+         == vtkMRMLScene::ReadDataState;
+}
+
 #endif
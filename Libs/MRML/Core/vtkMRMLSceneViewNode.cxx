@@ -22,15 +22,243 @@ Version:   $Revision: 1.14 $
 #include <vtksys/SystemTools.hxx>
 
 // VTK includes
+#include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
 #include <vtkImageData.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
 #include <cassert>
+#include <cstring>
+#include <map>
+#include <set>
 #include <sstream>
 #include <stack>
+#include <vector>
+
+//----------------------------------------------------------------------------
+namespace
+{
+
+/// Copy of the state of a scene node, shared by all the scene views storing
+/// that state. Shared copies have no scene and are never modified.
+/// SceneNodeMTime is the modification time the scene node had when it was
+/// copied or restored: as long as the node keeps it, its state is the one
+/// of the copy. SceneNodeState are the attributes of the storage nodes,
+/// see GetNodeState().
+struct SharedNodeCopy
+{
+  SharedNodeCopy() : SceneNodeMTime(0) {}
+  vtkSmartPointer<vtkMRMLNode> Copy;
+  vtkWeakPointer<vtkMRMLNode> SceneNode;
+  unsigned long SceneNodeMTime;
+  std::string SceneNodeState;
+};
+typedef std::map<std::string, SharedNodeCopy> SharedNodeCopiesType;
+
+/// Last copy of each node of the scenes, indexed by node ID.
+std::map<vtkMRMLScene*, SharedNodeCopiesType> SharedNodeCopies;
+
+//----------------------------------------------------------------------------
+void SharedNodeCopiesCallback(vtkObject* caller, unsigned long eid,
+                              void* vtkNotUsed(clientData), void* vtkNotUsed(callData))
+{
+  std::map<vtkMRMLScene*, SharedNodeCopiesType>::iterator it =
+    SharedNodeCopies.find(static_cast<vtkMRMLScene*>(caller));
+  if (it == SharedNodeCopies.end())
+    {
+    return;
+    }
+  if (eid == vtkCommand::DeleteEvent)
+    {
+    SharedNodeCopies.erase(it);
+    }
+  else
+    {
+    // the nodes of the closed scene are gone
+    it->second.clear();
+    }
+}
+
+//----------------------------------------------------------------------------
+SharedNodeCopiesType& GetSharedNodeCopies(vtkMRMLScene* scene)
+{
+  std::map<vtkMRMLScene*, SharedNodeCopiesType>::iterator it =
+    SharedNodeCopies.find(scene);
+  if (it != SharedNodeCopies.end())
+    {
+    return it->second;
+    }
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(SharedNodeCopiesCallback);
+  scene->AddObserver(vtkCommand::DeleteEvent, callback.GetPointer());
+  scene->AddObserver(vtkMRMLScene::EndCloseEvent, callback.GetPointer());
+  return SharedNodeCopies[scene];
+}
+
+//----------------------------------------------------------------------------
+/// Return the attributes of \a node as written in the scene file if it is a
+/// storage node, an empty string otherwise. They catch the modifications of
+/// the file names that don't change the modification time of the node
+/// (e.g. vtkMRMLStorageNode::AddFileName()). The other nodes are compared by
+/// modification time only, they are not written on each store or restore.
+std::string GetNodeState(vtkMRMLNode* node)
+{
+  if (!node->IsA("vtkMRMLStorageNode"))
+    {
+    return std::string();
+    }
+  std::stringstream state;
+  node->WriteXML(state, 0);
+  return state.str();
+}
+
+//----------------------------------------------------------------------------
+/// Return the shared copy of \a sceneNode if the node has not been modified
+/// since it was copied or restored, 0 otherwise.
+vtkMRMLNode* GetUnmodifiedNodeCopy(SharedNodeCopiesType& copies, vtkMRMLNode* sceneNode)
+{
+  if (!sceneNode->GetID() ||
+      sceneNode->GetModifiedEventPending() > 0)
+    {
+    return 0;
+    }
+  SharedNodeCopiesType::iterator it = copies.find(sceneNode->GetID());
+  if (it == copies.end() ||
+      it->second.SceneNode.GetPointer() != sceneNode ||
+      it->second.SceneNodeMTime != sceneNode->GetMTime())
+    {
+    return 0;
+    }
+  // The state is only written when the modification times match.
+  // vtkMRMLStorageNode::WriteXML() makes relative file names absolute, which
+  // modifies the node: its modification time is checked again afterward.
+  if (it->second.SceneNodeState != GetNodeState(sceneNode) ||
+      it->second.SceneNodeMTime != sceneNode->GetMTime())
+    {
+    return 0;
+    }
+  return it->second.Copy;
+}
+
+//----------------------------------------------------------------------------
+/// Share \a copy, the current state of \a sceneNode, with the next scene
+/// views. Only the copies without scene can be shared, the others belong to
+/// a scene view that may modify them.
+void SetNodeCopy(SharedNodeCopiesType& copies, vtkMRMLNode* sceneNode, vtkMRMLNode* copy)
+{
+  if (!sceneNode->GetID())
+    {
+    return;
+    }
+  if (copy->GetScene() != 0)
+    {
+    copies.erase(sceneNode->GetID());
+    return;
+    }
+  SharedNodeCopy& sharedCopy = copies[sceneNode->GetID()];
+  sharedCopy.Copy = copy;
+  sharedCopy.SceneNode = sceneNode;
+  sharedCopy.SceneNodeState = GetNodeState(sceneNode);
+  sharedCopy.SceneNodeMTime = sceneNode->GetMTime();
+}
+
+//----------------------------------------------------------------------------
+/// Return a new copy of \a node, without scene.
+vtkMRMLNode* CopyStoredNode(vtkMRMLNode* node)
+{
+  vtkMRMLNode* copy = node->CreateNodeInstance();
+  copy->CopyWithoutModifiedEvent(node);
+  copy->SetID(node->GetID());
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+/// Replace the shared copies of \a snapshotScene (the nodes without scene)
+/// by copies of its own. It must be done before the stored nodes are
+/// modified, their references resolved or given to the caller. Only the
+/// shared copies of class \a className (if any) and in \a selectedNodes
+/// (if any) are replaced.
+void CopySharedNodes(vtkMRMLScene* snapshotScene, const char* className = 0,
+                     const std::set<vtkMRMLNode*>* selectedNodes = 0)
+{
+  std::vector<vtkSmartPointer<vtkMRMLNode> > storedNodes;
+  std::vector<bool> copy;
+  bool sharedNodes = false;
+  vtkCollectionSimpleIterator it;
+  vtkMRMLNode* node = 0;
+  vtkCollection* nodes = snapshotScene->GetNodes();
+  for (nodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+    {
+    bool copyNode = node->GetScene() == 0 &&
+      (!className || node->IsA(className)) &&
+      (!selectedNodes || selectedNodes->count(node));
+    storedNodes.push_back(node);
+    copy.push_back(copyNode);
+    sharedNodes = sharedNodes || copyNode;
+    }
+  if (!sharedNodes)
+    {
+    return;
+    }
+
+  // keep the order of the nodes
+  std::vector<vtkMRMLNode*> copiedNodes;
+  nodes->RemoveAllItems();
+  for (size_t i = 0; i < storedNodes.size(); ++i)
+    {
+    if (copy[i])
+      {
+      storedNodes[i].TakeReference(CopyStoredNode(storedNodes[i]));
+      copiedNodes.push_back(storedNodes[i]);
+      }
+    nodes->vtkCollection::AddItem(storedNodes[i]);
+    snapshotScene->AddNodeID(storedNodes[i]);
+    }
+  // the scene is set once all the copies are in to resolve their references
+  for (size_t i = 0; i < copiedNodes.size(); ++i)
+    {
+    copiedNodes[i]->SetScene(snapshotScene);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Return true if \a storageNode has the file names of \a sceneStorageNode,
+/// as set by vtkMRMLSceneViewNode::SetAbsentStorageFileNames().
+bool HasFileNames(vtkMRMLStorageNode* storageNode, vtkMRMLStorageNode* sceneStorageNode)
+{
+  const char* fileName = storageNode->GetFileName();
+  const char* sceneFileName = sceneStorageNode->GetFileName();
+  if ((fileName == 0) != (sceneFileName == 0) ||
+      (fileName && strcmp(fileName, sceneFileName) != 0))
+    {
+    return false;
+    }
+  int numberOfFileNames = sceneStorageNode->GetNumberOfFileNames();
+  if (numberOfFileNames == 0)
+    {
+    // the file list is left as is
+    return true;
+    }
+  if (storageNode->GetNumberOfFileNames() != numberOfFileNames)
+    {
+    return false;
+    }
+  for (int i = 0; i < numberOfFileNames; ++i)
+    {
+    if (strcmp(storageNode->GetNthFileName(i), sceneStorageNode->GetNthFileName(i)) != 0)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSceneViewNode);
@@ -90,6 +318,16 @@ void vtkMRMLSceneViewNode::WriteNodeBodyXML(ostream& of, int nIndent)
     node = (vtkMRMLNode*)this->SnapshotScene->GetNodes()->GetItemAsObject(n);
     if (node && !node->IsA("vtkMRMLSceneViewNode") && node->GetSaveWithScene())
       {
+      // The nodes shared with other scene views are written as is, but the
+      // storage nodes need a scene to write their file names relative to
+      // its root directory: a temporary copy is written instead.
+      vtkSmartPointer<vtkMRMLNode> sharedStorageNodeCopy;
+      if (node->GetScene() == 0 && node->IsA("vtkMRMLStorageNode"))
+        {
+        sharedStorageNodeCopy.TakeReference(CopyStoredNode(node));
+        sharedStorageNodeCopy->SetScene(this->SnapshotScene);
+        node = sharedStorageNodeCopy;
+        }
       vtkIndent vindent(nIndent+1);
       of << vindent << "<" << node->GetNodeTagName() << "\n";
 
@@ -250,15 +488,25 @@ void vtkMRMLSceneViewNode::Copy(vtkMRMLNode *anode)
   vtkMRMLNode *node = NULL;
   if ( snode->SnapshotScene != NULL )
     {
-    int n;
-    for (n=0; n < snode->SnapshotScene->GetNodes()->GetNumberOfItems(); n++)
+    // share the shared copies, copy the nodes owned by the other scene view
+    std::vector<vtkMRMLNode*> copiedNodes;
+    vtkCollectionSimpleIterator it;
+    vtkCollection* nodes = snode->SnapshotScene->GetNodes();
+    for (nodes->InitTraversal(it);
+         (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
       {
-      node = (vtkMRMLNode*)snode->SnapshotScene->GetNodes()->GetItemAsObject(n);
-      if (node)
+      vtkSmartPointer<vtkMRMLNode> storedNode = node;
+      if (node->GetScene() != 0)
         {
-        node->SetScene(this->SnapshotScene);
-        this->SnapshotScene->AddNodeID(node);
-       }
+        storedNode.TakeReference(CopyStoredNode(node));
+        copiedNodes.push_back(storedNode);
+        }
+      this->SnapshotScene->GetNodes()->vtkCollection::AddItem(storedNode);
+      this->SnapshotScene->AddNodeID(storedNode);
+      }
+    for (size_t i = 0; i < copiedNodes.size(); ++i)
+      {
+      copiedNodes[i]->SetScene(this->SnapshotScene);
       }
     }
 }
@@ -281,6 +529,7 @@ void vtkMRMLSceneViewNode::UpdateScene(vtkMRMLScene *scene)
     }
   if (this->SnapshotScene)
     {
+    CopySharedNodes(this->SnapshotScene);
     // node references are in (this->SavedScene) already, so they should not be modified
     // but there could have been some node ID changes, so get them and update the
     // references accordingly
@@ -304,6 +553,8 @@ void vtkMRMLSceneViewNode::UpdateStoredScene()
     return;
     }
 
+  CopySharedNodes(this->SnapshotScene);
+
   unsigned int nnodesSanpshot = this->SnapshotScene->GetNodes()->GetNumberOfItems();
   unsigned int n;
   vtkMRMLNode *node = NULL;
@@ -399,26 +650,30 @@ void vtkMRMLSceneViewNode::StoreScene()
       }
     }
 
-  /// \todo: GetNumberOfNodes/GetNthNode is slow, fasten by using collection
-  /// iterators.
-  for (int n=0; n < this->Scene->GetNumberOfNodes(); n++)
+  // Nodes not modified since they were last stored or restored share their
+  // copy with the scene views storing them already, only the modified nodes
+  // are copied. The copies are shared without scene, see CopySharedNodes().
+  SharedNodeCopiesType& sharedCopies = GetSharedNodeCopies(this->Scene);
+  vtkCollectionSimpleIterator it;
+  vtkCollection* sceneNodes = this->Scene->GetNodes();
+  vtkMRMLNode *node = NULL;
+  for (sceneNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(sceneNodes->GetNextItemAsObject(it))) ;)
     {
-    vtkMRMLNode *node = this->Scene->GetNthNode(n);
     if (this->IncludeNodeInSceneView(node) &&
         node->GetSaveWithScene() )
       {
-      vtkSmartPointer<vtkMRMLNode> newNode = vtkSmartPointer<vtkMRMLNode>::Take(node->CreateNodeInstance());
-
-      newNode->SetScene(this->SnapshotScene);
-      newNode->CopyWithoutModifiedEvent(node);
-      newNode->SetID(node->GetID());
-
-      newNode->SetAddToSceneNoModify(1);
-      this->SnapshotScene->AddNode(newNode);
-      newNode->SetAddToSceneNoModify(0);
-
+      vtkSmartPointer<vtkMRMLNode> storedNode = GetUnmodifiedNodeCopy(sharedCopies, node);
+      if (!storedNode)
+        {
+        storedNode.TakeReference(CopyStoredNode(node));
+        SetNodeCopy(sharedCopies, node, storedNode);
+        }
       // sanity check
-      assert(newNode->GetScene() == this->SnapshotScene);
+      assert(storedNode->GetScene() == NULL);
+
+      this->SnapshotScene->GetNodes()->vtkCollection::AddItem(storedNode);
+      this->SnapshotScene->AddNodeID(storedNode);
       }
     }
   this->SnapshotScene->CopyNodeReferences(this->GetScene());
@@ -438,6 +693,7 @@ void vtkMRMLSceneViewNode::AddMissingNodes()
     vtkWarningMacro("No scene to add to");
     return;
     }
+
   unsigned int numNodesInSceneView = this->SnapshotScene->GetNodes()->GetNumberOfItems();
   unsigned int n;
   vtkMRMLNode *node = NULL;
@@ -492,6 +748,8 @@ void vtkMRMLSceneViewNode::AddMissingNodes()
   vtkDebugMacro("AddMissingNodes: Added " << nodesAdded << " nodes to this scene view");
   if (nodesAdded > 0)
     {
+    // the shared nodes are copied before their references are resolved
+    CopySharedNodes(this->SnapshotScene);
     // update references for any ids that got changed
     this->SnapshotScene->UpdateNodeReferences();
     }
@@ -511,7 +769,6 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
     return;
     }
 
-  unsigned int numNodesInSceneView = this->SnapshotScene->GetNodes()->GetNumberOfItems();
   unsigned int n;
   vtkMRMLNode *node = NULL;
 
@@ -519,9 +776,11 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
 
   // remove nodes in the scene which are not stored in the snapshot
   std::map<std::string, vtkMRMLNode*> snapshotMap;
-  for (n=0; n<numNodesInSceneView; n++)
+  vtkCollectionSimpleIterator it;
+  vtkCollection* snapshotNodes = this->SnapshotScene->GetNodes();
+  for (snapshotNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(snapshotNodes->GetNextItemAsObject(it))) ;)
     {
-    node  = vtkMRMLNode::SafeDownCast(this->SnapshotScene->GetNodes()->GetItemAsObject(n));
     if (node)
       {
       /***
@@ -542,7 +801,6 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
       }
     }
   // Identify which nodes must be removed from the scene.
-  vtkCollectionSimpleIterator it;
   vtkCollection* sceneNodes = this->Scene->GetNodes();
   // Use smart pointer to ensure the nodes still exist when being removed.
   // Indeed, removing a node can have the side effect of removing other nodes.
@@ -560,6 +818,7 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
       removedNodes.push(vtkSmartPointer<vtkMRMLNode>(node));
       }
     }
+  bool nodesRemoved = !removedNodes.empty();
   while(!removedNodes.empty())
     {
     vtkMRMLNode* nodeToRemove = removedNodes.top().GetPointer();
@@ -588,10 +847,15 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
       }
     }
 
+  // Only the nodes modified since they were stored or restored from the same
+  // copy need to be restored.
+  SharedNodeCopiesType& sharedCopies = GetSharedNodeCopies(this->Scene);
   std::vector<vtkMRMLNode *> addedNodes;
-  for (n=0; n < numNodesInSceneView; n++)
+  std::vector<vtkMRMLNode *> restoredNodes;
+  std::vector<vtkMRMLNode *> restoredNodeCopies;
+  for (snapshotNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(snapshotNodes->GetNextItemAsObject(it))) ;)
     {
-    node = vtkMRMLNode::SafeDownCast(this->SnapshotScene->GetNodes()->GetItemAsObject(n));
     if (node)
       {
       // don't restore certain nodes that might have been in the scene view by mistake
@@ -599,13 +863,19 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
         {
         vtkMRMLNode *snode = this->Scene->GetNodeByID(node->GetID());
 
-        if (snode)
+        if (snode && GetUnmodifiedNodeCopy(sharedCopies, snode) == node)
+          {
+          // already in the stored state
+          }
+        else if (snode)
           {
           snode->SetScene(this->Scene);
           // to prevent copying of default info if not stored in sanpshot
           snode->CopyWithSingleModifiedEvent(node);
           // to prevent reading data on UpdateScene()
           snode->SetAddToSceneNoModify(0);
+          restoredNodes.push_back(snode);
+          restoredNodeCopies.push_back(node);
           }
         else
           {
@@ -614,8 +884,13 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
 
           addedNodes.push_back(newNode);
           newNode->SetAddToSceneNoModify(1);
-          this->Scene->AddNode(newNode);
+          vtkMRMLNode *addedNode = this->Scene->AddNode(newNode);
           newNode->Delete();
+          if (addedNode)
+            {
+            restoredNodes.push_back(addedNode);
+            restoredNodeCopies.push_back(node);
+            }
 
           // to prevent reading data on UpdateScene()
           // but new nodes should read their data
@@ -629,14 +904,33 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
 
   //this->Scene->UpdateNodeReferences(this->Nodes);
 
-  for (sceneNodes->InitTraversal(it);
-       (node = vtkMRMLNode::SafeDownCast(sceneNodes->GetNextItemAsObject(it))) ;)
+  if (nodesRemoved || !addedNodes.empty())
+    {
+    // references to the removed and added nodes must be updated
+    for (sceneNodes->InitTraversal(it);
+         (node = vtkMRMLNode::SafeDownCast(sceneNodes->GetNextItemAsObject(it))) ;)
+      {
+      if (this->IncludeNodeInSceneView(node) && node->GetSaveWithScene())
+        {
+        node->UpdateScene(this->Scene);
+        }
+      }
+    }
+  else
     {
-    if (this->IncludeNodeInSceneView(node) && node->GetSaveWithScene())
+    for (n=0; n<restoredNodes.size(); n++)
       {
-      node->UpdateScene(this->Scene);
+      if (restoredNodes[n]->GetSaveWithScene())
+        {
+        restoredNodes[n]->UpdateScene(this->Scene);
+        }
       }
     }
+  // the restored nodes are now in the state of their copy
+  for (n=0; n<restoredNodes.size(); n++)
+    {
+    SetNodeCopy(sharedCopies, restoredNodes[n], restoredNodeCopies[n]);
+    }
 
   //this->Scene->SetIsClosing(0);
   for(n=0; n<addedNodes.size(); n++)
@@ -660,9 +954,26 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
 //----------------------------------------------------------------------------
 vtkMRMLScene* vtkMRMLSceneViewNode::GetStoredScene()
 {
+  if (this->SnapshotScene)
+    {
+    // the caller may modify the stored nodes
+    CopySharedNodes(this->SnapshotScene);
+    }
   return this->SnapshotScene;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLSceneViewNode::GetNumberOfStoredNodes()
+{
+  return this->SnapshotScene ? this->SnapshotScene->GetNumberOfNodes() : 0;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSceneViewNode::GetNthStoredNode(int n)
+{
+  return this->SnapshotScene ? this->SnapshotScene->GetNthNode(n) : 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSceneViewNode::SetAbsentStorageFileNames()
 {
@@ -676,16 +987,37 @@ void vtkMRMLSceneViewNode::SetAbsentStorageFileNames()
     return;
     }
 
+  // Only the shared storage nodes whose file names change are copied
+  std::set<vtkMRMLNode*> modifiedSharedNodes;
+  vtkCollectionSimpleIterator it;
+  vtkMRMLNode *node = NULL;
+  vtkCollection* snapshotNodes = this->SnapshotScene->GetNodes();
+  for (snapshotNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(snapshotNodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorageNode *snode = vtkMRMLStorageNode::SafeDownCast(node);
+    vtkMRMLStorageNode *snode1 = snode ?
+      vtkMRMLStorageNode::SafeDownCast(this->Scene->GetNodeByID(snode->GetID())) : 0;
+    if (snode && snode->GetScene() == 0 && snode1 && !HasFileNames(snode, snode1))
+      {
+      modifiedSharedNodes.insert(snode);
+      }
+    }
+  if (!modifiedSharedNodes.empty())
+    {
+    CopySharedNodes(this->SnapshotScene, 0, &modifiedSharedNodes);
+    }
+
   // TBD: determine if storage nodes in the all scene views need unique file names
   // in order to support reading into scene view nodes on xml read.
   unsigned int numNodesInSceneView = this->SnapshotScene->GetNodes()->GetNumberOfItems();
   unsigned int n;
-  vtkMRMLNode *node = NULL;
 
   for (n=0; n<numNodesInSceneView; n++)
     {
     node  = vtkMRMLNode::SafeDownCast(this->SnapshotScene->GetNodes()->GetItemAsObject(n));
-    if (node)
+    // the remaining shared nodes have the file names already
+    if (node && node->GetScene() != 0)
       {
       // for storage nodes replace full path with relative
       vtkMRMLStorageNode *snode = vtkMRMLStorageNode::SafeDownCast(node);
@@ -774,6 +1106,8 @@ int vtkMRMLSceneViewNode::GetNodesByClass(const char *className, std::vector<vtk
     {
     return 0;
     }
+  // the caller may modify the nodes, only those of className are copied
+  CopySharedNodes(this->SnapshotScene, className);
   return this->SnapshotScene->GetNodesByClass(className, nodes);
 }
 
@@ -784,6 +1118,7 @@ vtkCollection* vtkMRMLSceneViewNode::GetNodesByClass(const char *className)
     {
     return NULL;
     }
+  CopySharedNodes(this->SnapshotScene, className);
   return this->SnapshotScene->GetNodesByClass(className);
 }
 
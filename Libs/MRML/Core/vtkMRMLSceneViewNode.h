@@ -65,11 +65,25 @@ class VTK_MRML_EXPORT vtkMRMLSceneViewNode : public vtkMRMLStorableNode
   /// when parsing XML file
   virtual void ProcessChildNode(vtkMRMLNode *node);
 
+  /// Return the stored scene. Its nodes shared with other scene views are
+  /// copied first so that they can be modified. Use GetNthStoredNode() to
+  /// only read the stored nodes.
   /// \sa StoreScene() RestoreScene()
   vtkMRMLScene* GetStoredScene();
 
+  /// Number of nodes stored by the scene view and the nth of them, without
+  /// copying the nodes shared with other scene views: the shared nodes have
+  /// no scene and must not be modified.
+  /// \sa GetStoredScene() GetNodesByClass()
+  int GetNumberOfStoredNodes();
+  vtkMRMLNode* GetNthStoredNode(int n);
+
   ///
   /// Store content of the scene
+  /// The nodes not modified since they were last stored or restored by any
+  /// scene view of the scene are not copied: the stored scenes share the
+  /// same immutable copy of their state, without scene. A scene view copies
+  /// the shared nodes before modifying its stored scene or giving it away.
   /// \sa GetStoredScene() RestoreScene()
   void StoreScene();
 
@@ -83,6 +97,8 @@ class VTK_MRML_EXPORT vtkMRMLSceneViewNode : public vtkMRMLStorableNode
   /// do no appear in the scene view. If it is false, and nodes are found that will be
   /// deleted, don't remove them, print a warning, set the scene error code to 1, save
   /// the warning to the scene error message, and return.
+  /// Only the nodes modified since they were stored or restored from the same
+  /// copy are restored.
   /// \sa GetStoredScene() StoreScene() AddMissingNodes()
   void RestoreScene(bool removeNodes = true);
 
@@ -112,6 +128,8 @@ class VTK_MRML_EXPORT vtkMRMLSceneViewNode : public vtkMRMLStorableNode
   virtual vtkMRMLStorageNode* CreateDefaultStorageNode();
 
   /// Get vector of nodes of a specified class in the scene.
+  /// The stored nodes of that class shared with other scene views are
+  /// copied first so that they can be modified.
   /// Returns 0 on failure, number of nodes on success.
   /// \sa vtkMRMLScene;:GetNodesByClass
   int GetNodesByClass(const char *className, std::vector<vtkMRMLNode *> &nodes);
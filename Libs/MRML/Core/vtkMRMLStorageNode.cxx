@@ -20,6 +20,9 @@ Version:   $Revision: 1.1.1.1 $
 #include "vtkMRMLStorageNode.h"
 #include "vtkMRMLScene.h"
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkCommand.h>
 #include <vtkStringArray.h>
@@ -1069,6 +1072,7 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
   vtkDebugMacro("ReadData: read state is ready, "
     <<  "URI = " << (this->GetURI() == NULL ? "null" : this->GetURI()) << ", "
     << "filename = " << (this->GetFileName() == NULL ? "null" : this->GetFileName()));
+  vtkTraceZoneWithDetailMacro("ReadData", this->GetClassName(), this->GetFileName());
   int res = this->ReadDataInternal(refNode);
   if (res)
     {
@@ -1101,6 +1105,7 @@ int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
     return 0;
     }
 
+  vtkTraceZoneWithDetailMacro("WriteData", this->GetClassName(), this->GetFileName());
   int res = this->WriteDataInternal(refNode);
 
   if (res)
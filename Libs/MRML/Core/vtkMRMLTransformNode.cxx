@@ -31,17 +31,177 @@ Version:   $Revision: 1.14 $
 #include <vtkGeneralTransform.h>
 #include <vtkImageData.h>
 #include <vtkLinearTransform.h>
+#include <vtkMatrix4x4.h>
 #include <vtkHomogeneousTransform.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPerspectiveTransform.h>
 #include <vtkPoints.h>
+#include <vtkSmartPointer.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 #include <stack>
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Component of a compiled transform. Linear components store the top three
+// rows of their matrix, other components are evaluated by the transform.
+struct CompiledTransformComponent
+{
+  vtkAbstractTransform* Transform;
+  double Matrix[3][4];
+};
+
+//----------------------------------------------------------------------------
+struct TransformPointsThreadInfo
+{
+  std::vector<CompiledTransformComponent> Components;
+  double* Points;
+  vtkIdType NumberOfPoints;
+};
+
+// Points are transformed in blocks so that each component
+// runs a tight loop on coordinates that are still in the cache
+const vtkIdType TRANSFORM_POINTS_BLOCK_SIZE = 1024;
+
+//----------------------------------------------------------------------------
+void TransformPointsBlock(const std::vector<CompiledTransformComponent>& components,
+                          double* points, vtkIdType numberOfPoints)
+{
+  for (std::vector<CompiledTransformComponent>::const_iterator it = components.begin();
+       it != components.end(); ++it)
+    {
+    if (it->Transform)
+      {
+      double* point = points;
+      for (vtkIdType i = 0; i < numberOfPoints; ++i, point += 3)
+        {
+        it->Transform->InternalTransformPoint(point, point);
+        }
+      continue;
+      }
+    const double (*m)[4] = it->Matrix;
+    double* point = points;
+    for (vtkIdType i = 0; i < numberOfPoints; ++i, point += 3)
+      {
+      double x = point[0];
+      double y = point[1];
+      double z = point[2];
+      point[0] = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+      point[1] = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+      point[2] = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE TransformPointsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  TransformPointsThreadInfo* info = static_cast<TransformPointsThreadInfo*>(threadInfo->UserData);
+  vtkIdType numberOfBlocks =
+    (info->NumberOfPoints + TRANSFORM_POINTS_BLOCK_SIZE - 1) / TRANSFORM_POINTS_BLOCK_SIZE;
+  for (vtkIdType block = threadInfo->ThreadID; block < numberOfBlocks; block += threadInfo->NumberOfThreads)
+    {
+    vtkIdType firstPoint = block * TRANSFORM_POINTS_BLOCK_SIZE;
+    vtkIdType numberOfPoints = std::min(TRANSFORM_POINTS_BLOCK_SIZE, info->NumberOfPoints - firstPoint);
+    TransformPointsBlock(info->Components, info->Points + 3 * firstPoint, numberOfPoints);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Matrices can be merged only if their bottom row is (0,0,0,1), the
+// perspective division would be lost otherwise.
+bool IsAffineMatrix(vtkMatrix4x4* matrix)
+{
+  return matrix->GetElement(3, 0) == 0.0 && matrix->GetElement(3, 1) == 0.0
+    && matrix->GetElement(3, 2) == 0.0 && matrix->GetElement(3, 3) == 1.0;
+}
+
+//----------------------------------------------------------------------------
+// Get the matrix of a homogeneous transform that can be merged with other
+// affine matrices. Linear transforms ignore the bottom row of their matrix,
+// so it is reset. Return false for a perspective transform.
+bool GetAffineMatrix(vtkHomogeneousTransform* transform, vtkMatrix4x4* matrix)
+{
+  matrix->DeepCopy(transform->GetMatrix());
+  if (vtkLinearTransform::SafeDownCast(transform))
+    {
+    matrix->SetElement(3, 0, 0.0);
+    matrix->SetElement(3, 1, 0.0);
+    matrix->SetElement(3, 2, 0.0);
+    matrix->SetElement(3, 3, 1.0);
+    }
+  return IsAffineMatrix(matrix);
+}
+
+//----------------------------------------------------------------------------
+// Return a new transform equivalent to inputTransform, with consecutive
+// affine components merged into a single matrix. The other components are
+// deep copies: the result does not change when the input transforms are
+// modified, and it can be evaluated while they are being updated.
+vtkGeneralTransform* CompileTransform(vtkAbstractTransform* inputTransform)
+{
+  vtkNew<vtkCollection> transformList;
+  vtkMRMLTransformNode::FlattenGeneralTransform(transformList.GetPointer(), inputTransform);
+
+  vtkGeneralTransform* compiledTransform = vtkGeneralTransform::New();
+  compiledTransform->PostMultiply();
+  vtkSmartPointer<vtkTransform> linearComponent;
+  vtkNew<vtkMatrix4x4> matrix;
+  vtkCollectionSimpleIterator it;
+  vtkAbstractTransform* transform = NULL;
+  for (transformList->InitTraversal(it); (transform = vtkAbstractTransform::SafeDownCast(transformList->GetNextItemAsObject(it))) ;)
+    {
+    transform->Update();
+    vtkHomogeneousTransform* homogeneousTransform = vtkHomogeneousTransform::SafeDownCast(transform);
+    if (homogeneousTransform && GetAffineMatrix(homogeneousTransform, matrix.GetPointer()))
+      {
+      if (linearComponent.GetPointer() == NULL)
+        {
+        linearComponent = vtkSmartPointer<vtkTransform>::New();
+        linearComponent->PostMultiply();
+        }
+      linearComponent->Concatenate(matrix.GetPointer());
+      continue;
+      }
+    if (linearComponent.GetPointer() != NULL)
+      {
+      compiledTransform->Concatenate(linearComponent.GetPointer());
+      linearComponent = NULL;
+      }
+    if (homogeneousTransform)
+      {
+      // Perspective transform, the copy does not depend on an input matrix
+      vtkNew<vtkPerspectiveTransform> perspectiveTransform;
+      perspectiveTransform->SetMatrix(homogeneousTransform->GetMatrix());
+      compiledTransform->Concatenate(perspectiveTransform.GetPointer());
+      continue;
+      }
+    vtkAbstractTransform* transformCopy = transform->MakeTransform();
+    transformCopy->DeepCopy(transform);
+    transformCopy->Update();
+    compiledTransform->Concatenate(transformCopy);
+    transformCopy->Delete();
+    }
+  if (linearComponent.GetPointer() != NULL)
+    {
+    compiledTransform->Concatenate(linearComponent.GetPointer());
+    }
+  compiledTransform->Update();
+  return compiledTransform;
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLTransformNode);
 
@@ -54,6 +214,10 @@ vtkMRMLTransformNode::vtkMRMLTransformNode()
 
   this->CachedMatrixTransformToParent=vtkMatrix4x4::New();
   this->CachedMatrixTransformFromParent=vtkMatrix4x4::New();
+
+  this->CompiledTransformToWorld=NULL;
+  this->CompiledTransformFromWorld=NULL;
+  this->CompiledTransformToWorldMTime=0;
 }
 
 //----------------------------------------------------------------------------
@@ -66,6 +230,17 @@ vtkMRMLTransformNode::~vtkMRMLTransformNode()
   this->CachedMatrixTransformToParent=NULL;
   this->CachedMatrixTransformFromParent->Delete();
   this->CachedMatrixTransformFromParent=NULL;
+
+  if (this->CompiledTransformToWorld)
+    {
+    this->CompiledTransformToWorld->Delete();
+    this->CompiledTransformToWorld=NULL;
+    }
+  if (this->CompiledTransformFromWorld)
+    {
+    this->CompiledTransformFromWorld->Delete();
+    this->CompiledTransformFromWorld=NULL;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -408,6 +583,141 @@ void vtkMRMLTransformNode::GetTransformToWorld(vtkGeneralTransform* transformToW
     }
 }
 
+//----------------------------------------------------------------------------
+vtkGeneralTransform* vtkMRMLTransformNode::GetCompiledTransformToWorld()
+{
+  this->UpdateCompiledTransforms();
+  return this->CompiledTransformToWorld;
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLTransformNode::GetCompiledTransformFromWorld()
+{
+  this->UpdateCompiledTransforms();
+  return this->CompiledTransformFromWorld;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::UpdateCompiledTransforms()
+{
+  // The cache is up-to-date if none of the transforms up to the world
+  // have been modified or replaced since it was built.
+  std::vector<vtkAbstractTransform*> chain;
+  for (vtkMRMLTransformNode* node = this; node != NULL; node = node->GetParentTransformNode())
+    {
+    chain.push_back(node->GetTransformToParent());
+    }
+  unsigned long transformToWorldMTime = this->GetTransformToWorldMTime();
+  if (this->CompiledTransformToWorld != NULL
+    && this->CompiledTransformToWorldMTime == transformToWorldMTime
+    && this->CompiledTransformToWorldChain == chain)
+    {
+    return;
+    }
+
+  // New transforms are built instead of updating the previous ones in place:
+  // pipelines that concatenated them (e.g. reslicing in other threads) keep
+  // evaluating a consistent transform until they get the new one.
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  this->GetTransformToWorld(transformToWorld.GetPointer());
+  vtkNew<vtkGeneralTransform> transformFromWorld;
+  this->GetTransformFromWorld(transformFromWorld.GetPointer());
+  if (this->CompiledTransformToWorld != NULL)
+    {
+    this->CompiledTransformToWorld->Delete();
+    }
+  if (this->CompiledTransformFromWorld != NULL)
+    {
+    this->CompiledTransformFromWorld->Delete();
+    }
+  this->CompiledTransformToWorld = CompileTransform(transformToWorld.GetPointer());
+  this->CompiledTransformFromWorld = CompileTransform(transformFromWorld.GetPointer());
+
+  this->CompiledTransformToWorldMTime = transformToWorldMTime;
+  this->CompiledTransformToWorldChain = chain;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::TransformPointsToWorld(vtkPoints* inputPoints, vtkPoints* outputPoints)
+{
+  if (inputPoints==NULL || outputPoints==NULL)
+    {
+    vtkErrorMacro("vtkMRMLTransformNode::TransformPointsToWorld failed: invalid input or output points");
+    return;
+    }
+
+  // Copy the input coordinates to the output, which is then transformed in place
+  vtkIdType numberOfPoints = inputPoints->GetNumberOfPoints();
+  vtkSmartPointer<vtkPoints> sourcePoints = inputPoints;
+  if (inputPoints == outputPoints && inputPoints->GetDataType() != VTK_DOUBLE)
+    {
+    sourcePoints = vtkSmartPointer<vtkPoints>::New();
+    sourcePoints->DeepCopy(inputPoints);
+    }
+  if (outputPoints->GetDataType() != VTK_DOUBLE)
+    {
+    outputPoints->SetDataTypeToDouble();
+    }
+  outputPoints->SetNumberOfPoints(numberOfPoints);
+  if (numberOfPoints == 0)
+    {
+    return;
+    }
+  double* points = static_cast<double*>(outputPoints->GetVoidPointer(0));
+  if (sourcePoints.GetPointer() != outputPoints)
+    {
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+      {
+      sourcePoints->GetPoint(i, points + 3 * i);
+      }
+    }
+
+  TransformPointsThreadInfo info;
+  info.Points = points;
+  info.NumberOfPoints = numberOfPoints;
+  vtkGeneralTransform* compiledTransform = this->GetCompiledTransformToWorld();
+  int numberOfComponents = compiledTransform->GetNumberOfConcatenatedTransforms();
+  for (int i = 0; i < numberOfComponents; ++i)
+    {
+    CompiledTransformComponent component;
+    component.Transform = compiledTransform->GetConcatenatedTransform(i);
+    vtkLinearTransform* linearTransform = vtkLinearTransform::SafeDownCast(component.Transform);
+    if (linearTransform)
+      {
+      vtkMatrix4x4* matrix = linearTransform->GetMatrix();
+      for (int row = 0; row < 3; ++row)
+        {
+        for (int column = 0; column < 4; ++column)
+          {
+          component.Matrix[row][column] = matrix->GetElement(row, column);
+          }
+        }
+      component.Transform = NULL;
+      }
+    info.Components.push_back(component);
+    }
+  if (info.Components.empty())
+    {
+    outputPoints->Modified();
+    return;
+    }
+
+  vtkIdType numberOfBlocks = (numberOfPoints + TRANSFORM_POINTS_BLOCK_SIZE - 1) / TRANSFORM_POINTS_BLOCK_SIZE;
+  if (numberOfBlocks == 1)
+    {
+    TransformPointsBlock(info.Components, points, numberOfPoints);
+    }
+  else
+    {
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(static_cast<int>(
+      std::min(static_cast<vtkIdType>(threader->GetNumberOfThreads()), numberOfBlocks)));
+    threader->SetSingleMethod(TransformPointsThreadFunction, &info);
+    threader->SingleMethodExecute();
+    }
+  outputPoints->Modified();
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLTransformNode::GetTransformFromWorld(vtkGeneralTransform* transformFromWorld)
 {
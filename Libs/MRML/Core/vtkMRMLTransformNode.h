@@ -21,8 +21,12 @@ class vtkCollection;
 class vtkAbstractTransform;
 class vtkGeneralTransform;
 class vtkMatrix4x4;
+class vtkPoints;
 class vtkTransform;
 
+// STD includes
+#include <vector>
+
 /// \brief MRML node for representing a transformation
 /// between this node space and a parent node space.
 ///
@@ -122,6 +126,35 @@ public:
   /// Get concatenated transforms to the top
   void GetTransformToWorld(vtkGeneralTransform* transformToWorld);
 
+  ///
+  /// Get concatenated transforms to the top, with consecutive linear components
+  /// merged into a single matrix.
+  /// The returned transform is cached by the node and it is only rebuilt when
+  /// GetTransformToWorldMTime() or the parent transform nodes change, therefore
+  /// it is much cheaper than GetTransformToWorld() for repeated use.
+  /// The returned transform is a snapshot: its non-linear components are
+  /// copies, and it is never modified. A new transform is built when the
+  /// hierarchy changes, pipelines that concatenate it get it again on
+  /// TransformModifiedEvent.
+  /// The returned transform is owned by the node and must not be modified.
+  vtkGeneralTransform* GetCompiledTransformToWorld();
+
+  ///
+  /// Get the compiled transform from world, built from GetTransformFromWorld()
+  /// with the compiled transform to world. It is used for resampling images
+  /// from world, e.g. by the slice views and the volume resampling.
+  /// The returned transform is owned by the node and must not be modified.
+  vtkAbstractTransform* GetCompiledTransformFromWorld();
+
+  ///
+  /// Transform points from this node's coordinate system to world using the
+  /// compiled transform (see GetCompiledTransformToWorld()).
+  /// Linear components are applied in a single pass over the coordinates,
+  /// the points are split between all available threads.
+  /// inputPoints and outputPoints may be the same object.
+  /// outputPoints are stored in double precision.
+  void TransformPointsToWorld(vtkPoints* inputPoints, vtkPoints* outputPoints);
+
   ///
   /// Get concatenated transforms from the top
   void GetTransformFromWorld(vtkGeneralTransform* transformToWorld);
@@ -335,6 +368,17 @@ protected:
   /// GetMatrixTransformToParent and GetMatrixFromParent methods
   vtkMatrix4x4* CachedMatrixTransformToParent;
   vtkMatrix4x4* CachedMatrixTransformFromParent;
+
+  /// Build the compiled transforms to and from world if the hierarchy changed.
+  void UpdateCompiledTransforms();
+
+  /// Cached transform to world returned by GetCompiledTransformToWorld.
+  /// The cache is valid while the transform MTime and the list of
+  /// transforms to parent up to the world are unchanged.
+  vtkGeneralTransform* CompiledTransformToWorld;
+  vtkGeneralTransform* CompiledTransformFromWorld;
+  unsigned long CompiledTransformToWorldMTime;
+  std::vector<vtkAbstractTransform*> CompiledTransformToWorldChain;
 };
 
 #endif
@@ -37,6 +37,7 @@ vtkMRMLNodeNewMacro(vtkMRMLTransformStorageNode);
 vtkMRMLTransformStorageNode::vtkMRMLTransformStorageNode()
 {
   this->PreferITKv3CompatibleTransforms = 0;
+  this->PrecomputeInverse = 0;
   vtkITKTransformConverter::RegisterInverseTransformTypes();
 }
 
@@ -51,6 +52,7 @@ void vtkMRMLTransformStorageNode::WriteXML(ostream& of, int nIndent)
   Superclass::WriteXML(of, nIndent);
   vtkIndent indent(nIndent);
   of << indent << " preferITKv3CompatibleTransforms=\"" << (this->PreferITKv3CompatibleTransforms ? "true" : "false") << "\"";
+  of << indent << " precomputeInverse=\"" << (this->PrecomputeInverse ? "true" : "false") << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -77,6 +79,17 @@ void vtkMRMLTransformStorageNode::ReadXMLAttributes(const char** atts)
         this->PreferITKv3CompatibleTransforms = 0;
         }
       }
+    else if (!strcmp(attName, "precomputeInverse"))
+      {
+      if (!strcmp(attValue,"true"))
+        {
+        this->PrecomputeInverse = 1;
+        }
+      else
+        {
+        this->PrecomputeInverse = 0;
+        }
+      }
     }
 
   this->EndModify(disabledModify);
@@ -97,6 +110,7 @@ void vtkMRMLTransformStorageNode::Copy(vtkMRMLNode *anode)
   vtkMRMLTransformStorageNode *node = vtkMRMLTransformStorageNode::SafeDownCast(anode);
 
   this->SetPreferITKv3CompatibleTransforms(node->GetPreferITKv3CompatibleTransforms());
+  this->SetPrecomputeInverse(node->GetPrecomputeInverse());
 
   this->EndModify(disabledModify);
 
@@ -108,6 +122,8 @@ void vtkMRMLTransformStorageNode::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
   os << indent << "PreferITKv3CompatibleTransforms: " <<
     (this->PreferITKv3CompatibleTransforms ? "true" : "false") << "\n";
+  os << indent << "PrecomputeInverse: " <<
+    (this->PrecomputeInverse ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -197,6 +213,8 @@ int vtkMRMLTransformStorageNode::ReadFromITKv3BSplineTransformFile(vtkMRMLNode *
     transformNode->SetReadAsTransformToParent(0);
     }
 
+  this->ApplyPrecomputeInverse(bsplineVtk.GetPointer());
+
   SetAndObserveTransformFromParentAutoInvert(transformNode, bsplineVtk.GetPointer());
   return 1;
 }
@@ -258,6 +276,8 @@ int vtkMRMLTransformStorageNode::ReadFromImageFile(vtkMRMLNode *refNode)
     tn->SetReadAsTransformToParent(0);
     }
 
+  this->ApplyPrecomputeInverse(gridTransform_Ras.GetPointer());
+
   SetAndObserveTransformFromParentAutoInvert(tn, gridTransform_Ras.GetPointer());
   return 1;
 }
@@ -384,6 +404,8 @@ int vtkMRMLTransformStorageNode::ReadFromTransformFile(vtkMRMLNode *refNode)
     transformNode->SetReadAsTransformToParent(0);
     }
 
+  this->ApplyPrecomputeInverse(transformVtk.GetPointer());
+
   SetAndObserveTransformFromParentAutoInvert(transformNode, transformVtk.GetPointer());
 
   return 1;
@@ -613,6 +635,28 @@ bool vtkMRMLTransformStorageNode::IsImageFile(const std::string &filename)
   return false;
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLTransformStorageNode::ApplyPrecomputeInverse(vtkAbstractTransform* transform)
+{
+  vtkNew<vtkCollection> sourceTransformList;
+  vtkMRMLTransformNode::FlattenGeneralTransform(sourceTransformList.GetPointer(), transform);
+  vtkCollectionSimpleIterator it;
+  vtkObject* sourceTransform = NULL;
+  for (sourceTransformList->InitTraversal(it); (sourceTransform = sourceTransformList->GetNextItemAsObject(it)) ;)
+    {
+    vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(sourceTransform);
+    if (gridTransform)
+      {
+      gridTransform->SetPrecomputeInverse(this->PrecomputeInverse);
+      }
+    vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(sourceTransform);
+    if (bsplineTransform)
+      {
+      bsplineTransform->SetPrecomputeInverse(this->PrecomputeInverse);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLTransformStorageNode::SetAndObserveTransformFromParentAutoInvert(vtkMRMLTransformNode* transformNode, vtkAbstractTransform *transform)
 {
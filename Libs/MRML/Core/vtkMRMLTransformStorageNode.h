@@ -68,6 +68,16 @@ class VTK_MRML_EXPORT vtkMRMLTransformStorageNode : public vtkMRMLStorageNode
   vtkSetMacro ( PreferITKv3CompatibleTransforms, int );
   vtkBooleanMacro ( PreferITKv3CompatibleTransforms, int );
 
+  ///
+  /// If true then the inverse of displacement field and b-spline transforms that
+  /// are read from file is precomputed on a grid when the transform is first inverted
+  /// (see vtkOrientedGridTransform::SetPrecomputeInverse), which makes transforming
+  /// many points (e.g., models and markups) by the inverse transform faster
+  /// at the cost of a longer update and more memory. Off by default.
+  vtkGetMacro ( PrecomputeInverse, int );
+  vtkSetMacro ( PrecomputeInverse, int );
+  vtkBooleanMacro ( PrecomputeInverse, int );
+
 protected:
   vtkMRMLTransformStorageNode();
   ~vtkMRMLTransformStorageNode();
@@ -87,6 +97,10 @@ protected:
   /// It makes the displayed transform information more intuitive.
   virtual void SetAndObserveTransformFromParentAutoInvert(vtkMRMLTransformNode* transformNode, vtkAbstractTransform *transform);
 
+  /// Set PrecomputeInverse of all the displacement field and b-spline components of the transform
+  /// to the value of PrecomputeInverse in this storage node.
+  void ApplyPrecomputeInverse(vtkAbstractTransform* transform);
+
   /// Read data and set it in the referenced node
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
 
@@ -128,6 +142,7 @@ protected:
 protected:
 
   int PreferITKv3CompatibleTransforms;
+  int PrecomputeInverse;
 };
 
 #endif
@@ -980,11 +980,7 @@ void vtkMRMLVolumeNode::GetRASBounds(double bounds[6])
 
   if ( transformNode )
     {
-    vtkNew<vtkGeneralTransform> worldTransform;
-    worldTransform->Identity();
-    //transformNode->GetTransformFromWorld(worldTransform);
-    transformNode->GetTransformToWorld(worldTransform.GetPointer());
-    transform->Concatenate(worldTransform.GetPointer());
+    transform->Concatenate(transformNode->GetCompiledTransformToWorld());
     }
 
   int dimensions[3];
@@ -3,8 +3,12 @@
 #include "vtkPermissionPrompter.h"
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkObjectFactory.h>
 
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
 vtkStandardNewMacro ( vtkURIHandler );
 vtkCxxSetObjectMacro( vtkURIHandler, PermissionPrompter, vtkPermissionPrompter );
 //----------------------------------------------------------------------------
@@ -111,6 +115,28 @@ void vtkURIHandler::StageFileWrite ( const char * vtkNotUsed( source ), const ch
 {
 }
 
+//----------------------------------------------------------------------------
+void vtkURIHandler::StageFileReads ( const std::vector<std::string>& sources,
+                                     const std::vector<std::string>& destinations )
+{
+  if ( sources.size() != destinations.size() )
+    {
+    vtkErrorMacro ( "StageFileReads: " << sources.size() << " sources for "
+                    << destinations.size() << " destinations" );
+    return;
+    }
+  for ( size_t i = 0; i < sources.size(); ++i )
+    {
+    this->StageFileRead ( sources[i].c_str(), destinations[i].c_str() );
+    int result[2];
+    result[0] = static_cast<int>(i);
+    result[1] = vtksys::SystemTools::FileExists ( destinations[i].c_str() ) ? 1 : 0;
+    this->InvokeEvent ( vtkURIHandler::StageFileReadDoneEvent, result );
+    double progress = static_cast<double>(i + 1) / sources.size();
+    this->InvokeEvent ( vtkCommand::ProgressEvent, &progress );
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkURIHandler::StageFileRead(const char * vtkNotUsed( source ),
                              const char * vtkNotUsed( destination ),
@@ -8,6 +8,10 @@ class vtkPermissionPrompter;
 // VTK includes
 #include <vtkObject.h>
 
+// STD includes
+#include <string>
+#include <vector>
+
 class VTK_MRML_EXPORT vtkURIHandler : public vtkObject
 {
 public:
@@ -42,6 +46,23 @@ public:
 
   /// need something that goes the other way too...
 
+  ///
+  /// Downloads each source into the matching destination and returns
+  /// when all the transfers are over. StageFileReadDoneEvent is invoked
+  /// as soon as a file is transferred, with an int[2] call data holding the
+  /// index of the file and 1 on success or 0 on failure. ProgressEvent is
+  /// invoked with the overall progress (double, from 0 to 1) of the
+  /// transfers. Events are invoked from the calling thread.
+  /// The default implementation calls StageFileRead for each file in turn,
+  /// handlers that can transfer files concurrently reimplement it.
+  virtual void StageFileReads ( const std::vector<std::string>& sources,
+                                const std::vector<std::string>& destinations );
+
+  enum
+    {
+      StageFileReadDoneEvent = 19100
+    };
+
   ///
   /// Determine whether protocol is appropriate for this handler.
   /// NOTE: Subclasses should implement this method
@@ -35,15 +35,18 @@
 // VTK includes
 #include <vtkCamera.h>
 #include <vtkErrorCode.h>
+#include <vtkIdList.h>
 #include <vtkImageData.h>
 #include <vtkInteractorEventRecorder.h>
 #include <vtkNew.h>
 #include <vtkPNGWriter.h>
+#include <vtkPoints.h>
 #include <vtkRegressionTestImage.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSphereSource.h>
+#include <vtkStringArray.h>
 #include <vtkWindowToImageFilter.h>
 
 // STD includes
@@ -143,6 +146,34 @@ int vtkMRMLModelDisplayableManagerTest(int argc, char* argv[])
       }
     }
 
+  // Picking near the center of the view hits the front then the back of the sphere
+  renderWindow->Render();
+  if (!vrDisplayableManager->Pick(310, 295) ||
+      strcmp(vrDisplayableManager->GetPickedNodeID(), modelDisplayNode->GetID()) != 0 ||
+      vrDisplayableManager->GetPickedCellID() < 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Pick failed to find the model" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkStringArray> pickedNodeIDs;
+  vtkNew<vtkPoints> pickedPoints;
+  vtkNew<vtkIdList> pickedCellIDs;
+  if (vrDisplayableManager->PickAll(310, 295, pickedNodeIDs.GetPointer(),
+        pickedPoints.GetPointer(), pickedCellIDs.GetPointer()) != 2 ||
+      pickedNodeIDs->GetValue(0) != modelDisplayNode->GetID() ||
+      pickedCellIDs->GetId(0) != vrDisplayableManager->GetPickedCellID())
+    {
+    std::cerr << "Line " << __LINE__ << " - PickAll failed: "
+              << pickedNodeIDs->GetNumberOfValues() << " hits" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (vrDisplayableManager->GetNumberOfPicks() != 2 ||
+      vrDisplayableManager->GetMaximumPickTime() < vrDisplayableManager->GetLastPickTime())
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong pick statistics" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   int retval = vtkRegressionTestImageThreshold(renderWindow.GetPointer(), 85.0);
   if ( record || retval == vtkRegressionTester::DO_INTERACTOR)
     {
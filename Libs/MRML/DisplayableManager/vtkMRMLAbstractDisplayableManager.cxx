@@ -31,6 +31,9 @@
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkInteractorStyle.h>
@@ -851,6 +854,7 @@ void vtkMRMLAbstractDisplayableManager::RequestRender()
 
   if (this->Internal->UpdateFromMRMLRequested)
     {
+    vtkTraceZoneMacro(this->GetClassName(), "UpdateFromMRML");
     this->UpdateFromMRML();
     }
 
@@ -46,34 +46,58 @@
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkImageMapper3D.h>
+#include <vtkIdList.h>
 #include <vtkImplicitBoolean.h>
 #include <vtkLookupTable.h>
+#include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlane.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataMapper.h>
+#include <vtkPoints.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkTimerLog.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkVersion.h>
 #include <vtkWeakPointer.h>
 
 // for picking
 #include <vtkCellPicker.h>
+#include <vtkModifiedBSPTree.h>
 #include <vtkPointPicker.h>
 #include <vtkPropPicker.h>
 #include <vtkRendererCollection.h>
 #include <vtkWorldPointPicker.h>
 
 // STD includes
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro (vtkMRMLModelDisplayableManager );
 
+namespace
+{
+
+//---------------------------------------------------------------------------
+/// Intersection of the pick ray with a model, ordered by distance to the camera
+struct PickHit
+{
+  double Distance2;
+  double Position[3];
+  vtkIdType CellID;
+  const std::string* NodeID;
+  bool operator<(const PickHit& other) const { return this->Distance2 < other.Distance2; }
+};
+
+} // end of anonymous namespace
+
 //---------------------------------------------------------------------------
 class vtkMRMLModelDisplayableManager::vtkInternal
 {
@@ -86,6 +110,13 @@ public:
   /// Reset all the pick vars
   void ResetPick();
 
+  /// Build or reuse the pick locator of each pickable model actor and
+  /// register them to the cell picker.
+  void UpdatePickLocators();
+
+  /// Record the duration of a pick in the pick statistics.
+  void AddPickTime(double time);
+
   std::map<std::string, vtkProp3D *>               DisplayedActors;
   std::map<std::string, vtkMRMLDisplayNode *>      DisplayedNodes;
   std::map<std::string, int>                       DisplayedClipState;
@@ -118,6 +149,25 @@ public:
   vtkSmartPointer<vtkCellPicker>       CellPicker;
   vtkSmartPointer<vtkPointPicker>      PointPicker;
 
+  /// Cell locator of a displayed model, rebuilt only when the polydata
+  /// rendered by the actor is replaced or modified.
+  struct PickLocator
+    {
+    PickLocator() : PolyData(0), PolyDataMTime(0) {}
+    vtkSmartPointer<vtkModifiedBSPTree> Locator;
+    vtkPolyData* PolyData;
+    unsigned long PolyDataMTime;
+    };
+  /// Pick locators indexed by display node ID
+  std::map<std::string, PickLocator> PickLocators;
+
+  /// Pick latency statistics, in seconds
+  vtkSmartPointer<vtkTimerLog> PickTimer;
+  int          NumberOfPicks;
+  double       LastPickTime;
+  double       TotalPickTime;
+  double       MaximumPickTime;
+
   /// Information about a pick event
   std::string  PickedNodeID;
   double       PickedRAS[3];
@@ -150,6 +200,12 @@ vtkMRMLModelDisplayableManager::vtkInternal::vtkInternal()
   this->CellPicker->SetTolerance(0.00001);
   this->PointPicker = vtkSmartPointer<vtkPointPicker>::New();
   this->ResetPick();
+
+  this->PickTimer = vtkSmartPointer<vtkTimerLog>::New();
+  this->NumberOfPicks = 0;
+  this->LastPickTime = 0.;
+  this->TotalPickTime = 0.;
+  this->MaximumPickTime = 0.;
 }
 
 //---------------------------------------------------------------------------
@@ -188,6 +244,59 @@ void vtkMRMLModelDisplayableManager::vtkInternal::ResetPick()
   this->PickedPointID = -1;
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLModelDisplayableManager::vtkInternal::UpdatePickLocators()
+{
+  this->CellPicker->RemoveAllLocators();
+
+  std::map<std::string, PickLocator> pickLocators;
+  std::map<std::string, vtkProp3D *>::iterator actorIt;
+  for (actorIt = this->DisplayedActors.begin(); actorIt != this->DisplayedActors.end(); ++actorIt)
+    {
+    vtkActor* actor = vtkActor::SafeDownCast(actorIt->second);
+    if (!actor || !actor->GetVisibility() || !actor->GetPickable())
+      {
+      continue;
+      }
+    vtkPolyDataMapper* mapper = vtkPolyDataMapper::SafeDownCast(actor->GetMapper());
+    vtkPolyData* polyData = mapper ? mapper->GetInput() : 0;
+    if (!polyData || polyData->GetNumberOfCells() == 0)
+      {
+      continue;
+      }
+    // Reuse the locator if the polydata did not change since it was built
+    PickLocator pickLocator;
+    std::map<std::string, PickLocator>::iterator locatorIt = this->PickLocators.find(actorIt->first);
+    if (locatorIt != this->PickLocators.end())
+      {
+      pickLocator = locatorIt->second;
+      }
+    if (pickLocator.Locator.GetPointer() == 0 ||
+        pickLocator.PolyData != polyData ||
+        pickLocator.PolyDataMTime != polyData->GetMTime())
+      {
+      pickLocator.Locator = vtkSmartPointer<vtkModifiedBSPTree>::New();
+      pickLocator.Locator->SetDataSet(polyData);
+      pickLocator.Locator->BuildLocator();
+      pickLocator.PolyData = polyData;
+      pickLocator.PolyDataMTime = polyData->GetMTime();
+      }
+    this->CellPicker->AddLocator(pickLocator.Locator);
+    pickLocators[actorIt->first] = pickLocator;
+    }
+  // Locators of models that are no longer displayed are released
+  this->PickLocators.swap(pickLocators);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLModelDisplayableManager::vtkInternal::AddPickTime(double time)
+{
+  ++this->NumberOfPicks;
+  this->LastPickTime = time;
+  this->TotalPickTime += time;
+  this->MaximumPickTime = std::max(this->MaximumPickTime, time);
+}
+
 //---------------------------------------------------------------------------
 // vtkMRMLModelDisplayableManager methods
 
@@ -250,6 +359,10 @@ void vtkMRMLModelDisplayableManager::PrintSelf ( ostream& os, vtkIndent indent )
       << this->Internal->PickedRAS[1] << ", "<< this->Internal->PickedRAS[2] << ")\n";
   os << indent << "PickedCellID = " << this->Internal->PickedCellID << "\n";
   os << indent << "PickedPointID = " << this->Internal->PickedPointID << "\n";
+  os << indent << "NumberOfPicks = " << this->Internal->NumberOfPicks << "\n";
+  os << indent << "LastPickTime = " << this->Internal->LastPickTime << "\n";
+  os << indent << "AveragePickTime = " << this->GetAveragePickTime() << "\n";
+  os << indent << "MaximumPickTime = " << this->Internal->MaximumPickTime << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -2043,6 +2156,11 @@ int vtkMRMLModelDisplayableManager::Pick(int x, int y)
   displayPoint[1] = renSize[1] - y;
   displayPoint[2] = 0.0;
 
+  this->Internal->PickTimer->StartTimer();
+
+  // The picker intersects the ray with the cached locators of the models
+  // instead of testing every cell of the models
+  this->Internal->UpdatePickLocators();
   if (this->Internal->CellPicker->Pick(displayPoint[0], displayPoint[1], displayPoint[2], ren))
     {
     this->Internal->CellPicker->GetPickPosition(pickPoint);
@@ -2132,9 +2250,153 @@ int vtkMRMLModelDisplayableManager::Pick(int x, int y)
   // now set up the class vars
   this->SetPickedRAS(RASPoint);
 
+  this->Internal->PickTimer->StopTimer();
+  this->Internal->AddPickTime(this->Internal->PickTimer->GetElapsedTime());
+
   return 1;
 }
 
+//---------------------------------------------------------------------------
+int vtkMRMLModelDisplayableManager::PickAll(int x, int y,
+                                            vtkStringArray* pickedNodeIDs,
+                                            vtkPoints* pickedRASPoints,
+                                            vtkIdList* pickedCellIDs)
+{
+  if (pickedNodeIDs)
+    {
+    pickedNodeIDs->Initialize();
+    }
+  if (pickedRASPoints)
+    {
+    pickedRASPoints->Initialize();
+    }
+  if (pickedCellIDs)
+    {
+    pickedCellIDs->Initialize();
+    }
+
+  vtkRenderer* ren = this->GetRenderer();
+  if (!ren)
+    {
+    vtkErrorMacro("PickAll: unable to get renderer\n");
+    return 0;
+    }
+
+  this->Internal->PickTimer->StartTimer();
+
+  // Compute the pick ray, from the near to the far clipping plane
+  int *renSize = ren->GetSize();
+  double rayPoints[2][3];
+  for (int i = 0; i < 2; ++i)
+    {
+    ren->SetDisplayPoint(x, renSize[1] - y, i);
+    ren->DisplayToWorld();
+    double* worldPoint = ren->GetWorldPoint();
+    for (int c = 0; c < 3; ++c)
+      {
+      rayPoints[i][c] = worldPoint[3] != 0. ? worldPoint[c] / worldPoint[3] : worldPoint[c];
+      }
+    }
+
+  this->Internal->UpdatePickLocators();
+
+  // Collect the intersections with every model
+  std::vector<PickHit> hits;
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkIdList> cellIds;
+  std::map<std::string, vtkInternal::PickLocator>::iterator locatorIt;
+  for (locatorIt = this->Internal->PickLocators.begin();
+       locatorIt != this->Internal->PickLocators.end();
+       ++locatorIt)
+    {
+    vtkProp3D* prop = this->Internal->DisplayedActors[locatorIt->first];
+    // The locator works in the actor coordinate system
+    vtkNew<vtkMatrix4x4> worldToActor;
+    prop->GetMatrix(worldToActor.GetPointer());
+    worldToActor->Invert();
+    double p1[4] = {rayPoints[0][0], rayPoints[0][1], rayPoints[0][2], 1.};
+    double p2[4] = {rayPoints[1][0], rayPoints[1][1], rayPoints[1][2], 1.};
+    worldToActor->MultiplyPoint(p1, p1);
+    worldToActor->MultiplyPoint(p2, p2);
+    points->Reset();
+    cellIds->Reset();
+    locatorIt->second.Locator->IntersectWithLine(
+      p1, p2, this->GetPickTolerance(), points.GetPointer(), cellIds.GetPointer());
+    vtkNew<vtkMatrix4x4> actorToWorld;
+    prop->GetMatrix(actorToWorld.GetPointer());
+    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+      {
+      double position[4] = {0., 0., 0., 1.};
+      points->GetPoint(i, position);
+      actorToWorld->MultiplyPoint(position, position);
+      PickHit hit;
+      hit.Distance2 = vtkMath::Distance2BetweenPoints(position, rayPoints[0]);
+      hit.Position[0] = position[0];
+      hit.Position[1] = position[1];
+      hit.Position[2] = position[2];
+      hit.CellID = cellIds->GetId(i);
+      hit.NodeID = &locatorIt->first;
+      hits.push_back(hit);
+      }
+    }
+  std::sort(hits.begin(), hits.end());
+
+  for (std::vector<PickHit>::iterator hitIt = hits.begin(); hitIt != hits.end(); ++hitIt)
+    {
+    if (pickedNodeIDs)
+      {
+      pickedNodeIDs->InsertNextValue(*hitIt->NodeID);
+      }
+    if (pickedRASPoints)
+      {
+      pickedRASPoints->InsertNextPoint(hitIt->Position);
+      }
+    if (pickedCellIDs)
+      {
+      pickedCellIDs->InsertNextId(hitIt->CellID);
+      }
+    }
+
+  this->Internal->PickTimer->StopTimer();
+  this->Internal->AddPickTime(this->Internal->PickTimer->GetElapsedTime());
+
+  return static_cast<int>(hits.size());
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLModelDisplayableManager::GetNumberOfPicks()
+{
+  return this->Internal->NumberOfPicks;
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLModelDisplayableManager::GetLastPickTime()
+{
+  return this->Internal->LastPickTime;
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLModelDisplayableManager::GetAveragePickTime()
+{
+  return this->Internal->NumberOfPicks > 0 ?
+    this->Internal->TotalPickTime / this->Internal->NumberOfPicks : 0.;
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLModelDisplayableManager::GetMaximumPickTime()
+{
+  return this->Internal->MaximumPickTime;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLModelDisplayableManager::ResetPickStatistics()
+{
+  this->Internal->NumberOfPicks = 0;
+  this->Internal->LastPickTime = 0.;
+  this->Internal->TotalPickTime = 0.;
+  this->Internal->MaximumPickTime = 0.;
+}
+
 //---------------------------------------------------------------------------
 const char * vtkMRMLModelDisplayableManager::GetPickedNodeID()
 {
@@ -40,15 +40,18 @@ class vtkCellArray;
 class vtkCellPicker;
 class vtkClipPolyData;
 class vtkFollower;
+class vtkIdList;
 class vtkImplicitBoolean;
 class vtkMatrix4x4;
 class vtkPMatrix4x4;
 class vtkPlane;
 class vtkPlane;
 class vtkPointPicker;
+class vtkPoints;
 class vtkPolyData;
 class vtkProp3D;
 class vtkPropPicker;
+class vtkStringArray;
 class vtkWorldPointPicker;
 
 /// \brief Manage display nodes with polydata in 3D views.
@@ -98,8 +101,26 @@ public:
 
   /// Convert an x/y location to a mrml node, 3d RAS point, point id, cell id,
   /// as appropriate depending what's found under the xy.
+  /// Each displayed model keeps a cell locator (BSP tree) that is reused
+  /// until the model polydata is modified.
   int Pick(int x, int y);
 
+  /// Find all the intersections of the models with the ray under the x/y
+  /// location, sorted from the nearest to the farthest.
+  /// For each intersection, the display node ID, RAS point and cell id are
+  /// appended to the optional \a pickedNodeIDs, \a pickedRASPoints and
+  /// \a pickedCellIDs. Returns the number of intersections.
+  /// \sa Pick()
+  int PickAll(int x, int y, vtkStringArray* pickedNodeIDs,
+              vtkPoints* pickedRASPoints, vtkIdList* pickedCellIDs);
+
+  /// Pick latency statistics of Pick() and PickAll(), in seconds.
+  int GetNumberOfPicks();
+  double GetLastPickTime();
+  double GetAveragePickTime();
+  double GetMaximumPickTime();
+  void ResetPickStatistics();
+
   /// Get/Set tolerance for Pick() method.
   /// it will call vtkCellPicker.Get/SetTolerance()
   double GetPickTolerance();
@@ -47,17 +47,17 @@
 #include <vtkGeneralTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkWeakPointer.h>
-#include <vtkPointLocator.h>
 #include <vtkVersion.h>
 
-// VTK includes: customization
-#include <vtkCutter.h>
+// vtkAddon includes
+#include <vtkCachedPlaneCutter.h>
 
 // STD includes
 #include <algorithm>
 #include <cassert>
 #include <set>
 #include <map>
+#include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro(vtkMRMLModelSliceDisplayableManager );
@@ -73,7 +73,7 @@ public:
     vtkSmartPointer<vtkTransformPolyDataFilter> Transformer;
     vtkSmartPointer<vtkTransformPolyDataFilter> ModelWarper;
     vtkSmartPointer<vtkPlane> Plane;
-    vtkSmartPointer<vtkCutter> Cutter;
+    vtkSmartPointer<vtkCachedPlaneCutter> Cutter;
     vtkSmartPointer<vtkProp> Actor;
     };
 
@@ -95,6 +95,7 @@ public:
   void AddDisplayNode(vtkMRMLDisplayableNode*, vtkMRMLDisplayNode*);
   void UpdateDisplayNode(vtkMRMLDisplayNode* displayNode);
   void UpdateDisplayNodePipeline(vtkMRMLDisplayNode*, const Pipeline*);
+  void UpdateCutters();
   void RemoveDisplayNode(vtkMRMLDisplayNode* displayNode);
 
   // Observations
@@ -199,6 +200,25 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
     {
     this->UpdateDisplayNodePipeline(it->first, it->second);
     }
+  this->UpdateCutters();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLModelSliceDisplayableManager::vtkInternal
+::UpdateCutters()
+{
+  // Cut all the visible models at once, using all the cores, instead of
+  // cutting them one after the other when the view is rendered.
+  std::vector<vtkCachedPlaneCutter*> cutters;
+  PipelinesCacheType::iterator it;
+  for (it = this->DisplayPipelines.begin(); it != this->DisplayPipelines.end(); ++it)
+    {
+    if (it->second->Actor->GetVisibility())
+      {
+      cutters.push_back(it->second->Cutter);
+      }
+    }
+  vtkCachedPlaneCutter::UpdateInParallel(cutters);
 }
 
 //---------------------------------------------------------------------------
@@ -302,7 +322,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   // Create pipeline
   Pipeline* pipeline = new Pipeline();
   pipeline->Actor = actor.GetPointer();
-  pipeline->Cutter = vtkSmartPointer<vtkCutter>::New();
+  pipeline->Cutter = vtkSmartPointer<vtkCachedPlaneCutter>::New();
   pipeline->TransformToSlice = vtkSmartPointer<vtkTransform>::New();
   pipeline->NodeToWorld = vtkSmartPointer<vtkGeneralTransform>::New();
   pipeline->Transformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
@@ -312,8 +332,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   // Set up pipeline
   pipeline->Transformer->SetTransform(pipeline->TransformToSlice);
   pipeline->Transformer->SetInputConnection(pipeline->Cutter->GetOutputPort());
-  pipeline->Cutter->SetCutFunction(pipeline->Plane);
-  pipeline->Cutter->SetGenerateCutScalars(0);
+  pipeline->Cutter->SetPlane(pipeline->Plane);
   pipeline->Cutter->SetInputConnection(pipeline->ModelWarper->GetOutputPort());
   pipeline->Actor->SetVisibility(0);
 
@@ -394,17 +413,6 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
     vtkMatrix4x4::Invert(this->SliceXYToRAS, rasToSliceXY.GetPointer());
     pipeline->TransformToSlice->SetMatrix(rasToSliceXY.GetPointer());
 
-    // optimization for slice to slice intersections which are 1 quad polydatas
-    // no need for 50^3 default locator divisons
-    if (polyData->GetPoints() != NULL && polyData->GetNumberOfPoints() <= 4)
-    {
-      vtkNew<vtkPointLocator> locator;
-      double *bounds = polyData->GetBounds();
-      locator->SetDivisions(2,2,2);
-      locator->InitPointInsertion(polyData->GetPoints(), bounds);
-      pipeline->Cutter->SetLocator(locator.GetPointer());
-    }
-
     // Update pipeline actor
     vtkActor2D* actor = vtkActor2D::SafeDownCast(pipeline->Actor);
     vtkPolyDataMapper2D* mapper = vtkPolyDataMapper2D::SafeDownCast(
@@ -0,0 +1,382 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkArchive.h"
+
+// VTK includes
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+const char* FileNames[] = {
+  "Data/text.txt", "Data/large.txt", "Data/random.gz", "Data/gzip.nrrd",
+  "Data/raw.nrrd", "Data/empty.txt", 0};
+const char* SceneContent = "<MRML version=\"Slicer4\">\n</MRML>\n";
+
+//----------------------------------------------------------------------------
+bool WriteFile(const std::string& fileName, const std::string& content)
+{
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+  file << content;
+  return file.good();
+}
+
+//----------------------------------------------------------------------------
+std::string ReadFile(const std::string& fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+//----------------------------------------------------------------------------
+std::string RandomString(size_t size)
+{
+  std::string str(size, '\0');
+  for (size_t i = 0; i < size; ++i)
+    {
+    str[i] = static_cast<char>(rand() & 0xff);
+    }
+  return str;
+}
+
+//----------------------------------------------------------------------------
+// Write the files of <directory>/Input, the random ones can't be compressed.
+bool WriteInputFiles(const std::string& directory)
+{
+  std::stringstream text;
+  for (int i = 0; i < 20000; ++i)
+    {
+    text << "line " << (i % 100) << " of a compressible text file\n";
+    }
+  std::stringstream large;
+  for (int i = 0; i < 100000; ++i)
+    {
+    large << "large " << i << "\n";
+    }
+  std::string inputDirectory = directory + "/Input/";
+  srand(42);
+  return vtksys::SystemTools::MakeDirectory((inputDirectory + "Data").c_str()) &&
+    WriteFile(inputDirectory + FileNames[0], text.str()) &&
+    WriteFile(inputDirectory + FileNames[1], large.str()) &&
+    WriteFile(inputDirectory + FileNames[2], RandomString(100000)) &&
+    WriteFile(inputDirectory + FileNames[3],
+              "NRRD0004\ntype: short\nencoding: gzip\n\n" + RandomString(1000)) &&
+    WriteFile(inputDirectory + FileNames[4],
+              "NRRD0004\ntype: short\nencoding: raw\n\n" + std::string(1000, '\0')) &&
+    WriteFile(inputDirectory + FileNames[5], "");
+}
+
+//----------------------------------------------------------------------------
+bool TestIsCompressedFile(const std::string& directory)
+{
+  std::string inputDirectory = directory + "/Input/";
+  if (!vtkArchiveWriter::IsCompressedFile((inputDirectory + "Data/random.gz").c_str()) ||
+      !vtkArchiveWriter::IsCompressedFile((inputDirectory + "Data/gzip.nrrd").c_str()) ||
+      !vtkArchiveWriter::IsCompressedFile("model.vtp") ||
+      !vtkArchiveWriter::IsCompressedFile("Screenshot.PNG") ||
+      vtkArchiveWriter::IsCompressedFile((inputDirectory + "Data/raw.nrrd").c_str()) ||
+      vtkArchiveWriter::IsCompressedFile((inputDirectory + "Data/text.txt").c_str()) ||
+      vtkArchiveWriter::IsCompressedFile(0))
+    {
+    std::cerr << __LINE__ << ": IsCompressedFile failed" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WriteArchive(const std::string& directory, const std::string& zipFileName, int threads,
+                  size_t maximumBufferedSize = 256 * 1024 * 1024)
+{
+  vtkArchiveWriter writer;
+  writer.SetNumberOfThreads(threads);
+  // Files larger than 64KB are deflated while they are written
+  writer.SetMaximumBufferedEntrySize(64 * 1024);
+  writer.SetMaximumBufferedSize(maximumBufferedSize);
+  if (!writer.Open(zipFileName.c_str()) ||
+      !writer.AddDirectory("Input"))
+    {
+    std::cerr << __LINE__ << ": could not create " << zipFileName << std::endl;
+    return false;
+    }
+  for (int i = 0; FileNames[i]; ++i)
+    {
+    if (!writer.AddFile((std::string("Input/") + FileNames[i]).c_str(),
+                        (directory + "/Input/" + FileNames[i]).c_str()))
+      {
+      std::cerr << __LINE__ << ": could not add " << FileNames[i] << std::endl;
+      return false;
+      }
+    }
+  if (writer.AddFile("Input/Data/missing.txt", (directory + "/missing.txt").c_str()))
+    {
+    std::cerr << __LINE__ << ": a missing file should not be added" << std::endl;
+    return false;
+    }
+  // Stream the scene from memory in two chunks
+  std::string scene(SceneContent);
+  if (!writer.BeginEntry("Input/Scene.mrml") ||
+      !writer.WriteData(scene.c_str(), 10) ||
+      !writer.WriteData(scene.c_str() + 10, scene.size() - 10) ||
+      !writer.EndEntry())
+    {
+    std::cerr << __LINE__ << ": could not stream the scene" << std::endl;
+    return false;
+    }
+  // Close() fails because of the missing file, the archive is still valid
+  writer.Close();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckArchive(const std::string& directory, const std::string& zipFileName)
+{
+  std::string outputDirectory = directory + "/Output";
+  vtksys::SystemTools::RemoveADirectory(outputDirectory.c_str());
+  vtksys::SystemTools::MakeDirectory(outputDirectory.c_str());
+  if (!unzip(zipFileName.c_str(), outputDirectory.c_str()))
+    {
+    std::cerr << __LINE__ << ": could not extract " << zipFileName << std::endl;
+    return false;
+    }
+  for (int i = 0; FileNames[i]; ++i)
+    {
+    std::string expected = ReadFile(directory + "/Input/" + FileNames[i]);
+    std::string extracted = ReadFile(outputDirectory + "/Input/" + FileNames[i]);
+    if (extracted != expected)
+      {
+      std::cerr << __LINE__ << ": " << FileNames[i] << " differs in " << zipFileName
+                << ": " << extracted.size() << " bytes instead of " << expected.size() << std::endl;
+      return false;
+      }
+    }
+  if (ReadFile(outputDirectory + "/Input/Scene.mrml") != SceneContent)
+    {
+    std::cerr << __LINE__ << ": the streamed scene differs in " << zipFileName << std::endl;
+    return false;
+    }
+
+  // The text files are deflated, the random files are stored
+  unsigned long randomSize = vtksys::SystemTools::FileLength(
+    (directory + "/Input/Data/random.gz").c_str());
+  unsigned long textSize = vtksys::SystemTools::FileLength(
+    (directory + "/Input/Data/text.txt").c_str());
+  unsigned long zipSize = vtksys::SystemTools::FileLength(zipFileName.c_str());
+  if (zipSize < randomSize || zipSize > randomSize + textSize / 2)
+    {
+    std::cerr << __LINE__ << ": unexpected archive size: " << zipSize << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestWriteArchive(const std::string& directory)
+{
+  vtkTimerLog* timer = vtkTimerLog::New();
+  std::string zipFileName1 = directory + "/Archive1.zip";
+  std::string zipFileName4 = directory + "/Archive4.zip";
+  timer->StartTimer();
+  bool res = WriteArchive(directory, zipFileName1, 1);
+  timer->StopTimer();
+  double time1 = timer->GetElapsedTime();
+  timer->StartTimer();
+  res = res && WriteArchive(directory, zipFileName4, 4);
+  timer->StopTimer();
+  double time4 = timer->GetElapsedTime();
+  timer->Delete();
+  if (!res)
+    {
+    return false;
+    }
+  std::cout << "<DartMeasurement name=\"ZipTime1Thread\" type=\"numeric/double\">"
+            << time1 << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"ZipTime4Threads\" type=\"numeric/double\">"
+            << time4 << "</DartMeasurement>" << std::endl;
+
+  // Threads don't change the content of the archive
+  if (vtksys::SystemTools::FileLength(zipFileName1.c_str()) !=
+      vtksys::SystemTools::FileLength(zipFileName4.c_str()))
+    {
+    std::cerr << __LINE__ << ": archives written with 1 and 4 threads differ" << std::endl;
+    return false;
+    }
+  // Few files in memory at once: the files larger than 1500 bytes are
+  // streamed, the others are flushed before they add up to more.
+  std::string zipFileNameCapped = directory + "/Archive4Capped.zip";
+  if (!WriteArchive(directory, zipFileNameCapped, 4, 1500))
+    {
+    return false;
+    }
+  return CheckArchive(directory, zipFileName1) &&
+    CheckArchive(directory, zipFileName4) &&
+    CheckArchive(directory, zipFileNameCapped);
+}
+
+//----------------------------------------------------------------------------
+// A large file that deflating makes larger is stored, even if it was
+// streamed, and the archive remains valid.
+bool TestStreamIncompressibleFile(const std::string& directory)
+{
+  std::string zipFileName = directory + "/Incompressible.zip";
+  std::string randomFileName = directory + "/Input/Data/random.raw";
+  std::string random = ReadFile(directory + "/Input/Data/random.gz");
+  WriteFile(randomFileName, random);
+  vtkArchiveWriter writer;
+  writer.SetMaximumBufferedEntrySize(64 * 1024);
+  if (!writer.Open(zipFileName.c_str()) ||
+      !writer.AddFile("Input/Data/random.raw", randomFileName.c_str(),
+                      vtkArchiveWriter::Deflate) ||
+      !writer.AddFile("Input/Data/text.txt", (directory + "/Input/Data/text.txt").c_str()) ||
+      !writer.Close())
+    {
+    std::cerr << __LINE__ << ": could not write " << zipFileName << std::endl;
+    return false;
+    }
+  vtksys::SystemTools::RemoveFile(randomFileName.c_str());
+
+  unsigned long zipSize = vtksys::SystemTools::FileLength(zipFileName.c_str());
+  unsigned long textSize = vtksys::SystemTools::FileLength(
+    (directory + "/Input/Data/text.txt").c_str());
+  if (zipSize < random.size() || zipSize > random.size() + textSize / 2)
+    {
+    std::cerr << __LINE__ << ": unexpected archive size: " << zipSize << std::endl;
+    return false;
+    }
+  std::string outputDirectory = directory + "/Output";
+  vtksys::SystemTools::RemoveADirectory(outputDirectory.c_str());
+  vtksys::SystemTools::MakeDirectory(outputDirectory.c_str());
+  if (!unzip(zipFileName.c_str(), outputDirectory.c_str()) ||
+      ReadFile(outputDirectory + "/Input/Data/random.raw") != random ||
+      ReadFile(outputDirectory + "/Input/Data/text.txt") !=
+        ReadFile(directory + "/Input/Data/text.txt"))
+    {
+    std::cerr << __LINE__ << ": could not extract " << zipFileName << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestZipDirectory(const std::string& directory)
+{
+  std::string zipFileName = directory + "/Directory.zip";
+  // The scene is a file for zip()
+  WriteFile(directory + "/Input/Scene.mrml", SceneContent);
+  bool res = zip(zipFileName.c_str(), (directory + "/Input").c_str());
+  vtksys::SystemTools::RemoveFile((directory + "/Input/Scene.mrml").c_str());
+  if (!res)
+    {
+    std::cerr << __LINE__ << ": could not zip " << directory << "/Input" << std::endl;
+    return false;
+    }
+  return CheckArchive(directory, zipFileName);
+}
+
+//----------------------------------------------------------------------------
+// Entries with ".." or absolute paths must not be extracted outside of the
+// destination directory.
+bool TestExtractOutsideDestination(const std::string& directory)
+{
+  std::string zipFileName = directory + "/Outside.zip";
+  std::string outputDirectory = directory + "/Output";
+  const char* pathNames[] = {
+    "Input/inside.txt", "../outside.txt", "Input/../../outside2.txt", 0};
+  std::string absolutePathName = directory + "/absolute.txt";
+  std::string content("content");
+  vtkArchiveWriter writer;
+  if (!writer.Open(zipFileName.c_str()))
+    {
+    std::cerr << __LINE__ << ": could not create " << zipFileName << std::endl;
+    return false;
+    }
+  for (int i = 0; pathNames[i]; ++i)
+    {
+    writer.BeginEntry(pathNames[i]);
+    writer.WriteData(content.c_str(), content.size());
+    writer.EndEntry();
+    }
+  writer.BeginEntry(absolutePathName.c_str());
+  writer.WriteData(content.c_str(), content.size());
+  writer.EndEntry();
+  if (!writer.Close())
+    {
+    std::cerr << __LINE__ << ": could not write " << zipFileName << std::endl;
+    return false;
+    }
+
+  vtksys::SystemTools::RemoveADirectory(outputDirectory.c_str());
+  vtksys::SystemTools::MakeDirectory(outputDirectory.c_str());
+  if (unzip(zipFileName.c_str(), outputDirectory.c_str()))
+    {
+    std::cerr << __LINE__ << ": extracting " << zipFileName << " should fail" << std::endl;
+    return false;
+    }
+  if (ReadFile(outputDirectory + "/Input/inside.txt") != content)
+    {
+    std::cerr << __LINE__ << ": the entry inside of the destination was not extracted"
+              << std::endl;
+    return false;
+    }
+  if (vtksys::SystemTools::FileExists((directory + "/outside.txt").c_str()) ||
+      vtksys::SystemTools::FileExists((directory + "/outside2.txt").c_str()) ||
+      vtksys::SystemTools::FileExists(absolutePathName.c_str()))
+    {
+    std::cerr << __LINE__ << ": an entry was extracted outside of the destination"
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkArchiveWriterTest1(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " temporaryDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string directory = std::string(argv[1]) + "/vtkArchiveWriterTest1";
+  vtksys::SystemTools::RemoveADirectory(directory.c_str());
+  if (!WriteInputFiles(directory))
+    {
+    std::cerr << __LINE__ << ": could not write the input files" << std::endl;
+    return EXIT_FAILURE;
+    }
+  bool res = TestIsCompressedFile(directory);
+  res = res && TestWriteArchive(directory);
+  res = res && TestStreamIncompressibleFile(directory);
+  res = res && TestZipDirectory(directory);
+  res = res && TestExtractOutsideDestination(directory);
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
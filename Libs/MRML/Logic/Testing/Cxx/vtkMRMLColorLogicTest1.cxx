@@ -35,6 +35,7 @@
 #include <vtkTimerLog.h>
 
 // STD includes
+#include <string>
 
 #include "vtkMRMLCoreTestingMacros.h"
 
@@ -42,6 +43,7 @@
 namespace
 {
 bool TestPerformance();
+bool TestSharedColors();
 bool TestNodeIDs();
 bool TestDefaults();
 bool TestCopy();
@@ -53,6 +55,7 @@ int vtkMRMLColorLogicTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[] )
 {
   bool res = true;
   res = TestPerformance() && res;
+  res = TestSharedColors() && res;
   res = TestNodeIDs() && res;
   res = TestDefaults() && res;
   res = TestCopy() && res;
@@ -79,6 +82,29 @@ bool TestPerformance()
   std::cout << "<DartMeasurement name=\"AddDefaultColorNodes\" "
             << "type=\"numeric/double\">"
             << overallTimer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // the colors computed for the first scene are shared with the next ones
+  vtkNew<vtkMRMLScene> scene2;
+  vtkMRMLColorLogic* colorLogic2 = vtkMRMLColorLogic::New();
+  overallTimer->StartTimer();
+
+  colorLogic2->SetMRMLScene(scene2.GetPointer());
+
+  overallTimer->StopTimer();
+  std::cout << "<DartMeasurement name=\"AddDefaultColorNodes-Shared\" "
+            << "type=\"numeric/double\">"
+            << overallTimer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  overallTimer->StartTimer();
+
+  scene2->Clear(1);
+  colorLogic2->SetMRMLScene(0);
+  colorLogic2->SetMRMLScene(scene2.GetPointer());
+
+  overallTimer->StopTimer();
+  std::cout << "<DartMeasurement name=\"ClearAndAddDefaultColorNodes-Shared\" "
+            << "type=\"numeric/double\">"
+            << overallTimer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  colorLogic2->Delete();
   overallTimer->StartTimer();
 
   colorLogic->Delete();
@@ -92,6 +118,52 @@ bool TestPerformance()
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool TestSharedColors()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLColorLogic> colorLogic;
+  colorLogic->SetMRMLScene(scene.GetPointer());
+  vtkNew<vtkMRMLScene> scene2;
+  vtkNew<vtkMRMLColorLogic> colorLogic2;
+  colorLogic2->SetMRMLScene(scene2.GetPointer());
+
+  std::string greyID = vtkMRMLColorLogic::GetColorTableNodeID(vtkMRMLColorTableNode::Grey);
+  vtkMRMLColorTableNode* greyNode = vtkMRMLColorTableNode::SafeDownCast(
+    scene->GetNodeByID(greyID.c_str()));
+  vtkMRMLColorTableNode* greyNode2 = vtkMRMLColorTableNode::SafeDownCast(
+    scene2->GetNodeByID(greyID.c_str()));
+  if (!greyNode || !greyNode2 || greyNode == greyNode2 ||
+      greyNode->GetLookupTable() == NULL ||
+      greyNode->GetLookupTable() != greyNode2->GetLookupTable() ||
+      greyNode2->GetNumberOfColors() != 256 ||
+      greyNode2->GetColorName(255) == NULL)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Grey color table is not shared between scenes" << std::endl;
+    return false;
+    }
+
+  std::string petID = vtkMRMLColorLogic::GetPETColorNodeID(vtkMRMLPETProceduralColorNode::PETheat);
+  vtkMRMLPETProceduralColorNode* petNode = vtkMRMLPETProceduralColorNode::SafeDownCast(
+    scene->GetNodeByID(petID.c_str()));
+  vtkMRMLPETProceduralColorNode* petNode2 = vtkMRMLPETProceduralColorNode::SafeDownCast(
+    scene2->GetNodeByID(petID.c_str()));
+  if (!petNode || !petNode2 ||
+      petNode2->GetColorTransferFunction() == NULL ||
+      petNode->GetColorTransferFunction() == petNode2->GetColorTransferFunction() ||
+      petNode->GetColorTransferFunction()->GetSize() !=
+        petNode2->GetColorTransferFunction()->GetSize() ||
+      petNode2->GetType() != vtkMRMLPETProceduralColorNode::PETheat ||
+      petNode2->GetAttribute("Category") == NULL)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - PET color transfer function is not copied between scenes" << std::endl;
+    return false;
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool TestNodeIDs()
 {
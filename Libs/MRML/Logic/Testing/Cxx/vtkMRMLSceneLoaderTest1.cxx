@@ -0,0 +1,280 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkArchive.h"
+#include "vtkMRMLSceneLoader.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeDisplayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// ITK includes
+#include <itkFactoryRegistration.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct ReadDataEvents
+{
+  ReadDataEvents() : Starts(0), Ends(0) {}
+  int Starts;
+  int Ends;
+  std::vector<int> Progress;
+};
+
+//----------------------------------------------------------------------------
+void ReadDataCallback(vtkObject* vtkNotUsed(caller), unsigned long eid,
+                      void* clientData, void* callData)
+{
+  ReadDataEvents* events = reinterpret_cast<ReadDataEvents*>(clientData);
+  switch (eid)
+    {
+    case vtkMRMLScene::StartReadDataEvent:
+      ++events->Starts;
+      break;
+    case vtkMRMLScene::EndReadDataEvent:
+      ++events->Ends;
+      break;
+    case vtkMRMLScene::ProgressReadDataEvent:
+      events->Progress.push_back(static_cast<int>(reinterpret_cast<long long>(callData)));
+      break;
+    default:
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+void ObserveReadData(vtkMRMLScene* scene, vtkCallbackCommand* callback, ReadDataEvents* events)
+{
+  callback->SetCallback(ReadDataCallback);
+  callback->SetClientData(events);
+  scene->AddObserver(vtkMRMLScene::StartReadDataEvent, callback);
+  scene->AddObserver(vtkMRMLScene::EndReadDataEvent, callback);
+  scene->AddObserver(vtkMRMLScene::ProgressReadDataEvent, callback);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* GetVolumeNode(vtkMRMLScene* scene)
+{
+  return vtkMRMLScalarVolumeNode::SafeDownCast(
+    scene->GetNthNodeByClass(0, "vtkMRMLScalarVolumeNode"));
+}
+
+//----------------------------------------------------------------------------
+// Write <directory>/Scene/Scene.mrml referencing a copy of volumeFile, and
+// the bundle <directory>/Scene.mrb.
+bool WriteScene(const std::string& directory, const char* volumeFile)
+{
+  std::string sceneDirectory = directory + "/Scene";
+  std::string dataFile = sceneDirectory + "/Data/fixed.nrrd";
+  vtksys::SystemTools::RemoveADirectory(directory.c_str());
+  if (!vtksys::SystemTools::MakeDirectory((sceneDirectory + "/Data").c_str()) ||
+      !vtksys::SystemTools::CopyFileAlways(volumeFile, dataFile.c_str()))
+    {
+    std::cerr << __LINE__ << ": could not create " << dataFile << std::endl;
+    return false;
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  storageNode->SetFileName(dataFile.c_str());
+  scene->AddNode(storageNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  scene->AddNode(displayNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  volumeNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+  if (!scene->Commit((sceneDirectory + "/Scene.mrml").c_str()))
+    {
+    std::cerr << __LINE__ << ": could not write the scene" << std::endl;
+    return false;
+    }
+  if (!zip((directory + "/Scene.mrb").c_str(), sceneDirectory.c_str()))
+    {
+    std::cerr << __LINE__ << ": could not write the bundle" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestLoadBundle(const std::string& directory)
+{
+  std::string extractDirectory = directory + "/LoadBundle";
+  vtksys::SystemTools::MakeDirectory(extractDirectory.c_str());
+
+  vtkNew<vtkMRMLScene> scene;
+  ReadDataEvents events;
+  vtkNew<vtkCallbackCommand> callback;
+  ObserveReadData(scene.GetPointer(), callback.GetPointer(), &events);
+
+  vtkNew<vtkMRMLSceneLoader> loader;
+  loader->SetMRMLScene(scene.GetPointer());
+  loader->SetFileName((directory + "/Scene.mrb").c_str());
+  loader->SetTemporaryDirectory(extractDirectory.c_str());
+  loader->SetChunkSize(1024);
+  if (!loader->Start())
+    {
+    std::cerr << __LINE__ << ": Start failed" << std::endl;
+    return false;
+    }
+
+  // The scene is parsed, the data is not read yet
+  vtkMRMLScalarVolumeNode* volumeNode = GetVolumeNode(scene.GetPointer());
+  if (!volumeNode || volumeNode->GetImageData() != 0 ||
+      !scene->IsReadingData() || !loader->IsLoading() ||
+      loader->GetNumberOfPendingNodes() != 1 ||
+      events.Starts != 1 || events.Ends != 0)
+    {
+    std::cerr << __LINE__ << ": the data should not be read by Start(): "
+              << volumeNode << " " << loader->GetNumberOfPendingNodes() << " "
+              << events.Starts << " " << events.Ends << std::endl;
+    return false;
+    }
+
+  int steps = 0;
+  while (loader->Step())
+    {
+    ++steps;
+    }
+  if (volumeNode->GetImageData() == 0 || scene->IsReadingData() ||
+      !loader->IsSuccessful() || steps < 2 || events.Ends != 1)
+    {
+    std::cerr << __LINE__ << ": the data should be read by Step(): "
+              << loader->IsSuccessful() << " " << steps << " " << events.Ends << std::endl;
+    return false;
+    }
+  if (events.Progress.empty() || events.Progress.back() != 100 ||
+      loader->GetProgress() != 100)
+    {
+    std::cerr << __LINE__ << ": wrong final progress" << std::endl;
+    return false;
+    }
+  for (size_t i = 1; i < events.Progress.size(); ++i)
+    {
+    if (events.Progress[i] < events.Progress[i - 1])
+      {
+      std::cerr << __LINE__ << ": progress is decreasing: "
+                << events.Progress[i - 1] << " then " << events.Progress[i] << std::endl;
+      return false;
+      }
+    }
+  if (!vtksys::SystemTools::FileExists((extractDirectory + "/Scene/Data/fixed.nrrd").c_str()))
+    {
+    std::cerr << __LINE__ << ": the volume is not extracted" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestCancel(const std::string& directory)
+{
+  std::string extractDirectory = directory + "/Cancel";
+  vtksys::SystemTools::MakeDirectory(extractDirectory.c_str());
+
+  vtkNew<vtkMRMLScene> scene;
+  ReadDataEvents events;
+  vtkNew<vtkCallbackCommand> callback;
+  ObserveReadData(scene.GetPointer(), callback.GetPointer(), &events);
+
+  vtkNew<vtkMRMLSceneLoader> loader;
+  loader->SetMRMLScene(scene.GetPointer());
+  loader->SetFileName((directory + "/Scene.mrb").c_str());
+  loader->SetTemporaryDirectory(extractDirectory.c_str());
+  if (!loader->Start())
+    {
+    std::cerr << __LINE__ << ": Start failed" << std::endl;
+    return false;
+    }
+  loader->Cancel();
+
+  // The volume is removed with its storage and display nodes
+  if (GetVolumeNode(scene.GetPointer()) != 0 ||
+      scene->GetNumberOfNodesByClass("vtkMRMLVolumeArchetypeStorageNode") != 0 ||
+      scene->GetNumberOfNodesByClass("vtkMRMLScalarVolumeDisplayNode") != 0)
+    {
+    std::cerr << __LINE__ << ": unread nodes are not removed" << std::endl;
+    return false;
+    }
+  if (loader->IsLoading() || !loader->IsCanceled() || loader->IsSuccessful() ||
+      loader->Step() || scene->IsReadingData() || events.Ends != 1)
+    {
+    std::cerr << __LINE__ << ": the load is not canceled" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestLoadSceneFile(const std::string& directory)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSceneLoader> loader;
+  loader->SetMRMLScene(scene.GetPointer());
+  loader->SetFileName((directory + "/Scene/Scene.mrml").c_str());
+  loader->ClearOn();
+  if (!loader->Run())
+    {
+    std::cerr << __LINE__ << ": Run failed" << std::endl;
+    return false;
+    }
+  vtkMRMLScalarVolumeNode* volumeNode = GetVolumeNode(scene.GetPointer());
+  if (!volumeNode || volumeNode->GetImageData() == 0 ||
+      loader->GetSceneFileName() != loader->GetFileName())
+    {
+    std::cerr << __LINE__ << ": the scene file is not loaded" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLSceneLoaderTest1(int argc, char * argv[])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " temporaryDirectory volume.nrrd" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::itkFactoryRegistration();
+
+  std::string directory = std::string(argv[1]) + "/vtkMRMLSceneLoaderTest1";
+  bool res = WriteScene(directory, argv[2]);
+  res = res && TestLoadBundle(directory);
+  res = res && TestCancel(directory);
+  res = res && TestLoadSceneFile(directory);
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -23,22 +23,34 @@
 
 // MRML includes
 #include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLGridTransformNode.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
+#include "vtkMRMLSliceNode.h"
+#include "vtkOrientedGridTransform.h"
 
 // VTK includes
 #include <vtkAssignAttribute.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkFloatArray.h>
+#include <vtkGeneralTransform.h>
 #include <vtkImageData.h>
 #include <vtkImageInterpolator.h>
 #include <vtkImageReslice.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkTrivialProducer.h>
 
+// STD includes
+#include <cstring>
+
 namespace
 {
 bool testDTIPipeline();
+bool testTransformModifiedWhileReslicing();
 }
 
 //----------------------------------------------------------------------------
@@ -73,6 +85,7 @@ int vtkMRMLSliceLayerLogicTest(int , char * [] )
 
   bool res = true;
   res = res && testDTIPipeline();
+  res = res && testTransformModifiedWhileReslicing();
   return res ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -140,4 +153,155 @@ bool testDTIPipeline()
   return true;
 }
 
+//----------------------------------------------------------------------------
+struct ResliceThreadInfo
+{
+  vtkImageReslice* Reslice;
+  vtkImageData* ExpectedOutput;
+  int NumberOfReslices;
+  int NumberOfDifferences;
+};
+
+//----------------------------------------------------------------------------
+// Reslice again and again, the output must not change.
+VTK_THREAD_RETURN_TYPE ResliceThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ResliceThreadInfo* info = static_cast<ResliceThreadInfo*>(threadInfo->UserData);
+  vtkImageData* expected = info->ExpectedOutput;
+  size_t size = static_cast<size_t>(expected->GetNumberOfPoints()) * expected->GetScalarSize();
+  for (int i = 0; i < info->NumberOfReslices; ++i)
+    {
+    info->Reslice->Modified();
+    info->Reslice->Update();
+    if (memcmp(info->Reslice->GetOutput()->GetScalarPointer(),
+               expected->GetScalarPointer(), size) != 0)
+      {
+      ++info->NumberOfDifferences;
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// The compiled transform from world concatenated by the slice layer logic is
+// a snapshot: changing the hierarchy, which rebuilds the compiled transforms,
+// must not affect a slice that is being resliced with it.
+bool testTransformModifiedWhileReslicing()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(32, 32, 32);
+#if VTK_MAJOR_VERSION <= 5
+  imageData->SetScalarTypeToShort();
+  imageData->AllocateScalars();
+#else
+  imageData->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* scalars = static_cast<short*>(imageData->GetScalarPointer());
+  for (int i = 0; i < 32 * 32 * 32; ++i)
+    {
+    scalars[i] = static_cast<short>(i % 251);
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+
+  // Volume under a grid transform, under a linear transform
+  vtkNew<vtkMRMLLinearTransformNode> linearNode;
+  scene->AddNode(linearNode.GetPointer());
+  vtkNew<vtkImageData> displacementGrid;
+  displacementGrid->SetExtent(0, 4, 0, 4, 0, 4);
+  displacementGrid->SetOrigin(-10, -10, -10);
+  displacementGrid->SetSpacing(12, 12, 12);
+#if VTK_MAJOR_VERSION <= 5
+  displacementGrid->SetScalarTypeToDouble();
+  displacementGrid->SetNumberOfScalarComponents(3);
+  displacementGrid->AllocateScalars();
+#else
+  displacementGrid->AllocateScalars(VTK_DOUBLE, 3);
+#endif
+  double* displacement = static_cast<double*>(displacementGrid->GetScalarPointer());
+  for (int i = 0; i < 5 * 5 * 5 * 3; ++i)
+    {
+    displacement[i] = (i % 5) * 0.7;
+    }
+  vtkNew<vtkOrientedGridTransform> gridTransform;
+#if VTK_MAJOR_VERSION <= 5
+  gridTransform->SetDisplacementGrid(displacementGrid.GetPointer());
+#else
+  gridTransform->SetDisplacementGridData(displacementGrid.GetPointer());
+#endif
+  vtkNew<vtkMRMLGridTransformNode> gridNode;
+  scene->AddNode(gridNode.GetPointer());
+  gridNode->SetAndObserveTransformToParent(gridTransform.GetPointer());
+  gridNode->SetAndObserveTransformNodeID(linearNode->GetID());
+  volumeNode->SetAndObserveTransformNodeID(gridNode->GetID());
+
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetLayoutName("Red");
+  sliceNode->SetOrientationToAxial();
+  scene->AddNode(sliceNode.GetPointer());
+  sliceNode->SetDimensions(64, 64, 1);
+  sliceNode->SetFieldOfView(40, 40, 1);
+
+  vtkNew<vtkMRMLSliceLayerLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+  logic->SetSliceNode(sliceNode.GetPointer());
+  logic->SetVolumeNode(volumeNode.GetPointer());
+
+  // Reslice like the logic does, with the compiled transform it concatenated
+  vtkNew<vtkGeneralTransform> xyToIJK;
+  xyToIJK->PostMultiply();
+  xyToIJK->Concatenate(sliceNode->GetXYToRAS());
+  xyToIJK->Concatenate(gridNode->GetCompiledTransformFromWorld());
+  vtkNew<vtkMatrix4x4> rasToIJK;
+  volumeNode->GetRASToIJKMatrix(rasToIJK.GetPointer());
+  xyToIJK->Concatenate(rasToIJK.GetPointer());
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(imageData.GetPointer());
+  reslice->SetResliceTransform(xyToIJK.GetPointer());
+  reslice->SetInterpolationModeToLinear();
+  reslice->SetOutputExtent(0, 63, 0, 63, 0, 0);
+  reslice->SetNumberOfThreads(2);
+  reslice->Update();
+  vtkNew<vtkImageData> expectedOutput;
+  expectedOutput->DeepCopy(reslice->GetOutput());
+
+  ResliceThreadInfo info;
+  info.Reslice = reslice.GetPointer();
+  info.ExpectedOutput = expectedOutput.GetPointer();
+  info.NumberOfReslices = 50;
+  info.NumberOfDifferences = 0;
+  vtkNew<vtkMultiThreader> threader;
+  int threadId = threader->SpawnThread(ResliceThread, &info);
+
+  // Change the hierarchy while reslicing: the logic gets the new compiled
+  // transforms, which are rebuilt each time.
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int i = 0; i < 200; ++i)
+    {
+    matrix->SetElement(0, 3, (i % 10) + 1.);
+    matrix->SetElement(1, 0, 0.01 * (i % 7));
+    linearNode->SetMatrixTransformToParent(matrix.GetPointer());
+    gridNode->SetAndObserveTransformNodeID(i % 2 ? NULL : linearNode->GetID());
+    gridNode->GetCompiledTransformFromWorld();
+    }
+  threader->TerminateThread(threadId);
+
+  if (info.NumberOfDifferences != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << info.NumberOfDifferences
+              << " reslices changed while the hierarchy was modified" << std::endl;
+    return false;
+    }
+  if (logic->GetXYToIJKTransform()->GetNumberOfConcatenatedTransforms() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Transform not concatenated by the logic" << std::endl;
+    return false;
+    }
+  return true;
+}
+
 }
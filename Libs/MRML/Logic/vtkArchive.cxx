@@ -14,14 +14,29 @@
 #include "vtksys/Glob.hxx"
 #include "vtksys/SystemTools.hxx"
 
+// VTK includes
+#include <vtkCriticalSection.h>
+#include <vtkMultiThreader.h>
+#include <vtkType.h>
+#include <vtk_zlib.h>
+
 // LibArchive includes
 #include <archive.h>
 #include <archive_entry.h>
 
 // STD includes
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 
+#if defined(_WIN32) && !defined(__CYGWIN__)
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
 namespace
 {
 
@@ -214,6 +229,28 @@ long copy_data(struct archive *ar, struct archive *aw)
   return r;
 }
 
+// --------------------------------------------------------------------------
+// Return the file an entry path name is extracted into, or an empty string
+// if the entry would be written outside of directory: absolute path names
+// and path names with too many ".." (zip slip) are rejected.
+std::string GetFileNameInDirectory(const std::string& pathName, const std::string& directory)
+{
+  if (pathName.empty() || vtksys::SystemTools::FileIsFullPath(pathName.c_str()))
+    {
+    return std::string();
+    }
+  std::string fileName =
+    vtksys::SystemTools::CollapseFullPath(pathName.c_str(), directory.c_str());
+  std::string collapsedDirectory =
+    vtksys::SystemTools::CollapseFullPath(directory.c_str());
+  if (!vtksys::SystemTools::ComparePath(fileName.c_str(), collapsedDirectory.c_str()) &&
+      !vtksys::SystemTools::IsSubDirectory(fileName.c_str(), collapsedDirectory.c_str()))
+    {
+    return std::string();
+    }
+  return fileName;
+}
+
 } // end of anonymous namespace
 
 //-----------------------------------------------------------------------------
@@ -297,7 +334,11 @@ bool extract_tar(const char* tarFileName, bool verbose, bool extract, std::vecto
       }
     if(extract)
       {
-      r = archive_write_disk_set_options(ext, ARCHIVE_EXTRACT_TIME);
+      int options = ARCHIVE_EXTRACT_TIME;
+#ifdef ARCHIVE_EXTRACT_SECURE_NOABSOLUTEPATHS
+      options |= ARCHIVE_EXTRACT_SECURE_NOABSOLUTEPATHS;
+#endif
+      r = archive_write_disk_set_options(ext, options);
       if (r != ARCHIVE_OK)
         {
         vtkArchiveTools::Error(
@@ -349,19 +390,13 @@ bool zip(const char* zipFileName, const char* directoryToZip)
 
   //
   // to make a zip file:
-  // - check that libarchive supports zip writing
   // - check arguments
   // - get a list of files using vtksys Glob
   // - create the archive
-  // -- go file-by-file and add chunks of data to the archive
+  // -- add the files, they are deflated by several threads
   // - close up and return success
   //
 
-// only support the libarchive version 3.0 +
-#if !defined(ARCHIVE_VERSION_NUMBER) || ARCHIVE_VERSION_NUMBER < 3000000
-  return false;
-#endif
-
   if ( !zipFileName || !directoryToZip )
     {
     vtkArchiveTools::Error("Zip:", "Invalid zipfile or directory");
@@ -383,90 +418,29 @@ bool zip(const char* zipFileName, const char* directoryToZip)
     }
   std::vector<std::string> files = glob.GetFiles();
 
-  // now zip it up using LibArchive
-  struct archive *zipArchive;
-  struct archive_entry *entry, *dirEntry;
-  char buff[BUFSIZ];
-  size_t len;
-  // have to read the contents of the files to add them to the archive
-  FILE *fd;
-
-  zipArchive = archive_write_new();
-
-  // create a zip archive
-#ifdef HAVE_ZLIB_H
-  std::string compression_type = "deflate";
-#else
-  std::string compression_type = "store";
-#endif
-
-  archive_write_set_format_zip(zipArchive);
-
-  archive_write_set_format_option(zipArchive, "zip", "compression", compression_type.c_str());
-
-  archive_write_open_filename(zipArchive, zipFileName);
+  vtkArchiveWriter writer;
+  writer.SetNumberOfThreads(vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  if (!writer.Open(zipFileName))
+    {
+    return false;
+    }
 
   // add the data directory
-  dirEntry = archive_entry_new();
-  archive_entry_set_mtime(dirEntry, 11, 110);
-  archive_entry_copy_pathname(dirEntry, directoryName.c_str());
-  archive_entry_set_mode(dirEntry, S_IFDIR | 0755);
-  archive_entry_set_size(dirEntry, 512);
-  archive_write_header(zipArchive, dirEntry);
-  archive_entry_free(dirEntry);
+  writer.AddDirectory(directoryName.c_str());
 
   // add the files
+  std::string parentDirectory = vtksys::SystemTools::GetParentDirectory(directoryToZip);
   std::vector<std::string>::const_iterator sit;
-  sit = files.begin();
-  while (sit != files.end())
+  for (sit = files.begin(); sit != files.end(); ++sit)
     {
-    vtkArchiveTools::Message("Zip: adding:", (*sit).c_str());
-    const char *fileName = (*sit).c_str();
-    ++sit;
-
-    //
-    // add an entry for this file
-    //
-    entry = archive_entry_new();
     // use a relative path for the entry file name, including the top
     // directory so it unzips into a directory of it's own
     std::string relFileName = vtksys::SystemTools::RelativePath(
-              vtksys::SystemTools::GetParentDirectory(directoryToZip).c_str(),
-              fileName);
-    vtkArchiveTools::Message("Zip: adding rel:", relFileName.c_str());
-    archive_entry_set_pathname(entry, relFileName.c_str());
-    // size is required, for now use the vtksys call though it uses struct stat
-    // and may not be portable
-    unsigned long fileLength = vtksys::SystemTools::FileLength(fileName);
-    archive_entry_set_size(entry, fileLength);
-    archive_entry_set_filetype(entry, AE_IFREG);
-    archive_entry_set_perm(entry, 0644);
-    archive_write_header(zipArchive, entry);
-
-    //
-    // add the data for this entry
-    //
-    fd = fopen(fileName, "rb");
-    if (!fd)
-      {
-      vtkArchiveTools::Error("Zip: cannot open:", (*sit).c_str());
-      }
-    else
-      {
-      len = fread(buff, sizeof(char), sizeof(buff), fd);
-      while ( len > 0 )
-        {
-        archive_write_data(zipArchive, buff, len);
-        len = fread(buff, sizeof(char), sizeof(buff), fd);
-        }
-      fclose(fd);
-      }
-    archive_entry_free(entry);
+      parentDirectory.c_str(), sit->c_str());
+    writer.AddFile(relFileName.c_str(), sit->c_str());
     }
 
-  archive_write_close(zipArchive);
-  int retval = archive_write_free(zipArchive);
-  if (retval != ARCHIVE_OK)
+  if (!writer.Close())
     {
     vtkArchiveTools::Error("Zip:", "error on close!");
     return false;
@@ -478,17 +452,6 @@ bool zip(const char* zipFileName, const char* directoryToZip)
 // unzips zip file into destinationDirectory
 bool unzip(const char* zipFileName, const char* destinationDirectory)
 {
-  //
-  // Unziping the archive
-  // - check that files and directories exist
-  // - cd to destination
-  // - create an extracter from the file
-  // - create a writer to disk
-  // - read all headers and data into disk
-  // - close up the archives
-  // - cd back to original directory
-  //
-
   if ( !zipFileName || !destinationDirectory )
     {
     vtkArchiveTools::Error("Unzip:", "Invalid zipfile or directory");
@@ -501,129 +464,1237 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
     return false;
     }
 
+  // Entries are extracted under the destination directory, the current
+  // directory is left untouched.
+  vtkArchiveExtractor extractor;
+  if (!extractor.Open(zipFileName, destinationDirectory))
+    {
+    return false;
+    }
+  bool success = true;
+  while (extractor.NextEntry())
+    {
+    int result = 0;
+    while (result == 0)
+      {
+      result = extractor.ExtractData(1024 * 1024);
+      }
+    success = success && (result == 1);
+    }
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+vtkArchiveExtractor::vtkArchiveExtractor()
+{
+  this->Reader = 0;
+  this->Writer = 0;
+  this->Entry = 0;
+  this->EntryStarted = false;
+  this->EntryDone = false;
+}
+
+//-----------------------------------------------------------------------------
+vtkArchiveExtractor::~vtkArchiveExtractor()
+{
+  this->Close();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveExtractor::Open(const char* archiveFileName, const char* destinationDirectory)
+{
+  this->Close();
+  if ( !archiveFileName || !destinationDirectory )
+    {
+    vtkArchiveTools::Error("Extract:", "Invalid archive or directory");
+    return false;
+    }
   if ( !vtksys::SystemTools::FileIsDirectory(destinationDirectory) )
     {
-    vtkArchiveTools::Error("Unzip:", "Destination is not a directory");
+    vtkArchiveTools::Error("Extract:", "Destination is not a directory");
+    return false;
+    }
+  this->DestinationDirectory = destinationDirectory;
+
+  this->Reader = archive_read_new();
+  archive_read_support_filter_all(this->Reader);
+  archive_read_support_format_all(this->Reader);
+  if (archive_read_open_filename(this->Reader, archiveFileName, 10240) != ARCHIVE_OK)
+    {
+    vtkArchiveTools::Error("Extract: cannot open archive file", archive_error_string(this->Reader));
+    this->Close();
     return false;
     }
 
-  std::string cwd = vtksys::SystemTools::GetCurrentWorkingDirectory(true);
+  this->Writer = archive_write_disk_new();
+  archive_write_disk_set_standard_lookup(this->Writer);
+  archive_write_disk_set_options(this->Writer,
+    ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_SECURE_NODOTDOT | ARCHIVE_EXTRACT_SECURE_SYMLINKS);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkArchiveExtractor::Close()
+{
+  if (this->Reader)
+    {
+    archive_read_close(this->Reader);
+    archive_read_free(this->Reader);
+    this->Reader = 0;
+    }
+  if (this->Writer)
+    {
+    archive_write_close(this->Writer);
+    archive_write_free(this->Writer);
+    this->Writer = 0;
+    }
+  this->Entry = 0;
+  this->EntryPathName.clear();
+  this->EntryStarted = false;
+  this->EntryDone = false;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveExtractor::IsOpen()const
+{
+  return this->Reader != 0;
+}
 
-  if ( vtksys::SystemTools::ChangeDirectory(destinationDirectory) )
+//-----------------------------------------------------------------------------
+bool vtkArchiveExtractor::NextEntry()
+{
+  if (!this->Reader)
     {
-    vtkArchiveTools::Error("Unzip:", "could not change to destination directory");
     return false;
     }
+  if (this->EntryStarted && !this->EntryDone)
+    {
+    // The remaining data of the entry is skipped, only keep what is written.
+    archive_write_finish_entry(this->Writer);
+    }
+  this->Entry = 0;
+  this->EntryPathName.clear();
+  this->EntryStarted = false;
+  this->EntryDone = false;
 
-  struct archive *zipArchive;
-  struct archive *diskDestination;
-  struct archive_entry *entry;
-  int result;
-
-  zipArchive = archive_read_new();
-  // we will typically have zip files, but support all archive types (why not?)
-  archive_read_support_filter_all(zipArchive);
-  archive_read_support_format_all(zipArchive);
-  // Note: the 10240 is just a suggested block size
-  result = archive_read_open_filename(zipArchive, zipFileName, 10240);
-  if (result != ARCHIVE_OK)
+  struct archive_entry* entry = 0;
+  int result = archive_read_next_header(this->Reader, &entry);
+  if (result == ARCHIVE_EOF)
     {
-    vtkArchiveTools::Error("Unzip:", "Cannot open archive file");
     return false;
     }
+  if (result != ARCHIVE_OK)
+    {
+    vtkArchiveTools::Error("Extract error:", archive_error_string(this->Reader));
+    if (result < ARCHIVE_WARN)
+      {
+      return false;
+      }
+    }
+  this->Entry = entry;
+  this->EntryPathName = archive_entry_pathname(entry);
+  return true;
+}
 
-  diskDestination = archive_write_disk_new();
-  archive_write_disk_set_standard_lookup(diskDestination);
+//-----------------------------------------------------------------------------
+std::string vtkArchiveExtractor::GetEntryPathName()const
+{
+  return this->EntryPathName;
+}
 
-  for (;;)
+//-----------------------------------------------------------------------------
+std::string vtkArchiveExtractor::GetEntryFileName()const
+{
+  if (!this->Entry)
     {
-    // for each file entry
-    result = archive_read_next_header(zipArchive, &entry);
-    if (result == ARCHIVE_EOF)
+    return std::string();
+    }
+  return GetFileNameInDirectory(this->EntryPathName, this->DestinationDirectory);
+}
+
+//-----------------------------------------------------------------------------
+long long vtkArchiveExtractor::GetEntrySize()const
+{
+  if (!this->Entry || !archive_entry_size_is_set(this->Entry))
+    {
+    return 0;
+    }
+  return archive_entry_size(this->Entry);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveExtractor::IsEntryDirectory()const
+{
+  return this->Entry && archive_entry_filetype(this->Entry) == AE_IFDIR;
+}
+
+//-----------------------------------------------------------------------------
+int vtkArchiveExtractor::ExtractData(size_t maxBytes, size_t* extractedBytes)
+{
+  if (extractedBytes)
+    {
+    *extractedBytes = 0;
+    }
+  if (!this->Entry)
+    {
+    return -1;
+    }
+  if (this->EntryDone)
+    {
+    return 1;
+    }
+  if (!this->EntryStarted)
+    {
+    // Relative paths are resolved against the destination directory
+    // instead of changing the current directory like unzip() does. The
+    // resolved paths are absolute, so libarchive can't reject ".." and
+    // absolute paths (ARCHIVE_EXTRACT_SECURE_NODOTDOT and
+    // ARCHIVE_EXTRACT_SECURE_NOABSOLUTEPATHS): it is done here.
+    this->EntryStarted = true;
+    std::string fileName = this->GetEntryFileName();
+    if (fileName.empty())
       {
-      break;
+      vtkArchiveTools::Error("Extract error: entry outside of the destination directory:",
+                             this->EntryPathName.c_str());
+      this->EntryDone = true;
+      return -1;
       }
-    if (result != ARCHIVE_OK)
+    archive_entry_copy_pathname(this->Entry, fileName.c_str());
+    const char* hardlink = archive_entry_hardlink(this->Entry);
+    if (hardlink)
       {
-      vtkArchiveTools::Error("Unzip error:", archive_error_string(zipArchive));
-      if (result < ARCHIVE_WARN)
+      std::string linkFileName =
+        GetFileNameInDirectory(hardlink, this->DestinationDirectory);
+      if (linkFileName.empty())
         {
-        break;
+        vtkArchiveTools::Error("Extract error: link outside of the destination directory:",
+                               hardlink);
+        this->EntryDone = true;
+        return -1;
         }
+      archive_entry_copy_hardlink(this->Entry, linkFileName.c_str());
       }
-    result = archive_write_header(diskDestination, entry);
+    int result = archive_write_header(this->Writer, this->Entry);
     if (result != ARCHIVE_OK)
       {
-      vtkArchiveTools::Error("Unzip error:", archive_error_string(diskDestination));
+      vtkArchiveTools::Error("Extract error:", archive_error_string(this->Writer));
       if (result < ARCHIVE_WARN)
         {
-        break;
+        this->EntryDone = true;
+        return -1;
         }
       }
-    else
-      {
-      // copy data
-      const void *buff;
-      size_t size;
+    }
+
+  size_t written = 0;
+  for (;;)
+    {
+    const void *buff;
+    size_t size;
 #if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3000000
-      __LA_INT64_T offset;
+    __LA_INT64_T offset;
 #else
-      off_t offset;
+    off_t offset;
 #endif
-
-      for (;;)
-        {
-        result = archive_read_data_block(zipArchive, &buff, &size, &offset);
-        if (result == ARCHIVE_EOF)
-          {
-          break;
-          }
-        if (result != ARCHIVE_OK)
-          {
-          vtkArchiveTools::Error("Unzip error:", archive_error_string(zipArchive));
-          break;
-          }
-        result = archive_write_data_block(diskDestination, buff, size, offset);
-        if (result != ARCHIVE_OK)
-          {
-          vtkArchiveTools::Error("Unzip error:", archive_error_string(diskDestination));
-          break;
-          }
-        }
+    int result = archive_read_data_block(this->Reader, &buff, &size, &offset);
+    if (result == ARCHIVE_EOF)
+      {
+      break;
+      }
+    if (result != ARCHIVE_OK)
+      {
+      vtkArchiveTools::Error("Extract error:", archive_error_string(this->Reader));
+      this->EntryDone = true;
+      archive_write_finish_entry(this->Writer);
+      return -1;
+      }
+    result = archive_write_data_block(this->Writer, buff, size, offset);
+    if (result != ARCHIVE_OK)
+      {
+      vtkArchiveTools::Error("Extract error:", archive_error_string(this->Writer));
+      this->EntryDone = true;
+      archive_write_finish_entry(this->Writer);
+      return -1;
+      }
+    written += size;
+    if (extractedBytes)
+      {
+      *extractedBytes = written;
+      }
+    if (written >= maxBytes)
+      {
+      return 0;
       }
     }
 
-  result = archive_read_close(zipArchive);
-  if (result != ARCHIVE_OK)
+  this->EntryDone = true;
+  if (archive_write_finish_entry(this->Writer) != ARCHIVE_OK)
     {
-    vtkArchiveTools::Error("Unzip closing zipfile:", archive_error_string(zipArchive));
-    return false;
+    vtkArchiveTools::Error("Extract error:", archive_error_string(this->Writer));
+    return -1;
     }
-  result = archive_read_free(zipArchive);
-  if (result != ARCHIVE_OK)
+  return 1;
+}
+
+namespace
+{
+
+// --------------------------------------------------------------------------
+// Zip format constants, see the PKWARE APPNOTE.TXT.
+const vtkTypeUInt32 ZipLocalHeaderSignature = 0x04034b50;
+const vtkTypeUInt32 ZipCentralHeaderSignature = 0x02014b50;
+const vtkTypeUInt32 ZipEndOfCentralDirectorySignature = 0x06054b50;
+const vtkTypeUInt32 Zip64EndOfCentralDirectorySignature = 0x06064b50;
+const vtkTypeUInt32 Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+const vtkTypeUInt16 ZipStored = 0;
+const vtkTypeUInt16 ZipDeflated = 8;
+const vtkTypeUInt16 ZipVersion = 20;
+const vtkTypeUInt16 Zip64Version = 45;
+// Entries are "made by" Unix so that the permissions are restored.
+const vtkTypeUInt16 ZipVersionMadeBy = (3 << 8) | Zip64Version;
+const vtkTypeUInt32 ZipMax32 = 0xffffffff;
+const vtkTypeUInt16 ZipMax16 = 0xffff;
+// Deflated data may be slightly larger than the input, entries streamed
+// from files that are close to 4GB are written in the Zip64 format.
+const vtkTypeUInt64 ZipMaxSizeWithoutZip64 = 0xf0000000;
+const size_t ZipChunkSize = 1024 * 1024;
+
+// --------------------------------------------------------------------------
+void Put16(std::string& buffer, vtkTypeUInt16 value)
+{
+  buffer += static_cast<char>(value & 0xff);
+  buffer += static_cast<char>((value >> 8) & 0xff);
+}
+
+// --------------------------------------------------------------------------
+void Put32(std::string& buffer, vtkTypeUInt32 value)
+{
+  Put16(buffer, static_cast<vtkTypeUInt16>(value & 0xffff));
+  Put16(buffer, static_cast<vtkTypeUInt16>((value >> 16) & 0xffff));
+}
+
+// --------------------------------------------------------------------------
+void Put64(std::string& buffer, vtkTypeUInt64 value)
+{
+  Put32(buffer, static_cast<vtkTypeUInt32>(value & ZipMax32));
+  Put32(buffer, static_cast<vtkTypeUInt32>((value >> 32) & ZipMax32));
+}
+
+// --------------------------------------------------------------------------
+int SeekFile(FILE* file, vtkTypeUInt64 offset)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+// --------------------------------------------------------------------------
+int TruncateFile(FILE* file, vtkTypeUInt64 size)
+{
+  if (fflush(file) != 0)
+    {
+    return -1;
+    }
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  return _chsize_s(_fileno(file), static_cast<__int64>(size)) == 0 ? 0 : -1;
+#else
+  return ftruncate(fileno(file), static_cast<off_t>(size));
+#endif
+}
+
+// --------------------------------------------------------------------------
+bool GetFileSize(FILE* file, vtkTypeUInt64& size)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  if (_fseeki64(file, 0, SEEK_END) != 0)
     {
-    vtkArchiveTools::Error("Unzip freeing zipfile:", archive_error_string(zipArchive));
     return false;
     }
-  result = archive_write_close(diskDestination);
-  if (result != ARCHIVE_OK)
+  __int64 end = _ftelli64(file);
+#else
+  if (fseeko(file, 0, SEEK_END) != 0)
     {
-    vtkArchiveTools::Error("Unzip closing disk:", archive_error_string(diskDestination));
     return false;
     }
-  result = archive_write_free(diskDestination);
-  if (result != ARCHIVE_OK)
+  off_t end = ftello(file);
+#endif
+  if (end < 0)
     {
-    vtkArchiveTools::Error("Unzip freeing disk:", archive_error_string(diskDestination));
     return false;
     }
+  size = static_cast<vtkTypeUInt64>(end);
+  return SeekFile(file, 0) == 0;
+}
+
+// --------------------------------------------------------------------------
+vtkTypeUInt32 UpdateCrc(vtkTypeUInt32 crc, const unsigned char* data, size_t size)
+{
+  // crc32() takes a 32 bit length
+  while (size > 0)
+    {
+    uInt length = static_cast<uInt>(std::min(size, static_cast<size_t>(1 << 30)));
+    crc = static_cast<vtkTypeUInt32>(crc32(crc, data, length));
+    data += length;
+    size -= length;
+    }
+  return crc;
+}
+
+// --------------------------------------------------------------------------
+void GetDosTime(time_t time, vtkTypeUInt16& dosTime, vtkTypeUInt16& dosDate)
+{
+  struct tm* local = localtime(&time);
+  if (!local || local->tm_year < 80)
+    {
+    // 1980-01-01 is the earliest date of the format
+    dosTime = 0;
+    dosDate = (1 << 5) | 1;
+    return;
+    }
+  dosTime = static_cast<vtkTypeUInt16>(
+    (local->tm_hour << 11) | (local->tm_min << 5) | (local->tm_sec / 2));
+  dosDate = static_cast<vtkTypeUInt16>(
+    ((local->tm_year - 80) << 9) | ((local->tm_mon + 1) << 5) | local->tm_mday);
+}
+
+// --------------------------------------------------------------------------
+bool EndsWith(const std::string& str, const char* suffix)
+{
+  size_t length = strlen(suffix);
+  return str.size() >= length &&
+    str.compare(str.size() - length, length, suffix) == 0;
+}
 
+// --------------------------------------------------------------------------
+// Record of an entry for the central directory.
+struct vtkArchiveWriterEntry
+{
+  vtkArchiveWriterEntry()
+    : Method(ZipStored), Time(0), Date(0), Crc(0), CompressedSize(0), Size(0),
+      Offset(0), ExternalAttributes(0) {}
+  std::string PathName;
+  vtkTypeUInt16 Method;
+  vtkTypeUInt16 Time;
+  vtkTypeUInt16 Date;
+  vtkTypeUInt32 Crc;
+  vtkTypeUInt64 CompressedSize;
+  vtkTypeUInt64 Size;
+  vtkTypeUInt64 Offset;
+  vtkTypeUInt32 ExternalAttributes;
+};
+
+// --------------------------------------------------------------------------
+// File waiting to be read and deflated by a thread.
+struct vtkArchiveWriterFile
+{
+  vtkArchiveWriterFile() : Deflate(true), Size(0), Success(false) {}
+  vtkArchiveWriterEntry Entry;
+  std::string FileName;
+  bool Deflate;
+  vtkTypeUInt64 Size;
+  std::vector<unsigned char> Data;
+  bool Success;
+};
+
+// --------------------------------------------------------------------------
+// Read a file and deflate it in memory. The file is stored instead if
+// deflating does not make it smaller. Only touches the file, so it can run
+// in any thread.
+void CompressFile(vtkArchiveWriterFile& file, int level)
+{
+  file.Success = false;
+  std::vector<unsigned char> input(static_cast<size_t>(file.Size));
+  FILE* fd = fopen(file.FileName.c_str(), "rb");
+  if (!fd)
+    {
+    return;
+    }
+  size_t read = input.empty() ? 0 : fread(&input[0], 1, input.size(), fd);
+  fclose(fd);
+  if (read != input.size())
+    {
+    return;
+    }
+  file.Entry.Crc = UpdateCrc(crc32(0L, Z_NULL, 0),
+                             input.empty() ? 0 : &input[0], input.size());
+  file.Entry.Size = file.Size;
 
-  if ( vtksys::SystemTools::ChangeDirectory(cwd.c_str()) )
+  if (file.Deflate && !input.empty())
     {
-    vtkArchiveTools::Error("Unzip:", "could not change back to working directory");
-    return false;
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) == Z_OK)
+      {
+      file.Data.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+      stream.next_in = &input[0];
+      stream.avail_in = static_cast<uInt>(input.size());
+      stream.next_out = &file.Data[0];
+      stream.avail_out = static_cast<uInt>(file.Data.size());
+      int result = deflate(&stream, Z_FINISH);
+      deflateEnd(&stream);
+      if (result == Z_STREAM_END && stream.total_out < input.size())
+        {
+        file.Data.resize(stream.total_out);
+        file.Entry.Method = ZipDeflated;
+        file.Entry.CompressedSize = stream.total_out;
+        file.Success = true;
+        return;
+        }
+      }
+    }
+  file.Data.swap(input);
+  file.Entry.Method = ZipStored;
+  file.Entry.CompressedSize = file.Size;
+  file.Success = true;
+}
+
+// --------------------------------------------------------------------------
+struct vtkArchiveWriterJob
+{
+  std::vector<vtkArchiveWriterFile>* Files;
+  int Level;
+  size_t NextFile;
+  vtkSimpleCriticalSection Lock;
+};
+
+// --------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE CompressFilesThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkArchiveWriterJob* job = static_cast<vtkArchiveWriterJob*>(info->UserData);
+  // Files are picked one at a time, sizes vary too much for a static split.
+  for (;;)
+    {
+    job->Lock.Lock();
+    size_t index = job->NextFile++;
+    job->Lock.Unlock();
+    if (index >= job->Files->size())
+      {
+      break;
+      }
+    CompressFile((*job->Files)[index], job->Level);
     }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+class vtkArchiveWriter::vtkInternal
+{
+public:
+  vtkInternal();
 
-  return (result == ARCHIVE_OK);
+  bool Write(const void* data, size_t size);
+  bool WriteLocalHeader(const vtkArchiveWriterEntry& entry, bool zip64);
+  bool PatchLocalHeader(const vtkArchiveWriterEntry& entry, bool zip64);
+  bool AddPendingFile(const vtkArchiveWriterFile& file);
+  bool FlushPendingFiles();
+  bool WriteCentralDirectory();
+  bool StreamFile(const vtkArchiveWriterEntry& entry, const char* fileName,
+                  bool deflate, bool zip64);
+  bool BeginEntry(const vtkArchiveWriterEntry& entry, bool deflate, bool zip64);
+  bool WriteEntryData(const unsigned char* data, size_t size);
+  bool EndEntry();
+
+  FILE* File;
+  vtkTypeUInt64 Offset;
+  bool Success;
+
+  int NumberOfThreads;
+  int CompressionLevel;
+  size_t MaximumBufferedEntrySize;
+  size_t MaximumBufferedSize;
+
+  std::vector<vtkArchiveWriterEntry> Entries;
+  std::vector<vtkArchiveWriterFile> PendingFiles;
+  vtkTypeUInt64 PendingBytes;
+
+  // Entry being streamed
+  bool InEntry;
+  bool EntryDeflate;
+  bool EntryZip64;
+  vtkArchiveWriterEntry Entry;
+  vtkTypeUInt64 EntryDataOffset;
+  z_stream Stream;
+  std::vector<unsigned char> Buffer;
+};
+
+//-----------------------------------------------------------------------------
+vtkArchiveWriter::vtkInternal::vtkInternal()
+{
+  this->File = 0;
+  this->Offset = 0;
+  this->Success = true;
+  this->NumberOfThreads = 1;
+  this->CompressionLevel = 6;
+  this->MaximumBufferedEntrySize = 32 * 1024 * 1024;
+  this->MaximumBufferedSize = 256 * 1024 * 1024;
+  this->PendingBytes = 0;
+  this->InEntry = false;
+  this->EntryDeflate = false;
+  this->EntryZip64 = false;
+  this->EntryDataOffset = 0;
+  memset(&this->Stream, 0, sizeof(this->Stream));
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::Write(const void* data, size_t size)
+{
+  if (size > 0 && fwrite(data, 1, size, this->File) != size)
+    {
+    vtkArchiveTools::Error("Zip:", "cannot write the archive");
+    this->Success = false;
+    return false;
+    }
+  this->Offset += size;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::WriteLocalHeader(
+  const vtkArchiveWriterEntry& entry, bool zip64)
+{
+  std::string header;
+  Put32(header, ZipLocalHeaderSignature);
+  Put16(header, zip64 ? Zip64Version : ZipVersion);
+  Put16(header, 0); // flags
+  Put16(header, entry.Method);
+  Put16(header, entry.Time);
+  Put16(header, entry.Date);
+  Put32(header, entry.Crc);
+  Put32(header, zip64 ? ZipMax32 : static_cast<vtkTypeUInt32>(entry.CompressedSize));
+  Put32(header, zip64 ? ZipMax32 : static_cast<vtkTypeUInt32>(entry.Size));
+  Put16(header, static_cast<vtkTypeUInt16>(entry.PathName.size()));
+  Put16(header, zip64 ? 20 : 0);
+  header += entry.PathName;
+  if (zip64)
+    {
+    Put16(header, 0x0001);
+    Put16(header, 16);
+    Put64(header, entry.Size);
+    Put64(header, entry.CompressedSize);
+    }
+  return this->Write(header.data(), header.size());
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::PatchLocalHeader(
+  const vtkArchiveWriterEntry& entry, bool zip64)
+{
+  std::string sizes;
+  Put32(sizes, entry.Crc);
+  Put32(sizes, zip64 ? ZipMax32 : static_cast<vtkTypeUInt32>(entry.CompressedSize));
+  Put32(sizes, zip64 ? ZipMax32 : static_cast<vtkTypeUInt32>(entry.Size));
+  std::string zip64Sizes;
+  Put64(zip64Sizes, entry.Size);
+  Put64(zip64Sizes, entry.CompressedSize);
+
+  // The crc is at offset 14 of the local header, the Zip64 sizes follow
+  // the path name and the extra field header.
+  bool success = SeekFile(this->File, entry.Offset + 14) == 0 &&
+    fwrite(sizes.data(), 1, sizes.size(), this->File) == sizes.size();
+  if (success && zip64)
+    {
+    success = SeekFile(this->File, entry.Offset + 30 + entry.PathName.size() + 4) == 0 &&
+      fwrite(zip64Sizes.data(), 1, zip64Sizes.size(), this->File) == zip64Sizes.size();
+    }
+  success = SeekFile(this->File, this->Offset) == 0 && success;
+  if (!success)
+    {
+    vtkArchiveTools::Error("Zip: cannot write the header of", entry.PathName.c_str());
+    this->Success = false;
+    }
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::AddPendingFile(const vtkArchiveWriterFile& file)
+{
+  // Files and their deflated data are in memory until they are written,
+  // the pending files never add up to more than MaximumBufferedSize.
+  vtkTypeUInt64 maximumSize = this->MaximumBufferedSize;
+  if (this->PendingBytes + file.Size > maximumSize &&
+      !this->FlushPendingFiles())
+    {
+    return false;
+    }
+  this->PendingFiles.push_back(file);
+  this->PendingBytes += file.Size;
+  // Enough files to keep all the threads busy
+  if (this->PendingBytes >= std::min(maximumSize,
+        static_cast<vtkTypeUInt64>(this->MaximumBufferedEntrySize) *
+        this->NumberOfThreads))
+    {
+    return this->FlushPendingFiles();
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::FlushPendingFiles()
+{
+  if (this->PendingFiles.empty())
+    {
+    return true;
+    }
+  vtkArchiveWriterJob job;
+  job.Files = &this->PendingFiles;
+  job.Level = this->CompressionLevel;
+  job.NextFile = 0;
+  int threads = static_cast<int>(std::min(
+    static_cast<size_t>(this->NumberOfThreads), this->PendingFiles.size()));
+  if (threads > 1)
+    {
+    vtkMultiThreader* threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(threads);
+    threader->SetSingleMethod(CompressFilesThread, &job);
+    threader->SingleMethodExecute();
+    threader->Delete();
+    }
+  else
+    {
+    for (size_t i = 0; i < this->PendingFiles.size(); ++i)
+      {
+      CompressFile(this->PendingFiles[i], this->CompressionLevel);
+      }
+    }
+
+  // Write the entries in the order they were added
+  bool success = true;
+  for (size_t i = 0; i < this->PendingFiles.size(); ++i)
+    {
+    vtkArchiveWriterFile& file = this->PendingFiles[i];
+    if (!file.Success)
+      {
+      vtkArchiveTools::Error("Zip: cannot read", file.FileName.c_str());
+      success = false;
+      continue;
+      }
+    file.Entry.Offset = this->Offset;
+    bool zip64 = file.Entry.Size >= ZipMax32 || file.Entry.CompressedSize >= ZipMax32;
+    if (!this->WriteLocalHeader(file.Entry, zip64) ||
+        !this->Write(file.Data.empty() ? 0 : &file.Data[0], file.Data.size()))
+      {
+      success = false;
+      break;
+      }
+    this->Entries.push_back(file.Entry);
+    std::vector<unsigned char>().swap(file.Data);
+    }
+  this->PendingFiles.clear();
+  this->PendingBytes = 0;
+  this->Success = this->Success && success;
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::StreamFile(
+  const vtkArchiveWriterEntry& entry, const char* fileName, bool deflate, bool zip64)
+{
+  FILE* fd = fopen(fileName, "rb");
+  if (!fd)
+    {
+    vtkArchiveTools::Error("Zip: cannot read", fileName);
+    this->Success = false;
+    return false;
+    }
+  bool success = this->BeginEntry(entry, deflate, zip64);
+  std::vector<unsigned char> buffer(ZipChunkSize);
+  size_t read = 0;
+  while (success && (read = fread(&buffer[0], 1, buffer.size(), fd)) > 0)
+    {
+    success = this->WriteEntryData(&buffer[0], read);
+    }
+  if (success && ferror(fd))
+    {
+    vtkArchiveTools::Error("Zip: cannot read", fileName);
+    this->Success = false;
+    success = false;
+    }
+  fclose(fd);
+  success = this->EndEntry() && success;
+  if (success && this->EntryDeflate &&
+      this->Entry.CompressedSize > this->Entry.Size)
+    {
+    // Deflating made the file larger, e.g. compressed data with an unknown
+    // extension: overwrite the entry with the stored file. The local header
+    // has the same size, the archive is truncated by Close().
+    this->Entries.pop_back();
+    if (SeekFile(this->File, entry.Offset) != 0)
+      {
+      vtkArchiveTools::Error("Zip:", "cannot write the archive");
+      this->Success = false;
+      return false;
+      }
+    this->Offset = entry.Offset;
+    return this->StreamFile(entry, fileName, false, zip64);
+    }
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::BeginEntry(
+  const vtkArchiveWriterEntry& entry, bool deflate, bool zip64)
+{
+  this->Entry = entry;
+  this->Entry.Method = deflate ? ZipDeflated : ZipStored;
+  this->Entry.Crc = static_cast<vtkTypeUInt32>(crc32(0L, Z_NULL, 0));
+  this->Entry.Offset = this->Offset;
+  this->EntryDeflate = deflate;
+  this->EntryZip64 = zip64;
+  this->InEntry = true;
+  if (deflate)
+    {
+    memset(&this->Stream, 0, sizeof(this->Stream));
+    if (deflateInit2(&this->Stream, this->CompressionLevel, Z_DEFLATED,
+                     -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      {
+      vtkArchiveTools::Error("Zip: cannot deflate", entry.PathName.c_str());
+      this->Entry.Method = ZipStored;
+      this->EntryDeflate = false;
+      }
+    this->Buffer.resize(ZipChunkSize);
+    }
+  bool success = this->WriteLocalHeader(this->Entry, zip64);
+  this->EntryDataOffset = this->Offset;
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::WriteEntryData(const unsigned char* data, size_t size)
+{
+  this->Entry.Crc = UpdateCrc(this->Entry.Crc, data, size);
+  this->Entry.Size += size;
+  if (!this->EntryDeflate)
+    {
+    return this->Write(data, size);
+    }
+  while (size > 0)
+    {
+    uInt length = static_cast<uInt>(std::min(size, static_cast<size_t>(1 << 30)));
+    this->Stream.next_in = const_cast<Bytef*>(data);
+    this->Stream.avail_in = length;
+    do
+      {
+      this->Stream.next_out = &this->Buffer[0];
+      this->Stream.avail_out = static_cast<uInt>(this->Buffer.size());
+      deflate(&this->Stream, Z_NO_FLUSH);
+      if (!this->Write(&this->Buffer[0], this->Buffer.size() - this->Stream.avail_out))
+        {
+        return false;
+        }
+      }
+    while (this->Stream.avail_out == 0);
+    data += length;
+    size -= length;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::EndEntry()
+{
+  bool success = true;
+  if (this->EntryDeflate)
+    {
+    int result = Z_OK;
+    while (success && result == Z_OK)
+      {
+      this->Stream.next_out = &this->Buffer[0];
+      this->Stream.avail_out = static_cast<uInt>(this->Buffer.size());
+      result = deflate(&this->Stream, Z_FINISH);
+      success = this->Write(&this->Buffer[0], this->Buffer.size() - this->Stream.avail_out);
+      }
+    success = success && result == Z_STREAM_END;
+    deflateEnd(&this->Stream);
+    }
+  this->InEntry = false;
+  this->Entry.CompressedSize = this->Offset - this->EntryDataOffset;
+  if (!this->EntryZip64 &&
+      (this->Entry.Size >= ZipMax32 || this->Entry.CompressedSize >= ZipMax32))
+    {
+    vtkArchiveTools::Error("Zip: file changed while added", this->Entry.PathName.c_str());
+    success = false;
+    }
+  success = success && this->PatchLocalHeader(this->Entry, this->EntryZip64);
+  if (!success)
+    {
+    this->Success = false;
+    return false;
+    }
+  this->Entries.push_back(this->Entry);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::vtkInternal::WriteCentralDirectory()
+{
+  vtkTypeUInt64 directoryOffset = this->Offset;
+  for (size_t i = 0; i < this->Entries.size(); ++i)
+    {
+    const vtkArchiveWriterEntry& entry = this->Entries[i];
+    // Only the values that don't fit are in the Zip64 extra field
+    std::string extra;
+    if (entry.Size >= ZipMax32)
+      {
+      Put64(extra, entry.Size);
+      }
+    if (entry.CompressedSize >= ZipMax32)
+      {
+      Put64(extra, entry.CompressedSize);
+      }
+    if (entry.Offset >= ZipMax32)
+      {
+      Put64(extra, entry.Offset);
+      }
+    bool zip64 = !extra.empty();
+
+    std::string header;
+    Put32(header, ZipCentralHeaderSignature);
+    Put16(header, ZipVersionMadeBy);
+    Put16(header, zip64 ? Zip64Version : ZipVersion);
+    Put16(header, 0); // flags
+    Put16(header, entry.Method);
+    Put16(header, entry.Time);
+    Put16(header, entry.Date);
+    Put32(header, entry.Crc);
+    Put32(header, static_cast<vtkTypeUInt32>(std::min<vtkTypeUInt64>(entry.CompressedSize, ZipMax32)));
+    Put32(header, static_cast<vtkTypeUInt32>(std::min<vtkTypeUInt64>(entry.Size, ZipMax32)));
+    Put16(header, static_cast<vtkTypeUInt16>(entry.PathName.size()));
+    Put16(header, static_cast<vtkTypeUInt16>(zip64 ? extra.size() + 4 : 0));
+    Put16(header, 0); // comment length
+    Put16(header, 0); // disk number
+    Put16(header, 0); // internal attributes
+    Put32(header, entry.ExternalAttributes);
+    Put32(header, static_cast<vtkTypeUInt32>(std::min<vtkTypeUInt64>(entry.Offset, ZipMax32)));
+    header += entry.PathName;
+    if (zip64)
+      {
+      Put16(header, 0x0001);
+      Put16(header, static_cast<vtkTypeUInt16>(extra.size()));
+      header += extra;
+      }
+    if (!this->Write(header.data(), header.size()))
+      {
+      return false;
+      }
+    }
+  vtkTypeUInt64 directorySize = this->Offset - directoryOffset;
+  vtkTypeUInt64 entries = this->Entries.size();
+
+  std::string end;
+  if (entries >= ZipMax16 || directorySize >= ZipMax32 || directoryOffset >= ZipMax32)
+    {
+    vtkTypeUInt64 zip64EndOffset = this->Offset;
+    Put32(end, Zip64EndOfCentralDirectorySignature);
+    Put64(end, 44); // size of the remaining record
+    Put16(end, ZipVersionMadeBy);
+    Put16(end, Zip64Version);
+    Put32(end, 0); // disk number
+    Put32(end, 0); // disk of the central directory
+    Put64(end, entries);
+    Put64(end, entries);
+    Put64(end, directorySize);
+    Put64(end, directoryOffset);
+    Put32(end, Zip64EndOfCentralDirectoryLocatorSignature);
+    Put32(end, 0); // disk of the Zip64 end of central directory
+    Put64(end, zip64EndOffset);
+    Put32(end, 1); // number of disks
+    }
+  Put32(end, ZipEndOfCentralDirectorySignature);
+  Put16(end, 0); // disk number
+  Put16(end, 0); // disk of the central directory
+  Put16(end, static_cast<vtkTypeUInt16>(std::min<vtkTypeUInt64>(entries, ZipMax16)));
+  Put16(end, static_cast<vtkTypeUInt16>(std::min<vtkTypeUInt64>(entries, ZipMax16)));
+  Put32(end, static_cast<vtkTypeUInt32>(std::min<vtkTypeUInt64>(directorySize, ZipMax32)));
+  Put32(end, static_cast<vtkTypeUInt32>(std::min<vtkTypeUInt64>(directoryOffset, ZipMax32)));
+  Put16(end, 0); // comment length
+  return this->Write(end.data(), end.size());
+}
+
+//-----------------------------------------------------------------------------
+vtkArchiveWriter::vtkArchiveWriter()
+{
+  this->Internal = new vtkInternal;
+}
+
+//-----------------------------------------------------------------------------
+vtkArchiveWriter::~vtkArchiveWriter()
+{
+  this->Close();
+  delete this->Internal;
+}
+
+//-----------------------------------------------------------------------------
+void vtkArchiveWriter::SetNumberOfThreads(int threads)
+{
+  this->Internal->NumberOfThreads = std::max(1, std::min(threads, VTK_MAX_THREADS));
+}
+
+//-----------------------------------------------------------------------------
+int vtkArchiveWriter::GetNumberOfThreads()const
+{
+  return this->Internal->NumberOfThreads;
+}
+
+//-----------------------------------------------------------------------------
+void vtkArchiveWriter::SetCompressionLevel(int level)
+{
+  this->Internal->CompressionLevel = std::max(1, std::min(level, 9));
+}
+
+//-----------------------------------------------------------------------------
+int vtkArchiveWriter::GetCompressionLevel()const
+{
+  return this->Internal->CompressionLevel;
+}
+
+//-----------------------------------------------------------------------------
+void vtkArchiveWriter::SetMaximumBufferedEntrySize(size_t size)
+{
+  // deflateBound() and deflate() take 32 bit sizes
+  this->Internal->MaximumBufferedEntrySize = std::min(size, static_cast<size_t>(1 << 30));
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkArchiveWriter::GetMaximumBufferedEntrySize()const
+{
+  return this->Internal->MaximumBufferedEntrySize;
+}
+
+//-----------------------------------------------------------------------------
+void vtkArchiveWriter::SetMaximumBufferedSize(size_t size)
+{
+  this->Internal->MaximumBufferedSize = size;
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkArchiveWriter::GetMaximumBufferedSize()const
+{
+  return this->Internal->MaximumBufferedSize;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::Open(const char* zipFileName)
+{
+  this->Close();
+  if (!zipFileName)
+    {
+    vtkArchiveTools::Error("Zip:", "Invalid zipfile");
+    return false;
+    }
+  this->Internal->File = fopen(zipFileName, "wb");
+  if (!this->Internal->File)
+    {
+    vtkArchiveTools::Error("Zip: cannot create", zipFileName);
+    return false;
+    }
+  this->Internal->Offset = 0;
+  this->Internal->Success = true;
+  this->Internal->Entries.clear();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::Close()
+{
+  if (!this->Internal->File)
+    {
+    return false;
+    }
+  if (this->Internal->InEntry)
+    {
+    this->Internal->EndEntry();
+    }
+  this->Internal->FlushPendingFiles();
+  this->Internal->WriteCentralDirectory();
+  // Remove what is left of entries rewritten as stored
+  if (TruncateFile(this->Internal->File, this->Internal->Offset) != 0)
+    {
+    vtkArchiveTools::Error("Zip:", "cannot write the archive");
+    this->Internal->Success = false;
+    }
+  if (fclose(this->Internal->File) != 0)
+    {
+    vtkArchiveTools::Error("Zip:", "cannot close the archive");
+    this->Internal->Success = false;
+    }
+  this->Internal->File = 0;
+  this->Internal->Entries.clear();
+  return this->Internal->Success;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::IsOpen()const
+{
+  return this->Internal->File != 0;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::AddDirectory(const char* pathName)
+{
+  if (!this->Internal->File || this->Internal->InEntry || !pathName)
+    {
+    return false;
+    }
+  if (!this->Internal->FlushPendingFiles())
+    {
+    return false;
+    }
+  vtkArchiveWriterEntry entry;
+  entry.PathName = pathName;
+  if (!EndsWith(entry.PathName, "/"))
+    {
+    entry.PathName += "/";
+    }
+  GetDosTime(time(0), entry.Time, entry.Date);
+  entry.Crc = static_cast<vtkTypeUInt32>(crc32(0L, Z_NULL, 0));
+  entry.Offset = this->Internal->Offset;
+  // drwxr-xr-x, and the MS-DOS directory attribute
+  entry.ExternalAttributes = (040755u << 16) | 0x10;
+  if (!this->Internal->WriteLocalHeader(entry, false))
+    {
+    return false;
+    }
+  this->Internal->Entries.push_back(entry);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::AddFile(const char* pathName, const char* fileName,
+                               CompressionType compression)
+{
+  if (!this->Internal->File || this->Internal->InEntry || !pathName || !fileName)
+    {
+    return false;
+    }
+  FILE* fd = fopen(fileName, "rb");
+  vtkTypeUInt64 size = 0;
+  bool hasSize = fd && GetFileSize(fd, size);
+  if (fd)
+    {
+    fclose(fd);
+    }
+  if (!hasSize)
+    {
+    vtkArchiveTools::Error("Zip: cannot read", fileName);
+    this->Internal->Success = false;
+    return false;
+    }
+
+  vtkArchiveWriterFile file;
+  file.Entry.PathName = pathName;
+  GetDosTime(static_cast<time_t>(vtksys::SystemTools::ModifiedTime(fileName)),
+             file.Entry.Time, file.Entry.Date);
+  // -rw-r--r--
+  file.Entry.ExternalAttributes = 0100644u << 16;
+  file.FileName = fileName;
+  file.Size = size;
+  file.Deflate = compression == Deflate ||
+    (compression == Automatic && !vtkArchiveWriter::IsCompressedFile(fileName));
+
+  if (size > this->Internal->MaximumBufferedEntrySize ||
+      size > this->Internal->MaximumBufferedSize)
+    {
+    // Too large to hold in memory, deflate it while it is written
+    return this->Internal->FlushPendingFiles() &&
+      this->Internal->StreamFile(file.Entry, fileName, file.Deflate,
+                                 size >= ZipMaxSizeWithoutZip64);
+    }
+  return this->Internal->AddPendingFile(file);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::BeginEntry(const char* pathName, CompressionType compression)
+{
+  if (!this->Internal->File || this->Internal->InEntry || !pathName)
+    {
+    return false;
+    }
+  if (!this->Internal->FlushPendingFiles())
+    {
+    return false;
+    }
+  vtkArchiveWriterEntry entry;
+  entry.PathName = pathName;
+  GetDosTime(time(0), entry.Time, entry.Date);
+  entry.ExternalAttributes = 0100644u << 16;
+  // The size is unknown, the Zip64 sizes are always written
+  return this->Internal->BeginEntry(entry, compression != Store, true);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::WriteData(const void* data, size_t size)
+{
+  if (!this->Internal->InEntry || (!data && size > 0))
+    {
+    return false;
+    }
+  return this->Internal->WriteEntryData(static_cast<const unsigned char*>(data), size);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::EndEntry()
+{
+  if (!this->Internal->InEntry)
+    {
+    return false;
+    }
+  return this->Internal->EndEntry();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkArchiveWriter::IsCompressedFile(const char* fileName)
+{
+  if (!fileName)
+    {
+    return false;
+    }
+  std::string name = vtksys::SystemTools::LowerCase(
+    vtksys::SystemTools::GetFilenameName(fileName));
+  const char* compressedExtensions[] = {
+    ".gz", ".tgz", ".bz2", ".xz", ".zip", ".mrb",
+    ".png", ".jpg", ".jpeg",
+    ".vtp", ".vtu", ".vti", ".vts", ".vtr", 0};
+  for (int i = 0; compressedExtensions[i]; ++i)
+    {
+    if (EndsWith(name, compressedExtensions[i]))
+      {
+      return true;
+      }
+    }
+  if (!EndsWith(name, ".nrrd"))
+    {
+    return false;
+    }
+
+  // Attached NRRD header: look for "encoding: gzip" before the data
+  FILE* fd = fopen(fileName, "rb");
+  if (!fd)
+    {
+    return false;
+    }
+  char buffer[4096];
+  size_t read = fread(buffer, 1, sizeof(buffer), fd);
+  fclose(fd);
+  std::string header(buffer, read);
+  size_t headerEnd = std::min(header.find("\n\n"), header.find("\r\n\r\n"));
+  if (headerEnd != std::string::npos)
+    {
+    header.resize(headerEnd);
+    }
+  header = vtksys::SystemTools::LowerCase(header);
+  size_t encoding = header.find("\nencoding:");
+  if (encoding == std::string::npos)
+    {
+    return false;
+    }
+  std::string value = header.substr(encoding + strlen("\nencoding:"));
+  value = value.substr(0, value.find_first_of("\r\n"));
+  value.erase(0, value.find_first_not_of(" \t"));
+  return value.compare(0, 2, "gz") == 0 || value.compare(0, 2, "bz") == 0;
 }
@@ -37,13 +37,181 @@ VTK_MRML_LOGIC_EXPORT bool extract_tar(const char* tarFileName, bool verbose, bo
 
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
+// Files are compressed on all the cores (see vtkArchiveWriter), files that
+// are already compressed (.nrrd.gz, .vtp, .png...) are stored as is.
+// The directory is not removed.
 VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip);
 
 // unzips zip file into specified directory
 // (internally this supports many formats of archive, not just zip)
+// The current directory is not changed (see vtkArchiveExtractor).
 VTK_MRML_LOGIC_EXPORT bool unzip(const char* zipFileName, const char *destinationDirectory);
 #ifdef __cplusplus
 }
 #endif
 
+struct archive;
+struct archive_entry;
+
+// Extracts an archive entry by entry, and each entry chunk by chunk, into
+// a destination directory. Unlike unzip(), the current directory is not
+// changed and the caller decides which entries are extracted and when,
+// e.g. to extract a scene file before the data files it references:
+//
+//   vtkArchiveExtractor extractor;
+//   extractor.Open("scene.mrb", "/tmp/scene");
+//   while (extractor.NextEntry())
+//     {
+//     if (wanted(extractor.GetEntryPathName()))
+//       {
+//       while (extractor.ExtractData(1024 * 1024) == 0) {}
+//       }
+//     }
+//
+// Entries are written under the destination directory. Entries with an
+// absolute path or with ".." leading outside of the destination directory
+// are rejected, like links to files outside of it.
+class VTK_MRML_LOGIC_EXPORT vtkArchiveExtractor
+{
+public:
+  vtkArchiveExtractor();
+  ~vtkArchiveExtractor();
+
+  // Open the archive for reading. Returns false if the archive can't be
+  // read or the destination is not a directory.
+  bool Open(const char* archiveFileName, const char* destinationDirectory);
+  void Close();
+  bool IsOpen()const;
+
+  // Move to the next entry of the archive, the data of the current entry
+  // not extracted yet is skipped. Returns false at the end of the archive
+  // or on error.
+  bool NextEntry();
+
+  // Path of the current entry in the archive, and of the file it is
+  // extracted into (empty if the entry is outside of the destination).
+  std::string GetEntryPathName()const;
+  std::string GetEntryFileName()const;
+
+  // Uncompressed size in bytes of the current entry, 0 if unknown.
+  long long GetEntrySize()const;
+  bool IsEntryDirectory()const;
+
+  // Extract about maxBytes of the current entry (whole blocks are
+  // written), or what is left of it.
+  // extractedBytes, if not null, receives the number of bytes written.
+  // Returns 1 when the entry is fully extracted, 0 if there is more data
+  // to extract and -1 on error.
+  int ExtractData(size_t maxBytes, size_t* extractedBytes = 0);
+
+private:
+  vtkArchiveExtractor(const vtkArchiveExtractor&); // Not implemented
+  void operator=(const vtkArchiveExtractor&); // Not implemented
+
+  struct archive* Reader;
+  struct archive* Writer;
+  struct archive_entry* Entry;
+  std::string DestinationDirectory;
+  std::string EntryPathName;
+  bool EntryStarted;
+  bool EntryDone;
+};
+
+// Writes a zip archive entry by entry. Files are read from disk and
+// written into the archive without an intermediate copy, and entries can
+// also be streamed from memory:
+//
+//   vtkArchiveWriter writer;
+//   writer.SetNumberOfThreads(4);
+//   writer.Open("scene.mrb");
+//   writer.AddDirectory("scene");
+//   writer.AddFile("scene/Data/volume.nrrd", "/path/to/volume.nrrd");
+//   writer.BeginEntry("scene/scene.mrml");
+//   writer.WriteData(xml.c_str(), xml.size());
+//   writer.EndEntry();
+//   writer.Close();
+//
+// Entries are either deflated or stored. With Automatic compression, files
+// that are already compressed (see IsCompressedFile()) are stored, which
+// is as small and much faster than deflating them again.
+//
+// The entries are independent, so files up to MaximumBufferedEntrySize
+// are deflated in memory by NumberOfThreads threads and written in the
+// order they were added. Larger files and streamed entries are deflated
+// on the calling thread while they are written; a file that deflating
+// makes larger is then written again, stored.
+//
+// Entries and archives larger than 4GB are written in the Zip64 format.
+//
+// Slicer data bundles (.mrb) only use it through zip(): the scene and its
+// data are still saved into a directory first (the storage nodes write
+// files), and loading a bundle extracts all of it (see unzip()).
+// BeginEntry() is for callers that produce entries in memory.
+class VTK_MRML_LOGIC_EXPORT vtkArchiveWriter
+{
+public:
+  enum CompressionType
+    {
+    Automatic = 0,
+    Store,
+    Deflate
+    };
+
+  vtkArchiveWriter();
+  ~vtkArchiveWriter();
+
+  // Number of threads deflating the files, 1 by default.
+  void SetNumberOfThreads(int threads);
+  int GetNumberOfThreads()const;
+
+  // zlib compression level, from 1 (fastest) to 9 (smallest), 6 by default.
+  void SetCompressionLevel(int level);
+  int GetCompressionLevel()const;
+
+  // Files up to this size in bytes are deflated in memory by the threads.
+  // Larger files are deflated while they are written. 32MB by default.
+  void SetMaximumBufferedEntrySize(size_t size);
+  size_t GetMaximumBufferedEntrySize()const;
+
+  // Total size in bytes of the files deflated in memory at once, whatever
+  // the number of threads. The memory used is at most about twice this
+  // size. 256MB by default.
+  void SetMaximumBufferedSize(size_t size);
+  size_t GetMaximumBufferedSize()const;
+
+  // Create the archive, an existing file is overwritten.
+  bool Open(const char* zipFileName);
+  // Write the pending entries and the central directory, and close the
+  // file. Returns false if the archive or any of its entries could not be
+  // written.
+  bool Close();
+  bool IsOpen()const;
+
+  // Add a directory entry, pathName is relative to the archive root.
+  bool AddDirectory(const char* pathName);
+
+  // Add the file fileName as the entry pathName. The file may be read
+  // and written later, by Close() at the latest.
+  bool AddFile(const char* pathName, const char* fileName,
+               CompressionType compression = Automatic);
+
+  // Stream an entry: BeginEntry(), then WriteData() any number of times,
+  // and EndEntry(). Automatic compression deflates the data.
+  bool BeginEntry(const char* pathName, CompressionType compression = Automatic);
+  bool WriteData(const void* data, size_t size);
+  bool EndEntry();
+
+  // Return true if the file content is already compressed: gzip, zip, bzip2
+  // and image files, VTK XML files (compressed by default) and NRRD files
+  // with a gzip or bzip2 encoding.
+  static bool IsCompressedFile(const char* fileName);
+
+private:
+  vtkArchiveWriter(const vtkArchiveWriter&); // Not implemented
+  void operator=(const vtkArchiveWriter&); // Not implemented
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
 #endif
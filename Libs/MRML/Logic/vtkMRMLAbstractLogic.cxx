@@ -20,6 +20,9 @@
 #include "vtkMRMLNode.h"
 #include "vtkMRMLScene.h"
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkObjectFactory.h>
@@ -169,7 +172,11 @@ void vtkMRMLAbstractLogic::MRMLSceneCallback(vtkObject*caller, unsigned long eid
   self->SetInMRMLSceneCallbackFlag(self->GetInMRMLSceneCallbackFlag() + 1);
   int oldProcessingEvent = self->GetProcessingMRMLSceneEvent();
   self->SetProcessingMRMLSceneEvent(eid);
+  {
+  vtkTraceZoneWithDetailMacro(self->GetClassName(), "ProcessMRMLSceneEvents",
+                              vtkCommand::GetStringFromEventId(eid));
   self->ProcessMRMLSceneEvents(caller, eid, callData);
+  }
   self->SetProcessingMRMLSceneEvent(oldProcessingEvent);
   self->SetInMRMLSceneCallbackFlag(self->GetInMRMLSceneCallbackFlag() - 1);
 }
@@ -195,7 +202,11 @@ void vtkMRMLAbstractLogic::MRMLNodesCallback(vtkObject* caller, unsigned long ei
   vtkDebugWithObjectMacro(self, "In vtkMRMLAbstractLogic MRMLNodesCallback");
 
   self->SetInMRMLNodesCallbackFlag(self->GetInMRMLNodesCallbackFlag() + 1);
+  {
+  vtkTraceZoneWithDetailMacro(self->GetClassName(), "ProcessMRMLNodesEvents",
+                              vtkCommand::GetStringFromEventId(eid));
   self->ProcessMRMLNodesEvents(caller, eid, callData);
+  }
   self->SetInMRMLNodesCallbackFlag(self->GetInMRMLNodesCallbackFlag() - 1);
 }
 
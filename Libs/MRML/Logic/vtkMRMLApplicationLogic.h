@@ -126,10 +126,14 @@ public:
   void PropagateTableSelection();
 
   /// zip the directory into a zip file
+  /// The files of the directory, e.g. saved by
+  /// SaveSceneToSlicerDataBundleDirectory, are compressed in parallel.
   /// Returns success or failure.
+  /// \sa zip(), vtkArchiveWriter
   bool Zip(const char *zipFileName, const char *directoryToZip);
 
-  /// unzip the zip file to the current working directory
+  /// unzip the zip file into destinationDirectory, all the entries are
+  /// extracted. The current working directory is not changed.
   /// Returns success or failure.
   bool Unzip(const char *zipFileName, const char *destinationDirectory);
 
@@ -147,6 +151,8 @@ public:
   /// Save the scene into a self contained directory, sdbDir
   /// Called by the qSlicerSceneWriter, which can be accessed via
   /// \sa qSlicerCoreIOManager::saveScene
+  /// The scene file and the data files are written in sdbDir, Zip() then
+  /// archives the directory into a data bundle (.mrb).
   /// If screenShot is not null, use it as the screen shot for a scene view
   /// Returns false if the save failed
   bool SaveSceneToSlicerDataBundleDirectory(const char *sdbDir, vtkImageData *screenShot = NULL);
@@ -23,6 +23,7 @@
 #include "vtkMRMLPETProceduralColorNode.h"
 #include "vtkMRMLProceduralColorStorageNode.h"
 #include "vtkMRMLScene.h"
+#include "vtkMRMLStorageNode.h"
 
 // VTK sys includes
 #include <vtkLookupTable.h>
@@ -30,20 +31,159 @@
 
 // VTK includes
 #include <vtkColorTransferFunction.h>
+#include <vtkDebugLeaks.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
 
 // STD includes
 #include <cassert>
+#include <map>
 
 std::string vtkMRMLColorLogic::TempColorNodeID;
 
 vtkStandardNewMacro(vtkMRMLColorLogic);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Default color nodes shared by all the color logics of the process.
+// The colors of a default node are computed (or read from file) the first
+// time the node is added to a scene, the node is then kept here and the
+// nodes added to the scenes are copies of it. Only the lookup tables of the
+// built-in table types are shared between the scenes, the node API doesn't
+// allow to modify them; code changing the lookup table of a default node
+// directly (GetLookupTable()->SetTableValue()) changes it in all the scenes.
+struct SharedColorNode
+{
+  vtkSmartPointer<vtkMRMLColorNode> Node;
+  // File the colors were read from, empty for the built-in nodes
+  std::string FileName;
+};
+typedef std::map<std::string, SharedColorNode> SharedColorNodeMap;
+
+//----------------------------------------------------------------------------
+SharedColorNodeMap& SharedColorNodes()
+{
+  static SharedColorNodeMap sharedColorNodes;
+  return sharedColorNodes;
+}
+
+// The shared nodes are released with the last color logic, not at exit
+int NumberOfColorLogics = 0;
+
+//----------------------------------------------------------------------------
+bool HasSharedColorNode(const std::string& key)
+{
+  return SharedColorNodes().find(key) != SharedColorNodes().end();
+}
+
+//----------------------------------------------------------------------------
+// Keep colorNode as the shared node of key. File based nodes are read with a
+// storage node added to the scene, remove it: the shared node belongs to no
+// scene.
+void SetSharedColorNode(const std::string& key, vtkMRMLColorNode* colorNode, vtkMRMLScene* scene)
+{
+  SharedColorNode& sharedColorNode = SharedColorNodes()[key];
+  sharedColorNode.Node = colorNode;
+  vtkMRMLStorageNode* storageNode = colorNode->GetStorageNode();
+  if (storageNode)
+    {
+    sharedColorNode.FileName = storageNode->GetFileName() ? storageNode->GetFileName() : "";
+    colorNode->SetAndObserveStorageNodeID(NULL);
+    scene->RemoveNode(storageNode);
+    }
+  colorNode->SetScene(NULL);
+}
+
+//----------------------------------------------------------------------------
+// Add to the scene a copy of the shared node of key. The copy shares the
+// colors of the shared node, they are not recomputed.
+void AddSharedColorNode(const std::string& key, vtkMRMLScene* scene)
+{
+  SharedColorNodeMap::iterator it = SharedColorNodes().find(key);
+  if (it == SharedColorNodes().end())
+    {
+    return;
+    }
+  vtkMRMLColorNode* sharedNode = it->second.Node;
+  vtkMRMLColorNode* node = vtkMRMLColorNode::SafeDownCast(sharedNode->CreateNodeInstance());
+  // Copy() shares the lookup table and deep copies the color transfer
+  // function of procedural nodes: the colors of the built-in table types
+  // can't be changed (see vtkMRMLColorTableNode::SetColor()), the color
+  // transfer functions can be edited and are small.
+  node->Copy(sharedNode);
+  if (!it->second.FileName.empty())
+    {
+    // the colors of a file node can be edited, it gets its own copy of the
+    // table, which is still much faster than reading the file again
+    vtkMRMLColorTableNode* tableNode = vtkMRMLColorTableNode::SafeDownCast(node);
+    if (tableNode && tableNode->GetLookupTable())
+      {
+      vtkNew<vtkLookupTable> lookupTable;
+      lookupTable->DeepCopy(tableNode->GetLookupTable());
+      tableNode->SetLookupTable(lookupTable.GetPointer());
+      }
+    // file based nodes keep a storage node to know where they come from, the
+    // file is not read again
+    node->SetScene(scene);
+    vtkNew<vtkMRMLColorTableStorageNode> colorStorageNode;
+    colorStorageNode->SaveWithSceneOff();
+    colorStorageNode->SetFileName(it->second.FileName.c_str());
+    scene->AddNode(colorStorageNode.GetPointer());
+    node->SetAndObserveStorageNodeID(colorStorageNode->GetID());
+    }
+  scene->AddNode(node);
+  node->Delete();
+}
+
+//----------------------------------------------------------------------------
+// Color node that only stores its type: SetType() computes the colors, the
+// IDs of the default nodes only need the type name.
+template <class T>
+class TypeColorNode : public T
+{
+public:
+  static TypeColorNode* New()
+    {
+    TypeColorNode* node = new TypeColorNode;
+#ifdef VTK_DEBUG_LEAKS
+    vtkDebugLeaks::ConstructClass(node->GetClassName());
+#endif
+    return node;
+    }
+  void SetTypeOnly(int type) { this->Type = type; }
+};
+
+//----------------------------------------------------------------------------
+// The default node IDs are looked up often (e.g. by RemoveDefaultColorNodes),
+// they are computed once per type and cached. No colors are computed, the
+// default tables are built the first time they are added to a scene.
+template <class T>
+const std::string& DefaultColorNodeID(int type)
+{
+  static std::map<int, std::string> nodeIDs;
+  std::map<int, std::string>::iterator it = nodeIDs.find(type);
+  if (it == nodeIDs.end())
+    {
+    vtkSmartPointer<TypeColorNode<T> > basicNode =
+      vtkSmartPointer<TypeColorNode<T> >::Take(TypeColorNode<T>::New());
+    basicNode->SetTypeOnly(type);
+    std::string id = std::string(basicNode->GetClassName()) +
+                     std::string(basicNode->GetTypeAsString());
+    it = nodeIDs.insert(std::make_pair(type, id)).first;
+    }
+  return it->second;
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkMRMLColorLogic::vtkMRMLColorLogic()
 {
   this->UserColorFilePaths = NULL;
+  ++NumberOfColorLogics;
 }
 
 //----------------------------------------------------------------------------
@@ -61,6 +201,11 @@ vtkMRMLColorLogic::~vtkMRMLColorLogic()
     delete [] this->UserColorFilePaths;
     this->UserColorFilePaths = NULL;
     }
+
+  if (--NumberOfColorLogics == 0)
+    {
+    SharedColorNodes().clear();
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -276,33 +421,29 @@ void vtkMRMLColorLogic::RemoveDefaultColorNodes()
 //----------------------------------------------------------------------------
 const char *vtkMRMLColorLogic::GetColorTableNodeID(int type)
 {
-  vtkNew<vtkMRMLColorTableNode> basicNode;
-  basicNode->SetType(type);
-  return vtkMRMLColorLogic::GetColorNodeID(basicNode.GetPointer());
+  vtkMRMLColorLogic::TempColorNodeID = DefaultColorNodeID<vtkMRMLColorTableNode>(type);
+  return vtkMRMLColorLogic::TempColorNodeID.c_str();
 }
 
 //----------------------------------------------------------------------------
 const char * vtkMRMLColorLogic::GetFreeSurferColorNodeID(int type)
 {
-  vtkNew<vtkMRMLFreeSurferProceduralColorNode> basicNode;
-  basicNode->SetType(type);
-  return vtkMRMLColorLogic::GetColorNodeID(basicNode.GetPointer());
+  vtkMRMLColorLogic::TempColorNodeID = DefaultColorNodeID<vtkMRMLFreeSurferProceduralColorNode>(type);
+  return vtkMRMLColorLogic::TempColorNodeID.c_str();
 }
 
 //----------------------------------------------------------------------------
 const char * vtkMRMLColorLogic::GetPETColorNodeID (int type )
 {
-  vtkNew<vtkMRMLPETProceduralColorNode> basicNode;
-  basicNode->SetType(type);
-  return vtkMRMLColorLogic::GetColorNodeID(basicNode.GetPointer());
+  vtkMRMLColorLogic::TempColorNodeID = DefaultColorNodeID<vtkMRMLPETProceduralColorNode>(type);
+  return vtkMRMLColorLogic::TempColorNodeID.c_str();
 }
 
 //----------------------------------------------------------------------------
 const char * vtkMRMLColorLogic::GetdGEMRICColorNodeID(int type)
 {
-  vtkNew<vtkMRMLdGEMRICProceduralColorNode> basicNode;
-  basicNode->SetType(type);
-  return vtkMRMLColorLogic::GetColorNodeID(basicNode.GetPointer());
+  vtkMRMLColorLogic::TempColorNodeID = DefaultColorNodeID<vtkMRMLdGEMRICProceduralColorNode>(type);
+  return vtkMRMLColorLogic::TempColorNodeID.c_str();
 }
 
 //----------------------------------------------------------------------------
@@ -796,137 +937,131 @@ vtkMRMLProceduralColorNode* vtkMRMLColorLogic::CreateProceduralFileNode(const ch
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddLabelsNode()
 {
-  vtkMRMLColorTableNode* labelsNode = this->CreateLabelsNode();
-  //if (this->GetMRMLScene()->GetNodeByID(labelsNode->GetSingletonTag()) == NULL)
+  std::string key = this->GetColorTableNodeID(vtkMRMLColorTableNode::Labels);
+  if (!HasSharedColorNode(key))
     {
-    //this->GetMRMLScene()->RequestNodeID(labelsNode, labelsNode->GetSingletonTag());
-    this->GetMRMLScene()->AddNode(labelsNode);
+    vtkMRMLColorTableNode* labelsNode = this->CreateLabelsNode();
+    SetSharedColorNode(key, labelsNode, this->GetMRMLScene());
+    labelsNode->Delete();
     }
-  labelsNode->Delete();
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddDefaultTableNode(int i)
 {
-  vtkMRMLColorTableNode* node = this->CreateDefaultTableNode(i);
-  //if (node->GetSingletonTag())
+  std::string key = this->GetColorTableNodeID(i);
+  if (!HasSharedColorNode(key))
     {
-    //if (this->GetMRMLScene()->GetNodeByID(node->GetSingletonTag()) == NULL)
-      {
-      vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: requesting id " << node->GetSingletonTag() << endl);
-      //this->GetMRMLScene()->RequestNodeID(node, node->GetSingletonTag());
-      this->GetMRMLScene()->AddNode(node);
-      vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: added node " << node->GetID() << ", requested id was " << node->GetSingletonTag() << ", type = " << node->GetTypeAsString() << endl);
-      }
-    //else
-    //  {
-    //  vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: didn't add node " << node->GetID() << " as it was already in the scene.\n");
-    //  }
+    vtkMRMLColorTableNode* node = this->CreateDefaultTableNode(i);
+    SetSharedColorNode(key, node, this->GetMRMLScene());
+    node->Delete();
     }
-  node->Delete();
+  vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: adding node " << key << endl);
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddDefaultProceduralNodes()
 {
   // random one
-  vtkMRMLProceduralColorNode* randomNode = this->CreateRandomNode();
-  this->GetMRMLScene()->AddNode(randomNode);
-  randomNode->Delete();
+  std::string randomKey = this->GetProceduralColorNodeID("RandomIntegers");
+  if (!HasSharedColorNode(randomKey))
+    {
+    vtkMRMLProceduralColorNode* randomNode = this->CreateRandomNode();
+    SetSharedColorNode(randomKey, randomNode, this->GetMRMLScene());
+    randomNode->Delete();
+    }
+  AddSharedColorNode(randomKey, this->GetMRMLScene());
 
   // red green blue one
-  vtkMRMLProceduralColorNode* rgbNode = this->CreateRedGreenBlueNode();
-  this->GetMRMLScene()->AddNode(rgbNode);
-  rgbNode->Delete();
+  std::string rgbKey = this->GetProceduralColorNodeID("RedGreenBlue");
+  if (!HasSharedColorNode(rgbKey))
+    {
+    vtkMRMLProceduralColorNode* rgbNode = this->CreateRedGreenBlueNode();
+    SetSharedColorNode(rgbKey, rgbNode, this->GetMRMLScene());
+    rgbNode->Delete();
+    }
+  AddSharedColorNode(rgbKey, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddFreeSurferNode(int type)
 {
-  vtkMRMLFreeSurferProceduralColorNode* node = this->CreateFreeSurferNode(type);
-  //if (this->GetMRMLScene()->GetNodeByID(node->GetSingletonTag()) == NULL)
+  std::string key = this->GetFreeSurferColorNodeID(type);
+  if (!HasSharedColorNode(key))
     {
-    //this->GetMRMLScene()->RequestNodeID(node, node->GetSingletonTag());
-    this->GetMRMLScene()->AddNode(node);
-    vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: added node " << node->GetID() << ", requested id was " << node->GetSingletonTag()<< ", type = " << node->GetTypeAsString() << endl);
+    vtkMRMLFreeSurferProceduralColorNode* node = this->CreateFreeSurferNode(type);
+    SetSharedColorNode(key, node, this->GetMRMLScene());
+    node->Delete();
     }
-  //else
-  //  {
-  //  vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: didn't add node " << node->GetID() << " as it was already in the scene.\n");
-  //  }
-  node->Delete();
+  vtkDebugMacro("vtkMRMLColorLogic::AddDefaultColorNodes: adding node " << key << endl);
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddFreeSurferFileNode(vtkMRMLFreeSurferProceduralColorNode* basicFSNode)
 {
-  vtkMRMLColorTableNode* node = this->CreateFreeSurferFileNode(basicFSNode->GetLabelsFileName());
-  if (node)
+  const char* fileName = basicFSNode->GetLabelsFileName();
+  std::string key = std::string("FreeSurferLabels") + (fileName ? fileName : "");
+  if (!HasSharedColorNode(key))
     {
-    //if (this->GetMRMLScene()->GetNodeByID(node->GetSingletonTag()) == NULL)
+    vtkMRMLColorTableNode* node = this->CreateFreeSurferFileNode(fileName);
+    if (!node)
       {
-      //this->GetMRMLScene()->RequestNodeID(node, node->GetSingletonTag());
-      this->GetMRMLScene()->AddNode(node);
+      return;
       }
-    //else
-    //  {
-    //  vtkDebugMacro("Unable to add a new colour node " << node->GetSingletonTag()
-    //                << " with freesurfer colours, from file: "
-    //                << node->GetStorageNode()->GetFileName()
-    //                << " as there is already a node with this id in the scene");
-    //  }
+    SetSharedColorNode(key, node, this->GetMRMLScene());
     node->Delete();
     }
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddPETNode(int type)
 {
   vtkDebugMacro("AddDefaultColorNodes: adding PET nodes");
-  vtkMRMLPETProceduralColorNode *nodepcn = this->CreatePETColorNode(type);
-  //if (this->GetMRMLScene()->GetNodeByID( nodepcn->GetSingletonTag() ) == NULL)
+  std::string key = this->GetPETColorNodeID(type);
+  if (!HasSharedColorNode(key))
     {
-    //this->GetMRMLScene()->RequestNodeID(nodepcn, nodepcn->GetSingletonTag() );
-    this->GetMRMLScene()->AddNode(nodepcn);
+    vtkMRMLPETProceduralColorNode *nodepcn = this->CreatePETColorNode(type);
+    SetSharedColorNode(key, nodepcn, this->GetMRMLScene());
+    nodepcn->Delete();
     }
-  nodepcn->Delete();
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddDGEMRICNode(int type)
 {
   vtkDebugMacro("AddDefaultColorNodes: adding dGEMRIC nodes");
-  vtkMRMLdGEMRICProceduralColorNode *pcnode = this->CreatedGEMRICColorNode(type);
-  //if (this->GetMRMLScene()->GetNodeByID(pcnode->GetSingletonTag()) == NULL)
+  std::string key = this->GetdGEMRICColorNodeID(type);
+  if (!HasSharedColorNode(key))
     {
-    //this->GetMRMLScene()->RequestNodeID(pcnode, pcnode->GetSingletonTag());
-    this->GetMRMLScene()->AddNode(pcnode);
+    vtkMRMLdGEMRICProceduralColorNode *pcnode = this->CreatedGEMRICColorNode(type);
+    SetSharedColorNode(key, pcnode, this->GetMRMLScene());
+    pcnode->Delete();
     }
-  pcnode->Delete();
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
 void vtkMRMLColorLogic::AddDefaultFileNode(int i)
 {
-  vtkMRMLColorTableNode* ctnode =  this->CreateDefaultFileNode(this->ColorFiles[i]);
-  if (ctnode)
+  std::string key = this->GetFileColorNodeID(this->ColorFiles[i].c_str());
+  if (!HasSharedColorNode(key))
     {
-    //if (this->GetMRMLScene()->GetNodeByID(ctnode->GetSingletonTag()) == NULL)
+    vtkMRMLColorTableNode* ctnode =  this->CreateDefaultFileNode(this->ColorFiles[i]);
+    if (!ctnode)
       {
-        //this->GetMRMLScene()->RequestNodeID(ctnode, ctnode->GetSingletonTag());
-        this->GetMRMLScene()->AddNode(ctnode);
-        ctnode->Delete();
-        vtkDebugMacro("AddDefaultColorFiles: Read and added file node: " <<  this->ColorFiles[i].c_str());
+      vtkWarningMacro("Unable to read color file " << this->ColorFiles[i].c_str());
+      return;
       }
-    //else
-    //  {
-    //  vtkDebugMacro("AddDefaultColorFiles: node " << ctnode->GetSingletonTag() << " already in scene");
-    //  }
-    }
-  else
-    {
-    vtkWarningMacro("Unable to read color file " << this->ColorFiles[i].c_str());
+    SetSharedColorNode(key, ctnode, this->GetMRMLScene());
+    ctnode->Delete();
+    vtkDebugMacro("AddDefaultColorFiles: Read file node: " <<  this->ColorFiles[i].c_str());
     }
+  AddSharedColorNode(key, this->GetMRMLScene());
 }
 
 //----------------------------------------------------------------------------------------
@@ -945,12 +1080,12 @@ void vtkMRMLColorLogic::AddUserFileNode(int i)
     //  {
     //  vtkDebugMacro("AddDefaultColorFiles: node " << ctnode->GetSingletonTag() << " already in scene");
     //  }
+    ctnode->Delete();
     }
   else
     {
     vtkWarningMacro("Unable to read user color file " << this->UserColorFiles[i].c_str());
     }
-  ctnode->Delete();
 }
 
 //----------------------------------------------------------------------------------------
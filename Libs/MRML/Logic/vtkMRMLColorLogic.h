@@ -49,6 +49,11 @@ public:
   /// Each node is a singleton and is not included in a saved scene. The color
   /// node singleton tags are the same as the node IDs:
   /// vtkMRMLColorTableNodeGrey, vtkMRMLPETProceduralColorNodeHeat, etc.
+  /// The colors of a default node are computed (or read from file) the first
+  /// time the node is added to a scene and are then copied into the default
+  /// nodes of the other scenes of the process. The lookup tables of the
+  /// built-in table types are shared, they must not be modified directly,
+  /// use CopyNode to edit colors. The user color files are not shared.
   virtual void AddDefaultColorNodes();
 
   /// Remove the colour nodes that were added
@@ -0,0 +1,731 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkArchive.h"
+#include "vtkMRMLSceneLoader.h"
+
+// MRML includes
+#include <vtkMRMLDisplayableNode.h>
+#include <vtkMRMLDisplayNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLStorableNode.h>
+#include <vtkMRMLStorageNode.h>
+
+// vtkAddon includes
+#include <vtkTracer.h>
+
+// VTK includes
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+//----------------------------------------------------------------------------
+class vtkMRMLSceneLoader::vtkInternal
+{
+public:
+  vtkInternal();
+  void Reset();
+
+  /// Entry of the bundle.
+  struct EntryType
+  {
+    EntryType() : Size(0), Directory(false), Extracted(false), VolumeFile(false) {}
+    std::string FileName;
+    long long Size;
+    bool Directory;
+    bool Extracted;
+    /// True if a volume node reads the entry, it is extracted first.
+    bool VolumeFile;
+  };
+  typedef std::map<std::string, EntryType> EntryMapType;
+
+  /// Storable node whose data is not read yet.
+  struct PendingNodeType
+  {
+    vtkSmartPointer<vtkMRMLStorableNode> Node;
+    std::vector<std::string> FileNames;
+    bool Volume;
+  };
+  typedef std::vector<PendingNodeType> PendingNodeListType;
+
+  bool IsReady(const PendingNodeType& pendingNode)const;
+
+  bool Loading;
+  bool Importing;
+  bool Canceled;
+  bool Failed;
+  int Progress;
+
+  std::string SceneFileName;
+
+  EntryMapType Entries;
+  /// Files of the bundle that are not extracted yet.
+  std::set<std::string> FilesToExtract;
+  /// Files of the bundle read by the pending nodes.
+  std::set<std::string> NodeFiles;
+  vtkArchiveExtractor Extractor;
+  bool Extracting;
+  /// 0 when extracting the volume files, 1 for the other files.
+  int ExtractionPass;
+  bool ExtractingEntry;
+  long long BytesToExtract;
+  long long ExtractedBytes;
+
+  PendingNodeListType PendingNodes;
+  int NumberOfNodesToRead;
+  int NumberOfReadNodes;
+};
+
+//----------------------------------------------------------------------------
+vtkMRMLSceneLoader::vtkInternal::vtkInternal()
+{
+  this->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::vtkInternal::Reset()
+{
+  this->Loading = false;
+  this->Importing = false;
+  this->Canceled = false;
+  this->Failed = false;
+  this->Progress = 0;
+  this->SceneFileName.clear();
+  this->Entries.clear();
+  this->FilesToExtract.clear();
+  this->NodeFiles.clear();
+  this->Extractor.Close();
+  this->Extracting = false;
+  this->ExtractionPass = 0;
+  this->ExtractingEntry = false;
+  this->BytesToExtract = 0;
+  this->ExtractedBytes = 0;
+  this->PendingNodes.clear();
+  this->NumberOfNodesToRead = 0;
+  this->NumberOfReadNodes = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::vtkInternal::IsReady(const PendingNodeType& pendingNode)const
+{
+  for (std::vector<std::string>::const_iterator it = pendingNode.FileNames.begin();
+       it != pendingNode.FileNames.end(); ++it)
+    {
+    if (this->FilesToExtract.count(*it))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLSceneLoader);
+
+//----------------------------------------------------------------------------
+vtkMRMLSceneLoader::vtkMRMLSceneLoader()
+{
+  this->FileName = 0;
+  this->TemporaryDirectory = 0;
+  this->Clear = false;
+  this->ChunkSize = 4 * 1024 * 1024;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSceneLoader::~vtkMRMLSceneLoader()
+{
+  this->Cancel();
+  this->SetFileName(0);
+  this->SetTemporaryDirectory(0);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << "\n";
+  os << indent << "TemporaryDirectory: "
+     << (this->TemporaryDirectory ? this->TemporaryDirectory : "(none)") << "\n";
+  os << indent << "Clear: " << this->Clear << "\n";
+  os << indent << "ChunkSize: " << this->ChunkSize << "\n";
+  os << indent << "Loading: " << this->Internal->Loading << "\n";
+  os << indent << "Progress: " << this->Internal->Progress << "\n";
+  os << indent << "NumberOfPendingNodes: " << this->GetNumberOfPendingNodes() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::SetMRMLSceneInternal(vtkMRMLScene* newScene)
+{
+  // The nodes of the previous scene can't be read anymore.
+  this->Cancel();
+
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  events->InsertNextValue(vtkMRMLScene::StartCloseEvent);
+  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+  if (!this->Internal->Importing)
+    {
+    return;
+    }
+  vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+  if (!storableNode || storableNode->GetNumberOfStorageNodes() == 0)
+    {
+    return;
+    }
+  // vtkMRMLScene::Import() only calls UpdateScene(), that reads the data,
+  // on the nodes to add to the scene. The data is read later by ReadNode().
+  storableNode->SetAddToSceneNoModify(0);
+  vtkInternal::PendingNodeType pendingNode;
+  pendingNode.Node = storableNode;
+  pendingNode.Volume = storableNode->IsA("vtkMRMLVolumeNode") != 0;
+  this->Internal->PendingNodes.push_back(pendingNode);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  vtkInternal::PendingNodeListType& pendingNodes = this->Internal->PendingNodes;
+  for (vtkInternal::PendingNodeListType::iterator it = pendingNodes.begin();
+       it != pendingNodes.end(); ++it)
+    {
+    if (it->Node.GetPointer() == node)
+      {
+      // Removed nodes are restored as regular nodes by undo.
+      node->SetAddToSceneNoModify(1);
+      pendingNodes.erase(it);
+      ++this->Internal->NumberOfReadNodes;
+      return;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::OnMRMLSceneStartClose()
+{
+  if (!this->Internal->Loading || this->Internal->Importing)
+    {
+    return;
+    }
+  // The scene state can't be ended while the scene is closing, the next
+  // Step() finishes the load.
+  this->Internal->Canceled = true;
+  this->Internal->Extracting = false;
+  this->Internal->Extractor.Close();
+  this->Internal->FilesToExtract.clear();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::Start()
+{
+  vtkTraceZoneWithDetailMacro("Start", "MRMLSceneLoader", this->FileName);
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  if (this->Internal->Loading)
+    {
+    vtkErrorMacro("Start: a scene is already loading");
+    return false;
+    }
+  if (!scene || !this->FileName)
+    {
+    vtkErrorMacro("Start: no scene or no file name");
+    return false;
+    }
+  this->Internal->Reset();
+
+  std::string extension = vtksys::SystemTools::LowerCase(
+    vtksys::SystemTools::GetFilenameLastExtension(this->FileName));
+  if (extension == ".mrml")
+    {
+    this->Internal->SceneFileName = this->FileName;
+    }
+  else if (!this->StartExtraction())
+    {
+    return false;
+    }
+
+  this->Internal->Loading = true;
+  scene->StartState(vtkMRMLScene::ReadDataState, 100);
+
+  bool res = this->ImportScene();
+  if (!res && this->Internal->PendingNodes.empty())
+    {
+    this->Finish();
+    return false;
+    }
+  this->Internal->Failed = !res;
+  this->CollectPendingFiles();
+  this->UpdateProgress();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::StartExtraction()
+{
+  if (!this->TemporaryDirectory)
+    {
+    vtkErrorMacro("StartExtraction: no temporary directory to extract "
+                  << this->FileName);
+    return false;
+    }
+  vtkArchiveExtractor& extractor = this->Internal->Extractor;
+  // List the entries, the scene file is the shallowest .mrml file.
+  if (!extractor.Open(this->FileName, this->TemporaryDirectory))
+    {
+    vtkErrorMacro("StartExtraction: could not open bundle file " << this->FileName);
+    return false;
+    }
+  std::string sceneEntry;
+  size_t sceneEntryDepth = std::string::npos;
+  while (extractor.NextEntry())
+    {
+    std::string pathName = extractor.GetEntryPathName();
+    vtkInternal::EntryType entry;
+    entry.FileName = extractor.GetEntryFileName();
+    entry.Size = extractor.GetEntrySize();
+    entry.Directory = extractor.IsEntryDirectory();
+    this->Internal->Entries[pathName] = entry;
+    if (!entry.Directory &&
+        vtksys::SystemTools::LowerCase(
+          vtksys::SystemTools::GetFilenameLastExtension(pathName)) == ".mrml")
+      {
+      size_t depth = std::count(pathName.begin(), pathName.end(), '/');
+      if (sceneEntry.empty() || depth < sceneEntryDepth)
+        {
+        sceneEntry = pathName;
+        sceneEntryDepth = depth;
+        }
+      }
+    }
+  extractor.Close();
+  if (sceneEntry.empty())
+    {
+    vtkErrorMacro("StartExtraction: could not find mrml file in archive " << this->FileName);
+    return false;
+    }
+
+  // Extract the scene file only
+  int res = -1;
+  extractor.Open(this->FileName, this->TemporaryDirectory);
+  while (extractor.NextEntry())
+    {
+    if (extractor.GetEntryPathName() == sceneEntry)
+      {
+      while ((res = extractor.ExtractData(this->ChunkSize)) == 0)
+        {
+        }
+      break;
+      }
+    }
+  extractor.Close();
+  if (res != 1)
+    {
+    vtkErrorMacro("StartExtraction: could not extract " << sceneEntry);
+    return false;
+    }
+  vtkInternal::EntryType& entry = this->Internal->Entries[sceneEntry];
+  entry.Extracted = true;
+  this->Internal->SceneFileName = entry.FileName;
+
+  for (vtkInternal::EntryMapType::const_iterator it = this->Internal->Entries.begin();
+       it != this->Internal->Entries.end(); ++it)
+    {
+    if (!it->second.Extracted && !it->second.Directory)
+      {
+      this->Internal->FilesToExtract.insert(it->second.FileName);
+      this->Internal->BytesToExtract += it->second.Size;
+      }
+    }
+  this->Internal->Extracting = true;
+  this->Internal->ExtractionPass = 0;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::ImportScene()
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  scene->SetURL(this->Internal->SceneFileName.c_str());
+  this->Internal->Importing = true;
+  int res = this->Clear ? scene->Connect() : scene->Import();
+  this->Internal->Importing = false;
+  return res != 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::CollectPendingFiles()
+{
+  std::map<std::string, vtkInternal::EntryType*> entriesByFileName;
+  for (vtkInternal::EntryMapType::iterator it = this->Internal->Entries.begin();
+       it != this->Internal->Entries.end(); ++it)
+    {
+    entriesByFileName[it->second.FileName] = &it->second;
+    }
+
+  vtkInternal::PendingNodeListType& pendingNodes = this->Internal->PendingNodes;
+  for (vtkInternal::PendingNodeListType::iterator it = pendingNodes.begin();
+       it != pendingNodes.end(); ++it)
+    {
+    vtkMRMLStorableNode* node = it->Node;
+    for (int i = 0; i < node->GetNumberOfStorageNodes(); ++i)
+      {
+      vtkMRMLStorageNode* storageNode = node->GetNthStorageNode(i);
+      if (!storageNode)
+        {
+        continue;
+        }
+      // -1 is the archetype file name
+      for (int n = -1; n < storageNode->GetNumberOfFileNames(); ++n)
+        {
+        std::string fileName = storageNode->GetFullNameFromNthFileName(n);
+        if (fileName.empty())
+          {
+          continue;
+          }
+        fileName = vtksys::SystemTools::CollapseFullPath(fileName.c_str());
+        it->FileNames.push_back(fileName);
+        this->Internal->NodeFiles.insert(fileName);
+        std::map<std::string, vtkInternal::EntryType*>::iterator entryIt =
+          entriesByFileName.find(fileName);
+        if (it->Volume && entryIt != entriesByFileName.end())
+          {
+          entryIt->second->VolumeFile = true;
+          }
+        }
+      }
+    }
+  this->Internal->NumberOfNodesToRead = static_cast<int>(pendingNodes.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::Step()
+{
+  if (!this->Internal->Loading)
+    {
+    return false;
+    }
+  vtkMRMLStorableNode* node = this->GetNextNodeToRead();
+  if (node)
+    {
+    this->ReadNode(node);
+    }
+  else if (this->Internal->Extracting)
+    {
+    this->Internal->Extracting = this->ExtractChunk();
+    }
+  else if (!this->Internal->PendingNodes.empty())
+    {
+    // Files missing from the bundle, the storage nodes report the error.
+    this->ReadNode(this->Internal->PendingNodes.front().Node);
+    }
+
+  if (!this->Internal->Extracting && this->Internal->PendingNodes.empty())
+    {
+    this->Finish();
+    return false;
+    }
+  this->UpdateProgress();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::ExtractChunk()
+{
+  vtkTraceZoneMacro("ExtractChunk", "MRMLSceneLoader");
+  vtkInternal* internal = this->Internal;
+  vtkArchiveExtractor& extractor = internal->Extractor;
+  long long budget = this->ChunkSize;
+  while (budget > 0)
+    {
+    if (!internal->ExtractingEntry)
+      {
+      if (!extractor.IsOpen() &&
+          !extractor.Open(this->FileName, this->TemporaryDirectory))
+        {
+        internal->Failed = true;
+        internal->FilesToExtract.clear();
+        return false;
+        }
+      if (!extractor.NextEntry())
+        {
+        extractor.Close();
+        if (++internal->ExtractionPass > 1)
+          {
+          internal->FilesToExtract.clear();
+          return false;
+          }
+        continue;
+        }
+      vtkInternal::EntryMapType::iterator entryIt =
+        internal->Entries.find(extractor.GetEntryPathName());
+      if (entryIt == internal->Entries.end() ||
+          entryIt->second.Extracted ||
+          (internal->ExtractionPass == 0 && !entryIt->second.VolumeFile))
+        {
+        continue;
+        }
+      internal->ExtractingEntry = true;
+      }
+
+    size_t extractedBytes = 0;
+    int res = extractor.ExtractData(static_cast<size_t>(budget), &extractedBytes);
+    internal->ExtractedBytes += extractedBytes;
+    budget -= static_cast<long long>(extractedBytes);
+    if (res == 0)
+      {
+      continue;
+      }
+    internal->ExtractingEntry = false;
+    vtkInternal::EntryType& entry = internal->Entries[extractor.GetEntryPathName()];
+    entry.Extracted = true;
+    internal->FilesToExtract.erase(entry.FileName);
+    if (res < 0)
+      {
+      vtkErrorMacro("ExtractChunk: could not extract " << extractor.GetEntryPathName());
+      internal->Failed = true;
+      }
+    if (internal->NodeFiles.count(entry.FileName))
+      {
+      // A node may be ready to be read.
+      break;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLStorableNode* vtkMRMLSceneLoader::GetNextNodeToRead()const
+{
+  vtkMRMLStorableNode* nextNode = 0;
+  const vtkInternal::PendingNodeListType& pendingNodes = this->Internal->PendingNodes;
+  for (vtkInternal::PendingNodeListType::const_iterator it = pendingNodes.begin();
+       it != pendingNodes.end(); ++it)
+    {
+    if (!this->Internal->IsReady(*it))
+      {
+      continue;
+      }
+    if (it->Volume)
+      {
+      return it->Node;
+      }
+    if (!nextNode)
+      {
+      nextNode = it->Node;
+      }
+    }
+  return nextNode;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::ReadNode(vtkMRMLStorableNode* node)
+{
+  vtkTraceZoneWithDetailMacro("ReadNode", "MRMLSceneLoader", node->GetID());
+  // Keep the node alive while it is removed from the pending nodes.
+  vtkSmartPointer<vtkMRMLStorableNode> nodeToRead = node;
+  vtkInternal::PendingNodeListType& pendingNodes = this->Internal->PendingNodes;
+  for (vtkInternal::PendingNodeListType::iterator it = pendingNodes.begin();
+       it != pendingNodes.end(); ++it)
+    {
+    if (it->Node.GetPointer() == node)
+      {
+      pendingNodes.erase(it);
+      break;
+      }
+    }
+  ++this->Internal->NumberOfReadNodes;
+
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  node->SetAddToSceneNoModify(1);
+  if (node->GetScene() != scene)
+    {
+    return;
+    }
+  // Only report the errors of this node, previous errors are kept.
+  unsigned long previousErrorCode = scene->GetErrorCode();
+  std::string previousErrorMessage = scene->GetErrorMessage();
+  scene->SetErrorCode(0);
+  node->UpdateScene(scene);
+  if (scene->GetErrorCode() != 0)
+    {
+    vtkErrorMacro("ReadNode: " << scene->GetErrorMessage());
+    this->Internal->Failed = true;
+    }
+  else
+    {
+    scene->SetErrorCode(previousErrorCode);
+    scene->SetErrorMessage(previousErrorMessage);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::Cancel()
+{
+  if (!this->Internal->Loading)
+    {
+    return;
+    }
+  this->Internal->Canceled = true;
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  // OnMRMLSceneNodeRemoved() is not needed anymore.
+  vtkInternal::PendingNodeListType pendingNodes;
+  pendingNodes.swap(this->Internal->PendingNodes);
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  for (vtkInternal::PendingNodeListType::iterator it = pendingNodes.begin();
+       it != pendingNodes.end(); ++it)
+    {
+    vtkMRMLStorableNode* node = it->Node;
+    node->SetAddToSceneNoModify(1);
+    if (node->GetScene() != scene)
+      {
+      continue;
+      }
+    std::vector<vtkSmartPointer<vtkMRMLNode> > nodesToRemove;
+    vtkMRMLDisplayableNode* displayableNode = vtkMRMLDisplayableNode::SafeDownCast(node);
+    for (int i = 0; displayableNode && i < displayableNode->GetNumberOfDisplayNodes(); ++i)
+      {
+      nodesToRemove.push_back(displayableNode->GetNthDisplayNode(i));
+      }
+    for (int i = 0; i < node->GetNumberOfStorageNodes(); ++i)
+      {
+      nodesToRemove.push_back(node->GetNthStorageNode(i));
+      }
+    nodesToRemove.push_back(node);
+    for (std::vector<vtkSmartPointer<vtkMRMLNode> >::iterator nodeIt = nodesToRemove.begin();
+         nodeIt != nodesToRemove.end(); ++nodeIt)
+      {
+      if (nodeIt->GetPointer() && (*nodeIt)->GetScene() == scene)
+        {
+        scene->RemoveNode(*nodeIt);
+        }
+      }
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  this->Finish();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::Run()
+{
+  if (!this->Start())
+    {
+    return false;
+    }
+  while (this->Step())
+    {
+    }
+  return this->IsSuccessful();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::Finish()
+{
+  if (!this->Internal->Loading)
+    {
+    return;
+    }
+  this->Internal->Loading = false;
+  this->Internal->Extracting = false;
+  this->Internal->ExtractingEntry = false;
+  this->Internal->Extractor.Close();
+  for (vtkInternal::PendingNodeListType::iterator it = this->Internal->PendingNodes.begin();
+       it != this->Internal->PendingNodes.end(); ++it)
+    {
+    it->Node->SetAddToSceneNoModify(1);
+    }
+  this->Internal->PendingNodes.clear();
+  if (!this->Internal->Canceled)
+    {
+    this->Internal->Progress = 100;
+    this->GetMRMLScene()->ProgressState(vtkMRMLScene::ReadDataState, 100);
+    }
+  this->GetMRMLScene()->EndState(vtkMRMLScene::ReadDataState);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneLoader::UpdateProgress()
+{
+  // Extracting the bundle is half of the work.
+  double extractionWeight = this->Internal->BytesToExtract > 0 ? 0.5 : 0.;
+  double extraction = this->Internal->BytesToExtract > 0 ?
+    static_cast<double>(this->Internal->ExtractedBytes) / this->Internal->BytesToExtract : 1.;
+  double reading = this->Internal->NumberOfNodesToRead > 0 ?
+    static_cast<double>(this->Internal->NumberOfReadNodes) / this->Internal->NumberOfNodesToRead : 1.;
+  int progress = static_cast<int>(100. * (extractionWeight * std::min(extraction, 1.) +
+                                          (1. - extractionWeight) * std::min(reading, 1.)));
+  // 100 is reported when the load is done.
+  progress = std::min(progress, 99);
+  if (progress == this->Internal->Progress)
+    {
+    return;
+    }
+  this->Internal->Progress = progress;
+  this->GetMRMLScene()->ProgressState(vtkMRMLScene::ReadDataState, progress);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::IsLoading()const
+{
+  return this->Internal->Loading;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::IsCanceled()const
+{
+  return this->Internal->Canceled;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneLoader::IsSuccessful()const
+{
+  return !this->Internal->Loading && !this->Internal->Canceled && !this->Internal->Failed;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSceneLoader::GetProgress()const
+{
+  return this->Internal->Progress;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLSceneLoader::GetSceneFileName()const
+{
+  return this->Internal->SceneFileName;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSceneLoader::GetNumberOfPendingNodes()const
+{
+  return static_cast<int>(this->Internal->PendingNodes.size());
+}
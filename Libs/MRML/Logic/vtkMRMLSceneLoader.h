@@ -0,0 +1,166 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkMRMLSceneLoader_h
+#define __vtkMRMLSceneLoader_h
+
+// MRMLLogic includes
+#include "vtkMRMLAbstractLogic.h"
+
+// STD includes
+#include <string>
+
+class vtkMRMLStorableNode;
+
+/// \brief Load a scene file (.mrml) or a scene bundle (.mrb) step by step.
+///
+/// Unlike vtkMRMLScene::Connect() or Import(), the loader returns as soon as
+/// the scene file is parsed: the nodes are in the scene but their data is
+/// not read yet. Each call to Step() then extracts a chunk of the bundle or
+/// reads the data of one node, volumes first, so that the application can
+/// process its events (render the views, handle a cancel button) between
+/// two steps. Nodes are shown in the views as soon as their data is read.
+///
+/// \code
+/// vtkNew<vtkMRMLSceneLoader> loader;
+/// loader->SetMRMLScene(scene);
+/// loader->SetFileName("scene.mrb");
+/// loader->SetTemporaryDirectory("/tmp/scene");
+/// if (loader->Start())
+///   {
+///   while (loader->Step())
+///     {
+///     processEvents();
+///     }
+///   }
+/// \endcode
+///
+/// The scene is in \link vtkMRMLScene::ReadDataState ReadDataState \endlink
+/// from Start() until the last step, the progress (0 to 100) is reported with
+/// vtkMRMLScene::ProgressReadDataEvent. The scene is imported within that
+/// state: vtkMRMLScene::EndImportEvent is invoked by Start(), before the
+/// data of the nodes is read. Each node invokes its own data event (e.g.
+/// vtkMRMLVolumeNode::ImageDataModifiedEvent) when its data is read and
+/// vtkMRMLScene::EndReadDataEvent is invoked once all the data is read.
+///
+/// Processing the application events between two steps lets the user
+/// trigger other loads and saves: the application must refuse them until the
+/// load is done. Slicer only loads step by step the scenes loaded from the
+/// GUI (see the "interactive" property of qSlicerCoreIOManager::loadNodes()),
+/// scripts and tests load them with Run().
+///
+/// Bundles are extracted into TemporaryDirectory entry by entry, the scene
+/// file first, then the files of the volumes, then the other files. The
+/// caller is responsible for removing the directory.
+///
+/// \sa vtkMRMLScene::ReadDataState, vtkArchiveExtractor
+class VTK_MRML_LOGIC_EXPORT vtkMRMLSceneLoader : public vtkMRMLAbstractLogic
+{
+public:
+  static vtkMRMLSceneLoader *New();
+  vtkTypeMacro(vtkMRMLSceneLoader, vtkMRMLAbstractLogic);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Scene file (.mrml) or bundle (.mrb, .zip) to load.
+  vtkSetStringMacro(FileName);
+  vtkGetStringMacro(FileName);
+
+  /// Existing directory where a bundle is extracted.
+  vtkSetStringMacro(TemporaryDirectory);
+  vtkGetStringMacro(TemporaryDirectory);
+
+  /// If on, the scene is cleared before loading, like with
+  /// vtkMRMLScene::Connect(). Otherwise the loaded nodes are added to the
+  /// scene, like with vtkMRMLScene::Import(). Off by default.
+  vtkSetMacro(Clear, bool);
+  vtkGetMacro(Clear, bool);
+  vtkBooleanMacro(Clear, bool);
+
+  /// Number of bytes extracted from the bundle by a Step().
+  /// 4MB by default.
+  vtkSetClampMacro(ChunkSize, int, 1, VTK_INT_MAX);
+  vtkGetMacro(ChunkSize, int);
+
+  /// Extract and parse the scene file, and add its nodes to the scene
+  /// without reading their data. Returns false if the scene can't be
+  /// parsed, nothing is left to do then.
+  bool Start();
+
+  /// Extract a chunk of the bundle or read the data of a node.
+  /// Returns true while there is something left to do.
+  bool Step();
+
+  /// Stop loading: the nodes whose data is not read yet are removed from
+  /// the scene with their display and storage nodes.
+  void Cancel();
+
+  /// Start() and Step() until the scene is loaded.
+  /// Returns true if the scene is loaded without error.
+  bool Run();
+
+  /// Return true between Start() and the end of the last Step().
+  bool IsLoading()const;
+
+  /// Return true if the load was canceled with Cancel() or because the
+  /// scene was closed.
+  bool IsCanceled()const;
+
+  /// Return true if the load is done and the data of all the nodes was read.
+  bool IsSuccessful()const;
+
+  /// Progress of the load, from 0 to 100.
+  int GetProgress()const;
+
+  /// Scene file that is loaded: FileName or the scene file extracted from
+  /// the bundle.
+  std::string GetSceneFileName()const;
+
+  /// Number of nodes whose data is not read yet.
+  int GetNumberOfPendingNodes()const;
+
+protected:
+  vtkMRMLSceneLoader();
+  virtual ~vtkMRMLSceneLoader();
+
+  virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene);
+  virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+  virtual void OnMRMLSceneStartClose();
+
+  bool StartExtraction();
+  bool ImportScene();
+  void CollectPendingFiles();
+  bool ExtractChunk();
+  vtkMRMLStorableNode* GetNextNodeToRead()const;
+  void ReadNode(vtkMRMLStorableNode* node);
+  void Finish();
+  void UpdateProgress();
+
+  char* FileName;
+  char* TemporaryDirectory;
+  bool Clear;
+  int ChunkSize;
+
+private:
+  vtkMRMLSceneLoader(const vtkMRMLSceneLoader&); // Not implemented
+  void operator=(const vtkMRMLSceneLoader&); // Not implemented
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
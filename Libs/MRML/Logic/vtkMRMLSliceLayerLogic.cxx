@@ -542,13 +542,13 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
     vtkMRMLTransformNode *transformNode = this->VolumeNode->GetParentTransformNode();
     if ( transformNode != 0 )
       {
-      vtkNew<vtkGeneralTransform> worldTransform;
-      worldTransform->Identity();
-      transformNode->GetTransformFromWorld(worldTransform.GetPointer());
-      //worldTransform->Inverse();
-
-      this->XYToIJKTransform->Concatenate(worldTransform.GetPointer());
-      this->UVWToIJKTransform->Concatenate(worldTransform.GetPointer());
+      // The compiled transform merges the linear transforms of the
+      // hierarchy, fewer transforms are evaluated at each resliced voxel.
+      // It is a snapshot that the node never modifies, a new one is
+      // concatenated here on TransformModifiedEvent.
+      vtkAbstractTransform* worldTransform = transformNode->GetCompiledTransformFromWorld();
+      this->XYToIJKTransform->Concatenate(worldTransform);
+      this->UVWToIJKTransform->Concatenate(worldTransform);
       }
 
     vtkNew<vtkMatrix4x4> rasToIJK;
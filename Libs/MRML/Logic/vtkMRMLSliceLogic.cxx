@@ -28,6 +28,9 @@
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSliceCompositeNode.h>
 
+// vtkAddon includes
+#include <vtkTracer.h>
+
 // VTK includes
 #include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
@@ -952,6 +955,7 @@ void vtkMRMLSliceLogic::UpdateImageData ()
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdatePipeline()
 {
+  vtkTraceZoneWithDetailMacro("UpdatePipeline", "vtkMRMLSliceLogic", this->GetName());
   int modified = 0;
   if ( this->SliceCompositeNode )
     {
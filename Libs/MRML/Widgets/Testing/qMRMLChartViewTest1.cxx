@@ -0,0 +1,148 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QWebFrame>
+
+// qMRML includes
+#include "qMRMLChartView.h"
+
+// MRML includes
+#include <vtkMRMLChartNode.h>
+#include <vtkMRMLChartViewNode.h>
+#include <vtkMRMLDoubleArrayNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void PrintElapsedTime(const char* name, int numberOfPoints, vtkTimerLog* timer)
+{
+  std::cout << "<DartMeasurement name=\"qMRMLChartView-" << name << "-" << numberOfPoints
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void FillArray(vtkMRMLDoubleArrayNode* arrayNode, int numberOfPoints, double frequency)
+{
+  vtkDoubleArray* array = arrayNode->GetArray();
+  array->SetNumberOfTuples(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    array->SetComponent(i, 0, i);
+    array->SetComponent(i, 1, sin(frequency * i) + (i % 100003 == 0 ? 10. : 0.));
+    array->SetComponent(i, 2, 0.);
+    }
+  arrayNode->Modified();
+}
+
+//----------------------------------------------------------------------------
+void WaitForPage(qMRMLChartView* view)
+{
+  QEventLoop loop;
+  QObject::connect(view, SIGNAL(loadFinished(bool)), &loop, SLOT(quit()));
+  QTimer::singleShot(10000, &loop, SLOT(quit()));
+  loop.exec();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int qMRMLChartViewTest1(int argc, char * argv [] )
+{
+  QApplication app(argc, argv);
+
+  int numberOfPoints = 1000000;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLDoubleArrayNode> arrayNode;
+  scene->AddNode(arrayNode.GetPointer());
+  FillArray(arrayNode.GetPointer(), numberOfPoints, 0.001);
+
+  vtkNew<vtkMRMLChartNode> chartNode;
+  scene->AddNode(chartNode.GetPointer());
+  chartNode->AddArray("Large array", arrayNode->GetID());
+
+  vtkNew<vtkMRMLChartViewNode> chartViewNode;
+  scene->AddNode(chartViewNode.GetPointer());
+  chartViewNode->SetChartNodeID(chartNode->GetID());
+
+  qMRMLChartView view;
+  view.resize(800, 600);
+  view.show();
+  view.setMRMLScene(scene.GetPointer());
+
+  //
+  // Generate and load the page
+  //
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  view.setMRMLChartViewNode(chartViewNode.GetPointer());
+  WaitForPage(&view);
+  timer->StopTimer();
+  PrintElapsedTime("Load", numberOfPoints, timer.GetPointer());
+
+  // The series is decimated to a few points per pixel, the page would
+  // be larger than 10MB otherwise.
+  int pageSize = view.page()->mainFrame()->toHtml().size();
+  std::cout << "Page size: " << pageSize << " characters" << std::endl;
+  if (pageSize > 1000000)
+    {
+    std::cerr << "Line " << __LINE__ << " - The series was not decimated, page size: "
+              << pageSize << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Update the values, only the series is sent to the page
+  //
+  timer->StartTimer();
+  FillArray(arrayNode.GetPointer(), numberOfPoints, 0.002);
+  qApp->processEvents();
+  timer->StopTimer();
+  PrintElapsedTime("UpdateSeries", numberOfPoints, timer.GetPointer());
+
+  //
+  // Resize, the series is decimated again
+  //
+  timer->StartTimer();
+  view.resize(1600, 600);
+  qApp->processEvents();
+  timer->StopTimer();
+  PrintElapsedTime("Resize", numberOfPoints, timer.GetPointer());
+
+  if (argc < 2 || QString(argv[1]) != "-I")
+    {
+    QTimer::singleShot(200, &app, SLOT(quit()));
+    }
+
+  return app.exec();
+}
@@ -27,7 +27,10 @@
 
 // MRML includes
 #include "qMRMLSceneFactoryWidget.h"
+#include "qMRMLSceneHierarchyModel.h"
 #include "qMRMLSceneModel.h"
+#include <vtkMRMLHierarchyNode.h>
+#include <vtkMRMLModelNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLViewNode.h>
 
@@ -47,6 +50,9 @@ private slots:
   void testSetColumns_data();
   void testSetColumnsWithScene();
   void testSetColumnsWithScene_data();
+  void testLargeScene();
+  void testLargeScene_data();
+  void testPopulateHierarchy();
 };
 
 // ----------------------------------------------------------------------------
@@ -192,6 +198,89 @@ void qMRMLSceneModelTester::testSetColumnsWithScene_data()
   this->testSetColumns_data();
 }
 
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelTester::testLargeScene()
+{
+  QFETCH(bool, lazyUpdate);
+  const int nodeCount = 10000;
+
+  qMRMLSceneModel sceneModel;
+  sceneModel.setLazyUpdate(lazyUpdate);
+  vtkNew<vtkMRMLScene> scene;
+  sceneModel.setMRMLScene(scene.GetPointer());
+
+  QList<vtkMRMLNode*> nodes;
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  for (int i = 0; i < nodeCount; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> node;
+    scene->AddNode(node.GetPointer());
+    nodes << node.GetPointer();
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+
+  QCOMPARE(sceneModel.rowCount(sceneModel.mrmlSceneIndex()), nodeCount);
+  for (int i = 0; i < nodeCount; ++i)
+    {
+    QCOMPARE(sceneModel.indexFromNode(nodes[i]).row(), i);
+    }
+
+  // Removing a node shifts the indexes of the following nodes
+  scene->RemoveNode(nodes[0]);
+  QCOMPARE(sceneModel.rowCount(sceneModel.mrmlSceneIndex()), nodeCount - 1);
+  QCOMPARE(sceneModel.indexFromNode(nodes[1]).row(), 0);
+  QCOMPARE(sceneModel.indexFromNode(nodes[nodeCount - 1]).row(), nodeCount - 2);
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelTester::testLargeScene_data()
+{
+  QTest::addColumn<bool>("lazyUpdate");
+
+  QTest::newRow("lazy update") << true;
+  QTest::newRow("no lazy update") << false;
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelTester::testPopulateHierarchy()
+{
+  // The hierarchy model reimplements nodeIndex(): the indexes cached while
+  // populating the model must be the ones it computes.
+  qMRMLSceneHierarchyModel sceneModel;
+  sceneModel.setLazyUpdate(true);
+  vtkNew<vtkMRMLScene> scene;
+  sceneModel.setMRMLScene(scene.GetPointer());
+
+  QList<vtkMRMLNode*> nodes;
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  vtkNew<vtkMRMLHierarchyNode> parentHierarchyNode;
+  scene->AddNode(parentHierarchyNode.GetPointer());
+  nodes << parentHierarchyNode.GetPointer();
+  for (int i = 0; i < 10; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> node;
+    scene->AddNode(node.GetPointer());
+    nodes << node.GetPointer();
+    if (i % 2)
+      {
+      vtkNew<vtkMRMLHierarchyNode> hierarchyNode;
+      scene->AddNode(hierarchyNode.GetPointer());
+      hierarchyNode->SetAssociatedNodeID(node->GetID());
+      if (i % 3)
+        {
+        hierarchyNode->SetParentNodeID(parentHierarchyNode->GetID());
+        }
+      nodes << hierarchyNode.GetPointer();
+      }
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+
+  foreach(vtkMRMLNode* node, nodes)
+    {
+    QCOMPARE(sceneModel.indexFromNode(node).row(), sceneModel.nodeIndex(node));
+    }
+}
+
 // ----------------------------------------------------------------------------
 CTK_TEST_MAIN(qMRMLSceneModelTest)
 #include "moc_qMRMLSceneModelTest.cxx"
@@ -20,6 +20,8 @@
 #include <QEvent>
 #include <QFileInfo>
 #include <QHBoxLayout>
+#include <QResizeEvent>
+#include <QSet>
 #include <QToolButton>
 #include <QWebFrame>
 
@@ -45,6 +47,7 @@
 #include <vtkMRMLScene.h>
 
 // VTK includes
+#include <vtkDoubleArray.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 
@@ -91,6 +94,9 @@ qMRMLChartViewPrivate::qMRMLChartViewPrivate(qMRMLChartView& object)
   this->ColorLogic = 0;
   this->PinButton = 0;
   this->PopupWidget = 0;
+  this->DecimationBuckets = 0;
+  this->IncrementalUpdate = false;
+  this->PageLoaded = false;
 }
 
 //---------------------------------------------------------------------------
@@ -109,6 +115,10 @@ void qMRMLChartViewPrivate::init()
   // Expose the ChartView class to Javascript
   q->page()->mainFrame()->addToJavaScriptWindowObject(QString("qtobject"), this);
 
+  // Series can only be updated once the plot has been created
+  QObject::connect(q, SIGNAL(loadFinished(bool)),
+                   this, SLOT(onLoadFinished(bool)));
+
   this->PopupWidget = new ctkPopupWidget;
   QHBoxLayout* popupLayout = new QHBoxLayout;
   popupLayout->addWidget(new QToolButton);
@@ -196,6 +206,13 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
     return;
     }
 
+  // The page is regenerated, the arrays are observed again below
+  this->qvtkDisconnect(0, vtkCommand::ModifiedEvent,
+                       this, SLOT(onArrayNodeModified(vtkObject*)));
+  this->SeriesPointIndices.clear();
+  this->IncrementalUpdate = false;
+  this->PageLoaded = false;
+
   // Get the ChartNode
   char *chartnodeid = this->MRMLChartViewNode->GetChartNodeID();
 
@@ -215,6 +232,27 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
     return;
     }
 
+  // Observe the arrays so that a change of values only updates the
+  // series of the array instead of the whole page
+  vtkStringArray *arrayIDs = cn->GetArrays();
+  QSet<vtkMRMLDoubleArrayNode*> arrayNodes;
+  bool allArraysFound = true;
+  for (int idx = 0; idx < arrayIDs->GetNumberOfValues(); idx++)
+    {
+    vtkMRMLDoubleArrayNode *dn = vtkMRMLDoubleArrayNode::SafeDownCast(this->MRMLScene->GetNodeByID( arrayIDs->GetValue(idx).c_str() ));
+    if (!dn)
+      {
+      allArraysFound = false;
+      continue;
+      }
+    if (!arrayNodes.contains(dn))
+      {
+      arrayNodes.insert(dn);
+      this->qvtkConnect(dn, vtkCommand::ModifiedEvent,
+                        this, SLOT(onArrayNodeModified(vtkObject*)));
+      }
+    }
+
 
   // Generate javascript for the data, ticks, options
   //
@@ -224,11 +262,19 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
   QStringList plotOptions;
 
   const char *type = cn->GetProperty("default", "type");
+  const char *xAxisType = cn->GetProperty("default", "xAxisType");
 
   if (!type || (type && !strcmp(type, "Line")))
     {
+    // Quantitative series of line charts are decimated to the
+    // resolution of the view and updated individually. The ticks of
+    // date and categorical axes depend on the values of the arrays.
+    this->IncrementalUpdate = allArraysFound
+      && (!xAxisType || (strcmp(xAxisType, "date") && strcmp(xAxisType, "categorical")));
+    this->DecimationBuckets = this->numberOfDecimationBuckets();
+
     // line charts are the default
-    plotData << this->lineData(cn);
+    plotData << this->lineData(cn, this->IncrementalUpdate);
     plotXAxisTicks << this->lineXAxisTicks(cn);
     plotOptions << this->lineOptions(cn);
     }
@@ -264,6 +310,15 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
     "plot1.replot( opts );"
     "};";
 
+  // update slot - represented in javascript
+  // replace the data of a series and replot, used for incremental updates
+  QStringList plotUpdateSeriesSlot;
+  plotUpdateSeriesSlot <<
+    "window.updateSeries = function(seriesIndex, seriesData) {"
+    "plot1.series[seriesIndex].data = seriesData;"
+    "resizeSlot();"
+    "};";
+
   // an initial call to the resize slot - represented in javascript
   QStringList plotInitialResize;
   plotInitialResize <<
@@ -325,6 +380,7 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
   plot <<
     "var plot1 = $.jqplot ('chart', data, options);";  // call the plot
   plot << plotResizeSlot;        // insert definition of the resizeSlot
+  plot << plotUpdateSeriesSlot;  // insert definition of the updateSeries slot
   plot << plotInitialResize;     // insert an initial call to resizeSlot
   plot << plotResizeHook;        // insert hook to call resizeSlot on page resize
   plot << plotDataMouseOverSlot; // insert definition of the data mouse over slot
@@ -521,31 +577,130 @@ QString qMRMLChartViewPrivate::seriesDateTicksString(vtkMRMLDoubleArrayNode *dn)
 }
 
 //---------------------------------------------------------------------------
-QString qMRMLChartViewPrivate::seriesDataString(vtkMRMLDoubleArrayNode *dn)
+QString qMRMLChartViewPrivate::seriesDataString(vtkMRMLDoubleArrayNode *dn, QVector<int>* pointIndices)
 {
-  QStringList data;
-
-  data << "[";
+  QString data("[");
 
-  if (dn)
+  vtkDoubleArray* array = dn ? dn->GetArray() : 0;
+  if (array && array->GetNumberOfComponents() >= 2)
     {
-    double x, y;
+    if (pointIndices)
+      {
+      this->decimate(dn, this->DecimationBuckets, *pointIndices);
+      }
+    bool decimated = pointIndices && !pointIndices->isEmpty();
+    int numberOfPoints = decimated ? pointIndices->size() : array->GetNumberOfTuples();
+    int numberOfComponents = array->GetNumberOfComponents();
+    const double* values = array->GetPointer(0);
+
+    // about 20 characters per point
+    data.reserve(20 * numberOfPoints + 2);
 
     // for each value
-    for (unsigned int j = 0; j < dn->GetSize(); ++j)
+    for (int j = 0; j < numberOfPoints; ++j)
       {
-      dn->GetXYValue(j, &x, &y);
-      data << "[" << QString("%1").arg(x) << ", " << QString("%1").arg(y) << "]";
-      if (j < dn->GetSize()-1)
+      const double* xy = values + numberOfComponents * (decimated ? pointIndices->at(j) : j);
+      if (j > 0)
         {
-        data << ",";
+        data += ',';
         }
+      data += '[';
+      data += QString::number(xy[0]);
+      data += ',';
+      data += QString::number(xy[1]);
+      data += ']';
       }
     }
 
-  data << "]";
+  data += ']';
 
-  return data.join("");
+  return data;
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartViewPrivate::decimate(vtkMRMLDoubleArrayNode *dn, int numberOfBuckets,
+                                     QVector<int>& pointIndices)
+{
+  pointIndices.clear();
+  vtkDoubleArray* array = dn ? dn->GetArray() : 0;
+  if (!array || array->GetNumberOfComponents() < 2 || numberOfBuckets <= 0)
+    {
+    return;
+    }
+  int numberOfPoints = array->GetNumberOfTuples();
+  if (numberOfPoints <= 2 * numberOfBuckets + 2)
+    {
+    return;
+    }
+  int numberOfComponents = array->GetNumberOfComponents();
+  const double* y = array->GetPointer(0) + 1;
+
+  pointIndices.reserve(2 * numberOfBuckets + 2);
+  // the first and last points are kept to preserve the range of the curve
+  pointIndices.append(0);
+  int numberOfInnerPoints = numberOfPoints - 2;
+  for (int bucket = 0; bucket < numberOfBuckets; ++bucket)
+    {
+    int begin = 1 + static_cast<int>(static_cast<double>(bucket) * numberOfInnerPoints / numberOfBuckets);
+    int end = 1 + static_cast<int>(static_cast<double>(bucket + 1) * numberOfInnerPoints / numberOfBuckets);
+    int minIndex = begin;
+    int maxIndex = begin;
+    for (int i = begin + 1; i < end; ++i)
+      {
+      double value = y[i * numberOfComponents];
+      if (value < y[minIndex * numberOfComponents])
+        {
+        minIndex = i;
+        }
+      else if (value > y[maxIndex * numberOfComponents])
+        {
+        maxIndex = i;
+        }
+      }
+    pointIndices.append(qMin(minIndex, maxIndex));
+    if (minIndex != maxIndex)
+      {
+      pointIndices.append(qMax(minIndex, maxIndex));
+      }
+    }
+  pointIndices.append(numberOfPoints - 1);
+}
+
+//---------------------------------------------------------------------------
+int qMRMLChartViewPrivate::numberOfDecimationBuckets()const
+{
+  Q_Q(const qMRMLChartView);
+  // the view may not be laid out yet
+  return qMax(q->width(), 256);
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartViewPrivate::updateSeries(int series, vtkMRMLDoubleArrayNode *dn)
+{
+  Q_Q(qMRMLChartView);
+  if (series < 0 || series >= this->SeriesPointIndices.size())
+    {
+    return;
+    }
+  QString script = QString("updateSeries(%1, ").arg(series);
+  script += this->seriesDataString(dn, &this->SeriesPointIndices[series]);
+  script += ");";
+  q->page()->mainFrame()->evaluateJavaScript(script);
+}
+
+//---------------------------------------------------------------------------
+int qMRMLChartViewPrivate::arrayPointIndex(int series, int pointidx)const
+{
+  if (series < 0 || series >= this->SeriesPointIndices.size())
+    {
+    return pointidx;
+    }
+  const QVector<int>& pointIndices = this->SeriesPointIndices[series];
+  if (pointidx < 0 || pointidx >= pointIndices.size())
+    {
+    return pointidx;
+    }
+  return pointIndices[pointidx];
 }
 
 //---------------------------------------------------------------------------
@@ -606,7 +761,7 @@ QString qMRMLChartViewPrivate::seriesDependentDataString(vtkMRMLDoubleArrayNode
 }
 
 //---------------------------------------------------------------------------
-QString qMRMLChartViewPrivate::lineData(vtkMRMLChartNode *cn)
+QString qMRMLChartViewPrivate::lineData(vtkMRMLChartNode *cn, bool decimateSeries)
 {
   QStringList data;
 
@@ -632,7 +787,15 @@ QString qMRMLChartViewPrivate::lineData(vtkMRMLChartNode *cn)
       else
         {
         // convert the data array into a string of quantitative values
-        data << this->seriesDataString(dn);
+        if (decimateSeries)
+          {
+          this->SeriesPointIndices.append(QVector<int>());
+          data << this->seriesDataString(dn, &this->SeriesPointIndices.last());
+          }
+        else
+          {
+          data << this->seriesDataString(dn);
+          }
         }
 
       if (idx < arrayIDs->GetNumberOfValues()-1)
@@ -1607,7 +1770,68 @@ void qMRMLChartViewPrivate::onDataMouseOver(int series, int pointidx, double x,
   if (series >= 0 && series < arrayIDs->GetNumberOfValues())
     {
     //qDebug() << "Array: " << arrayIDs->GetValue(series) << ", Pointidx: " << pointidx << ": " << x << ", " << y;
-    emit q->dataMouseOver(arrayIDs->GetValue(series), pointidx, x, y);
+    emit q->dataMouseOver(arrayIDs->GetValue(series), this->arrayPointIndex(series, pointidx), x, y);
+    }
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartViewPrivate::onArrayNodeModified(vtkObject* caller)
+{
+  Q_Q(qMRMLChartView);
+  vtkMRMLDoubleArrayNode* dn = vtkMRMLDoubleArrayNode::SafeDownCast(caller);
+  if (!q->isEnabled() || !dn)
+    {
+    return;
+    }
+  if (!this->IncrementalUpdate || !this->PageLoaded || !this->MRMLChartNode)
+    {
+    this->updateWidgetFromMRML();
+    return;
+    }
+
+  // only send the series of the modified array
+  vtkStringArray *arrayIDs = this->MRMLChartNode->GetArrays();
+  for (int idx = 0; idx < arrayIDs->GetNumberOfValues(); idx++)
+    {
+    if (dn->GetID() && arrayIDs->GetValue(idx) == dn->GetID())
+      {
+      this->updateSeries(idx, dn);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartViewPrivate::onLoadFinished(bool ok)
+{
+  this->PageLoaded = ok;
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartViewPrivate::onResized()
+{
+  if (!this->IncrementalUpdate || !this->PageLoaded || !this->MRMLChartNode)
+    {
+    return;
+    }
+  // Decimate again if the view is wider (details are missing) or less
+  // than half as wide (too many points are sent for nothing)
+  int oldBuckets = this->DecimationBuckets;
+  int newBuckets = this->numberOfDecimationBuckets();
+  if (newBuckets <= oldBuckets && 2 * newBuckets >= oldBuckets)
+    {
+    return;
+    }
+  this->DecimationBuckets = newBuckets;
+
+  vtkStringArray *arrayIDs = this->MRMLChartNode->GetArrays();
+  for (int idx = 0; idx < arrayIDs->GetNumberOfValues(); idx++)
+    {
+    vtkMRMLDoubleArrayNode *dn = vtkMRMLDoubleArrayNode::SafeDownCast(this->MRMLScene->GetNodeByID( arrayIDs->GetValue(idx).c_str() ));
+    // only the arrays that are (or become) decimated change
+    if (dn && static_cast<int>(dn->GetSize()) > 2 * qMin(oldBuckets, newBuckets) + 2)
+      {
+      this->updateSeries(idx, dn);
+      }
     }
 }
 
@@ -1652,7 +1876,7 @@ void qMRMLChartViewPrivate::onDataPointClicked(int series, int pointidx, double
   if (series >= 0 && series < arrayIDs->GetNumberOfValues())
     {
     //qDebug() << "Array: " << arrayIDs->GetValue(series) << ", Pointidx: " << pointidx << ": " << x << ", " << y;
-    emit q->dataPointClicked(arrayIDs->GetValue(series), pointidx, x, y);
+    emit q->dataPointClicked(arrayIDs->GetValue(series), this->arrayPointIndex(series, pointidx), x, y);
     }
 }
 
@@ -1760,6 +1984,14 @@ QSize qMRMLChartView::sizeHint()const
   return QSize();
 }
 
+//---------------------------------------------------------------------------
+void qMRMLChartView::resizeEvent(QResizeEvent* event)
+{
+  Q_D(qMRMLChartView);
+  this->Superclass::resizeEvent(event);
+  d->onResized();
+}
+
 
 
 
@@ -23,6 +23,7 @@
 
 #include "qMRMLWidgetsExport.h"
 
+class QResizeEvent;
 class qMRMLChartViewPrivate;
 
 // MRML includes
@@ -88,6 +89,10 @@ signals:
   void mrmlSceneChanged(vtkMRMLScene*);
 
 protected:
+  /// Reimplemented to adapt the decimation of the series to the
+  /// width of the view.
+  virtual void resizeEvent(QResizeEvent* event);
+
   QScopedPointer<qMRMLChartViewPrivate> d_ptr;
 
 private:
@@ -13,6 +13,8 @@
 //
 
 // Qt includes
+#include <QList>
+#include <QVector>
 class QToolButton;
 
 // VTK includes
@@ -67,6 +69,17 @@ public slots:
   // slot when a data point is clicked
   void onDataPointClicked(int series, int pointidx, double x, double y);
 
+  // slot when the values of a plotted array changed. Only the series
+  // of the array is sent to the page when possible.
+  void onArrayNodeModified(vtkObject* caller);
+
+  // slot when the page (and the plot) has been loaded
+  void onLoadFinished(bool ok);
+
+  // slot when the view has been resized. The decimated series are
+  // recomputed if the resolution of the view changed significantly.
+  void onResized();
+
 
 protected:
 
@@ -84,8 +97,29 @@ protected:
   QString seriesColorsString(vtkMRMLColorNode*, vtkMRMLDoubleArrayNode*);
 
   // Convert a data array into a string that can be passed as the data
-  // for a series.
-  QString seriesDataString(vtkMRMLDoubleArrayNode*);
+  // for a series. If pointIndices is not null, arrays with more points
+  // than the view can display are decimated (see decimate()) and
+  // pointIndices receives the index in the array of each point of the
+  // string (it is left empty if the array is not decimated).
+  QString seriesDataString(vtkMRMLDoubleArrayNode*, QVector<int>* pointIndices = 0);
+
+  // Select the points to display from an array with more than two
+  // points per bucket: the array is split into numberOfBuckets ranges
+  // of consecutive points and the minimum and maximum dependent values
+  // of each range are kept, in their original order. The shape of the
+  // curve (including its spikes) is preserved at the view resolution.
+  static void decimate(vtkMRMLDoubleArrayNode*, int numberOfBuckets, QVector<int>& pointIndices);
+
+  // Number of buckets used to decimate the series, one per horizontal
+  // pixel of the view.
+  int numberOfDecimationBuckets()const;
+
+  // Send the new values of a series to the page without regenerating it.
+  void updateSeries(int series, vtkMRMLDoubleArrayNode*);
+
+  // Convert a point index of a (possibly decimated) series into an
+  // index in its array.
+  int arrayPointIndex(int series, int pointidx)const;
 
   // Convert a data array into a string that can be passed as the data
   // for a series. This version will use values in the ArrayNode to
@@ -119,8 +153,9 @@ protected:
   QString arrayTicksString(vtkStringArray*);
 
   // Convert the data in all the arrays into a structure suitable for
-  // plotting as lines.
-  QString lineData(vtkMRMLChartNode*);
+  // plotting as lines. Quantitative series are decimated if decimate
+  // is true.
+  QString lineData(vtkMRMLChartNode*, bool decimateSeries = false);
 
   // Generate x-axis tick locations for lines. Generates ticks only
   // for categorical and date axes. Defaults to jqPlot for
@@ -183,6 +218,17 @@ protected:
 
   QToolButton*                       PinButton;
   ctkPopupWidget*                    PopupWidget;
+
+  // Index in its array of each point of the decimated series, empty
+  // for series that are not decimated.
+  QList<QVector<int> >               SeriesPointIndices;
+  // Number of buckets the series were decimated with.
+  int                                DecimationBuckets;
+  // True if the series of the current page can be updated individually
+  // (quantitative line chart with all its arrays in the scene).
+  bool                               IncrementalUpdate;
+  // True when the page is loaded and updateSeries() can be called.
+  bool                               PageLoaded;
 };
 
 #endif
@@ -183,6 +183,36 @@ vtkMRMLNode* qMRMLNodeComboBoxPrivate::mrmlNodeFromIndex(const QModelIndex& inde
 // --------------------------------------------------------------------------
 QModelIndexList qMRMLNodeComboBoxPrivate::indexesFromMRMLNodeID(const QString& nodeID)const
 {
+  Q_Q(const qMRMLNodeComboBox);
+  // The scene model knows the index of its nodes, map it through the proxy
+  // models instead of browsing all the items.
+  vtkMRMLScene* scene = q->mrmlScene();
+  vtkMRMLNode* node = (scene && !nodeID.isEmpty()) ? scene->GetNodeByID(nodeID.toLatin1()) : 0;
+  QModelIndex sceneModelIndex = this->MRMLSceneModel->indexFromNode(node);
+  if (sceneModelIndex.isValid())
+    {
+    QList<QAbstractProxyModel*> proxyModels;
+    QAbstractItemModel* model = this->ComboBox->model();
+    while (qobject_cast<QAbstractProxyModel*>(model))
+      {
+      proxyModels.prepend(qobject_cast<QAbstractProxyModel*>(model));
+      model = proxyModels.first()->sourceModel();
+      }
+    if (model == this->MRMLSceneModel)
+      {
+      QModelIndex index = sceneModelIndex;
+      foreach(QAbstractProxyModel* proxyModel, proxyModels)
+        {
+        index = proxyModel->mapFromSource(index);
+        }
+      QModelIndexList indexes;
+      if (index.isValid())
+        {
+        indexes << index;
+        }
+      return indexes;
+      }
+    }
   return this->ComboBox->model()->match(
     this->ComboBox->model()->index(0, 0), qMRMLSceneModel::UIDRole, nodeID, 1,
     Qt::MatchRecursive | Qt::MatchExactly | Qt::MatchWrap);
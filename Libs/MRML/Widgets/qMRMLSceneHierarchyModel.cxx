@@ -52,6 +52,37 @@ vtkMRMLHierarchyNode* qMRMLSceneHierarchyModelPrivate::CreateHierarchyNode()cons
   return vtkMRMLHierarchyNode::New();
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneHierarchyModelPrivate::cacheNodeIndexes()
+{
+  Q_Q(qMRMLSceneHierarchyModel);
+  // Same indexes as the scene browsing in qMRMLSceneHierarchyModel::nodeIndex()
+  this->NodeIndexCache.reserve(this->MRMLScene->GetNumberOfNodes());
+  QHash<vtkMRMLNode*, int> siblingCounts;
+  vtkMRMLNode* node = 0;
+  vtkCollectionSimpleIterator it;
+  for (this->MRMLScene->GetNodes()->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->MRMLScene->GetNodes()->GetNextItemAsObject(it)) ;)
+    {
+    if (!node->GetID())
+      {
+      continue;
+      }
+    int& index = siblingCounts[q->parentNode(node)];
+    this->NodeIndexCache[node] = index;
+    if (!vtkMRMLHierarchyNode::GetAssociatedHierarchyNode(this->MRMLScene, node->GetID()))
+      {
+      ++index;
+      }
+    // the associated node of a hierarchy node is displayed after it
+    vtkMRMLHierarchyNode* hierarchy = vtkMRMLHierarchyNode::SafeDownCast(node);
+    if (hierarchy && hierarchy->GetAssociatedNode())
+      {
+      ++index;
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
@@ -201,6 +232,13 @@ int qMRMLSceneHierarchyModel::nodeIndex(vtkMRMLNode* node)const
       }
     }
 
+  // While populating the model, the indexes are computed at once
+  QHash<vtkMRMLNode*, int>::const_iterator cachedIndexIt = d->NodeIndexCache.find(node);
+  if (cachedIndexIt != d->NodeIndexCache.end())
+    {
+    return index + cachedIndexIt.value();
+    }
+
   // otherwise, iterate through the scene
   vtkCollection* nodes = d->MRMLScene->GetNodes();
   vtkMRMLNode* n = 0;
@@ -53,6 +53,7 @@ public:
   qMRMLSceneHierarchyModelPrivate(qMRMLSceneHierarchyModel& object);
   virtual void init();
   virtual vtkMRMLHierarchyNode* CreateHierarchyNode()const;
+  virtual void cacheNodeIndexes();
 
   int ExpandColumn;
 };
@@ -89,27 +89,69 @@ void qMRMLSceneModelPrivate::init()
 }
 
 //------------------------------------------------------------------------------
-QModelIndexList qMRMLSceneModelPrivate::indexes(const QString& nodeID)const
+QModelIndex qMRMLSceneModelPrivate::indexFromNode(vtkMRMLNode* node, const QString& nodeID)const
 {
   Q_Q(const qMRMLSceneModel);
+  if (node == 0 || nodeID.isEmpty())
+    {
+    return QModelIndex();
+    }
+
+  // Try to find the nodeIndex in the cache first
+  QHash<vtkMRMLNode*,QPersistentModelIndex>::iterator rowCacheIt = this->RowCache.find(node);
+  if (rowCacheIt == this->RowCache.end())
+    {
+    // not found in cache, therefore it cannot be in the model
+    return QModelIndex();
+    }
+  if (rowCacheIt.value().isValid())
+    {
+    // An entry found in the cache. If the item at the cached index matches the requested node ID
+    // then we use it.
+    QStandardItem* nodeItem = q->itemFromIndex(rowCacheIt.value());
+    if (nodeItem != 0 &&
+        nodeItem->data(qMRMLSceneModel::UIDRole).toString() == nodeID)
+      {
+      return rowCacheIt.value();
+      }
+    }
+
+  // The cache was not up-to-date. Do a slow linear search.
   QModelIndex scene = q->mrmlSceneIndex();
   if (scene == QModelIndex())
     {
-    return QModelIndexList();
+    return QModelIndex();
     }
   // QAbstractItemModel::match doesn't browse through columns
-  // we need to do it manually
   QModelIndexList nodeIndexes = q->match(
     scene, qMRMLSceneModel::UIDRole, nodeID,
     1, Qt::MatchExactly | Qt::MatchRecursive);
   Q_ASSERT(nodeIndexes.size() <= 1); // we know for sure it won't be more than 1
   if (nodeIndexes.size() == 0)
+    {
+    // maybe the node hasn't been added to the scene yet...
+    // (if it's called from populateScene/inserteNode)
+    this->RowCache.remove(node);
+    return QModelIndex();
+    }
+  this->RowCache[node] = nodeIndexes[0];
+  return nodeIndexes[0];
+}
+
+//------------------------------------------------------------------------------
+QModelIndexList qMRMLSceneModelPrivate::indexes(vtkMRMLNode* node, const QString& nodeID)const
+{
+  Q_Q(const qMRMLSceneModel);
+  QModelIndexList nodeIndexes;
+  QModelIndex nodeIndex = this->indexFromNode(node, nodeID);
+  if (!nodeIndex.isValid())
     {
     return nodeIndexes;
     }
+  nodeIndexes << nodeIndex;
   // Add the QModelIndexes from the other columns
-  const int row = nodeIndexes[0].row();
-  QModelIndex nodeParentIndex = nodeIndexes[0].parent();
+  const int row = nodeIndex.row();
+  QModelIndex nodeParentIndex = nodeIndex.parent();
   const int sceneColumnCount = q->columnCount(nodeParentIndex);
   for (int j = 1; j < sceneColumnCount; ++j)
     {
@@ -118,6 +160,25 @@ QModelIndexList qMRMLSceneModelPrivate::indexes(const QString& nodeID)const
   return nodeIndexes;
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::updateRowCache(QStandardItem* item)
+{
+  Q_Q(qMRMLSceneModel);
+  vtkMRMLNode* node = q->mrmlNodeFromItem(item);
+  if (node)
+    {
+    this->RowCache[node] = item->index();
+    }
+  for (int i = 0; i < item->rowCount(); ++i)
+    {
+    QStandardItem* child = item->child(i, 0);
+    if (child)
+      {
+      this->updateRowCache(child);
+      }
+    }
+}
+
 //------------------------------------------------------------------------------
 void qMRMLSceneModelPrivate::listenNodeModifiedEvent()
 {
@@ -242,6 +303,24 @@ bool qMRMLSceneModelPrivate::isExtraItem(const QStandardItem* item)const
   return uid == "preItem" || uid == "postItem";
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::cacheNodeIndexes()
+{
+  Q_Q(qMRMLSceneModel);
+  this->NodeIndexCache.reserve(this->MRMLScene->GetNumberOfNodes());
+  QHash<vtkMRMLNode*, int> siblingCounts;
+  vtkMRMLNode* node = 0;
+  vtkCollectionSimpleIterator it;
+  for (this->MRMLScene->GetNodes()->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->MRMLScene->GetNodes()->GetNextItemAsObject(it)) ;)
+    {
+    if (node->GetID())
+      {
+      this->NodeIndexCache[node] = siblingCounts[q->parentNode(node)]++;
+      }
+    }
+}
+
 //------------------------------------------------------------------------------
 void qMRMLSceneModelPrivate::reparentItems(
   QList<QStandardItem*>& children, int newIndex, QStandardItem* newParentItem)
@@ -251,6 +330,11 @@ void qMRMLSceneModelPrivate::reparentItems(
   int max = newParentItem->rowCount() - q->postItems(newParentItem).count();
   int pos = qMin(min + newIndex, max);
   newParentItem->insertRow(pos, children);
+  // Taking the rows invalidated the persistent indexes of the subtree
+  if (!children.isEmpty() && children[0])
+    {
+    this->updateRowCache(children[0]);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -440,48 +524,10 @@ QModelIndex qMRMLSceneModel::indexFromNode(vtkMRMLNode* node, int column)const
     return QModelIndex();
     }
 
-  QModelIndex nodeIndex;
-
-  // Try to find the nodeIndex in the cache first
-  QMap<vtkMRMLNode*,QPersistentModelIndex>::iterator rowCacheIt=d->RowCache.find(node);
-  if (rowCacheIt==d->RowCache.end())
-    {
-    // not found in cache, therefore it cannot be in the model
-    return nodeIndex;
-    }
-  if (rowCacheIt.value().isValid())
-    {
-    // An entry found in the cache. If the item at the cached index matches the requested node ID
-    // then we use it.
-    QStandardItem* nodeItem = this->itemFromIndex(rowCacheIt.value());
-    if (nodeItem!=NULL)
-      {
-      if (nodeItem->data(qMRMLSceneModel::UIDRole).toString().compare(QLatin1String(node->GetID()))==0)
-        {
-        // id matched
-        nodeIndex=rowCacheIt.value();
-        }
-      }
-    }
-
-  // The cache was not up-to-date. Do a slow linear search.
+  QModelIndex nodeIndex = d->indexFromNode(node, QString(node->GetID()));
   if (!nodeIndex.isValid())
     {
-    // QAbstractItemModel::match doesn't browse through columns
-    // we need to do it manually
-    QModelIndexList nodeIndexes = this->match(
-      this->mrmlSceneIndex(), qMRMLSceneModel::UIDRole, QString(node->GetID()),
-      1, Qt::MatchExactly | Qt::MatchRecursive);
-    Q_ASSERT(nodeIndexes.size() <= 1); // we know for sure it won't be more than 1
-    if (nodeIndexes.size() == 0)
-      {
-      // maybe the node hasn't been added to the scene yet...
-      // (if it's called from populateScene/inserteNode)
-      d->RowCache.remove(node);
-      return QModelIndex();
-      }
-    nodeIndex=nodeIndexes[0];
-    d->RowCache[node]=nodeIndex;
+    return QModelIndex();
     }
   if (column == 0)
     {
@@ -501,7 +547,7 @@ QModelIndex qMRMLSceneModel::indexFromNode(vtkMRMLNode* node, int column)const
 QModelIndexList qMRMLSceneModel::indexes(vtkMRMLNode* node)const
 {
   Q_D(const qMRMLSceneModel);
-  return d->indexes(QString(node->GetID()));
+  return d->indexes(node, QString(node->GetID()));
 }
 
 //------------------------------------------------------------------------------
@@ -524,6 +570,13 @@ int qMRMLSceneModel::nodeIndex(vtkMRMLNode* node)const
     {
     return -1;
     }
+  // While populating the model, all the indexes are computed at once
+  QHash<vtkMRMLNode*, int>::const_iterator cachedIndexIt = d->NodeIndexCache.find(node);
+  if (cachedIndexIt != d->NodeIndexCache.end())
+    {
+    return cachedIndexIt.value();
+    }
+
   const char* nId = 0;
   int index = -1;
   vtkMRMLNode* parent = this->parentNode(node);
@@ -772,6 +825,12 @@ void qMRMLSceneModel::populateScene()
   vtkMRMLNode *node = 0;
   vtkCollectionSimpleIterator it;
   d->MisplacedNodes.clear();
+
+  // Compute the index of every node among its siblings in a single pass
+  // instead of browsing the scene for each inserted node in nodeIndex().
+  d->NodeIndexCache.clear();
+  d->cacheNodeIndexes();
+
   for (d->MRMLScene->GetNodes()->InitTraversal(it);
        (node = (vtkMRMLNode*)d->MRMLScene->GetNodes()->GetNextItemAsObject(it)) ;)
     {
@@ -781,6 +840,7 @@ void qMRMLSceneModel::populateScene()
     {
     this->onMRMLNodeModified(misplacedNode);
     }
+  d->NodeIndexCache.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -1252,13 +1312,11 @@ void qMRMLSceneModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMR
   // Remove all the observations on the node
   qvtkDisconnect(node, vtkCommand::NoEvent, this, 0);
 
-  // TODO: can be fasten by browsing the tree only once
-  QModelIndexList indexes = this->match(this->mrmlSceneIndex(), qMRMLSceneModel::UIDRole,
-                                        QString(node->GetID()), 1,
-                                        Qt::MatchExactly | Qt::MatchRecursive);
-  if (indexes.count())
+  QModelIndex nodeIndex = d->indexFromNode(node, QString(node->GetID()));
+  d->RowCache.remove(node);
+  if (nodeIndex.isValid())
     {
-    QStandardItem* item = this->itemFromIndex(indexes[0].sibling(indexes[0].row(),0));
+    QStandardItem* item = this->itemFromIndex(nodeIndex);
     // The children may be lost if not reparented, we ensure they got reparented.
     while (item->rowCount())
       {
@@ -1275,7 +1333,7 @@ void qMRMLSceneModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMR
         d->Orphans.removeAll(orphans);
         }
       }
-    this->removeRow(indexes[0].row(), indexes[0].parent());
+    this->removeRow(nodeIndex.row(), nodeIndex.parent());
     }
 }
 
@@ -1401,7 +1459,7 @@ void qMRMLSceneModel::updateNodeItems(vtkMRMLNode* node, const QString& nodeUID)
     return;
     }
   //Q_ASSERT(node->GetScene()->IsNodePresent(node));
-  QModelIndexList nodeIndexes = d->indexes(nodeUID);
+  QModelIndexList nodeIndexes = d->indexes(node, nodeUID);
   //qDebug() << "onMRMLNodeModified" << node->GetID() << nodeIndexes;
   Q_ASSERT(nodeIndexes.count());
   for (int i = 0; i < nodeIndexes.size(); ++i)
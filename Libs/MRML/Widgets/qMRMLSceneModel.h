@@ -196,7 +196,10 @@ public:
   virtual vtkMRMLNode* parentNode(vtkMRMLNode* node)const;
   /// Returns the row model index relative to its parent node indepentently of
   /// any filtering or proxy model.
-  /// Must be reimplemented in derived classes
+  /// Must be reimplemented in derived classes. While the model is populated,
+  /// the indexes are computed at once by
+  /// qMRMLSceneModelPrivate::cacheNodeIndexes(), reimplementations must
+  /// look them up.
   virtual int          nodeIndex(vtkMRMLNode* node)const;
   /// fast function that only check the type of the node to know if it can be a child.
   virtual bool         canBeAChild(vtkMRMLNode* node)const;
@@ -35,6 +35,7 @@
 // Qt includes
 class QStandardItemModel;
 #include <QFlags>
+#include <QHash>
 #include <QMap>
 
 // qMRML includes
@@ -60,7 +61,14 @@ public:
   virtual ~qMRMLSceneModelPrivate();
   void init();
 
-  QModelIndexList indexes(const QString& nodeID)const;
+  /// Return the index of the first column of the node item. nodeID is the ID
+  /// the item has been created with, it can differ from the current ID of
+  /// the node if it just changed.
+  QModelIndex indexFromNode(vtkMRMLNode* node, const QString& nodeID)const;
+  QModelIndexList indexes(vtkMRMLNode* node, const QString& nodeID)const;
+  /// Update the cached indexes of the node of the item and its children
+  /// (e.g. after the item has been moved).
+  void updateRowCache(QStandardItem* item);
 
   QStringList extraItems(QStandardItem* parent, const QString& extraType)const;
   void insertExtraItem(int row, QStandardItem* parent,
@@ -70,6 +78,12 @@ public:
   bool isExtraItem(const QStandardItem* item)const;
   void listenNodeModifiedEvent();
   void reparentItems(QList<QStandardItem*>& children, int newIndex, QStandardItem* newParent);
+  /// Fill NodeIndexCache with the index of all the nodes of the scene in a
+  /// single pass. The default implementation indexes the nodes among the
+  /// nodes of the same parent in the scene order, like
+  /// qMRMLSceneModel::nodeIndex(). Subclasses reimplementing nodeIndex()
+  /// must reimplement it to match and look up the cache in nodeIndex().
+  virtual void cacheNodeIndexes();
 
   vtkSmartPointer<vtkCallbackCommand> CallBack;
   qMRMLSceneModel::NodeTypes ListenNodeModifiedEvent;
@@ -95,12 +109,17 @@ public:
   // likely to be unreachable when browsing the model
   QList<QList<QStandardItem*> > Orphans;
 
-  // Map from MRML node to row.
-  // It just stores the result of the latest lookup by indexFromNode,
-  // not guaranteed to contain up-to-date information, should be just used
-  // as a search hint. If the node cannot be found at the given index then
-  // we need to browse through all model items.
-  mutable QMap<vtkMRMLNode*,QPersistentModelIndex> RowCache;
+  // Map from MRML node to the index of its item in the first column.
+  // It contains all the nodes of the model and is updated when items are
+  // inserted, moved and removed by the model. The index is still checked
+  // against the node ID and if it doesn't match (e.g. the rows have been
+  // moved by a view) we browse through all model items.
+  mutable QHash<vtkMRMLNode*,QPersistentModelIndex> RowCache;
+
+  // Index of the nodes among their siblings, only valid while populating
+  // the model: the scene doesn't change meanwhile, so nodes can't be
+  // reparented. \sa qMRMLSceneModel::nodeIndex(), cacheNodeIndexes()
+  QHash<vtkMRMLNode*, int> NodeIndexCache;
 };
 
 #endif
@@ -0,0 +1,622 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// RemoteIO includes
+#include "vtkHTTPHandler.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// Socket includes
+#ifdef _WIN32
+# include <winsock2.h>
+typedef int socklen_t;
+#else
+# include <arpa/inet.h>
+# include <netinet/in.h>
+# include <sys/select.h>
+# include <sys/socket.h>
+# include <unistd.h>
+# define closesocket close
+# define INVALID_SOCKET -1
+typedef int SOCKET;
+#endif
+
+// Most transfers are done with file:// URLs: curl handles them like
+// HTTP downloads, including the range requests used to resume a download,
+// without requiring a server. The HTTP responses (partial content, range
+// not satisfiable and server errors) are tested with HTTPServer, a minimal
+// server running on a thread of the test.
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct TransferObserver
+{
+  TransferObserver()
+  {
+    this->NumberOfProgressEvents = 0;
+    this->Progress = 0.;
+  }
+  std::vector<int> Done;
+  int NumberOfProgressEvents;
+  double Progress;
+};
+
+//----------------------------------------------------------------------------
+void TransferCallback(vtkObject* vtkNotUsed(caller), unsigned long eid,
+                      void* clientData, void* callData)
+{
+  TransferObserver* observer = reinterpret_cast<TransferObserver*>(clientData);
+  if (eid == vtkURIHandler::StageFileReadDoneEvent)
+    {
+    int* done = reinterpret_cast<int*>(callData);
+    observer->Done[done[0]] = done[1];
+    }
+  else if (eid == vtkCommand::ProgressEvent)
+    {
+    ++observer->NumberOfProgressEvents;
+    observer->Progress = *reinterpret_cast<double*>(callData);
+    }
+}
+
+//----------------------------------------------------------------------------
+std::string FileContent(int index, int size)
+{
+  std::string content(size, ' ');
+  for (int i = 0; i < size; ++i)
+    {
+    content[i] = static_cast<char>('a' + (i * 7 + index) % 26);
+    }
+  return content;
+}
+
+//----------------------------------------------------------------------------
+void WriteFile(const std::string& fileName, const std::string& content)
+{
+  std::ofstream output(fileName.c_str(), std::ios::out | std::ios::binary);
+  output << content;
+}
+
+//----------------------------------------------------------------------------
+bool CheckFile(int line, const std::string& fileName, const std::string& expected)
+{
+  std::ifstream input(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream content;
+  content << input.rdbuf();
+  if (!input.is_open() || content.str() != expected)
+    {
+    std::cerr << "Line " << line << " - Wrong content for " << fileName << std::endl;
+    return false;
+    }
+  if (vtksys::SystemTools::FileExists((fileName + ".part").c_str()))
+    {
+    std::cerr << "Line " << line << " - " << fileName << ".part was not removed" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestConcurrentDownloads(vtkHTTPHandler* handler, const std::string& directory)
+{
+  const int numberOfFiles = 20;
+  std::vector<std::string> sources;
+  std::vector<std::string> destinations;
+  for (int i = 0; i < numberOfFiles; ++i)
+    {
+    std::stringstream name;
+    name << "/file" << i << ".nrrd";
+    WriteFile(directory + "/source" + name.str(), FileContent(i, 100000 * (i + 1)));
+    sources.push_back("file://" + directory + "/source" + name.str());
+    destinations.push_back(directory + "/destination" + name.str());
+    }
+
+  TransferObserver observer;
+  observer.Done.resize(numberOfFiles, -1);
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(TransferCallback);
+  callback->SetClientData(&observer);
+  handler->AddObserver(vtkURIHandler::StageFileReadDoneEvent, callback.GetPointer());
+  handler->AddObserver(vtkCommand::ProgressEvent, callback.GetPointer());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  handler->StageFileReads(sources, destinations);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkHTTPHandler-StageFileReads-" << numberOfFiles
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  handler->RemoveObservers(vtkURIHandler::StageFileReadDoneEvent);
+  handler->RemoveObservers(vtkCommand::ProgressEvent);
+
+  for (int i = 0; i < numberOfFiles; ++i)
+    {
+    if (observer.Done[i] != 1)
+      {
+      std::cerr << "Line " << __LINE__ << " - Download of " << sources[i]
+                << " reported " << observer.Done[i] << std::endl;
+      return false;
+      }
+    if (!CheckFile(__LINE__, destinations[i], FileContent(i, 100000 * (i + 1))))
+      {
+      return false;
+      }
+    }
+  if (observer.NumberOfProgressEvents == 0 || observer.Progress != 1.)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << observer.NumberOfProgressEvents
+              << " progress events, last progress is " << observer.Progress << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestResume(vtkHTTPHandler* handler, const std::string& directory)
+{
+  std::string content = FileContent(100, 300000);
+  std::string source = directory + "/source/resumed.nrrd";
+  std::string destination = directory + "/destination/resumed.nrrd";
+  WriteFile(source, content);
+
+  // An interrupted download left the first half of the file. Its content
+  // differs from the source to check that it is not downloaded again.
+  std::string partialContent(content.size() / 2, 'z');
+  WriteFile(destination + ".part", partialContent);
+
+  handler->StageFileRead(("file://" + source).c_str(), destination.c_str());
+  return CheckFile(__LINE__, destination, partialContent + content.substr(partialContent.size()));
+}
+
+//----------------------------------------------------------------------------
+bool TestMissingFile(vtkHTTPHandler* handler, const std::string& directory)
+{
+  std::vector<std::string> sources;
+  sources.push_back("file://" + directory + "/source/missing.nrrd");
+  sources.push_back("file://" + directory + "/source/file0.nrrd");
+  std::vector<std::string> destinations;
+  destinations.push_back(directory + "/destination/missing.nrrd");
+  destinations.push_back(directory + "/destination/file0-copy.nrrd");
+
+  TransferObserver observer;
+  observer.Done.resize(2, -1);
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(TransferCallback);
+  callback->SetClientData(&observer);
+  handler->AddObserver(vtkURIHandler::StageFileReadDoneEvent, callback.GetPointer());
+  handler->StageFileReads(sources, destinations);
+  handler->RemoveObservers(vtkURIHandler::StageFileReadDoneEvent);
+
+  if (observer.Done[0] != 0 || observer.Done[1] != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Downloads reported " << observer.Done[0]
+              << " and " << observer.Done[1] << " instead of 0 and 1" << std::endl;
+    return false;
+    }
+  if (vtksys::SystemTools::FileExists(destinations[0].c_str()) ||
+      vtksys::SystemTools::FileExists((destinations[0] + ".part").c_str()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed download left a file" << std::endl;
+    return false;
+    }
+  return CheckFile(__LINE__, destinations[1], FileContent(0, 100000));
+}
+
+//----------------------------------------------------------------------------
+// Serves Content to any GET request, one connection at a time. Range
+// requests are answered with 206 or 416 if AcceptRanges is set, and the
+// next responses can be replaced by an error status or an interruption.
+struct HTTPServer
+{
+  enum
+    {
+    Serve = 0,
+    // The connection is closed after half of the response content.
+    Interrupt = 1
+    };
+
+  HTTPServer()
+  {
+    this->Socket = INVALID_SOCKET;
+    this->Port = 0;
+    this->ThreadId = -1;
+    this->AcceptRanges = true;
+  }
+  std::string URL()const
+  {
+    std::stringstream url;
+    url << "http://127.0.0.1:" << this->Port << "/file.nrrd";
+    return url.str();
+  }
+  // Set the content and the next responses, and forget the requests.
+  void Reset(const std::string& content, bool acceptRanges,
+             int response1 = Serve, int response2 = Serve, int response3 = Serve)
+  {
+    this->Lock->Lock();
+    this->Content = content;
+    this->AcceptRanges = acceptRanges;
+    this->Responses.clear();
+    int responses[3] = {response1, response2, response3};
+    for (int i = 0; i < 3 && responses[i] != Serve; ++i)
+      {
+      this->Responses.push_back(responses[i]);
+      }
+    this->RequestedOffsets.clear();
+    this->Lock->Unlock();
+  }
+  std::vector<long> GetRequestedOffsets()
+  {
+    this->Lock->Lock();
+    std::vector<long> offsets = this->RequestedOffsets;
+    this->Lock->Unlock();
+    return offsets;
+  }
+
+  SOCKET Socket;
+  int Port;
+  int ThreadId;
+  vtkNew<vtkMultiThreader> Threader;
+  vtkNew<vtkMutexLock> Lock;
+  std::string Content;
+  bool AcceptRanges;
+  std::deque<int> Responses;
+  // Start of the range of each request, -1 if the whole file was requested.
+  std::vector<long> RequestedOffsets;
+};
+
+//----------------------------------------------------------------------------
+void ServeRequest(HTTPServer* server, SOCKET connection)
+{
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos)
+    {
+    int received = recv(connection, buffer, sizeof(buffer), 0);
+    if (received <= 0)
+      {
+      return;
+      }
+    request.append(buffer, received);
+    }
+  long offset = -1;
+  std::string::size_type range = request.find("Range: bytes=");
+  if (range != std::string::npos)
+    {
+    offset = atol(request.c_str() + range + strlen("Range: bytes="));
+    }
+
+  server->Lock->Lock();
+  server->RequestedOffsets.push_back(offset);
+  int response = HTTPServer::Serve;
+  if (!server->Responses.empty())
+    {
+    response = server->Responses.front();
+    server->Responses.pop_front();
+    }
+  std::string content = server->Content;
+  bool acceptRanges = server->AcceptRanges;
+  server->Lock->Unlock();
+
+  long size = static_cast<long>(content.size());
+  std::stringstream header;
+  std::string body;
+  if (response >= 400)
+    {
+    header << "HTTP/1.1 " << response << " Error\r\n";
+    body = "error";
+    }
+  else if (offset >= 0 && acceptRanges && offset >= size)
+    {
+    header << "HTTP/1.1 416 Requested Range Not Satisfiable\r\n"
+           << "Content-Range: bytes */" << size << "\r\n";
+    }
+  else if (offset >= 0 && acceptRanges)
+    {
+    header << "HTTP/1.1 206 Partial Content\r\n"
+           << "Content-Range: bytes " << offset << "-" << size - 1 << "/" << size << "\r\n";
+    body = content.substr(offset);
+    }
+  else
+    {
+    header << "HTTP/1.1 200 OK\r\n";
+    body = content;
+    }
+  header << "Content-Length: " << body.size() << "\r\n"
+         << "Connection: close\r\n\r\n";
+  if (response == HTTPServer::Interrupt)
+    {
+    body.resize(body.size() / 2);
+    }
+  std::string reply = header.str() + body;
+  size_t sent = 0;
+  while (sent < reply.size())
+    {
+    int res = send(connection, reply.c_str() + sent, static_cast<int>(reply.size() - sent), 0);
+    if (res <= 0)
+      {
+      return;
+      }
+    sent += res;
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ServeRequests(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  HTTPServer* server = static_cast<HTTPServer*>(info->UserData);
+  while (true)
+    {
+    info->ActiveFlagLock->Lock();
+    int active = *info->ActiveFlag;
+    info->ActiveFlagLock->Unlock();
+    if (!active)
+      {
+      break;
+      }
+    fd_set sockets;
+    FD_ZERO(&sockets);
+    FD_SET(server->Socket, &sockets);
+    timeval timeout = {0, 100000};
+    if (select(static_cast<int>(server->Socket) + 1, &sockets, NULL, NULL, &timeout) <= 0)
+      {
+      continue;
+      }
+    SOCKET connection = accept(server->Socket, NULL, NULL);
+    if (connection != INVALID_SOCKET)
+      {
+      ServeRequest(server, connection);
+      closesocket(connection);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Listen on a free port of the loopback interface.
+bool StartServer(HTTPServer* server)
+{
+  server->Socket = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  socklen_t addressLength = sizeof(address);
+  if (server->Socket == INVALID_SOCKET ||
+      bind(server->Socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(server->Socket, 16) != 0 ||
+      getsockname(server->Socket, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Unable to start the HTTP server" << std::endl;
+    return false;
+    }
+  server->Port = ntohs(address.sin_port);
+  server->ThreadId = server->Threader->SpawnThread(ServeRequests, server);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void StopServer(HTTPServer* server)
+{
+  if (server->ThreadId >= 0)
+    {
+    server->Threader->TerminateThread(server->ThreadId);
+    }
+  if (server->Socket != INVALID_SOCKET)
+    {
+    closesocket(server->Socket);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CheckRequests(int line, HTTPServer* server, long offset1, long offset2 = -2, long offset3 = -2)
+{
+  std::vector<long> expected;
+  long offsets[3] = {offset1, offset2, offset3};
+  for (int i = 0; i < 3 && offsets[i] != -2; ++i)
+    {
+    expected.push_back(offsets[i]);
+    }
+  std::vector<long> requested = server->GetRequestedOffsets();
+  if (requested != expected)
+    {
+    std::cerr << "Line " << line << " - Requested ranges:";
+    for (size_t i = 0; i < requested.size(); ++i)
+      {
+      std::cerr << " " << requested[i];
+      }
+    std::cerr << " instead of";
+    for (size_t i = 0; i < expected.size(); ++i)
+      {
+      std::cerr << " " << expected[i];
+      }
+    std::cerr << " (-1 is the whole file)" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Download the server file into destination, returns the reported status.
+int StageServerFile(vtkHTTPHandler* handler, HTTPServer* server, const std::string& destination)
+{
+  TransferObserver observer;
+  observer.Done.resize(1, -1);
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(TransferCallback);
+  callback->SetClientData(&observer);
+  handler->AddObserver(vtkURIHandler::StageFileReadDoneEvent, callback.GetPointer());
+  handler->StageFileRead(server->URL().c_str(), destination.c_str());
+  handler->RemoveObservers(vtkURIHandler::StageFileReadDoneEvent);
+  return observer.Done[0];
+}
+
+//----------------------------------------------------------------------------
+bool TestHTTPRangeResume(vtkHTTPHandler* handler, HTTPServer* server, const std::string& directory)
+{
+  std::string content = FileContent(200, 300000);
+  std::string destination = directory + "/destination/http-resumed.nrrd";
+
+  // The transfer is interrupted after half of the file, the rest of the
+  // file is requested with a range.
+  server->Reset(content, true, HTTPServer::Interrupt);
+  if (StageServerFile(handler, server, destination) != 1 ||
+      !CheckRequests(__LINE__, server, -1, static_cast<long>(content.size() / 2)) ||
+      !CheckFile(__LINE__, destination, content))
+    {
+    return false;
+    }
+
+  // Partial file of a previous session
+  std::string partialContent(content.size() / 3, 'z');
+  WriteFile(destination + ".part", partialContent);
+  server->Reset(content, true);
+  return StageServerFile(handler, server, destination) == 1 &&
+    CheckRequests(__LINE__, server, static_cast<long>(partialContent.size())) &&
+    CheckFile(__LINE__, destination, partialContent + content.substr(partialContent.size()));
+}
+
+//----------------------------------------------------------------------------
+bool TestHTTPRangeErrors(vtkHTTPHandler* handler, HTTPServer* server, const std::string& directory)
+{
+  std::string content = FileContent(300, 1000);
+  std::string destination = directory + "/destination/http-range.nrrd";
+
+  // The partial file is larger than the source: the range is not
+  // satisfiable (416), the partial file is discarded and the whole file
+  // is downloaded again.
+  WriteFile(destination + ".part", std::string(2000, 'z'));
+  server->Reset(content, true);
+  if (StageServerFile(handler, server, destination) != 1 ||
+      !CheckRequests(__LINE__, server, 2000, -1) ||
+      !CheckFile(__LINE__, destination, content))
+    {
+    return false;
+    }
+
+  // The server ignores the range request and answers 200
+  WriteFile(destination + ".part", std::string(500, 'z'));
+  server->Reset(content, false);
+  return StageServerFile(handler, server, destination) == 1 &&
+    CheckRequests(__LINE__, server, 500, -1) &&
+    CheckFile(__LINE__, destination, content);
+}
+
+//----------------------------------------------------------------------------
+bool TestHTTPServerErrors(vtkHTTPHandler* handler, HTTPServer* server, const std::string& directory)
+{
+  std::string content = FileContent(400, 100000);
+  std::string destination = directory + "/destination/http-error.nrrd";
+
+  // Server errors (>= 500) are retried
+  server->Reset(content, true, 503, 500);
+  if (StageServerFile(handler, server, destination) != 1 ||
+      !CheckRequests(__LINE__, server, -1, -1, -1) ||
+      !CheckFile(__LINE__, destination, content))
+    {
+    return false;
+    }
+  vtksys::SystemTools::RemoveFile(destination.c_str());
+
+  // until there are no retries left
+  int maximumNumberOfRetries = handler->GetMaximumNumberOfRetries();
+  handler->SetMaximumNumberOfRetries(2);
+  server->Reset(content, true, 500, 502, 503);
+  int done = StageServerFile(handler, server, destination);
+  handler->SetMaximumNumberOfRetries(maximumNumberOfRetries);
+  if (done != 0 ||
+      !CheckRequests(__LINE__, server, -1, -1, -1))
+    {
+    std::cerr << "Line " << __LINE__ << " - Download reported " << done << " instead of 0" << std::endl;
+    return false;
+    }
+
+  // Client errors are not retried
+  server->Reset(content, true, 404);
+  done = StageServerFile(handler, server, destination);
+  if (done != 0 ||
+      !CheckRequests(__LINE__, server, -1))
+    {
+    std::cerr << "Line " << __LINE__ << " - Download reported " << done << " instead of 0" << std::endl;
+    return false;
+    }
+  if (vtksys::SystemTools::FileExists(destination.c_str()) ||
+      vtksys::SystemTools::FileExists((destination + ".part").c_str()))
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed download left a file" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkHTTPHandlerTest1(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string directory = std::string(argv[1]) + "/vtkHTTPHandlerTest1";
+  vtksys::SystemTools::RemoveADirectory(directory.c_str());
+  vtksys::SystemTools::MakeDirectory((directory + "/source").c_str());
+  vtksys::SystemTools::MakeDirectory((directory + "/destination").c_str());
+
+  vtkNew<vtkHTTPHandler> handler;
+  handler->SetMaximumNumberOfConnections(8);
+
+  bool res = true;
+  res = res && TestConcurrentDownloads(handler.GetPointer(), directory);
+  res = res && TestResume(handler.GetPointer(), directory);
+  res = res && TestMissingFile(handler.GetPointer(), directory);
+
+#ifdef _WIN32
+  WSADATA wsaData;
+  WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+  HTTPServer server;
+  res = res && StartServer(&server);
+  res = res && TestHTTPRangeResume(handler.GetPointer(), &server, directory);
+  res = res && TestHTTPRangeErrors(handler.GetPointer(), &server, directory);
+  res = res && TestHTTPServerErrors(handler.GetPointer(), &server, directory);
+  StopServer(&server);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+
+  vtksys::SystemTools::RemoveADirectory(directory.c_str());
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
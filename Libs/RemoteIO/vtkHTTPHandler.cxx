@@ -5,9 +5,21 @@
 // MRML includes
 #include <vtkPermissionPrompter.h>
 
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkCriticalSection.h>
+#include <vtkTimerLog.h>
+
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
 // CURL includes
 #include <curl/curl.h>
 
+// STD includes
+#include <algorithm>
+#include <cstdio>
+
 #if defined(_MSC_VER)
 #pragma warning ( disable : 4786 )
 #endif
@@ -19,9 +31,36 @@ public:
   vtkInternal(vtkHTTPHandler* external);
   ~vtkInternal();
 
+  struct Download
+    {
+    size_t Index;
+    std::string Source;
+    std::string Destination;
+    std::string PartialFile;
+    CURL* Handle;
+    FILE* File;
+    /// Size of the partial file when the transfer started.
+    vtkTypeInt64 Offset;
+    vtkTypeInt64 BytesWritten;
+    int NumberOfRetries;
+    };
+
+  void StartDownload(Download& download);
+  /// Returns true if the download must be restarted.
+  bool FinishDownload(Download& download, CURLcode result, bool& success);
+  double GetProgress(Download& download);
+
+  static size_t WriteCallback(char* buffer, size_t size, size_t nitems, void* userData);
+
   vtkHTTPHandler* External;
   CURL* CurlHandle;
   int ForbidReuse;
+  int MaximumNumberOfConnections;
+  int MaximumNumberOfConnectionsPerHost;
+  int MaximumNumberOfRetries;
+  /// Kept between calls to StageFileReads to reuse the connections.
+  CURLM* MultiHandle;
+  vtkCriticalSection* MultiHandleLock;
 };
 
 //----------------------------------------------------------------------------
@@ -32,12 +71,180 @@ vtkHTTPHandler::vtkInternal::vtkInternal(vtkHTTPHandler* external):External(exte
 {
   this->CurlHandle = NULL;
   this->ForbidReuse = 0;
+  this->MaximumNumberOfConnections = 4;
+  this->MaximumNumberOfConnectionsPerHost = 4;
+  this->MaximumNumberOfRetries = 3;
+  this->MultiHandle = NULL;
+  this->MultiHandleLock = vtkCriticalSection::New();
 }
 
 //-----------------------------------------------------------------------------
 vtkHTTPHandler::vtkInternal::~vtkInternal()
 {
   this->CurlHandle = NULL;
+  if (this->MultiHandle)
+    {
+    curl_multi_cleanup(this->MultiHandle);
+    curl_global_cleanup();
+    }
+  this->MultiHandleLock->Delete();
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkHTTPHandler::vtkInternal::WriteCallback(char* buffer, size_t size, size_t nitems, void* userData)
+{
+  Download* download = static_cast<Download*>(userData);
+  if (download->File == NULL)
+    {
+    // The partial file is opened when the first bytes are received. curl
+    // fails before writing anything if the server ignores the range request.
+    download->File = fopen(download->PartialFile.c_str(), download->Offset > 0 ? "ab" : "wb");
+    if (download->File == NULL)
+      {
+      // aborts the transfer with CURLE_WRITE_ERROR
+      return 0;
+      }
+    }
+  size_t written = fwrite(buffer, 1, size * nitems, download->File);
+  download->BytesWritten += written;
+  return written;
+}
+
+//-----------------------------------------------------------------------------
+void vtkHTTPHandler::vtkInternal::StartDownload(Download& download)
+{
+  download.Offset = 0;
+  if (vtksys::SystemTools::FileExists(download.PartialFile.c_str()))
+    {
+    download.Offset = vtksys::SystemTools::FileLength(download.PartialFile.c_str());
+    }
+  download.BytesWritten = 0;
+  download.File = NULL;
+  download.Handle = curl_easy_init();
+
+  CURL* handle = download.Handle;
+  if (this->ForbidReuse)
+    {
+    curl_easy_setopt(handle, CURLOPT_FORBID_REUSE, 1L);
+    }
+  curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+  curl_easy_setopt(handle, CURLOPT_URL, download.Source.c_str());
+  curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+  // error pages are not saved as data
+  curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+  // transfers run in a networking thread, signals can't be used for timeouts
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  // quick timeout during connection phase if URL is not accessible (e.g. blocked by a firewall)
+  curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, 3L);
+  // a stalled transfer is interrupted, and resumed if retries are left
+  curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+  curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME, 60L);
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, vtkHTTPHandler::vtkInternal::WriteCallback);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, &download);
+  curl_easy_setopt(handle, CURLOPT_PRIVATE, &download);
+  if (download.Offset > 0)
+    {
+    curl_easy_setopt(handle, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(download.Offset));
+    }
+  curl_multi_add_handle(this->MultiHandle, handle);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkHTTPHandler::vtkInternal::FinishDownload(Download& download, CURLcode result, bool& success)
+{
+  long responseCode = 0;
+  curl_easy_getinfo(download.Handle, CURLINFO_RESPONSE_CODE, &responseCode);
+  curl_multi_remove_handle(this->MultiHandle, download.Handle);
+  curl_easy_cleanup(download.Handle);
+  download.Handle = NULL;
+  if (download.File)
+    {
+    fclose(download.File);
+    download.File = NULL;
+    }
+
+  success = false;
+  // The partial file can't be resumed: the server ignored the range request
+  // (CURLE_RANGE_ERROR), or the range is past the end of the source (416,
+  // reported as a success by some curl versions).
+  bool rangeError = (download.Offset > 0 &&
+                     (result == CURLE_RANGE_ERROR ||
+                      result == CURLE_BAD_DOWNLOAD_RESUME ||
+                      responseCode == 416));
+  if (result == CURLE_OK && !rangeError)
+    {
+    if (!vtksys::SystemTools::FileExists(download.PartialFile.c_str()))
+      {
+      // empty file
+      FILE* file = fopen(download.PartialFile.c_str(), "wb");
+      if (file)
+        {
+        fclose(file);
+        }
+      }
+    if (vtksys::SystemTools::FileExists(download.Destination.c_str()))
+      {
+      vtksys::SystemTools::RemoveFile(download.Destination.c_str());
+      }
+    success = (rename(download.PartialFile.c_str(), download.Destination.c_str()) == 0);
+    if (!success)
+      {
+      vtkErrorWithObjectMacro(this->External, "StageFileReads: unable to write " << download.Destination);
+      }
+    return false;
+    }
+
+  if (rangeError)
+    {
+    // the partial file does not match the source anymore, the download
+    // restarts from the beginning without counting as a retry
+    vtksys::SystemTools::RemoveFile(download.PartialFile.c_str());
+    vtkDebugWithObjectMacro(this->External, "StageFileReads: restarting " << download.Source
+                            << " after error: " << curl_easy_strerror(result));
+    return true;
+    }
+  bool interrupted = (result == CURLE_PARTIAL_FILE ||
+                      result == CURLE_OPERATION_TIMEDOUT ||
+                      result == CURLE_RECV_ERROR ||
+                      result == CURLE_SEND_ERROR ||
+                      result == CURLE_GOT_NOTHING ||
+                      result == CURLE_COULDNT_CONNECT ||
+                      (result == CURLE_HTTP_RETURNED_ERROR && responseCode >= 500));
+  if (!interrupted)
+    {
+    vtksys::SystemTools::RemoveFile(download.PartialFile.c_str());
+    }
+  if (interrupted && download.NumberOfRetries < this->MaximumNumberOfRetries)
+    {
+    ++download.NumberOfRetries;
+    vtkDebugWithObjectMacro(this->External, "StageFileReads: resuming " << download.Source
+                            << " after error: " << curl_easy_strerror(result));
+    return true;
+    }
+
+  vtkErrorWithObjectMacro(this->External, "StageFileReads: error downloading " << download.Source
+                          << ": " << curl_easy_strerror(result));
+  //--- in case the permissions were not correct and that's
+  //--- the reason the read command failed,
+  //--- reset the 'remember check' in the permissions
+  //--- prompter so that new login info  will be prompted.
+  if ( this->External->GetPermissionPrompter() != NULL )
+    {
+    this->External->GetPermissionPrompter()->SetRemember ( 0 );
+    }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+double vtkHTTPHandler::vtkInternal::GetProgress(Download& download)
+{
+  double contentLength = -1.;
+  curl_easy_getinfo(download.Handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+  if (contentLength <= 0.)
+    {
+    return 0.;
+    }
+  return static_cast<double>(download.Offset + download.BytesWritten) / (download.Offset + contentLength);
 }
 
 //----------------------------------------------------------------------------
@@ -107,6 +314,10 @@ vtkHTTPHandler::~vtkHTTPHandler()
 void vtkHTTPHandler::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf ( os, indent );
+  os << indent << "ForbidReuse: " << this->Internal->ForbidReuse << "\n";
+  os << indent << "MaximumNumberOfConnections: " << this->Internal->MaximumNumberOfConnections << "\n";
+  os << indent << "MaximumNumberOfConnectionsPerHost: " << this->Internal->MaximumNumberOfConnectionsPerHost << "\n";
+  os << indent << "MaximumNumberOfRetries: " << this->Internal->MaximumNumberOfRetries << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -162,6 +373,60 @@ int vtkHTTPHandler::GetForbidReuse()
   return this->Internal->ForbidReuse;
 }
 
+//----------------------------------------------------------------------------
+void vtkHTTPHandler::SetMaximumNumberOfConnections(int value)
+{
+  value = std::max(value, 1);
+  if (this->Internal->MaximumNumberOfConnections == value)
+    {
+    return;
+    }
+  this->Internal->MaximumNumberOfConnections = value;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkHTTPHandler::GetMaximumNumberOfConnections()
+{
+  return this->Internal->MaximumNumberOfConnections;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPHandler::SetMaximumNumberOfConnectionsPerHost(int value)
+{
+  value = std::max(value, 1);
+  if (this->Internal->MaximumNumberOfConnectionsPerHost == value)
+    {
+    return;
+    }
+  this->Internal->MaximumNumberOfConnectionsPerHost = value;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkHTTPHandler::GetMaximumNumberOfConnectionsPerHost()
+{
+  return this->Internal->MaximumNumberOfConnectionsPerHost;
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPHandler::SetMaximumNumberOfRetries(int value)
+{
+  value = std::max(value, 0);
+  if (this->Internal->MaximumNumberOfRetries == value)
+    {
+    return;
+    }
+  this->Internal->MaximumNumberOfRetries = value;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkHTTPHandler::GetMaximumNumberOfRetries()
+{
+  return this->Internal->MaximumNumberOfRetries;
+}
+
 //----------------------------------------------------------------------------
 void vtkHTTPHandler::InitTransfer( )
 {
@@ -190,78 +455,132 @@ void vtkHTTPHandler::StageFileRead(const char * source, const char * destination
     vtkErrorMacro("StageFileRead: source or dest is null!");
     return;
     }
-  /*
-  if (this->LocalFile)
+  std::vector<std::string> sources(1, source);
+  std::vector<std::string> destinations(1, destination);
+  this->StageFileReads(sources, destinations);
+}
+
+//----------------------------------------------------------------------------
+void vtkHTTPHandler::StageFileReads(const std::vector<std::string>& sources,
+                                    const std::vector<std::string>& destinations)
+{
+  if (sources.size() != destinations.size())
     {
-    this->LocalFile->close();
-    delete this->LocalFile;
-    this->LocalFile = NULL;
+    vtkErrorMacro("StageFileReads: " << sources.size() << " sources for "
+                  << destinations.size() << " destinations");
+    return;
     }
-  this->LocalFile = new std::ofstream(destination, std::ios::binary);
-  */
-  this->InitTransfer( );
-
-
-  if ( this->Internal->ForbidReuse )
+  if (sources.empty())
     {
-    curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_FORBID_REUSE, 1);
+    return;
     }
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_HTTPGET, 1);
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_URL, source);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_NOPROGRESS, false);
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_FOLLOWLOCATION, true);
-  // use the default curl write call back
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_WRITEFUNCTION, NULL); // write_callback);
-  this->LocalFile = fopen(destination, "wb");
-  // output goes into LocalFile, must be  FILE*
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_WRITEDATA, this->LocalFile);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_PROGRESSDATA, NULL);
-//  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_PROGRESSFUNCTION, ProgressCallback);
 
-  // quick timeout during connection phase if URL is not accessible (e.g. blocked by a firewall)
-  curl_easy_setopt(this->Internal->CurlHandle, CURLOPT_CONNECTTIMEOUT, 3); // in seconds (type long)
-
-  vtkDebugMacro("StageFileRead: about to do the curl download... source = " << source << ", dest = " << destination);
-  CURLcode retval = curl_easy_perform(this->Internal->CurlHandle);
-
-  if (retval == CURLE_OK)
+  // The multi handle keeps the connections of the previous transfers open,
+  // it is used by one StageFileReads at a time.
+  this->Internal->MultiHandleLock->Lock();
+  if (this->Internal->MultiHandle == NULL)
     {
-    vtkDebugMacro("StageFileRead: successful return from curl");
+    curl_global_init(CURL_GLOBAL_ALL);
+    this->Internal->MultiHandle = curl_multi_init();
     }
-  else if (retval == CURLE_BAD_FUNCTION_ARGUMENT)
+  CURLM* multiHandle = this->Internal->MultiHandle;
+#if LIBCURL_VERSION_NUM >= 0x071E00
+  curl_multi_setopt(multiHandle, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                    static_cast<long>(this->Internal->MaximumNumberOfConnections));
+  curl_multi_setopt(multiHandle, CURLMOPT_MAX_HOST_CONNECTIONS,
+                    static_cast<long>(this->Internal->MaximumNumberOfConnectionsPerHost));
+#endif
+
+  const size_t numberOfFiles = sources.size();
+  std::vector<vtkInternal::Download> downloads(numberOfFiles);
+  for (size_t i = 0; i < numberOfFiles; ++i)
     {
-    vtkErrorMacro("StageFileRead: bad function argument to curl, did you init CurlHandle?");
+    downloads[i].Index = i;
+    downloads[i].Source = sources[i];
+    downloads[i].Destination = destinations[i];
+    downloads[i].PartialFile = destinations[i] + ".part";
+    downloads[i].Handle = NULL;
+    downloads[i].File = NULL;
+    downloads[i].Offset = 0;
+    downloads[i].BytesWritten = 0;
+    downloads[i].NumberOfRetries = 0;
     }
-  else if (retval == CURLE_OUT_OF_MEMORY)
+
+  std::vector<vtkInternal::Download*> pending;
+  for (size_t i = numberOfFiles; i > 0; --i)
     {
-    vtkErrorMacro("StageFileRead: curl ran out of memory!");
+    pending.push_back(&downloads[i - 1]);
     }
-  else
+  std::vector<vtkInternal::Download*> active;
+  size_t numberOfFilesDone = 0;
+  double lastProgressTime = 0.;
+
+  while (numberOfFilesDone < numberOfFiles)
     {
-    const char *stringError = curl_easy_strerror(retval);
-    vtkErrorMacro("StageFileRead: error running curl: " << stringError);
-    //--- in case the permissions were not correct and that's
-    //--- the reason the read command failed,
-    //--- reset the 'remember check' in the permissions
-    //--- prompter so that new login info  will be prompted.
-    if ( this->GetPermissionPrompter() != NULL )
+    while (!pending.empty() &&
+           static_cast<int>(active.size()) < this->Internal->MaximumNumberOfConnections)
       {
-      this->GetPermissionPrompter()->SetRemember ( 0 );
+      vtkDebugMacro("StageFileReads: downloading " << pending.back()->Source
+                    << " to " << pending.back()->Destination);
+      this->Internal->StartDownload(*pending.back());
+      active.push_back(pending.back());
+      pending.pop_back();
       }
-    }
-  this->CloseTransfer();
 
-  /*
-  this->LocalFile->close();
-  delete this->LocalFile;
-  this->LocalFile = NULL;
-  */
-  if (this->LocalFile)
-    {
-    fclose(this->LocalFile);
+    int runningHandles = 0;
+    curl_multi_perform(multiHandle, &runningHandles);
+
+    int messagesInQueue = 0;
+    CURLMsg* message = NULL;
+    while ((message = curl_multi_info_read(multiHandle, &messagesInQueue)) != NULL)
+      {
+      if (message->msg != CURLMSG_DONE)
+        {
+        continue;
+        }
+      vtkInternal::Download* download = NULL;
+      curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&download));
+      // message is invalidated when the handle is removed
+      CURLcode result = message->data.result;
+      active.erase(std::find(active.begin(), active.end(), download));
+      bool success = false;
+      if (this->Internal->FinishDownload(*download, result, success))
+        {
+        pending.push_back(download);
+        continue;
+        }
+      ++numberOfFilesDone;
+      int callData[2] = {static_cast<int>(download->Index), success ? 1 : 0};
+      this->InvokeEvent(vtkURIHandler::StageFileReadDoneEvent, callData);
+      }
+
+    double now = vtkTimerLog::GetUniversalTime();
+    if (now - lastProgressTime > 0.2 && numberOfFilesDone < numberOfFiles)
+      {
+      lastProgressTime = now;
+      double progress = numberOfFilesDone;
+      for (size_t i = 0; i < active.size(); ++i)
+        {
+        progress += this->Internal->GetProgress(*active[i]);
+        }
+      progress /= numberOfFiles;
+      this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+      }
+
+    if (!active.empty())
+      {
+#if LIBCURL_VERSION_NUM >= 0x071C00
+      curl_multi_wait(multiHandle, NULL, 0, 100, NULL);
+#else
+      vtksys::SystemTools::Delay(10);
+#endif
+      }
     }
-}
+  this->Internal->MultiHandleLock->Unlock();
 
+  double progress = 1.;
+  this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+}
 
 //----------------------------------------------------------------------------
 void vtkHTTPHandler::StageFileWrite(const char * source, const char * destination)
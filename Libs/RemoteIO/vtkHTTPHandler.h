@@ -32,9 +32,32 @@ public:
   void SetForbidReuse(int value);
   int GetForbidReuse();
 
+  /// Maximum number of files StageFileReads downloads at once.
+  /// Default is 4.
+  void SetMaximumNumberOfConnections(int value);
+  int GetMaximumNumberOfConnections();
+
+  /// Maximum number of connections opened to the same host. Connections
+  /// to a host are kept open and reused by the following transfers.
+  /// Default is 4.
+  void SetMaximumNumberOfConnectionsPerHost(int value);
+  int GetMaximumNumberOfConnectionsPerHost();
+
+  /// Number of times an interrupted download is resumed before giving up.
+  /// Default is 3.
+  void SetMaximumNumberOfRetries(int value);
+  int GetMaximumNumberOfRetries();
+
   /// This function wraps curl functionality to download a specified URL to a specified dir
   void StageFileRead(const char * source, const char * destination);
   using vtkURIHandler::StageFileRead;
+
+  /// Downloads the files concurrently with a curl multi handle.
+  /// Each file is downloaded into destination.part first, and renamed
+  /// when complete. An interrupted download is resumed from the end of
+  /// the partial file, with an HTTP range request.
+  virtual void StageFileReads(const std::vector<std::string>& sources,
+                              const std::vector<std::string>& destinations);
   void StageFileWrite(const char * source, const char * destination);
   using vtkURIHandler::StageFileWrite;
   virtual void InitTransfer ( );
@@ -0,0 +1,133 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkCachedPlaneCutter.h>
+
+// VTK includes
+#include <vtkCutter.h>
+#include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <vector>
+
+//----------------------------------------------------------------------------
+int vtkCachedPlaneCutterTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(10.);
+  sphere->SetThetaResolution(400);
+  sphere->SetPhiResolution(400);
+  sphere->Update();
+
+  vtkNew<vtkPlane> referencePlane;
+  referencePlane->SetNormal(0.2, 0.3, 1.);
+  vtkNew<vtkCutter> referenceCutter;
+  referenceCutter->SetCutFunction(referencePlane.GetPointer());
+  referenceCutter->SetGenerateCutScalars(0);
+  referenceCutter->SetInputConnection(sphere->GetOutputPort());
+
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(0.2, 0.3, 1.);
+  vtkNew<vtkCachedPlaneCutter> cutter;
+  cutter->SetPlane(plane.GetPointer());
+  cutter->SetInputConnection(sphere->GetOutputPort());
+
+  // Scroll the plane through the sphere, past both ends
+  const int numberOfSlices = 100;
+  double referenceTime = 0.;
+  double cachedTime = 0.;
+  vtkNew<vtkTimerLog> timer;
+  for (int i = 0; i <= numberOfSlices; ++i)
+    {
+    double z = -12. + 24. * i / numberOfSlices;
+    referencePlane->SetOrigin(0., 0., z);
+    plane->SetOrigin(0., 0., z);
+
+    timer->StartTimer();
+    referenceCutter->Update();
+    timer->StopTimer();
+    referenceTime += timer->GetElapsedTime();
+
+    timer->StartTimer();
+    cutter->Update();
+    timer->StopTimer();
+    cachedTime += timer->GetElapsedTime();
+
+    vtkPolyData* expected = referenceCutter->GetOutput();
+    vtkPolyData* output = cutter->GetOutput();
+    if (output->GetNumberOfPoints() != expected->GetNumberOfPoints() ||
+        output->GetNumberOfLines() != expected->GetNumberOfLines())
+      {
+      std::cerr << "Line " << __LINE__ << " - Cut at z=" << z << " failed:"
+                << " expected " << expected->GetNumberOfPoints() << " points and "
+                << expected->GetNumberOfLines() << " lines, got "
+                << output->GetNumberOfPoints() << " points and "
+                << output->GetNumberOfLines() << " lines" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (output->GetNumberOfPoints() > 0 &&
+        cutter->GetNumberOfCutCells() >= sphere->GetOutput()->GetNumberOfCells() / 2)
+      {
+      std::cerr << "Line " << __LINE__ << " - Cut at z=" << z << " contoured "
+                << cutter->GetNumberOfCutCells() << " cells, only the cells"
+                << " straddling the plane should be contoured" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::cout << "<DartMeasurement name=\"vtkCutter-" << numberOfSlices
+            << "Slices\" type=\"numeric/double\">"
+            << referenceTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkCachedPlaneCutter-" << numberOfSlices
+            << "Slices\" type=\"numeric/double\">"
+            << cachedTime << "</DartMeasurement>" << std::endl;
+
+  // Cut several inputs at once
+  std::vector<vtkSmartPointer<vtkCachedPlaneCutter> > cutters;
+  std::vector<vtkCachedPlaneCutter*> cutterPointers;
+  for (int i = 0; i < 8; ++i)
+    {
+    vtkSmartPointer<vtkCachedPlaneCutter> parallelCutter = vtkSmartPointer<vtkCachedPlaneCutter>::New();
+    parallelCutter->SetPlane(plane.GetPointer());
+    parallelCutter->SetInputConnection(sphere->GetOutputPort());
+    cutters.push_back(parallelCutter);
+    cutterPointers.push_back(parallelCutter);
+    }
+  plane->SetOrigin(0., 0., 1.);
+  referencePlane->SetOrigin(0., 0., 1.);
+  referenceCutter->Update();
+  vtkCachedPlaneCutter::UpdateInParallel(cutterPointers);
+  for (size_t i = 0; i < cutters.size(); ++i)
+    {
+    cutters[i]->Update();
+    if (cutters[i]->GetOutput()->GetNumberOfLines() !=
+        referenceCutter->GetOutput()->GetNumberOfLines())
+      {
+      std::cerr << "Line " << __LINE__ << " - UpdateInParallel failed: expected "
+                << referenceCutter->GetOutput()->GetNumberOfLines() << " lines, got "
+                << cutters[i]->GetOutput()->GetNumberOfLines() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
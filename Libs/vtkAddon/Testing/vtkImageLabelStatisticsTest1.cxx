@@ -0,0 +1,220 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkImageLabelStatistics.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct ReferenceStatistics
+{
+  ReferenceStatistics()
+  {
+    this->Count = 0;
+    this->Extent[0] = this->Extent[2] = this->Extent[4] = VTK_INT_MAX;
+    this->Extent[1] = this->Extent[3] = this->Extent[5] = VTK_INT_MIN;
+    this->IndexSum[0] = this->IndexSum[1] = this->IndexSum[2] = 0.;
+  }
+  int Count;
+  int Extent[6];
+  double IndexSum[3];
+  std::vector<double> Values;
+};
+
+//----------------------------------------------------------------------------
+void AllocateImage(vtkImageData* image, int dimension, int scalarType)
+{
+  image->SetExtent(0, dimension - 1, 0, dimension - 1, 0, dimension - 1);
+#if (VTK_MAJOR_VERSION <= 5)
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+#else
+  image->AllocateScalars(scalarType, 1);
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool CheckValue(int line, const char* what, int label, double value, double expected)
+{
+  if (fabs(value - expected) > 1e-6 * std::max(1., fabs(expected)))
+    {
+    std::cerr << "Line " << line << " - " << what << " of label " << label << ": "
+              << value << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatisticsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  const int dimension = 128;
+  vtkNew<vtkImageData> labelMap;
+  AllocateImage(labelMap.GetPointer(), dimension, VTK_SHORT);
+  vtkNew<vtkImageData> grayscale;
+  AllocateImage(grayscale.GetPointer(), dimension, VTK_FLOAT);
+
+  // Blocks of labels in a sphere, with a few isolated voxels
+  std::map<int, ReferenceStatistics> reference;
+  short* labels = static_cast<short*>(labelMap->GetScalarPointer());
+  float* values = static_cast<float*>(grayscale->GetScalarPointer());
+  for (int k = 0; k < dimension; ++k)
+    {
+    for (int j = 0; j < dimension; ++j)
+      {
+      for (int i = 0; i < dimension; ++i, ++labels, ++values)
+        {
+        double radius = sqrt(static_cast<double>((i - 64) * (i - 64) + (j - 64) * (j - 64) + (k - 64) * (k - 64)));
+        short label = (radius < 60. ? static_cast<short>(1 + i / 16 + 8 * (j / 16) + 64 * (k / 32)) : 0);
+        if ((i * 7 + j * 13 + k * 17) % 1009 == 0)
+          {
+          label = 1000;
+          }
+        *labels = label;
+        *values = static_cast<float>(1000. + 0.5 * i - 2. * j + k + ((i * j + k) % 10));
+        ReferenceStatistics& statistics = reference[label];
+        ++statistics.Count;
+        int ijk[3] = {i, j, k};
+        for (int axis = 0; axis < 3; ++axis)
+          {
+          statistics.IndexSum[axis] += ijk[axis];
+          statistics.Extent[2 * axis] = std::min(statistics.Extent[2 * axis], ijk[axis]);
+          statistics.Extent[2 * axis + 1] = std::max(statistics.Extent[2 * axis + 1], ijk[axis]);
+          }
+        statistics.Values.push_back(*values);
+        }
+      }
+    }
+
+  vtkNew<vtkImageLabelStatistics> filter;
+#if (VTK_MAJOR_VERSION <= 5)
+  filter->SetInput(labelMap.GetPointer());
+  filter->SetGrayscale(grayscale.GetPointer());
+#else
+  filter->SetInputData(labelMap.GetPointer());
+  filter->SetGrayscaleData(grayscale.GetPointer());
+#endif
+  filter->ComputePercentilesOn();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  filter->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkImageLabelStatistics-" << reference.size() << "Labels"
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  if (filter->GetNumberOfLabels() != static_cast<int>(reference.size()))
+    {
+    std::cerr << "Line " << __LINE__ << " - " << filter->GetNumberOfLabels()
+              << " labels instead of " << reference.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  int index = 0;
+  for (std::map<int, ReferenceStatistics>::iterator it = reference.begin();
+       it != reference.end(); ++it, ++index)
+    {
+    int label = it->first;
+    ReferenceStatistics& expected = it->second;
+    if (filter->GetLabel(index) != label || filter->GetCount(label) != expected.Count)
+      {
+      std::cerr << "Line " << __LINE__ << " - Label " << filter->GetLabel(index) << " with "
+                << filter->GetCount(label) << " voxels instead of label " << label
+                << " with " << expected.Count << " voxels" << std::endl;
+      return EXIT_FAILURE;
+      }
+    int extent[6];
+    filter->GetBoundingBox(label, extent);
+    if (!std::equal(extent, extent + 6, expected.Extent))
+      {
+      std::cerr << "Line " << __LINE__ << " - Wrong bounding box for label " << label << std::endl;
+      return EXIT_FAILURE;
+      }
+    double centroid[3];
+    filter->GetCentroid(label, centroid);
+
+    double sum = 0.;
+    for (size_t n = 0; n < expected.Values.size(); ++n)
+      {
+      sum += expected.Values[n];
+      }
+    double mean = sum / expected.Count;
+    double squares = 0.;
+    for (size_t n = 0; n < expected.Values.size(); ++n)
+      {
+      squares += (expected.Values[n] - mean) * (expected.Values[n] - mean);
+      }
+    double standardDeviation = expected.Count > 1 ? sqrt(squares / (expected.Count - 1)) : 0.;
+    std::sort(expected.Values.begin(), expected.Values.end());
+    double median = expected.Values.size() % 2 ? expected.Values[expected.Values.size() / 2]
+      : 0.5 * (expected.Values[expected.Values.size() / 2 - 1] + expected.Values[expected.Values.size() / 2]);
+
+    if (!CheckValue(__LINE__, "Centroid I", label, centroid[0], expected.IndexSum[0] / expected.Count) ||
+        !CheckValue(__LINE__, "Centroid J", label, centroid[1], expected.IndexSum[1] / expected.Count) ||
+        !CheckValue(__LINE__, "Centroid K", label, centroid[2], expected.IndexSum[2] / expected.Count) ||
+        !CheckValue(__LINE__, "Min", label, filter->GetMin(label), expected.Values.front()) ||
+        !CheckValue(__LINE__, "Max", label, filter->GetMax(label), expected.Values.back()) ||
+        !CheckValue(__LINE__, "Mean", label, filter->GetMean(label), mean) ||
+        !CheckValue(__LINE__, "StdDev", label, filter->GetStandardDeviation(label), standardDeviation) ||
+        !CheckValue(__LINE__, "Median", label, filter->GetPercentile(label, 50.), median) ||
+        !CheckValue(__LINE__, "Percentile 100", label, filter->GetPercentile(label, 100.), expected.Values.back()))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Missing label
+  if (filter->HasLabel(2000) || filter->GetCount(2000) != 0 || filter->GetMean(2000) != 0.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Statistics reported for a missing label" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Without grayscale, only the geometry of the labels is computed
+#if (VTK_MAJOR_VERSION <= 5)
+  filter->SetGrayscale(NULL);
+#else
+  filter->SetGrayscaleData(NULL);
+#endif
+  filter->Update();
+  if (filter->GetNumberOfLabels() != static_cast<int>(reference.size()) ||
+      filter->GetCount(1000) != reference[1000].Count ||
+      filter->GetMean(1000) != 0.)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong statistics without grayscale image" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkOrientedBSplineTransform.h>
+#include <vtkOrientedGridTransform.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <string>
+
+//----------------------------------------------------------------------------
+// Transforms that count how many points are inverted with the iterative method,
+// to verify that the precomputed inverse is actually used.
+class vtkCountingOrientedGridTransform : public vtkOrientedGridTransform
+{
+public:
+  static vtkCountingOrientedGridTransform *New();
+  vtkTypeMacro(vtkCountingOrientedGridTransform,vtkOrientedGridTransform);
+  vtkAbstractTransform *MakeTransform() { return vtkCountingOrientedGridTransform::New(); }
+
+  // Counting is enabled after the update, when the transform is not
+  // used from multiple threads anymore
+  bool Counting;
+  int NumberOfIterativeInverses;
+  int NumberOfInitializedIterativeInverses;
+
+protected:
+  vtkCountingOrientedGridTransform()
+    : Counting(false), NumberOfIterativeInverses(0), NumberOfInitializedIterativeInverses(0) {}
+  virtual bool IterativeInverseTransformDerivative(const double in[3], const double* initialInverse,
+    double out[3], double derivative[3][3], bool warnIfNotConverged)
+    {
+    if (this->Counting)
+      {
+      this->NumberOfIterativeInverses++;
+      this->NumberOfInitializedIterativeInverses += (initialInverse ? 1 : 0);
+      }
+    return this->Superclass::IterativeInverseTransformDerivative(in, initialInverse, out, derivative, warnIfNotConverged);
+    }
+};
+vtkStandardNewMacro(vtkCountingOrientedGridTransform);
+
+//----------------------------------------------------------------------------
+class vtkCountingOrientedBSplineTransform : public vtkOrientedBSplineTransform
+{
+public:
+  static vtkCountingOrientedBSplineTransform *New();
+  vtkTypeMacro(vtkCountingOrientedBSplineTransform,vtkOrientedBSplineTransform);
+  vtkAbstractTransform *MakeTransform() { return vtkCountingOrientedBSplineTransform::New(); }
+
+  bool Counting;
+  int NumberOfIterativeInverses;
+  int NumberOfInitializedIterativeInverses;
+
+protected:
+  vtkCountingOrientedBSplineTransform()
+    : Counting(false), NumberOfIterativeInverses(0), NumberOfInitializedIterativeInverses(0) {}
+  virtual bool IterativeInverseTransformDerivative(const double in[3], const double* initialInverse,
+    double out[3], double derivative[3][3], bool warnIfNotConverged)
+    {
+    if (this->Counting)
+      {
+      this->NumberOfIterativeInverses++;
+      this->NumberOfInitializedIterativeInverses += (initialInverse ? 1 : 0);
+      }
+    return this->Superclass::IterativeInverseTransformDerivative(in, initialInverse, out, derivative, warnIfNotConverged);
+    }
+};
+vtkStandardNewMacro(vtkCountingOrientedBSplineTransform);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateDisplacementField(vtkImageData* field, int size)
+{
+  field->SetExtent(0, size-1, 0, size-1, 0, size-1);
+  field->SetOrigin(-75., -70., -80.);
+  field->SetSpacing(150./(size-1), 140./(size-1), 160./(size-1));
+#if (VTK_MAJOR_VERSION <= 5)
+  field->SetScalarTypeToDouble();
+  field->SetNumberOfScalarComponents(3);
+  field->AllocateScalars();
+#else
+  field->AllocateScalars(VTK_DOUBLE, 3);
+#endif
+  double* displacement = static_cast<double*>(field->GetScalarPointer());
+  for (int k = 0; k < size; k++)
+    {
+    for (int j = 0; j < size; j++)
+      {
+      for (int i = 0; i < size; i++)
+        {
+        // smooth deformation without folds
+        *(displacement++) = 4. * sin(0.3 * j);
+        *(displacement++) = 3. * cos(0.2 * k);
+        *(displacement++) = 2. * sin(0.25 * i + 0.1 * j);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void SetDirection(vtkMatrix4x4* direction)
+{
+  double angle = vtkMath::RadiansFromDegrees(20.);
+  direction->Identity();
+  direction->SetElement(0, 0, cos(angle));
+  direction->SetElement(0, 1, -sin(angle));
+  direction->SetElement(1, 0, sin(angle));
+  direction->SetElement(1, 1, cos(angle));
+}
+
+//----------------------------------------------------------------------------
+template <class CountingTransformType>
+bool CompareInverses(const std::string& name, CountingTransformType* forward,
+                     CountingTransformType* referenceForward, vtkImageData* displacementField,
+                     double minimumInterpolatedFraction)
+{
+  CountingTransformType* inverse = CountingTransformType::SafeDownCast(forward->GetInverse());
+  CountingTransformType* referenceInverse = CountingTransformType::SafeDownCast(referenceForward->GetInverse());
+  if (!inverse || !referenceInverse)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << name << ": unexpected inverse transform type" << std::endl;
+    return false;
+    }
+
+  const int numberOfPoints = 20000;
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    points->SetPoint(i, vtkMath::Random(-60., 60.), vtkMath::Random(-60., 60.), vtkMath::Random(-60., 60.));
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  inverse->Update();
+  referenceInverse->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"" << name << "-PrecomputeInverse"
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  inverse->Counting = true;
+  referenceInverse->Counting = true;
+
+  vtkNew<vtkPoints> referencePoints;
+  timer->StartTimer();
+  referenceInverse->TransformPoints(points.GetPointer(), referencePoints.GetPointer());
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"" << name << "-IterativeInverse"
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  vtkNew<vtkPoints> inversePoints;
+  timer->StartTimer();
+  inverse->TransformPoints(points.GetPointer(), inversePoints.GetPointer());
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"" << name << "-PrecomputedInverse"
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  if (!inverse->HasPrecomputedInverse() || referenceInverse->HasPrecomputedInverse())
+    {
+    std::cerr << "Line " << __LINE__ << " - " << name << ": inverse was not precomputed" << std::endl;
+    return false;
+    }
+
+  // Without precomputed inverse each point is inverted iteratively from scratch
+  if (referenceInverse->NumberOfIterativeInverses != numberOfPoints
+    || referenceInverse->NumberOfInitializedIterativeInverses != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << name << ": unexpected number of iterative inverses: "
+              << referenceInverse->NumberOfIterativeInverses << std::endl;
+    return false;
+    }
+
+  // With precomputed inverse the points inside the grid are interpolated
+  // (and only refined iteratively if not accurate enough). The grid does not
+  // cover about 20% of the test points, those are inverted from scratch.
+  int numberOfNotInterpolated = inverse->NumberOfIterativeInverses - inverse->NumberOfInitializedIterativeInverses;
+  int numberOfInterpolatedWithinTolerance = numberOfPoints - inverse->NumberOfIterativeInverses;
+  std::cout << name << ": " << numberOfInterpolatedWithinTolerance << " interpolated, "
+            << inverse->NumberOfInitializedIterativeInverses << " interpolated and refined, "
+            << numberOfNotInterpolated << " iterative inverses" << std::endl;
+  if (numberOfNotInterpolated > 0.3 * numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << name << ": precomputed inverse was not used for "
+              << numberOfNotInterpolated << " points" << std::endl;
+    return false;
+    }
+  if (numberOfInterpolatedWithinTolerance < minimumInterpolatedFraction * numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << name << ": only " << numberOfInterpolatedWithinTolerance
+              << " interpolated inverses were within tolerance" << std::endl;
+    return false;
+    }
+
+  // Both inverses have a residual below the tolerance, allow some more
+  // for the distance between them as the deformation is not an isometry
+  double maximumDistance = 4 * forward->GetInverseTolerance();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    double distance = sqrt(vtkMath::Distance2BetweenPoints(
+      inversePoints->GetPoint(i), referencePoints->GetPoint(i)));
+    if (distance > maximumDistance)
+      {
+      double* point = points->GetPoint(i);
+      std::cerr << "Line " << __LINE__ << " - " << name << ": inverse of ("
+                << point[0] << ", " << point[1] << ", " << point[2] << ") is "
+                << distance << " away from the iterative inverse" << std::endl;
+      return false;
+      }
+    }
+
+  // Modifying the forward transform invalidates the precomputed inverse
+  inverse->Counting = false;
+  referenceInverse->Counting = false;
+  double* displacement = static_cast<double*>(displacementField->GetScalarPointer());
+  vtkIdType numberOfValues = 3 * displacementField->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfValues; i++)
+    {
+    displacement[i] *= 0.5;
+    }
+  displacementField->Modified();
+  double point[3] = {10., 20., -5.};
+  double inversePoint[3];
+  double referenceInversePoint[3];
+  inverse->TransformPoint(point, inversePoint);
+  referenceInverse->TransformPoint(point, referenceInversePoint);
+  if (sqrt(vtkMath::Distance2BetweenPoints(inversePoint, referenceInversePoint)) > maximumDistance)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << name
+              << ": precomputed inverse was not updated" << std::endl;
+    return false;
+    }
+
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkOrientedTransformPrecomputedInverseTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMatrix4x4> direction;
+  SetDirection(direction.GetPointer());
+
+  // Displacement field
+  vtkNew<vtkImageData> displacementField;
+  CreateDisplacementField(displacementField.GetPointer(), 40);
+
+  vtkNew<vtkCountingOrientedGridTransform> gridTransform;
+  vtkNew<vtkCountingOrientedGridTransform> referenceGridTransform;
+  vtkCountingOrientedGridTransform* gridTransforms[2] = {gridTransform.GetPointer(), referenceGridTransform.GetPointer()};
+  for (int i = 0; i < 2; i++)
+    {
+#if (VTK_MAJOR_VERSION <= 5)
+    gridTransforms[i]->SetDisplacementGrid(displacementField.GetPointer());
+#else
+    gridTransforms[i]->SetDisplacementGridData(displacementField.GetPointer());
+#endif
+    gridTransforms[i]->SetGridDirectionMatrix(direction.GetPointer());
+    }
+  gridTransform->PrecomputeInverseOn();
+  // The test field is too wavy for the interpolated inverse to be within
+  // tolerance, it is only used as initial value of the iterative method
+  if (!CompareInverses("vtkOrientedGridTransform", gridTransform.GetPointer(), referenceGridTransform.GetPointer(),
+    displacementField.GetPointer(), 0.0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // B-spline
+  vtkNew<vtkImageData> coefficients;
+  CreateDisplacementField(coefficients.GetPointer(), 12);
+
+  vtkNew<vtkCountingOrientedBSplineTransform> bsplineTransform;
+  vtkNew<vtkCountingOrientedBSplineTransform> referenceBSplineTransform;
+  vtkCountingOrientedBSplineTransform* bsplineTransforms[2] = {bsplineTransform.GetPointer(), referenceBSplineTransform.GetPointer()};
+  for (int i = 0; i < 2; i++)
+    {
+#if (VTK_MAJOR_VERSION <= 5)
+    bsplineTransforms[i]->SetCoefficients(coefficients.GetPointer());
+#else
+    bsplineTransforms[i]->SetCoefficientData(coefficients.GetPointer());
+#endif
+    bsplineTransforms[i]->SetGridDirectionMatrix(direction.GetPointer());
+    }
+  bsplineTransform->PrecomputeInverseOn();
+  // The inverse is sampled on a subdivided control point grid, which is dense
+  // enough for most interpolated inverses to be within tolerance
+  if (!CompareInverses("vtkOrientedBSplineTransform", bsplineTransform.GetPointer(), referenceBSplineTransform.GetPointer(),
+    coefficients.GetPointer(), 0.5))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkPolyDataToLabelMapFilter.h>
+
+// VTK includes
+#include <vtkAppendPolyData.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Count the voxels with a given value, and the voxels that have a wrong
+// value given the distance of their center to the origin.
+void CountVoxels(vtkImageData* image, unsigned char value, double innerRadius, double outerRadius,
+                 unsigned char outerValue, int& count, int& errors)
+{
+  count = 0;
+  errors = 0;
+  int* extent = image->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        double point[3];
+        int ijk[3] = {i, j, k};
+        vtkIdType pointId = image->ComputePointId(ijk);
+        image->GetPoint(pointId, point);
+        double radius = sqrt(point[0] * point[0] + point[1] * point[1] + point[2] * point[2]);
+        unsigned char voxel = *static_cast<unsigned char*>(image->GetScalarPointer(i, j, k));
+        count += (voxel == value ? 1 : 0);
+        // the facets of the spheres are inside the exact spheres
+        if ((radius < 0.99 * innerRadius && voxel != value) ||
+            (radius > innerRadius && radius < 0.99 * outerRadius && voxel != outerValue))
+          {
+          ++errors;
+          }
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkPolyDataToLabelMapFilterTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> labelMap;
+  labelMap->SetExtent(0, 99, 0, 99, 0, 99);
+  labelMap->SetOrigin(-24.75, -24.75, -24.75);
+  labelMap->SetSpacing(0.5, 0.5, 0.5);
+#if (VTK_MAJOR_VERSION <= 5)
+  labelMap->SetScalarTypeToUnsignedChar();
+  labelMap->SetNumberOfScalarComponents(1);
+  labelMap->AllocateScalars();
+#else
+  labelMap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+#endif
+  labelMap->GetPointData()->GetScalars()->FillComponent(0, 0.);
+
+  vtkNew<vtkSphereSource> outerSphere;
+  outerSphere->SetRadius(20.);
+  outerSphere->SetThetaResolution(200);
+  outerSphere->SetPhiResolution(200);
+  vtkNew<vtkSphereSource> innerSphere;
+  innerSphere->SetRadius(10.);
+  innerSphere->SetThetaResolution(100);
+  innerSphere->SetPhiResolution(100);
+
+  //
+  // Two surfaces, the second one overwrites the first one
+  //
+  vtkNew<vtkPolyDataToLabelMapFilter> filter;
+#if (VTK_MAJOR_VERSION <= 5)
+  filter->SetInput(labelMap.GetPointer());
+#else
+  filter->SetInputData(labelMap.GetPointer());
+#endif
+  filter->AddInputSurfaceConnection(outerSphere->GetOutputPort());
+  filter->AddInputSurfaceConnection(innerSphere->GetOutputPort());
+  filter->SetLabelValue(0, 1);
+  filter->SetLabelValue(1, 2);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  filter->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkPolyDataToLabelMapFilter-TwoSpheres"
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  int count = 0;
+  int errors = 0;
+  CountVoxels(filter->GetOutput(), 2, 10., 20., 1, count, errors);
+  double expectedCount = 4. / 3. * vtkMath::Pi() * pow(10. / 0.5, 3);
+  if (errors != 0 || fabs(count - expectedCount) > 0.02 * expectedCount)
+    {
+    std::cerr << "Line " << __LINE__ << " - Painting two surfaces failed: "
+              << count << " voxels instead of " << expectedCount << ", "
+              << errors << " misclassified voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned char* inputLabel = static_cast<unsigned char*>(labelMap->GetScalarPointer(50, 50, 50));
+  if (*inputLabel != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - The input label map was modified" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Nested surfaces in a single input: parity leaves a shell
+  //
+  vtkNew<vtkAppendPolyData> append;
+  append->AddInputConnection(outerSphere->GetOutputPort());
+  append->AddInputConnection(innerSphere->GetOutputPort());
+  filter->RemoveAllInputSurfaces();
+  filter->AddInputSurfaceConnection(append->GetOutputPort());
+  filter->SetLabelValue(0, 3);
+  filter->SetFillRuleToParity();
+  filter->Update();
+  CountVoxels(filter->GetOutput(), 0, 10., 20., 3, count, errors);
+  if (filter->GetNumberOfInputSurfaces() != 1 || errors != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Parity fill failed: "
+              << errors << " misclassified voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // non-zero winding fills the consistently oriented spheres entirely
+  filter->SetFillRuleToNonZero();
+  filter->Update();
+  CountVoxels(filter->GetOutput(), 3, 20., 20., 3, count, errors);
+  expectedCount = 4. / 3. * vtkMath::Pi() * pow(20. / 0.5, 3);
+  if (errors != 0 || fabs(count - expectedCount) > 0.02 * expectedCount)
+    {
+    std::cerr << "Line " << __LINE__ << " - Non-zero fill failed: "
+              << count << " voxels instead of " << expectedCount << ", "
+              << errors << " misclassified voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkTracer.h>
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+const int NumberOfZonesPerThread = 1000;
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE RecordZones(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  std::stringstream threadName;
+  threadName << "Worker " << info->ThreadID;
+  vtkTracer::GetInstance()->SetThreadName(threadName.str().c_str());
+  for (int i = 0; i < NumberOfZonesPerThread; ++i)
+    {
+    vtkTraceZoneMacro("Work", "Test");
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+int CountOccurrences(const std::string& text, const std::string& pattern)
+{
+  int count = 0;
+  for (size_t position = text.find(pattern); position != std::string::npos;
+       position = text.find(pattern, position + pattern.size()))
+    {
+    ++count;
+    }
+  return count;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTracerTest1(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkTracer* tracer = vtkTracer::GetInstance();
+
+  // Nothing is recorded while the tracer is disabled
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < 1000000; ++i)
+    {
+    vtkTraceZoneMacro("Disabled", "Test");
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkTracer-DisabledZones-1000000\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  vtkTraceCounterMacro("Disabled", 1.);
+  if (tracer->GetNumberOfEvents() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << tracer->GetNumberOfEvents()
+              << " events recorded by a disabled tracer" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  tracer->EnabledOn();
+  tracer->SetThreadName("Main");
+  {
+  vtkTraceZoneWithDetailMacro("Outer \"zone\"", "Test", "C:\\data\\file.nrrd");
+  vtkTraceCounterMacro("Counter", 42.);
+  }
+
+  const int numberOfThreads = 4;
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(RecordZones, 0);
+  timer->StartTimer();
+  threader->SingleMethodExecute();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkTracer-EnabledZones-" << numberOfThreads * NumberOfZonesPerThread
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // The main thread runs the first worker and is renamed
+  int expectedNumberOfEvents = 2 + numberOfThreads * (NumberOfZonesPerThread + 1);
+  if (tracer->GetNumberOfEvents() != expectedNumberOfEvents)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << tracer->GetNumberOfEvents()
+              << " events instead of " << expectedNumberOfEvents << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::string fileName = std::string(argv[1]) + "/vtkTracerTest1.json";
+  tracer->SetFileName(fileName.c_str());
+  if (!tracer->WriteTrace())
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to write " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::ifstream input(fileName.c_str());
+  std::stringstream content;
+  content << input.rdbuf();
+  std::string trace = content.str();
+  if (trace.find("{\"traceEvents\":[") != 0 ||
+      CountOccurrences(trace, "\"name\":\"Work\"") != numberOfThreads * NumberOfZonesPerThread ||
+      CountOccurrences(trace, "\"name\":\"thread_name\"") != numberOfThreads ||
+      trace.find("\"name\":\"Outer \\\"zone\\\"\"") == std::string::npos ||
+      trace.find("\"detail\":\"C:\\\\data\\\\file.nrrd\"") == std::string::npos ||
+      trace.find("\"args\":{\"value\":42.000}") == std::string::npos)
+    {
+    std::cerr << "Line " << __LINE__ << " - Unexpected trace:\n" << trace.substr(0, 1000) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Thread names are kept
+  tracer->ClearEvents();
+  if (tracer->GetNumberOfEvents() != numberOfThreads)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << tracer->GetNumberOfEvents()
+              << " events after clear instead of " << numberOfThreads << std::endl;
+    return EXIT_FAILURE;
+    }
+  tracer->EnabledOff();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,376 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkCachedPlaneCutter.h"
+
+#include "vtkAlgorithmOutput.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkExecutive.h"
+#include "vtkGenericCell.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMath.h"
+#include "vtkMergePoints.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPlane.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+
+// STD includes
+#include <algorithm>
+
+vtkStandardNewMacro(vtkCachedPlaneCutter);
+
+vtkCxxSetObjectMacro(vtkCachedPlaneCutter,Plane,vtkPlane);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool HasMoreCandidateCells(const std::pair<vtkIdType, vtkCachedPlaneCutter*>& a,
+                           const std::pair<vtkIdType, vtkCachedPlaneCutter*>& b)
+{
+  return a.first > b.first;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkCachedPlaneCutter::vtkCachedPlaneCutter()
+{
+  this->Plane = NULL;
+
+  this->CachedInput = NULL;
+  this->CachedInputMTime = 0;
+  this->CachedNormal[0] = 0.0;
+  this->CachedNormal[1] = 0.0;
+  this->CachedNormal[2] = 0.0;
+  this->MaximumIntervalLength = 0.0;
+  this->MinimumDistance = 0.0;
+  this->MaximumDistance = 0.0;
+
+  this->Cut = vtkPolyData::New();
+  this->CutInputMTime = 0;
+  this->CutPlaneMTime = 0;
+  this->CutDistance = 0.0;
+  this->FirstCutInterval = 0;
+  this->EndCutInterval = 0;
+  this->Locator = vtkMergePoints::New();
+  this->Cell = vtkGenericCell::New();
+  this->CellDistances = vtkDoubleArray::New();
+  this->NumberOfCutCells = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkCachedPlaneCutter::~vtkCachedPlaneCutter()
+{
+  this->SetPlane(NULL);
+  this->Cut->Delete();
+  this->Locator->Delete();
+  this->Cell->Delete();
+  this->CellDistances->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedPlaneCutter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Plane: " << this->Plane << "\n";
+  if (this->Plane)
+    {
+    this->Plane->PrintSelf(os,indent.GetNextIndent());
+    }
+  os << indent << "Number of cached cell intervals: " << this->CellIntervals.size() << "\n";
+  os << indent << "NumberOfCutCells: " << this->NumberOfCutCells << "\n";
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkCachedPlaneCutter::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  if (this->Plane)
+    {
+    mTime = std::max(mTime, this->Plane->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedPlaneCutter::UpdateCellIntervals(vtkPolyData* input, const double normal[3])
+{
+  if (input == this->CachedInput &&
+      input->GetMTime() == this->CachedInputMTime &&
+      normal[0] == this->CachedNormal[0] &&
+      normal[1] == this->CachedNormal[1] &&
+      normal[2] == this->CachedNormal[2])
+    {
+    return;
+    }
+  this->CachedInput = input;
+  this->CachedInputMTime = input->GetMTime();
+  this->CachedNormal[0] = normal[0];
+  this->CachedNormal[1] = normal[1];
+  this->CachedNormal[2] = normal[2];
+
+  // distance of every point along the normal
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  this->PointDistances.resize(numberOfPoints);
+  double point[3];
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    input->GetPoint(pointId, point);
+    this->PointDistances[pointId] = vtkMath::Dot(normal, point);
+    }
+
+  // distance range of every cell, sorted by lower bound
+  vtkIdType numberOfCells = input->GetNumberOfCells();
+  this->CellIntervals.clear();
+  this->CellIntervals.reserve(numberOfCells);
+  this->MaximumIntervalLength = 0.0;
+  this->MinimumDistance = VTK_DOUBLE_MAX;
+  this->MaximumDistance = VTK_DOUBLE_MIN;
+  // GetCellPoints also builds the cells if needed, ComputeCut can then
+  // access them concurrently
+  vtkIdType numberOfCellPoints = 0;
+  vtkIdType* cellPoints = NULL;
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    input->GetCellPoints(cellId, numberOfCellPoints, cellPoints);
+    if (numberOfCellPoints == 0)
+      {
+      continue;
+      }
+    CellInterval interval;
+    interval.CellId = cellId;
+    interval.Min = this->PointDistances[cellPoints[0]];
+    interval.Max = interval.Min;
+    for (vtkIdType i = 1; i < numberOfCellPoints; ++i)
+      {
+      double distance = this->PointDistances[cellPoints[i]];
+      interval.Min = std::min(interval.Min, distance);
+      interval.Max = std::max(interval.Max, distance);
+      }
+    this->MaximumIntervalLength = std::max(this->MaximumIntervalLength, interval.Max - interval.Min);
+    this->MinimumDistance = std::min(this->MinimumDistance, interval.Min);
+    this->MaximumDistance = std::max(this->MaximumDistance, interval.Max);
+    this->CellIntervals.push_back(interval);
+    }
+  std::sort(this->CellIntervals.begin(), this->CellIntervals.end());
+}
+
+//----------------------------------------------------------------------------
+bool vtkCachedPlaneCutter::IsCutUpToDate(vtkPolyData* input)
+{
+  return input == this->CachedInput &&
+         this->Plane &&
+         input->GetMTime() == this->CutInputMTime &&
+         this->Plane->GetMTime() == this->CutPlaneMTime;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCachedPlaneCutter::PrepareCut(vtkPolyData* input)
+{
+  this->Cut->Initialize();
+  this->NumberOfCutCells = 0;
+  this->FirstCutInterval = 0;
+  this->EndCutInterval = 0;
+  this->CutInputMTime = input->GetMTime();
+  this->CutPlaneMTime = this->Plane->GetMTime();
+
+  if (input->GetNumberOfPoints() == 0 || input->GetNumberOfCells() == 0)
+    {
+    this->CachedInput = input;
+    return false;
+    }
+
+  double normal[3];
+  this->Plane->GetNormal(normal);
+  this->UpdateCellIntervals(input, normal);
+
+  this->CutDistance = vtkMath::Dot(normal, this->Plane->GetOrigin());
+  if (this->CellIntervals.empty() ||
+      this->CutDistance < this->MinimumDistance ||
+      this->CutDistance > this->MaximumDistance)
+    {
+    // the plane misses the input
+    return false;
+    }
+
+  // a cell straddling the plane has a lower bound in
+  // [distance - longest interval, distance]
+  CellInterval bound;
+  bound.Min = this->CutDistance - this->MaximumIntervalLength;
+  this->FirstCutInterval = std::lower_bound(
+    this->CellIntervals.begin(), this->CellIntervals.end(), bound) - this->CellIntervals.begin();
+  bound.Min = this->CutDistance;
+  this->EndCutInterval = std::upper_bound(
+    this->CellIntervals.begin(), this->CellIntervals.end(), bound) - this->CellIntervals.begin();
+
+  // allocate the output now, ComputeCut only fills it
+  vtkIdType estimatedSize = static_cast<vtkIdType>(this->EndCutInterval - this->FirstCutInterval);
+  estimatedSize = std::max(estimatedSize, static_cast<vtkIdType>(1024));
+
+  vtkNew<vtkPoints> points;
+  points->SetDataType(input->GetPoints()->GetDataType());
+  points->Allocate(estimatedSize, estimatedSize / 2);
+  vtkNew<vtkCellArray> verts;
+  vtkNew<vtkCellArray> lines;
+  lines->Allocate(estimatedSize, estimatedSize / 2);
+  vtkNew<vtkCellArray> polys;
+  this->Cut->SetPoints(points.GetPointer());
+  this->Cut->SetVerts(verts.GetPointer());
+  this->Cut->SetLines(lines.GetPointer());
+  this->Cut->SetPolys(polys.GetPointer());
+  this->Cut->GetPointData()->InterpolateAllocate(input->GetPointData(), estimatedSize, estimatedSize / 2);
+  this->Cut->GetCellData()->CopyAllocate(input->GetCellData(), estimatedSize, estimatedSize / 2);
+
+  this->Locator->InitPointInsertion(points.GetPointer(), input->GetBounds(), estimatedSize);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedPlaneCutter::ComputeCut()
+{
+  vtkPolyData* input = this->CachedInput;
+  vtkPointData* inputPointData = input->GetPointData();
+  vtkCellData* inputCellData = input->GetCellData();
+  vtkPointData* outputPointData = this->Cut->GetPointData();
+  vtkCellData* outputCellData = this->Cut->GetCellData();
+  vtkCellArray* verts = this->Cut->GetVerts();
+  vtkCellArray* lines = this->Cut->GetLines();
+  vtkCellArray* polys = this->Cut->GetPolys();
+
+  for (size_t i = this->FirstCutInterval; i < this->EndCutInterval; ++i)
+    {
+    const CellInterval& interval = this->CellIntervals[i];
+    if (interval.Max < this->CutDistance)
+      {
+      continue;
+      }
+    input->GetCell(interval.CellId, this->Cell);
+    vtkIdList* cellPointIds = this->Cell->GetPointIds();
+    vtkIdType numberOfCellPoints = cellPointIds->GetNumberOfIds();
+    this->CellDistances->SetNumberOfTuples(numberOfCellPoints);
+    for (vtkIdType j = 0; j < numberOfCellPoints; ++j)
+      {
+      this->CellDistances->SetValue(
+        j, this->PointDistances[cellPointIds->GetId(j)] - this->CutDistance);
+      }
+    this->Cell->Contour(0.0, this->CellDistances, this->Locator,
+                        verts, lines, polys,
+                        inputPointData, outputPointData,
+                        inputCellData, interval.CellId, outputCellData);
+    ++this->NumberOfCutCells;
+    }
+  this->Locator->Initialize();
+  this->Cut->Squeeze();
+}
+
+//----------------------------------------------------------------------------
+int vtkCachedPlaneCutter::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  vtkPolyData *input = vtkPolyData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPolyData *output = vtkPolyData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!input || !output)
+    {
+    return 0;
+    }
+  if (!this->Plane)
+    {
+    vtkErrorMacro("RequestData: no plane specified");
+    return 0;
+    }
+
+  if (!this->IsCutUpToDate(input))
+    {
+    if (this->PrepareCut(input))
+      {
+      this->ComputeCut();
+      }
+    }
+  output->ShallowCopy(this->Cut);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkCachedPlaneCutter::ComputeCutsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  std::vector<vtkCachedPlaneCutter*>* cutters =
+    static_cast<std::vector<vtkCachedPlaneCutter*>*>(info->UserData);
+  for (size_t i = info->ThreadID; i < cutters->size(); i += info->NumberOfThreads)
+    {
+    (*cutters)[i]->ComputeCut();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkCachedPlaneCutter::UpdateInParallel(const std::vector<vtkCachedPlaneCutter*>& cutters)
+{
+  // Update the inputs and prepare the cuts sequentially, pipeline updates and
+  // VTK object allocations are not thread-safe.
+  std::vector<std::pair<vtkIdType, vtkCachedPlaneCutter*> > cuttersToCompute;
+  for (std::vector<vtkCachedPlaneCutter*>::const_iterator it = cutters.begin();
+       it != cutters.end(); ++it)
+    {
+    vtkCachedPlaneCutter* cutter = *it;
+    if (!cutter || !cutter->Plane || cutter->GetNumberOfInputConnections(0) < 1)
+      {
+      continue;
+      }
+    cutter->GetInputConnection(0, 0)->GetProducer()->Update();
+    vtkPolyData* input = vtkPolyData::SafeDownCast(cutter->GetExecutive()->GetInputData(0, 0));
+    if (!input || cutter->IsCutUpToDate(input))
+      {
+      continue;
+      }
+    if (cutter->PrepareCut(input))
+      {
+      cuttersToCompute.push_back(std::make_pair(
+        static_cast<vtkIdType>(cutter->EndCutInterval - cutter->FirstCutInterval), cutter));
+      }
+    }
+  if (cuttersToCompute.empty())
+    {
+    return;
+    }
+
+  // Spread the largest cuts first among the threads
+  std::sort(cuttersToCompute.begin(), cuttersToCompute.end(), HasMoreCandidateCells);
+  std::vector<vtkCachedPlaneCutter*> sortedCutters;
+  for (size_t i = 0; i < cuttersToCompute.size(); ++i)
+    {
+    sortedCutters.push_back(cuttersToCompute[i].second);
+    }
+  if (sortedCutters.size() == 1)
+    {
+    sortedCutters[0]->ComputeCut();
+    return;
+    }
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(threader->GetNumberOfThreads(),
+                                        static_cast<int>(sortedCutters.size())));
+  threader->SetSingleMethod(vtkCachedPlaneCutter::ComputeCutsThreadFunction, &sortedCutters);
+  threader->SingleMethodExecute();
+}
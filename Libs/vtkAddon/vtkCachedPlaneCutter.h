@@ -0,0 +1,137 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkCachedPlaneCutter - cut polydata with a plane, reusing
+/// per-cell intervals between cuts.
+///
+/// This filter produces the same contour as vtkCutter with a vtkPlane cut
+/// function, but it is meant for a plane that moves along its normal
+/// (e.g. scrolling through slices). For the current input and plane normal,
+/// the range of signed distances of every cell is computed once and the
+/// cells are sorted by their lower bound. Each cut then only contours the
+/// cells whose range straddles the plane, found by a binary search.
+/// Inputs that the plane misses entirely produce an empty output at no cost.
+///
+/// Several cutters can be executed concurrently with UpdateInParallel().
+///
+/// Only point data is interpolated (cut scalars are not generated).
+
+#ifndef __vtkCachedPlaneCutter_h
+#define __vtkCachedPlaneCutter_h
+
+#include "vtkAddon.h"
+
+#include "vtkMultiThreader.h"
+#include "vtkPolyDataAlgorithm.h"
+
+// STD includes
+#include <vector>
+
+class vtkDoubleArray;
+class vtkGenericCell;
+class vtkIncrementalPointLocator;
+class vtkPlane;
+class vtkPolyData;
+
+class VTK_ADDON_EXPORT vtkCachedPlaneCutter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkCachedPlaneCutter *New();
+  vtkTypeMacro(vtkCachedPlaneCutter,vtkPolyDataAlgorithm);
+  virtual void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set/Get the plane used to cut the input.
+  virtual void SetPlane(vtkPlane*);
+  vtkGetObjectMacro(Plane,vtkPlane);
+
+  // Description:
+  // Take the plane modified time into account.
+  virtual unsigned long GetMTime();
+
+  // Description:
+  // Number of cells that were contoured during the last cut.
+  // It is 0 when the plane missed the input bounds.
+  vtkGetMacro(NumberOfCutCells, vtkIdType);
+
+  // Description:
+  // Update the inputs of all the cutters then compute their cuts using
+  // all the available threads, one cutter per thread at a time.
+  // The cuts are reused by the next update of each cutter if neither its
+  // input nor its plane were modified in between.
+  static void UpdateInParallel(const std::vector<vtkCachedPlaneCutter*>& cutters);
+
+protected:
+  vtkCachedPlaneCutter();
+  ~vtkCachedPlaneCutter();
+
+  virtual int RequestData(vtkInformation *, vtkInformationVector **,
+                          vtkInformationVector *);
+
+  // Description:
+  // Rebuild the sorted cell intervals if the input or the plane normal
+  // changed since they were computed.
+  void UpdateCellIntervals(vtkPolyData* input, const double normal[3]);
+
+  // Description:
+  // Build everything needed by ComputeCut so that it does not allocate VTK
+  // objects nor modify the input. Returns false if there is nothing to cut.
+  bool PrepareCut(vtkPolyData* input);
+
+  // Description:
+  // Contour the cells straddling the plane into the Cut polydata.
+  // Safe to run concurrently on different cutters once PrepareCut was called.
+  void ComputeCut();
+
+  // Description:
+  // Return true if Cut holds the result for the current input and plane.
+  bool IsCutUpToDate(vtkPolyData* input);
+
+  // Description:
+  // Thread function of UpdateInParallel.
+  static VTK_THREAD_RETURN_TYPE ComputeCutsThreadFunction(void* arg);
+
+  struct CellInterval
+    {
+    double Min;
+    double Max;
+    vtkIdType CellId;
+    bool operator<(const CellInterval& other) const { return this->Min < other.Min; }
+    };
+
+  vtkPlane* Plane;
+
+  // Intervals cache
+  vtkPolyData* CachedInput;
+  unsigned long CachedInputMTime;
+  double CachedNormal[3];
+  std::vector<double> PointDistances;
+  std::vector<CellInterval> CellIntervals;
+  double MaximumIntervalLength;
+  double MinimumDistance;
+  double MaximumDistance;
+
+  // Cut result cache
+  vtkPolyData* Cut;
+  unsigned long CutInputMTime;
+  unsigned long CutPlaneMTime;
+  double CutDistance;
+  size_t FirstCutInterval;
+  size_t EndCutInterval;
+  vtkIncrementalPointLocator* Locator;
+  vtkGenericCell* Cell;
+  vtkDoubleArray* CellDistances;
+  vtkIdType NumberOfCutCells;
+
+private:
+  vtkCachedPlaneCutter(const vtkCachedPlaneCutter&);  // Not implemented.
+  void operator=(const vtkCachedPlaneCutter&);  // Not implemented.
+};
+
+#endif
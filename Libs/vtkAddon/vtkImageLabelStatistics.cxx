@@ -0,0 +1,495 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkImageLabelStatistics.h"
+
+#include "vtkAlgorithmOutput.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+vtkStandardNewMacro(vtkImageLabelStatistics);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Statistics of a label. The grayscale sums are relative to Shift, the first
+// value accumulated, to limit the loss of precision of the variance.
+struct LabelAccumulator
+{
+  LabelAccumulator()
+  {
+    this->Count = 0;
+    this->NumberOfValues = 0;
+    this->Shift = 0.;
+    this->Min = VTK_DOUBLE_MAX;
+    this->Max = -VTK_DOUBLE_MAX;
+    this->Sum = 0.;
+    this->SumOfSquares = 0.;
+    for (int i = 0; i < 3; ++i)
+      {
+      this->IndexSum[i] = 0.;
+      this->Extent[2 * i] = VTK_INT_MAX;
+      this->Extent[2 * i + 1] = VTK_INT_MIN;
+      }
+  }
+
+  void AddValue(double value)
+  {
+    if (this->NumberOfValues == 0)
+      {
+      this->Shift = value;
+      }
+    ++this->NumberOfValues;
+    this->Min = std::min(this->Min, value);
+    this->Max = std::max(this->Max, value);
+    double shifted = value - this->Shift;
+    this->Sum += shifted;
+    this->SumOfSquares += shifted * shifted;
+  }
+
+  void Merge(const LabelAccumulator& other)
+  {
+    this->Count += other.Count;
+    for (int i = 0; i < 3; ++i)
+      {
+      this->IndexSum[i] += other.IndexSum[i];
+      this->Extent[2 * i] = std::min(this->Extent[2 * i], other.Extent[2 * i]);
+      this->Extent[2 * i + 1] = std::max(this->Extent[2 * i + 1], other.Extent[2 * i + 1]);
+      }
+    if (other.NumberOfValues == 0)
+      {
+      return;
+      }
+    if (this->NumberOfValues == 0)
+      {
+      this->Shift = other.Shift;
+      }
+    // move the sums of other to this shift
+    double delta = other.Shift - this->Shift;
+    this->Sum += other.Sum + other.NumberOfValues * delta;
+    this->SumOfSquares += other.SumOfSquares + 2. * delta * other.Sum
+      + other.NumberOfValues * delta * delta;
+    this->NumberOfValues += other.NumberOfValues;
+    this->Min = std::min(this->Min, other.Min);
+    this->Max = std::max(this->Max, other.Max);
+    this->Values.insert(this->Values.end(), other.Values.begin(), other.Values.end());
+  }
+
+  vtkIdType Count;
+  double IndexSum[3];
+  int Extent[6];
+
+  vtkIdType NumberOfValues;
+  double Shift;
+  double Min;
+  double Max;
+  double Sum;
+  double SumOfSquares;
+  // grayscale values, only kept to compute percentiles
+  std::vector<double> Values;
+};
+
+typedef std::map<int, LabelAccumulator> LabelAccumulatorMap;
+
+//----------------------------------------------------------------------------
+struct AccumulateSlicesInfo
+{
+  vtkImageData* LabelMap;
+  vtkImageData* Grayscale;
+  bool KeepValues;
+  // one map per thread
+  std::vector<LabelAccumulatorMap> ThreadAccumulators;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void CopyRow(const T* grayscale, int numberOfComponents, int length, double* values)
+{
+  for (int i = 0; i < length; ++i, grayscale += numberOfComponents)
+    {
+    values[i] = static_cast<double>(*grayscale);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Accumulate the voxels [i0, i1] of row (j, k). values are the grayscale
+// values of the row or NULL.
+template <class T>
+void AccumulateRow(const T* labels, const double* values, int i0, int i1, int j, int k,
+                   bool keepValues, LabelAccumulatorMap& accumulators)
+{
+  // label maps are made of long runs of the same label
+  LabelAccumulator* accumulator = NULL;
+  int lastLabel = 0;
+  for (int i = i0; i <= i1; ++i, ++labels)
+    {
+    double labelValue = static_cast<double>(*labels);
+    int label = static_cast<int>(labelValue);
+    if (label != labelValue)
+      {
+      continue;
+      }
+    if (accumulator == NULL || label != lastLabel)
+      {
+      accumulator = &accumulators[label];
+      lastLabel = label;
+      }
+    ++accumulator->Count;
+    accumulator->IndexSum[0] += i;
+    accumulator->IndexSum[1] += j;
+    accumulator->IndexSum[2] += k;
+    accumulator->Extent[0] = std::min(accumulator->Extent[0], i);
+    accumulator->Extent[1] = std::max(accumulator->Extent[1], i);
+    accumulator->Extent[2] = std::min(accumulator->Extent[2], j);
+    accumulator->Extent[3] = std::max(accumulator->Extent[3], j);
+    accumulator->Extent[4] = std::min(accumulator->Extent[4], k);
+    accumulator->Extent[5] = std::max(accumulator->Extent[5], k);
+    if (values)
+      {
+      double value = values[i - i0];
+      accumulator->AddValue(value);
+      if (keepValues)
+        {
+        accumulator->Values.push_back(value);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageLabelStatistics::vtkInternal
+{
+public:
+  const LabelAccumulator* Find(int label) const
+  {
+    LabelAccumulatorMap::const_iterator it = this->Statistics.find(label);
+    return (it != this->Statistics.end() ? &it->second : NULL);
+  }
+
+  LabelAccumulatorMap Statistics;
+  std::vector<int> Labels;
+};
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::vtkImageLabelStatistics()
+{
+  this->ComputePercentiles = 0;
+  this->Internal = new vtkInternal;
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::~vtkImageLabelStatistics()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ComputePercentiles: " << this->ComputePercentiles << "\n";
+  os << indent << "NumberOfLabels: " << this->Internal->Labels.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetGrayscaleConnection(vtkAlgorithmOutput* grayscale)
+{
+  this->SetInputConnection(1, grayscale);
+}
+
+//----------------------------------------------------------------------------
+#if (VTK_MAJOR_VERSION <= 5)
+void vtkImageLabelStatistics::SetGrayscale(vtkImageData* grayscale)
+{
+  this->SetInputConnection(1, grayscale ? grayscale->GetProducerPort() : NULL);
+}
+#else
+void vtkImageLabelStatistics::SetGrayscaleData(vtkImageData* grayscale)
+{
+  this->SetInputDataInternal(1, grayscale);
+}
+#endif
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::GetNumberOfLabels()
+{
+  return static_cast<int>(this->Internal->Labels.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::GetLabel(int index)
+{
+  if (index < 0 || index >= this->GetNumberOfLabels())
+    {
+    vtkErrorMacro("GetLabel: invalid label index " << index);
+    return 0;
+    }
+  return this->Internal->Labels[index];
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelStatistics::HasLabel(int label)
+{
+  return this->Internal->Find(label) != NULL;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageLabelStatistics::GetCount(int label)
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  return statistics ? statistics->Count : 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::GetBoundingBox(int label, int extent[6])
+{
+  LabelAccumulator empty;
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  const int* labelExtent = statistics ? statistics->Extent : empty.Extent;
+  std::copy(labelExtent, labelExtent + 6, extent);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::GetCentroid(int label, double ijk[3])
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  for (int i = 0; i < 3; ++i)
+    {
+    ijk[i] = statistics ? statistics->IndexSum[i] / statistics->Count : 0.;
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetMin(int label)
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  return (statistics && statistics->NumberOfValues > 0) ? statistics->Min : 0.;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetMax(int label)
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  return (statistics && statistics->NumberOfValues > 0) ? statistics->Max : 0.;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetMean(int label)
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  if (!statistics || statistics->NumberOfValues == 0)
+    {
+    return 0.;
+    }
+  return statistics->Shift + statistics->Sum / statistics->NumberOfValues;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetStandardDeviation(int label)
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  if (!statistics || statistics->NumberOfValues < 2)
+    {
+    return 0.;
+    }
+  double n = static_cast<double>(statistics->NumberOfValues);
+  double variance = (statistics->SumOfSquares - statistics->Sum * statistics->Sum / n) / (n - 1.);
+  return sqrt(std::max(variance, 0.));
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetPercentile(int label, double percentage)
+{
+  const LabelAccumulator* statistics = this->Internal->Find(label);
+  if (!statistics || statistics->Values.empty())
+    {
+    return 0.;
+    }
+  const std::vector<double>& values = statistics->Values;
+  double position = std::min(std::max(percentage, 0.), 100.) / 100. * (values.size() - 1);
+  size_t below = static_cast<size_t>(floor(position));
+  size_t above = std::min(below + 1, values.size() - 1);
+  double weight = position - below;
+  return (1. - weight) * values[below] + weight * values[above];
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::FillInputPortInformation(int port, vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *vtkNotUsed(outputVector))
+{
+  // All the voxels are needed
+  for (int port = 0; port < 2; ++port)
+    {
+    vtkInformation *inInfo = inputVector[port]->GetInformationObject(0);
+    if (inInfo)
+      {
+      inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+                  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
+      }
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  this->Internal->Statistics.clear();
+  this->Internal->Labels.clear();
+
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *grayscaleInfo = inputVector[1]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  vtkImageData *labelMap = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData *grayscale = grayscaleInfo ? vtkImageData::SafeDownCast(
+    grayscaleInfo->Get(vtkDataObject::DATA_OBJECT())) : NULL;
+  vtkImageData *output = vtkImageData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!labelMap || !output)
+    {
+    return 0;
+    }
+  output->ShallowCopy(labelMap);
+  if (!labelMap->GetPointData()->GetScalars() ||
+      labelMap->GetPointData()->GetScalars()->GetNumberOfComponents() != 1)
+    {
+    vtkErrorMacro("RequestData: the label map must have single component scalars");
+    return 0;
+    }
+  int extent[6];
+  labelMap->GetExtent(extent);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return 1;
+    }
+  if (grayscale)
+    {
+    int grayscaleExtent[6];
+    grayscale->GetExtent(grayscaleExtent);
+    if (!grayscale->GetPointData()->GetScalars() ||
+        !std::equal(extent, extent + 6, grayscaleExtent))
+      {
+      vtkErrorMacro("RequestData: the grayscale image must have the extent of the label map");
+      return 0;
+      }
+    }
+
+  AccumulateSlicesInfo info;
+  info.LabelMap = labelMap;
+  info.Grayscale = grayscale;
+  info.KeepValues = (grayscale != NULL && this->ComputePercentiles);
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(threader->GetNumberOfThreads(), extent[5] - extent[4] + 1));
+  info.ThreadAccumulators.resize(threader->GetNumberOfThreads());
+  threader->SetSingleMethod(vtkImageLabelStatistics::AccumulateSlicesThreadFunction, &info);
+  threader->SingleMethodExecute();
+
+  // Merge the statistics of the threads
+  for (size_t thread = 0; thread < info.ThreadAccumulators.size(); ++thread)
+    {
+    LabelAccumulatorMap& accumulators = info.ThreadAccumulators[thread];
+    for (LabelAccumulatorMap::iterator it = accumulators.begin(); it != accumulators.end(); ++it)
+      {
+      this->Internal->Statistics[it->first].Merge(it->second);
+      }
+    accumulators.clear();
+    }
+  for (LabelAccumulatorMap::iterator it = this->Internal->Statistics.begin();
+       it != this->Internal->Statistics.end(); ++it)
+    {
+    this->Internal->Labels.push_back(it->first);
+    std::sort(it->second.Values.begin(), it->second.Values.end());
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageLabelStatistics::AccumulateSlicesThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  AccumulateSlicesInfo* info = static_cast<AccumulateSlicesInfo*>(threadInfo->UserData);
+  LabelAccumulatorMap& accumulators = info->ThreadAccumulators[threadInfo->ThreadID];
+
+  int extent[6];
+  info->LabelMap->GetExtent(extent);
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  int firstK = extent[4] + numberOfSlices * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  int lastK = extent[4] + numberOfSlices * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads - 1;
+  int rowLength = extent[1] - extent[0] + 1;
+
+  std::vector<double> values;
+  int grayscaleComponents = 0;
+  if (info->Grayscale)
+    {
+    values.resize(rowLength);
+    grayscaleComponents = info->Grayscale->GetNumberOfScalarComponents();
+    }
+  int labelType = info->LabelMap->GetScalarType();
+  int grayscaleType = info->Grayscale ? info->Grayscale->GetScalarType() : VTK_VOID;
+
+  for (int k = firstK; k <= lastK; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      double* rowValues = NULL;
+      if (info->Grayscale)
+        {
+        void* grayscaleRow = info->Grayscale->GetScalarPointer(extent[0], j, k);
+        switch (grayscaleType)
+          {
+          vtkTemplateMacro(CopyRow(static_cast<VTK_TT*>(grayscaleRow), grayscaleComponents,
+                                   rowLength, &values[0]));
+          }
+        rowValues = &values[0];
+        }
+      void* labelRow = info->LabelMap->GetScalarPointer(extent[0], j, k);
+      switch (labelType)
+        {
+        vtkTemplateMacro(AccumulateRow(static_cast<VTK_TT*>(labelRow), rowValues,
+                                       extent[0], extent[1], j, k, info->KeepValues, accumulators));
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
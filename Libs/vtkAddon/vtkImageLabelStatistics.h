@@ -0,0 +1,129 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkImageLabelStatistics - statistics of all the labels of a label map.
+///
+/// The label map is connected to the first input (port 0) and an optional
+/// grayscale image of the same extent to port 1. A single pass over the
+/// voxels computes, for every integer value found in the label map, the
+/// number of voxels, the bounding box and the centroid of the label and,
+/// if a grayscale image is set, the minimum, maximum, mean and standard
+/// deviation of the grayscale values under the label. Percentiles of the
+/// grayscale values can optionally be computed too, at the cost of keeping
+/// a copy of the labeled grayscale values.
+///
+/// Slices are processed concurrently, each thread accumulates into its own
+/// statistics which are merged at the end. Non integer label values are
+/// ignored. The output is the label map, unchanged.
+///
+/// The statistics are accessed by label value:
+/// \code
+/// filter->Update();
+/// for (int index = 0; index < filter->GetNumberOfLabels(); ++index)
+///   {
+///   int label = filter->GetLabel(index);
+///   std::cout << label << ": " << filter->GetCount(label) << " voxels, mean "
+///             << filter->GetMean(label) << std::endl;
+///   }
+/// \endcode
+
+#ifndef __vtkImageLabelStatistics_h
+#define __vtkImageLabelStatistics_h
+
+#include "vtkAddon.h"
+
+#include "vtkImageAlgorithm.h"
+#include "vtkMultiThreader.h"
+#include "vtkVersion.h"
+
+class vtkImageData;
+
+class VTK_ADDON_EXPORT vtkImageLabelStatistics : public vtkImageAlgorithm
+{
+public:
+  static vtkImageLabelStatistics *New();
+  vtkTypeMacro(vtkImageLabelStatistics,vtkImageAlgorithm);
+  virtual void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set the grayscale image whose values are summarized for each label.
+  // It must have the same extent as the label map. Only the first
+  // component is used.
+  void SetGrayscaleConnection(vtkAlgorithmOutput* grayscale);
+#if (VTK_MAJOR_VERSION <= 5)
+  void SetGrayscale(vtkImageData* grayscale);
+#else
+  void SetGrayscaleData(vtkImageData* grayscale);
+#endif
+
+  // Description:
+  // Keep the grayscale values of each label to compute percentiles.
+  // Off by default.
+  vtkSetMacro(ComputePercentiles, int);
+  vtkGetMacro(ComputePercentiles, int);
+  vtkBooleanMacro(ComputePercentiles, int);
+
+  // Description:
+  // Labels found in the label map, in increasing order.
+  int GetNumberOfLabels();
+  int GetLabel(int index);
+  bool HasLabel(int label);
+
+  // Description:
+  // Number of voxels with the label, 0 if the label is not in the label map.
+  vtkIdType GetCount(int label);
+
+  // Description:
+  // Extent of the voxels with the label. The extent is empty (min > max)
+  // if the label is not in the label map.
+  void GetBoundingBox(int label, int extent[6]);
+
+  // Description:
+  // Mean IJK coordinates of the voxels with the label.
+  void GetCentroid(int label, double ijk[3]);
+
+  // Description:
+  // Statistics of the grayscale values under the label, 0 without grayscale
+  // image. The standard deviation is the sample standard deviation.
+  double GetMin(int label);
+  double GetMax(int label);
+  double GetMean(int label);
+  double GetStandardDeviation(int label);
+
+  // Description:
+  // Grayscale value below which the given percentage (0 to 100) of the
+  // values under the label fall, linearly interpolated between values.
+  // Requires ComputePercentiles, returns 0 otherwise.
+  double GetPercentile(int label, double percentage);
+
+protected:
+  vtkImageLabelStatistics();
+  ~vtkImageLabelStatistics();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **,
+                                  vtkInformationVector *);
+  virtual int RequestData(vtkInformation *, vtkInformationVector **,
+                          vtkInformationVector *);
+
+  // Description:
+  // Thread function of RequestData, accumulates a range of slices.
+  static VTK_THREAD_RETURN_TYPE AccumulateSlicesThreadFunction(void* arg);
+
+  int ComputePercentiles;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkImageLabelStatistics(const vtkImageLabelStatistics&);  // Not implemented.
+  void operator=(const vtkImageLabelStatistics&);  // Not implemented.
+};
+
+#endif
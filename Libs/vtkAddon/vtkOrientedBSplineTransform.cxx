@@ -12,8 +12,10 @@
 #include "vtkImageData.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 
+#include <algorithm>
 #include <math.h>
 
 vtkStandardNewMacro(vtkOrientedBSplineTransform);
@@ -85,6 +87,12 @@ vtkOrientedBSplineTransform::vtkOrientedBSplineTransform()
   this->GridIndexToOutputTransformMatrixCached = vtkMatrix4x4::New();
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
   this->InverseBulkTransformMatrixCached = vtkMatrix4x4::New();
+  this->PrecomputeInverse = 0;
+  this->InverseGridSubdivision = 8;
+  this->InverseGridSize[0] = 0;
+  this->InverseGridSize[1] = 0;
+  this->InverseGridSize[2] = 0;
+  this->InverseGridMTime = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -124,6 +132,9 @@ void vtkOrientedBSplineTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GetBulkTransformMatrix()->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "PrecomputeInverse: " << this->PrecomputeInverse << "\n";
+  os << indent << "InverseGridSubdivision: " << this->InverseGridSubdivision << "\n";
+  os << indent << "HasPrecomputedInverse: " << this->HasPrecomputedInverse() << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -238,15 +249,60 @@ void vtkOrientedBSplineTransform::ForwardTransformDerivative(const double inPoin
   outPoint[2] += displacement[2]*scale;
 }
 
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::InverseTransformPoint(const double inPoint[3],
+                                                     double outPoint[3])
+{
+  double derivative[3][3];
+  if (this->InverseGrid.empty())
+    {
+    this->InverseTransformDerivative(inPoint,outPoint,derivative);
+    return;
+    }
+
+  // inPoint and outPoint may be the same vector
+  double point[3] = {inPoint[0], inPoint[1], inPoint[2]};
+  double inverse[3];
+  if (!this->InterpolateInverseGrid(point, inverse))
+    {
+    this->IterativeInverseTransformDerivative(point, NULL, outPoint, derivative, true);
+    return;
+    }
+
+  // Accept the interpolated inverse if it is within tolerance,
+  // refine it with the iterative method otherwise
+  double forward[3];
+  this->ForwardTransformPoint(inverse, forward);
+  if (vtkMath::Distance2BetweenPoints(forward, point) <
+      this->InverseTolerance * this->InverseTolerance)
+    {
+    outPoint[0] = inverse[0];
+    outPoint[1] = inverse[1];
+    outPoint[2] = inverse[2];
+    return;
+    }
+  this->IterativeInverseTransformDerivative(point, inverse, outPoint, derivative, true);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoint[3],
+                                                     double outPoint[3],
+                                                     double derivative[3][3])
+{
+  this->IterativeInverseTransformDerivative(inPoint, NULL, outPoint, derivative, true);
+}
+
 //----------------------------------------------------------------------------
 // We use Newton's method to iteratively invert the transformation.
 // This is actally quite robust as long as the Jacobian matrix is never
 // singular.
 // Note that this is similar to vtkWarpTransform::InverseTransformPoint()
 // but has been optimized specifically for uniform grid transforms.
-void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPointTemp[3],
-                                                     double outPoint[3],
-                                                     double derivative[3][3])
+bool vtkOrientedBSplineTransform::IterativeInverseTransformDerivative(const double inPointTemp[3],
+                                                                      const double* initialInverse,
+                                                                      double outPoint[3],
+                                                                      double derivative[3][3],
+                                                                      bool warnIfNotConverged)
 {
   // inPointTemp and outPoint may be the same vector, so make a copy of the
   // input before modifying the output
@@ -272,7 +328,7 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   if (!this->GridPointer || !this->CalculateSpline)
 #endif
     {
-    return;
+    return true;
     }
 
   void *gridPtr = this->GridPointer;
@@ -294,22 +350,31 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   double f = 1.0;
   double a;
 
-  double inPoint_IJK[3];
-  // Convert the inPoint to i,j,k indices into the deformation grid
-  // plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
-
-  // first guess at inverse_IJK point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->CalculateSpline(inPoint_IJK, deltaP, 0,
-                        gridPtr, extent, increments, this->BorderMode);
+  if (initialInverse)
+    {
+    inverse[0] = initialInverse[0];
+    inverse[1] = initialInverse[1];
+    inverse[2] = initialInverse[2];
+    }
+  else
+    {
+    double inPoint_IJK[3];
+    // Convert the inPoint to i,j,k indices into the deformation grid
+    // plus fractions
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
+
+    // first guess at inverse_IJK point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->CalculateSpline(inPoint_IJK, deltaP, 0,
+                          gridPtr, extent, increments, this->BorderMode);
 
-  double inverseBulkTransformedInPoint[3];
-  vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,inverseBulkTransformedInPoint);
+    double inverseBulkTransformedInPoint[3];
+    vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,inverseBulkTransformedInPoint);
 
-  inverse[0] = inverseBulkTransformedInPoint[0] - deltaP[0]*scale;
-  inverse[1] = inverseBulkTransformedInPoint[1] - deltaP[1]*scale;
-  inverse[2] = inverseBulkTransformedInPoint[2] - deltaP[2]*scale;
+    inverse[0] = inverseBulkTransformedInPoint[0] - deltaP[0]*scale;
+    inverse[1] = inverseBulkTransformedInPoint[1] - deltaP[1]*scale;
+    inverse[2] = inverseBulkTransformedInPoint[2] - deltaP[2]*scale;
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -430,17 +495,21 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
-  if (iteration >= maxNumberOfIterations)
+  bool converged = (iteration < maxNumberOfIterations);
+  if (!converged)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
 
-    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                    ") error = " << sqrt(errorSquared) << " after " <<
-                    iteration << " iterations.");
+    if (warnIfNotConverged)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                      ") error = " << sqrt(errorSquared) << " after " <<
+                      iteration << " iterations.");
+      }
     }
 
   // Convert the inPoint to i,j,k indices into the deformation grid
@@ -448,6 +517,143 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::InterpolateInverseGrid(const double inPoint[3], double outPoint[3])
+{
+  int *extent = this->GridExtent;
+  int *size = this->InverseGridSize;
+
+  double point[3];
+  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+
+  // Find the grid cell that contains the point
+  int cellIndex[3];
+  double fraction[3];
+  int cellSize[3];
+  for (int i = 0; i < 3; i++)
+    {
+    double index = (point[i] - extent[2*i]) * this->InverseGridSubdivision;
+    if (index < 0 || index > size[i]-1)
+      {
+      return false;
+      }
+    cellIndex[i] = std::min(static_cast<int>(floor(index)), std::max(size[i]-2, 0));
+    fraction[i] = index - cellIndex[i];
+    cellSize[i] = (size[i] > 1 ? 2 : 1);
+    }
+
+  // Trilinear interpolation of the inverse displacement
+  double displacement[3] = {0.0, 0.0, 0.0};
+  for (int k = 0; k < cellSize[2]; k++)
+    {
+    double wk = (k ? fraction[2] : 1.0-fraction[2]);
+    for (int j = 0; j < cellSize[1]; j++)
+      {
+      double wj = wk * (j ? fraction[1] : 1.0-fraction[1]);
+      vtkIdType pointId = ((cellIndex[2]+k)*size[1] + cellIndex[1]+j)*size[0] + cellIndex[0];
+      for (int i = 0; i < cellSize[0]; i++, pointId++)
+        {
+        if (!this->InverseGridConverged[pointId])
+          {
+          return false;
+          }
+        double w = wj * (i ? fraction[0] : 1.0-fraction[0]);
+        const double* gridDisplacement = &this->InverseGrid[3*pointId];
+        displacement[0] += w * gridDisplacement[0];
+        displacement[1] += w * gridDisplacement[1];
+        displacement[2] += w * gridDisplacement[2];
+        }
+      }
+    }
+
+  outPoint[0] = inPoint[0] + displacement[0];
+  outPoint[1] = inPoint[1] + displacement[1];
+  outPoint[2] = inPoint[2] + displacement[2];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkOrientedBSplineTransform::UpdateInverseGridThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkOrientedBSplineTransform* self = static_cast<vtkOrientedBSplineTransform*>(info->UserData);
+
+  int *extent = self->GridExtent;
+  int *size = self->InverseGridSize;
+  double spacing = 1.0 / self->InverseGridSubdivision;
+  vtkIdType sliceSize = static_cast<vtkIdType>(size[0]) * size[1];
+  double derivative[3][3];
+  double point_IJK[3];
+  double point[3];
+  double inverse[3];
+  for (int k = info->ThreadID; k < size[2]; k += info->NumberOfThreads)
+    {
+    vtkIdType pointId = k * sliceSize;
+    point_IJK[2] = extent[4] + k * spacing;
+    for (int j = 0; j < size[1]; j++)
+      {
+      point_IJK[1] = extent[2] + j * spacing;
+      for (int i = 0; i < size[0]; i++, pointId++)
+        {
+        point_IJK[0] = extent[0] + i * spacing;
+        vtkLinearTransformPoint(self->GridIndexToOutputTransformMatrixCached->Element, point_IJK, point);
+        self->InverseGridConverged[pointId] =
+          self->IterativeInverseTransformDerivative(point, NULL, inverse, derivative, false);
+        self->InverseGrid[3*pointId] = inverse[0] - point[0];
+        self->InverseGrid[3*pointId+1] = inverse[1] - point[1];
+        self->InverseGrid[3*pointId+2] = inverse[2] - point[2];
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::UpdateInverseGrid()
+{
+#if (VTK_MAJOR_VERSION <= 5)
+  if (!this->PrecomputeInverse || !this->InverseFlag || !this->Coefficients || !this->CalculateSpline)
+#else
+  if (!this->PrecomputeInverse || !this->InverseFlag || !this->GridPointer || !this->CalculateSpline)
+#endif
+    {
+    this->InverseGrid.clear();
+    this->InverseGridConverged.clear();
+    this->InverseGridMTime = 0;
+    return;
+    }
+
+  // An inverse transform that is computed from its forward transform
+  // is deep-copied from it at each update, use the forward transform time
+  unsigned long forwardMTime = (this->DependsOnInverse && this->MyInverse ?
+    this->MyInverse->GetMTime() : this->GetMTime());
+  if (!this->InverseGrid.empty() && this->InverseGridMTime == forwardMTime)
+    {
+    return;
+    }
+
+  // The control point lattice is too coarse for an interpolated inverse to be
+  // within InverseTolerance, therefore the inverse is sampled on a grid that
+  // subdivides each control point cell (similarly to a displacement field)
+  int *extent = this->GridExtent;
+  for (int i = 0; i < 3; i++)
+    {
+    this->InverseGridSize[i] = (extent[2*i+1]-extent[2*i]) * this->InverseGridSubdivision + 1;
+    }
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(this->InverseGridSize[0])
+    * this->InverseGridSize[1] * this->InverseGridSize[2];
+  this->InverseGrid.resize(3*numberOfPoints);
+  this->InverseGridConverged.resize(numberOfPoints);
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(threader->GetNumberOfThreads(), this->InverseGridSize[2]));
+  threader->SetSingleMethod(vtkOrientedBSplineTransform::UpdateInverseGridThreadFunction, this);
+  threader->SingleMethodExecute();
+
+  this->InverseGridMTime = forwardMTime;
 }
 
 //----------------------------------------------------------------------------
@@ -456,6 +662,8 @@ void vtkOrientedBSplineTransform::InternalDeepCopy(vtkAbstractTransform *transfo
   vtkOrientedBSplineTransform *orientedBSplineTransform = (vtkOrientedBSplineTransform *)transform;
   this->SetGridDirectionMatrix(orientedBSplineTransform->GetGridDirectionMatrix());
   this->SetBulkTransformMatrix(orientedBSplineTransform ->GetBulkTransformMatrix());
+  this->SetPrecomputeInverse(orientedBSplineTransform->GetPrecomputeInverse());
+  this->SetInverseGridSubdivision(orientedBSplineTransform->GetInverseGridSubdivision());
 
   // Cached matrices will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
@@ -497,6 +705,8 @@ void vtkOrientedBSplineTransform::InternalUpdate()
     {
     vtkMatrix4x4::Invert(this->BulkTransformMatrix, this->InverseBulkTransformMatrixCached);
     }
+
+  this->UpdateInverseGrid();
 }
 
 //----------------------------------------------------------------------------
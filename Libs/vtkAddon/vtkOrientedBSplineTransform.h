@@ -23,6 +23,14 @@
 /// This choice does not seem reasonable and this bulk transform has been
 /// already removed from the more recent itk::BSplineTransform transform
 /// but we need to support this for backward compatibility.
+///
+/// If PrecomputeInverse is enabled then the inverse transform samples the
+/// inverse displacement once (using all the available threads) on a grid
+/// that subdivides each control point cell InverseGridSubdivision times, and
+/// then computes inverse points by trilinear interpolation of these samples.
+/// The iterative method is still used where the interpolated inverse is not
+/// accurate within InverseTolerance, such as near folds of the deformation
+/// or outside the grid.
 
 #ifndef __vtkOrientedBSplineTransform_h
 #define __vtkOrientedBSplineTransform_h
@@ -30,6 +38,10 @@
 #include "vtkAddon.h"
 
 #include "vtkBSplineTransform.h"
+#include "vtkMultiThreader.h"
+
+// STD includes
+#include <vector>
 
 class VTK_ADDON_EXPORT vtkOrientedBSplineTransform : public vtkBSplineTransform
 {
@@ -63,6 +75,28 @@ public:
   // the GetDisplacementScale method is added to the superclass.
   vtkGetMacro(DisplacementScale,double);
 
+  // Description:
+  // Precompute the inverse displacement on the grid points when
+  // the transform is inverted. The setting is copied to the inverse
+  // transform (returned by GetInverse()). Off by default.
+  vtkSetMacro(PrecomputeInverse,int);
+  vtkGetMacro(PrecomputeInverse,int);
+  vtkBooleanMacro(PrecomputeInverse,int);
+
+  // Description:
+  // Number of inverse grid samples along each axis of a control point cell.
+  // Higher values make more interpolated inverse points accurate within
+  // InverseTolerance but the inverse grid takes longer to compute.
+  // The setting is copied to the inverse transform. Default is 8.
+  vtkSetClampMacro(InverseGridSubdivision,int,1,16);
+  vtkGetMacro(InverseGridSubdivision,int);
+
+  // Description:
+  // Return true if the inverse displacement has been precomputed.
+  // This only happens for inverted transforms with PrecomputeInverse enabled,
+  // after the transform is updated.
+  bool HasPrecomputedInverse() { return !this->InverseGrid.empty(); }
+
 protected:
   vtkOrientedBSplineTransform();
   ~vtkOrientedBSplineTransform();
@@ -84,10 +118,39 @@ protected:
                                   double derivative[3][3]);
   using Superclass::ForwardTransformDerivative; // Inherit the float version from parent
 
+  void InverseTransformPoint(const double in[3], double out[3]);
+  using Superclass::InverseTransformPoint; // Inherit the float version from parent
+
   void InverseTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]);
   using Superclass::InverseTransformDerivative; // Inherit the float version from parent
 
+  // Description:
+  // Invert the transformation at a point using Newton's method, starting
+  // from initialInverse or from the point minus its displacement if
+  // initialInverse is NULL. Returns false if it did not converge.
+  virtual bool IterativeInverseTransformDerivative(const double in[3],
+                                                   const double* initialInverse,
+                                                   double out[3],
+                                                   double derivative[3][3],
+                                                   bool warnIfNotConverged);
+
+  // Description:
+  // Compute the inverse displacement on the subdivided grid if PrecomputeInverse
+  // is enabled and the transform is inverted, clear it otherwise.
+  void UpdateInverseGrid();
+
+  // Description:
+  // Thread function of UpdateInverseGrid, computes a subset of the inverse
+  // grid slices.
+  static VTK_THREAD_RETURN_TYPE UpdateInverseGridThreadFunction(void* arg);
+
+  // Description:
+  // Compute an inverse point by interpolating the precomputed inverse grid.
+  // Returns false if the point is outside the grid or next to a grid point
+  // where the inverse could not be computed.
+  bool InterpolateInverseGrid(const double in[3], double out[3]);
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -100,6 +163,19 @@ protected:
   vtkMatrix4x4* OutputToGridIndexTransformMatrixCached;
   vtkMatrix4x4* InverseBulkTransformMatrixCached;
 
+  int PrecomputeInverse;
+  int InverseGridSubdivision;
+
+  // Description:
+  // Inverse displacement (3 components) and convergence flag at each point of
+  // the inverse grid, which has InverseGridSize points along each axis.
+  // The grid is recomputed when the modification time of the forward
+  // transform is different from InverseGridMTime.
+  std::vector<double> InverseGrid;
+  std::vector<unsigned char> InverseGridConverged;
+  int InverseGridSize[3];
+  unsigned long InverseGridMTime;
+
 private:
   vtkOrientedBSplineTransform(const vtkOrientedBSplineTransform&);  // Not implemented.
   void operator=(const vtkOrientedBSplineTransform&);  // Not implemented.
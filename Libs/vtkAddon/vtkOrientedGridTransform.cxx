@@ -14,6 +14,10 @@
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
 
+// STD includes
+#include <algorithm>
+#include <math.h>
+
 vtkStandardNewMacro(vtkOrientedGridTransform);
 
 vtkCxxSetObjectMacro(vtkOrientedGridTransform,GridDirectionMatrix,vtkMatrix4x4);
@@ -24,6 +28,8 @@ vtkOrientedGridTransform::vtkOrientedGridTransform()
   this->GridDirectionMatrix = NULL;
   this->GridIndexToOutputTransformMatrixCached = vtkMatrix4x4::New();
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
+  this->PrecomputeInverse = 0;
+  this->InverseGridMTime = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -52,6 +58,8 @@ void vtkOrientedGridTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GridDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "PrecomputeInverse: " << this->PrecomputeInverse << "\n";
+  os << indent << "HasPrecomputedInverse: " << this->HasPrecomputedInverse() << "\n";
 }
 
 //------------------------------------------------------------------------
@@ -180,6 +188,41 @@ void vtkOrientedGridTransform::ForwardTransformDerivative(const double inPoint[3
   outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
 }
 
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InverseTransformPoint(const double inPoint[3],
+                                                     double outPoint[3])
+{
+  double derivative[3][3];
+  if (this->InverseGrid.empty())
+    {
+    this->InverseTransformDerivative(inPoint,outPoint,derivative);
+    return;
+    }
+
+  // inPoint and outPoint may be the same vector
+  double point[3] = {inPoint[0], inPoint[1], inPoint[2]};
+  double inverse[3];
+  if (!this->InterpolateInverseGrid(point, inverse))
+    {
+    this->IterativeInverseTransformDerivative(point, NULL, outPoint, derivative, true);
+    return;
+    }
+
+  // Accept the interpolated inverse if it is within tolerance,
+  // refine it with the iterative method otherwise
+  double forward[3];
+  this->ForwardTransformPoint(inverse, forward);
+  if (vtkMath::Distance2BetweenPoints(forward, point) <
+      this->InverseTolerance * this->InverseTolerance)
+    {
+    outPoint[0] = inverse[0];
+    outPoint[1] = inverse[1];
+    outPoint[2] = inverse[2];
+    return;
+    }
+  this->IterativeInverseTransformDerivative(point, inverse, outPoint, derivative, true);
+}
+
 //----------------------------------------------------------------------------
 void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3],
                                                   double outPoint[3],
@@ -195,6 +238,20 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     return;
     }
 
+  this->IterativeInverseTransformDerivative(inPoint, NULL, outPoint, derivative, true);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::IterativeInverseTransformDerivative(const double inPointTemp[3],
+                                                                   const double* initialInverse,
+                                                                   double outPoint[3],
+                                                                   double derivative[3][3],
+                                                                   bool warnIfNotConverged)
+{
+  // inPointTemp and outPoint may be the same vector, so make a copy of the
+  // input before modifying the output
+  double inPoint[3] = {inPointTemp[0],inPointTemp[1],inPointTemp[2]};
+
   void *gridPtr = this->GridPointer;
   int gridType = this->GridScalarType;
 
@@ -221,14 +278,23 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
   // convert the inPoint to i,j,k indices plus fractions
   vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
 
-  // first guess at inverse point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->InterpolationFunction(point, deltaP, NULL,
-                              gridPtr, gridType, extent, increments);
+  if (initialInverse)
+    {
+    inverse[0] = initialInverse[0];
+    inverse[1] = initialInverse[1];
+    inverse[2] = initialInverse[2];
+    }
+  else
+    {
+    // first guess at inverse point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->InterpolationFunction(point, deltaP, NULL,
+                                gridPtr, gridType, extent, increments);
 
-  inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
-  inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
-  inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
+    inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
+    inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -327,23 +393,151 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
 
   vtkDebugMacro("Inverse Iterations: " << (i+1));
 
-  if (i >= n)
+  bool converged = (i < n);
+  if (!converged)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
 
-    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                    ") error = " << sqrt(errorSquared) << " after " <<
-                    i << " iterations.");
+    if (warnIfNotConverged)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                      ") error = " << sqrt(errorSquared) << " after " <<
+                      i << " iterations.");
+      }
     }
 
   // convert point
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InterpolateInverseGrid(const double inPoint[3], double outPoint[3])
+{
+  int *extent = this->GridExtent;
+  int size[3] = {extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
+
+  double point[3];
+  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+
+  // Find the grid cell that contains the point
+  int cellIndex[3];
+  double fraction[3];
+  int cellSize[3];
+  for (int i = 0; i < 3; i++)
+    {
+    double index = point[i] - extent[2*i];
+    if (index < 0 || index > size[i]-1)
+      {
+      return false;
+      }
+    cellIndex[i] = std::min(static_cast<int>(floor(index)), std::max(size[i]-2, 0));
+    fraction[i] = index - cellIndex[i];
+    cellSize[i] = (size[i] > 1 ? 2 : 1);
+    }
+
+  // Trilinear interpolation of the inverse displacement
+  double displacement[3] = {0.0, 0.0, 0.0};
+  for (int k = 0; k < cellSize[2]; k++)
+    {
+    double wk = (k ? fraction[2] : 1.0-fraction[2]);
+    for (int j = 0; j < cellSize[1]; j++)
+      {
+      double wj = wk * (j ? fraction[1] : 1.0-fraction[1]);
+      vtkIdType pointId = ((cellIndex[2]+k)*size[1] + cellIndex[1]+j)*size[0] + cellIndex[0];
+      for (int i = 0; i < cellSize[0]; i++, pointId++)
+        {
+        if (!this->InverseGridConverged[pointId])
+          {
+          return false;
+          }
+        double w = wj * (i ? fraction[0] : 1.0-fraction[0]);
+        const double* gridDisplacement = &this->InverseGrid[3*pointId];
+        displacement[0] += w * gridDisplacement[0];
+        displacement[1] += w * gridDisplacement[1];
+        displacement[2] += w * gridDisplacement[2];
+        }
+      }
+    }
+
+  outPoint[0] = inPoint[0] + displacement[0];
+  outPoint[1] = inPoint[1] + displacement[1];
+  outPoint[2] = inPoint[2] + displacement[2];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkOrientedGridTransform::UpdateInverseGridThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkOrientedGridTransform* self = static_cast<vtkOrientedGridTransform*>(info->UserData);
+
+  int *extent = self->GridExtent;
+  vtkIdType sliceSize = (extent[1]-extent[0]+1) * (extent[3]-extent[2]+1);
+  double derivative[3][3];
+  double point_IJK[3];
+  double point[3];
+  double inverse[3];
+  for (int k = extent[4] + info->ThreadID; k <= extent[5]; k += info->NumberOfThreads)
+    {
+    vtkIdType pointId = (k-extent[4]) * sliceSize;
+    point_IJK[2] = k;
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      point_IJK[1] = j;
+      for (int i = extent[0]; i <= extent[1]; i++, pointId++)
+        {
+        point_IJK[0] = i;
+        vtkLinearTransformPoint(self->GridIndexToOutputTransformMatrixCached->Element, point_IJK, point);
+        self->InverseGridConverged[pointId] =
+          self->IterativeInverseTransformDerivative(point, NULL, inverse, derivative, false);
+        self->InverseGrid[3*pointId] = inverse[0] - point[0];
+        self->InverseGrid[3*pointId+1] = inverse[1] - point[1];
+        self->InverseGrid[3*pointId+2] = inverse[2] - point[2];
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::UpdateInverseGrid()
+{
+  if (!this->PrecomputeInverse || !this->InverseFlag || this->GridPointer == NULL)
+    {
+    this->InverseGrid.clear();
+    this->InverseGridConverged.clear();
+    this->InverseGridMTime = 0;
+    return;
+    }
+
+  // An inverse transform that is computed from its forward transform
+  // is deep-copied from it at each update, use the forward transform time
+  unsigned long forwardMTime = (this->DependsOnInverse && this->MyInverse ?
+    this->MyInverse->GetMTime() : this->GetMTime());
+  if (!this->InverseGrid.empty() && this->InverseGridMTime == forwardMTime)
+    {
+    return;
+    }
+
+  int *extent = this->GridExtent;
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(extent[1]-extent[0]+1)
+    * (extent[3]-extent[2]+1) * (extent[5]-extent[4]+1);
+  this->InverseGrid.resize(3*numberOfPoints);
+  this->InverseGridConverged.resize(numberOfPoints);
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(threader->GetNumberOfThreads(), extent[5]-extent[4]+1));
+  threader->SetSingleMethod(vtkOrientedGridTransform::UpdateInverseGridThreadFunction, this);
+  threader->SingleMethodExecute();
+
+  this->InverseGridMTime = forwardMTime;
 }
 
 //----------------------------------------------------------------------------
@@ -352,6 +546,7 @@ void vtkOrientedGridTransform::InternalDeepCopy(vtkAbstractTransform *transform)
   vtkOrientedGridTransform *gridTransform = (vtkOrientedGridTransform *)transform;
 
   this->SetGridDirectionMatrix(gridTransform->GetGridDirectionMatrix());
+  this->SetPrecomputeInverse(gridTransform->GetPrecomputeInverse());
 
   // Cached matrices will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
@@ -389,6 +584,7 @@ void vtkOrientedGridTransform::InternalUpdate()
   // Compute Output to GridIndex transform
   vtkMatrix4x4::Invert(this->GridIndexToOutputTransformMatrixCached, this->OutputToGridIndexTransformMatrixCached);
 
+  this->UpdateInverseGrid();
 }
 
 //----------------------------------------------------------------------------
@@ -12,6 +12,14 @@
 ///
 /// This transforms extends vtkGridTransform to arbitrary grid orientation.
 ///
+/// Computing the inverse of a displacement field requires an iterative
+/// search for each point. If PrecomputeInverse is enabled then the inverse
+/// transform samples the inverse displacement at each grid point once (using
+/// all the available threads) and then computes inverse points by trilinear
+/// interpolation of these samples. The iterative method is still used where
+/// the interpolated inverse is not accurate within InverseTolerance, such as
+/// near folds of the displacement field or outside the grid.
+///
 
 #ifndef __vtkOrientedGridTransform_h
 #define __vtkOrientedGridTransform_h
@@ -19,6 +27,10 @@
 #include "vtkAddon.h"
 
 #include "vtkGridTransform.h"
+#include "vtkMultiThreader.h"
+
+// STD includes
+#include <vector>
 
 class VTK_ADDON_EXPORT vtkOrientedGridTransform : public vtkGridTransform
 {
@@ -35,6 +47,20 @@ public:
   virtual void SetGridDirectionMatrix(vtkMatrix4x4*);
   vtkGetObjectMacro(GridDirectionMatrix,vtkMatrix4x4);
 
+  // Description:
+  // Precompute the inverse displacement field on the grid points when
+  // the transform is inverted. The setting is copied to the inverse
+  // transform (returned by GetInverse()). Off by default.
+  vtkSetMacro(PrecomputeInverse,int);
+  vtkGetMacro(PrecomputeInverse,int);
+  vtkBooleanMacro(PrecomputeInverse,int);
+
+  // Description:
+  // Return true if the inverse displacement field has been precomputed.
+  // This only happens for inverted transforms with PrecomputeInverse enabled,
+  // after the transform is updated.
+  bool HasPrecomputedInverse() { return !this->InverseGrid.empty(); }
+
   // Description:
   // Make another transform of the same type.
   vtkAbstractTransform *MakeTransform();
@@ -56,6 +82,7 @@ protected:
   // the float versions)
   using vtkGridTransform::ForwardTransformPoint;
   using vtkGridTransform::ForwardTransformDerivative;
+  using vtkGridTransform::InverseTransformPoint;
   using vtkGridTransform::InverseTransformDerivative;
 
   // Description:
@@ -65,9 +92,36 @@ protected:
   void ForwardTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]);
 
+  void InverseTransformPoint(const double in[3], double out[3]);
+
   void InverseTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]);
 
+  // Description:
+  // Invert the transformation at a point using Newton's method, starting
+  // from initialInverse or from the point minus its displacement if
+  // initialInverse is NULL. Returns false if it did not converge.
+  virtual bool IterativeInverseTransformDerivative(const double in[3],
+                                                   const double* initialInverse,
+                                                   double out[3],
+                                                   double derivative[3][3],
+                                                   bool warnIfNotConverged);
+
+  // Description:
+  // Compute the inverse displacement at each grid point if PrecomputeInverse
+  // is enabled and the transform is inverted, clear it otherwise.
+  void UpdateInverseGrid();
+
+  // Description:
+  // Thread function of UpdateInverseGrid, computes a subset of the grid slices.
+  static VTK_THREAD_RETURN_TYPE UpdateInverseGridThreadFunction(void* arg);
+
+  // Description:
+  // Compute an inverse point by interpolating the precomputed inverse grid.
+  // Returns false if the point is outside the grid or next to a grid point
+  // where the inverse could not be computed.
+  bool InterpolateInverseGrid(const double in[3], double out[3]);
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -78,6 +132,16 @@ protected:
   vtkMatrix4x4* GridIndexToOutputTransformMatrixCached;
   vtkMatrix4x4* OutputToGridIndexTransformMatrixCached;
 
+  int PrecomputeInverse;
+
+  // Description:
+  // Inverse displacement (3 components) and convergence flag at each grid point.
+  // The grid is recomputed when the modification time of the forward
+  // transform is different from InverseGridMTime.
+  std::vector<double> InverseGrid;
+  std::vector<unsigned char> InverseGridConverged;
+  unsigned long InverseGridMTime;
+
 private:
   vtkOrientedGridTransform(const vtkOrientedGridTransform&);  // Not implemented.
   void operator=(const vtkOrientedGridTransform&);  // Not implemented.
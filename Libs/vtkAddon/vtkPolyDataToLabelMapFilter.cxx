@@ -0,0 +1,523 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkPolyDataToLabelMapFilter.h"
+
+#include "vtkAlgorithmOutput.h"
+#include "vtkCellArray.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(vtkPolyDataToLabelMapFilter);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Triangle in continuous index coordinates, ordered counter-clockwise when
+// projected on the (j, k) plane.
+struct Triangle
+{
+  double P[3][3];
+  // +1 if the rows enter the surface through the triangle, -1 if they exit
+  int Sign;
+};
+
+//----------------------------------------------------------------------------
+struct Crossing
+{
+  double I;
+  int Sign;
+  bool operator<(const Crossing& other) const { return this->I < other.I; }
+};
+
+//----------------------------------------------------------------------------
+struct PaintSlicesInfo
+{
+  std::vector<Triangle> Triangles;
+  // triangles crossing slice k are SliceTriangles[SliceOffsets[k - Extent[4]]...]
+  std::vector<vtkIdType> SliceOffsets;
+  std::vector<vtkIdType> SliceTriangles;
+  int FillRule;
+  double LabelValue;
+  int Extent[6];
+  void* Scalars;
+  int ScalarType;
+};
+
+//----------------------------------------------------------------------------
+// Signed area of (a, b, q) in the (j, k) plane. It is always computed from
+// the lexicographically smaller vertex of the edge so that the triangles
+// sharing the edge evaluate it exactly the same way (with opposite signs).
+double EdgeFunction(const double* a, const double* b, double j, double k)
+{
+  if (a[1] < b[1] || (a[1] == b[1] && a[2] <= b[2]))
+    {
+    return (b[1] - a[1]) * (k - a[2]) - (b[2] - a[2]) * (j - a[1]);
+    }
+  return -((a[1] - b[1]) * (k - b[2]) - (a[2] - b[2]) * (j - b[1]));
+}
+
+//----------------------------------------------------------------------------
+// Top-left rule: a row passing exactly through the edge a->b of a
+// counter-clockwise triangle belongs to the triangle only for half of the
+// edge directions. The opposite direction is owned by the neighbor triangle.
+bool IsOwnedEdge(const double* a, const double* b)
+{
+  double dk = b[2] - a[2];
+  return dk > 0. || (dk == 0. && b[1] < a[1]);
+}
+
+//----------------------------------------------------------------------------
+bool IsInsideEdge(double w, const double* a, const double* b)
+{
+  return w > 0. || (w == 0. && IsOwnedEdge(a, b));
+}
+
+//----------------------------------------------------------------------------
+// Compute the crossing of the row (j, k) with the triangle.
+// Return false if the row misses the triangle.
+bool IntersectRow(const Triangle& triangle, double j, double k, double& i)
+{
+  const double* a = triangle.P[0];
+  const double* b = triangle.P[1];
+  const double* c = triangle.P[2];
+  double wa = EdgeFunction(b, c, j, k);
+  double wb = EdgeFunction(c, a, j, k);
+  double wc = EdgeFunction(a, b, j, k);
+  if (!IsInsideEdge(wa, b, c) || !IsInsideEdge(wb, c, a) || !IsInsideEdge(wc, a, b))
+    {
+    return false;
+    }
+  double area = wa + wb + wc;
+  if (area <= 0.)
+    {
+    return false;
+    }
+  i = (wa * a[0] + wb * b[0] + wc * c[0]) / area;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void AddTriangle(const double* a, const double* b, const double* c,
+                 std::vector<Triangle>& triangles)
+{
+  double area = EdgeFunction(a, b, c[1], c[2]);
+  if (area == 0.)
+    {
+    // parallel to the rows
+    return;
+    }
+  Triangle triangle;
+  // the normal of a counter-clockwise triangle points along the rows
+  const double* second = (area > 0. ? b : c);
+  const double* third = (area > 0. ? c : b);
+  triangle.Sign = (area > 0. ? -1 : 1);
+  for (int i = 0; i < 3; ++i)
+    {
+    triangle.P[0][i] = a[i];
+    triangle.P[1][i] = second[i];
+    triangle.P[2][i] = third[i];
+    }
+  triangles.push_back(triangle);
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void FillRun(T* scalars, vtkIdType offset, int count, double value)
+{
+  std::fill(scalars + offset, scalars + offset + count, static_cast<T>(value));
+}
+
+//----------------------------------------------------------------------------
+// Set the voxels of the row whose index i is in [start, end)
+void PaintRun(const PaintSlicesInfo* info, vtkIdType rowOffset, double start, double end)
+{
+  int first = std::max(static_cast<int>(ceil(start)), info->Extent[0]);
+  int last = std::min(static_cast<int>(ceil(end)) - 1, info->Extent[1]);
+  if (first > last)
+    {
+    return;
+    }
+  vtkIdType offset = rowOffset + first - info->Extent[0];
+  switch (info->ScalarType)
+    {
+    vtkTemplateMacro(FillRun(static_cast<VTK_TT*>(info->Scalars), offset,
+                             last - first + 1, info->LabelValue));
+    }
+}
+
+//----------------------------------------------------------------------------
+void PaintRow(const PaintSlicesInfo* info, vtkIdType rowOffset, std::vector<Crossing>& crossings)
+{
+  std::sort(crossings.begin(), crossings.end());
+  if (info->FillRule == vtkPolyDataToLabelMapFilter::FILL_PARITY)
+    {
+    for (size_t n = 0; n + 1 < crossings.size(); n += 2)
+      {
+      PaintRun(info, rowOffset, crossings[n].I, crossings[n + 1].I);
+      }
+    return;
+    }
+  int winding = 0;
+  double start = 0.;
+  for (size_t n = 0; n < crossings.size(); ++n)
+    {
+    int previousWinding = winding;
+    winding += crossings[n].Sign;
+    if (previousWinding == 0 && winding != 0)
+      {
+      start = crossings[n].I;
+      }
+    else if (previousWinding != 0 && winding == 0)
+      {
+      PaintRun(info, rowOffset, start, crossings[n].I);
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkPolyDataToLabelMapFilter::vtkPolyDataToLabelMapFilter()
+{
+  this->FillRule = FILL_PARITY;
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkPolyDataToLabelMapFilter::~vtkPolyDataToLabelMapFilter()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataToLabelMapFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "FillRule: "
+     << (this->FillRule == FILL_PARITY ? "Parity" : "NonZero") << "\n";
+  os << indent << "LabelValues:";
+  for (size_t i = 0; i < this->LabelValues.size(); ++i)
+    {
+    os << " " << this->LabelValues[i];
+    }
+  os << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataToLabelMapFilter::AddInputSurfaceConnection(vtkAlgorithmOutput* surface)
+{
+  this->AddInputConnection(1, surface);
+}
+
+//----------------------------------------------------------------------------
+#if (VTK_MAJOR_VERSION <= 5)
+void vtkPolyDataToLabelMapFilter::AddInputSurface(vtkPolyData* surface)
+{
+  if (surface)
+    {
+    this->AddInputConnection(1, surface->GetProducerPort());
+    }
+}
+#else
+void vtkPolyDataToLabelMapFilter::AddInputSurfaceData(vtkPolyData* surface)
+{
+  this->AddInputDataInternal(1, surface);
+}
+#endif
+
+//----------------------------------------------------------------------------
+void vtkPolyDataToLabelMapFilter::RemoveAllInputSurfaces()
+{
+  this->SetInputConnection(1, NULL);
+}
+
+//----------------------------------------------------------------------------
+int vtkPolyDataToLabelMapFilter::GetNumberOfInputSurfaces()
+{
+  return this->GetNumberOfInputConnections(1);
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataToLabelMapFilter::SetLabelValue(int surfaceIndex, double labelValue)
+{
+  if (surfaceIndex < 0)
+    {
+    vtkErrorMacro("SetLabelValue: invalid surface index " << surfaceIndex);
+    return;
+    }
+  if (surfaceIndex >= static_cast<int>(this->LabelValues.size()))
+    {
+    this->LabelValues.resize(surfaceIndex + 1, 1.);
+    }
+  if (this->LabelValues[surfaceIndex] == labelValue)
+    {
+    return;
+    }
+  this->LabelValues[surfaceIndex] = labelValue;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkPolyDataToLabelMapFilter::GetLabelValue(int surfaceIndex)
+{
+  if (surfaceIndex < 0 || surfaceIndex >= static_cast<int>(this->LabelValues.size()))
+    {
+    return 1.;
+    }
+  return this->LabelValues[surfaceIndex];
+}
+
+//----------------------------------------------------------------------------
+int vtkPolyDataToLabelMapFilter::FillInputPortInformation(int port, vtkInformation* info)
+{
+  if (port == 0)
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+    return 1;
+    }
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPolyData");
+  info->Set(vtkAlgorithm::INPUT_IS_REPEATABLE(), 1);
+  info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkPolyDataToLabelMapFilter::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *vtkNotUsed(outputVector))
+{
+  // The whole label map is painted
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+              inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
+
+  // with the whole surfaces
+  for (int i = 0; i < inputVector[1]->GetNumberOfInformationObjects(); ++i)
+    {
+    vtkInformation *surfaceInfo = inputVector[1]->GetInformationObject(i);
+    surfaceInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER(), 0);
+    surfaceInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES(), 1);
+    surfaceInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS(), 0);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkPolyDataToLabelMapFilter::RequestData(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+
+  vtkImageData *input = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData *output = vtkImageData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!input || !output)
+    {
+    return 0;
+    }
+  if (!input->GetPointData()->GetScalars() ||
+      input->GetPointData()->GetScalars()->GetNumberOfComponents() != 1)
+    {
+    vtkErrorMacro("RequestData: the label map must have single component scalars");
+    return 0;
+    }
+
+  output->DeepCopy(input);
+
+  for (int i = 0; i < inputVector[1]->GetNumberOfInformationObjects(); ++i)
+    {
+    vtkPolyData* surface = vtkPolyData::SafeDownCast(
+      inputVector[1]->GetInformationObject(i)->Get(vtkDataObject::DATA_OBJECT()));
+    if (!surface)
+      {
+      continue;
+      }
+    this->PaintSurface(surface, this->GetLabelValue(i), output);
+    this->UpdateProgress(static_cast<double>(i + 1) / inputVector[1]->GetNumberOfInformationObjects());
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkPolyDataToLabelMapFilter::PaintSurface(vtkPolyData* surface, double labelValue,
+                                               vtkImageData* output)
+{
+  vtkPoints* points = surface->GetPoints();
+  if (!points || points->GetNumberOfPoints() == 0)
+    {
+    return;
+    }
+
+  PaintSlicesInfo info;
+  output->GetExtent(info.Extent);
+  info.FillRule = this->FillRule;
+  info.LabelValue = labelValue;
+  info.Scalars = output->GetPointData()->GetScalars()->GetVoidPointer(0);
+  info.ScalarType = output->GetPointData()->GetScalars()->GetDataType();
+
+  // Points in continuous index coordinates
+  double origin[3];
+  double spacing[3];
+  output->GetOrigin(origin);
+  output->GetSpacing(spacing);
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  std::vector<double> indexPoints(3 * numberOfPoints);
+  double point[3];
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    points->GetPoint(pointId, point);
+    for (int i = 0; i < 3; ++i)
+      {
+      indexPoints[3 * pointId + i] = (point[i] - origin[i]) / spacing[i];
+      }
+    }
+
+  // Triangulate polygons (fan) and strips
+  vtkIdType numberOfCellPoints = 0;
+  vtkIdType* cellPoints = NULL;
+  vtkCellArray* polys = surface->GetPolys();
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPoints);)
+    {
+    for (vtkIdType i = 2; i < numberOfCellPoints; ++i)
+      {
+      AddTriangle(&indexPoints[3 * cellPoints[0]], &indexPoints[3 * cellPoints[i - 1]],
+                  &indexPoints[3 * cellPoints[i]], info.Triangles);
+      }
+    }
+  vtkCellArray* strips = surface->GetStrips();
+  for (strips->InitTraversal(); strips->GetNextCell(numberOfCellPoints, cellPoints);)
+    {
+    for (vtkIdType i = 2; i < numberOfCellPoints; ++i)
+      {
+      // every other triangle of a strip is flipped
+      vtkIdType second = (i % 2 == 0 ? i - 1 : i - 2);
+      vtkIdType first = (i % 2 == 0 ? i - 2 : i - 1);
+      AddTriangle(&indexPoints[3 * cellPoints[first]], &indexPoints[3 * cellPoints[second]],
+                  &indexPoints[3 * cellPoints[i]], info.Triangles);
+      }
+    }
+  if (info.Triangles.empty())
+    {
+    return;
+    }
+
+  // Bucket the triangles by the slices they cross
+  int numberOfSlices = info.Extent[5] - info.Extent[4] + 1;
+  std::vector<int> firstSlices(info.Triangles.size());
+  std::vector<int> lastSlices(info.Triangles.size());
+  info.SliceOffsets.assign(numberOfSlices + 1, 0);
+  for (size_t t = 0; t < info.Triangles.size(); ++t)
+    {
+    const Triangle& triangle = info.Triangles[t];
+    double minK = std::min(triangle.P[0][2], std::min(triangle.P[1][2], triangle.P[2][2]));
+    double maxK = std::max(triangle.P[0][2], std::max(triangle.P[1][2], triangle.P[2][2]));
+    firstSlices[t] = std::max(static_cast<int>(ceil(minK)), info.Extent[4]);
+    lastSlices[t] = std::min(static_cast<int>(floor(maxK)), info.Extent[5]);
+    for (int k = firstSlices[t]; k <= lastSlices[t]; ++k)
+      {
+      ++info.SliceOffsets[k - info.Extent[4] + 1];
+      }
+    }
+  for (int k = 0; k < numberOfSlices; ++k)
+    {
+    info.SliceOffsets[k + 1] += info.SliceOffsets[k];
+    }
+  info.SliceTriangles.resize(info.SliceOffsets[numberOfSlices]);
+  std::vector<vtkIdType> sliceEnds(info.SliceOffsets.begin(), info.SliceOffsets.end() - 1);
+  for (size_t t = 0; t < info.Triangles.size(); ++t)
+    {
+    for (int k = firstSlices[t]; k <= lastSlices[t]; ++k)
+      {
+      info.SliceTriangles[sliceEnds[k - info.Extent[4]]++] = static_cast<vtkIdType>(t);
+      }
+    }
+  if (info.SliceTriangles.empty())
+    {
+    return;
+    }
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(threader->GetNumberOfThreads(), numberOfSlices));
+  threader->SetSingleMethod(vtkPolyDataToLabelMapFilter::PaintSlicesThreadFunction, &info);
+  threader->SingleMethodExecute();
+  output->Modified();
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPolyDataToLabelMapFilter::PaintSlicesThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  const PaintSlicesInfo* info = static_cast<const PaintSlicesInfo*>(threadInfo->UserData);
+  const int* extent = info->Extent;
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  int numberOfRows = extent[3] - extent[2] + 1;
+  vtkIdType rowLength = extent[1] - extent[0] + 1;
+
+  std::vector<std::vector<Crossing> > rowCrossings(numberOfRows);
+  for (int slice = threadInfo->ThreadID; slice < numberOfSlices; slice += threadInfo->NumberOfThreads)
+    {
+    vtkIdType begin = info->SliceOffsets[slice];
+    vtkIdType end = info->SliceOffsets[slice + 1];
+    if (begin == end)
+      {
+      continue;
+      }
+    double k = extent[4] + slice;
+    int firstRow = numberOfRows;
+    int lastRow = -1;
+    for (vtkIdType t = begin; t < end; ++t)
+      {
+      const Triangle& triangle = info->Triangles[info->SliceTriangles[t]];
+      double minJ = std::min(triangle.P[0][1], std::min(triangle.P[1][1], triangle.P[2][1]));
+      double maxJ = std::max(triangle.P[0][1], std::max(triangle.P[1][1], triangle.P[2][1]));
+      int firstJ = std::max(static_cast<int>(ceil(minJ)), extent[2]);
+      int lastJ = std::min(static_cast<int>(floor(maxJ)), extent[3]);
+      for (int j = firstJ; j <= lastJ; ++j)
+        {
+        Crossing crossing;
+        if (IntersectRow(triangle, j, k, crossing.I))
+          {
+          crossing.Sign = triangle.Sign;
+          rowCrossings[j - extent[2]].push_back(crossing);
+          firstRow = std::min(firstRow, j - extent[2]);
+          lastRow = std::max(lastRow, j - extent[2]);
+          }
+        }
+      }
+    for (int row = firstRow; row <= lastRow; ++row)
+      {
+      if (rowCrossings[row].empty())
+        {
+        continue;
+        }
+      PaintRow(info, (static_cast<vtkIdType>(slice) * numberOfRows + row) * rowLength, rowCrossings[row]);
+      rowCrossings[row].clear();
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
@@ -0,0 +1,113 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkPolyDataToLabelMapFilter - paint closed surfaces into a label map.
+///
+/// The first input (port 0) is the label map to paint into, its geometry
+/// (extent, origin and spacing) defines the voxel grid. The surfaces are
+/// connected to port 1 (repeatable) and must be expressed in the same
+/// coordinate system as the image. The output is a copy of the label map
+/// where the voxels whose center is inside a surface are set to the label
+/// value of that surface. Surfaces are painted in the order they were added,
+/// later surfaces overwrite earlier ones.
+///
+/// The voxelization is exact: for every row of voxels along the first axis,
+/// the crossings of the row with the triangles of the surface are computed
+/// analytically, sorted and the voxels between crossings are filled using the
+/// parity (even-odd) or the non-zero winding rule. Rows passing through edges
+/// or vertices shared by several triangles are counted once (top-left rule).
+/// Slices are processed concurrently.
+///
+/// Polygons and triangle strips are triangulated on the fly, vertices and
+/// lines are ignored. Surfaces should be closed, open surfaces are filled up
+/// to their boundary along the rows.
+
+#ifndef __vtkPolyDataToLabelMapFilter_h
+#define __vtkPolyDataToLabelMapFilter_h
+
+#include "vtkAddon.h"
+
+#include "vtkImageAlgorithm.h"
+#include "vtkMultiThreader.h"
+#include "vtkVersion.h"
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+class vtkPolyData;
+
+class VTK_ADDON_EXPORT vtkPolyDataToLabelMapFilter : public vtkImageAlgorithm
+{
+public:
+  static vtkPolyDataToLabelMapFilter *New();
+  vtkTypeMacro(vtkPolyDataToLabelMapFilter,vtkImageAlgorithm);
+  virtual void PrintSelf(ostream& os, vtkIndent indent);
+
+  enum FillRules
+    {
+    FILL_PARITY = 0,
+    FILL_NON_ZERO
+    };
+
+  // Description:
+  // Rule used to decide if a voxel is inside a surface: odd number of
+  // crossings (parity, default) or non-zero sum of the oriented crossings
+  // (non-zero winding, self-intersecting or nested consistently oriented
+  // surfaces are filled entirely).
+  vtkSetClampMacro(FillRule, int, FILL_PARITY, FILL_NON_ZERO);
+  vtkGetMacro(FillRule, int);
+  void SetFillRuleToParity() { this->SetFillRule(FILL_PARITY); }
+  void SetFillRuleToNonZero() { this->SetFillRule(FILL_NON_ZERO); }
+
+  // Description:
+  // Add a surface to paint. The surfaces are painted in the order they
+  // were added.
+  void AddInputSurfaceConnection(vtkAlgorithmOutput* surface);
+#if (VTK_MAJOR_VERSION <= 5)
+  void AddInputSurface(vtkPolyData* surface);
+#else
+  void AddInputSurfaceData(vtkPolyData* surface);
+#endif
+  void RemoveAllInputSurfaces();
+  int GetNumberOfInputSurfaces();
+
+  // Description:
+  // Set/Get the value written in the voxels inside the n-th surface.
+  // The default label value is 1.
+  void SetLabelValue(int surfaceIndex, double labelValue);
+  double GetLabelValue(int surfaceIndex);
+
+protected:
+  vtkPolyDataToLabelMapFilter();
+  ~vtkPolyDataToLabelMapFilter();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **,
+                                  vtkInformationVector *);
+  virtual int RequestData(vtkInformation *, vtkInformationVector **,
+                          vtkInformationVector *);
+
+  // Description:
+  // Paint the voxels of output whose center is inside surface.
+  void PaintSurface(vtkPolyData* surface, double labelValue, vtkImageData* output);
+
+  // Description:
+  // Thread function of PaintSurface, fills a subset of the slices.
+  static VTK_THREAD_RETURN_TYPE PaintSlicesThreadFunction(void* arg);
+
+  int FillRule;
+  std::vector<double> LabelValues;
+
+private:
+  vtkPolyDataToLabelMapFilter(const vtkPolyDataToLabelMapFilter&);  // Not implemented.
+  void operator=(const vtkPolyDataToLabelMapFilter&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,423 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkTracer.h"
+
+// VTK includes
+#include <vtkCriticalSection.h>
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// The tracer singleton.
+// This MUST be default initialized to zero by the compiler and is
+// therefore not initialized here.  The ClassInitialize and
+// ClassFinalize methods handle this instance.
+static vtkTracer* vtkTracerInstance;
+
+//----------------------------------------------------------------------------
+// Must NOT be initialized.  Default initialization to zero is necessary.
+unsigned int vtkTracerInitialize::Count;
+
+//----------------------------------------------------------------------------
+// Implementation of vtkTracerInitialize class.
+//----------------------------------------------------------------------------
+vtkTracerInitialize::vtkTracerInitialize()
+{
+  if(++Self::Count == 1)
+    {
+    vtkTracer::classInitialize();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkTracerInitialize::~vtkTracerInitialize()
+{
+  if(--Self::Count == 0)
+    {
+    vtkTracer::classFinalize();
+    }
+}
+
+//----------------------------------------------------------------------------
+class vtkTracer::vtkInternal
+{
+public:
+  struct Event
+    {
+    /// 'X' for zones, 'C' for counters, 'M' for thread names
+    char Phase;
+    int Thread;
+    double Begin;
+    double Duration;
+    std::string Name;
+    std::string Category;
+    std::string Detail;
+    };
+
+  vtkInternal();
+
+  /// Return the index of the current thread in the trace, must be called
+  /// with the lock acquired.
+  int CurrentThread();
+
+  static void WriteString(std::ostream& stream, const std::string& text);
+
+  vtkSimpleCriticalSection Lock;
+  double StartTime;
+  std::vector<Event> Events;
+  std::vector<vtkMultiThreaderIDType> Threads;
+};
+
+//----------------------------------------------------------------------------
+vtkTracer::vtkInternal::vtkInternal()
+{
+  this->StartTime = -1.;
+}
+
+//----------------------------------------------------------------------------
+int vtkTracer::vtkInternal::CurrentThread()
+{
+  vtkMultiThreaderIDType threadId = vtkMultiThreader::GetCurrentThreadID();
+  for (size_t i = 0; i < this->Threads.size(); ++i)
+    {
+    if (vtkMultiThreader::ThreadsEqual(this->Threads[i], threadId))
+      {
+      return static_cast<int>(i);
+      }
+    }
+  this->Threads.push_back(threadId);
+  return static_cast<int>(this->Threads.size() - 1);
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::vtkInternal::WriteString(std::ostream& stream, const std::string& text)
+{
+  stream << '"';
+  for (std::string::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+    switch (*it)
+      {
+      case '"': stream << "\\\""; break;
+      case '\\': stream << "\\\\"; break;
+      case '\n': stream << "\\n"; break;
+      case '\r': stream << "\\r"; break;
+      case '\t': stream << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*it) < 0x20)
+          {
+          char escaped[7];
+          sprintf(escaped, "\\u%04x", static_cast<unsigned int>(*it));
+          stream << escaped;
+          }
+        else
+          {
+          stream << *it;
+          }
+      }
+    }
+  stream << '"';
+}
+
+//----------------------------------------------------------------------------
+// Needed when we don't use the vtkStandardNewMacro.
+vtkInstantiatorNewMacro(vtkTracer);
+
+//----------------------------------------------------------------------------
+// Up the reference count so it behaves like New
+vtkTracer* vtkTracer::New()
+{
+  vtkTracer* ret = vtkTracer::GetInstance();
+  ret->Register(NULL);
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// Return the single instance of the vtkTracer
+vtkTracer* vtkTracer::GetInstance()
+{
+  if(!vtkTracerInstance)
+    {
+    // Try the factory first
+    vtkTracerInstance = (vtkTracer*)vtkObjectFactory::CreateInstance("vtkTracer");
+    // if the factory did not provide one, then create it here
+    if(!vtkTracerInstance)
+      {
+      vtkTracerInstance = new vtkTracer;
+      }
+    }
+  // return the instance
+  return vtkTracerInstance;
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::classInitialize()
+{
+  // Allocate the singleton
+  vtkTracerInstance = vtkTracer::GetInstance();
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::classFinalize()
+{
+  vtkTracerInstance->Delete();
+  vtkTracerInstance = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkTracer::vtkTracer()
+{
+  this->Enabled = false;
+  this->FileName = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkTracer::~vtkTracer()
+{
+  this->SetFileName(0);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Enabled: " << this->Enabled << "\n";
+  os << indent << "FileName: " << (this->FileName ? this->FileName : "(none)") << "\n";
+  os << indent << "NumberOfEvents: " << this->GetNumberOfEvents() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::SetEnabled(bool enabled)
+{
+  if (this->Enabled == enabled)
+    {
+    return;
+    }
+  this->Internal->Lock.Lock();
+  if (enabled && this->Internal->StartTime < 0.)
+    {
+    this->Internal->StartTime = vtkTimerLog::GetUniversalTime();
+    }
+  this->Enabled = enabled;
+  this->Internal->Lock.Unlock();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkTracer::GetTime()
+{
+  if (this->Internal->StartTime < 0.)
+    {
+    return 0.;
+    }
+  return (vtkTimerLog::GetUniversalTime() - this->Internal->StartTime) * 1000000.;
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::AddZone(const char* name, const char* category,
+                        double begin, double end, const char* detail)
+{
+  if (!this->Enabled)
+    {
+    return;
+    }
+  vtkInternal::Event event;
+  event.Phase = 'X';
+  event.Begin = begin;
+  event.Duration = end - begin;
+  event.Name = name ? name : "";
+  event.Category = category ? category : "";
+  event.Detail = detail ? detail : "";
+  this->Internal->Lock.Lock();
+  event.Thread = this->Internal->CurrentThread();
+  this->Internal->Events.push_back(event);
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::AddCounter(const char* name, double value)
+{
+  if (!this->Enabled)
+    {
+    return;
+    }
+  vtkInternal::Event event;
+  event.Phase = 'C';
+  event.Begin = this->GetTime();
+  event.Duration = value;
+  event.Name = name ? name : "";
+  this->Internal->Lock.Lock();
+  event.Thread = this->Internal->CurrentThread();
+  this->Internal->Events.push_back(event);
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::SetThreadName(const char* name)
+{
+  // Thread names are recorded even if the tracer is disabled, threads are
+  // usually named when they start.
+  vtkInternal::Event event;
+  event.Phase = 'M';
+  event.Begin = 0.;
+  event.Duration = 0.;
+  event.Name = name ? name : "";
+  this->Internal->Lock.Lock();
+  event.Thread = this->Internal->CurrentThread();
+  // Replace the previous name of the thread
+  for (std::vector<vtkInternal::Event>::iterator it = this->Internal->Events.begin();
+       it != this->Internal->Events.end(); ++it)
+    {
+    if (it->Phase == 'M' && it->Thread == event.Thread)
+      {
+      this->Internal->Events.erase(it);
+      break;
+      }
+    }
+  this->Internal->Events.push_back(event);
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+int vtkTracer::GetNumberOfEvents()
+{
+  this->Internal->Lock.Lock();
+  int numberOfEvents = static_cast<int>(this->Internal->Events.size());
+  this->Internal->Lock.Unlock();
+  return numberOfEvents;
+}
+
+//----------------------------------------------------------------------------
+void vtkTracer::ClearEvents()
+{
+  this->Internal->Lock.Lock();
+  // Thread names are kept
+  std::vector<vtkInternal::Event> threadNames;
+  for (std::vector<vtkInternal::Event>::iterator it = this->Internal->Events.begin();
+       it != this->Internal->Events.end(); ++it)
+    {
+    if (it->Phase == 'M')
+      {
+      threadNames.push_back(*it);
+      }
+    }
+  this->Internal->Events.swap(threadNames);
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+bool vtkTracer::WriteTrace()
+{
+  if (!this->FileName)
+    {
+    vtkErrorMacro("WriteTrace: no file name");
+    return false;
+    }
+  return this->WriteTrace(this->FileName);
+}
+
+//----------------------------------------------------------------------------
+bool vtkTracer::WriteTrace(const char* fileName)
+{
+  std::ofstream output(fileName, std::ios::out | std::ios::trunc);
+  if (!output.is_open())
+    {
+    vtkErrorMacro("WriteTrace: failed to open " << (fileName ? fileName : "(null)"));
+    return false;
+    }
+  // Copy the events to not block the threads recording events while writing
+  this->Internal->Lock.Lock();
+  std::vector<vtkInternal::Event> events = this->Internal->Events;
+  this->Internal->Lock.Unlock();
+
+  output.setf(std::ios::fixed);
+  output.precision(3);
+  output << "{\"traceEvents\":[";
+  for (std::vector<vtkInternal::Event>::const_iterator it = events.begin();
+       it != events.end(); ++it)
+    {
+    output << (it == events.begin() ? "\n" : ",\n");
+    output << "{\"ph\":\"" << it->Phase << "\",\"pid\":1,\"tid\":" << it->Thread << ",";
+    switch (it->Phase)
+      {
+      case 'X':
+        output << "\"name\":";
+        vtkInternal::WriteString(output, it->Name);
+        output << ",\"cat\":";
+        vtkInternal::WriteString(output, it->Category);
+        output << ",\"ts\":" << it->Begin << ",\"dur\":" << it->Duration;
+        if (!it->Detail.empty())
+          {
+          output << ",\"args\":{\"detail\":";
+          vtkInternal::WriteString(output, it->Detail);
+          output << "}";
+          }
+        break;
+      case 'C':
+        output << "\"name\":";
+        vtkInternal::WriteString(output, it->Name);
+        output << ",\"ts\":" << it->Begin << ",\"args\":{\"value\":" << it->Duration << "}";
+        break;
+      case 'M':
+        output << "\"name\":\"thread_name\",\"args\":{\"name\":";
+        vtkInternal::WriteString(output, it->Name);
+        output << "}";
+        break;
+      }
+    output << "}";
+    }
+  output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  output.close();
+  return !output.fail();
+}
+
+//----------------------------------------------------------------------------
+// vtkTraceZone methods
+
+//----------------------------------------------------------------------------
+vtkTraceZone::vtkTraceZone(const char* name, const char* category, const char* detail)
+{
+  vtkTracer* tracer = vtkTracer::GetInstance();
+  this->Active = tracer->GetEnabled();
+  this->Begin = 0.;
+  if (!this->Active)
+    {
+    return;
+    }
+  this->Name = name ? name : "";
+  this->Category = category ? category : "";
+  this->Detail = detail ? detail : "";
+  this->Begin = tracer->GetTime();
+}
+
+//----------------------------------------------------------------------------
+vtkTraceZone::~vtkTraceZone()
+{
+  if (!this->Active)
+    {
+    return;
+    }
+  vtkTracer* tracer = vtkTracer::GetInstance();
+  tracer->AddZone(this->Name.c_str(), this->Category.c_str(),
+                  this->Begin, tracer->GetTime(), this->Detail.c_str());
+}
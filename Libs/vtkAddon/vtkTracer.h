@@ -0,0 +1,187 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkTracer_h
+#define __vtkTracer_h
+
+#include "vtkAddon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+
+/// \brief Record the time spent in zones of code into a Chrome trace.
+///
+/// The tracer is a singleton that collects, from any thread:
+/// - zones: the name and duration of a section of code, usually recorded
+///   with vtkTraceZoneMacro() for the lifetime of a scope,
+/// - counters: values changing over time (e.g. number of nodes),
+/// - thread names.
+///
+/// Nothing is recorded until the tracer is enabled, zones and counters then
+/// only cost a test. Recorded events are kept in memory and written by
+/// WriteTrace() in the Chrome trace event format, which can be opened by
+/// chrome://tracing or https://ui.perfetto.dev.
+///
+/// Example:
+/// \code
+/// vtkTracer::GetInstance()->SetFileName("/tmp/trace.json");
+/// vtkTracer::GetInstance()->EnabledOn();
+/// {
+/// vtkTraceZoneMacro("Import", "MRML");
+/// scene->Import();
+/// }
+/// vtkTraceCounterMacro("Nodes", scene->GetNumberOfNodes());
+/// vtkTracer::GetInstance()->WriteTrace();
+/// \endcode
+class VTK_ADDON_EXPORT vtkTracer : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkTracer, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Return the singleton instance with no reference counting.
+  static vtkTracer* GetInstance();
+
+  /// This is a singleton pattern New. There will only be ONE
+  /// reference to a vtkTracer object per process. Clients that
+  /// call this must call Delete on the object so that the reference
+  /// counting will work. The single instance will be unreferenced when
+  /// the program exits.
+  static vtkTracer* New();
+
+  /// Enable/disable the recording of the events.
+  /// Enabling the tracer starts its clock if no event was recorded yet.
+  /// Disabled by default.
+  void SetEnabled(bool enabled);
+  bool GetEnabled()const { return this->Enabled; }
+  void EnabledOn() { this->SetEnabled(true); }
+  void EnabledOff() { this->SetEnabled(false); }
+
+  /// File written by WriteTrace().
+  vtkSetStringMacro(FileName);
+  vtkGetStringMacro(FileName);
+
+  /// Time in microseconds since the first event could be recorded.
+  double GetTime();
+
+  /// Record a zone that started at \a begin and ended at \a end (as returned
+  /// by GetTime()) in the current thread.
+  /// \a detail is an optional text shown with the zone (e.g. a file name).
+  void AddZone(const char* name, const char* category,
+               double begin, double end, const char* detail = 0);
+
+  /// Record the value of the counter \a name at the current time.
+  void AddCounter(const char* name, double value);
+
+  /// Name the current thread in the trace.
+  void SetThreadName(const char* name);
+
+  /// Number of events recorded since the last ClearEvents().
+  int GetNumberOfEvents();
+
+  /// Discard the recorded events.
+  void ClearEvents();
+
+  /// Write the recorded events into \a fileName in the Chrome trace event
+  /// (JSON) format. The events are kept, the file is rewritten each time.
+  /// Returns false if the file could not be written.
+  bool WriteTrace(const char* fileName);
+  /// Write the recorded events into FileName.
+  bool WriteTrace();
+
+protected:
+  vtkTracer();
+  virtual ~vtkTracer();
+
+  /// Singleton management functions.
+  static void classInitialize();
+  static void classFinalize();
+
+  friend class vtkTracerInitialize;
+  typedef vtkTracer Self;
+
+  bool Enabled;
+  char* FileName;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkTracer(const vtkTracer&);  // Not implemented.
+  void operator=(const vtkTracer&);  // Not implemented.
+};
+
+/// Utility class to make sure the singleton is created before it is used
+/// and destroyed when the program exits.
+class VTK_ADDON_EXPORT vtkTracerInitialize
+{
+public:
+  typedef vtkTracerInitialize Self;
+
+  vtkTracerInitialize();
+  ~vtkTracerInitialize();
+private:
+  static unsigned int Count;
+};
+
+/// This instance will show up in any translation unit that uses
+/// vtkTracer.  It will make sure vtkTracer is initialized
+/// before it is used.
+static vtkTracerInitialize vtkTracerInitializer;
+
+//----------------------------------------------------------------------------
+/// \brief Record the lifetime of the object as a zone of the trace.
+///
+/// The zone is recorded only if the tracer is enabled when the object is
+/// created.
+/// \sa vtkTraceZoneMacro
+class VTK_ADDON_EXPORT vtkTraceZone
+{
+public:
+  vtkTraceZone(const char* name, const char* category, const char* detail = 0);
+  ~vtkTraceZone();
+private:
+  bool Active;
+  double Begin;
+  std::string Name;
+  std::string Category;
+  std::string Detail;
+};
+
+/// Record the time spent until the end of the current scope.
+#define vtkTraceZoneMacro(name, category) \
+  vtkTraceZone vtkTraceZoneInstance(name, category)
+
+/// Record the time spent until the end of the current scope with a detail
+/// (e.g. the file name being read).
+#define vtkTraceZoneWithDetailMacro(name, category, detail) \
+  vtkTraceZone vtkTraceZoneInstance(name, category, detail)
+
+/// Record the value of a counter if the tracer is enabled.
+#define vtkTraceCounterMacro(name, value)               \
+  do                                                    \
+    {                                                   \
+    vtkTracer* vtkTracerInstance = vtkTracer::GetInstance(); \
+    if (vtkTracerInstance->GetEnabled())                \
+      {                                                 \
+      vtkTracerInstance->AddCounter(name, value);       \
+      }                                                 \
+    }                                                   \
+  while (0)
+
+#endif
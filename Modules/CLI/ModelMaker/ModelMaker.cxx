@@ -30,6 +30,7 @@ Version:   $Revision$
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkDebugLeaks.h>
 #include <vtkDecimatePro.h>
 #include <vtkDiscreteMarchingCubes.h>
@@ -42,8 +43,14 @@ Version:   $Revision$
 #include <vtkImageToStructuredPoints.h>
 #include <vtkInformation.h>
 #include <vtkLookupTable.h>
+#include <vtkMarchingCubes.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkReverseSense.h>
@@ -52,6 +59,7 @@ Version:   $Revision$
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkStripper.h>
 #include <vtkThreshold.h>
+#include <vtkTimerLog.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkUnstructuredGrid.h>
@@ -61,6 +69,289 @@ Version:   $Revision$
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// A label processed by the parallel pipeline. The extent is the bounding box
+// of the label in the marching cubes input, grown by one voxel so that all
+// the cubes crossing the label boundary are kept.
+struct LabelModel
+{
+  int Label;
+  int Extent[6];
+  vtkSmartPointer<vtkPolyData> Model;
+};
+
+//----------------------------------------------------------------------------
+// State shared by the threads of the parallel pipeline. Only the label
+// counters are modified by the threads and they are protected by Lock.
+struct LabelModelGenerator
+{
+  vtkImageData*           Image;
+  std::vector<LabelModel> LabelModels;
+  double                  IJKToRAS[16];
+  double                  Decimate;
+  bool                    SincSmoothing;
+  int                     Smooth;
+  bool                    SplitNormals;
+  bool                    PointNormals;
+
+  ::size_t                NextLabelModel;
+  ::size_t                NumberOfGeneratedModels;
+  vtkSimpleMutexLock      Lock;
+};
+
+//----------------------------------------------------------------------------
+// Grow the extents of the labels to include all the voxels with that value.
+template <class T>
+void ComputeLabelExtents(T* scalars, const int extent[6],
+                         const std::vector<int>& labelIndices, int minLabel,
+                         std::vector<LabelModel>& labelModels)
+{
+  T* voxel = scalars;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, ++voxel)
+        {
+        double value = static_cast<double>(*voxel);
+        int label = static_cast<int>(value);
+        if (label != value || label < minLabel ||
+            label >= minLabel + static_cast<int>(labelIndices.size()) ||
+            labelIndices[label - minLabel] < 0)
+          {
+          continue;
+          }
+        int* labelExtent = labelModels[labelIndices[label - minLabel]].Extent;
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[4] = std::min(labelExtent[4], k);
+        labelExtent[5] = std::max(labelExtent[5], k);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute the bounding boxes of all the labels in a single pass over the
+// image, then grow them by one voxel within the image extent.
+void ComputeLabelExtents(vtkImageData* image, std::vector<LabelModel>& labelModels)
+{
+  if (labelModels.empty())
+    {
+    return;
+    }
+  int minLabel = labelModels[0].Label;
+  int maxLabel = labelModels[0].Label;
+  for (::size_t l = 0; l < labelModels.size(); ++l)
+    {
+    minLabel = std::min(minLabel, labelModels[l].Label);
+    maxLabel = std::max(maxLabel, labelModels[l].Label);
+    }
+  std::vector<int> labelIndices(maxLabel - minLabel + 1, -1);
+  for (::size_t l = 0; l < labelModels.size(); ++l)
+    {
+    labelIndices[labelModels[l].Label - minLabel] = static_cast<int>(l);
+    int* labelExtent = labelModels[l].Extent;
+    labelExtent[0] = labelExtent[2] = labelExtent[4] = VTK_INT_MAX;
+    labelExtent[1] = labelExtent[3] = labelExtent[5] = VTK_INT_MIN;
+    }
+
+  int extent[6];
+  image->GetExtent(extent);
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(ComputeLabelExtents(static_cast<VTK_TT*>(image->GetScalarPointer()),
+                                         extent, labelIndices, minLabel, labelModels));
+    default:
+      std::cerr << "ERROR: unsupported label map scalar type " << image->GetScalarType() << std::endl;
+      return;
+    }
+
+  for (::size_t l = 0; l < labelModels.size(); ++l)
+    {
+    int* labelExtent = labelModels[l].Extent;
+    if (labelExtent[0] > labelExtent[1])
+      {
+      continue;
+      }
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      labelExtent[2 * axis] = std::max(labelExtent[2 * axis] - 1, extent[2 * axis]);
+      labelExtent[2 * axis + 1] = std::min(labelExtent[2 * axis + 1] + 1, extent[2 * axis + 1]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void ThresholdLabel(vtkImageData* image, T*, int label, const int extent[6],
+                    unsigned char inValue, unsigned char* output)
+{
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      T* voxel = static_cast<T*>(image->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; ++i, ++voxel, ++output)
+        {
+        *output = (static_cast<double>(*voxel) == label ? inValue : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Equivalent of the image threshold used by the sequential pipeline,
+// restricted to the extent of the label. The output keeps the extent and
+// origin of the input so that the marching cubes points are unchanged.
+vtkSmartPointer<vtkImageData> ThresholdLabel(vtkImageData* image, const LabelModel& labelModel)
+{
+  vtkSmartPointer<vtkImageData> labelImage = vtkSmartPointer<vtkImageData>::New();
+  labelImage->SetExtent(const_cast<int*>(labelModel.Extent));
+  labelImage->SetOrigin(image->GetOrigin());
+  labelImage->SetSpacing(image->GetSpacing());
+#if (VTK_MAJOR_VERSION <= 5)
+  labelImage->SetScalarTypeToUnsignedChar();
+  labelImage->SetNumberOfScalarComponents(1);
+  labelImage->AllocateScalars();
+#else
+  labelImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+#endif
+  // vtkImageThreshold clamps the in value to the range of the input type
+  unsigned char inValue = static_cast<unsigned char>(std::min(200., image->GetScalarTypeMax()));
+  unsigned char* output = static_cast<unsigned char*>(labelImage->GetScalarPointer());
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(ThresholdLabel(image, static_cast<VTK_TT*>(0), labelModel.Label,
+                                    labelModel.Extent, inValue, output));
+    }
+  return labelImage;
+}
+
+//----------------------------------------------------------------------------
+// Run the per label pipeline of the sequential mode, without the progress
+// watchers that are not thread safe.
+void GenerateLabelModel(LabelModelGenerator* generator, LabelModel& labelModel)
+{
+  if (labelModel.Extent[0] > labelModel.Extent[1])
+    {
+    return;
+    }
+  vtkSmartPointer<vtkImageData> labelImage = ThresholdLabel(generator->Image, labelModel);
+
+  vtkNew<vtkMarchingCubes> mcubes;
+#if (VTK_MAJOR_VERSION <= 5)
+  mcubes->SetInput(labelImage);
+#else
+  mcubes->SetInputData(labelImage);
+#endif
+  mcubes->SetValue(0, 100.5);
+  mcubes->ComputeScalarsOff();
+  mcubes->ComputeGradientsOff();
+  mcubes->ComputeNormalsOff();
+  mcubes->Update();
+  if (mcubes->GetOutput()->GetNumberOfPolys() == 0)
+    {
+    return;
+    }
+
+  vtkNew<vtkDecimatePro> decimator;
+  decimator->SetInputConnection(mcubes->GetOutputPort());
+  decimator->SetFeatureAngle(60);
+  decimator->SplittingOff();
+  decimator->PreserveTopologyOn();
+  decimator->SetMaximumError(1);
+  decimator->SetTargetReduction(generator->Decimate);
+
+  vtkNew<vtkTransform> transformIJKtoRAS;
+  transformIJKtoRAS->SetMatrix(generator->IJKToRAS);
+
+  vtkAlgorithmOutput* smootherInput = decimator->GetOutputPort();
+  vtkNew<vtkReverseSense> reverser;
+  if (transformIJKtoRAS->GetMatrix()->Determinant() < 0)
+    {
+    reverser->SetInputConnection(decimator->GetOutputPort());
+    reverser->ReverseNormalsOn();
+    smootherInput = reverser->GetOutputPort();
+    }
+
+  vtkSmartPointer<vtkPolyDataAlgorithm> smoother;
+  if (generator->SincSmoothing)
+    {
+    vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc =
+      vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+    smootherSinc->SetPassBand(0.1);
+    smootherSinc->SetNumberOfIterations(generator->Smooth);
+    smootherSinc->FeatureEdgeSmoothingOff();
+    smootherSinc->BoundarySmoothingOff();
+    smoother = smootherSinc;
+    }
+  else
+    {
+    vtkSmartPointer<vtkSmoothPolyDataFilter> smootherPoly =
+      vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
+    smootherPoly->SetRelaxationFactor(0.33);
+    smootherPoly->SetFeatureAngle(60);
+    smootherPoly->SetConvergence(0);
+    smootherPoly->SetNumberOfIterations(generator->Smooth);
+    smootherPoly->FeatureEdgeSmoothingOff();
+    smootherPoly->BoundarySmoothingOff();
+    smoother = smootherPoly;
+    }
+  smoother->SetInputConnection(smootherInput);
+
+  vtkNew<vtkTransformPolyDataFilter> transformer;
+  transformer->SetInputConnection(smoother->GetOutputPort());
+  transformer->SetTransform(transformIJKtoRAS.GetPointer());
+
+  vtkNew<vtkPolyDataNormals> normals;
+  normals->SetComputePointNormals(generator->PointNormals);
+  normals->SetInputConnection(transformer->GetOutputPort());
+  normals->SetFeatureAngle(60);
+  normals->SetSplitting(generator->SplitNormals);
+
+  vtkNew<vtkStripper> stripper;
+  stripper->SetInputConnection(normals->GetOutputPort());
+  stripper->Update();
+
+  labelModel.Model = vtkSmartPointer<vtkPolyData>::New();
+  labelModel.Model->ShallowCopy(stripper->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE GenerateLabelModelsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LabelModelGenerator* generator = static_cast<LabelModelGenerator*>(info->UserData);
+  while (true)
+    {
+    generator->Lock.Lock();
+    ::size_t index = generator->NextLabelModel++;
+    generator->Lock.Unlock();
+    if (index >= generator->LabelModels.size())
+      {
+      break;
+      }
+    GenerateLabelModel(generator, generator->LabelModels[index]);
+    generator->Lock.Lock();
+    ++generator->NumberOfGeneratedModels;
+    generator->Lock.Unlock();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
 int main(int argc, char * argv[])
 {
   PARSE_ARGS;
@@ -379,6 +670,9 @@ int main(int argc, char * argv[])
     numSingletonFilterSteps = 1;
     numRepeatedFilterSteps = 9;
     }
+  // labels are generated in parallel only when they are smoothed
+  // independently and no intermediate model is saved
+  bool useParallelPipeline = Parallel && makeMultiple && !JointSmoothing && !SaveIntermediateModels;
   numFilterSteps = numSingletonFilterSteps + (numRepeatedFilterSteps * numModelsToGenerate);
   if (SaveIntermediateModels)
     {
@@ -726,14 +1020,18 @@ int main(int argc, char * argv[])
         }
       cubes->GenerateValues((labelsMax - labelsMin + 1), labelsMin, labelsMax);
       }
-    try
-      {
-      cubes->Update();
-      }
-    catch(...)
+    // the parallel pipeline runs marching cubes on each label separately
+    if (!useParallelPipeline)
       {
-      std::cerr << "ERROR while updating marching cubes filter." << std::endl;
-      return EXIT_FAILURE;
+      try
+        {
+        cubes->Update();
+        }
+      catch(...)
+        {
+        std::cerr << "ERROR while updating marching cubes filter." << std::endl;
+        return EXIT_FAILURE;
+        }
       }
     if (JointSmoothing)
       {
@@ -917,6 +1215,122 @@ int main(int argc, char * argv[])
       loopLabels.push_back(Labels[i]);
       }
     }
+
+  // In parallel mode, generate the models of all the labels first, the loop
+  // below then only writes them out.
+  std::map<int, vtkSmartPointer<vtkPolyData> > generatedModels;
+  if (useParallelPipeline)
+    {
+    LabelModelGenerator generator;
+    if (Pad)
+      {
+#if (VTK_MAJOR_VERSION <= 5)
+      padder->GetOutput()->Update();
+#else
+      padder->Update();
+#endif
+      generator.Image = padder->GetOutput();
+      }
+    else
+      {
+      generator.Image = image;
+      }
+    // same criteria as the loop below, to not generate models for the labels
+    // that are skipped
+    for(::size_t l = 0; l < loopLabels.size(); l++)
+      {
+      int label = loopLabels[l];
+      if ((((hist->GetOutput())->GetPointData())->GetScalars())->GetTuple1(label) == 0.0)
+        {
+        continue;
+        }
+      if (SkipUnNamed)
+        {
+        if (colorNode == NULL)
+          {
+          continue;
+          }
+        std::string colorName = std::string(colorNode->GetColorNameAsFileName(label));
+        if (colorName.compare("invalid") == 0 || colorName.compare("(none)") == 0)
+          {
+          continue;
+          }
+        }
+      LabelModel labelModel;
+      labelModel.Label = label;
+      generator.LabelModels.push_back(labelModel);
+      }
+    vtkMatrix4x4::DeepCopy(generator.IJKToRAS, transformIJKtoRAS->GetMatrix());
+    generator.Decimate = Decimate;
+    generator.SincSmoothing = (strcmp(FilterType.c_str(), "Sinc") == 0);
+    if (generator.SincSmoothing && Smooth == 1)
+      {
+      std::cerr << "Warning: Smoothing iterations of 1 not allowed for Sinc filter, using 2" << endl;
+      Smooth = 2;
+      }
+    generator.Smooth = Smooth;
+    generator.SplitNormals = SplitNormals;
+    generator.PointNormals = PointNormals;
+    generator.NextLabelModel = 0;
+    generator.NumberOfGeneratedModels = 0;
+
+    vtkNew<vtkTimerLog> timer;
+    timer->StartTimer();
+    ComputeLabelExtents(generator.Image, generator.LabelModels);
+
+    // The threads can't use filter watchers, their progress is reported
+    // through a placeholder algorithm. It accounts for all the steps but
+    // writing the models.
+    vtkNew<vtkPolyDataAlgorithm> generatorProgress;
+    std::stringstream stream;
+    stream << "Generate " << generator.LabelModels.size() << " models in parallel";
+    std::string            commentParallel = stream.str();
+    vtkPluginFilterWatcher watchGenerator(generatorProgress.GetPointer(),
+                                          commentParallel.c_str(),
+                                          CLPProcessInformation,
+                                          (numRepeatedFilterSteps - 1) * numModelsToGenerate / numFilterSteps,
+                                          currentFilterOffset / numFilterSteps);
+    currentFilterOffset += (numRepeatedFilterSteps - 1) * numModelsToGenerate;
+    if (debug)
+      {
+      watchGenerator.QuietOn();
+      }
+    generatorProgress->InvokeEvent(vtkCommand::StartEvent);
+
+    int numberOfThreads = std::min(vtkMultiThreader::GetGlobalDefaultNumberOfThreads(),
+                                   static_cast<int>(generator.LabelModels.size()));
+    vtkNew<vtkMultiThreader> threader;
+    std::vector<int> threadIds;
+    for (int t = 0; t < numberOfThreads; ++t)
+      {
+      threadIds.push_back(threader->SpawnThread(GenerateLabelModelsThreadFunction, &generator));
+      }
+    ::size_t numberOfGeneratedModels = 0;
+    while (numberOfGeneratedModels < generator.LabelModels.size())
+      {
+      vtksys::SystemTools::Delay(100);
+      generator.Lock.Lock();
+      numberOfGeneratedModels = generator.NumberOfGeneratedModels;
+      generator.Lock.Unlock();
+      generatorProgress->UpdateProgress(static_cast<double>(numberOfGeneratedModels) /
+                                        generator.LabelModels.size());
+      }
+    // TerminateThread waits for the thread to be done
+    for (::size_t t = 0; t < threadIds.size(); ++t)
+      {
+      threader->TerminateThread(threadIds[t]);
+      }
+    generatorProgress->InvokeEvent(vtkCommand::EndEvent);
+    timer->StopTimer();
+    std::cout << "Generated " << generator.LabelModels.size() << " models with " << numberOfThreads
+              << " threads in " << timer->GetElapsedTime() << " seconds" << std::endl;
+
+    for (::size_t l = 0; l < generator.LabelModels.size(); ++l)
+      {
+      generatedModels[generator.LabelModels[l].Label] = generator.LabelModels[l].Model;
+      }
+    }
+
   for(::size_t l = 0; l < loopLabels.size(); l++)
     {
     // get the label out of the vector
@@ -1027,8 +1441,23 @@ int main(int argc, char * argv[])
       */
       }
 
+    // the model was already generated by the parallel pipeline
+    vtkPolyData* generatedModel = NULL;
+    if (useParallelPipeline)
+      {
+      std::map<int, vtkSmartPointer<vtkPolyData> >::iterator it = generatedModels.find(i);
+      if (it == generatedModels.end() || it->second == NULL)
+        {
+        std::cout << "Cannot create a model from label " << i
+                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+        std::cout << "...continuing" << endl;
+        continue;
+        }
+      generatedModel = it->second;
+      }
+
     // threshold
-    if (JointSmoothing == 0)
+    if (JointSmoothing == 0 && generatedModel == NULL)
       {
       if (imageThreshold)
         {
@@ -1105,7 +1534,7 @@ int main(int argc, char * argv[])
         }
       imageToStructuredPoints->ReleaseDataFlagOn();
       }
-    else
+    else if (JointSmoothing)
       {
       // use the output of the smoother
       if (threshold)
@@ -1169,7 +1598,7 @@ int main(int argc, char * argv[])
 
     // if not joint smoothing, may need to skip this label
     int skipLabel = 0;
-    if (JointSmoothing == 0)
+    if (JointSmoothing == 0 && generatedModel == NULL)
       {
       if (mcubes)
         {
@@ -1308,11 +1737,11 @@ int main(int argc, char * argv[])
         writer = NULL;
         }
       }
-    else
+    else if (JointSmoothing)
       {
       std::cout << "Skipping marching cubes..." << endl;
       }
-    if (!skipLabel)
+    if (!skipLabel && generatedModel == NULL)
       {
       // In switch from vtk 4 to vtk 5, vtkDecimate was deprecated from the Patented dir, use vtkDecimatePro
       // TODO: look at vtkQuadraticDecimation
@@ -1823,7 +2252,10 @@ int main(int argc, char * argv[])
         std::cerr << "ERROR updating stripper for model " << i << std::endl;
         return EXIT_FAILURE;
         }
-
+      generatedModel = stripper->GetOutput();
+      }
+    if (!skipLabel)
+      {
       // but for now we're just going to write it out
       writer = vtkSmartPointer<vtkPolyDataWriter>::New();
       std::string            comment4 = "Write " + labelName;
@@ -1838,9 +2270,16 @@ int main(int argc, char * argv[])
         watchWriter.QuietOn();
         }
 #if (VTK_MAJOR_VERSION <= 5)
-      writer->SetInput(stripper->GetOutput());
+      writer->SetInput(generatedModel);
 #else
-      writer->SetInputConnection(stripper->GetOutputPort());
+      if (useParallelPipeline)
+        {
+        writer->SetInputData(generatedModel);
+        }
+      else
+        {
+        writer->SetInputConnection(stripper->GetOutputPort());
+        }
 #endif
       writer->SetFileType(2);
       std::string fileName;
@@ -0,0 +1,280 @@
+// VTK includes
+#include <vtkCellLocator.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataReader.h>
+#include <vtkTimerLog.h>
+
+// VTKsys includes
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#define MODULE_IMPORT __declspec(dllimport)
+#else
+#define MODULE_IMPORT
+#endif
+
+extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char * []);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Return the sorted names of the models (.vtk files) of a directory.
+std::vector<std::string> GetModelFileNames(const std::string& directory)
+{
+  std::vector<std::string> fileNames;
+  vtksys::Directory dir;
+  dir.Load(directory.c_str());
+  for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+    {
+    std::string fileName = dir.GetFile(i);
+    if (vtksys::SystemTools::GetFilenameLastExtension(fileName) == ".vtk")
+      {
+      fileNames.push_back(fileName);
+      }
+    }
+  std::sort(fileNames.begin(), fileNames.end());
+  return fileNames;
+}
+
+//----------------------------------------------------------------------------
+// Largest distance from a point of 'from' to the surface 'to'.
+double GetMaximumDistance(vtkPolyData* from, vtkPolyData* to)
+{
+  if (from->GetNumberOfPoints() == 0)
+    {
+    return 0.;
+    }
+  if (to->GetNumberOfCells() == 0)
+    {
+    return VTK_DOUBLE_MAX;
+    }
+  vtkNew<vtkCellLocator> locator;
+  locator->SetDataSet(to);
+  locator->BuildLocator();
+  double maximumDistance2 = 0.;
+  for (vtkIdType i = 0; i < from->GetNumberOfPoints(); ++i)
+    {
+    double closestPoint[3];
+    vtkIdType cellId = 0;
+    int subId = 0;
+    double distance2 = 0.;
+    locator->FindClosestPoint(from->GetPoint(i), closestPoint, cellId, subId, distance2);
+    maximumDistance2 = std::max(maximumDistance2, distance2);
+    }
+  return sqrt(maximumDistance2);
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* ReadModel(vtkPolyDataReader* reader, const std::string& fileName)
+{
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  return reader->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+// Check that the two directories contain the same models, the surfaces of
+// two models with the same file name must be closer than tolerance.
+bool CompareModels(const std::string& directory1, const std::string& directory2,
+                   double tolerance)
+{
+  std::vector<std::string> fileNames = GetModelFileNames(directory1);
+  if (fileNames.empty() || fileNames != GetModelFileNames(directory2))
+    {
+    std::cerr << "Line " << __LINE__ << " - " << directory1 << " and " << directory2
+              << " don't contain the same models" << std::endl;
+    return false;
+    }
+  double maximumDistance = 0.;
+  for (size_t i = 0; i < fileNames.size(); ++i)
+    {
+    vtkNew<vtkPolyDataReader> reader1;
+    vtkNew<vtkPolyDataReader> reader2;
+    vtkPolyData* model1 = ReadModel(reader1.GetPointer(), directory1 + "/" + fileNames[i]);
+    vtkPolyData* model2 = ReadModel(reader2.GetPointer(), directory2 + "/" + fileNames[i]);
+    double distance = std::max(GetMaximumDistance(model1, model2),
+                               GetMaximumDistance(model2, model1));
+    if (distance > tolerance)
+      {
+      std::cerr << "Line " << __LINE__ << " - " << fileNames[i] << " differs by "
+                << distance << " (" << model1->GetNumberOfPoints() << " and "
+                << model2->GetNumberOfPoints() << " points)" << std::endl;
+      return false;
+      }
+    maximumDistance = std::max(maximumDistance, distance);
+    }
+  std::cout << "<DartMeasurement name=\"ModelMaximumDistance\" type=\"numeric/double\">"
+            << maximumDistance << "</DartMeasurement>" << std::endl;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Write an atlas like label map: numberOfLabels ellipsoids of different
+// sizes laid out on a grid, in a dimension^3 volume of 1mm voxels.
+bool WriteAtlas(const std::string& fileName, int dimension, int numberOfLabels)
+{
+  int cellsPerAxis = 1;
+  while (cellsPerAxis * cellsPerAxis * cellsPerAxis < numberOfLabels)
+    {
+    ++cellsPerAxis;
+    }
+  double cellSize = static_cast<double>(dimension) / cellsPerAxis;
+  std::vector<short> labels(static_cast<size_t>(dimension) * dimension * dimension, 0);
+  for (int label = 1; label <= numberOfLabels; ++label)
+    {
+    int cell = label - 1;
+    double center[3] = {
+      (cell % cellsPerAxis + 0.5) * cellSize,
+      ((cell / cellsPerAxis) % cellsPerAxis + 0.5) * cellSize,
+      (cell / (cellsPerAxis * cellsPerAxis) + 0.5) * cellSize};
+    double radius[3] = {
+      cellSize * (0.30 + 0.05 * (label % 3)),
+      cellSize * (0.30 + 0.05 * (label % 4)),
+      cellSize * (0.25 + 0.05 * (label % 5))};
+    for (int k = std::max(0, static_cast<int>(center[2] - radius[2]));
+         k < std::min(dimension, static_cast<int>(center[2] + radius[2]) + 1); ++k)
+      {
+      for (int j = std::max(0, static_cast<int>(center[1] - radius[1]));
+           j < std::min(dimension, static_cast<int>(center[1] + radius[1]) + 1); ++j)
+        {
+        for (int i = std::max(0, static_cast<int>(center[0] - radius[0]));
+             i < std::min(dimension, static_cast<int>(center[0] + radius[0]) + 1); ++i)
+          {
+          double x = (i - center[0]) / radius[0];
+          double y = (j - center[1]) / radius[1];
+          double z = (k - center[2]) / radius[2];
+          if (x * x + y * y + z * z <= 1.)
+            {
+            labels[(static_cast<size_t>(k) * dimension + j) * dimension + i] =
+              static_cast<short>(label);
+            }
+          }
+        }
+      }
+    }
+
+  const short one = 1;
+  bool littleEndian = (*reinterpret_cast<const char*>(&one) == 1);
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+  file << "NRRD0004\n"
+       << "type: short\n"
+       << "dimension: 3\n"
+       << "space: left-posterior-superior\n"
+       << "sizes: " << dimension << " " << dimension << " " << dimension << "\n"
+       << "space directions: (1,0,0) (0,1,0) (0,0,1)\n"
+       << "kinds: domain domain domain\n"
+       << "endian: " << (littleEndian ? "little" : "big") << "\n"
+       << "encoding: raw\n"
+       << "space origin: (0,0,0)\n\n";
+  file.write(reinterpret_cast<const char*>(&labels[0]), labels.size() * sizeof(short));
+  return file.good();
+}
+
+//----------------------------------------------------------------------------
+// Generate the models of all the labels of inputVolume into the directory of
+// sceneFileName and return the elapsed time, or -1 on failure.
+double RunModelMaker(const std::string& inputVolume, const std::string& sceneFileName,
+                     bool parallel)
+{
+  std::vector<std::string> arguments;
+  arguments.push_back("ModelMaker");
+  arguments.push_back("--generateAll");
+  if (parallel)
+    {
+    arguments.push_back("--parallel");
+    }
+  arguments.push_back("--modelSceneFile");
+  arguments.push_back(sceneFileName);
+  arguments.push_back(inputVolume);
+  std::vector<char*> argv;
+  for (size_t i = 0; i < arguments.size(); ++i)
+    {
+    argv.push_back(const_cast<char*>(arguments[i].c_str()));
+    }
+  argv.push_back(0);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  int res = ModuleEntryPoint(static_cast<int>(arguments.size()), &argv[0]);
+  timer->StopTimer();
+  return res == EXIT_SUCCESS ? timer->GetElapsedTime() : -1.;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Compare the models generated in two directories, e.g. by the parallel and
+// the sequential modes.
+int ModelMakerCompareModelsTest(int argc, char * argv[])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " directory1 directory2 [tolerance]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  double tolerance = argc > 3 ? atof(argv[3]) : 1e-3;
+  return CompareModels(argv[1], argv[2], tolerance) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------
+// Time the generation of the models of an atlas sized label map, one label
+// at a time and in parallel, and check that the models are the same.
+int ModelMakerAtlasTimingTest(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0]
+              << " temporaryDirectory [dimension] [numberOfLabels]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int dimension = argc > 2 ? atoi(argv[2]) : 256;
+  int numberOfLabels = argc > 3 ? atoi(argv[3]) : 150;
+
+  std::string directory = std::string(argv[1]) + "/ModelMakerAtlasTimingTest";
+  vtksys::SystemTools::RemoveADirectory(directory.c_str());
+  std::string sequentialDirectory = directory + "/Sequential";
+  std::string parallelDirectory = directory + "/Parallel";
+  std::string atlasFileName = directory + "/Atlas.nrrd";
+  if (!vtksys::SystemTools::MakeDirectory(sequentialDirectory.c_str()) ||
+      !vtksys::SystemTools::MakeDirectory(parallelDirectory.c_str()) ||
+      !WriteAtlas(atlasFileName, dimension, numberOfLabels))
+    {
+    std::cerr << "Line " << __LINE__ << " - Could not write " << atlasFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  double sequentialTime = RunModelMaker(
+    atlasFileName, sequentialDirectory + "/Atlas.mrml", false);
+  double parallelTime = RunModelMaker(
+    atlasFileName, parallelDirectory + "/Atlas.mrml", true);
+  if (sequentialTime < 0. || parallelTime < 0.)
+    {
+    std::cerr << "Line " << __LINE__ << " - ModelMaker failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "<DartMeasurement name=\"ModelMakerSequentialTime\" type=\"numeric/double\">"
+            << sequentialTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"ModelMakerParallelTime\" type=\"numeric/double\">"
+            << parallelTime << "</DartMeasurement>" << std::endl;
+
+  if (GetModelFileNames(sequentialDirectory).size() != static_cast<size_t>(numberOfLabels))
+    {
+    std::cerr << "Line " << __LINE__ << " - Expected " << numberOfLabels << " models, got "
+              << GetModelFileNames(sequentialDirectory).size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return CompareModels(sequentialDirectory, parallelDirectory, 1e-3) ?
+    EXIT_SUCCESS : EXIT_FAILURE;
+}
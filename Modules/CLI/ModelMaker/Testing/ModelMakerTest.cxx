@@ -7,8 +7,12 @@
 #endif
 
 extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char * []);
+int ModelMakerCompareModelsTest(int, char * []);
+int ModelMakerAtlasTimingTest(int, char * []);
 
 void RegisterTests()
 {
   StringToTestFunctionMap["ModuleEntryPoint"] = ModuleEntryPoint;
+  StringToTestFunctionMap["ModelMakerCompareModelsTest"] = ModelMakerCompareModelsTest;
+  StringToTestFunctionMap["ModelMakerAtlasTimingTest"] = ModelMakerAtlasTimingTest;
 }
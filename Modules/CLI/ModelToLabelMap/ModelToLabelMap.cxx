@@ -28,12 +28,21 @@
 #include "itkPluginUtilities.h"
 #include <itksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+
+// vtkAddon includes
+#include <vtkPolyDataToLabelMapFilter.h>
+
 // VTK includes
 #include <vtkDebugLeaks.h>
+#include <vtkImageData.h>
 #include <vtkNew.h>
+#include <vtkPointData.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyDataPointSampler.h>
 #include <vtkPolyDataReader.h>
+#include <vtkUnsignedCharArray.h>
 #include <vtkXMLPolyDataReader.h>
 #include <vtkVersion.h>
 
@@ -92,6 +101,141 @@ LabelImageType::Pointer BinaryClosingFilter3D( LabelImageType::Pointer & img, un
   return BinaryErodeFilter3D( imgDilate, ballsize );
 }
 
+//
+// Description: Set the voxels close to the surface then flood fill from the
+// center of gravity of the model
+void SampleAndFillModel( LabelImageType::Pointer & label, vtkPolyData* polyData,
+                         double sampleDistance, int labelValue )
+{
+  vtkNew<vtkPolyDataPointSampler> sampler;
+
+#if (VTK_MAJOR_VERSION <= 5)
+  sampler->SetInput( polyData );
+#else
+  sampler->SetInputData( polyData );
+#endif
+  sampler->SetDistance( sampleDistance );
+  sampler->GenerateEdgePointsOn();
+  sampler->GenerateInteriorPointsOn();
+  sampler->GenerateVertexPointsOn();
+  sampler->Update();
+
+  std::cout << polyData->GetNumberOfPoints() << std::endl;
+  std::cout << sampler->GetOutput()->GetNumberOfPoints() << std::endl;
+  for( int k = 0; k < sampler->GetOutput()->GetNumberOfPoints(); k++ )
+    {
+    double *                  pt = sampler->GetOutput()->GetPoint( k );
+    LabelImageType::PointType pitk;
+    pitk[0] = pt[0];
+    pitk[1] = pt[1];
+    pitk[2] = pt[2];
+    LabelImageType::IndexType idx;
+    label->TransformPhysicalPointToIndex( pitk, idx );
+
+    if( label->GetLargestPossibleRegion().IsInside(idx) )
+      {
+      label->SetPixel( idx, labelValue );
+      }
+    }
+
+  // do morphological closing
+  LabelImageType::Pointer                           closedLabel = BinaryClosingFilter3D( label, 2);
+  itk::ImageRegionIteratorWithIndex<LabelImageType> itLabel(closedLabel, closedLabel->GetLargestPossibleRegion() );
+
+  // do flood fill using binary threshold image function
+  typedef itk::BinaryThresholdImageFunction<LabelImageType> ImageFunctionType;
+  ImageFunctionType::Pointer func = ImageFunctionType::New();
+  func->SetInputImage( closedLabel );
+  func->ThresholdBelow(1);
+
+  LabelImageType::IndexType idx;
+  LabelImageType::PointType COG;
+
+  // set the centre of gravity
+  // double *bounds = polyData->GetBounds();
+  COG.Fill(0.0);
+  for( vtkIdType k = 0; k < polyData->GetNumberOfPoints(); k++ )
+    {
+    double *pt = polyData->GetPoint( k );
+    for( int m = 0; m < 3; m++ )
+      {
+      COG[m] += pt[m];
+      }
+    }
+  for( int m = 0; m < 3; m++ )
+    {
+    COG[m] /= static_cast<float>( polyData->GetNumberOfPoints() );
+    }
+
+  label->TransformPhysicalPointToIndex( COG, idx );
+
+  itk::FloodFilledImageFunctionConditionalIterator<LabelImageType, ImageFunctionType> floodFill( closedLabel, func, idx );
+  for( floodFill.GoToBegin(); !floodFill.IsAtEnd(); ++floodFill )
+    {
+    LabelImageType::IndexType i = floodFill.GetIndex();
+    closedLabel->SetPixel( i, labelValue );
+    }
+  LabelImageType::Pointer finalLabel = BinaryClosingFilter3D( closedLabel, 2);
+  for( itLabel.GoToBegin(); !itLabel.IsAtEnd(); ++itLabel )
+    {
+    LabelImageType::IndexType i = itLabel.GetIndex();
+    label->SetPixel( i, finalLabel->GetPixel(i) );
+    }
+}
+
+//
+// Description: Set the voxels whose center is inside the model
+void VoxelizeModel( LabelImageType::Pointer & label, vtkPolyData* polyData, int labelValue )
+{
+  // Voxelize in the continuous index space of the label map so that the
+  // direction of the reference volume is taken into account
+  vtkPoints* allPoints = polyData->GetPoints();
+  vtkNew<vtkPoints> indexPoints;
+  indexPoints->SetNumberOfPoints( allPoints->GetNumberOfPoints() );
+  for( vtkIdType k = 0; k < allPoints->GetNumberOfPoints(); k++ )
+    {
+    double*                   point = allPoints->GetPoint( k );
+    LabelImageType::PointType pitk;
+    pitk[0] = point[0];
+    pitk[1] = point[1];
+    pitk[2] = point[2];
+    itk::ContinuousIndex<double, 3> cidx;
+    label->TransformPhysicalPointToContinuousIndex( pitk, cidx );
+    indexPoints->SetPoint( k, cidx[0], cidx[1], cidx[2] );
+    }
+  vtkNew<vtkPolyData> indexPolyData;
+  indexPolyData->ShallowCopy( polyData );
+  indexPolyData->SetPoints( indexPoints.GetPointer() );
+
+  // Paint directly into the buffer of the label map
+  LabelImageType::RegionType region = label->GetLargestPossibleRegion();
+  vtkNew<vtkUnsignedCharArray> labelArray;
+  labelArray->SetArray( label->GetBufferPointer(), region.GetNumberOfPixels(), 1 );
+  vtkNew<vtkImageData> labelImage;
+  labelImage->SetExtent( region.GetIndex()[0], region.GetIndex()[0] + region.GetSize()[0] - 1,
+                         region.GetIndex()[1], region.GetIndex()[1] + region.GetSize()[1] - 1,
+                         region.GetIndex()[2], region.GetIndex()[2] + region.GetSize()[2] - 1 );
+#if (VTK_MAJOR_VERSION <= 5)
+  labelImage->SetScalarTypeToUnsignedChar();
+  labelImage->SetNumberOfScalarComponents( 1 );
+#endif
+  labelImage->GetPointData()->SetScalars( labelArray.GetPointer() );
+
+  vtkNew<vtkPolyDataToLabelMapFilter> voxelizer;
+#if (VTK_MAJOR_VERSION <= 5)
+  voxelizer->SetInput( labelImage.GetPointer() );
+  voxelizer->AddInputSurface( indexPolyData.GetPointer() );
+#else
+  voxelizer->SetInputData( labelImage.GetPointer() );
+  voxelizer->AddInputSurfaceData( indexPolyData.GetPointer() );
+#endif
+  voxelizer->SetLabelValue( 0, labelValue );
+  voxelizer->Update();
+
+  unsigned char* voxels = static_cast<unsigned char*>( voxelizer->GetOutput()->GetScalarPointer() );
+  std::copy( voxels, voxels + region.GetNumberOfPixels(), label->GetBufferPointer() );
+}
+
 //
 // Description: A templated procedure to execute the algorithm
 template <class T>
@@ -166,80 +310,13 @@ int DoIt( int argc, char * argv[])
     allPoints->SetPoint( k, point[0], point[1], point[2] );
     }
 
-  // do it
-  vtkNew<vtkPolyDataPointSampler> sampler;
-
-#if (VTK_MAJOR_VERSION <= 5)
-  sampler->SetInput( polyData );
-#else
-  sampler->SetInputData( polyData );
-#endif
-  sampler->SetDistance( sampleDistance );
-  sampler->GenerateEdgePointsOn();
-  sampler->GenerateInteriorPointsOn();
-  sampler->GenerateVertexPointsOn();
-  sampler->Update();
-
-  std::cout << polyData->GetNumberOfPoints() << std::endl;
-  std::cout << sampler->GetOutput()->GetNumberOfPoints() << std::endl;
-  for( int k = 0; k < sampler->GetOutput()->GetNumberOfPoints(); k++ )
-    {
-    double *                  pt = sampler->GetOutput()->GetPoint( k );
-    LabelImageType::PointType pitk;
-    pitk[0] = pt[0];
-    pitk[1] = pt[1];
-    pitk[2] = pt[2];
-    LabelImageType::IndexType idx;
-    label->TransformPhysicalPointToIndex( pitk, idx );
-
-    if( label->GetLargestPossibleRegion().IsInside(idx) )
-      {
-      label->SetPixel( idx, labelValue );
-      }
-    }
-
-  // do morphological closing
-  LabelImageType::Pointer                           closedLabel = BinaryClosingFilter3D( label, 2);
-  itk::ImageRegionIteratorWithIndex<LabelImageType> itLabel(closedLabel, closedLabel->GetLargestPossibleRegion() );
-
-  // do flood fill using binary threshold image function
-  typedef itk::BinaryThresholdImageFunction<LabelImageType> ImageFunctionType;
-  ImageFunctionType::Pointer func = ImageFunctionType::New();
-  func->SetInputImage( closedLabel );
-  func->ThresholdBelow(1);
-
-  LabelImageType::IndexType idx;
-  LabelImageType::PointType COG;
-
-  // set the centre of gravity
-  // double *bounds = polyData->GetBounds();
-  COG.Fill(0.0);
-  for( vtkIdType k = 0; k < polyData->GetNumberOfPoints(); k++ )
+  if( exact )
     {
-    double *pt = polyData->GetPoint( k );
-    for( int m = 0; m < 3; m++ )
-      {
-      COG[m] += pt[m];
-      }
-    }
-  for( int m = 0; m < 3; m++ )
-    {
-    COG[m] /= static_cast<float>( polyData->GetNumberOfPoints() );
-    }
-
-  label->TransformPhysicalPointToIndex( COG, idx );
-
-  itk::FloodFilledImageFunctionConditionalIterator<LabelImageType, ImageFunctionType> floodFill( closedLabel, func, idx );
-  for( floodFill.GoToBegin(); !floodFill.IsAtEnd(); ++floodFill )
-    {
-    LabelImageType::IndexType i = floodFill.GetIndex();
-    closedLabel->SetPixel( i, labelValue );
+    VoxelizeModel( label, polyData, labelValue );
     }
-  LabelImageType::Pointer finalLabel = BinaryClosingFilter3D( closedLabel, 2);
-  for( itLabel.GoToBegin(); !itLabel.IsAtEnd(); ++itLabel )
+  else
     {
-    LabelImageType::IndexType i = itLabel.GetIndex();
-    label->SetPixel( i, finalLabel->GetPixel(i) );
+    SampleAndFillModel( label, polyData, sampleDistance, labelValue );
     }
 
   typename WriterType::Pointer writer = WriterType::New();
@@ -158,7 +158,8 @@ QString qSlicerColorsModule::helpText()const
     "2. Parametric tables, defined by an equation, such as the FMRIPA table.<br>"
     "3. Discrete tables, such as those read in from a file.<br><br>"
     "You can create a duplicate of a color table to allow editing the "
-    "names and values and color by clicking on the folder+ icon.<br>"
+    "names and values and color by clicking on the folder+ icon. The built-in "
+    "tables can't be edited, they are shared by all the scenes.<br>"
     "You can then save the new color table via the File -> Save interface.<br>"
     "The color file format is a plain text file with the .txt or .ctbl extension. "
     "Each line in the file has:<br>"
@@ -19,6 +19,8 @@
 ==============================================================================*/
 
 // QtCore includes
+#include <QCoreApplication>
+#include <QDebug>
 #include <QMessageBox>
 
 #include "qSlicerSceneReader.h"
@@ -30,12 +32,28 @@
 // MRML includes
 #include <vtkMRMLScene.h>
 
+// MRML Logic includes
+#include <vtkMRMLSceneLoader.h>
+
+// VTK includes
+#include <vtkNew.h>
+
 class qSlicerSceneReaderPrivate
 {
 public:
+  qSlicerSceneReaderPrivate();
+
   vtkSmartPointer<vtkSlicerCamerasModuleLogic> CamerasLogic;
+  /// Loader of the scene being loaded, 0 if none.
+  vtkMRMLSceneLoader* Loader;
 };
 
+//-----------------------------------------------------------------------------
+qSlicerSceneReaderPrivate::qSlicerSceneReaderPrivate()
+{
+  this->Loader = 0;
+}
+
 //-----------------------------------------------------------------------------
 qSlicerSceneReader::qSlicerSceneReader(vtkSlicerCamerasModuleLogic* camerasLogic,
                                QObject* _parent)
@@ -81,21 +99,47 @@ bool qSlicerSceneReader::load(const qSlicerIO::IOProperties& properties)
   Q_D(qSlicerSceneReader);
   Q_ASSERT(properties.contains("fileName"));
   QString file = properties["fileName"].toString();
-  this->mrmlScene()->SetURL(file.toLatin1());
-  bool clear = properties.value("clear", false).toBool();
-  int res = 0;
-  if (clear)
+  if (d->Loader)
     {
-    res = this->mrmlScene()->Connect();
+    qWarning() << "Can't load" << file << "while another scene is loading";
+    return false;
     }
-  else
+  bool clear = properties.value("clear", false).toBool();
+
+  vtkNew<vtkMRMLSceneLoader> loader;
+  loader->SetMRMLScene(this->mrmlScene());
+  loader->SetFileName(file.toLatin1());
+  loader->SetClear(clear);
+  bool wasCopying = d->CamerasLogic->GetCopyImportedCameras();
+  if (!clear)
     {
-    bool wasCopying = d->CamerasLogic->GetCopyImportedCameras();
     bool copyCameras = properties.value("copyCameras", wasCopying).toBool();
     d->CamerasLogic->SetCopyImportedCameras(copyCameras);
-    res = this->mrmlScene()->Import();
+    }
+  bool res = false;
+  if (properties.value("interactive", false).toBool())
+    {
+    // The data is read step by step, the views are rendered and the load
+    // can be canceled between two steps. The scene is parsed by Start().
+    bool started = loader->Start();
+    d->CamerasLogic->SetCopyImportedCameras(wasCopying);
+    if (started)
+      {
+      d->Loader = loader.GetPointer();
+      while (loader->Step())
+        {
+        QCoreApplication::processEvents();
+        }
+      d->Loader = 0;
+      res = loader->IsSuccessful();
+      }
+    }
+  else
+    {
+    res = loader->Run();
     d->CamerasLogic->SetCopyImportedCameras(wasCopying);
     }
+  loader->SetMRMLScene(0);
 
   if (this->mrmlScene()->GetLastLoadedVersion() &&
      this->mrmlScene()->GetVersion() &&
@@ -112,3 +156,13 @@ bool qSlicerSceneReader::load(const qSlicerIO::IOProperties& properties)
 
   return res;
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerSceneReader::cancel()
+{
+  Q_D(qSlicerSceneReader);
+  if (d->Loader)
+    {
+    d->Loader->Cancel();
+    }
+}
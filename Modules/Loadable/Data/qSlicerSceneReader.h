@@ -31,8 +31,9 @@ class qSlicerSceneReaderPrivate;
 
 ///
 /// qSlicerSceneReader is the IO class that handle MRML scene
-/// It internally call vtkMRMLScene::Connect() or vtkMRMLScene::Import()
-/// depending on the clear flag.
+/// It internally uses vtkMRMLSceneLoader to clear (or not depending on the
+/// clear flag) and load the scene step by step: the application events are
+/// processed while the data of the nodes is read.
 class Q_SLICER_QTMODULES_DATA_EXPORT qSlicerSceneReader
   : public qSlicerFileReader
 {
@@ -55,7 +56,17 @@ public:
   /// the supported properties are:
   /// QString fileName: the path of the mrml scene to load
   /// bool clear: wether the current should be cleared or not
+  /// bool interactive: if true, the application events are processed while
+  /// the data is read and the load can be canceled, see vtkMRMLSceneLoader.
+  /// False by default.
   virtual bool load(const qSlicerIO::IOProperties& properties);
+
+public slots:
+  /// Stop loading the scene, the nodes whose data is not read yet are
+  /// removed from the scene. load() then returns false. Only interactive
+  /// loads can be canceled.
+  void cancel();
+
 protected:
   QScopedPointer<qSlicerSceneReaderPrivate> d_ptr;
 
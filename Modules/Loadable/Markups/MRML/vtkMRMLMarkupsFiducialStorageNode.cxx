@@ -26,7 +26,13 @@
 #include "vtkStringArray.h"
 #include <vtksys/SystemTools.hxx>
 
-#include <sstream>
+// STD includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
 
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsFiducialStorageNode);
@@ -71,6 +77,102 @@ bool vtkMRMLMarkupsFiducialStorageNode::CanReadInReferenceNode(vtkMRMLNode *refN
   return refNode->IsA("vtkMRMLMarkupsFiducialNode");
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Read the whole file with a single call so that lines can be tokenized in
+// place instead of being copied into a std::stringstream.
+bool ReadFileIntoBuffer(const std::string& fileName, std::vector<char>& buffer)
+{
+  std::ifstream ifs(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!ifs.is_open())
+    {
+    return false;
+    }
+  ifs.seekg(0, std::ios::end);
+  std::streamoff length = ifs.tellg();
+  ifs.seekg(0, std::ios::beg);
+  buffer.clear();
+  if (length > 0)
+    {
+    buffer.resize(static_cast<size_t>(length));
+    ifs.read(&buffer[0], length);
+    buffer.resize(static_cast<size_t>(ifs.gcount()));
+    }
+  // terminate the buffer so that strtod/strtol stop on the last line
+  buffer.push_back('\0');
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Return the end of the field starting at begin. A field starting with a
+// double quote extends to its closing quote, skipping the escaped quotes
+// written by vtkMRMLMarkupsStorageNode::ConvertStringToStorageFormat.
+const char* FindFieldEnd(const char* begin, const char* end, char separator)
+{
+  if (begin < end && *begin == '"')
+    {
+    for (const char* c = begin + 1; c < end; ++c)
+      {
+      if (*c != '"')
+        {
+        continue;
+        }
+      if (c + 1 < end && c[1] == '"')
+        {
+        ++c;
+        continue;
+        }
+      return c + 1;
+      }
+    return end;
+    }
+  const char* separatorPos =
+    static_cast<const char*>(memchr(begin, separator, end - begin));
+  return separatorPos ? separatorPos : end;
+}
+
+//----------------------------------------------------------------------------
+// Extract the next field of the line and move the cursor past its separator.
+void NextField(const char*& cursor, const char* end, char separator,
+               const char*& fieldBegin, const char*& fieldEnd)
+{
+  fieldBegin = cursor;
+  fieldEnd = FindFieldEnd(cursor, end, separator);
+  cursor = (fieldEnd < end) ? fieldEnd + 1 : end;
+}
+
+//----------------------------------------------------------------------------
+double NextDouble(const char*& cursor, const char* end, char separator)
+{
+  const char* fieldBegin;
+  const char* fieldEnd;
+  NextField(cursor, end, separator, fieldBegin, fieldEnd);
+  return (fieldBegin < fieldEnd) ? strtod(fieldBegin, NULL) : 0.0;
+}
+
+//----------------------------------------------------------------------------
+int NextInt(const char*& cursor, const char* end, char separator)
+{
+  const char* fieldBegin;
+  const char* fieldEnd;
+  NextField(cursor, end, separator, fieldBegin, fieldEnd);
+  return (fieldBegin < fieldEnd) ? static_cast<int>(strtol(fieldBegin, NULL, 10)) : 0;
+}
+
+//----------------------------------------------------------------------------
+// Append a number formatted as ostream would with its default precision.
+void AppendNumber(std::string& buffer, double value)
+{
+  char number[64];
+  sprintf(number, "%g", value);
+  buffer.append(number);
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 int vtkMRMLMarkupsFiducialStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -124,336 +226,213 @@ int vtkMRMLMarkupsFiducialStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     parseAsAnnotationFiducial = true;
     }
 
-  // open the file for reading input
-  fstream fstr;
-
-  fstr.open(fullName.c_str(), fstream::in);
+  // read the whole file at once, lines are then tokenized in place
+  std::vector<char> buffer;
+  if (!ReadFileIntoBuffer(fullName, buffer))
+    {
+    vtkErrorMacro("ERROR opening markups file " << this->FileName << endl);
+    return 0;
+    }
 
-  if (fstr.is_open())
+  if (markupsNode->GetNumberOfMarkups() > 0)
     {
-    if (markupsNode->GetNumberOfMarkups() > 0)
-      {
-      // clear out the list
-      markupsNode->RemoveAllMarkups();
-      }
+    // clear out the list
+    markupsNode->RemoveAllMarkups();
+    }
+
+  // parse all the markups before adding them to the node in one call, so
+  // that observers are notified once instead of once per markup
+  std::vector<Markup> markups;
+  markups.reserve(std::count(buffer.begin(), buffer.end(), '\n') + 1);
 
-    char line[MARKUPS_BUFFER_SIZE];
+  // check for the version
+  std::string version;
+  // only print out the warning once
+  bool printedVersionWarning = false;
 
-    // save the valid lines in a vector, parse them once know the max id
-    std::vector<std::string>lines;
-    int thisMarkupNumber = 0;
+  // coordinate system
+  int coordinateSystemFlag = 0;
 
-    // check for the version
-    std::string version;
-    // only print out the warning once
-    bool printedVersionWarning = false;
+  // annotation fiducial files use the file name as label for all the points
+  std::string annotationLabel;
+  if (parseAsAnnotationFiducial)
+    {
+    std::string filenameName = vtksys::SystemTools::GetFilenameName(this->GetFileName());
+    annotationLabel = vtksys::SystemTools::GetFilenameWithoutExtension(filenameName);
+    }
 
-    // coordinate system
-    int coordinateSystemFlag = 0;
+  // the format of the default labels, used when a legacy file has no label
+  std::string labelFormat = markupsNode->ReplaceListNameInMarkupLabelFormat();
+  char defaultLabel[MARKUPS_BUFFER_SIZE];
 
-    while (fstr.good())
+  const char* bufferEnd = &buffer[0] + buffer.size() - 1;
+  const char* lineBegin = &buffer[0];
+  while (lineBegin < bufferEnd)
+    {
+    const char* lineEnd =
+      static_cast<const char*>(memchr(lineBegin, '\n', bufferEnd - lineBegin));
+    const char* nextLine = lineEnd ? lineEnd + 1 : bufferEnd;
+    if (!lineEnd)
       {
-      fstr.getline(line, MARKUPS_BUFFER_SIZE);
+      lineEnd = bufferEnd;
+      }
+    // ignore the carriage return of files saved on Windows
+    if (lineEnd > lineBegin && lineEnd[-1] == '\r')
+      {
+      --lineEnd;
+      }
+
+    if (lineBegin == lineEnd)
+      {
+      vtkDebugMacro("Empty line, skipping");
+      }
+    else if (lineBegin[0] == '#')
+      {
+      // if there's a space after the hash, check for the version
+      if (lineEnd - lineBegin > 1 && lineBegin[1] == ' ')
+        {
+        std::string lineString = std::string(lineBegin, lineEnd);
+        vtkDebugMacro("Have a possible option in line " << lineString);
+        if (lineString.find("# Markups fiducial file version = ") != std::string::npos)
+          {
+          version = lineString.substr(34,std::string::npos);
+          vtkDebugMacro("Version = " << version);
+          }
+        else if (lineString.find("# CoordinateSystem = ") != std::string::npos)
+          {
+          std::string str = lineString.substr(21,std::string::npos);
+          coordinateSystemFlag = atoi(str.c_str());
+          vtkDebugMacro("CoordinateSystem = " << coordinateSystemFlag);
+          this->SetCoordinateSystem(coordinateSystemFlag);
+          }
+        else if (lineString.find("# columns = ") != std::string::npos)
+          {
+          // the markups header, fixed
+          }
+        }
+      }
+    else
+      {
+      markups.push_back(Markup());
+      Markup& markup = markups.back();
+      // ID, default label and orientation, flags
+      markupsNode->InitMarkup(&markup);
+      if (!markupsNode->GetScene())
+        {
+        // Outside of a scene InitMarkup numbers the ID from the markups
+        // already in the node, count the ones parsed so far as well
+        char id[32];
+        sprintf(id, "%d", markupsNode->MaximumNumberOfMarkups + static_cast<int>(markups.size()));
+        markup.ID = std::string(id);
+        }
+      markup.points.push_back(vtkVector3d(0.0, 0.0, 0.0));
+      double* xyz = markup.points[0].GetData();
+
+      const char* cursor = lineBegin;
+      const char* fieldBegin;
+      const char* fieldEnd;
 
-      // does it start with a #?
-      if (line[0] == '#')
+      if (version.size() == 0)
         {
-        vtkDebugMacro("Comment line, checking:\n\"" << line << "\"");
+        // legacy files: the label is the first field
+        char separator = parseAsAnnotationFiducial ? '|' : ',';
+        if (!parseAsAnnotationFiducial && !printedVersionWarning)
+          {
+          vtkWarningMacro("Have an unversioned file, assuming Slicer 3 format .fcsv");
+          printedVersionWarning = true;
+          }
 
-        // if there's a space after the hash, check for the version
-        if (line[1] == ' ')
+        // annotation fiducial line format = point|x|y|z|sel|vis
+        // point line format = label,x,y,z,sel,vis
+        NextField(cursor, lineEnd, separator, fieldBegin, fieldEnd);
+        if (fieldBegin < fieldEnd)
+          {
+          markup.Label = parseAsAnnotationFiducial ?
+            annotationLabel : std::string(fieldBegin, fieldEnd);
+          }
+        else
           {
-          vtkDebugMacro("Have a possible option in line " << line);
-          std::string lineString = std::string(line);
-          if (lineString.find("# Markups fiducial file version = ") != std::string::npos)
-            {
-            version = lineString.substr(34,std::string::npos);
-            vtkDebugMacro("Version = " << version);
-            }
-          else if (lineString.find("# CoordinateSystem = ") != std::string::npos)
-            {
-            std::string str = lineString.substr(21,std::string::npos);
-            coordinateSystemFlag = atoi(str.c_str());
-            vtkDebugMacro("CoordinateSystem = " << coordinateSystemFlag);
-            this->SetCoordinateSystem(coordinateSystemFlag);
-            }
-          else if (lineString.find("# columns = ") != std::string::npos)
-            {
-            // the markups header, fixed
-            }
+          // InitMarkup numbers the default label from the markups already
+          // in the node, count the ones parsed so far as well
+          int number = markupsNode->MaximumNumberOfMarkups + static_cast<int>(markups.size());
+          sprintf(defaultLabel, labelFormat.c_str(), number);
+          markup.Label = std::string(defaultLabel);
           }
+        xyz[0] = NextDouble(cursor, lineEnd, separator);
+        xyz[1] = NextDouble(cursor, lineEnd, separator);
+        xyz[2] = NextDouble(cursor, lineEnd, separator);
+        markup.Selected = (NextInt(cursor, lineEnd, separator) != 0);
+        markup.Visibility = (NextInt(cursor, lineEnd, separator) != 0);
         }
       else
         {
-        // is it empty?
-        if (line[0] == '\0')
+        // Slicer 4 markups fiducial file
+        // id,x,y,z,ow,ox,oy,oz,vis,sel,lock,label,desc,associatedNodeID
+        NextField(cursor, lineEnd, ',', fieldBegin, fieldEnd);
+        if (fieldBegin < fieldEnd)
           {
-          vtkDebugMacro("Empty line, skipping:\n\"" << line << "\"");
+          markup.ID = std::string(fieldBegin, fieldEnd);
           }
-        else
+        else if (this->GetScene())
           {
-          if (version.size() == 0)
-            {
-            std::string label = std::string("");
-            double x = 0.0, y = 0.0, z = 0.0;
-            int sel = 1, vis = 1;
-
-            markupsNode->AddMarkupWithNPoints(1);
-
-            std::stringstream ss(line);
-            std::string component;
-
-            if (parseAsAnnotationFiducial)
-              {
-              // annotation fiducial line format = point|x|y|z|sel|vis
-              // label
-              getline(ss, component, '|');
-              if (component.size())
-                {
-                vtkDebugMacro("Got point string = " << component.c_str());
-                // use the file name for the point label
-                std::string filenameName = vtksys::SystemTools::GetFilenameName(this->GetFileName());
-                label = vtksys::SystemTools::GetFilenameWithoutExtension(filenameName);
-                markupsNode->SetNthMarkupLabel(thisMarkupNumber,label);
-                }
-
-              // x,y,z
-              getline(ss, component, '|');
-              x = atof(component.c_str());
-              getline(ss, component, '|');
-              y = atof(component.c_str());
-              getline(ss, component, '|');
-              z = atof(component.c_str());
-              markupsNode->SetMarkupPoint(thisMarkupNumber,0,x,y,z);
-
-              // selected
-              getline(ss, component, '|');
-              sel = atoi(component.c_str());
-              markupsNode->SetNthMarkupSelected(thisMarkupNumber,sel);
-
-              // visibility
-              getline(ss, component, '|');
-              vtkDebugMacro("component = " << component.c_str());
-              vis = atoi(component.c_str());
-              markupsNode->SetNthMarkupVisibility(thisMarkupNumber,vis);
-              }
-            else
-              {
-              if (!printedVersionWarning)
-                {
-                vtkWarningMacro("Have an unversioned file, assuming Slicer 3 format .fcsv");
-                printedVersionWarning = true;
-                }
-              // point line format = label,x,y,z,sel,vis
-
-              // label
-              getline(ss, component, ',');
-              if (component.size())
-                {
-                vtkDebugMacro("Got label = " << component.c_str());
-                label = component;
-                markupsNode->SetNthMarkupLabel(thisMarkupNumber,label);
-                }
-
-              // x,y,z
-              getline(ss, component, ',');
-              x = atof(component.c_str());
-              getline(ss, component, ',');
-              y = atof(component.c_str());
-              getline(ss, component, ',');
-              z = atof(component.c_str());
-              markupsNode->SetMarkupPoint(thisMarkupNumber,0,x,y,z);
-
-              // selected
-              getline(ss, component, ',');
-              sel = atoi(component.c_str());
-              markupsNode->SetNthMarkupSelected(thisMarkupNumber,sel);
-
-              // visibility
-              getline(ss, component, ',');
-              vtkDebugMacro("component = " << component.c_str());
-              vis = atoi(component.c_str());
-              markupsNode->SetNthMarkupVisibility(thisMarkupNumber,vis);
-              }
-            thisMarkupNumber++;
-            }
-          else
-            {
-            // Slicer 4 markups fiducial file
-            vtkDebugMacro("\n\n\n\nVersion = " << version << ", got a line: \n\"" << line << "\"");
-            std::string id = std::string("");
-            double x = 0.0, y = 0.0, z = 0.0;
-            double ow = 0.0, ox = 0.0, oy = 0.0, oz = 1.0;
-            int sel = 1, vis = 1, lock = 0;
-            std::string associatedNodeID = std::string("");
-            std::string label = std::string("");
-            std::string desc = std::string("");
-
-            std::stringstream ss(line);
-            int numPoints = 1;
-            markupsNode->AddMarkupWithNPoints(numPoints);
-
-            std::string component;
-
-            // id
-            getline(ss, component, ',');
-            if (component.size())
-              {
-              vtkDebugMacro("Got id = " << component.c_str());
-              id = component;
-              markupsNode->SetNthMarkupID(thisMarkupNumber,id);
-              }
-            else
-              {
-              vtkDebugMacro("No ID");
-              if (this->GetScene())
-                {
-                markupsNode->SetNthMarkupID(thisMarkupNumber,this->GetScene()->GenerateUniqueName(this->GetID()));
-                }
-              }
-
-            // x,y,z
-            getline(ss, component, ',');
-            x = atof(component.c_str());
-            getline(ss, component, ',');
-            y = atof(component.c_str());
-            getline(ss, component, ',');
-            z = atof(component.c_str());
-            if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::RAS)
-              {
-              markupsNode->SetMarkupPoint(thisMarkupNumber,0,x,y,z);
-              }
-            else if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::LPS)
-              {
-              markupsNode->SetMarkupPointLPS(thisMarkupNumber,0,x,y,z);
-              }
-            else
-              {
-              // IJK not implemented yet, assume RAS
-              markupsNode->SetMarkupPoint(thisMarkupNumber,0,x,y,z);
-              }
-
-            // orientatation
-            getline(ss, component, ',');
-            ow = atof(component.c_str());
-            getline(ss, component, ',');
-            ox = atof(component.c_str());
-            getline(ss, component, ',');
-            oy = atof(component.c_str());
-            getline(ss, component, ',');
-            oz = atof(component.c_str());
-            markupsNode->SetNthMarkupOrientation(thisMarkupNumber, ow, ox, oy, oz);
-
-            // visibility
-            getline(ss, component, ',');
-            vtkDebugMacro("component = " << component.c_str());
-            vis = atoi(component.c_str());
-            markupsNode->SetNthMarkupVisibility(thisMarkupNumber,vis);
-
-            // selected
-            getline(ss, component, ',');
-            sel = atoi(component.c_str());
-            markupsNode->SetNthMarkupSelected(thisMarkupNumber,sel);
-
-            // locked
-            getline(ss, component, ',');
-            lock = atoi(component.c_str());
-            markupsNode->SetNthMarkupLocked(thisMarkupNumber,lock);
-
-            // label
-            // the label may have quotes around it, look for the end quote and comma
-            // std::cout << "Line ss = '" << ss.str().c_str() << "'" << std::endl;
-            std::string labelDescID;
-            getline(ss, labelDescID);
-            // if there's no quote at the start of the line, the label was
-            // checked to be sure that there are no commas in it, so extract
-            // to the next comma
-            size_t endCommaPos;
-            if (labelDescID[0] != '"')
-              {
-              endCommaPos = labelDescID.find(",");
-              component = labelDescID.substr(0, endCommaPos);
-              }
-            else
-              {
-              component = this->GetFirstQuotedString(labelDescID, &endCommaPos);
-              }
-            if (component.size())
-              {
-              vtkDebugMacro("Got label = " << component.c_str());
-              label = component;
-              markupsNode->SetNthMarkupLabelFromStorage(thisMarkupNumber,label);
-              }
-            else
-              {
-              vtkDebugMacro("No label");
-              markupsNode->SetNthMarkupLabel(thisMarkupNumber,"");
-              }
-
-            // description
-            // get the rest of the string after the label
-            std::string descID = labelDescID.substr(endCommaPos + 1);
-            // the description may have quotes around it as well
-            if (descID[0] != '"')
-              {
-              endCommaPos = descID.find(",");
-              component = descID.substr(0, endCommaPos);
-              }
-            else
-              {
-              component = this->GetFirstQuotedString(descID, &endCommaPos);
-              }
-            if (component.size())
-              {
-              vtkDebugMacro("Got desc = " << component.c_str());
-              desc = component;
-              markupsNode->SetNthMarkupDescriptionFromStorage(thisMarkupNumber,desc);
-              }
-            else
-              {
-              vtkDebugMacro("No description");
-              markupsNode->SetNthMarkupDescription(thisMarkupNumber,"");
-              }
-
-            // in case the file was written by hand, the associated node id
-            // might be empty
-            size_t associatedNodeIDPos = ss.str().find_last_of(',');
-            if (associatedNodeIDPos != std::string::npos)
-              {
-              component = ss.str().substr(associatedNodeIDPos + 1);
-              if (component.size())
-                {
-                vtkDebugMacro("Got associated node id = " << component.c_str());
-                associatedNodeID = component;
-                markupsNode->SetNthMarkupAssociatedNodeID(thisMarkupNumber,associatedNodeID);
-                }
-              else
-                {
-                vtkDebugMacro("no associated node id");
-                markupsNode->SetNthMarkupAssociatedNodeID(thisMarkupNumber,"");
-                }
-              }
-            else
-              {
-                  markupsNode->SetNthMarkupAssociatedNodeID(thisMarkupNumber,"");
-              }
-
-            thisMarkupNumber++;
-            vtkDebugMacro("Line parsed, got id = " << id << ", vis = " << vis << ", sel = " << sel
-                          << ", associatedNodeID = " << associatedNodeID.c_str()
-                          << ", label = '" << label.c_str() << "', markup number is now " << thisMarkupNumber);
-            } // point line
+          vtkDebugMacro("No ID");
+          markup.ID = this->GetScene()->GenerateUniqueName(this->GetID());
           }
+
+        xyz[0] = NextDouble(cursor, lineEnd, ',');
+        xyz[1] = NextDouble(cursor, lineEnd, ',');
+        xyz[2] = NextDouble(cursor, lineEnd, ',');
+        if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::LPS)
+          {
+          xyz[0] = -xyz[0];
+          xyz[1] = -xyz[1];
+          }
+        // IJK not implemented yet, assume RAS
+
+        for (int i = 0; i < 4; ++i)
+          {
+          markup.OrientationWXYZ[i] = NextDouble(cursor, lineEnd, ',');
+          }
+        markup.Visibility = (NextInt(cursor, lineEnd, ',') != 0);
+        markup.Selected = (NextInt(cursor, lineEnd, ',') != 0);
+        markup.Locked = (NextInt(cursor, lineEnd, ',') != 0);
+
+        // the label and description may have quotes around them
+        NextField(cursor, lineEnd, ',', fieldBegin, fieldEnd);
+        markup.Label = std::string(fieldBegin, fieldEnd);
+        if (memchr(fieldBegin, '"', fieldEnd - fieldBegin))
+          {
+          markup.Label = this->ConvertStringFromStorageFormat(markup.Label);
+          }
+        NextField(cursor, lineEnd, ',', fieldBegin, fieldEnd);
+        markup.Description = std::string(fieldBegin, fieldEnd);
+        if (memchr(fieldBegin, '"', fieldEnd - fieldBegin))
+          {
+          markup.Description = this->ConvertStringFromStorageFormat(markup.Description);
+          }
+
+        // in case the file was written by hand, the associated node id
+        // might be empty, it is whatever follows the last comma
+        const char* associatedNodeIDBegin = lineEnd;
+        while (associatedNodeIDBegin > lineBegin && associatedNodeIDBegin[-1] != ',')
+          {
+          --associatedNodeIDBegin;
+          }
+        if (associatedNodeIDBegin > lineBegin)
+          {
+          markup.AssociatedNodeID = std::string(associatedNodeIDBegin, lineEnd);
+          }
+        vtkDebugMacro("Line parsed, got id = " << markup.ID << ", vis = " << markup.Visibility
+                      << ", sel = " << markup.Selected
+                      << ", associatedNodeID = " << markup.AssociatedNodeID.c_str()
+                      << ", label = '" << markup.Label.c_str() << "'");
         }
       }
-    fstr.close();
-    }
-  else
-    {
-    vtkErrorMacro("ERROR opening markups file " << this->FileName << endl);
-    return 0;
+    lineBegin = nextLine;
     }
 
+  markupsNode->AddMarkups(markups);
+
   return 1;
 }
 
@@ -505,56 +484,57 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   // label can have spaces, everything up to next comma is used, no quotes
   // necessary, same with the description
   of << "# columns = id,x,y,z,ow,ox,oy,oz,vis,sel,lock,label,desc,associatedNodeID" << endl;
+
+  // format the lines in memory and write them by large blocks
+  const size_t blockSize = 1 << 20;
+  std::string buffer;
+  buffer.reserve(blockSize + MARKUPS_BUFFER_SIZE);
   for (int i = 0; i < numberOfMarkups; i++)
     {
-    std::string id = markupsNode->GetNthMarkupID(i);
-    of << id.c_str();
-    vtkDebugMacro("WriteDataInternal: wrote id " << id.c_str());
+    Markup *markup = markupsNode->GetNthMarkup(i);
+    buffer.append(markup->ID);
 
-    int p = 0;
-    double xyz[3];
-    if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::RAS)
+    double xyz[3] = {0.0, 0.0, 0.0};
+    if (!markup->points.empty())
       {
-      markupsNode->GetMarkupPoint(i,p,xyz);
+      xyz[0] = markup->points[0].GetX();
+      xyz[1] = markup->points[0].GetY();
+      xyz[2] = markup->points[0].GetZ();
       }
-    else if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::LPS)
+    if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::LPS)
       {
-      markupsNode->GetMarkupPointLPS(i,p,xyz);
+      xyz[0] = -xyz[0];
+      xyz[1] = -xyz[1];
       }
-    else if (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::IJK)
+    // IJK not implemented yet, use RAS
+    for (int c = 0; c < 3; ++c)
       {
-      // not implemented yet, use RAS
-//      markupsNode->GetMarkupPointIJK(i,p,xyz);
-      markupsNode->GetMarkupPoint(i,p,xyz);
+      buffer.push_back(',');
+      AppendNumber(buffer, xyz[c]);
       }
-    of << "," << xyz[0] << "," << xyz[1] << "," << xyz[2];
-
-    double orientation[4];
-    markupsNode->GetNthMarkupOrientation(i, orientation);
-    bool vis = markupsNode->GetNthMarkupVisibility(i);
-    bool sel = markupsNode->GetNthMarkupSelected(i);
-    bool lock = markupsNode->GetNthMarkupLocked(i);
-
-    std::string label = markupsNode->GetNthMarkupLabelForStorage(i);
-    std::string desc = markupsNode->GetNthMarkupDescriptionForStorage(i);
-    if (desc.size() == 0)
+    for (int c = 0; c < 4; ++c)
       {
-      desc = std::string("");
+      buffer.push_back(',');
+      AppendNumber(buffer, markup->OrientationWXYZ[c]);
       }
-
-    std::string associatedNodeID = markupsNode->GetNthMarkupAssociatedNodeID(i);
-    if (associatedNodeID.size() == 0)
+    buffer.append(markup->Visibility ? ",1" : ",0");
+    buffer.append(markup->Selected ? ",1" : ",0");
+    buffer.append(markup->Locked ? ",1" : ",0");
+    buffer.push_back(',');
+    buffer.append(this->ConvertStringToStorageFormat(markup->Label));
+    buffer.push_back(',');
+    buffer.append(this->ConvertStringToStorageFormat(markup->Description));
+    buffer.push_back(',');
+    buffer.append(markup->AssociatedNodeID);
+    buffer.push_back('\n');
+
+    if (buffer.size() >= blockSize)
       {
-      associatedNodeID = std::string("");
+      of.write(buffer.data(), buffer.size());
+      buffer.clear();
       }
-    of << "," << orientation[0] << "," << orientation[1] << "," << orientation[2] << "," << orientation[3];
-    of << "," << vis << "," << sel << "," << lock;
-    of << "," << label;
-    of << "," << desc;
-    of << "," << associatedNodeID;
-
-    of << endl;
     }
+  of.write(buffer.data(), buffer.size());
 
   of.close();
 
@@ -70,7 +70,10 @@ protected:
   /// Initialize all the supported write file types
   virtual void InitializeSupportedWriteFileTypes();
 
-  /// Read data and set it in the referenced node
+  /// Read data and set it in the referenced node.
+  /// The file is read at once and tokenized in place, the markups are then
+  /// added to the node in a single call.
+  /// \sa vtkMRMLMarkupsNode::AddMarkups
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
 
   /// Write data from a  referenced node.
@@ -499,6 +499,24 @@ int vtkMRMLMarkupsNode::AddMarkup(Markup markup)
   return markupIndex;
 }
 
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddMarkups(const std::vector<Markup>& markups)
+{
+  if (markups.empty())
+    {
+    return -1;
+    }
+  this->Markups.reserve(this->Markups.size() + markups.size());
+  this->Markups.insert(this->Markups.end(), markups.begin(), markups.end());
+  this->MaximumNumberOfMarkups += static_cast<int>(markups.size());
+
+  int markupIndex = this->GetNumberOfMarkups() - 1;
+
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupAddedEvent, (void*)&markupIndex);
+  return markupIndex;
+}
+
 //-----------------------------------------------------------
 #if (VTK_MAJOR_VERSION < 6)
 int vtkMRMLMarkupsNode::AddMarkupWithNPoints(int n)
@@ -175,6 +175,12 @@ public:
   /// Add a markup to the end of the list. Return index
   /// of new markup, -1 on failure.
   int AddMarkup(Markup markup);
+  /// Add a list of markups to the end of the list, with a single Modified
+  /// and MarkupAddedEvent for the whole list instead of one per markup.
+  /// Meant for loading large lists from file. Return index of the last
+  /// new markup, -1 if the list is empty.
+  /// \sa AddMarkup
+  int AddMarkups(const std::vector<Markup>& markups);
   /// Create a new markup with n points, init points to (0,0,0). Return index
   /// of new markup, -1 on failure.
 #if (VTK_MAJOR_VERSION >= 6)
@@ -945,11 +945,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
-  // this call will create a new handle and set it
-  int n = markupsNode->GetNumberOfMarkups() - 1;
-  this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
-
+  // these calls will create the new handles and set them, several markups
+  // may have been added at once (\sa vtkMRMLMarkupsNode::AddMarkups)
   vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+  for (int n = seedRepresentation->GetNumberOfSeeds(); n < markupsNode->GetNumberOfMarkups(); ++n)
+    {
+    this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
+    }
+
   seedRepresentation->NeedToRenderOn();
   seedWidget->Modified();
 }
@@ -0,0 +1,201 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLMarkupsDisplayNode.h"
+#include "vtkMRMLMarkupsFiducialStorageNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+void CountEvent(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+// Measure the throughput of writing and reading large fiducial lists.
+int vtkMRMLMarkupsFiducialStorageNodeTest4(int argc, char * argv[] )
+{
+  std::string fileName = std::string("testMarkupsFiducialStorageNodeThroughput.fcsv");
+  if (argc > 1)
+    {
+    fileName = std::string(argv[1]);
+    }
+  int numberOfMarkups = 100000;
+  if (argc > 2)
+    {
+    numberOfMarkups = atoi(argv[2]);
+    }
+  std::cout << "Using file name " << fileName.c_str()
+            << " with " << numberOfMarkups << " markups" << std::endl;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> storageNode;
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode;
+  scene->AddNode(storageNode.GetPointer());
+  scene->AddNode(markupsNode.GetPointer());
+  markupsNode->SetAndObserveStorageNodeID(storageNode->GetID());
+
+  int wasModifying = markupsNode->StartModify();
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    int index = markupsNode->AddMarkupWithNPoints(1);
+    markupsNode->SetMarkupPoint(index, 0, 0.5 * i, -0.25 * i, 1.0 + i);
+    }
+  markupsNode->SetNthMarkupLabel(0, "Label, with \"quotes\"");
+  markupsNode->EndModify(wasModifying);
+
+  vtkNew<vtkTimerLog> timer;
+
+  //
+  // write
+  //
+  storageNode->SetFileName(fileName.c_str());
+  timer->StartTimer();
+  if (!storageNode->WriteData(markupsNode.GetPointer()))
+    {
+    std::cerr << "Failed to write " << storageNode->GetFileName() << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLMarkupsFiducialStorageNode-WritePerformance-"
+            << numberOfMarkups << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  //
+  // read
+  //
+  vtkNew<vtkMRMLScene> scene2;
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> storageNode2;
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode2;
+  vtkNew<vtkMRMLMarkupsDisplayNode> displayNode2;
+  scene2->AddNode(storageNode2.GetPointer());
+  scene2->AddNode(markupsNode2.GetPointer());
+  scene2->AddNode(displayNode2.GetPointer());
+  markupsNode2->SetAndObserveStorageNodeID(storageNode2->GetID());
+  markupsNode2->SetAndObserveDisplayNodeID(displayNode2->GetID());
+  storageNode2->SetFileName(fileName.c_str());
+
+  int markupAddedEvents = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountEvent);
+  callback->SetClientData(&markupAddedEvents);
+  markupsNode2->AddObserver(vtkMRMLMarkupsNode::MarkupAddedEvent, callback.GetPointer());
+
+  timer->StartTimer();
+  if (!storageNode2->ReadData(markupsNode2.GetPointer()))
+    {
+    std::cerr << "Failed to read " << storageNode2->GetFileName() << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLMarkupsFiducialStorageNode-ReadPerformance-"
+            << numberOfMarkups << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  if (markupsNode2->GetNumberOfMarkups() != numberOfMarkups)
+    {
+    std::cerr << "Expected " << numberOfMarkups << " markups after reading, got "
+              << markupsNode2->GetNumberOfMarkups() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (numberOfMarkups > 0 && markupAddedEvents != 1)
+    {
+    std::cerr << "Expected a single MarkupAddedEvent when reading, got "
+              << markupAddedEvents << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    double point[3];
+    markupsNode2->GetMarkupPoint(i, 0, point);
+    double expected[3] = {0.5 * i, -0.25 * i, 1.0 + i};
+    for (int c = 0; c < 3; ++c)
+      {
+      // points are written with the default stream precision
+      if (fabs(point[c] - expected[c]) > 1e-5 * (1.0 + fabs(expected[c])))
+        {
+        std::cerr << "Markup " << i << ": expected coordinate " << c << " of "
+                  << expected[c] << ", got " << point[c] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    if (markupsNode2->GetNthMarkupID(i) != markupsNode->GetNthMarkupID(i) ||
+        markupsNode2->GetNthMarkupLabel(i) != markupsNode->GetNthMarkupLabel(i))
+      {
+      std::cerr << "Markup " << i << ": expected id/label "
+                << markupsNode->GetNthMarkupID(i) << "/"
+                << markupsNode->GetNthMarkupLabel(i) << ", got "
+                << markupsNode2->GetNthMarkupID(i) << "/"
+                << markupsNode2->GetNthMarkupLabel(i) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //
+  // read a legacy file outside of a scene, markup IDs must still be unique
+  //
+  std::string legacyFileName = fileName + ".legacy.fcsv";
+  std::ofstream legacyFile(legacyFileName.c_str());
+  legacyFile << "# Fiducial List file\n"
+             << "F-1,1.0,2.0,3.0,1,1\n"
+             << "F-2,4.0,5.0,6.0,1,1\n"
+             << ",7.0,8.0,9.0,0,1\n";
+  legacyFile.close();
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> legacyStorageNode;
+  vtkNew<vtkMRMLMarkupsFiducialNode> legacyMarkupsNode;
+  legacyStorageNode->SetFileName(legacyFileName.c_str());
+  if (!legacyStorageNode->ReadData(legacyMarkupsNode.GetPointer()) ||
+      legacyMarkupsNode->GetNumberOfMarkups() != 3)
+    {
+    std::cerr << "Failed to read " << legacyFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::set<std::string> legacyIDs;
+  for (int i = 0; i < legacyMarkupsNode->GetNumberOfMarkups(); ++i)
+    {
+    legacyIDs.insert(legacyMarkupsNode->GetNthMarkupID(i));
+    }
+  if (legacyIDs.size() != 3)
+    {
+    std::cerr << "Expected unique markup IDs outside of a scene, got "
+              << legacyMarkupsNode->GetNthMarkupID(0) << ", "
+              << legacyMarkupsNode->GetNthMarkupID(1) << ", "
+              << legacyMarkupsNode->GetNthMarkupID(2) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -2988,12 +2988,18 @@ void qSlicerMarkupsModuleWidget::onActiveMarkupsNodeMarkupAddedEvent()//vtkMRMLN
 
   //qDebug() << QString("active markups node id from combo box = ") + activeMarkupsNodeID;
 
-  int newRow = d->activeMarkupTableWidget->rowCount();
+  // several markups may have been added at once
+  vtkMRMLMarkupsNode *markupsNode = vtkMRMLMarkupsNode::SafeDownCast(
+    d->activeMarkupMRMLNodeComboBox->currentNode());
+  int firstNewRow = d->activeMarkupTableWidget->rowCount();
+  int newRowCount = markupsNode ? markupsNode->GetNumberOfMarkups() : firstNewRow + 1;
+  d->activeMarkupTableWidget->setRowCount(newRowCount);
+  int newRow = newRowCount - 1;
   //qDebug() << QString("\tnew row / row count = ") + QString::number(newRow);
-  d->activeMarkupTableWidget->insertRow(newRow);
-  //qDebug() << QString("\t after inserting a row, row count = ") + QString::number(d->activeMarkupTableWidget->rowCount());
-
-  this->updateRow(newRow);
+  for (int row = firstNewRow; row < newRowCount; ++row)
+    {
+    this->updateRow(row);
+    }
 
   // scroll to the new row only if jump slices is not selected
   // (if jump slices on click in table is selected, selecting the new
@@ -0,0 +1,341 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MultiVolumeRendering includes
+#include "vtkSlicerMultiVolumeRayCaster.h"
+
+// VTK includes
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkTimerLog.h>
+#include <vtkVersion.h>
+#include <vtkVolumeProperty.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// The rendering is headless: the ray caster writes into an image without
+// render window, the test can run on machines without OpenGL.
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Cube of \a size voxels with a ball of \a value in its center, the voxel
+// size is 1.
+void CreateBall(vtkImageData* image, int size, int scalarType, double value)
+{
+  image->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+#else
+  image->AllocateScalars(scalarType, 1);
+#endif
+  double center = (size - 1) / 2.;
+  double radius2 = (size / 4.) * (size / 4.);
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        double distance2 = (i - center) * (i - center) +
+          (j - center) * (j - center) + (k - center) * (k - center);
+        double scalar = (distance2 <= radius2) ? value : 0.;
+        if (scalarType == VTK_SHORT)
+          {
+          *static_cast<short*>(image->GetScalarPointer(i, j, k)) = static_cast<short>(scalar);
+          }
+        else
+          {
+          *static_cast<float*>(image->GetScalarPointer(i, j, k)) = static_cast<float>(scalar);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Property mapping \a value to \a color, 0 is transparent.
+void SetupProperty(vtkVolumeProperty* property, double value, double r, double g, double b)
+{
+  vtkNew<vtkPiecewiseFunction> opacity;
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(value / 2., 0.);
+  opacity->AddPoint(value, 0.2);
+  vtkNew<vtkColorTransferFunction> color;
+  color->AddRGBPoint(0., r, g, b);
+  color->AddRGBPoint(value, r, g, b);
+  property->SetScalarOpacity(opacity.GetPointer());
+  property->SetColor(color.GetPointer());
+  property->SetInterpolationTypeToLinear();
+}
+
+//----------------------------------------------------------------------------
+unsigned char* Pixel(vtkSlicerMultiVolumeRayCaster* rayCaster, int x, int y)
+{
+  return static_cast<unsigned char*>(rayCaster->GetOutput()->GetScalarPointer(x, y, 0));
+}
+
+//----------------------------------------------------------------------------
+int MaximumDifference(vtkImageData* image1, vtkImageData* image2)
+{
+  int* dimensions = image1->GetDimensions();
+  const unsigned char* pixels1 = static_cast<unsigned char*>(image1->GetScalarPointer());
+  const unsigned char* pixels2 = static_cast<unsigned char*>(image2->GetScalarPointer());
+  int difference = 0;
+  for (int i = 0; i < dimensions[0] * dimensions[1] * 4; ++i)
+    {
+    difference = std::max(difference, abs(pixels1[i] - pixels2[i]));
+    }
+  return difference;
+}
+
+//----------------------------------------------------------------------------
+void SetupCamera(vtkCamera* camera, double center, double scale)
+{
+  camera->ParallelProjectionOn();
+  camera->SetParallelScale(scale);
+  camera->SetFocalPoint(center, center, center);
+  camera->SetPosition(center, center, center + 1000.);
+  camera->SetViewUp(0., 1., 0.);
+  camera->SetClippingRange(500., 1500.);
+}
+
+//----------------------------------------------------------------------------
+bool TestCompositing()
+{
+  // A red ball and a green ball moved 8mm along X, they overlap
+  vtkNew<vtkImageData> redImage;
+  CreateBall(redImage.GetPointer(), 32, VTK_SHORT, 1000.);
+  vtkNew<vtkVolumeProperty> redProperty;
+  SetupProperty(redProperty.GetPointer(), 1000., 1., 0., 0.);
+
+  vtkNew<vtkImageData> greenImage;
+  CreateBall(greenImage.GetPointer(), 32, VTK_FLOAT, 5.);
+  vtkNew<vtkVolumeProperty> greenProperty;
+  SetupProperty(greenProperty.GetPointer(), 5., 0., 1., 0.);
+  vtkNew<vtkMatrix4x4> greenIJKToWorld;
+  greenIJKToWorld->SetElement(0, 3, 8.);
+
+  vtkNew<vtkCamera> camera;
+  // 1 pixel per mm, the world origin is at the pixel (16, 16)
+  SetupCamera(camera.GetPointer(), 15.5, 32.);
+
+  vtkNew<vtkSlicerMultiVolumeRayCaster> rayCaster;
+  rayCaster->SetCamera(camera.GetPointer());
+  rayCaster->SetImageSize(64, 64);
+  rayCaster->SetBackground(0., 0., 1.);
+  rayCaster->AddVolume(redImage.GetPointer(), redProperty.GetPointer());
+  rayCaster->AddVolume(greenImage.GetPointer(), greenProperty.GetPointer(),
+                       greenIJKToWorld.GetPointer());
+  rayCaster->Render();
+
+  // Only the background
+  unsigned char* corner = Pixel(rayCaster.GetPointer(), 0, 0);
+  if (corner[0] != 0 || corner[1] != 0 || corner[2] != 255 || corner[3] != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong background: "
+              << int(corner[0]) << " " << int(corner[1]) << " "
+              << int(corner[2]) << " " << int(corner[3]) << std::endl;
+    return false;
+    }
+  // Only the red ball
+  unsigned char* red = Pixel(rayCaster.GetPointer(), 26, 32);
+  // Red and green balls overlap
+  unsigned char* mixed = Pixel(rayCaster.GetPointer(), 36, 32);
+  // Only the green ball
+  unsigned char* green = Pixel(rayCaster.GetPointer(), 44, 32);
+  if (red[3] < 128 || red[0] < 128 || red[1] != 0 ||
+      green[3] < 128 || green[1] < 128 || green[0] != 0 ||
+      mixed[3] <= red[3] || mixed[0] < 32 || mixed[1] < 32)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong compositing: red "
+              << int(red[0]) << " " << int(red[1]) << " " << int(red[2]) << " " << int(red[3])
+              << ", mixed " << int(mixed[0]) << " " << int(mixed[1]) << " " << int(mixed[2])
+              << " " << int(mixed[3])
+              << ", green " << int(green[0]) << " " << int(green[1]) << " " << int(green[2])
+              << " " << int(green[3]) << std::endl;
+    return false;
+    }
+
+  // Skipping the empty space does not change the image
+  vtkNew<vtkImageData> skippedImage;
+  skippedImage->DeepCopy(rayCaster->GetOutput());
+  vtkTypeInt64 skippedSamples = rayCaster->GetNumberOfInterpolatedSamples();
+  rayCaster->EmptySpaceSkippingOff();
+  rayCaster->Render();
+  if (MaximumDifference(skippedImage.GetPointer(), rayCaster->GetOutput()) > 2 ||
+      skippedSamples >= rayCaster->GetNumberOfInterpolatedSamples())
+    {
+    std::cerr << "Line " << __LINE__ << " - Empty space skipping changed the image or "
+              << "did not skip samples: " << skippedSamples << " samples instead of "
+              << rayCaster->GetNumberOfInterpolatedSamples() << std::endl;
+    return false;
+    }
+
+  // The image does not depend on the number of threads
+  rayCaster->SetNumberOfThreads(1);
+  rayCaster->Render();
+  vtkNew<vtkImageData> singleThreadImage;
+  singleThreadImage->DeepCopy(rayCaster->GetOutput());
+  rayCaster->SetNumberOfThreads(4);
+  rayCaster->Render();
+  if (MaximumDifference(singleThreadImage.GetPointer(), rayCaster->GetOutput()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Image depends on the number of threads" << std::endl;
+    return false;
+    }
+
+  // Moving the green volume updates the image
+  greenIJKToWorld->SetElement(0, 3, 100.);
+  rayCaster->SetVolumeIJKToWorldMatrix(1, greenIJKToWorld.GetPointer());
+  rayCaster->Render();
+  green = Pixel(rayCaster.GetPointer(), 44, 32);
+  if (green[3] != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Moved volume is still rendered" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestLabels()
+{
+  // Two neighbor labels, 5000 in the left half and 5001 in the right half,
+  // behind a slice of background label. Quantized on 16 bits, they would
+  // share the same table entry.
+  vtkNew<vtkImageData> labelImage;
+  labelImage->SetDimensions(16, 16, 16);
+#if (VTK_MAJOR_VERSION <= 5)
+  labelImage->SetScalarType(VTK_SHORT);
+  labelImage->SetNumberOfScalarComponents(1);
+  labelImage->AllocateScalars();
+#else
+  labelImage->AllocateScalars(VTK_SHORT, 1);
+#endif
+  for (int k = 0; k < 16; ++k)
+    {
+    for (int j = 0; j < 16; ++j)
+      {
+      for (int i = 0; i < 16; ++i)
+        {
+        *static_cast<short*>(labelImage->GetScalarPointer(i, j, k)) =
+          (k == 0) ? 0 : (i < 8 ? 5000 : 5001);
+        }
+      }
+    }
+  vtkNew<vtkPiecewiseFunction> opacity;
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(1., 1.);
+  opacity->AddPoint(5001., 1.);
+  vtkNew<vtkColorTransferFunction> color;
+  color->AddRGBPoint(0., 0., 0., 0.);
+  color->AddRGBPoint(5000., 1., 0., 0.);
+  color->AddRGBPoint(5001., 0., 1., 0.);
+  vtkNew<vtkVolumeProperty> labelProperty;
+  labelProperty->SetScalarOpacity(opacity.GetPointer());
+  labelProperty->SetColor(color.GetPointer());
+  labelProperty->SetInterpolationTypeToNearest();
+
+  vtkNew<vtkCamera> camera;
+  // 1 pixel per mm, the world origin is at the pixel (8, 8)
+  SetupCamera(camera.GetPointer(), 7.5, 16.);
+
+  vtkNew<vtkSlicerMultiVolumeRayCaster> rayCaster;
+  rayCaster->SetCamera(camera.GetPointer());
+  rayCaster->SetImageSize(32, 32);
+  rayCaster->AddVolume(labelImage.GetPointer(), labelProperty.GetPointer());
+  rayCaster->Render();
+
+  unsigned char* left = Pixel(rayCaster.GetPointer(), 12, 16);
+  unsigned char* right = Pixel(rayCaster.GetPointer(), 20, 16);
+  if (left[3] < 250 || left[0] < 250 || left[1] != 0 ||
+      right[3] < 250 || right[1] < 250 || right[0] != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Wrong label colors: left "
+              << int(left[0]) << " " << int(left[1]) << " " << int(left[2]) << " " << int(left[3])
+              << ", right " << int(right[0]) << " " << int(right[1]) << " " << int(right[2])
+              << " " << int(right[3]) << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestBenchmark(int volumeSize, int imageSize)
+{
+  vtkNew<vtkImageData> ctImage;
+  CreateBall(ctImage.GetPointer(), volumeSize, VTK_SHORT, 1000.);
+  vtkNew<vtkVolumeProperty> ctProperty;
+  SetupProperty(ctProperty.GetPointer(), 1000., 1., 1., 1.);
+  vtkNew<vtkImageData> petImage;
+  CreateBall(petImage.GetPointer(), volumeSize / 2, VTK_FLOAT, 10.);
+  petImage->SetSpacing(2., 2., 2.);
+  vtkNew<vtkVolumeProperty> petProperty;
+  SetupProperty(petProperty.GetPointer(), 10., 1., 1., 0.);
+
+  vtkNew<vtkCamera> camera;
+  SetupCamera(camera.GetPointer(), volumeSize / 2., volumeSize);
+
+  vtkNew<vtkSlicerMultiVolumeRayCaster> rayCaster;
+  rayCaster->SetCamera(camera.GetPointer());
+  rayCaster->SetImageSize(imageSize, imageSize);
+  rayCaster->AddVolume(ctImage.GetPointer(), ctProperty.GetPointer());
+  rayCaster->AddVolume(petImage.GetPointer(), petProperty.GetPointer());
+  // Build the quantized scalars and the min/max volumes
+  rayCaster->Render();
+
+  vtkNew<vtkTimerLog> timer;
+  for (int skipping = 1; skipping >= 0; --skipping)
+    {
+    rayCaster->SetEmptySpaceSkipping(skipping != 0);
+    timer->StartTimer();
+    rayCaster->Render();
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"vtkSlicerMultiVolumeRayCaster-Render-"
+              << (skipping ? "" : "NoSkipping-") << volumeSize << "-" << imageSize
+              << "\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+    std::cout << "<DartMeasurement name=\"vtkSlicerMultiVolumeRayCaster-Samples-"
+              << (skipping ? "" : "NoSkipping-") << volumeSize << "-" << imageSize
+              << "\" type=\"numeric/integer\">"
+              << rayCaster->GetNumberOfInterpolatedSamples() << "</DartMeasurement>" << std::endl;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerMultiVolumeRayCasterTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  bool res = true;
+  res = res && TestCompositing();
+  res = res && TestLabels();
+  res = res && TestBenchmark(128, 256);
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,765 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MultiVolumeRendering includes
+#include "vtkSlicerMultiVolumeRayCaster.h"
+
+// VTK includes
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkVersion.h>
+#include <vtkVolumeProperty.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+/// Number of entries of the transfer function tables of the interpolated
+/// volumes. The scalars are quantized on 16 bits, the table index is the
+/// quantized scalar >> 4. Label maps have one entry per label instead.
+const int QuantizedTableSize = 4096;
+const int QuantizedTableShift = 4;
+
+/// Number of cells along each axis of a min/max volume element.
+const int MinMaxCellSize = 4;
+
+/// Rays stop once their opacity reaches this value.
+const float OpacityTermination = 0.99f;
+
+//----------------------------------------------------------------------------
+template <class T>
+void QuantizeScalars(T* scalars, vtkIdType numberOfVoxels, int numberOfComponents,
+                     double minimum, double scale, unsigned short* quantized)
+{
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i, scalars += numberOfComponents)
+    {
+    double value = (static_cast<double>(*scalars) - minimum) * scale;
+    quantized[i] = static_cast<unsigned short>(
+      std::max(0., std::min(65535., value + 0.5)));
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkSlicerMultiVolumeRayCaster::vtkInternal
+{
+public:
+  struct Volume
+    {
+    Volume();
+
+    /// Quantize the scalars and build the min/max volume if the image or
+    /// the interpolation type changed.
+    void UpdateScalars();
+    /// Update the transfer function tables and the empty cell flags if
+    /// the property or the sample distance changed.
+    void UpdateTables(double sampleDistance);
+    /// Compute the world to IJK transform.
+    void UpdateTransform();
+
+    /// Index of the min/max element containing the continuous index.
+    int MinMaxIndex(const double ijk[3], int block[3])const;
+
+    vtkSmartPointer<vtkImageData> Image;
+    vtkSmartPointer<vtkVolumeProperty> Property;
+    vtkSmartPointer<vtkMatrix4x4> IJKToWorld;
+    double WorldToIJK[16];
+    /// Smallest distance in world between two voxels.
+    double VoxelSize;
+    bool NearestInterpolation;
+
+    int Dimensions[3];
+    std::vector<unsigned short> Scalars;
+    double ScalarMinimum;
+    /// Scale from the scalar range to the quantized range [0, 65535].
+    double ScalarScale;
+    unsigned long ScalarsMTime;
+    vtkImageData* ScalarsImage;
+    /// True if the scalars are labels: integers sampled with the nearest
+    /// interpolation. They are then stored as the offset from the minimum
+    /// label and the tables have one entry per label.
+    bool Labels;
+    /// Number of entries of the tables and shift from a quantized scalar to
+    /// its entry.
+    int TableSize;
+    int TableShift;
+
+    int MinMaxSize[3];
+    std::vector<unsigned short> Minimums;
+    std::vector<unsigned short> Maximums;
+    /// Non zero if some voxel of the element is not transparent.
+    std::vector<unsigned char> Visible;
+
+    std::vector<float> Colors;
+    std::vector<float> Opacities;
+    unsigned long TablesMTime;
+    double TablesSampleDistance;
+    };
+
+  vtkInternal();
+
+  std::vector<Volume> Volumes;
+  vtkSmartPointer<vtkImageData> Output;
+  vtkNew<vtkMultiThreader> Threader;
+  std::vector<vtkTypeInt64> InterpolatedSamples;
+
+  /// Normalized device coordinates to world transform of the camera.
+  double ViewToWorld[16];
+  double RenderSampleDistance;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerMultiVolumeRayCaster::vtkInternal::vtkInternal()
+{
+  this->RenderSampleDistance = 1.;
+  vtkMatrix4x4::Identity(this->ViewToWorld);
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerMultiVolumeRayCaster::vtkInternal::Volume::Volume()
+{
+  vtkMatrix4x4::Identity(this->WorldToIJK);
+  this->VoxelSize = 1.;
+  this->NearestInterpolation = false;
+  this->Dimensions[0] = this->Dimensions[1] = this->Dimensions[2] = 0;
+  this->ScalarMinimum = 0.;
+  this->ScalarScale = 0.;
+  this->ScalarsMTime = 0;
+  this->ScalarsImage = 0;
+  this->Labels = false;
+  this->TableSize = QuantizedTableSize;
+  this->TableShift = QuantizedTableShift;
+  this->MinMaxSize[0] = this->MinMaxSize[1] = this->MinMaxSize[2] = 0;
+  this->TablesMTime = 0;
+  this->TablesSampleDistance = 0.;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::vtkInternal::Volume::UpdateScalars()
+{
+  this->NearestInterpolation =
+    (this->Property->GetInterpolationType() == VTK_NEAREST_INTERPOLATION);
+  vtkDataArray* scalars = this->Image->GetPointData()->GetScalars();
+  double range[2] = {0., 0.};
+  if (scalars)
+    {
+    scalars->GetRange(range, 0);
+    }
+  // Labels are looked up exactly: quantizing them would merge neighbor
+  // labels into the same table entry.
+  bool labels = this->NearestInterpolation && scalars &&
+    scalars->GetDataType() != VTK_FLOAT && scalars->GetDataType() != VTK_DOUBLE &&
+    range[1] - range[0] < 65536.;
+  if (this->ScalarsImage == this->Image.GetPointer() &&
+      this->ScalarsMTime >= this->Image->GetMTime() &&
+      this->Labels == labels)
+    {
+    return;
+    }
+  this->ScalarsImage = this->Image;
+  this->ScalarsMTime = this->Image->GetMTime();
+  this->Labels = labels;
+  // Force the update of the tables and of the visibility of the min/max
+  // elements
+  this->TablesMTime = 0;
+
+  this->Image->GetDimensions(this->Dimensions);
+  vtkIdType numberOfVoxels = scalars ? this->Image->GetNumberOfPoints() : 0;
+  this->Scalars.resize(numberOfVoxels);
+  if (numberOfVoxels == 0)
+    {
+    this->Dimensions[0] = this->Dimensions[1] = this->Dimensions[2] = 0;
+    this->MinMaxSize[0] = this->MinMaxSize[1] = this->MinMaxSize[2] = 0;
+    return;
+    }
+
+  this->ScalarMinimum = range[0];
+  if (this->Labels)
+    {
+    this->ScalarScale = 1.;
+    this->TableSize = static_cast<int>(range[1] - range[0]) + 1;
+    this->TableShift = 0;
+    }
+  else
+    {
+    this->ScalarScale = (range[1] > range[0]) ? 65535. / (range[1] - range[0]) : 0.;
+    this->TableSize = QuantizedTableSize;
+    this->TableShift = QuantizedTableShift;
+    }
+  switch (scalars->GetDataType())
+    {
+    vtkTemplateMacro(QuantizeScalars(
+      static_cast<VTK_TT*>(scalars->GetVoidPointer(0)), numberOfVoxels,
+      scalars->GetNumberOfComponents(), this->ScalarMinimum, this->ScalarScale,
+      &this->Scalars[0]));
+    }
+
+  // Like in the fixed point ray cast mapper, an element of the min/max
+  // volume groups 4 cells (5 samples) along each axis.
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    this->MinMaxSize[axis] = (this->Dimensions[axis] < 2) ?
+      1 : 1 + (this->Dimensions[axis] - 2) / MinMaxCellSize;
+    }
+  int numberOfElements = this->MinMaxSize[0] * this->MinMaxSize[1] * this->MinMaxSize[2];
+  this->Minimums.assign(numberOfElements, 0xffff);
+  this->Maximums.assign(numberOfElements, 0);
+  this->Visible.assign(numberOfElements, 1);
+
+  const unsigned short* quantized = &this->Scalars[0];
+  for (int k = 0; k < this->Dimensions[2]; ++k)
+    {
+    // A sample on the border of two elements belongs to both
+    int zStart = (k > 0) ? (k - 1) / MinMaxCellSize : 0;
+    int zEnd = std::min(k / MinMaxCellSize, this->MinMaxSize[2] - 1);
+    for (int j = 0; j < this->Dimensions[1]; ++j)
+      {
+      int yStart = (j > 0) ? (j - 1) / MinMaxCellSize : 0;
+      int yEnd = std::min(j / MinMaxCellSize, this->MinMaxSize[1] - 1);
+      for (int i = 0; i < this->Dimensions[0]; ++i, ++quantized)
+        {
+        int xStart = (i > 0) ? (i - 1) / MinMaxCellSize : 0;
+        int xEnd = std::min(i / MinMaxCellSize, this->MinMaxSize[0] - 1);
+        for (int z = zStart; z <= zEnd; ++z)
+          {
+          for (int y = yStart; y <= yEnd; ++y)
+            {
+            for (int x = xStart; x <= xEnd; ++x)
+              {
+              int element = (z * this->MinMaxSize[1] + y) * this->MinMaxSize[0] + x;
+              this->Minimums[element] = std::min(this->Minimums[element], *quantized);
+              this->Maximums[element] = std::max(this->Maximums[element], *quantized);
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::vtkInternal::Volume::UpdateTables(double sampleDistance)
+{
+  if (this->TablesMTime >= this->Property->GetMTime() &&
+      this->TablesSampleDistance == sampleDistance)
+    {
+    return;
+    }
+  this->TablesMTime = this->Property->GetMTime();
+  this->TablesSampleDistance = sampleDistance;
+
+  this->Colors.resize(3 * this->TableSize);
+  this->Opacities.resize(this->TableSize);
+  vtkPiecewiseFunction* scalarOpacity = this->Property->GetScalarOpacity(0);
+  vtkColorTransferFunction* color = this->Property->GetRGBTransferFunction(0);
+  vtkPiecewiseFunction* gray = this->Property->GetGrayTransferFunction(0);
+  bool isGray = (this->Property->GetColorChannels(0) == 1);
+  double unitDistance = this->Property->GetScalarOpacityUnitDistance(0);
+  double opacityExponent = (unitDistance > 0.) ? sampleDistance / unitDistance : 1.;
+  for (int i = 0; i < this->TableSize; ++i)
+    {
+    // Label of the entry, or scalar at the center of the range of quantized
+    // values of the entry
+    double value = this->ScalarMinimum;
+    if (this->Labels)
+      {
+      value += i;
+      }
+    else if (this->ScalarScale > 0.)
+      {
+      value += ((i << this->TableShift) + (1 << (this->TableShift - 1))) / this->ScalarScale;
+      }
+    double rgb[3] = {1., 1., 1.};
+    if (isGray)
+      {
+      rgb[0] = rgb[1] = rgb[2] = gray->GetValue(value);
+      }
+    else
+      {
+      color->GetColor(value, rgb);
+      }
+    this->Colors[3 * i] = static_cast<float>(rgb[0]);
+    this->Colors[3 * i + 1] = static_cast<float>(rgb[1]);
+    this->Colors[3 * i + 2] = static_cast<float>(rgb[2]);
+    // Correct the opacity for the sample distance
+    double opacity = std::max(0., std::min(1., scalarOpacity->GetValue(value)));
+    this->Opacities[i] = static_cast<float>(1. - pow(1. - opacity, opacityExponent));
+    }
+
+  if (this->Scalars.empty())
+    {
+    return;
+    }
+  // Number of visible entries before each entry to know in constant time
+  // whether a range of scalars is transparent.
+  std::vector<int> visibleEntries(this->TableSize + 1, 0);
+  for (int i = 0; i < this->TableSize; ++i)
+    {
+    visibleEntries[i + 1] = visibleEntries[i] + (this->Opacities[i] > 0.f ? 1 : 0);
+    }
+  for (size_t element = 0; element < this->Visible.size(); ++element)
+    {
+    int first = std::min(this->TableSize - 1, this->Minimums[element] >> this->TableShift);
+    int last = std::min(this->TableSize - 1, this->Maximums[element] >> this->TableShift);
+    this->Visible[element] = (visibleEntries[last + 1] - visibleEntries[first]) > 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::vtkInternal::Volume::UpdateTransform()
+{
+  vtkNew<vtkMatrix4x4> ijkToWorld;
+  if (this->IJKToWorld.GetPointer())
+    {
+    ijkToWorld->DeepCopy(this->IJKToWorld);
+    }
+  else
+    {
+    double origin[3];
+    double spacing[3];
+    this->Image->GetOrigin(origin);
+    this->Image->GetSpacing(spacing);
+    for (int i = 0; i < 3; ++i)
+      {
+      ijkToWorld->SetElement(i, i, spacing[i]);
+      ijkToWorld->SetElement(i, 3, origin[i]);
+      }
+    }
+  this->VoxelSize = VTK_DOUBLE_MAX;
+  for (int column = 0; column < 3; ++column)
+    {
+    double axis[3] = {ijkToWorld->GetElement(0, column),
+                      ijkToWorld->GetElement(1, column),
+                      ijkToWorld->GetElement(2, column)};
+    this->VoxelSize = std::min(this->VoxelSize,
+      sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]));
+    }
+  vtkMatrix4x4::Invert(*ijkToWorld->Element, this->WorldToIJK);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerMultiVolumeRayCaster::vtkInternal::Volume
+::MinMaxIndex(const double ijk[3], int block[3])const
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    block[axis] = std::max(0, std::min(this->MinMaxSize[axis] - 1,
+      static_cast<int>(ijk[axis]) / MinMaxCellSize));
+    }
+  return (block[2] * this->MinMaxSize[1] + block[1]) * this->MinMaxSize[0] + block[0];
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerMultiVolumeRayCaster);
+vtkCxxSetObjectMacro(vtkSlicerMultiVolumeRayCaster, Camera, vtkCamera);
+
+//----------------------------------------------------------------------------
+vtkSlicerMultiVolumeRayCaster::vtkSlicerMultiVolumeRayCaster()
+{
+  this->Camera = 0;
+  this->ImageSize[0] = 256;
+  this->ImageSize[1] = 256;
+  this->SampleDistance = 0.;
+  this->Background[0] = this->Background[1] = this->Background[2] = 0.;
+  this->EmptySpaceSkipping = true;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->NumberOfInterpolatedSamples = 0;
+  this->Internal = new vtkInternal;
+  this->Internal->Output = vtkSmartPointer<vtkImageData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerMultiVolumeRayCaster::~vtkSlicerMultiVolumeRayCaster()
+{
+  this->SetCamera(0);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfVolumes: " << this->GetNumberOfVolumes() << "\n";
+  os << indent << "ImageSize: " << this->ImageSize[0] << " " << this->ImageSize[1] << "\n";
+  os << indent << "SampleDistance: " << this->SampleDistance << "\n";
+  os << indent << "Background: " << this->Background[0] << " "
+     << this->Background[1] << " " << this->Background[2] << "\n";
+  os << indent << "EmptySpaceSkipping: " << this->EmptySpaceSkipping << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfInterpolatedSamples: " << this->NumberOfInterpolatedSamples << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerMultiVolumeRayCaster::AddVolume(vtkImageData* image,
+                                             vtkVolumeProperty* property,
+                                             vtkMatrix4x4* ijkToWorld)
+{
+  if (!image || !property)
+    {
+    vtkErrorMacro("AddVolume: an image and a property are required");
+    return -1;
+    }
+  vtkInternal::Volume volume;
+  volume.Image = image;
+  volume.Property = property;
+  this->Internal->Volumes.push_back(volume);
+  int index = static_cast<int>(this->Internal->Volumes.size()) - 1;
+  this->SetVolumeIJKToWorldMatrix(index, ijkToWorld);
+  return index;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::RemoveAllVolumes()
+{
+  if (this->Internal->Volumes.empty())
+    {
+    return;
+    }
+  this->Internal->Volumes.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerMultiVolumeRayCaster::GetNumberOfVolumes()
+{
+  return static_cast<int>(this->Internal->Volumes.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::SetVolumeIJKToWorldMatrix(int index, vtkMatrix4x4* ijkToWorld)
+{
+  if (index < 0 || index >= this->GetNumberOfVolumes())
+    {
+    vtkErrorMacro("SetVolumeIJKToWorldMatrix: invalid volume index " << index);
+    return;
+    }
+  vtkInternal::Volume& volume = this->Internal->Volumes[index];
+  // Keep a copy, the matrix is read by the rendering threads
+  volume.IJKToWorld = 0;
+  if (ijkToWorld)
+    {
+    volume.IJKToWorld = vtkSmartPointer<vtkMatrix4x4>::New();
+    volume.IJKToWorld->DeepCopy(ijkToWorld);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerMultiVolumeRayCaster::GetOutput()
+{
+  return this->Internal->Output;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::Render()
+{
+  vtkImageData* output = this->Internal->Output;
+  output->SetDimensions(this->ImageSize[0], this->ImageSize[1], 1);
+#if (VTK_MAJOR_VERSION <= 5)
+  // The output can be the input of a pipeline
+  output->SetWholeExtent(output->GetExtent());
+  output->SetScalarTypeToUnsignedChar();
+  output->SetNumberOfScalarComponents(4);
+  output->AllocateScalars();
+#else
+  output->AllocateScalars(VTK_UNSIGNED_CHAR, 4);
+#endif
+  this->NumberOfInterpolatedSamples = 0;
+  if (!this->Camera)
+    {
+    vtkErrorMacro("Render: no camera");
+    return;
+    }
+
+  double sampleDistance = this->SampleDistance;
+  std::vector<vtkInternal::Volume>::iterator volumeIt;
+  for (volumeIt = this->Internal->Volumes.begin();
+       volumeIt != this->Internal->Volumes.end(); ++volumeIt)
+    {
+    volumeIt->UpdateScalars();
+    volumeIt->UpdateTransform();
+    if (this->SampleDistance <= 0.)
+      {
+      sampleDistance = (volumeIt == this->Internal->Volumes.begin()) ?
+        volumeIt->VoxelSize / 2. : std::min(sampleDistance, volumeIt->VoxelSize / 2.);
+      }
+    }
+  if (sampleDistance <= 0.)
+    {
+    sampleDistance = 1.;
+    }
+  for (volumeIt = this->Internal->Volumes.begin();
+       volumeIt != this->Internal->Volumes.end(); ++volumeIt)
+    {
+    volumeIt->UpdateTables(sampleDistance);
+    }
+  this->Internal->RenderSampleDistance = sampleDistance;
+
+  double aspect = static_cast<double>(this->ImageSize[0]) / std::max(1, this->ImageSize[1]);
+  vtkMatrix4x4* worldToView =
+    this->Camera->GetCompositeProjectionTransformMatrix(aspect, -1., 1.);
+  vtkMatrix4x4::Invert(*worldToView->Element, this->Internal->ViewToWorld);
+
+  int numberOfThreads = std::max(1, std::min(this->NumberOfThreads, this->ImageSize[1]));
+  this->Internal->InterpolatedSamples.assign(numberOfThreads, 0);
+  this->Internal->Threader->SetNumberOfThreads(numberOfThreads);
+  this->Internal->Threader->SetSingleMethod(
+    vtkSlicerMultiVolumeRayCaster::CastRaysThreadedMethod, this);
+  this->Internal->Threader->SingleMethodExecute();
+
+  for (int i = 0; i < numberOfThreads; ++i)
+    {
+    this->NumberOfInterpolatedSamples += this->Internal->InterpolatedSamples[i];
+    }
+  output->Modified();
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSlicerMultiVolumeRayCaster::CastRaysThreadedMethod(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkSlicerMultiVolumeRayCaster* self =
+    static_cast<vtkSlicerMultiVolumeRayCaster*>(info->UserData);
+  self->CastRays(info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRayCaster::CastRays(int threadId, int numberOfThreads)
+{
+  const int numberOfVolumes = this->GetNumberOfVolumes();
+  const int width = this->ImageSize[0];
+  const int height = this->ImageSize[1];
+  const double* viewToWorld = this->Internal->ViewToWorld;
+  vtkTypeInt64 interpolatedSamples = 0;
+
+  // Ray in the IJK coordinates of each volume: ijk = origin + t * direction
+  // with t in [enter, exit]
+  std::vector<double> rayOrigins(3 * numberOfVolumes);
+  std::vector<double> rayDirections(3 * numberOfVolumes);
+  std::vector<double> rayEnters(numberOfVolumes);
+  std::vector<double> rayExits(numberOfVolumes);
+
+  // Rows are interleaved between the threads to balance the load
+  for (int y = threadId; y < height; y += numberOfThreads)
+    {
+    unsigned char* pixel = static_cast<unsigned char*>(
+      this->Internal->Output->GetScalarPointer(0, y, 0));
+    for (int x = 0; x < width; ++x, pixel += 4)
+      {
+      // Ray from the near to the far clipping plane
+      double rayPoints[2][3];
+      for (int p = 0; p < 2; ++p)
+        {
+        double view[4] = {2. * (x + 0.5) / width - 1., 2. * (y + 0.5) / height - 1.,
+                          p == 0 ? -1. : 1., 1.};
+        double world[4];
+        vtkMatrix4x4::MultiplyPoint(viewToWorld, view, world);
+        for (int i = 0; i < 3; ++i)
+          {
+          rayPoints[p][i] = world[i] / world[3];
+          }
+        }
+      double rayLength = sqrt(vtkMath::Distance2BetweenPoints(rayPoints[0], rayPoints[1]));
+      double step = (rayLength > 0.) ? this->Internal->RenderSampleDistance / rayLength : 1.;
+
+      double rayStart = VTK_DOUBLE_MAX;
+      double rayEnd = -VTK_DOUBLE_MAX;
+      for (int v = 0; v < numberOfVolumes; ++v)
+        {
+        const vtkInternal::Volume& volume = this->Internal->Volumes[v];
+        double ijk[2][4];
+        for (int p = 0; p < 2; ++p)
+          {
+          double world[4] = {rayPoints[p][0], rayPoints[p][1], rayPoints[p][2], 1.};
+          vtkMatrix4x4::MultiplyPoint(volume.WorldToIJK, world, ijk[p]);
+          }
+        double enter = 0.;
+        double exit = 1.;
+        for (int i = 0; i < 3; ++i)
+          {
+          double origin = ijk[0][i];
+          double direction = ijk[1][i] - ijk[0][i];
+          rayOrigins[3 * v + i] = origin;
+          rayDirections[3 * v + i] = direction;
+          double upper = volume.Dimensions[i] - 1.;
+          if (fabs(direction) < 1e-12)
+            {
+            if (origin < 0. || origin > upper)
+              {
+              exit = -1.;
+              }
+            continue;
+            }
+          double t0 = (0. - origin) / direction;
+          double t1 = (upper - origin) / direction;
+          enter = std::max(enter, std::min(t0, t1));
+          exit = std::min(exit, std::max(t0, t1));
+          }
+        if (volume.Dimensions[0] == 0)
+          {
+          exit = -1.;
+          }
+        rayEnters[v] = enter;
+        rayExits[v] = exit;
+        if (enter <= exit)
+          {
+          rayStart = std::min(rayStart, enter);
+          rayEnd = std::max(rayEnd, exit);
+          }
+        }
+
+      float color[3] = {0.f, 0.f, 0.f};
+      float opacity = 0.f;
+      for (double t = rayStart; t <= rayEnd && opacity < OpacityTermination; )
+        {
+        float sampleTransparency = 1.f;
+        float sampleWeight = 0.f;
+        float sampleColor[3] = {0.f, 0.f, 0.f};
+        bool empty = true;
+        // Number of steps that can be skipped because all volumes are
+        // transparent or not crossed by the ray
+        double skippedSteps = VTK_DOUBLE_MAX;
+        for (int v = 0; v < numberOfVolumes; ++v)
+          {
+          if (t < rayEnters[v] || t > rayExits[v])
+            {
+            if (t < rayEnters[v] && rayEnters[v] <= rayExits[v])
+              {
+              skippedSteps = std::min(skippedSteps, (rayEnters[v] - t) / step);
+              }
+            continue;
+            }
+          const vtkInternal::Volume& volume = this->Internal->Volumes[v];
+          const double* origin = &rayOrigins[3 * v];
+          const double* direction = &rayDirections[3 * v];
+          double ijk[3];
+          for (int i = 0; i < 3; ++i)
+            {
+            ijk[i] = std::max(0., std::min(volume.Dimensions[i] - 1., origin[i] + t * direction[i]));
+            }
+          int block[3];
+          int element = volume.MinMaxIndex(ijk, block);
+          if (this->EmptySpaceSkipping && !volume.Visible[element])
+            {
+            // Steps until the ray leaves the element
+            for (int i = 0; i < 3; ++i)
+              {
+              double stepLength = direction[i] * step;
+              if (stepLength > 1e-12)
+                {
+                skippedSteps = std::min(skippedSteps,
+                  (MinMaxCellSize * (block[i] + 1) - ijk[i]) / stepLength);
+                }
+              else if (stepLength < -1e-12)
+                {
+                skippedSteps = std::min(skippedSteps,
+                  (ijk[i] - MinMaxCellSize * block[i]) / -stepLength);
+                }
+              }
+            continue;
+            }
+          empty = false;
+
+          float scalar;
+          const int* dimensions = volume.Dimensions;
+          const unsigned short* scalars = &volume.Scalars[0];
+          if (volume.NearestInterpolation)
+            {
+            int i = static_cast<int>(ijk[0] + 0.5);
+            int j = static_cast<int>(ijk[1] + 0.5);
+            int k = static_cast<int>(ijk[2] + 0.5);
+            scalar = scalars[(k * dimensions[1] + j) * dimensions[0] + i];
+            }
+          else
+            {
+            int i0 = static_cast<int>(ijk[0]);
+            int j0 = static_cast<int>(ijk[1]);
+            int k0 = static_cast<int>(ijk[2]);
+            float fx = static_cast<float>(ijk[0] - i0);
+            float fy = static_cast<float>(ijk[1] - j0);
+            float fz = static_cast<float>(ijk[2] - k0);
+            int di = (i0 < dimensions[0] - 1) ? 1 : 0;
+            int dj = (j0 < dimensions[1] - 1) ? dimensions[0] : 0;
+            int dk = (k0 < dimensions[2] - 1) ? dimensions[0] * dimensions[1] : 0;
+            const unsigned short* s = scalars + (k0 * dimensions[1] + j0) * dimensions[0] + i0;
+            float s00 = s[0] + fx * (s[di] - s[0]);
+            float s10 = s[dj] + fx * (s[dj + di] - s[dj]);
+            float s01 = s[dk] + fx * (s[dk + di] - s[dk]);
+            float s11 = s[dk + dj] + fx * (s[dk + dj + di] - s[dk + dj]);
+            float s0 = s00 + fy * (s10 - s00);
+            float s1 = s01 + fy * (s11 - s01);
+            scalar = s0 + fz * (s1 - s0);
+            }
+          int entry = std::min(volume.TableSize - 1,
+                               static_cast<int>(scalar + 0.5f) >> volume.TableShift);
+          float alpha = volume.Opacities[entry];
+          if (alpha > 0.f)
+            {
+            const float* rgb = &volume.Colors[3 * entry];
+            sampleTransparency *= 1.f - alpha;
+            sampleWeight += alpha;
+            sampleColor[0] += alpha * rgb[0];
+            sampleColor[1] += alpha * rgb[1];
+            sampleColor[2] += alpha * rgb[2];
+            }
+          }
+
+        if (empty)
+          {
+          // Jump to the first sample that may be visible
+          t += step * std::max(1., ceil(skippedSteps));
+          continue;
+          }
+        ++interpolatedSamples;
+        if (sampleWeight > 0.f)
+          {
+          // Blend the colors of the volumes by their opacities
+          float sampleOpacity = 1.f - sampleTransparency;
+          float weight = (1.f - opacity) * sampleOpacity / sampleWeight;
+          color[0] += weight * sampleColor[0];
+          color[1] += weight * sampleColor[1];
+          color[2] += weight * sampleColor[2];
+          opacity += (1.f - opacity) * sampleOpacity;
+          }
+        t += step;
+        }
+
+      for (int i = 0; i < 3; ++i)
+        {
+        float value = color[i] + (1.f - opacity) * static_cast<float>(this->Background[i]);
+        pixel[i] = static_cast<unsigned char>(std::min(255.f, std::max(0.f, value * 255.f + 0.5f)));
+        }
+      pixel[3] = static_cast<unsigned char>(std::min(255.f, opacity * 255.f + 0.5f));
+      }
+    }
+  this->Internal->InterpolatedSamples[threadId] = interpolatedSamples;
+}
@@ -0,0 +1,136 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerMultiVolumeRayCaster_h
+#define __vtkSlicerMultiVolumeRayCaster_h
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkObject.h>
+
+#include "vtkSlicerMultiVolumeRenderingModuleLogicExport.h"
+
+class vtkCamera;
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkVolumeProperty;
+
+/// \ingroup Slicer_QtModules_MultiVolumeRendering
+/// \brief Multithreaded CPU ray caster compositing several volumes.
+///
+/// Each volume has its own IJK to world transform and its own volume
+/// property (color, scalar opacity, opacity unit distance and interpolation
+/// type), so co-registered volumes (e.g. CT and PET) and label maps can be
+/// sampled along the same rays. At each sample, the colors of the volumes
+/// are blended by their opacities before being composited front to back.
+///
+/// Like the fixed point ray cast mapper, the scalars are quantized on
+/// 16 bits and summarized into a min/max volume of 4x4x4 cells per volume.
+/// Rays skip the cells that are transparent in all the volumes.
+/// The integer scalars of the volumes with the nearest interpolation type
+/// are label maps: they are not quantized and each label has its own
+/// color and opacity, labels are never interpolated.
+///
+/// The rendering does not require an OpenGL context: Render() writes the
+/// image seen by the camera into an RGBA unsigned char image (GetOutput()).
+class VTK_SLICER_MULTIVOLUMERENDERING_MODULE_LOGIC_EXPORT vtkSlicerMultiVolumeRayCaster
+  : public vtkObject
+{
+public:
+  static vtkSlicerMultiVolumeRayCaster *New();
+  vtkTypeMacro(vtkSlicerMultiVolumeRayCaster,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Add a single component volume rendered with the first component
+  /// transfer functions of \a property.
+  /// \a ijkToWorld is the transform from the voxel indices to the world,
+  /// the image origin and spacing are used if it is null.
+  /// Returns the index of the volume.
+  int AddVolume(vtkImageData* image, vtkVolumeProperty* property,
+                vtkMatrix4x4* ijkToWorld = 0);
+  void RemoveAllVolumes();
+  int GetNumberOfVolumes();
+
+  /// Update the transform of the volume \a index, for example when the
+  /// volume is moved by a transform node.
+  void SetVolumeIJKToWorldMatrix(int index, vtkMatrix4x4* ijkToWorld);
+
+  /// Camera looking at the volumes.
+  void SetCamera(vtkCamera* camera);
+  vtkGetObjectMacro(Camera, vtkCamera);
+
+  /// Size in pixels of the rendered image.
+  /// 256x256 by default.
+  vtkSetVector2Macro(ImageSize, int);
+  vtkGetVector2Macro(ImageSize, int);
+
+  /// Distance in world units between two samples along a ray.
+  /// If 0 (default), half the smallest voxel size of the volumes is used.
+  vtkSetMacro(SampleDistance, double);
+  vtkGetMacro(SampleDistance, double);
+
+  /// Color of the pixels not covered by the volumes.
+  /// Black by default.
+  vtkSetVector3Macro(Background, double);
+  vtkGetVector3Macro(Background, double);
+
+  /// Skip the cells of the min/max volumes that are transparent in all the
+  /// volumes. Disabling it is only useful to measure its benefit.
+  /// Enabled by default.
+  vtkSetMacro(EmptySpaceSkipping, bool);
+  vtkGetMacro(EmptySpaceSkipping, bool);
+  vtkBooleanMacro(EmptySpaceSkipping, bool);
+
+  /// Number of threads casting rays.
+  /// vtkMultiThreader::GetGlobalDefaultNumberOfThreads() by default.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Cast the rays and update the output image.
+  void Render();
+
+  /// RGBA unsigned char image of ImageSize pixels written by Render().
+  vtkImageData* GetOutput();
+
+  /// Number of samples where at least one volume was interpolated during
+  /// the last Render(). Samples skipped as empty space are not counted.
+  vtkGetMacro(NumberOfInterpolatedSamples, vtkTypeInt64);
+
+protected:
+  vtkSlicerMultiVolumeRayCaster();
+  virtual ~vtkSlicerMultiVolumeRayCaster();
+
+  static VTK_THREAD_RETURN_TYPE CastRaysThreadedMethod(void* arg);
+  void CastRays(int threadId, int numberOfThreads);
+
+  vtkCamera* Camera;
+  int ImageSize[2];
+  double SampleDistance;
+  double Background[3];
+  bool EmptySpaceSkipping;
+  int NumberOfThreads;
+  vtkTypeInt64 NumberOfInterpolatedSamples;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerMultiVolumeRayCaster(const vtkSlicerMultiVolumeRayCaster&); // Not implemented
+  void operator=(const vtkSlicerMultiVolumeRayCaster&);               // Not implemented
+};
+
+#endif
@@ -18,11 +18,13 @@
 // MultiVolumeRendering includes
 #include "vtkSlicerMultiVolumeRenderingLogic.h"
 #include "vtkMRMLMultiVolumeRenderingDisplayNode.h"
+#include "vtkSlicerMultiVolumeRayCaster.h"
 
 // MRML includes
 #include <vtkCacheManager.h>
 #include <vtkMRMLColorNode.h>
 #include <vtkMRMLLabelMapVolumeDisplayNode.h>
+#include <vtkMRMLTransformNode.h>
 #include <vtkMRMLViewNode.h>
 #include <vtkMRMLVectorVolumeDisplayNode.h>
 #include <vtkMRMLVectorVolumeNode.h>
@@ -33,9 +35,11 @@
 #include <vtkColorTransferFunction.h>
 #include <vtkImageData.h>
 #include <vtkLookupTable.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 #include <vtkVolumeProperty.h>
 
 // VTKSYS includes
@@ -207,3 +211,97 @@ vtkMRMLMultiVolumeRenderingDisplayNode* vtkSlicerMultiVolumeRenderingLogic
 
   return NULL;
 }
+
+//----------------------------------------------------------------------------
+namespace
+{
+
+bool GetIJKToWorldMatrix(vtkMRMLVolumeNode* volumeNode, vtkMatrix4x4* ijkToWorld)
+{
+  volumeNode->GetIJKToRASMatrix(ijkToWorld);
+  vtkMRMLTransformNode* transformNode = volumeNode->GetParentTransformNode();
+  if (!transformNode)
+    {
+    return true;
+    }
+  if (!transformNode->IsTransformToWorldLinear())
+    {
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> transformToWorld;
+  transformNode->GetMatrixTransformToWorld(transformToWorld.GetPointer());
+  vtkMatrix4x4::Multiply4x4(transformToWorld.GetPointer(), ijkToWorld, ijkToWorld);
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkSlicerMultiVolumeRenderingLogic
+::SetupRayCaster(vtkMRMLMultiVolumeRenderingDisplayNode* displayNode,
+                 vtkSlicerMultiVolumeRayCaster* rayCaster)
+{
+  if (!displayNode || !rayCaster)
+    {
+    return;
+    }
+  rayCaster->RemoveAllVolumes();
+
+  vtkMRMLVolumeNode* volumeNodes[3] = {
+    displayNode->GetBgVisibility() ? displayNode->GetBgVolumeNode() : 0,
+    displayNode->GetFgVisibility() ? displayNode->GetFgVolumeNode() : 0,
+    displayNode->GetLabelmapVisibility() ? displayNode->GetLabelmapVolumeNode() : 0};
+  vtkMRMLVolumePropertyNode* propertyNodes[2] = {
+    displayNode->GetBgVolumePropertyNode(), displayNode->GetFgVolumePropertyNode()};
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkMRMLVolumeNode* volumeNode = volumeNodes[i];
+    if (!volumeNode || !volumeNode->GetImageData())
+      {
+      continue;
+      }
+    vtkNew<vtkMatrix4x4> ijkToWorld;
+    if (!GetIJKToWorldMatrix(volumeNode, ijkToWorld.GetPointer()))
+      {
+      vtkWarningMacro("SetupRayCaster: " << volumeNode->GetName()
+                      << " is not rendered, its transform is not linear");
+      continue;
+      }
+    vtkSmartPointer<vtkVolumeProperty> property;
+    if (i < 2)
+      {
+      property = propertyNodes[i] ? propertyNodes[i]->GetVolumeProperty() : 0;
+      }
+    else
+      {
+      // Labels are colored by the lookup table of the color node, the
+      // background label (0) is transparent. With the nearest interpolation
+      // the ray caster looks each label up exactly, neighbor labels are
+      // neither blended nor merged.
+      vtkMRMLColorNode* colorNode = volumeNode->GetDisplayNode() ?
+        volumeNode->GetDisplayNode()->GetColorNode() : 0;
+      vtkLookupTable* lookupTable = colorNode ? colorNode->GetLookupTable() : 0;
+      if (lookupTable)
+        {
+        vtkNew<vtkColorTransferFunction> colors;
+        vtkNew<vtkPiecewiseFunction> opacities;
+        for (int label = 0; label < lookupTable->GetNumberOfTableValues(); ++label)
+          {
+          double rgba[4];
+          lookupTable->GetTableValue(label, rgba);
+          colors->AddRGBPoint(label, rgba[0], rgba[1], rgba[2]);
+          opacities->AddPoint(label, label == 0 ? 0. : rgba[3]);
+          }
+        property = vtkSmartPointer<vtkVolumeProperty>::New();
+        property->SetColor(colors.GetPointer());
+        property->SetScalarOpacity(opacities.GetPointer());
+        property->SetInterpolationTypeToNearest();
+        }
+      }
+    if (!property)
+      {
+      continue;
+      }
+    rayCaster->AddVolume(volumeNode->GetImageData(), property, ijkToWorld.GetPointer());
+    }
+}
@@ -49,6 +49,7 @@ class vtkPiecewiseFunction;
 class vtkVolumeProperty;
 
 class vtkMRMLMultiVolumeRenderingDisplayNode;
+class vtkSlicerMultiVolumeRayCaster;
 
 /// \ingroup Slicer_QtModules_MultiVolumeRendering
 class VTK_SLICER_MULTIVOLUMERENDERING_MODULE_LOGIC_EXPORT vtkSlicerMultiVolumeRenderingLogic :
@@ -73,6 +74,15 @@ public:
   // Find volume rendering display node reference in the volume
   vtkMRMLMultiVolumeRenderingDisplayNode* GetDisplayNodeByID(vtkMRMLVolumeNode *volumeNode, char *displayNodeID);
 
+  // Description:
+  // Set the visible bg, fg and labelmap volumes of the display node as the
+  // volumes of the CPU ray caster, with their transforms to world.
+  // The bg and fg volumes are rendered with their volume property node, the
+  // labelmap with the colors of its color node, without interpolation
+  // between labels.
+  void SetupRayCaster(vtkMRMLMultiVolumeRenderingDisplayNode* displayNode,
+                      vtkSlicerMultiVolumeRayCaster* rayCaster);
+
 protected:
   vtkSlicerMultiVolumeRenderingLogic();
   virtual ~vtkSlicerMultiVolumeRenderingLogic();
@@ -0,0 +1,361 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MultiVolumeRendering includes
+#include "vtkMRMLMultiVolumeRenderingDisplayableManager.h"
+#include "vtkMRMLMultiVolumeRenderingDisplayNode.h"
+#include "vtkSlicerMultiVolumeRayCaster.h"
+#include "vtkSlicerMultiVolumeRenderingLogic.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLViewNode.h>
+#include <vtkMRMLVolumeNode.h>
+#include <vtkMRMLVolumePropertyNode.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkImageExtractComponents.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkRenderer.h>
+#include <vtkTexture.h>
+#include <vtkVersion.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+//---------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLMultiVolumeRenderingDisplayableManager);
+
+//---------------------------------------------------------------------------
+class vtkMRMLMultiVolumeRenderingDisplayableManager::vtkInternal
+{
+public:
+  typedef std::vector<vtkWeakPointer<vtkMRMLNode> > NodesType;
+
+  vtkInternal();
+
+  bool IsObserved(vtkObject* node)const;
+  /// Show the ray cast image as the background of the renderer if the ray
+  /// caster has volumes, restore the background otherwise.
+  void UpdateBackground();
+
+  vtkNew<vtkSlicerMultiVolumeRayCaster> RayCaster;
+  vtkNew<vtkSlicerMultiVolumeRenderingLogic> Logic;
+  /// The colors of the ray caster output are already blended with the
+  /// background, its opacity must not blend them again.
+  vtkNew<vtkImageExtractComponents> ExtractColors;
+  vtkNew<vtkTexture> Texture;
+  vtkNew<vtkCallbackCommand> RenderCallbackCommand;
+
+  vtkWeakPointer<vtkMRMLMultiVolumeRenderingDisplayNode> DisplayedNode;
+  NodesType ObservedNodes;
+  /// Renderer observed and textured by the displayable manager.
+  vtkWeakPointer<vtkRenderer> Renderer;
+  bool TexturedBackground;
+};
+
+//---------------------------------------------------------------------------
+vtkMRMLMultiVolumeRenderingDisplayableManager::vtkInternal::vtkInternal()
+{
+  this->TexturedBackground = false;
+#if (VTK_MAJOR_VERSION <= 5)
+  this->ExtractColors->SetInput(this->RayCaster->GetOutput());
+#else
+  this->ExtractColors->SetInputData(this->RayCaster->GetOutput());
+#endif
+  this->ExtractColors->SetComponents(0, 1, 2);
+  this->Texture->SetInputConnection(this->ExtractColors->GetOutputPort());
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMultiVolumeRenderingDisplayableManager::vtkInternal
+::IsObserved(vtkObject* node)const
+{
+  for (NodesType::const_iterator it = this->ObservedNodes.begin();
+       it != this->ObservedNodes.end(); ++it)
+    {
+    if (it->GetPointer() == node)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::vtkInternal::UpdateBackground()
+{
+  bool texturedBackground = this->RayCaster->GetNumberOfVolumes() > 0;
+  if (!this->Renderer || texturedBackground == this->TexturedBackground)
+    {
+    return;
+    }
+  this->Renderer->SetBackgroundTexture(texturedBackground ? this->Texture.GetPointer() : 0);
+  this->Renderer->SetTexturedBackground(texturedBackground);
+  this->TexturedBackground = texturedBackground;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMultiVolumeRenderingDisplayableManager::vtkMRMLMultiVolumeRenderingDisplayableManager()
+{
+  this->Internal = new vtkInternal;
+  this->Internal->RenderCallbackCommand->SetCallback(
+    vtkMRMLMultiVolumeRenderingDisplayableManager::RenderCallback);
+  this->Internal->RenderCallbackCommand->SetClientData(this);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMultiVolumeRenderingDisplayableManager::~vtkMRMLMultiVolumeRenderingDisplayableManager()
+{
+  if (this->Internal->Renderer)
+    {
+    this->Internal->Renderer->RemoveObserver(this->Internal->RenderCallbackCommand.GetPointer());
+    }
+  this->Internal->RayCaster->RemoveAllVolumes();
+  this->Internal->UpdateBackground();
+  delete this->Internal;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "DisplayedNode: "
+     << (this->Internal->DisplayedNode ? this->Internal->DisplayedNode->GetID() : "(none)") << "\n";
+  os << indent << "RayCaster: " << this->Internal->RayCaster.GetPointer() << "\n";
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMultiVolumeRenderingDisplayNode* vtkMRMLMultiVolumeRenderingDisplayableManager::GetDisplayedNode()
+{
+  return this->Internal->DisplayedNode;
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerMultiVolumeRayCaster* vtkMRMLMultiVolumeRenderingDisplayableManager::GetRayCaster()
+{
+  return this->Internal->RayCaster.GetPointer();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::Create()
+{
+  vtkRenderer* renderer = this->GetRenderer();
+  if (renderer != this->Internal->Renderer.GetPointer())
+    {
+    if (this->Internal->Renderer)
+      {
+      this->Internal->Renderer->RemoveObserver(this->Internal->RenderCallbackCommand.GetPointer());
+      this->Internal->RayCaster->RemoveAllVolumes();
+      this->Internal->UpdateBackground();
+      }
+    this->Internal->Renderer = renderer;
+    this->Internal->TexturedBackground = false;
+    if (renderer)
+      {
+      renderer->AddObserver(vtkCommand::StartEvent, this->Internal->RenderCallbackCommand.GetPointer());
+      }
+    }
+  this->UpdateDisplayedNode();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::UnobserveMRMLScene()
+{
+  for (vtkInternal::NodesType::iterator it = this->Internal->ObservedNodes.begin();
+       it != this->Internal->ObservedNodes.end(); ++it)
+    {
+    if (it->GetPointer())
+      {
+      vtkUnObserveMRMLNodeMacro(it->GetPointer());
+      }
+    }
+  this->Internal->ObservedNodes.clear();
+  this->Internal->DisplayedNode = 0;
+  this->Internal->RayCaster->RemoveAllVolumes();
+  this->Internal->UpdateBackground();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::UpdateFromMRMLScene()
+{
+  this->UpdateDisplayedNode();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+  if (this->GetMRMLScene()->IsBatchProcessing() ||
+      !node->IsA("vtkMRMLMultiVolumeRenderingDisplayNode"))
+    {
+    return;
+    }
+  this->UpdateDisplayedNode();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  if (this->GetMRMLScene()->IsBatchProcessing() ||
+      !this->Internal->IsObserved(node))
+    {
+    return;
+    }
+  this->UpdateDisplayedNode();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager
+::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  if (!this->Internal->IsObserved(caller))
+    {
+    this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+    return;
+    }
+  this->UpdateDisplayedNode();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::UpdateDisplayedNode()
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  vtkMRMLViewNode* viewNode = this->GetMRMLViewNode();
+
+  // Display nodes are observed to know when they become visible in the view,
+  // the nodes referenced by the displayed node to render their changes.
+  std::vector<vtkMRMLNode*> nodes;
+  std::vector<vtkMRMLNode*> displayNodes;
+  if (scene && viewNode && !scene->IsClosing())
+    {
+    scene->GetNodesByClass("vtkMRMLMultiVolumeRenderingDisplayNode", displayNodes);
+    }
+  vtkMRMLMultiVolumeRenderingDisplayNode* displayedNode = 0;
+  for (std::vector<vtkMRMLNode*>::iterator it = displayNodes.begin();
+       it != displayNodes.end(); ++it)
+    {
+    vtkMRMLMultiVolumeRenderingDisplayNode* displayNode =
+      vtkMRMLMultiVolumeRenderingDisplayNode::SafeDownCast(*it);
+    nodes.push_back(displayNode);
+    if (!displayedNode && displayNode->GetVisibility() &&
+        displayNode->IsDisplayableInView(viewNode->GetID()))
+      {
+      displayedNode = displayNode;
+      }
+    }
+  if (displayedNode)
+    {
+    vtkMRMLVolumeNode* volumeNodes[3] = {displayedNode->GetBgVolumeNode(),
+                                         displayedNode->GetFgVolumeNode(),
+                                         displayedNode->GetLabelmapVolumeNode()};
+    for (int i = 0; i < 3; ++i)
+      {
+      if (volumeNodes[i])
+        {
+        nodes.push_back(volumeNodes[i]);
+        // The display node forwards the modifications of the color node
+        if (volumeNodes[i]->GetDisplayNode())
+          {
+          nodes.push_back(volumeNodes[i]->GetDisplayNode());
+          }
+        }
+      }
+    if (displayedNode->GetBgVolumePropertyNode())
+      {
+      nodes.push_back(displayedNode->GetBgVolumePropertyNode());
+      }
+    if (displayedNode->GetFgVolumePropertyNode())
+      {
+      nodes.push_back(displayedNode->GetFgVolumePropertyNode());
+      }
+    }
+
+  // Only change the observations that differ: the nodes still observed may
+  // be invoking the event being processed.
+  for (vtkInternal::NodesType::iterator it = this->Internal->ObservedNodes.begin();
+       it != this->Internal->ObservedNodes.end(); ++it)
+    {
+    vtkMRMLNode* node = it->GetPointer();
+    if (node && std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+      {
+      vtkUnObserveMRMLNodeMacro(node);
+      }
+    }
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkCommand::ModifiedEvent);
+  events->InsertNextValue(vtkMRMLVolumeNode::ImageDataModifiedEvent);
+  events->InsertNextValue(vtkMRMLTransformableNode::TransformModifiedEvent);
+  std::sort(nodes.begin(), nodes.end());
+  nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+  vtkInternal::NodesType observedNodes;
+  for (std::vector<vtkMRMLNode*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+    {
+    if (!this->Internal->IsObserved(*it))
+      {
+      vtkObserveMRMLNodeEventsMacro(*it, events.GetPointer());
+      }
+    observedNodes.push_back(*it);
+    }
+  this->Internal->ObservedNodes = observedNodes;
+
+  this->Internal->DisplayedNode = displayedNode;
+  this->Internal->RayCaster->RemoveAllVolumes();
+  if (displayedNode)
+    {
+    this->Internal->Logic->SetupRayCaster(displayedNode, this->Internal->RayCaster.GetPointer());
+    }
+  this->Internal->UpdateBackground();
+  this->RequestRender();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::RenderCallback(
+  vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+  void* clientData, void* vtkNotUsed(callData))
+{
+  vtkMRMLMultiVolumeRenderingDisplayableManager* self =
+    reinterpret_cast<vtkMRMLMultiVolumeRenderingDisplayableManager*>(clientData);
+  self->OnRenderStart();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMultiVolumeRenderingDisplayableManager::OnRenderStart()
+{
+  vtkRenderer* renderer = this->Internal->Renderer;
+  vtkSlicerMultiVolumeRayCaster* rayCaster = this->Internal->RayCaster.GetPointer();
+  if (!renderer || !this->Internal->TexturedBackground || !this->Internal->DisplayedNode)
+    {
+    return;
+    }
+  int* size = renderer->GetSize();
+  if (size[0] <= 0 || size[1] <= 0)
+    {
+    return;
+    }
+  // The texture covers the whole viewport, the image has one ray per pixel
+  rayCaster->SetCamera(renderer->GetActiveCamera());
+  rayCaster->SetImageSize(size[0], size[1]);
+  rayCaster->SetBackground(renderer->GetBackground());
+  rayCaster->SetSampleDistance(this->Internal->DisplayedNode->GetEstimatedSampleDistance());
+  rayCaster->Render();
+}
@@ -0,0 +1,86 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkMRMLMultiVolumeRenderingDisplayableManager_h
+#define __vtkMRMLMultiVolumeRenderingDisplayableManager_h
+
+// MultiVolumeRendering includes
+#include "vtkSlicerMultiVolumeRenderingModuleMRMLDisplayableManagerExport.h"
+class vtkMRMLMultiVolumeRenderingDisplayNode;
+class vtkSlicerMultiVolumeRayCaster;
+
+// MRML DisplayableManager includes
+#include <vtkMRMLAbstractThreeDViewDisplayableManager.h>
+
+/// \ingroup Slicer_QtModules_MultiVolumeRendering
+/// \brief Render the multi-volume rendering display nodes in 3D views.
+///
+/// The first visible vtkMRMLMultiVolumeRenderingDisplayNode displayable in
+/// the view is rendered by a vtkSlicerMultiVolumeRayCaster set up by
+/// vtkSlicerMultiVolumeRenderingLogic::SetupRayCaster(). The volumes are
+/// ray cast with the camera of the view each time the view is rendered,
+/// and the image is shown as the textured background of the renderer:
+/// the other props of the view are drawn in front of the volumes.
+class VTK_SLICER_MULTIVOLUMERENDERING_MODULE_MRMLDISPLAYABLEMANAGER_EXPORT vtkMRMLMultiVolumeRenderingDisplayableManager
+  : public vtkMRMLAbstractThreeDViewDisplayableManager
+{
+public:
+  static vtkMRMLMultiVolumeRenderingDisplayableManager *New();
+  vtkTypeMacro(vtkMRMLMultiVolumeRenderingDisplayableManager, vtkMRMLAbstractThreeDViewDisplayableManager);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Display node rendered in the view, 0 if none.
+  vtkMRMLMultiVolumeRenderingDisplayNode* GetDisplayedNode();
+
+  /// Ray caster rendering the volumes of the displayed node.
+  vtkSlicerMultiVolumeRayCaster* GetRayCaster();
+
+protected:
+  vtkMRMLMultiVolumeRenderingDisplayableManager();
+  virtual ~vtkMRMLMultiVolumeRenderingDisplayableManager();
+
+  virtual void Create();
+
+  virtual void UnobserveMRMLScene();
+  virtual void UpdateFromMRMLScene();
+  virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+
+  /// Any event of the display nodes, of the volume, volume property and
+  /// color nodes they reference updates the ray caster.
+  virtual void ProcessMRMLNodesEvents(vtkObject* caller,
+                                      unsigned long event,
+                                      void* callData);
+
+  /// Find the displayed node, observe the nodes it depends on and set up
+  /// the ray caster with its volumes.
+  void UpdateDisplayedNode();
+
+  /// Cast the rays with the camera of the view before it is rendered.
+  static void RenderCallback(vtkObject* caller, unsigned long eid,
+                             void* clientData, void* callData);
+  void OnRenderStart();
+
+private:
+  vtkMRMLMultiVolumeRenderingDisplayableManager(const vtkMRMLMultiVolumeRenderingDisplayableManager&); // Not implemented
+  void operator=(const vtkMRMLMultiVolumeRenderingDisplayableManager&);                           // Not implemented
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
@@ -20,10 +20,12 @@
 
 // MultiVolumeRendering Logic includes
 #include <vtkSlicerMultiVolumeRenderingLogic.h>
+#include <vtkMRMLThreeDViewDisplayableManagerFactory.h>
 
 // MultiVolumeRendering includes
 #include "qSlicerMultiVolumeRenderingModule.h"
 #include "qSlicerMultiVolumeRenderingModuleWidget.h"
+#include "MultiVolumeRenderingInstantiator.h"
 
 //-----------------------------------------------------------------------------
 Q_EXPORT_PLUGIN2(qSlicerMultiVolumeRenderingModule, qSlicerMultiVolumeRenderingModule);
@@ -108,6 +110,8 @@ QIcon qSlicerMultiVolumeRenderingModule::icon()const
 void qSlicerMultiVolumeRenderingModule::setup()
 {
   this->Superclass::setup();
+  vtkMRMLThreeDViewDisplayableManagerFactory::GetInstance()->
+    RegisterDisplayableManager("vtkMRMLMultiVolumeRenderingDisplayableManager");
 }
 
 //-----------------------------------------------------------------------------
@@ -95,40 +95,14 @@ vtkMRMLSubjectHierarchyNode* vtkSlicerSubjectHierarchyModuleLogic::InsertDicomSe
     return NULL;
     }
 
-  vtkMRMLSubjectHierarchyNode* patientNode = NULL;
-  vtkMRMLSubjectHierarchyNode* studyNode = NULL;
-  vtkMRMLSubjectHierarchyNode* seriesNode = NULL;
-
-  std::vector<vtkMRMLNode*> subjectHierarchyNodes;
-  unsigned int numberOfNodes = scene->GetNodesByClass("vtkMRMLHierarchyNode", subjectHierarchyNodes);
-
   // Find referenced nodes
-  for (unsigned int i=0; i<numberOfNodes; i++)
-    {
-    vtkMRMLSubjectHierarchyNode *node = vtkMRMLSubjectHierarchyNode::SafeDownCast(subjectHierarchyNodes[i]);
-    if ( node && node->IsA("vtkMRMLSubjectHierarchyNode") )
-      {
-      std::string nodeDicomUIDStr = node->GetUID(vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName());
-      const char* nodeDicomUID = nodeDicomUIDStr.c_str();
-      if (!nodeDicomUID)
-        {
-        // Having a UID is not mandatory
-        continue;
-        }
-      if (!strcmp(patientId, nodeDicomUID))
-        {
-        patientNode = node;
-        }
-      else if (!strcmp(studyInstanceUID, nodeDicomUID))
-        {
-        studyNode = node;
-        }
-      else if (!strcmp(seriesInstanceUID, nodeDicomUID))
-        {
-        seriesNode = node;
-        }
-      }
-    }
+  const char* dicomUIDName = vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName();
+  vtkMRMLSubjectHierarchyNode* patientNode =
+    vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene, dicomUIDName, patientId);
+  vtkMRMLSubjectHierarchyNode* studyNode =
+    vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene, dicomUIDName, studyInstanceUID);
+  vtkMRMLSubjectHierarchyNode* seriesNode =
+    vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene, dicomUIDName, seriesInstanceUID);
 
   if (!seriesNode)
     {
@@ -40,9 +40,102 @@
 #include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 #include <set>
 
+namespace
+{
+
+/// Subject hierarchy nodes by UID value, for each UID name of each scene
+typedef std::map<std::string, std::vector<vtkMRMLSubjectHierarchyNode*> > UIDValueToNodesType;
+typedef std::map<std::string, UIDValueToNodesType> UIDNameToNodesType;
+typedef std::map<vtkMRMLScene*, UIDNameToNodesType> SceneUIDIndexType;
+
+//----------------------------------------------------------------------------
+SceneUIDIndexType& SceneUIDIndex()
+{
+  static SceneUIDIndexType sceneUIDIndex;
+  return sceneUIDIndex;
+}
+
+//----------------------------------------------------------------------------
+/// Same as SceneUIDIndex() but the values are the items of the UID lists
+SceneUIDIndexType& SceneUIDListItemIndex()
+{
+  static SceneUIDIndexType sceneUIDListItemIndex;
+  return sceneUIDListItemIndex;
+}
+
+//----------------------------------------------------------------------------
+void AddToUIDIndex(SceneUIDIndexType& index, vtkMRMLScene* scene,
+                   const std::string& uidName, const std::string& uidValue,
+                   vtkMRMLSubjectHierarchyNode* node)
+{
+  index[scene][uidName][uidValue].push_back(node);
+}
+
+//----------------------------------------------------------------------------
+void RemoveFromUIDIndex(SceneUIDIndexType& index, vtkMRMLScene* scene,
+                        const std::string& uidName, const std::string& uidValue,
+                        vtkMRMLSubjectHierarchyNode* node)
+{
+  SceneUIDIndexType::iterator sceneIt = index.find(scene);
+  if (sceneIt == index.end())
+    {
+    return;
+    }
+  UIDNameToNodesType::iterator nameIt = sceneIt->second.find(uidName);
+  if (nameIt == sceneIt->second.end())
+    {
+    return;
+    }
+  UIDValueToNodesType::iterator valueIt = nameIt->second.find(uidValue);
+  if (valueIt == nameIt->second.end())
+    {
+    return;
+    }
+  std::vector<vtkMRMLSubjectHierarchyNode*>& nodes = valueIt->second;
+  nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+  if (nodes.empty())
+    {
+    nameIt->second.erase(valueIt);
+    if (nameIt->second.empty())
+      {
+      sceneIt->second.erase(nameIt);
+      if (sceneIt->second.empty())
+        {
+        index.erase(sceneIt);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSubjectHierarchyNode* FindInUIDIndex(SceneUIDIndexType& index, vtkMRMLScene* scene,
+                                            const char* uidName, const char* uidValue)
+{
+  SceneUIDIndexType::const_iterator sceneIt = index.find(scene);
+  if (sceneIt == index.end())
+    {
+    return NULL;
+    }
+  UIDNameToNodesType::const_iterator nameIt = sceneIt->second.find(uidName);
+  if (nameIt == sceneIt->second.end())
+    {
+    return NULL;
+    }
+  UIDValueToNodesType::const_iterator valueIt = nameIt->second.find(uidValue);
+  if (valueIt == nameIt->second.end())
+    {
+    return NULL;
+    }
+  // The first node that was given the UID
+  return valueIt->second.front();
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 const std::string vtkMRMLSubjectHierarchyNode::SUBJECTHIERARCHY_UID_ITEM_SEPARATOR = std::string(":");
 const std::string vtkMRMLSubjectHierarchyNode::SUBJECTHIERARCHY_UID_NAME_VALUE_SEPARATOR = std::string("; ");
@@ -65,6 +158,7 @@ vtkMRMLSubjectHierarchyNode::vtkMRMLSubjectHierarchyNode()
 //----------------------------------------------------------------------------
 vtkMRMLSubjectHierarchyNode::~vtkMRMLSubjectHierarchyNode()
 {
+  this->RemoveUIDsFromIndex();
   this->UIDs.clear();
 
   this->SetLevel(0);
@@ -132,6 +226,7 @@ void vtkMRMLSubjectHierarchyNode::ReadXMLAttributes( const char** atts)
       ss << attValue;
       std::string valueStr = ss.str();
 
+      this->RemoveUIDsFromIndex();
       this->UIDs.clear();
       size_t itemSeparatorPosition = valueStr.find(vtkMRMLSubjectHierarchyNode::SUBJECTHIERARCHY_UID_ITEM_SEPARATOR);
       while (itemSeparatorPosition != std::string::npos)
@@ -198,11 +293,75 @@ void vtkMRMLSubjectHierarchyNode::Copy(vtkMRMLNode *anode)
   this->SetOwnerPluginName(node->OwnerPluginName);
   this->SetOwnerPluginAutoSearch(node->GetOwnerPluginAutoSearch());
 
+  this->RemoveUIDsFromIndex();
   this->UIDs = node->GetUIDs();
+  this->AddUIDsToIndex();
 
   this->EndModify(disabledModify);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::SetScene(vtkMRMLScene* scene)
+{
+  if (scene == this->Scene)
+    {
+    return;
+    }
+  this->RemoveUIDsFromIndex();
+  this->Superclass::SetScene(scene);
+  this->AddUIDsToIndex();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::AddUIDToIndex(const std::string& uidName, const std::string& uidValue)
+{
+  if (!this->Scene)
+    {
+    return;
+    }
+  AddToUIDIndex(SceneUIDIndex(), this->Scene, uidName, uidValue, this);
+  std::vector<std::string> uidListItems;
+  vtkMRMLSubjectHierarchyNode::DeserializeUIDList(uidValue, uidListItems);
+  for (std::vector<std::string>::iterator itemIt = uidListItems.begin(); itemIt != uidListItems.end(); ++itemIt)
+    {
+    AddToUIDIndex(SceneUIDListItemIndex(), this->Scene, uidName, *itemIt, this);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::RemoveUIDFromIndex(const std::string& uidName, const std::string& uidValue)
+{
+  if (!this->Scene)
+    {
+    return;
+    }
+  RemoveFromUIDIndex(SceneUIDIndex(), this->Scene, uidName, uidValue, this);
+  std::vector<std::string> uidListItems;
+  vtkMRMLSubjectHierarchyNode::DeserializeUIDList(uidValue, uidListItems);
+  for (std::vector<std::string>::iterator itemIt = uidListItems.begin(); itemIt != uidListItems.end(); ++itemIt)
+    {
+    RemoveFromUIDIndex(SceneUIDListItemIndex(), this->Scene, uidName, *itemIt, this);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::AddUIDsToIndex()
+{
+  for (std::map<std::string, std::string>::iterator uidsIt = this->UIDs.begin(); uidsIt != this->UIDs.end(); ++uidsIt)
+    {
+    this->AddUIDToIndex(uidsIt->first, uidsIt->second);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSubjectHierarchyNode::RemoveUIDsFromIndex()
+{
+  for (std::map<std::string, std::string>::iterator uidsIt = this->UIDs.begin(); uidsIt != this->UIDs.end(); ++uidsIt)
+    {
+    this->RemoveUIDFromIndex(uidsIt->first, uidsIt->second);
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSubjectHierarchyNode::SetOwnerPluginName(const char* pluginName)
 {
@@ -255,8 +414,10 @@ void vtkMRMLSubjectHierarchyNode::AddUID(std::string uidName, std::string uidVal
       {
       return; // Do nothing if the UID values match
       }
+    this->RemoveUIDFromIndex(uidName, this->UIDs[uidName]);
     }
   this->UIDs[uidName] = uidValue;
+  this->AddUIDToIndex(uidName, uidValue);
   this->InvokeEvent(SubjectHierarchyUIDAddedEvent, this);
   this->Modified();
 }
@@ -287,23 +448,7 @@ vtkMRMLSubjectHierarchyNode* vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNod
     return NULL;
     }
 
-  std::vector<vtkMRMLNode*> subjectHierarchyNodes;
-  unsigned int numberOfNodes = scene->GetNodesByClass("vtkMRMLSubjectHierarchyNode", subjectHierarchyNodes);
-  for (unsigned int shNodeIndex=0; shNodeIndex<numberOfNodes; shNodeIndex++)
-    {
-    vtkMRMLSubjectHierarchyNode* node = vtkMRMLSubjectHierarchyNode::SafeDownCast(subjectHierarchyNodes[shNodeIndex]);
-    if (node)
-      {
-      std::string nodeUidValueStr = node->GetUID(uidName);
-      const char* nodeUidValue = nodeUidValueStr.c_str();
-      if (nodeUidValue && !strcmp(uidValue, nodeUidValue))
-        {
-        return node;
-        }
-      }
-    }
-
-  return NULL;
+  return FindInUIDIndex(SceneUIDIndex(), scene, uidName, uidValue);
 }
 
 //---------------------------------------------------------------------------
@@ -315,6 +460,14 @@ vtkMRMLSubjectHierarchyNode* vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNod
     return NULL;
     }
 
+  // Searched UID is usually an item of the UID list
+  vtkMRMLSubjectHierarchyNode* listItemNode = FindInUIDIndex(SceneUIDListItemIndex(), scene, uidName, uidValue);
+  if (listItemNode)
+    {
+    return listItemNode;
+    }
+
+  // Fall back to substring search
   std::vector<vtkMRMLNode*> subjectHierarchyNodes;
   unsigned int numberOfNodes = scene->GetNodesByClass("vtkMRMLSubjectHierarchyNode", subjectHierarchyNodes);
   for (unsigned int shNodeIndex=0; shNodeIndex<numberOfNodes; shNodeIndex++)
@@ -580,40 +733,25 @@ vtkMRMLSubjectHierarchyNode* vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHi
     return vtkMRMLSubjectHierarchyNode::SafeDownCast(associatedNode);
     }
 
-  vtkMRMLHierarchyNode::UpdateAssociatedToHierarchyMap(scene);
-
-  std::map<vtkMRMLScene*, AssociatedHierarchyNodesType>::iterator sceneIt =
-    vtkMRMLHierarchyNode::SceneAssociatedHierarchyNodes.find(scene);
-  if (sceneIt == vtkMRMLHierarchyNode::SceneAssociatedHierarchyNodes.end())
+  if (!associatedNode->GetID())
     {
-    vtkErrorWithObjectMacro(scene, "GetAssociatedSubjectHierarchyNode: Failed to find an associated hierarchy node type associated with the scene");
     return NULL;
     }
 
-  AssociatedHierarchyNodesType sceneAssociations = sceneIt->second;
-  std::map<std::string, vtkMRMLHierarchyNode*>::iterator assocIt =
-    sceneAssociations.find(associatedNode->GetID());
-  if (assocIt != sceneAssociations.end())
+  vtkMRMLHierarchyNode* associatedHierarchyNode =
+    vtkMRMLHierarchyNode::GetAssociatedHierarchyNode(scene, associatedNode->GetID());
+  if (!associatedHierarchyNode)
     {
-    vtkMRMLHierarchyNode* associatedHierarchyNode = assocIt->second;
-    if (associatedHierarchyNode->IsA("vtkMRMLSubjectHierarchyNode"))
-      {
-      return vtkMRMLSubjectHierarchyNode::SafeDownCast(associatedHierarchyNode);
-      }
-    // Associated node is a regular hierarchy node, because either nested association
-    // was used, or the node does not have an associated subject hierarchy node
-    else
-      {
-      std::map<std::string, vtkMRMLHierarchyNode*>::iterator nestedIt =
-        sceneAssociations.find(associatedHierarchyNode->GetID());
-      if (nestedIt != sceneAssociations.end())
-        {
-        return vtkMRMLSubjectHierarchyNode::SafeDownCast(nestedIt->second);
-        }
-      }
+    return NULL;
     }
-
-  return NULL;
+  if (associatedHierarchyNode->IsA("vtkMRMLSubjectHierarchyNode"))
+    {
+    return vtkMRMLSubjectHierarchyNode::SafeDownCast(associatedHierarchyNode);
+    }
+  // Associated node is a regular hierarchy node, because either nested association
+  // was used, or the node does not have an associated subject hierarchy node
+  return vtkMRMLSubjectHierarchyNode::SafeDownCast(
+    vtkMRMLHierarchyNode::GetAssociatedHierarchyNode(scene, associatedHierarchyNode->GetID()) );
 }
 
 //---------------------------------------------------------------------------
@@ -79,8 +79,13 @@ public:
   /// Get node XML tag name (like Volume, Contour)
   virtual const char* GetNodeTagName();
 
+  /// Reimplemented to index the UIDs of the node in its scene
+  virtual void SetScene(vtkMRMLScene* scene);
+
 public:
   /// Find subject hierarchy node according to a UID (by exact match)
+  /// The UIDs of the nodes of each scene are indexed, the lookup does not
+  /// iterate over the subject hierarchy nodes.
   /// \param scene MRML scene
   /// \param uidName UID string to lookup
   /// \param uidValue UID string that needs to _exactly match_ the UID string of the subject hierarchy node
@@ -91,7 +96,8 @@ public:
   /// \param scene MRML scene
   /// \param uidName UID string to lookup
   /// \param uidValue UID string that needs to be _contained_ in the UID string of the subject hierarchy node
-  /// \return First match
+  /// \return First match. Items of the UID lists (separated by spaces) are
+  ///   indexed, other substrings are searched by iterating over the nodes.
   /// \sa GetUID()
   static vtkMRMLSubjectHierarchyNode* GetSubjectHierarchyNodeByUIDList(vtkMRMLScene* scene, const char* uidName, const char* uidValue);
 
@@ -242,6 +248,14 @@ protected:
   /// UIDs can be DICOM UIDs, MIDAS urls, etc.
   std::map<std::string, std::string> UIDs;
 
+protected:
+  /// Add/remove a UID of this node to/from the UID index of its scene
+  void AddUIDToIndex(const std::string& uidName, const std::string& uidValue);
+  void RemoveUIDFromIndex(const std::string& uidName, const std::string& uidValue);
+  /// Add/remove all the UIDs of this node to/from the UID index of its scene
+  void AddUIDsToIndex();
+  void RemoveUIDsFromIndex();
+
 protected:
   vtkMRMLSubjectHierarchyNode();
   ~vtkMRMLSubjectHierarchyNode();
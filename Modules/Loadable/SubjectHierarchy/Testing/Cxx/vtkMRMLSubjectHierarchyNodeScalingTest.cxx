@@ -0,0 +1,265 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Subject Hierarchy includes
+#include "vtkMRMLSubjectHierarchyNode.h"
+#include "vtkMRMLSubjectHierarchyConstants.h"
+
+// MRML includes
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void PrintElapsedTime(const char* name, int numberOfItems, vtkTimerLog* timer)
+{
+  std::cout << "<DartMeasurement name=\"vtkMRMLSubjectHierarchyNode-" << name << "-" << numberOfItems
+            << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+}
+
+//----------------------------------------------------------------------------
+std::string SeriesUID(int index)
+{
+  std::stringstream ss;
+  ss << "SERIES" << index;
+  return ss.str();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSubjectHierarchyNode* AddSubjectHierarchyNode(vtkMRMLScene* scene,
+  vtkMRMLSubjectHierarchyNode* parent, const char* level, const std::string& uid)
+{
+  vtkNew<vtkMRMLSubjectHierarchyNode> node;
+  node->SetLevel(level);
+  node->AddUID(vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName(), uid);
+  if (parent)
+    {
+    node->SetParentNodeID(parent->GetID());
+    }
+  scene->AddNode(node.GetPointer());
+  return node.GetPointer();
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSubjectHierarchyNodeScalingTest(int argc, char * argv[] )
+{
+  int numberOfSeries = 50000;
+  if (argc > 1)
+    {
+    numberOfSeries = atoi(argv[1]);
+    }
+  const int numberOfStudies = 100;
+  const int seriesPerStudy = numberOfSeries / numberOfStudies;
+  numberOfSeries = seriesPerStudy * numberOfStudies;
+  // One series out of ten has an associated data node
+  const int associationPeriod = 10;
+  const char* uidName = vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName();
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkTimerLog> timer;
+
+  //
+  // Populate: patient -> studies -> series
+  //
+  timer->StartTimer();
+  vtkMRMLSubjectHierarchyNode* patientNode = AddSubjectHierarchyNode(scene.GetPointer(), NULL,
+    vtkMRMLSubjectHierarchyConstants::GetDICOMLevelPatient(), "PATIENT");
+  std::vector<vtkMRMLSubjectHierarchyNode*> studyNodes;
+  std::vector<vtkMRMLSubjectHierarchyNode*> seriesNodes;
+  std::vector<vtkMRMLNode*> dataNodes;
+  for (int study = 0; study < numberOfStudies; ++study)
+    {
+    std::stringstream studyUID;
+    studyUID << "STUDY" << study;
+    studyNodes.push_back(AddSubjectHierarchyNode(scene.GetPointer(), patientNode,
+      vtkMRMLSubjectHierarchyConstants::GetDICOMLevelStudy(), studyUID.str()));
+    for (int series = 0; series < seriesPerStudy; ++series)
+      {
+      int seriesIndex = study * seriesPerStudy + series;
+      vtkMRMLSubjectHierarchyNode* seriesNode = AddSubjectHierarchyNode(scene.GetPointer(), studyNodes.back(),
+        vtkMRMLSubjectHierarchyConstants::GetDICOMLevelSeries(), SeriesUID(seriesIndex));
+      seriesNodes.push_back(seriesNode);
+      if (seriesIndex % associationPeriod == 0)
+        {
+        vtkNew<vtkMRMLModelNode> dataNode;
+        scene->AddNode(dataNode.GetPointer());
+        seriesNode->SetAssociatedNodeID(dataNode->GetID());
+        dataNodes.push_back(dataNode.GetPointer());
+        }
+      }
+    }
+  timer->StopTimer();
+  PrintElapsedTime("AddNodes", numberOfSeries, timer.GetPointer());
+
+  //
+  // Children
+  //
+  timer->StartTimer();
+  bool childrenValid = true;
+  for (int study = 0; study < numberOfStudies; ++study)
+    {
+    std::vector<vtkMRMLHierarchyNode*> children = studyNodes[study]->GetChildrenNodes();
+    if (children.size() != static_cast<size_t>(seriesPerStudy))
+      {
+      childrenValid = false;
+      continue;
+      }
+    // Children are sorted in the order they were added
+    for (int series = 0; series < seriesPerStudy; ++series)
+      {
+      childrenValid = childrenValid && (children[series] == seriesNodes[study * seriesPerStudy + series]);
+      }
+    }
+  timer->StopTimer();
+  PrintElapsedTime("GetChildrenNodes", numberOfSeries, timer.GetPointer());
+  if (!childrenValid)
+    {
+    std::cerr << "Line " << __LINE__ << " - GetChildrenNodes failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::vector<vtkMRMLHierarchyNode*> allChildren;
+  patientNode->GetAllChildrenNodes(allChildren);
+  if (allChildren.size() != static_cast<size_t>(numberOfStudies + numberOfSeries))
+    {
+    std::cerr << "Line " << __LINE__ << " - GetAllChildrenNodes failed: "
+              << allChildren.size() << " nodes instead of " << numberOfStudies + numberOfSeries << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // UID lookup
+  //
+  timer->StartTimer();
+  for (int seriesIndex = 0; seriesIndex < numberOfSeries; ++seriesIndex)
+    {
+    if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(
+          scene.GetPointer(), uidName, SeriesUID(seriesIndex).c_str()) != seriesNodes[seriesIndex])
+      {
+      std::cerr << "Line " << __LINE__ << " - GetSubjectHierarchyNodeByUID failed for series "
+                << seriesIndex << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  PrintElapsedTime("GetSubjectHierarchyNodeByUID", numberOfSeries, timer.GetPointer());
+
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), uidName, "SERIES") != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - GetSubjectHierarchyNodeByUID found a partial match" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Instance UID lists
+  const char* instanceUIDName = vtkMRMLSubjectHierarchyConstants::GetDICOMInstanceUIDName();
+  seriesNodes[1]->AddUID(instanceUIDName, "INSTANCE1 INSTANCE2 INSTANCE3");
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUIDList(
+        scene.GetPointer(), instanceUIDName, "INSTANCE2") != seriesNodes[1]
+    || vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUIDList(
+        scene.GetPointer(), instanceUIDName, "STANCE3") != seriesNodes[1]
+    || vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUIDList(
+        scene.GetPointer(), instanceUIDName, "INSTANCE4") != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - GetSubjectHierarchyNodeByUIDList failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Replacing a UID updates the index
+  seriesNodes[2]->AddUID(uidName, "REPLACED");
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), uidName, "REPLACED") != seriesNodes[2]
+    || vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), uidName, SeriesUID(2).c_str()) != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - UID index not updated after replacing a UID" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Associated subject hierarchy nodes
+  //
+  timer->StartTimer();
+  for (size_t dataIndex = 0; dataIndex < dataNodes.size(); ++dataIndex)
+    {
+    if (vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(dataNodes[dataIndex])
+        != seriesNodes[dataIndex * associationPeriod])
+      {
+      std::cerr << "Line " << __LINE__ << " - GetAssociatedSubjectHierarchyNode failed for data node "
+                << dataNodes[dataIndex]->GetID() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  PrintElapsedTime("GetAssociatedSubjectHierarchyNode", static_cast<int>(dataNodes.size()), timer.GetPointer());
+
+  //
+  // Reparent all the series of the first study into the second one
+  //
+  timer->StartTimer();
+  for (int series = 0; series < seriesPerStudy; ++series)
+    {
+    seriesNodes[series]->SetParentNodeID(studyNodes[1]->GetID());
+    }
+  timer->StopTimer();
+  PrintElapsedTime("Reparent", seriesPerStudy, timer.GetPointer());
+  if (!studyNodes[0]->GetChildrenNodes().empty()
+    || studyNodes[1]->GetChildrenNodes().size() != static_cast<size_t>(2 * seriesPerStudy)
+    || studyNodes[1]->GetChildrenNodes().back() != seriesNodes[seriesPerStudy - 1])
+    {
+    std::cerr << "Line " << __LINE__ << " - Children not updated after reparenting" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Removal
+  //
+  vtkMRMLNode* removedDataNode = dataNodes[0];
+  scene->RemoveNode(seriesNodes[0]);
+  if (studyNodes[1]->GetChildrenNodes().size() != static_cast<size_t>(2 * seriesPerStudy - 1)
+    || vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), uidName, SeriesUID(0).c_str()) != NULL
+    || vtkMRMLSubjectHierarchyNode::GetAssociatedSubjectHierarchyNode(removedDataNode) != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - Indices not updated after removing a node" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  timer->StartTimer();
+  scene->Clear(1);
+  timer->StopTimer();
+  PrintElapsedTime("Clear", numberOfSeries, timer.GetPointer());
+  if (vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNodeByUID(scene.GetPointer(), uidName, "PATIENT") != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - UID index not cleared with the scene" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -83,6 +83,14 @@ void qMRMLSceneSubjectHierarchyModelPrivate::init()
   qSlicerSubjectHierarchyPluginHandler::instance()->defaultPlugin()->setDefaultVisibilityIcons(this->VisibleIcon, this->HiddenIcon, this->PartiallyVisibleIcon);
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneSubjectHierarchyModelPrivate::cacheNodeIndexes()
+{
+  // The nodes not found in the children of their parent are ordered as in
+  // the scene, see qMRMLSceneSubjectHierarchyModel::nodeIndex()
+  this->qMRMLSceneModelPrivate::cacheNodeIndexes();
+}
+
 
 //------------------------------------------------------------------------------
 
@@ -145,6 +153,13 @@ int qMRMLSceneSubjectHierarchyModel::nodeIndex(vtkMRMLNode* node)const
       }
     }
 
+  // While populating the model, the indexes are computed at once
+  QHash<vtkMRMLNode*, int>::const_iterator cachedIndexIt = d->NodeIndexCache.find(node);
+  if (cachedIndexIt != d->NodeIndexCache.end())
+    {
+    return index + cachedIndexIt.value();
+    }
+
   // Iterate through the scene and see if there is any matching node.
   // First try to find based on ptr value, as it's much faster than comparing string IDs.
   vtkCollection* nodes = d->MRMLScene->GetNodes();
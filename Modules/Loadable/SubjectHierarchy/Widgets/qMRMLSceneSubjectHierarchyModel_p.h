@@ -49,6 +49,7 @@ public:
   typedef qMRMLSceneHierarchyModelPrivate Superclass;
   qMRMLSceneSubjectHierarchyModelPrivate(qMRMLSceneSubjectHierarchyModel& object);
   virtual void init();
+  virtual void cacheNodeIndexes();
 
   int NodeTypeColumn;
   int TransformColumn;
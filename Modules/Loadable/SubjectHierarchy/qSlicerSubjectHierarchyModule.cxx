@@ -25,6 +25,8 @@
 
 // QtGUI includes
 #include <qSlicerApplication.h> 
+#include <qSlicerModuleFactoryManager.h>
+#include <qSlicerModuleManager.h>
 
 // SubjectHierarchy includes
 #include "qSlicerSubjectHierarchyModule.h"
@@ -33,6 +35,7 @@
 #include "vtkSlicerSubjectHierarchyModuleLogic.h"
 
 // SubjectHierarchy Plugins includes
+#include "qSlicerSubjectHierarchyPluginHandler.h"
 #include "qSlicerSubjectHierarchyPluginLogic.h"
 
 // MRML includes
@@ -41,6 +44,17 @@
 //-----------------------------------------------------------------------------
 Q_EXPORT_PLUGIN2(qSlicerSubjectHierarchyModule, qSlicerSubjectHierarchyModule);
 
+namespace
+{
+
+//-----------------------------------------------------------------------------
+int subjectHierarchyPluginCount()
+{
+  return qSlicerSubjectHierarchyPluginHandler::instance()->registeredPlugins().count();
+}
+
+} // end of anonymous namespace
+
 //-----------------------------------------------------------------------------
 /// \ingroup Slicer_QtModules_SubjectHierarchy
 class qSlicerSubjectHierarchyModulePrivate
@@ -126,6 +140,13 @@ void qSlicerSubjectHierarchyModule::setup()
 {
   this->Superclass::setup();
 
+  // Modules registering subject hierarchy plugins are not loaded on demand
+  if (qSlicerCoreApplication::application()->moduleManager())
+    {
+    qSlicerCoreApplication::application()->moduleManager()->factoryManager()
+      ->addPluginCounter(subjectHierarchyPluginCount);
+    }
+
   if (qSlicerApplication::application())
     {
     qSlicerSubjectHierarchySettingsPanel* panel = new qSlicerSubjectHierarchySettingsPanel();
@@ -56,6 +56,13 @@ public:
   vtkGetMacro (RaycastTechnique, int);
   vtkSetMacro (RaycastTechnique, int);
 
+  /// Time in seconds allocated to the first, coarse, image rendered after
+  /// the view changed. The image is then progressively refined by the
+  /// following renders until it reaches the full resolution.
+  /// 0 (default) disables the progressive refinement.
+  vtkGetMacro (RenderTimeBudget, double);
+  vtkSetMacro (RenderTimeBudget, double);
+
 protected:
   vtkMRMLCPURayCastVolumeRenderingDisplayNode();
   ~vtkMRMLCPURayCastVolumeRenderingDisplayNode();
@@ -71,6 +78,8 @@ protected:
    * 5: Illustrative Context Preserving Exploration
    * */
   int RaycastTechnique;
+
+  double RenderTimeBudget;
 };
 
 #endif
@@ -21,6 +21,7 @@
 // Slicer includes
 #include "vtkImageGradientMagnitude.h"
 #include "vtkMRMLVolumeRenderingDisplayableManager.h"
+#include "vtkSlicerFixedPointVolumeRayCastCache.h"
 #include "vtkSlicerFixedPointVolumeRayCastMapper.h"
 #include "vtkSlicerVolumeRenderingLogic.h"
 
@@ -35,6 +36,7 @@
 #include "vtkMRMLScalarVolumeDisplayNode.h"
 #include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLSliceLogic.h"
+#include "vtkMRMLStorageNode.h"
 #include "vtkMRMLTransformNode.h"
 #include "vtkMRMLViewNode.h"
 #include "vtkMRMLVolumePropertyNode.h"
@@ -84,8 +86,13 @@ int vtkMRMLVolumeRenderingDisplayableManager::DefaultGPUMemorySize = 256;
 vtkMRMLVolumeRenderingDisplayableManager::vtkMRMLVolumeRenderingDisplayableManager()
 {
   this->MapperRaycast = NULL;
+  this->MapperSlicerRaycast = NULL;
   this->MapperGPURaycast3 = NULL;
   this->Volume = NULL;
+  this->AbortCheckCallbackCommand = vtkCallbackCommand::New();
+  this->AbortCheckCallbackCommand->SetCallback(
+    vtkMRMLVolumeRenderingDisplayableManager::AbortCheckCallback);
+  this->AbortCheckCallbackCommand->SetClientData(this);
   //this->Histograms = vtkKWHistogramSet::New();
   //this->HistogramsFg = vtkKWHistogramSet::New();
   //this->VolumePropertyGPURaycast3 = NULL;
@@ -137,9 +144,15 @@ vtkMRMLVolumeRenderingDisplayableManager::~vtkMRMLVolumeRenderingDisplayableMana
     {
     this->DisplayObservedEvents->Delete();
     }
+  if (this->AbortCheckRenderWindow)
+    {
+    this->AbortCheckRenderWindow->RemoveObserver(this->AbortCheckCallbackCommand);
+    }
+  this->AbortCheckCallbackCommand->Delete();
 
   //delete instances
   vtkSetMRMLNodeMacro(this->MapperRaycast, NULL);
+  vtkSetMRMLNodeMacro(this->MapperSlicerRaycast, NULL);
   vtkSetMRMLNodeMacro(this->MapperGPURaycast3, NULL);
   vtkSetMRMLNodeMacro(this->Volume, NULL);
   /**
@@ -163,6 +176,19 @@ vtkMRMLVolumeRenderingDisplayableManager::~vtkMRMLVolumeRenderingDisplayableMana
   //}
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager
+::SetPersistentAccelerationStructures(bool persistent)
+{
+  vtkSlicerFixedPointVolumeRayCastCache::GetInstance()->SetPersistent(persistent);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLVolumeRenderingDisplayableManager::GetPersistentAccelerationStructures()
+{
+  return vtkSlicerFixedPointVolumeRayCastCache::GetInstance()->GetPersistent();
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager::PrintSelf(std::ostream &os, vtkIndent indent)
 {
@@ -182,6 +208,8 @@ void vtkMRMLVolumeRenderingDisplayableManager::SetGUICallbackCommand(vtkCommand*
   //cpu ray casting
   this->MapperRaycast->AddObserver(vtkCommand::VolumeMapperComputeGradientsProgressEvent, callback);
   this->MapperRaycast->AddObserver(vtkCommand::ProgressEvent,callback);
+  this->MapperSlicerRaycast->AddObserver(vtkCommand::VolumeMapperComputeGradientsProgressEvent, callback);
+  this->MapperSlicerRaycast->AddObserver(vtkCommand::ProgressEvent,callback);
 
   //hook up the gpu mapper
 
@@ -208,6 +236,16 @@ void vtkMRMLVolumeRenderingDisplayableManager::Reset()
                                       newMapperRaycast.GetPointer(),
                                       mapperEventsWithProgress.GetPointer());
 
+  // CPU mapper sharing its acceleration structures, each progressive
+  // refinement pass requests the next one
+  vtkNew<vtkIntArray> slicerMapperEvents;
+  slicerMapperEvents->InsertNextValue(
+    vtkSlicerFixedPointVolumeRayCastMapper::RefinementRequiredEvent);
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> newMapperSlicerRaycast;
+  vtkSetAndObserveMRMLNodeEventsMacro(this->MapperSlicerRaycast,
+                                      newMapperSlicerRaycast.GetPointer(),
+                                      slicerMapperEvents.GetPointer());
+
   // GPU raycast 3
   vtkNew<vtkGPUVolumeRayCastMapper> newMapperGPURaycast3;
   vtkSetAndObserveMRMLNodeEventsMacro(this->MapperGPURaycast3,
@@ -440,6 +478,52 @@ void vtkMRMLVolumeRenderingDisplayableManager
     }
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager
+::UpdateSlicerCPURaycastMapper(
+  vtkSlicerFixedPointVolumeRayCastMapper* mapper,
+  vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode)
+{
+  this->UpdateMapper(mapper, vspNode);
+  const bool highDef = vspNode->GetPerformanceControl() ==
+    vtkMRMLVolumeRenderingDisplayNode::MaximumQuality;
+  // A render time budget replaces the automatic adjustment
+  const bool progressive = vspNode->GetRenderTimeBudget() > 0.;
+  mapper->SetProgressiveRefinement(progressive ? 1 : 0);
+  if (progressive)
+    {
+    mapper->SetRenderTimeBudget(vspNode->GetRenderTimeBudget());
+    mapper->SetMinimumImageSampleDistance(highDef ? 0.5 : 1.);
+    }
+  else
+    {
+    mapper->SetAutoAdjustSampleDistances( highDef ? 0 : 1);
+    mapper->SetImageSampleDistance(highDef ? 0.5 : 1.);
+    }
+  mapper->SetSampleDistance(this->GetSampleDistance(vspNode));
+  mapper->SetInteractiveSampleDistance(this->GetSampleDistance(vspNode));
+
+  // The gradients and min/max volumes are persisted next to the volume
+  // file when enabled in the settings (see SetPersistentAccelerationStructures)
+  vtkMRMLVolumeNode* volumeNode = vspNode->GetVolumeNode();
+  if (volumeNode && volumeNode->GetImageData())
+    {
+    vtkMRMLStorageNode* storageNode = volumeNode->GetStorageNode();
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance()->SetFileName(
+      volumeNode->GetImageData(), storageNode ? storageNode->GetFileName() : 0);
+    }
+
+  if (vspNode->GetRaycastTechnique() ==
+      vtkMRMLVolumeRenderingDisplayNode::MaximumIntensityProjection)
+    {
+    mapper->SetBlendMode(vtkVolumeMapper::MAXIMUM_INTENSITY_BLEND);
+    }
+  else
+    {
+    mapper->SetBlendMode(vtkVolumeMapper::COMPOSITE_BLEND);
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager
 ::UpdateGPURaycastMapper(
@@ -494,7 +578,8 @@ int vtkMRMLVolumeRenderingDisplayableManager
                            vspNode->GetVolumeNode())->GetImageData() );
 #endif
   int supported = 0;
-  if (volumeMapper->IsA("vtkFixedPointVolumeRayCastMapper"))
+  if (volumeMapper->IsA("vtkFixedPointVolumeRayCastMapper") ||
+      volumeMapper->IsA("vtkSlicerFixedPointVolumeRayCastMapper"))
     {
     supported = 1;
     }
@@ -517,6 +602,15 @@ vtkVolumeMapper* vtkMRMLVolumeRenderingDisplayableManager
     }
   if (vspNode->IsA("vtkMRMLCPURayCastVolumeRenderingDisplayNode"))
     {
+    vtkMRMLCPURayCastVolumeRenderingDisplayNode* cpuNode =
+      vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode);
+    // The Slicer mapper shares its acceleration structures between the
+    // views but does not support minimum intensity projection
+    if (cpuNode->GetRaycastTechnique() !=
+          vtkMRMLVolumeRenderingDisplayNode::MinimumIntensityProjection)
+      {
+      return this->MapperSlicerRaycast;
+      }
     return this->MapperRaycast;
     }
   else if (vspNode->IsA("vtkMRMLGPURayCastVolumeRenderingDisplayNode"))
@@ -607,7 +701,12 @@ bool vtkMRMLVolumeRenderingDisplayableManager::UpdateMapper(
   vtkMRMLVolumeRenderingDisplayNode* vspNode)
 {
   vtkVolumeMapper* volumeMapper = this->GetVolumeMapper(vspNode);
-  if (vspNode->IsA("vtkMRMLCPURayCastVolumeRenderingDisplayNode"))
+  if (volumeMapper && volumeMapper == this->MapperSlicerRaycast)
+    {
+    this->UpdateSlicerCPURaycastMapper(this->MapperSlicerRaycast,
+      vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode));
+    }
+  else if (vspNode->IsA("vtkMRMLCPURayCastVolumeRenderingDisplayNode"))
     {
     this->UpdateCPURaycastMapper(vtkFixedPointVolumeRayCastMapper::SafeDownCast(volumeMapper),
                                  vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode));
@@ -848,11 +947,49 @@ void vtkMRMLVolumeRenderingDisplayableManager::OnCreate()
     vtkObserveMRMLNodeEventsMacro(viewNode, events.GetPointer());
     }
 
+  // Interrupt the progressive CPU ray casting when interaction events are pending
+  vtkRenderWindow* renderWindow = this->GetRenderer() ?
+    this->GetRenderer()->GetRenderWindow() : 0;
+  if (renderWindow != this->AbortCheckRenderWindow.GetPointer())
+    {
+    if (this->AbortCheckRenderWindow)
+      {
+      this->AbortCheckRenderWindow->RemoveObserver(this->AbortCheckCallbackCommand);
+      }
+    this->AbortCheckRenderWindow = renderWindow;
+    if (renderWindow)
+      {
+      renderWindow->AddObserver(vtkCommand::AbortCheckEvent, this->AbortCheckCallbackCommand);
+      }
+    }
+
   this->UpdateDisplayNodeList();
 
   //this->OnVolumeRenderingDisplayNodeModified();
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::AbortCheckCallback(
+  vtkObject* caller, unsigned long vtkNotUsed(eid),
+  void* clientData, void* vtkNotUsed(callData))
+{
+  vtkMRMLVolumeRenderingDisplayableManager* self =
+    reinterpret_cast<vtkMRMLVolumeRenderingDisplayableManager*>(clientData);
+  vtkRenderWindow* renderWindow = vtkRenderWindow::SafeDownCast(caller);
+  // Only the progressive refinement renders the view again after an abort,
+  // otherwise the image would be left incomplete.
+  if (!self || !renderWindow || !self->Volume ||
+      self->Volume->GetMapper() != self->MapperSlicerRaycast ||
+      !self->MapperSlicerRaycast->GetProgressiveRefinement())
+    {
+    return;
+    }
+  if (renderWindow->GetEventPending())
+    {
+    renderWindow->SetAbortRender(1);
+    }
+}
+
 //----------------------------------------------------------------------------
 bool vtkMRMLVolumeRenderingDisplayableManager::EnterMRMLNodesCallback()const
 {
@@ -971,6 +1108,11 @@ void vtkMRMLVolumeRenderingDisplayableManager
         vtkMRMLVolumeRenderingDisplayNode::SafeDownCast(caller));
       }
     }
+  else if (event == vtkSlicerFixedPointVolumeRayCastMapper::RefinementRequiredEvent)
+    {
+    // Render the next pass of the progressive refinement
+    this->RequestRender();
+    }
   else if (event == vtkMRMLScalarVolumeNode::ImageDataModifiedEvent)
     {
     this->SetupMapperFromVolumeNode(this->DisplayedNode);
@@ -1063,6 +1205,8 @@ void vtkMRMLVolumeRenderingDisplayableManager::OnInteractorStyleEvent(int eventi
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       break;
     case vtkCommand::StartInteractionEvent:
+      // Interrupt the progressive refinement, it restarts from a coarse image
+      this->MapperSlicerRaycast->RestartRefinement();
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       //this->SetExpectedFPS(
       //  this->DisplayedNode ? this->DisplayedNode->GetExpectedFPS() : 15);
@@ -30,6 +30,7 @@ class vtkMRMLGPURayCastVolumeRenderingDisplayNode;
 class vtkMRMLVolumeNode;
 class vtkMRMLVolumeRenderingDisplayNode;
 class vtkMRMLVolumeRenderingScenarioNode;
+class vtkSlicerFixedPointVolumeRayCastMapper;
 class vtkSlicerVolumeRenderingLogic;
 class vtkVolumeProperty;
 
@@ -37,9 +38,12 @@ class vtkVolumeProperty;
 #include <vtkMRMLAbstractThreeDViewDisplayableManager.h>
 
 // VTK includes
+#include <vtkWeakPointer.h>
+class vtkCallbackCommand;
 class vtkIntArray;
 class vtkMatrix4x4;
 class vtkPlanes;
+class vtkRenderWindow;
 class vtkTimerLog;
 class vtkVolume;
 class vtkVolumeMapper;
@@ -63,7 +67,12 @@ public:
   virtual void Create();
 
   ///
-  /// Return the volume mapper of the volume rendering display node
+  /// Return the volume mapper of the volume rendering display node.
+  /// The CPU ray cast node uses vtkSlicerFixedPointVolumeRayCastMapper,
+  /// which shares the gradient and space leaping structures of
+  /// vtkSlicerFixedPointVolumeRayCastCache between the views and refines
+  /// the image progressively when the render time budget is not 0. Minimum
+  /// intensity projection uses vtkFixedPointVolumeRayCastMapper.
   virtual vtkVolumeMapper* GetVolumeMapper(vtkMRMLVolumeRenderingDisplayNode* vspNode);
 
   ///
@@ -97,6 +106,8 @@ public:
                     vtkMRMLVolumeRenderingDisplayNode* vspNode);
   void UpdateCPURaycastMapper(vtkFixedPointVolumeRayCastMapper* mapper,
                               vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode);
+  void UpdateSlicerCPURaycastMapper(vtkSlicerFixedPointVolumeRayCastMapper* mapper,
+                                         vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode);
   void UpdateGPURaycastMapper(vtkGPUVolumeRayCastMapper* mapper,
                               vtkMRMLGPURayCastVolumeRenderingDisplayNode* vspNode);
   void UpdateDesiredUpdateRate(vtkMRMLVolumeRenderingDisplayNode* vspNode);
@@ -134,6 +145,13 @@ public:
 
   static int DefaultGPUMemorySize;
 
+  /// Read and write the CPU ray casting acceleration structures in files
+  /// next to the volumes, to not compute them again in the next sessions.
+  /// Off by default.
+  /// \sa vtkSlicerFixedPointVolumeRayCastCache::SetPersistent
+  static void SetPersistentAccelerationStructures(bool persistent);
+  static bool GetPersistentAccelerationStructures();
+
 protected:
   vtkMRMLVolumeRenderingDisplayableManager();
   ~vtkMRMLVolumeRenderingDisplayableManager();
@@ -154,6 +172,12 @@ protected:
 
   virtual void OnInteractorStyleEvent(int eventId);
 
+  // Description:
+  // Observer of the render window AbortCheckEvent: abort the render of the
+  // progressive CPU mapper if interaction events are pending.
+  static void AbortCheckCallback(vtkObject* caller, unsigned long eid,
+                                 void* clientData, void* callData);
+
   //virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
 
   //virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
@@ -168,6 +192,17 @@ protected:
   // The software accelerated software mapper
   vtkFixedPointVolumeRayCastMapper *MapperRaycast;
 
+  // Description:
+  // The software mapper sharing its acceleration structures between views.
+  // When the CPU display node has a render time budget, it renders a
+  // coarse image first and refines it progressively.
+  vtkSlicerFixedPointVolumeRayCastMapper *MapperSlicerRaycast;
+
+  // Description:
+  // Render window observed for AbortCheckEvent and its observer.
+  vtkWeakPointer<vtkRenderWindow> AbortCheckRenderWindow;
+  vtkCallbackCommand* AbortCheckCallbackCommand;
+
   // Description:
   // The gpu ray cast mapper.
   vtkGPUVolumeRayCastMapper *MapperGPURaycast3;
@@ -0,0 +1,377 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRenderingReplacements includes
+#include "vtkSlicerFixedPointVolumeRayCastCache.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnsignedShortArray.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Cube of \a size voxels with a ball of 1000 in its center.
+void CreateBall(vtkImageData* image, int size)
+{
+  image->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  image->SetScalarTypeToShort();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+#else
+  image->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* scalars = static_cast<short*>(image->GetScalarPointer());
+  double center = (size - 1) / 2.;
+  double radius2 = (size / 4.) * (size / 4.);
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        double distance2 = (i - center) * (i - center) +
+          (j - center) * (j - center) + (k - center) * (k - center);
+        *(scalars++) = (distance2 <= radius2) ? 1000 : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool SameValues(vtkDataArray* array1, vtkDataArray* array2)
+{
+  if (!array1 || !array2 ||
+      array1->GetNumberOfTuples() != array2->GetNumberOfTuples() ||
+      array1->GetNumberOfComponents() != array2->GetNumberOfComponents() ||
+      array1->GetDataTypeSize() != array2->GetDataTypeSize())
+    {
+    return false;
+    }
+  return memcmp(array1->GetVoidPointer(0), array2->GetVoidPointer(0),
+                array1->GetNumberOfTuples() * array1->GetNumberOfComponents() *
+                array1->GetDataTypeSize()) == 0;
+}
+
+//----------------------------------------------------------------------------
+// The shift and scale mapping [0, 1000] to the scalar indices.
+float Shift[4] = { 0.f, 0.f, 0.f, 0.f };
+float Scale[4] = { 32.767f, 1.f, 1.f, 1.f };
+
+//----------------------------------------------------------------------------
+bool TestSharing()
+{
+  vtkSlicerFixedPointVolumeRayCastCache* cache =
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), 32);
+
+  // Same structures whatever the number of threads
+  cache->SetNumberOfThreads(1);
+  vtkSmartPointer<vtkUnsignedShortArray> normals;
+  vtkSmartPointer<vtkUnsignedCharArray> magnitudes;
+  int size[4];
+  if (!cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes) ||
+      !normals || !magnitudes ||
+      normals->GetNumberOfTuples() != 32 * 32 * 32)
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to compute gradients" << std::endl;
+    return false;
+    }
+  vtkSmartPointer<vtkUnsignedShortArray> singleThreadNormals = normals;
+  vtkSmartPointer<vtkUnsignedCharArray> singleThreadMagnitudes = magnitudes;
+  vtkSmartPointer<vtkUnsignedShortArray> singleThreadMinMax =
+    cache->GetMinMaxVolume(image.GetPointer(), 1, Shift, Scale, 1, size);
+  if (!singleThreadMinMax || size[0] != 8 || size[1] != 8 || size[2] != 8 || size[3] != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Failed to compute the min/max volume" << std::endl;
+    return false;
+    }
+
+  cache->RemoveAllEntries();
+  cache->SetNumberOfThreads(4);
+  int computedEntries = cache->GetNumberOfComputedEntries();
+  cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes);
+  vtkSmartPointer<vtkUnsignedShortArray> minMax =
+    cache->GetMinMaxVolume(image.GetPointer(), 1, Shift, Scale, 1, size);
+  if (!SameValues(normals, singleThreadNormals) ||
+      !SameValues(magnitudes, singleThreadMagnitudes) ||
+      !SameValues(minMax, singleThreadMinMax) ||
+      cache->GetNumberOfComputedEntries() != computedEntries + 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Structures depend on the number of threads" << std::endl;
+    return false;
+    }
+
+  // The maximum gradient magnitudes are filled in the upper 8 bits
+  bool gradientFound = false;
+  for (vtkIdType i = 0; i < minMax->GetNumberOfTuples(); ++i)
+    {
+    gradientFound = gradientFound || (minMax->GetValue(3 * i + 2) >> 8) != 0;
+    }
+  if (!gradientFound)
+    {
+    std::cerr << "Line " << __LINE__ << " - No maximum gradient magnitude" << std::endl;
+    return false;
+    }
+
+  // A second mapper (dependent components are the same for a single
+  // component image) gets the same arrays
+  vtkSmartPointer<vtkUnsignedShortArray> sharedNormals;
+  vtkSmartPointer<vtkUnsignedCharArray> sharedMagnitudes;
+  cache->GetGradients(image.GetPointer(), 0, 0, sharedNormals, sharedMagnitudes);
+  if (sharedNormals != normals || sharedMagnitudes != magnitudes ||
+      cache->GetMinMaxVolume(image.GetPointer(), 1, Shift, Scale, 1, size) != minMax ||
+      cache->GetNumberOfComputedEntries() != computedEntries + 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - Structures are not shared" << std::endl;
+    return false;
+    }
+
+  // Modified scalars are recomputed and replace the older entries
+  image->Modified();
+  cache->GetGradients(image.GetPointer(), 1, 0, sharedNormals, sharedMagnitudes);
+  if (cache->GetNumberOfComputedEntries() != computedEntries + 3 ||
+      cache->GetNumberOfEntries() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Modified image not recomputed: "
+              << cache->GetNumberOfEntries() << " entries" << std::endl;
+    return false;
+    }
+
+  // Least recently used entries are removed when the cache is full
+  vtkNew<vtkImageData> image2;
+  CreateBall(image2.GetPointer(), 32);
+  unsigned long maximumMemorySize = cache->GetMaximumMemorySize();
+  cache->SetMaximumMemorySize(cache->GetMemorySize());
+  cache->GetGradients(image2.GetPointer(), 1, 0, normals, magnitudes);
+  cache->SetMaximumMemorySize(maximumMemorySize);
+  if (cache->GetNumberOfEntries() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << cache->GetNumberOfEntries()
+              << " entries instead of 1" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestDeletion()
+{
+  vtkSlicerFixedPointVolumeRayCastCache* cache =
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+  cache->RemoveAllEntries();
+  vtkSmartPointer<vtkUnsignedShortArray> normals;
+  {
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), 16);
+  vtkSmartPointer<vtkUnsignedShortArray> imageNormals;
+  vtkSmartPointer<vtkUnsignedCharArray> imageMagnitudes;
+  cache->GetGradients(image.GetPointer(), 1, 0, imageNormals, imageMagnitudes);
+  // A mapper keeps using its arrays
+  normals = imageNormals;
+  }
+  if (cache->GetNumberOfEntries() != 0 || normals->GetNumberOfTuples() != 16 * 16 * 16)
+    {
+    std::cerr << "Line " << __LINE__ << " - Entries of a deleted image are kept" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Observer of the gradients computation using the cache for another image.
+void ComputeOtherGradients(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                           void* clientData, void* vtkNotUsed(callData))
+{
+  vtkSmartPointer<vtkUnsignedShortArray> normals;
+  vtkSmartPointer<vtkUnsignedCharArray> magnitudes;
+  vtkSlicerFixedPointVolumeRayCastCache::GetInstance()->GetGradients(
+    reinterpret_cast<vtkImageData*>(clientData), 1, 0, normals, magnitudes);
+}
+
+//----------------------------------------------------------------------------
+void ModifyImage(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                 void* clientData, void* vtkNotUsed(callData))
+{
+  reinterpret_cast<vtkImageData*>(clientData)->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool TestReentrancy()
+{
+  vtkSlicerFixedPointVolumeRayCastCache* cache =
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+  cache->RemoveAllEntries();
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), 16);
+  vtkNew<vtkImageData> otherImage;
+  CreateBall(otherImage.GetPointer(), 16);
+
+  // The progress observers are called without the cache lock, they can
+  // use the cache (e.g. render another view) without a deadlock.
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(ComputeOtherGradients);
+  callback->SetClientData(otherImage.GetPointer());
+  vtkNew<vtkImageData> progressObject;
+  progressObject->AddObserver(vtkCommand::VolumeMapperComputeGradientsStartEvent,
+                              callback.GetPointer());
+  vtkSmartPointer<vtkUnsignedShortArray> normals;
+  vtkSmartPointer<vtkUnsignedCharArray> magnitudes;
+  cache->GetGradients(image.GetPointer(), 1, progressObject.GetPointer(),
+                      normals, magnitudes);
+  if (!normals || !magnitudes || cache->GetNumberOfEntries() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << cache->GetNumberOfEntries()
+              << " entries instead of 2" << std::endl;
+    return false;
+    }
+
+  // Entries of scalars modified while computing them are not cached
+  callback->SetCallback(ModifyImage);
+  callback->SetClientData(image.GetPointer());
+  cache->RemoveAllEntries();
+  cache->GetGradients(image.GetPointer(), 1, progressObject.GetPointer(),
+                      normals, magnitudes);
+  if (!normals || cache->GetNumberOfEntries() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Entry of modified scalars was cached" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestPersistence(const std::string& temporaryDirectory)
+{
+  vtkSlicerFixedPointVolumeRayCastCache* cache =
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+  cache->RemoveAllEntries();
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), 32);
+  std::string fileName = temporaryDirectory + "/vtkSlicerFixedPointVolumeRayCastCacheTest1.nrrd";
+  cache->SetFileName(image.GetPointer(), fileName.c_str());
+  cache->PersistentOn();
+
+  // Computed and written
+  vtkSmartPointer<vtkUnsignedShortArray> normals;
+  vtkSmartPointer<vtkUnsignedCharArray> magnitudes;
+  cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes);
+  vtkSmartPointer<vtkUnsignedShortArray> computedNormals = normals;
+  vtkSmartPointer<vtkUnsignedCharArray> computedMagnitudes = magnitudes;
+
+  // Read back in the next session
+  cache->RemoveAllEntries();
+  int readEntries = cache->GetNumberOfReadEntries();
+  cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes);
+  if (cache->GetNumberOfReadEntries() != readEntries + 1 ||
+      !SameValues(normals, computedNormals) ||
+      !SameValues(magnitudes, computedMagnitudes))
+    {
+    std::cerr << "Line " << __LINE__ << " - Gradients not read from " << fileName << std::endl;
+    return false;
+    }
+
+  // The file is not used for different scalars
+  cache->RemoveAllEntries();
+  static_cast<short*>(image->GetScalarPointer())[0] = 1;
+  image->Modified();
+  cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes);
+  if (cache->GetNumberOfReadEntries() != readEntries + 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - File of different scalars was used" << std::endl;
+    return false;
+    }
+  cache->PersistentOff();
+  cache->SetFileName(image.GetPointer(), 0);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestBenchmark(int size)
+{
+  vtkSlicerFixedPointVolumeRayCastCache* cache =
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), size);
+  vtkNew<vtkTimerLog> timer;
+  int numberOfThreads[2] = { 1, 4 };
+  for (int i = 0; i < 2; ++i)
+    {
+    cache->RemoveAllEntries();
+    cache->SetNumberOfThreads(numberOfThreads[i]);
+    vtkSmartPointer<vtkUnsignedShortArray> normals;
+    vtkSmartPointer<vtkUnsignedCharArray> magnitudes;
+    int minMaxSize[4];
+    timer->StartTimer();
+    cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes);
+    cache->GetMinMaxVolume(image.GetPointer(), 1, Shift, Scale, 1, minMaxSize);
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"vtkSlicerFixedPointVolumeRayCastCache-Compute-"
+              << size << "-" << numberOfThreads[i] << "Threads\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+    }
+  // Another view gets the cached structures
+  vtkSmartPointer<vtkUnsignedShortArray> normals;
+  vtkSmartPointer<vtkUnsignedCharArray> magnitudes;
+  timer->StartTimer();
+  cache->GetGradients(image.GetPointer(), 1, 0, normals, magnitudes);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkSlicerFixedPointVolumeRayCastCache-Cached-"
+            << size << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  cache->RemoveAllEntries();
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerFixedPointVolumeRayCastCacheTest1(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  bool res = true;
+  res = res && TestSharing();
+  res = res && TestDeletion();
+  res = res && TestReentrancy();
+  res = res && TestPersistence(argv[1]);
+  res = res && TestBenchmark(128);
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,419 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRenderingReplacements includes
+#include "vtkSlicerFixedPointRayCastImage.h"
+#include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkTimerLog.h>
+#include <vtkVersion.h>
+#include <vtkVolume.h>
+#include <vtkVolumeProperty.h>
+
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Give access to the tile scheduling without rendering.
+class vtkTileSchedulingMapper : public vtkSlicerFixedPointVolumeRayCastMapper
+{
+public:
+  static vtkTileSchedulingMapper* New();
+  vtkTypeMacro(vtkTileSchedulingMapper, vtkSlicerFixedPointVolumeRayCastMapper);
+
+  // Split numberOfRows rows into tiles, like a render does.
+  void InitializeTiles(int numberOfRows)
+    {
+    this->RayCastImage->SetImageInUseSize(1, numberOfRows);
+    this->Superclass::InitializeTiles();
+    }
+
+protected:
+  vtkTileSchedulingMapper(){}
+  ~vtkTileSchedulingMapper(){}
+};
+vtkStandardNewMacro(vtkTileSchedulingMapper);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct TileRecorder
+{
+  vtkTileSchedulingMapper* Mapper;
+  // Rows rendered by each thread
+  std::vector<std::vector<int> > Rows;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE RenderTiles(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  TileRecorder* recorder = static_cast<TileRecorder*>(info->UserData);
+  int firstRow = 0;
+  int endRow = 0;
+  while (recorder->Mapper->GetNextTile(info->ThreadID, firstRow, endRow))
+    {
+    for (int j = firstRow; j < endRow; ++j)
+      {
+      recorder->Rows[info->ThreadID].push_back(j);
+      }
+    // The first thread is slow, the others steal its tiles
+    if (info->ThreadID == 0)
+      {
+      vtksys::SystemTools::Delay(2);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool TestTileScheduling(int numberOfRows, int numberOfThreads)
+{
+  vtkNew<vtkTileSchedulingMapper> mapper;
+  mapper->SetNumberOfThreads(numberOfThreads);
+  mapper->InitializeTiles(numberOfRows);
+
+  TileRecorder recorder;
+  recorder.Mapper = mapper.GetPointer();
+  recorder.Rows.resize(numberOfThreads);
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(RenderTiles, &recorder);
+  threader->SingleMethodExecute();
+
+  std::vector<int> renderCount(numberOfRows, 0);
+  for (int t = 0; t < numberOfThreads; ++t)
+    {
+    for (size_t i = 0; i < recorder.Rows[t].size(); ++i)
+      {
+      ++renderCount[recorder.Rows[t][i]];
+      }
+    }
+  for (int j = 0; j < numberOfRows; ++j)
+    {
+    if (renderCount[j] != 1)
+      {
+      std::cerr << "Line " << __LINE__ << " - Row " << j << " of " << numberOfRows
+                << " rendered " << renderCount[j] << " times by "
+                << numberOfThreads << " threads" << std::endl;
+      return false;
+      }
+    }
+  if (numberOfThreads > 1 && numberOfRows >= 16 * numberOfThreads &&
+      mapper->GetNumberOfStolenTiles() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - No tile was stolen from the slow thread" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Cube of size voxels with a ball whose intensity decreases from its center.
+void CreateBall(vtkImageData* image, int size)
+{
+  image->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  image->SetScalarTypeToShort();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+#else
+  image->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* scalars = static_cast<short*>(image->GetScalarPointer());
+  double center = (size - 1) / 2.;
+  double radius2 = (size / 3.) * (size / 3.);
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        double distance2 = (i - center) * (i - center) +
+          (j - center) * (j - center) + (k - center) * (k - center);
+        *(scalars++) = (distance2 <= radius2) ?
+          static_cast<short>(1000. * (1. - 0.5 * distance2 / radius2)) : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Pixels of the image rendered by the last render, at the resolution of
+// the image sample distance.
+std::vector<unsigned short> GetRayCastImage(vtkSlicerFixedPointVolumeRayCastMapper* mapper)
+{
+  vtkSlicerFixedPointRayCastImage* image = mapper->GetRayCastImage();
+  int inUseSize[2];
+  int memorySize[2];
+  image->GetImageInUseSize(inUseSize);
+  image->GetImageMemorySize(memorySize);
+  std::vector<unsigned short> pixels;
+  for (int j = 0; j < inUseSize[1]; ++j)
+    {
+    unsigned short* row = image->GetImage() + 4 * j * memorySize[0];
+    pixels.insert(pixels.end(), row, row + 4 * inUseSize[0]);
+    }
+  return pixels;
+}
+
+//----------------------------------------------------------------------------
+void CountEvents(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                 void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+//----------------------------------------------------------------------------
+// Abort the render as an observer that finds pending interaction events would
+void AbortRender(vtkObject* caller, unsigned long vtkNotUsed(eid),
+                 void* vtkNotUsed(clientData), void* vtkNotUsed(callData))
+{
+  vtkRenderWindow::SafeDownCast(caller)->SetAbortRender(1);
+}
+
+//----------------------------------------------------------------------------
+bool TestRendering()
+{
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), 64);
+
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> mapper;
+#if (VTK_MAJOR_VERSION <= 5)
+  mapper->SetInput(image.GetPointer());
+#else
+  mapper->SetInputData(image.GetPointer());
+#endif
+  mapper->AutoAdjustSampleDistancesOff();
+  mapper->SetImageSampleDistance(1.);
+
+  vtkNew<vtkColorTransferFunction> color;
+  color->AddRGBPoint(0., 0., 0., 0.);
+  color->AddRGBPoint(500., 1., 0.5, 0.);
+  color->AddRGBPoint(1000., 1., 1., 1.);
+  vtkNew<vtkPiecewiseFunction> opacity;
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(400., 0.);
+  opacity->AddPoint(1000., 0.2);
+  vtkNew<vtkVolumeProperty> property;
+  property->SetColor(color.GetPointer());
+  property->SetScalarOpacity(opacity.GetPointer());
+  property->SetInterpolationTypeToLinear();
+  property->ShadeOn();
+
+  vtkNew<vtkVolume> volume;
+  volume->SetMapper(mapper.GetPointer());
+  volume->SetProperty(property.GetPointer());
+
+  vtkNew<vtkRenderer> renderer;
+  renderer->AddVolume(volume.GetPointer());
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->SetSize(300, 300);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderer->ResetCamera();
+  renderer->GetActiveCamera()->Azimuth(30.);
+  renderer->GetActiveCamera()->Elevation(20.);
+
+  // Reference image rendered by a single thread
+  mapper->SetNumberOfThreads(1);
+  renderWindow->Render();
+  std::vector<unsigned short> singleThreadImage = GetRayCastImage(mapper.GetPointer());
+  vtkTypeInt64 singleThreadRays = mapper->GetNumberOfCastRays();
+  if (singleThreadRays == 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - The volume was not rendered" << std::endl;
+    return false;
+    }
+
+  // The tiles rendered by several threads make the same image, each ray
+  // is cast once.
+  int numberOfThreads[3] = { 2, 3, 8 };
+  for (int i = 0; i < 3; ++i)
+    {
+    mapper->SetNumberOfThreads(numberOfThreads[i]);
+    renderWindow->Render();
+    if (GetRayCastImage(mapper.GetPointer()) != singleThreadImage ||
+        mapper->GetNumberOfCastRays() != singleThreadRays)
+      {
+      std::cerr << "Line " << __LINE__ << " - Image rendered by " << numberOfThreads[i]
+                << " threads (" << mapper->GetNumberOfCastRays() << " rays) differs from"
+                << " the single thread image (" << singleThreadRays << " rays)" << std::endl;
+      return false;
+      }
+    }
+
+  // Progressive refinement ends with the full resolution image
+  int refinementRequiredEvents = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountEvents);
+  callback->SetClientData(&refinementRequiredEvents);
+  mapper->AddObserver(vtkSlicerFixedPointVolumeRayCastMapper::RefinementRequiredEvent,
+                      callback.GetPointer());
+  mapper->SetNumberOfThreads(4);
+  mapper->SetMaximumImageSampleDistance(8.);
+  mapper->SetRenderTimeBudget(0.001);
+  mapper->ProgressiveRefinementOn();
+  const int maximumNumberOfPasses = 10;
+  int numberOfPasses = 0;
+  float previousImageSampleDistance = VTK_FLOAT_MAX;
+  while (numberOfPasses < maximumNumberOfPasses && !mapper->GetRefinementComplete())
+    {
+    renderWindow->Render();
+    ++numberOfPasses;
+    if (mapper->GetImageSampleDistance() > previousImageSampleDistance)
+      {
+      std::cerr << "Line " << __LINE__ << " - Pass " << numberOfPasses
+                << " is coarser than the previous one: "
+                << mapper->GetImageSampleDistance() << std::endl;
+      return false;
+      }
+    previousImageSampleDistance = mapper->GetImageSampleDistance();
+    }
+  if (!mapper->GetRefinementComplete() ||
+      mapper->GetImageSampleDistance() != mapper->GetMinimumImageSampleDistance() ||
+      refinementRequiredEvents != numberOfPasses - 1 ||
+      GetRayCastImage(mapper.GetPointer()) != singleThreadImage)
+    {
+    std::cerr << "Line " << __LINE__ << " - Refinement did not converge to the full"
+              << " resolution image after " << numberOfPasses << " passes ("
+              << refinementRequiredEvents << " refinement events, image sample distance: "
+              << mapper->GetImageSampleDistance() << ")" << std::endl;
+    return false;
+    }
+  std::cout << "<DartMeasurement name=\"vtkSlicerFixedPointVolumeRayCastMapper-RefinementPasses\""
+            << " type=\"numeric/integer\">" << numberOfPasses << "</DartMeasurement>" << std::endl;
+
+  // A camera change restarts the refinement
+  renderer->GetActiveCamera()->Azimuth(10.);
+  refinementRequiredEvents = 0;
+  renderWindow->Render();
+  if (mapper->GetRefinementComplete() || refinementRequiredEvents != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Refinement did not restart" << std::endl;
+    return false;
+    }
+  float coarseImageSampleDistance = mapper->GetImageSampleDistance();
+
+  // An aborted fine pass restarts the refinement at the coarse level
+  renderWindow->Render();
+  float fineImageSampleDistance = mapper->GetImageSampleDistance();
+  if (fineImageSampleDistance >= coarseImageSampleDistance)
+    {
+    std::cerr << "Line " << __LINE__ << " - Second pass is not finer than the first one: "
+              << fineImageSampleDistance << " >= " << coarseImageSampleDistance << std::endl;
+    return false;
+    }
+  vtkNew<vtkCallbackCommand> abortCallback;
+  abortCallback->SetCallback(AbortRender);
+  unsigned long abortObserver =
+    renderWindow->AddObserver(vtkCommand::AbortCheckEvent, abortCallback.GetPointer());
+  refinementRequiredEvents = 0;
+  renderWindow->Render();
+  renderWindow->RemoveObserver(abortObserver);
+  if (mapper->GetRefinementComplete() || refinementRequiredEvents != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Aborted pass did not request a new pass ("
+              << refinementRequiredEvents << " refinement events)" << std::endl;
+    return false;
+    }
+  renderWindow->Render();
+  if (mapper->GetImageSampleDistance() <= fineImageSampleDistance)
+    {
+    std::cerr << "Line " << __LINE__ << " - Refinement did not restart at the coarse level"
+              << " after an abort: " << mapper->GetImageSampleDistance() << " <= "
+              << fineImageSampleDistance << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestBenchmark()
+{
+  vtkNew<vtkImageData> image;
+  CreateBall(image.GetPointer(), 128);
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> mapper;
+#if (VTK_MAJOR_VERSION <= 5)
+  mapper->SetInput(image.GetPointer());
+#else
+  mapper->SetInputData(image.GetPointer());
+#endif
+  mapper->AutoAdjustSampleDistancesOff();
+  vtkNew<vtkPiecewiseFunction> opacity;
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(1000., 0.1);
+  vtkNew<vtkVolumeProperty> property;
+  property->SetScalarOpacity(opacity.GetPointer());
+  vtkNew<vtkVolume> volume;
+  volume->SetMapper(mapper.GetPointer());
+  volume->SetProperty(property.GetPointer());
+  vtkNew<vtkRenderer> renderer;
+  renderer->AddVolume(volume.GetPointer());
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->SetSize(400, 400);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderer->ResetCamera();
+  renderWindow->Render();
+
+  vtkNew<vtkTimerLog> timer;
+  int numberOfThreads[2] = { 1, 4 };
+  for (int i = 0; i < 2; ++i)
+    {
+    mapper->SetNumberOfThreads(numberOfThreads[i]);
+    timer->StartTimer();
+    renderWindow->Render();
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"vtkSlicerFixedPointVolumeRayCastMapper-Render-"
+              << numberOfThreads[i] << "Threads\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerFixedPointVolumeRayCastMapperTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  bool res = true;
+  res = res && TestTileScheduling(1, 4);
+  res = res && TestTileScheduling(7, 4);
+  res = res && TestTileScheduling(300, 1);
+  res = res && TestTileScheduling(300, 4);
+  res = res && TestTileScheduling(1000, 7);
+  res = res && TestRendering();
+  res = res && TestBenchmark();
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1308 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkSlicerFixedPointVolumeRayCastCache.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkCriticalSection.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphericalDirectionEncoder.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnsignedShortArray.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <string>
+
+namespace
+{
+
+enum EntryType
+{
+  GradientsEntry = 0,
+  MinMaxEntry,
+  MinMaxWithGradientsEntry
+};
+
+// Suffix of the files persisting each type of entry
+const char* EntryFileSuffixes[3] = { ".gradients", ".minmax", ".minmaxgradients" };
+
+const char EntryFileSignature[] = "vtkSlicerFixedPointVolumeRayCastCache 1\n";
+
+//----------------------------------------------------------------------------
+// Arguments of the threaded computations.
+struct ThreadArguments
+{
+  vtkImageData*         Input;
+  int                   Independent;
+  double                ScalarRange[4][2];
+  unsigned short*       GradientNormal;
+  unsigned char*        GradientMagnitude;
+  vtkDirectionEncoder*  DirectionEncoder;
+  vtkObject*            ProgressObject;
+  unsigned short*       MinMaxVolume;
+  int                   MinMaxVolumeSize[4];
+  float*                Shift;
+  float*                Scale;
+};
+
+//----------------------------------------------------------------------------
+// Compute the encoded normals and magnitudes of the slices of the thread.
+// Moved from vtkSlicerFixedPointVolumeRayCastMapper where it was always
+// called with a single thread.
+template <class T>
+void ComputeGradients( T *dataPtr,
+                       int dim[3],
+                       double spacing[3],
+                       int components,
+                       int independent,
+                       double scalarRange[4][2],
+                       unsigned short *gradientNormal,
+                       unsigned char  *gradientMagnitude,
+                       vtkDirectionEncoder *directionEncoder,
+                       vtkObject *progressObject,
+                       int threadId,
+                       int threadCount )
+{
+  int                 x, y, z, c;
+  int                 x_start, x_limit;
+  int                 y_start, y_limit;
+  int                 z_start, z_limit;
+  T                   *dptr, *cdptr;
+  float               n[3], t;
+  float               gvalue=0;
+  int                 xlow, xhigh;
+  double              aspect[3];
+  vtkIdType           xstep, ystep, zstep;
+  float               scale[4];
+  unsigned short      *dirPtr, *cdirPtr;
+  unsigned char       *magPtr, *cmagPtr;
+
+  double avgSpacing = (spacing[0]+spacing[1]+spacing[2])/3.0;
+
+  // adjust the aspect
+  aspect[0] = spacing[0] * 2.0 / avgSpacing;
+  aspect[1] = spacing[1] * 2.0 / avgSpacing;
+  aspect[2] = spacing[2] * 2.0 / avgSpacing;
+
+  // Compute steps through the volume in x, y, and z
+  xstep = components;
+  ystep = components*dim[0];
+  zstep = static_cast<vtkIdType>(components)*dim[0] * dim[1];
+
+  if ( !independent )
+    {
+    if ( scalarRange[components-1][1] - scalarRange[components-1][0] )
+      {
+      scale[0] = 255.0 / (0.25*(scalarRange[components-1][1] - scalarRange[components-1][0]));
+      }
+    else
+      {
+      scale[0] = 0.0;
+      }
+    }
+  else
+    {
+    for (c = 0; c < components; c++ )
+      {
+      if ( scalarRange[c][1] - scalarRange[c][0] )
+        {
+        scale[c] = 255.0 / (0.25*(scalarRange[c][1] - scalarRange[c][0]));
+        }
+      else
+        {
+        scale[c] = 1.0;
+        }
+      }
+    }
+
+  x_start = 0;
+  x_limit = dim[0];
+  y_start = 0;
+  y_limit = dim[1];
+  z_start = (int)(( (float)threadId / (float)threadCount ) *
+                  dim[2] );
+  z_limit = (int)(( (float)(threadId + 1) / (float)threadCount ) *
+                  dim[2] );
+
+  // Do final error checking on limits - make sure they are all within bounds
+  // of the scalar input
+  x_start = (x_start<0)?(0):(x_start);
+  y_start = (y_start<0)?(0):(y_start);
+  z_start = (z_start<0)?(0):(z_start);
+
+  x_limit = (x_limit>dim[0])?(dim[0]):(x_limit);
+  y_limit = (y_limit>dim[1])?(dim[1]):(y_limit);
+  z_limit = (z_limit>dim[2])?(dim[2]):(z_limit);
+
+  int increment = (independent)?(components):(1);
+  vtkIdType sliceSize = static_cast<vtkIdType>(dim[0])*dim[1]*increment;
+
+  float tolerance[4];
+  for ( c = 0; c < components; c++ )
+    {
+    tolerance[c] = .00001 * (scalarRange[c][1] - scalarRange[c][0]);
+    }
+
+  T *lastPixel = dataPtr + zstep*dim[2] - 1;
+
+  // Loop through the slices of the thread and compute the encoded normal
+  // and gradient magnitude for each scalar location
+  for ( z = z_start; z < z_limit; z++ )
+    {
+    unsigned short *gradientDirPtr = gradientNormal + z*sliceSize;
+    unsigned char *gradientMagPtr = gradientMagnitude + z*sliceSize;
+
+    for ( y = y_start; y < y_limit; y++ )
+      {
+      xlow = x_start;
+      xhigh = x_limit;
+
+      dptr = dataPtr + z*zstep + components*(y * dim[0] + xlow);
+
+      dirPtr  = gradientDirPtr    + (y * dim[0] + xlow)*increment;
+      magPtr  = gradientMagPtr    + (y * dim[0] + xlow)*increment;
+
+      for ( x = xlow; x < xhigh; x++ )
+        {
+        for ( c = 0; ( independent && c < components ) || c == 0; c++ )
+          {
+          cdptr   = dptr   + ((independent)?(c):(components-1));
+          cdirPtr = dirPtr + ((independent)?(c):(0));
+          cmagPtr = magPtr + ((independent)?(c):(0));
+
+          // Allow up to 3 tries to find the gadient - looking out at a distance of
+          // 1, 2, and 3 units.
+          int foundGradient = 0;
+          for ( int d = 1; d <= 3 && !foundGradient; d++ )
+            {
+            // Use a central difference method if possible,
+            // otherwise use a forward or backward difference if
+            // we are on the edge
+            // Compute the X component
+            if ( x < d && (cdptr+d*xstep) <= lastPixel )
+              {
+              n[0] = 2.0*((float)*(cdptr) - (float)*(cdptr+d*xstep));
+              }
+            else if ( x >= dim[0] - d && (cdptr-d*xstep) >= dataPtr )
+              {
+              n[0] = 2.0*((float)*(cdptr-d*xstep) - (float)*(cdptr));
+              }
+            else if ( (cdptr+d*xstep) <= lastPixel && (cdptr-d*xstep) >= dataPtr )
+              {
+              n[0] = (float)*(cdptr-d*xstep) - (float)*(cdptr+d*xstep);
+              }
+            else
+              {
+              n[0] = 0;
+              }
+
+            // Compute the Y component
+            if ( y < d && (cdptr+d*ystep) <= lastPixel )
+              {
+              n[1] = 2.0*((float)*(cdptr) - (float)*(cdptr+d*ystep));
+              }
+            else if ( y >= dim[1] - d && (cdptr-d*ystep) >= dataPtr )
+              {
+              n[1] = 2.0*((float)*(cdptr-d*ystep) - (float)*(cdptr));
+              }
+            else if ( (cdptr+d*ystep) <= lastPixel && (cdptr-d*ystep) >= dataPtr )
+              {
+              n[1] = (float)*(cdptr-d*ystep) - (float)*(cdptr+d*ystep);
+              }
+            else
+              {
+              n[1] = 0;
+              }
+
+            // Compute the Z component
+            if ( z < d && (cdptr+d*zstep) <= lastPixel )
+              {
+              n[2] = 2.0*((float)*(cdptr) - (float)*(cdptr+d*zstep));
+              }
+            else if ( z >= dim[2] - d && (cdptr-d*zstep) >= dataPtr )
+              {
+              n[2] = 2.0*((float)*(cdptr-d*zstep) - (float)*(cdptr));
+              }
+            else if ( (cdptr+d*zstep) <= lastPixel && (cdptr-d*zstep) >= dataPtr )
+              {
+              n[2] = (float)*(cdptr-d*zstep) - (float)*(cdptr+d*zstep);
+              }
+            else
+              {
+              n[2] = 0;
+              }
+
+            // Take care of the aspect ratio of the data
+            // Scaling in the vtkVolume is isotropic, so this is the
+            // only place we have to worry about non-isotropic scaling.
+            n[0] /= d*aspect[0];
+            n[1] /= d*aspect[1];
+            n[2] /= d*aspect[2];
+
+            // Compute the gradient magnitude
+            t = sqrt( (double)( n[0]*n[0] +
+                                n[1]*n[1] +
+                                n[2]*n[2] ) );
+
+            // Encode this into an 8 bit value
+            gvalue = t * scale[c];
+
+            if ( d > 1 )
+              {
+              gvalue = 0;
+              }
+
+            gvalue = (gvalue<0.0)?(0.0):(gvalue);
+            gvalue = (gvalue>255.0)?(255.0):(gvalue);
+
+            // Normalize the gradient direction
+            if ( t > tolerance[c] )
+              {
+              n[0] /= t;
+              n[1] /= t;
+              n[2] /= t;
+              foundGradient = 1;
+              }
+            else
+              {
+              n[0] = n[1] = n[2] = 0.0;
+              }
+            }
+
+          *cmagPtr = static_cast<unsigned char>(gvalue + 0.5);
+          *cdirPtr = directionEncoder->GetEncodedDirection( n );
+          }
+
+        dptr    +=   components;
+        dirPtr  +=   increment;
+        magPtr  +=   increment;
+        }
+      }
+    // The first thread runs in the calling thread and reports the
+    // progress for all of them, they all have the same amount of work.
+    if ( threadId == 0 && progressObject && z%8 == 7 )
+      {
+      float args[1];
+      args[0] =
+        static_cast<float>(z - z_start) /
+        static_cast<float>(std::max(z_limit - z_start - 1, 1));
+      progressObject->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsProgressEvent, args );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Fill in the min/max values of the cells [zStart, zEnd) of the min/max
+// volume. Only the samples of these cells are read, so threads working on
+// different cells never write the same element.
+template <class T>
+void FillInMinMaxVolume( T *dataPtr, unsigned short *minMaxVolume,
+                         int fullDim[3], int smallDim[4],
+                         int independent, int components,
+                         float *shift, float *scale,
+                         int zStart, int zEnd )
+{
+  int i, j, k, c;
+  int sx1, sx2, sy1, sy2, sz1, sz2;
+  int x, y, z;
+
+  // Cell z covers the samples 4z to 4z+4
+  int kStart = 4*zStart;
+  int kEnd = std::min(4*zEnd, fullDim[2]-1);
+
+  T *dptr = dataPtr + static_cast<vtkIdType>(kStart)*fullDim[0]*fullDim[1]*components;
+
+  for ( k = kStart; k <= kEnd; k++ )
+    {
+    sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
+    sz2 =              static_cast<int>((k  )/4);
+    sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
+    sz1 = std::max(sz1, zStart);
+    sz2 = std::min(sz2, zEnd-1);
+    for ( j = 0; j < fullDim[1]; j++ )
+      {
+      sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
+      sy2 =              static_cast<int>((j  )/4);
+      sy2 = ( j == fullDim[1]-1 )?(sy1):(sy2);
+      for ( i = 0; i < fullDim[0]; i++ )
+        {
+        sx1 = (i < 1)?(0):(static_cast<int>((i-1)/4));
+        sx2 =              static_cast<int>((i  )/4);
+        sx2 = ( i == fullDim[0]-1 )?(sx1):(sx2);
+
+        for ( c = 0; c < smallDim[3]; c++ )
+          {
+          unsigned short val;
+          if ( independent )
+            {
+            val = static_cast<unsigned short>((*dptr + shift[c]) * scale[c]);
+            dptr++;
+            }
+          else
+            {
+            val = static_cast<unsigned short>((*(dptr+components-1) +
+                                               shift[components-1]) * scale[components-1]);
+            dptr += components;
+            }
+
+          for ( z = sz1; z <= sz2; z++ )
+            {
+            for ( y = sy1; y <= sy2; y++ )
+              {
+              for ( x = sx1; x <= sx2; x++ )
+                {
+                unsigned short *tmpPtr = minMaxVolume +
+                  3*( z*smallDim[0]*smallDim[1]*smallDim[3] +
+                      y*smallDim[0]*smallDim[3] +
+                      x*smallDim[3] + c);
+
+                tmpPtr[0] = (val<tmpPtr[0])?(val):(tmpPtr[0]);
+                tmpPtr[1] = (val>tmpPtr[1])?(val):(tmpPtr[1]);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Fill in the maximum gradient magnitudes of the cells [zStart, zEnd) of
+// the min/max volume.
+void FillInMaxGradientMagnitudes( unsigned char *gradientMagnitude,
+                                  unsigned short *minMaxVolume,
+                                  int fullDim[3], int smallDim[4],
+                                  int zStart, int zEnd )
+{
+  int i, j, k, c;
+  int sx1, sx2, sy1, sy2, sz1, sz2;
+  int x, y, z;
+
+  int kStart = 4*zStart;
+  int kEnd = std::min(4*zEnd, fullDim[2]-1);
+
+  unsigned char *dptr = gradientMagnitude +
+    static_cast<vtkIdType>(kStart)*fullDim[0]*fullDim[1]*smallDim[3];
+
+  for ( k = kStart; k <= kEnd; k++ )
+    {
+    sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
+    sz2 =              static_cast<int>((k  )/4);
+    sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
+    sz1 = std::max(sz1, zStart);
+    sz2 = std::min(sz2, zEnd-1);
+
+    for ( j = 0; j < fullDim[1]; j++ )
+      {
+      sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
+      sy2 =              static_cast<int>((j  )/4);
+      sy2 = ( j == fullDim[1]-1 )?(sy1):(sy2);
+
+      for ( i = 0; i < fullDim[0]; i++ )
+        {
+        sx1 = (i < 1)?(0):(static_cast<int>((i-1)/4));
+        sx2 =              static_cast<int>((i  )/4);
+        sx2 = ( i == fullDim[0]-1 )?(sx1):(sx2);
+
+        for ( c = 0; c < smallDim[3]; c++ )
+          {
+          unsigned char val;
+          val = *dptr;
+          dptr++;
+
+          for ( z = sz1; z <= sz2; z++ )
+            {
+            for ( y = sy1; y <= sy2; y++ )
+              {
+              for ( x = sx1; x <= sx2; x++ )
+                {
+                unsigned short *tmpPtr = minMaxVolume +
+                  3*( z*smallDim[0]*smallDim[1]*smallDim[3] +
+                      y*smallDim[0]*smallDim[3] +
+                      x*smallDim[3] + c);
+
+                // Keep track of max gradient magnitude in upper eight bits,
+                // the flag in the lower eight bits is 0.
+                tmpPtr[2] = (val>(tmpPtr[2]>>8))?(val<<8):(tmpPtr[2]);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ComputeGradientsThreadedMethod( void *arg )
+{
+  vtkMultiThreader::ThreadInfo *info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ThreadArguments *args = static_cast<ThreadArguments*>(info->UserData);
+  vtkImageData *input = args->Input;
+  int dim[3];
+  double spacing[3];
+  input->GetDimensions(dim);
+  input->GetSpacing(spacing);
+  int components = input->GetPointData()->GetScalars()->GetNumberOfComponents();
+  void *dataPtr = input->GetScalarPointer();
+  switch ( input->GetScalarType() )
+    {
+    vtkTemplateMacro(
+      ComputeGradients(
+        (VTK_TT *)(dataPtr), dim, spacing, components,
+        args->Independent, args->ScalarRange,
+        args->GradientNormal, args->GradientMagnitude,
+        args->DirectionEncoder, args->ProgressObject,
+        info->ThreadID, info->NumberOfThreads) );
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE FillInMinMaxVolumeThreadedMethod( void *arg )
+{
+  vtkMultiThreader::ThreadInfo *info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ThreadArguments *args = static_cast<ThreadArguments*>(info->UserData);
+  vtkImageData *input = args->Input;
+  int dim[3];
+  input->GetDimensions(dim);
+  int components = input->GetPointData()->GetScalars()->GetNumberOfComponents();
+  void *dataPtr = input->GetScalarPointer();
+
+  int numberOfCells = args->MinMaxVolumeSize[2];
+  int zStart = numberOfCells * info->ThreadID / info->NumberOfThreads;
+  int zEnd = numberOfCells * (info->ThreadID + 1) / info->NumberOfThreads;
+  if ( zStart >= zEnd )
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  switch ( input->GetScalarType() )
+    {
+    vtkTemplateMacro(
+      FillInMinMaxVolume(
+        (VTK_TT *)(dataPtr), args->MinMaxVolume, dim, args->MinMaxVolumeSize,
+        args->Independent, components, args->Shift, args->Scale,
+        zStart, zEnd) );
+    }
+  if ( args->GradientMagnitude )
+    {
+    FillInMaxGradientMagnitudes( args->GradientMagnitude, args->MinMaxVolume,
+                                 dim, args->MinMaxVolumeSize, zStart, zEnd );
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// 64 bits FNV-1a hash of the scalars, used to check that a persisted file
+// was built from the same voxels.
+vtkTypeUInt64 HashScalars( vtkImageData *input )
+{
+  vtkDataArray *scalars = input->GetPointData()->GetScalars();
+  const unsigned char *bytes = static_cast<const unsigned char*>(scalars->GetVoidPointer(0));
+  vtkIdType size = scalars->GetNumberOfTuples() * scalars->GetNumberOfComponents() *
+    scalars->GetDataTypeSize();
+  vtkTypeUInt64 hash = 14695981039346656037ULL;
+  for ( vtkIdType i = 0; i < size; ++i )
+    {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+    }
+  return hash;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkSlicerFixedPointVolumeRayCastCache::vtkInternal
+{
+public:
+  struct Entry
+    {
+    vtkImageData*                 Input;
+    unsigned long                 InputMTime;
+    int                           Type;
+    int                           Independent;
+    float                         Shift[4];
+    float                         Scale[4];
+    int                           MinMaxVolumeSize[4];
+    vtkSmartPointer<vtkDataArray> Arrays[2];
+    };
+
+  struct FileInfo
+    {
+    std::string   FileName;
+    unsigned long HashMTime;
+    vtkTypeUInt64 Hash;
+    };
+
+  vtkInternal();
+
+  // The following methods must be called with the lock acquired.
+
+  // Return the entry matching the arguments, moved to the front of the
+  // list of entries as the most recently used one, or 0 if none.
+  Entry* FindEntry( vtkImageData *input, int type, int independent,
+                    float shift[4], float scale[4] );
+  // Add the entry in front of the list, replace the entries of older
+  // scalars of the same image and remove the least recently used entries
+  // while the cache is too big.
+  Entry* AddEntry( const Entry& entry, unsigned long maximumMemorySize );
+  // Observe the deletion of input to remove its entries.
+  void WatchInput( vtkImageData *input );
+  void RemoveInput( vtkImageData *input );
+
+  static unsigned long GetEntryMemorySize( const Entry& entry );
+
+  // The following methods acquire the lock.
+
+  // Copy the entry matching the arguments into entry. Return false if none.
+  bool CopyEntry( vtkImageData *input, int type, int independent,
+                  float shift[4], float scale[4], Entry& entry );
+  // Add entry built outside the lock (read from a file if read is set,
+  // computed otherwise). If another thread added the same entry meanwhile,
+  // entry receives its arrays instead. Entries of scalars modified since
+  // entry was built are not added.
+  void InsertEntry( Entry& entry, bool read, unsigned long maximumMemorySize );
+  // Get the file name and the hash of the scalars of input. The hash is
+  // computed without the lock when the scalars changed. Return false if
+  // input has no file name.
+  bool GetFile( vtkImageData *input, std::string& fileName, vtkTypeUInt64& hash );
+
+  static bool ReadEntry( Entry& entry, const std::string& fileName, vtkTypeUInt64 hash );
+  static bool WriteEntry( const Entry& entry, const std::string& fileName, vtkTypeUInt64 hash );
+
+  vtkSimpleCriticalSection                Lock;
+  std::list<Entry>                        Entries;
+  std::map<vtkImageData*, FileInfo>       Files;
+  std::map<vtkImageData*, unsigned long>  ObservedInputs;
+  vtkSmartPointer<vtkCallbackCommand>     InputDeletedCommand;
+  vtkSmartPointer<vtkSphericalDirectionEncoder> DirectionEncoder;
+  int                                     NumberOfComputedEntries;
+  int                                     NumberOfReadEntries;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::vtkInternal()
+{
+  this->InputDeletedCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->DirectionEncoder = vtkSmartPointer<vtkSphericalDirectionEncoder>::New();
+  this->NumberOfComputedEntries = 0;
+  this->NumberOfReadEntries = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::Entry*
+vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::FindEntry(
+  vtkImageData *input, int type, int independent, float shift[4], float scale[4] )
+{
+  unsigned long inputMTime = input->GetMTime();
+  for ( std::list<Entry>::iterator it = this->Entries.begin();
+        it != this->Entries.end(); ++it )
+    {
+    if ( it->Input == input &&
+         it->InputMTime == inputMTime &&
+         it->Type == type &&
+         it->Independent == independent &&
+         std::equal(shift, shift + 4, it->Shift) &&
+         std::equal(scale, scale + 4, it->Scale) )
+      {
+      this->Entries.splice( this->Entries.begin(), this->Entries, it );
+      return &this->Entries.front();
+      }
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::Entry*
+vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::AddEntry(
+  const Entry& entry, unsigned long maximumMemorySize )
+{
+  // The entries built from older scalars can't be used anymore
+  for ( std::list<Entry>::iterator it = this->Entries.begin();
+        it != this->Entries.end(); )
+    {
+    if ( it->Input == entry.Input && it->InputMTime != entry.InputMTime )
+      {
+      it = this->Entries.erase(it);
+      }
+    else
+      {
+      ++it;
+      }
+    }
+  this->Entries.push_front( entry );
+  this->WatchInput( entry.Input );
+
+  unsigned long memorySize = 0;
+  for ( std::list<Entry>::iterator it = this->Entries.begin();
+        it != this->Entries.end(); ++it )
+    {
+    memorySize += GetEntryMemorySize( *it );
+    }
+  // The new entry is kept even if it is bigger than the maximum size,
+  // it is used right away.
+  while ( memorySize > maximumMemorySize && this->Entries.size() > 1 )
+    {
+    memorySize -= GetEntryMemorySize( this->Entries.back() );
+    this->Entries.pop_back();
+    }
+  return &this->Entries.front();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::WatchInput( vtkImageData *input )
+{
+  if ( this->ObservedInputs.find(input) != this->ObservedInputs.end() )
+    {
+    return;
+    }
+  this->ObservedInputs[input] =
+    input->AddObserver( vtkCommand::DeleteEvent, this->InputDeletedCommand );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::RemoveInput( vtkImageData *input )
+{
+  for ( std::list<Entry>::iterator it = this->Entries.begin();
+        it != this->Entries.end(); )
+    {
+    if ( it->Input == input )
+      {
+      it = this->Entries.erase(it);
+      }
+    else
+      {
+      ++it;
+      }
+    }
+  this->Files.erase( input );
+  this->ObservedInputs.erase( input );
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkSlicerFixedPointVolumeRayCastCache::vtkInternal
+::GetEntryMemorySize( const Entry& entry )
+{
+  unsigned long memorySize = 0;
+  for ( int i = 0; i < 2; ++i )
+    {
+    if ( entry.Arrays[i] )
+      {
+      memorySize += entry.Arrays[i]->GetActualMemorySize();
+      }
+    }
+  return memorySize;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::CopyEntry(
+  vtkImageData *input, int type, int independent, float shift[4], float scale[4],
+  Entry& entry )
+{
+  this->Lock.Lock();
+  Entry *cachedEntry = this->FindEntry( input, type, independent, shift, scale );
+  if ( cachedEntry )
+    {
+    entry = *cachedEntry;
+    }
+  this->Lock.Unlock();
+  return cachedEntry != 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::InsertEntry(
+  Entry& entry, bool read, unsigned long maximumMemorySize )
+{
+  this->Lock.Lock();
+  if ( read )
+    {
+    ++this->NumberOfReadEntries;
+    }
+  else
+    {
+    ++this->NumberOfComputedEntries;
+    }
+  Entry *cachedEntry = this->FindEntry( entry.Input, entry.Type, entry.Independent,
+                                        entry.Shift, entry.Scale );
+  if ( cachedEntry )
+    {
+    entry = *cachedEntry;
+    }
+  else if ( entry.InputMTime == entry.Input->GetMTime() )
+    {
+    this->AddEntry( entry, maximumMemorySize );
+    }
+  this->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::GetFile(
+  vtkImageData *input, std::string& fileName, vtkTypeUInt64& hash )
+{
+  this->Lock.Lock();
+  std::map<vtkImageData*, FileInfo>::const_iterator it = this->Files.find( input );
+  bool found = ( it != this->Files.end() );
+  unsigned long inputMTime = input->GetMTime();
+  bool upToDate = found && it->second.HashMTime == inputMTime;
+  if ( found )
+    {
+    fileName = it->second.FileName;
+    hash = it->second.Hash;
+    }
+  this->Lock.Unlock();
+  if ( !found || upToDate )
+    {
+    return found;
+    }
+
+  hash = HashScalars( input );
+
+  this->Lock.Lock();
+  std::map<vtkImageData*, FileInfo>::iterator fileIt = this->Files.find( input );
+  if ( fileIt != this->Files.end() && fileIt->second.FileName == fileName )
+    {
+    fileIt->second.Hash = hash;
+    fileIt->second.HashMTime = inputMTime;
+    }
+  this->Lock.Unlock();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::ReadEntry(
+  Entry& entry, const std::string& fileName, vtkTypeUInt64 hash )
+{
+  std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+  if ( !file.is_open() )
+    {
+    return false;
+    }
+  char signature[sizeof(EntryFileSignature)] = "";
+  file.read( signature, sizeof(EntryFileSignature) - 1 );
+  if ( !file || strcmp(signature, EntryFileSignature) )
+    {
+    return false;
+    }
+  vtkImageData *input = entry.Input;
+  vtkDataArray *scalars = input->GetPointData()->GetScalars();
+  int expected[7] = { entry.Type, entry.Independent, 0, 0, 0,
+                      scalars->GetNumberOfComponents(), scalars->GetDataType() };
+  input->GetDimensions( expected + 2 );
+  int header[7];
+  float shift[4];
+  float scale[4];
+  vtkTypeUInt64 fileHash = 0;
+  file.read( reinterpret_cast<char*>(header), sizeof(header) );
+  file.read( reinterpret_cast<char*>(shift), sizeof(shift) );
+  file.read( reinterpret_cast<char*>(scale), sizeof(scale) );
+  file.read( reinterpret_cast<char*>(entry.MinMaxVolumeSize), sizeof(entry.MinMaxVolumeSize) );
+  file.read( reinterpret_cast<char*>(&fileHash), sizeof(fileHash) );
+  if ( !file ||
+       !std::equal(header, header + 7, expected) ||
+       !std::equal(shift, shift + 4, entry.Shift) ||
+       !std::equal(scale, scale + 4, entry.Scale) ||
+       fileHash != hash )
+    {
+    return false;
+    }
+  for ( int i = 0; i < 2; ++i )
+    {
+    vtkIdType numberOfTuples = 0;
+    int numberOfComponents = 0;
+    file.read( reinterpret_cast<char*>(&numberOfTuples), sizeof(numberOfTuples) );
+    file.read( reinterpret_cast<char*>(&numberOfComponents), sizeof(numberOfComponents) );
+    if ( !file || numberOfTuples < 0 || numberOfComponents < 0 || numberOfComponents > 4 )
+      {
+      return false;
+      }
+    if ( numberOfTuples == 0 )
+      {
+      entry.Arrays[i] = 0;
+      continue;
+      }
+    vtkSmartPointer<vtkDataArray> array;
+    if ( entry.Type == GradientsEntry && i == 1 )
+      {
+      array = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      }
+    else
+      {
+      array = vtkSmartPointer<vtkUnsignedShortArray>::New();
+      }
+    array->SetNumberOfComponents( numberOfComponents );
+    array->SetNumberOfTuples( numberOfTuples );
+    file.read( static_cast<char*>(array->GetVoidPointer(0)),
+               numberOfTuples * numberOfComponents * array->GetDataTypeSize() );
+    if ( !file )
+      {
+      return false;
+      }
+    entry.Arrays[i] = array;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointVolumeRayCastCache::vtkInternal::WriteEntry(
+  const Entry& entry, const std::string& fileName, vtkTypeUInt64 hash )
+{
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  if ( !file.is_open() )
+    {
+    return false;
+    }
+  vtkImageData *input = entry.Input;
+  vtkDataArray *scalars = input->GetPointData()->GetScalars();
+  int header[7] = { entry.Type, entry.Independent, 0, 0, 0,
+                    scalars->GetNumberOfComponents(), scalars->GetDataType() };
+  input->GetDimensions( header + 2 );
+  file.write( EntryFileSignature, sizeof(EntryFileSignature) - 1 );
+  file.write( reinterpret_cast<const char*>(header), sizeof(header) );
+  file.write( reinterpret_cast<const char*>(entry.Shift), sizeof(entry.Shift) );
+  file.write( reinterpret_cast<const char*>(entry.Scale), sizeof(entry.Scale) );
+  file.write( reinterpret_cast<const char*>(entry.MinMaxVolumeSize), sizeof(entry.MinMaxVolumeSize) );
+  file.write( reinterpret_cast<const char*>(&hash), sizeof(hash) );
+  for ( int i = 0; i < 2; ++i )
+    {
+    vtkDataArray *array = entry.Arrays[i];
+    vtkIdType numberOfTuples = array ? array->GetNumberOfTuples() : 0;
+    int numberOfComponents = array ? array->GetNumberOfComponents() : 0;
+    file.write( reinterpret_cast<const char*>(&numberOfTuples), sizeof(numberOfTuples) );
+    file.write( reinterpret_cast<const char*>(&numberOfComponents), sizeof(numberOfComponents) );
+    if ( array )
+      {
+      file.write( static_cast<const char*>(array->GetVoidPointer(0)),
+                  numberOfTuples * numberOfComponents * array->GetDataTypeSize() );
+      }
+    }
+  file.close();
+  return !file.fail();
+}
+
+//----------------------------------------------------------------------------
+// The cache singleton.
+// This MUST be default initialized to zero by the compiler and is
+// therefore not initialized here.  The ClassInitialize and
+// ClassFinalize methods handle this instance.
+static vtkSlicerFixedPointVolumeRayCastCache* vtkSlicerFixedPointVolumeRayCastCacheInstance;
+
+//----------------------------------------------------------------------------
+// Must NOT be initialized.  Default initialization to zero is necessary.
+unsigned int vtkSlicerFixedPointVolumeRayCastCacheInitialize::Count;
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCacheInitialize::vtkSlicerFixedPointVolumeRayCastCacheInitialize()
+{
+  if(++Self::Count == 1)
+    {
+    vtkSlicerFixedPointVolumeRayCastCache::classInitialize();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCacheInitialize::~vtkSlicerFixedPointVolumeRayCastCacheInitialize()
+{
+  if(--Self::Count == 0)
+    {
+    vtkSlicerFixedPointVolumeRayCastCache::classFinalize();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Needed when we don't use the vtkStandardNewMacro.
+vtkInstantiatorNewMacro(vtkSlicerFixedPointVolumeRayCastCache);
+
+//----------------------------------------------------------------------------
+// Up the reference count so it behaves like New
+vtkSlicerFixedPointVolumeRayCastCache* vtkSlicerFixedPointVolumeRayCastCache::New()
+{
+  vtkSlicerFixedPointVolumeRayCastCache* ret = vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+  ret->Register(NULL);
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// Return the single instance of the vtkSlicerFixedPointVolumeRayCastCache
+vtkSlicerFixedPointVolumeRayCastCache* vtkSlicerFixedPointVolumeRayCastCache::GetInstance()
+{
+  if(!vtkSlicerFixedPointVolumeRayCastCacheInstance)
+    {
+    // Try the factory first
+    vtkSlicerFixedPointVolumeRayCastCacheInstance = (vtkSlicerFixedPointVolumeRayCastCache*)
+      vtkObjectFactory::CreateInstance("vtkSlicerFixedPointVolumeRayCastCache");
+    // if the factory did not provide one, then create it here
+    if(!vtkSlicerFixedPointVolumeRayCastCacheInstance)
+      {
+      vtkSlicerFixedPointVolumeRayCastCacheInstance = new vtkSlicerFixedPointVolumeRayCastCache;
+      }
+    }
+  // return the instance
+  return vtkSlicerFixedPointVolumeRayCastCacheInstance;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::classInitialize()
+{
+  // Allocate the singleton
+  vtkSlicerFixedPointVolumeRayCastCacheInstance = vtkSlicerFixedPointVolumeRayCastCache::GetInstance();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::classFinalize()
+{
+  vtkSlicerFixedPointVolumeRayCastCacheInstance->Delete();
+  vtkSlicerFixedPointVolumeRayCastCacheInstance = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCache::vtkSlicerFixedPointVolumeRayCastCache()
+{
+  this->Persistent = false;
+  this->MaximumMemorySize = 1024 * 1024;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Internal = new vtkInternal;
+  this->Internal->InputDeletedCommand->SetClientData( this );
+  this->Internal->InputDeletedCommand->SetCallback(
+    vtkSlicerFixedPointVolumeRayCastCache::InputDeletedCallback );
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerFixedPointVolumeRayCastCache::~vtkSlicerFixedPointVolumeRayCastCache()
+{
+  // The observed images are still alive, they would have been removed
+  // otherwise.
+  for ( std::map<vtkImageData*, unsigned long>::iterator it =
+          this->Internal->ObservedInputs.begin();
+        it != this->Internal->ObservedInputs.end(); ++it )
+    {
+    it->first->RemoveObserver( it->second );
+    }
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Persistent: " << this->Persistent << "\n";
+  os << indent << "MaximumMemorySize: " << this->MaximumMemorySize << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfEntries: " << this->GetNumberOfEntries() << "\n";
+  os << indent << "MemorySize: " << this->GetMemorySize() << "\n";
+  os << indent << "NumberOfComputedEntries: " << this->GetNumberOfComputedEntries() << "\n";
+  os << indent << "NumberOfReadEntries: " << this->GetNumberOfReadEntries() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::InputDeletedCallback(
+  vtkObject *caller, unsigned long vtkNotUsed(eid),
+  void *clientData, void *vtkNotUsed(callData) )
+{
+  vtkSlicerFixedPointVolumeRayCastCache *self =
+    static_cast<vtkSlicerFixedPointVolumeRayCastCache*>(clientData);
+  self->Internal->Lock.Lock();
+  self->Internal->RemoveInput( static_cast<vtkImageData*>(caller) );
+  self->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointVolumeRayCastCache::GetGradients(
+  vtkImageData *input, int independent, vtkObject *progressObject,
+  vtkSmartPointer<vtkUnsignedShortArray>& gradientNormal,
+  vtkSmartPointer<vtkUnsignedCharArray>& gradientMagnitude )
+{
+  gradientNormal = 0;
+  gradientMagnitude = 0;
+  vtkDataArray *scalars = input ? input->GetPointData()->GetScalars() : 0;
+  if ( !scalars )
+    {
+    return false;
+    }
+  int components = scalars->GetNumberOfComponents();
+  // Single component images have the same gradients either way
+  independent = ( independent || components == 1 ) ? 1 : 0;
+  float noShift[4] = { 0.f, 0.f, 0.f, 0.f };
+
+  vtkInternal::Entry entry;
+  if ( !this->Internal->CopyEntry( input, GradientsEntry, independent, noShift, noShift, entry ) )
+    {
+    // The gradients are read or computed without the lock, the progress
+    // observers may use the cache. Another thread asking for them
+    // meanwhile computes them as well, the first ones added are kept.
+    entry.Input = input;
+    entry.InputMTime = input->GetMTime();
+    entry.Type = GradientsEntry;
+    entry.Independent = independent;
+    std::fill( entry.Shift, entry.Shift + 4, 0.f );
+    std::fill( entry.Scale, entry.Scale + 4, 0.f );
+    std::fill( entry.MinMaxVolumeSize, entry.MinMaxVolumeSize + 4, 0 );
+
+    std::string fileName;
+    vtkTypeUInt64 hash = 0;
+    bool persistent = this->Persistent && this->Internal->GetFile( input, fileName, hash );
+    fileName += EntryFileSuffixes[GradientsEntry];
+    bool read = persistent && vtkInternal::ReadEntry( entry, fileName, hash );
+    if ( !read )
+      {
+      int dim[3];
+      input->GetDimensions( dim );
+      vtkIdType numberOfVoxels = static_cast<vtkIdType>(dim[0]) * dim[1] * dim[2];
+      int increment = independent ? components : 1;
+
+      vtkSmartPointer<vtkUnsignedShortArray> normals =
+        vtkSmartPointer<vtkUnsignedShortArray>::New();
+      normals->SetNumberOfComponents( increment );
+      normals->SetNumberOfTuples( numberOfVoxels );
+      vtkSmartPointer<vtkUnsignedCharArray> magnitudes =
+        vtkSmartPointer<vtkUnsignedCharArray>::New();
+      magnitudes->SetNumberOfComponents( increment );
+      magnitudes->SetNumberOfTuples( numberOfVoxels );
+
+      ThreadArguments args;
+      args.Input = input;
+      args.Independent = independent;
+      for ( int c = 0; c < components; c++ )
+        {
+        scalars->GetRange( args.ScalarRange[c], c );
+        }
+      args.GradientNormal = normals->GetPointer(0);
+      args.GradientMagnitude = magnitudes->GetPointer(0);
+      args.DirectionEncoder = this->Internal->DirectionEncoder;
+      args.ProgressObject = progressObject;
+      args.MinMaxVolume = 0;
+      args.Shift = 0;
+      args.Scale = 0;
+
+      if ( progressObject )
+        {
+        progressObject->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsStartEvent, NULL );
+        }
+      vtkMultiThreader *threader = vtkMultiThreader::New();
+      threader->SetNumberOfThreads( std::min(this->NumberOfThreads, std::max(dim[2], 1)) );
+      threader->SetSingleMethod( ComputeGradientsThreadedMethod, &args );
+      threader->SingleMethodExecute();
+      threader->Delete();
+      if ( progressObject )
+        {
+        progressObject->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsEndEvent, NULL );
+        }
+
+      entry.Arrays[0] = normals;
+      entry.Arrays[1] = magnitudes;
+      if ( persistent && !vtkInternal::WriteEntry( entry, fileName, hash ) )
+        {
+        vtkWarningMacro( "GetGradients: failed to write " << fileName );
+        }
+      }
+    this->Internal->InsertEntry( entry, read, this->MaximumMemorySize );
+    }
+  gradientNormal = vtkUnsignedShortArray::SafeDownCast( entry.Arrays[0] );
+  gradientMagnitude = vtkUnsignedCharArray::SafeDownCast( entry.Arrays[1] );
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkUnsignedShortArray> vtkSlicerFixedPointVolumeRayCastCache::GetMinMaxVolume(
+  vtkImageData *input, int independent, float shift[4], float scale[4],
+  int withGradients, int minMaxVolumeSize[4] )
+{
+  vtkDataArray *scalars = input ? input->GetPointData()->GetScalars() : 0;
+  if ( !scalars )
+    {
+    return 0;
+    }
+  int components = scalars->GetNumberOfComponents();
+  independent = ( independent || components == 1 ) ? 1 : 0;
+  int type = withGradients ? MinMaxWithGradientsEntry : MinMaxEntry;
+
+  vtkInternal::Entry entry;
+  if ( !this->Internal->CopyEntry( input, type, independent, shift, scale, entry ) )
+    {
+    // Kept alive in case the gradients are removed from the cache meanwhile
+    vtkSmartPointer<vtkUnsignedShortArray> gradientNormal;
+    vtkSmartPointer<vtkUnsignedCharArray> gradientMagnitude;
+    if ( withGradients &&
+         !this->GetGradients( input, independent, 0, gradientNormal, gradientMagnitude ) )
+      {
+      return 0;
+      }
+
+    entry.Input = input;
+    entry.InputMTime = input->GetMTime();
+    entry.Type = type;
+    entry.Independent = independent;
+    std::copy( shift, shift + 4, entry.Shift );
+    std::copy( scale, scale + 4, entry.Scale );
+
+    std::string fileName;
+    vtkTypeUInt64 hash = 0;
+    bool persistent = this->Persistent && this->Internal->GetFile( input, fileName, hash );
+    fileName += EntryFileSuffixes[type];
+    bool read = persistent && vtkInternal::ReadEntry( entry, fileName, hash );
+    if ( !read )
+      {
+      int dim[3];
+      input->GetDimensions( dim );
+      for ( int i = 0; i < 3; i++ )
+        {
+        // We group four cells (which require 5 samples) into one element in the min/max tree
+        entry.MinMaxVolumeSize[i] =
+          (dim[i] < 2) ? (1) : ( 1 + static_cast<int>((dim[i] - 2)/4));
+        }
+      // This fourth dimension is the number of independent components for which we
+      // need to keep track of min/max
+      entry.MinMaxVolumeSize[3] = (independent)?(components):(1);
+
+      vtkSmartPointer<vtkUnsignedShortArray> minMaxVolume =
+        vtkSmartPointer<vtkUnsignedShortArray>::New();
+      minMaxVolume->SetNumberOfComponents( 3 );
+      minMaxVolume->SetNumberOfTuples( static_cast<vtkIdType>(entry.MinMaxVolumeSize[0]) *
+                                       entry.MinMaxVolumeSize[1] *
+                                       entry.MinMaxVolumeSize[2] *
+                                       entry.MinMaxVolumeSize[3] );
+      // Initialize the structure
+      unsigned short *tmpPtr = minMaxVolume->GetPointer(0);
+      for ( vtkIdType i = 0; i < minMaxVolume->GetNumberOfTuples(); i++ )
+        {
+        *(tmpPtr++) = 0xffff;  // Min Scalar
+        *(tmpPtr++) = 0;       // Max Scalar
+        *(tmpPtr++) = 0;       // Max Gradient Magnitude and flag
+        }
+
+      ThreadArguments args;
+      args.Input = input;
+      args.Independent = independent;
+      args.GradientNormal = 0;
+      args.GradientMagnitude = gradientMagnitude ? gradientMagnitude->GetPointer(0) : 0;
+      args.DirectionEncoder = 0;
+      args.ProgressObject = 0;
+      args.MinMaxVolume = minMaxVolume->GetPointer(0);
+      std::copy( entry.MinMaxVolumeSize, entry.MinMaxVolumeSize + 4, args.MinMaxVolumeSize );
+      args.Shift = shift;
+      args.Scale = scale;
+
+      vtkMultiThreader *threader = vtkMultiThreader::New();
+      threader->SetNumberOfThreads( std::min(this->NumberOfThreads, entry.MinMaxVolumeSize[2]) );
+      threader->SetSingleMethod( FillInMinMaxVolumeThreadedMethod, &args );
+      threader->SingleMethodExecute();
+      threader->Delete();
+
+      entry.Arrays[0] = minMaxVolume;
+      entry.Arrays[1] = 0;
+      if ( persistent && !vtkInternal::WriteEntry( entry, fileName, hash ) )
+        {
+        vtkWarningMacro( "GetMinMaxVolume: failed to write " << fileName );
+        }
+      }
+    this->Internal->InsertEntry( entry, read, this->MaximumMemorySize );
+    }
+  std::copy( entry.MinMaxVolumeSize, entry.MinMaxVolumeSize + 4, minMaxVolumeSize );
+  return vtkUnsignedShortArray::SafeDownCast( entry.Arrays[0] );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::SetFileName( vtkImageData *input, const char *fileName )
+{
+  if ( !input )
+    {
+    return;
+    }
+  this->Internal->Lock.Lock();
+  if ( !fileName || !*fileName )
+    {
+    this->Internal->Files.erase( input );
+    }
+  else if ( this->Internal->Files[input].FileName != fileName )
+    {
+    vtkInternal::FileInfo& info = this->Internal->Files[input];
+    info.FileName = fileName;
+    // Force the hash to be computed
+    info.HashMTime = 0;
+    info.Hash = 0;
+    this->Internal->WatchInput( input );
+    }
+  this->Internal->Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerFixedPointVolumeRayCastCache::GetFileName( vtkImageData *input )
+{
+  this->Internal->Lock.Lock();
+  std::map<vtkImageData*, vtkInternal::FileInfo>::const_iterator it =
+    this->Internal->Files.find( input );
+  std::string fileName = ( it != this->Internal->Files.end() ) ? it->second.FileName : std::string();
+  this->Internal->Lock.Unlock();
+  return fileName;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerFixedPointVolumeRayCastCache::GetNumberOfEntries()
+{
+  this->Internal->Lock.Lock();
+  int numberOfEntries = static_cast<int>( this->Internal->Entries.size() );
+  this->Internal->Lock.Unlock();
+  return numberOfEntries;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkSlicerFixedPointVolumeRayCastCache::GetMemorySize()
+{
+  this->Internal->Lock.Lock();
+  unsigned long memorySize = 0;
+  for ( std::list<vtkInternal::Entry>::const_iterator it = this->Internal->Entries.begin();
+        it != this->Internal->Entries.end(); ++it )
+    {
+    memorySize += vtkInternal::GetEntryMemorySize( *it );
+    }
+  this->Internal->Lock.Unlock();
+  return memorySize;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerFixedPointVolumeRayCastCache::GetNumberOfComputedEntries()
+{
+  return this->Internal->NumberOfComputedEntries;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerFixedPointVolumeRayCastCache::GetNumberOfReadEntries()
+{
+  return this->Internal->NumberOfReadEntries;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerFixedPointVolumeRayCastCache::RemoveAllEntries()
+{
+  this->Internal->Lock.Lock();
+  this->Internal->Entries.clear();
+  this->Internal->Lock.Unlock();
+}
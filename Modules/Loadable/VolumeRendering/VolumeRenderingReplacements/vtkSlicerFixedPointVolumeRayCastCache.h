@@ -0,0 +1,190 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerFixedPointVolumeRayCastCache - acceleration structures shared by mappers
+// .SECTION Description
+// The fixed point ray cast mapper needs, for each input image, the encoded
+// gradient normals and magnitudes (for shading and gradient opacity) and a
+// min/max volume of 4x4x4 cells (for space leaping). They only depend on
+// the scalars of the image, so this singleton computes them once per image
+// and hands the same arrays to all the mappers rendering it: every 3D view
+// and every mapper re-created when switching rendering method.
+//
+// Entries are keyed by the image, its modification time and the
+// independent components flag. They are computed with multiple threads,
+// kept while they fit in MaximumMemorySize and dropped when the image is
+// deleted. The structures are computed without holding the cache lock:
+// two threads asking for the same missing entry both compute it and the
+// first one added is kept.
+//
+// When Persistent is on, the structures of the images with a file name
+// (see SetFileName()) are written to files next to the volume after being
+// computed, and read back instead of being computed in the next sessions.
+// A file is only used if it was built from the same scalars. The volume
+// rendering settings panel turns it on from the
+// "VolumeRendering/PersistentAccelerationStructures" setting.
+//
+// Only vtkSlicerFixedPointVolumeRayCastMapper uses the cache. The volume
+// rendering displayable manager uses it for all the CPU ray casting but
+// minimum intensity projection. The GPU mapper has nothing to share: it
+// computes the gradients in its shaders.
+
+// .SECTION see also
+// vtkSlicerFixedPointVolumeRayCastMapper
+
+#ifndef __vtkSlicerFixedPointVolumeRayCastCache_h
+#define __vtkSlicerFixedPointVolumeRayCastCache_h
+#include "VolumeRenderingReplacementsExport.h"
+
+#include "vtkObject.h"
+#include "vtkSmartPointer.h"
+
+// STD includes
+#include <string>
+
+class vtkImageData;
+class vtkUnsignedCharArray;
+class vtkUnsignedShortArray;
+
+/// \ingroup Slicer_QtModules_VolumeRendering
+class Q_SLICER_QTMODULES_VOLUMERENDERING_REPLACEMENTS_EXPORT vtkSlicerFixedPointVolumeRayCastCache : public vtkObject
+{
+public:
+  // Description:
+  // Return the single instance of the cache.
+  static vtkSlicerFixedPointVolumeRayCastCache *GetInstance();
+
+  // Description:
+  // Return the singleton with its reference count incremented.
+  static vtkSlicerFixedPointVolumeRayCastCache *New();
+
+  vtkTypeMacro(vtkSlicerFixedPointVolumeRayCastCache,vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Get the encoded gradient normals and the 8 bits gradient magnitudes
+  // of the scalars of input. There is one tuple per voxel, with one
+  // component per scalar component if independent is set, one otherwise.
+  // The arrays are computed if not cached, progressObject (if any) then
+  // receives the VolumeMapperComputeGradients events. The arrays stay
+  // valid as long as the caller references them, even if they are removed
+  // from the cache. Return false if input has no scalars.
+  bool GetGradients( vtkImageData *input, int independent,
+                     vtkObject *progressObject,
+                     vtkSmartPointer<vtkUnsignedShortArray>& gradientNormal,
+                     vtkSmartPointer<vtkUnsignedCharArray>& gradientMagnitude );
+
+  // Description:
+  // Get the min/max volume of input: three unsigned shorts per 4x4x4
+  // cells and independent component, the minimum and maximum scalar
+  // indices (scalars mapped by shift and scale) and, if withGradients is
+  // set, the maximum gradient magnitude in the upper 8 bits of the third
+  // one. The lower 8 bits, the flag depending on the transfer functions,
+  // are 0. minMaxVolumeSize receives the number of cells along each axis
+  // and the number of components. Return 0 if input has no scalars.
+  vtkSmartPointer<vtkUnsignedShortArray> GetMinMaxVolume( vtkImageData *input,
+                                                          int independent,
+                                                          float shift[4],
+                                                          float scale[4],
+                                                          int withGradients,
+                                                          int minMaxVolumeSize[4] );
+
+  // Description:
+  // Set the file name of the volume input was read from. The acceleration
+  // structures of input are persisted in files with this name and a
+  // suffix. Set 0 to forget the file.
+  void SetFileName( vtkImageData *input, const char *fileName );
+  std::string GetFileName( vtkImageData *input );
+
+  // Description:
+  // Read and write the acceleration structures of the images with a file
+  // name. Off by default.
+  vtkSetMacro( Persistent, bool );
+  vtkGetMacro( Persistent, bool );
+  vtkBooleanMacro( Persistent, bool );
+
+  // Description:
+  // Memory in kibibytes the cache may use. Least recently used entries are
+  // removed from the cache when it is exceeded, the mappers still using
+  // them keep them alive. 1 GiB by default.
+  vtkSetMacro( MaximumMemorySize, unsigned long );
+  vtkGetMacro( MaximumMemorySize, unsigned long );
+
+  // Description:
+  // Number of threads computing the acceleration structures.
+  // vtkMultiThreader::GetGlobalDefaultNumberOfThreads() by default.
+  vtkSetClampMacro( NumberOfThreads, int, 1, VTK_MAX_THREADS );
+  vtkGetMacro( NumberOfThreads, int );
+
+  // Description:
+  // Number of cached entries and memory they use in kibibytes.
+  int GetNumberOfEntries();
+  unsigned long GetMemorySize();
+
+  // Description:
+  // Number of entries computed, and read from files, since the cache was
+  // created.
+  int GetNumberOfComputedEntries();
+  int GetNumberOfReadEntries();
+
+  // Description:
+  // Remove all the entries of the cache. Files are not removed.
+  void RemoveAllEntries();
+
+protected:
+  vtkSlicerFixedPointVolumeRayCastCache();
+  ~vtkSlicerFixedPointVolumeRayCastCache();
+
+  static void classInitialize();
+  static void classFinalize();
+
+  friend class vtkSlicerFixedPointVolumeRayCastCacheInitialize;
+
+  static void InputDeletedCallback( vtkObject *caller, unsigned long eid,
+                                    void *clientData, void *callData );
+
+  bool          Persistent;
+  unsigned long MaximumMemorySize;
+  int           NumberOfThreads;
+
+  class vtkInternal;
+  vtkInternal *Internal;
+
+private:
+  vtkSlicerFixedPointVolumeRayCastCache(const vtkSlicerFixedPointVolumeRayCastCache&);  // Not implemented.
+  void operator=(const vtkSlicerFixedPointVolumeRayCastCache&);  // Not implemented.
+};
+
+// Utility class to make sure the singleton is created before it is used
+// and deleted after the last mapper.
+class Q_SLICER_QTMODULES_VOLUMERENDERING_REPLACEMENTS_EXPORT vtkSlicerFixedPointVolumeRayCastCacheInitialize
+{
+public:
+  typedef vtkSlicerFixedPointVolumeRayCastCacheInitialize Self;
+
+  vtkSlicerFixedPointVolumeRayCastCacheInitialize();
+  ~vtkSlicerFixedPointVolumeRayCastCacheInitialize();
+private:
+  static unsigned int Count;
+};
+
+// This instance will show up in any translation unit that uses the
+// cache. It will make sure the cache is initialized before it is used
+// and finalized when it is done being used.
+static vtkSlicerFixedPointVolumeRayCastCacheInitialize vtkSlicerFixedPointVolumeRayCastCacheInitializer;
+
+#endif
@@ -536,6 +536,7 @@
   REMAININGOPACITY = (REMAININGOPACITY*((~(TMP[3])&VTKKW_FP_MASK))+0x7fff)>>VTKKW_FP_SHIFT;     \
   if ( REMAININGOPACITY < 0xff )                                                                \
     {                                                                                           \
+    numberOfTerminatedRays++;                                                                   \
     break;                                                                                      \
     }
 
@@ -711,7 +712,12 @@
   unsigned int inc[3];                                                                          \
   inc[0] = components;                                                                          \
   inc[1] = dim[0]*components;                                                                   \
-  inc[2] = dim[0]*dim[1]*components;
+  inc[2] = dim[0]*dim[1]*components;                                                            \
+                                                                                                \
+  int tileFirstRow, tileEndRow;                                                                 \
+  vtkTypeInt64 numberOfCastRays       = 0;                                                      \
+  vtkTypeInt64 numberOfTerminatedRays = 0;                                                      \
+  (void)threadCount;
 
 #define VTKKWRCHelper_InitializeWeights()                       \
   float weights[4];                                             \
@@ -805,11 +811,7 @@
   unsigned int dDHinc = dim[0]*dirOffset + dirOffset;
 
 #define VTKKWRCHelper_OuterInitialization()                             \
-    if ( j%threadCount != threadID )                                    \
-      {                                                                 \
-      continue;                                                         \
-      }                                                                 \
-     if ( !threadID )                                                   \
+    if ( !threadID )                                                    \
       {                                                                 \
       if ( renWin->CheckAbortStatus() )                                 \
         {                                                               \
@@ -837,6 +839,7 @@
     imagePtr += 4;                                      \
     continue;                                           \
     }                                                   \
+  numberOfCastRays++;                                   \
   unsigned int   spos[3];                               \
   unsigned int   k;
 
@@ -971,7 +974,8 @@
 
 #define VTKKWRCHelper_InitializationAndLoopStartNN()            \
   VTKKWRCHelper_InitializeVariables();                          \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -981,7 +985,8 @@
 #define VTKKWRCHelper_InitializationAndLoopStartGONN()          \
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeVariablesGO();                        \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -991,7 +996,8 @@
 #define VTKKWRCHelper_InitializationAndLoopStartShadeNN()       \
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeVariablesShade();                     \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1002,7 +1008,8 @@
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeVariablesGO();                        \
   VTKKWRCHelper_InitializeVariablesShade();                     \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1012,7 +1019,8 @@
 #define VTKKWRCHelper_InitializationAndLoopStartTrilin()        \
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeTrilinVariables();                    \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1024,7 +1032,8 @@
   VTKKWRCHelper_InitializeVariablesGO();                        \
   VTKKWRCHelper_InitializeTrilinVariables();                    \
   VTKKWRCHelper_InitializeTrilinVariablesGO();                  \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1036,7 +1045,8 @@
   VTKKWRCHelper_InitializeVariablesShade();                     \
   VTKKWRCHelper_InitializeTrilinVariables();                    \
   VTKKWRCHelper_InitializeTrilinVariablesShade();               \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1050,7 +1060,8 @@
   VTKKWRCHelper_InitializeTrilinVariables();                    \
   VTKKWRCHelper_InitializeTrilinVariablesShade();               \
   VTKKWRCHelper_InitializeTrilinVariablesGO();                  \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  while ( mapper->GetNextTile( threadID, tileFirstRow, tileEndRow ) ) \
+  for ( j = tileFirstRow; j < tileEndRow; j++ )                 \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1060,13 +1071,8 @@
 #define VTKKWRCHelper_IncrementAndLoopEnd()                                     \
       imagePtr+=4;                                                              \
       }                                                                         \
-    if ( j%32 == 0 && threadID==0 )                                                           \
-      {                                                                         \
-      float fargs[1];                                                           \
-      fargs[0] = static_cast<float>(j)/static_cast<float>(imageInUseSize[1]-1); \
-      mapper->InvokeEvent( vtkCommand::ProgressEvent, fargs );                  \
-      }                                                                         \
-    }
+    }                                                                           \
+  mapper->AddRayStatistics( numberOfCastRays, numberOfTerminatedRays );
 
 #define VTKKWRCHelper_CroppingCheckTrilin( POS )        \
   if ( cropping )                                       \
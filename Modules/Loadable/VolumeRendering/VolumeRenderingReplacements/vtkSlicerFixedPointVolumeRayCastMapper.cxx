@@ -21,7 +21,9 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkFiniteDifferenceGradientEstimator.h"
 #include "vtkImageData.h"
 #include "vtkCommand.h"
+#include "vtkCriticalSection.h"
 #include "vtkSphericalDirectionEncoder.h"
+#include "vtkSlicerFixedPointVolumeRayCastCache.h"
 #include "vtkSlicerFixedPointVolumeRayCastCompositeGOHelper.h"
 #include "vtkSlicerFixedPointVolumeRayCastCompositeGOShadeHelper.h"
 #include "vtkSlicerFixedPointVolumeRayCastCompositeHelper.h"
@@ -37,10 +39,14 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkRenderer.h"
 #include "vtkTimerLog.h"
 #include "vtkTransform.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnsignedShortArray.h"
 #include "vtkVolumeProperty.h"
 #include "vtkSlicerFixedPointRayCastImage.h"
 #include <vtkVersion.h>
 
+#include <cstring>
+
 
 vtkStandardNewMacro(vtkSlicerFixedPointVolumeRayCastMapper);
 vtkCxxSetObjectMacro(vtkSlicerFixedPointVolumeRayCastMapper, RayCastImage, vtkSlicerFixedPointRayCastImage);
@@ -77,327 +83,6 @@ vtkCxxSetObjectMacro(vtkSlicerFixedPointVolumeRayCastMapper, RayCastImage, vtkSl
     B[2] = A[0]*M[2]  + A[1]*M[6]  + A[2]*M[10]
 
 
-template <class T>
-void vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume( T *dataPtr, unsigned short *minMaxVolume,
-                                                              int fullDim[3], int smallDim[4],
-                                                              int independent, int components,
-                                                              float *shift, float *scale )
-{
-    int i, j, k, c;
-    int sx1, sx2, sy1, sy2, sz1, sz2;
-    int x, y, z;
-
-    T *dptr = dataPtr;
-
-    for ( k = 0; k < fullDim[2]; k++ )
-    {
-        sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
-        sz2 =              static_cast<int>((k  )/4);
-        sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
-        for ( j = 0; j < fullDim[1]; j++ )
-        {
-            sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
-            sy2 =              static_cast<int>((j  )/4);
-            sy2 = ( j == fullDim[1]-1 )?(sy1):(sy2);
-            for ( i = 0; i < fullDim[0]; i++ )
-            {
-                sx1 = (i < 1)?(0):(static_cast<int>((i-1)/4));
-                sx2 =              static_cast<int>((i  )/4);
-                sx2 = ( i == fullDim[0]-1 )?(sx1):(sx2);
-
-                for ( c = 0; c < smallDim[3]; c++ )
-                {
-                    unsigned short val;
-                    if ( independent )
-                    {
-                        val = static_cast<unsigned short>((*dptr + shift[c]) * scale[c]);
-                        dptr++;
-                    }
-                    else
-                    {
-                        val = static_cast<unsigned short>((*(dptr+components-1) +
-                            shift[components-1]) * scale[components-1]);
-                        dptr += components;
-                    }
-
-                    for ( z = sz1; z <= sz2; z++ )
-                    {
-                        for ( y = sy1; y <= sy2; y++ )
-                        {
-                            for ( x = sx1; x <= sx2; x++ )
-                            {
-                                unsigned short *tmpPtr = minMaxVolume +
-                                    3*( z*smallDim[0]*smallDim[1]*smallDim[3] +
-                                    y*smallDim[0]*smallDim[3] +
-                                    x*smallDim[3] + c);
-
-                                tmpPtr[0] = (val<tmpPtr[0])?(val):(tmpPtr[0]);
-                                tmpPtr[1] = (val>tmpPtr[1])?(val):(tmpPtr[1]);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
-template <class T>
-void vtkSlicerFixedPointVolumeRayCastMapperComputeGradients( T *dataPtr,
-                                                            int dim[3],
-                                                            double spacing[3],
-                                                            int components,
-                                                            int independent,
-                                                            double scalarRange[4][2],
-                                                            unsigned short **gradientNormal,
-                                                            unsigned char  **gradientMagnitude,
-                                                            vtkDirectionEncoder *directionEncoder,
-                                                            vtkSlicerFixedPointVolumeRayCastMapper *me )
-{
-    int                 x, y, z, c;
-    int                 x_start, x_limit;
-    int                 y_start, y_limit;
-    int                 z_start, z_limit;
-    T                   *dptr, *cdptr;
-    float               n[3], t;
-    float               gvalue=0;
-    int                 xlow, xhigh;
-    double              aspect[3];
-    int                 xstep, ystep, zstep;
-    float               scale[4];
-    unsigned short      *dirPtr, *cdirPtr;
-    unsigned char       *magPtr, *cmagPtr;
-
-
-
-
-    me->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsStartEvent, NULL );
-
-    double avgSpacing = (spacing[0]+spacing[1]+spacing[2])/3.0;
-
-    // adjust the aspect
-    aspect[0] = spacing[0] * 2.0 / avgSpacing;
-    aspect[1] = spacing[1] * 2.0 / avgSpacing;
-    aspect[2] = spacing[2] * 2.0 / avgSpacing;
-
-    // Compute steps through the volume in x, y, and z
-    xstep = components;
-    ystep = components*dim[0];
-    zstep = components*dim[0] * dim[1];
-
-    if ( !independent )
-    {
-        if ( scalarRange[components-1][1] - scalarRange[components-1][0] )
-        {
-            scale[0] = 255.0 / (0.25*(scalarRange[components-1][1] - scalarRange[components-1][0]));
-        }
-        else
-        {
-            scale[0] = 0.0;
-        }
-    }
-    else
-    {
-        for (c = 0; c < components; c++ )
-        {
-            if ( scalarRange[c][1] - scalarRange[c][0] )
-            {
-                scale[c] = 255.0 / (0.25*(scalarRange[c][1] - scalarRange[c][0]));
-            }
-            else
-            {
-                scale[c] = 1.0;
-            }
-        }
-    }
-
-
-    int thread_id = 0;
-    int thread_count = 1;
-
-    x_start = 0;
-    x_limit = dim[0];
-    y_start = 0;
-    y_limit = dim[1];
-    z_start = (int)(( (float)thread_id / (float)thread_count ) *
-        dim[2] );
-    z_limit = (int)(( (float)(thread_id + 1) / (float)thread_count ) *
-        dim[2] );
-
-    // Do final error checking on limits - make sure they are all within bounds
-    // of the scalar input
-
-    x_start = (x_start<0)?(0):(x_start);
-    y_start = (y_start<0)?(0):(y_start);
-    z_start = (z_start<0)?(0):(z_start);
-
-    x_limit = (x_limit>dim[0])?(dim[0]):(x_limit);
-    y_limit = (y_limit>dim[1])?(dim[1]):(y_limit);
-    z_limit = (z_limit>dim[2])?(dim[2]):(z_limit);
-
-
-    int increment = (independent)?(components):(1);
-
-    float tolerance[4];
-    for ( c = 0; c < components; c++ )
-    {
-        tolerance[c] = .00001 * (scalarRange[c][1] - scalarRange[c][0]);
-    }
-
-
-    T *lastPixel = dataPtr + components*dim[0]*dim[1]*dim[2] - 1;
-
-    // Loop through all the data and compute the encoded normal and
-    // gradient magnitude for each scalar location
-    //TODO LimitGradients in same way as done in Helper Classes
-    for ( z = z_start; z < z_limit; z++ )
-    {
-        unsigned short *gradientDirPtr = gradientNormal[z];
-        unsigned char *gradientMagPtr = gradientMagnitude[z];
-
-        for ( y = y_start; y < y_limit; y++ )
-        {
-            xlow = x_start;
-            xhigh = x_limit;
-
-            dptr = dataPtr + components*(z * dim[0] * dim[1] + y * dim[0] + xlow);
-
-            dirPtr  = gradientDirPtr    + (y * dim[0] + xlow)*increment;
-            magPtr  = gradientMagPtr    + (y * dim[0] + xlow)*increment;
-
-            for ( x = xlow; x < xhigh; x++ )
-            {
-                for ( c = 0; ( independent && c < components ) || c == 0; c++ )
-                {
-                    cdptr   = dptr   + ((independent)?(c):(components-1));
-                    cdirPtr = dirPtr + ((independent)?(c):(0));
-                    cmagPtr = magPtr + ((independent)?(c):(0));
-
-                    // Allow up to 3 tries to find the gadient - looking out at a distance of
-                    // 1, 2, and 3 units.
-                    int foundGradient = 0;
-                    for ( int d = 1; d <= 3 && !foundGradient; d++ )
-                    {
-                        // Use a central difference method if possible,
-                        // otherwise use a forward or backward difference if
-                        // we are on the edge
-                        // Compute the X component
-                        if ( x < d && (cdptr+d*xstep) <= lastPixel )
-                        {
-                            n[0] = 2.0*((float)*(cdptr) - (float)*(cdptr+d*xstep));
-                        }
-                        else if ( x >= dim[0] - d && (cdptr-d*xstep) >= dataPtr )
-                        {
-                            n[0] = 2.0*((float)*(cdptr-d*xstep) - (float)*(cdptr));
-                        }
-                        else if ( (cdptr+d*xstep) <= lastPixel && (cdptr-d*xstep) >= dataPtr )
-                        {
-                            n[0] = (float)*(cdptr-d*xstep) - (float)*(cdptr+d*xstep);
-                        }
-                        else
-                        {
-                            n[0] = 0;
-                        }
-
-                        // Compute the Y component
-                        if ( y < d && (cdptr+d*ystep) <= lastPixel )
-                        {
-                            n[1] = 2.0*((float)*(cdptr) - (float)*(cdptr+d*ystep));
-                        }
-                        else if ( y >= dim[1] - d && (cdptr-d*ystep) >= dataPtr )
-                        {
-                            n[1] = 2.0*((float)*(cdptr-d*ystep) - (float)*(cdptr));
-                        }
-                        else if ( (cdptr+d*ystep) <= lastPixel && (cdptr-d*ystep) >= dataPtr )
-                        {
-                            n[1] = (float)*(cdptr-d*ystep) - (float)*(cdptr+d*ystep);
-                        }
-                        else
-                        {
-                            n[1] = 0;
-                        }
-
-                        // Compute the Z component
-                        if ( z < d && (cdptr+d*zstep) <= lastPixel )
-                        {
-                            n[2] = 2.0*((float)*(cdptr) - (float)*(cdptr+d*zstep));
-                        }
-                        else if ( z >= dim[2] - d && (cdptr-d*zstep) >= dataPtr )
-                        {
-                            n[2] = 2.0*((float)*(cdptr-d*zstep) - (float)*(cdptr));
-                        }
-                        else if ( (cdptr+d*zstep) <= lastPixel && (cdptr-d*zstep) >= dataPtr )
-                        {
-                            n[2] = (float)*(cdptr-d*zstep) - (float)*(cdptr+d*zstep);
-                        }
-                        else
-                        {
-                            n[2] = 0;
-                        }
-
-
-                        // Take care of the aspect ratio of the data
-                        // Scaling in the vtkVolume is isotropic, so this is the
-                        // only place we have to worry about non-isotropic scaling.
-                        n[0] /= d*aspect[0];
-                        n[1] /= d*aspect[1];
-                        n[2] /= d*aspect[2];
-
-                        // Compute the gradient magnitude
-                        t = sqrt( (double)( n[0]*n[0] +
-                            n[1]*n[1] +
-                            n[2]*n[2] ) );
-
-
-                        // Encode this into an 8 bit value
-                        gvalue = t * scale[c];
-
-                        if ( d > 1 )
-                        {
-                            gvalue = 0;
-                        }
-
-                        gvalue = (gvalue<0.0)?(0.0):(gvalue);
-                        gvalue = (gvalue>255.0)?(255.0):(gvalue);
-
-                        // Normalize the gradient direction
-                        if ( t > tolerance[c] )
-                        {
-                            n[0] /= t;
-                            n[1] /= t;
-                            n[2] /= t;
-                            foundGradient = 1;
-                        }
-                        else
-                        {
-                            n[0] = n[1] = n[2] = 0.0;
-                        }
-                    }
-
-
-                    *cmagPtr = static_cast<unsigned char>(gvalue + 0.5);
-                    *cdirPtr = directionEncoder->GetEncodedDirection( n );
-                }
-
-                dptr    +=   components;
-                dirPtr  +=   increment;
-                magPtr  +=   increment;
-            }
-        }
-        if ( z%8 == 7 )
-        {
-            float args[1];
-            args[0] =
-                static_cast<float>(z - z_start) /
-                static_cast<float>(z_limit - z_start - 1);
-            me->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsProgressEvent, args );
-        }
-    }
-
-    me->InvokeEvent( vtkCommand::VolumeMapperComputeGradientsEndEvent, NULL );
-}
-
-// Construct a new vtkSlicerFixedPointVolumeRayCastMapper with default values
 vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
 {
     this->SampleDistance             =  1.0;
@@ -412,6 +97,29 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->OldSampleDistance          =  1.0;
     this->OldImageSampleDistance     =  1.0;
 
+    this->ProgressiveRefinement      =  0;
+    this->RenderTimeBudget           =  0.1;
+    this->RefinementComplete         =  0;
+    for ( int c = 0; c < 11; c++ )
+    {
+        this->RefinementCamera[c] = 0.0;
+    }
+    this->RefinementSize[0]          =  0;
+    this->RefinementSize[1]          =  0;
+    this->RefinementMTime            =  0;
+
+    this->TileLock                   = new vtkSimpleCriticalSection;
+    this->TileRanges                 = NULL;
+    this->NumberOfTileRanges         = 0;
+    this->NumberOfTiles              = 0;
+    this->NumberOfStartedTiles       = 0;
+    this->RowsPerTile                = 1;
+    this->NumberOfRows               = 0;
+
+    this->NumberOfCastRays            = 0;
+    this->NumberOfEarlyTerminatedRays = 0;
+    this->NumberOfStolenTiles         = 0;
+
     this->PerspectiveMatrix      = vtkMatrix4x4::New();
     this->ViewToWorldMatrix      = vtkMatrix4x4::New();
     this->ViewToVoxelsMatrix     = vtkMatrix4x4::New();
@@ -468,8 +176,8 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->NumberOfGradientSlices       = 0;
     this->GradientNormal               = NULL;
     this->GradientMagnitude            = NULL;
-    this->ContiguousGradientNormal     = NULL;
-    this->ContiguousGradientMagnitude  = NULL;
+    this->GradientNormalArray          = NULL;
+    this->GradientMagnitudeArray       = NULL;
 
     this->DirectionEncoder             = vtkSphericalDirectionEncoder::New();
     this->GradientShader               = vtkEncodedGradientShader::New();
@@ -571,44 +279,10 @@ vtkSlicerFixedPointVolumeRayCastMapper::~vtkSlicerFixedPointVolumeRayCastMapper(
     delete [] this->RowBounds;
     delete [] this->OldRowBounds;
 
-    int i;
-    if ( this->GradientNormal )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientNormal )
-        {
-            delete [] this->ContiguousGradientNormal;
-            this->ContiguousGradientNormal = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientNormal[i];
-            }
-        }
-        delete [] this->GradientNormal;
-        this->GradientNormal = NULL;
-    }
+    delete [] this->TileRanges;
+    delete this->TileLock;
 
-    if ( this->GradientMagnitude )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientMagnitude )
-        {
-            delete [] this->ContiguousGradientMagnitude;
-            this->ContiguousGradientMagnitude = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientMagnitude[i];
-            }
-        }
-        delete [] this->GradientMagnitude;
-        this->GradientMagnitude = NULL;
-    }
+    this->ReleaseGradients();
 
     this->DirectionEncoder->Delete();
     this->GradientShader->Delete();
@@ -773,64 +447,6 @@ int vtkSlicerFixedPointVolumeRayCastMapper::GetNumberOfThreads()
     return 0;
 }
 
-void vtkSlicerFixedPointVolumeRayCastMapper::FillInMaxGradientMagnitudes( int fullDim[3],
-                                                                         int smallDim[4] )
-{
-    int i, j, k, c;
-    int sx1, sx2, sy1, sy2, sz1, sz2;
-    int x, y, z;
-
-
-    for ( k = 0; k < fullDim[2]; k++ )
-    {
-        sz1 = (k < 1)?(0):(static_cast<int>((k-1)/4));
-        sz2 =              static_cast<int>((k  )/4);
-        sz2 = ( k == fullDim[2]-1 )?(sz1):(sz2);
-
-        unsigned char *dptr = this->GradientMagnitude[k];
-
-        for ( j = 0; j < fullDim[1]; j++ )
-        {
-            sy1 = (j < 1)?(0):(static_cast<int>((j-1)/4));
-            sy2 =              static_cast<int>((j  )/4);
-            sy2 = ( j == fullDim[1]-1 )?(sy1):(sy2);
-
-            for ( i = 0; i < fullDim[0]; i++ )
-            {
-                sx1 = (i < 1)?(0):(static_cast<int>((i-1)/4));
-                sx2 =              static_cast<int>((i  )/4);
-                sx2 = ( i == fullDim[0]-1 )?(sx1):(sx2);
-
-                for ( c = 0; c < smallDim[3]; c++ )
-                {
-                    unsigned char val;
-                    val = *dptr;
-                    dptr++;
-
-                    for ( z = sz1; z <= sz2; z++ )
-                    {
-                        for ( y = sy1; y <= sy2; y++ )
-                        {
-                            for ( x = sx1; x <= sx2; x++ )
-                            {
-                                unsigned short *tmpPtr = this->MinMaxVolume +
-                                    3*( z*smallDim[0]*smallDim[1]*smallDim[3] +
-                                    y*smallDim[0]*smallDim[3] +
-                                    x*smallDim[3] + c);
-
-                                // Need to keep track of max gradient magnitude in upper
-                                // eight bits. No need to preserve lower eight (the flag)
-                                // since we will be recomputing this.
-                                tmpPtr[2] = (val>(tmpPtr[2]>>8))?(val<<8):(tmpPtr[2]);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-}
-
 // This method should be called after UpdateColorTables since it
 // relies on some information (shift and scale) computed in that method,
 // as well as the last built time for the color tables.
@@ -848,10 +464,7 @@ void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxVolume( vtkVolume *vol
     vtkImageData *input = this->GetInput();
 
     // We'll need this info later
-    int components   = input->GetPointData()->GetScalars()->GetNumberOfComponents();
     int independent  = vol->GetProperty()->GetIndependentComponents();
-    int dim[3];
-    input->GetDimensions( dim );
 
     // Has the data itself changed?
     if ( input != this->SavedMinMaxInput ||
@@ -888,23 +501,22 @@ void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxVolume( vtkVolume *vol
         return;
     }
 
-    // Regenerate the min max values if necessary
-    if ( needToUpdate&0x02 )
+    // Regenerate the min max values and the maximum gradient magnitudes if
+    // necessary. They only depend on the input and are shared with the
+    // other mappers rendering it, only the flags are specific to this mapper.
+    if ( needToUpdate&0x06 )
     {
-        // How big should the min/max volume be?
         int targetSize[4];
-
-        for ( i = 0; i < 3; i++ )
+        vtkSmartPointer<vtkUnsignedShortArray> minMaxVolume =
+            vtkSlicerFixedPointVolumeRayCastCache::GetInstance()->GetMinMaxVolume(
+                input, independent, this->TableShift, this->TableScale,
+                this->GradientOpacityRequired, targetSize );
+        if ( !minMaxVolume )
         {
-            // We group four cells (which require 5 samples) into one element in the min/max tree
-            targetSize[i] =
-                (dim[i] < 2) ? (1) : ( 1 + static_cast<int>((dim[i] - 2)/4));
+            vtkErrorMacro( "Problem computing min/max volume" );
+            return;
         }
 
-        // This fourth dimension is the number of independent components for which we
-        // need to keep track of min/max
-        targetSize[3] = (independent)?(components):(1);
-
         if ( this->MinMaxVolumeSize[0] != targetSize[0] ||
             this->MinMaxVolumeSize[1] != targetSize[1] ||
             this->MinMaxVolumeSize[2] != targetSize[2] ||
@@ -919,61 +531,22 @@ void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxVolume( vtkVolume *vol
                 targetSize[2] *
                 targetSize[3] ) ];
 
-            // Don't really do anything about it - but reporting this error may
-            // save some debugging time later...
-            if ( !this->MinMaxVolume )
-            {
-                vtkErrorMacro( "Problem allocating min/max volume" );
-                this->MinMaxVolumeSize[0] = 0;
-                this->MinMaxVolumeSize[1] = 0;
-                this->MinMaxVolumeSize[2] = 0;
-                this->MinMaxVolumeSize[3] = 0;
-                return;
-            }
-
             this->MinMaxVolumeSize[0] = targetSize[0];
             this->MinMaxVolumeSize[1] = targetSize[1];
             this->MinMaxVolumeSize[2] = targetSize[2];
             this->MinMaxVolumeSize[3] = targetSize[3];
-
-            // Initialize the structure
-            unsigned short *tmpPtr = this->MinMaxVolume;
-            for ( i = 0; i < targetSize[0] * targetSize[1] * targetSize[2]; i++ )
-            {
-                for ( j = 0; j < targetSize[3]; j++ )
-                {
-                    *(tmpPtr++) = 0xffff;  // Min Scalar
-                    *(tmpPtr++) = 0;       // Max Scalar
-                    *(tmpPtr++) = 0;       // Max Gradient Magnitude and
-                }                      // Flag computed from transfer functions
-            }
-
-            // Now put the scalar data values into the structure
-            int scalarType   = input->GetScalarType();
-            void *dataPtr = input->GetScalarPointer();
-
-            switch ( scalarType )
-            {
-                vtkTemplateMacro(
-                    vtkSlicerFixedPointVolumeRayCastMapperFillInMinMaxVolume(
-                    (VTK_TT *)(dataPtr), this->MinMaxVolume, dim, targetSize,
-                    independent, components, this->TableShift, this->TableScale) );
-            }
         }
 
-        this->SavedMinMaxInput = input;
-        this->SavedMinMaxBuildTime.Modified();
-    }
-
-    if ( needToUpdate&0x04 )
-    {
-        // Now put the gradient magnitude values into the structure
-        this->FillInMaxGradientMagnitudes( dim, this->MinMaxVolumeSize );
+        // The flags computed below are written into the copy
+        memcpy( this->MinMaxVolume, minMaxVolume->GetPointer(0),
+                3 * targetSize[0] * targetSize[1] * targetSize[2] * targetSize[3] *
+                sizeof(unsigned short) );
 
         // It is OK to use this same variable for scalars and gradient magnitudes - either
         // we just rebuilt the min max volume from the scalars, or the MTime on the input
         // is already less than this build time so updating it again won't matter for
         // future checks
+        this->SavedMinMaxInput = input;
         this->SavedMinMaxBuildTime.Modified();
     }
 
@@ -1128,7 +701,11 @@ int vtkSlicerFixedPointVolumeRayCastMapper::PerImageInitialization( vtkRenderer
     // on the previous one and the previous render time. Don't let
     // the adjusted image sample distance be less than the minimum image sample
     // distance or more than the maximum image sample distance.
-    if ( this->AutoAdjustSampleDistances )
+    if ( this->ProgressiveRefinement )
+    {
+        this->UpdateRefinement( ren, vol );
+    }
+    else if ( this->AutoAdjustSampleDistances )
     {
         //SLICERADD
         if(this->ManualInteractive==1)
@@ -1270,11 +847,124 @@ void vtkSlicerFixedPointVolumeRayCastMapper::RenderSubVolume()
 {
     // Set the number of threads to use for ray casting,
     // then set the execution method and do it.
+    this->InitializeTiles();
     this->Threader->SetSingleMethod( SlicerFixedPointVolumeRayCastMapper_CastRays,
         (void *)this);
     this->Threader->SingleMethodExecute();
 }
 
+// Split the rows of the image into tiles and give each thread a contiguous
+// range of tiles. Tiles are small enough (about 16 per thread) for the idle
+// threads to balance the work by stealing tiles.
+void vtkSlicerFixedPointVolumeRayCastMapper::InitializeTiles()
+{
+    int imageInUseSize[2];
+    this->RayCastImage->GetImageInUseSize( imageInUseSize );
+    int threadCount = this->Threader->GetNumberOfThreads();
+
+    this->NumberOfRows = imageInUseSize[1];
+    this->RowsPerTile = this->NumberOfRows / ( 16 * threadCount );
+    if ( this->RowsPerTile < 1 )
+    {
+        this->RowsPerTile = 1;
+    }
+    this->NumberOfTiles =
+        ( this->NumberOfRows + this->RowsPerTile - 1 ) / this->RowsPerTile;
+
+    if ( this->NumberOfTileRanges != threadCount )
+    {
+        delete [] this->TileRanges;
+        this->TileRanges = new int [2*threadCount];
+        this->NumberOfTileRanges = threadCount;
+    }
+    for ( int t = 0; t < threadCount; t++ )
+    {
+        this->TileRanges[2*t]   = this->NumberOfTiles * t / threadCount;
+        this->TileRanges[2*t+1] = this->NumberOfTiles * (t+1) / threadCount;
+    }
+    this->NumberOfStartedTiles = 0;
+
+    this->NumberOfCastRays            = 0;
+    this->NumberOfEarlyTerminatedRays = 0;
+    this->NumberOfStolenTiles         = 0;
+}
+
+int vtkSlicerFixedPointVolumeRayCastMapper::GetNextTile( int threadID,
+                                                         int &firstRow,
+                                                         int &endRow )
+{
+    // Thread 0 runs in the thread that called Render(), it is the only one
+    // that can invoke AbortCheckEvent, the other threads read the flag.
+    if ( this->RenderWindow &&
+         ( threadID == 0 ? this->RenderWindow->CheckAbortStatus() :
+                           this->RenderWindow->GetAbortRender() ) )
+    {
+        return 0;
+    }
+
+    int tile = -1;
+    this->TileLock->Lock();
+    int *range = this->TileRanges + 2*threadID;
+    if ( range[0] >= range[1] )
+    {
+        // No tile left in the range of this thread, steal the second half of
+        // the tiles left to the thread with the most of them.
+        int busiestThread = -1;
+        int mostTiles = 0;
+        for ( int t = 0; t < this->NumberOfTileRanges; t++ )
+        {
+            int tiles = this->TileRanges[2*t+1] - this->TileRanges[2*t];
+            if ( tiles > mostTiles )
+            {
+                mostTiles = tiles;
+                busiestThread = t;
+            }
+        }
+        if ( busiestThread >= 0 )
+        {
+            int stolenTiles = ( mostTiles + 1 ) / 2;
+            range[1] = this->TileRanges[2*busiestThread+1];
+            range[0] = range[1] - stolenTiles;
+            this->TileRanges[2*busiestThread+1] = range[0];
+            this->NumberOfStolenTiles += stolenTiles;
+        }
+    }
+    if ( range[0] < range[1] )
+    {
+        tile = range[0]++;
+        this->NumberOfStartedTiles++;
+    }
+    int startedTiles = this->NumberOfStartedTiles;
+    this->TileLock->Unlock();
+
+    if ( tile < 0 )
+    {
+        return 0;
+    }
+
+    firstRow = tile * this->RowsPerTile;
+    endRow   = firstRow + this->RowsPerTile;
+    endRow   = (endRow > this->NumberOfRows)?(this->NumberOfRows):(endRow);
+
+    if ( threadID == 0 )
+    {
+        float fargs[1];
+        fargs[0] = static_cast<float>(startedTiles) /
+            static_cast<float>(this->NumberOfTiles);
+        this->InvokeEvent( vtkCommand::ProgressEvent, fargs );
+    }
+    return 1;
+}
+
+void vtkSlicerFixedPointVolumeRayCastMapper::AddRayStatistics( vtkTypeInt64 castRays,
+                                                               vtkTypeInt64 terminatedRays )
+{
+    this->TileLock->Lock();
+    this->NumberOfCastRays            += castRays;
+    this->NumberOfEarlyTerminatedRays += terminatedRays;
+    this->TileLock->Unlock();
+}
+
 // This method displays the image that has been created
 void vtkSlicerFixedPointVolumeRayCastMapper::DisplayRenderedImage( vtkRenderer *ren,
                                                                   vtkVolume   *vol )
@@ -1303,6 +993,88 @@ void vtkSlicerFixedPointVolumeRayCastMapper::AbortRender()
     // Restore values
     this->ImageSampleDistance = this->OldImageSampleDistance;
     this->SampleDistance      = this->OldSampleDistance;
+
+    // The pass was interrupted, start again from a coarse image
+    this->RestartRefinement();
+}
+
+// Abort the render because the render window requested it (e.g. an
+// interaction event is pending). The image is not final, so the view must be
+// rendered again even if the pending events don't trigger a render.
+void vtkSlicerFixedPointVolumeRayCastMapper::AbortRefinementPass()
+{
+    this->AbortRender();
+    if ( this->ProgressiveRefinement )
+    {
+        this->InvokeEvent( vtkSlicerFixedPointVolumeRayCastMapper::RefinementRequiredEvent );
+    }
+}
+
+void vtkSlicerFixedPointVolumeRayCastMapper::RestartRefinement()
+{
+    this->RefinementMTime    = 0;
+    this->RefinementComplete = 0;
+}
+
+// Choose the sample distances of the current pass of the progressive
+// refinement: restart from a coarse image if anything changed since the
+// previous pass, otherwise halve the image sample distance.
+void vtkSlicerFixedPointVolumeRayCastMapper::UpdateRefinement( vtkRenderer *ren,
+                                                               vtkVolume *vol )
+{
+    double camera[11];
+    vtkCamera *activeCamera = ren->GetActiveCamera();
+    activeCamera->GetPosition( camera );
+    activeCamera->GetFocalPoint( camera + 3 );
+    activeCamera->GetViewUp( camera + 6 );
+    camera[9]  = activeCamera->GetViewAngle();
+    camera[10] = activeCamera->GetParallelScale();
+
+    int size[2];
+    ren->GetTiledSize( &size[0], &size[1] );
+
+    unsigned long mtime = this->GetMTime();
+    unsigned long volumeMTime = vol->GetMTime();
+    mtime = (volumeMTime > mtime)?(volumeMTime):(mtime);
+    if ( this->GetInput() )
+    {
+        unsigned long inputMTime = this->GetInput()->GetMTime();
+        mtime = (inputMTime > mtime)?(inputMTime):(mtime);
+    }
+
+    int changed = ( mtime != this->RefinementMTime ||
+                    size[0] != this->RefinementSize[0] ||
+                    size[1] != this->RefinementSize[1] );
+    for ( int c = 0; c < 11; c++ )
+    {
+        changed = changed || ( camera[c] != this->RefinementCamera[c] );
+        this->RefinementCamera[c] = camera[c];
+    }
+    this->RefinementSize[0] = size[0];
+    this->RefinementSize[1] = size[1];
+    this->RefinementMTime = mtime;
+
+    if ( changed )
+    {
+        this->RefinementComplete = 0;
+        this->ImageSampleDistance =
+            this->ComputeRequiredImageSampleDistance( this->RenderTimeBudget, ren, vol );
+        if ( this->InteractiveSampleDistance > this->SampleDistance )
+        {
+            this->SampleDistance = this->InteractiveSampleDistance;
+        }
+    }
+    else if ( !this->RefinementComplete )
+    {
+        float distance = this->ImageSampleDistance / 2.0;
+        this->ImageSampleDistance =
+            (distance < this->MinimumImageSampleDistance)?
+            (this->MinimumImageSampleDistance):(distance);
+    }
+    else
+    {
+        this->ImageSampleDistance = this->MinimumImageSampleDistance;
+    }
 }
 
 // Capture the ZBuffer to use for intermixing with opaque geometry
@@ -1391,14 +1163,14 @@ void vtkSlicerFixedPointVolumeRayCastMapper::Render( vtkRenderer *ren, vtkVolume
     this->PerVolumeInitialization( ren, vol );
     if ( this->RenderWindow->CheckAbortStatus() )
     {
-        this->AbortRender();
+        this->AbortRefinementPass();
         return;
     }
 
     this->PerSubVolumeInitialization( ren, vol, 0 );
     if ( this->RenderWindow->CheckAbortStatus() )
     {
-        this->AbortRender();
+        this->AbortRefinementPass();
         return;
     }
 
@@ -1406,7 +1178,7 @@ void vtkSlicerFixedPointVolumeRayCastMapper::Render( vtkRenderer *ren, vtkVolume
 
     if ( this->RenderWindow->CheckAbortStatus() )
     {
-        this->AbortRender();
+        this->AbortRefinementPass();
         return;
     }
 
@@ -1424,7 +1196,19 @@ void vtkSlicerFixedPointVolumeRayCastMapper::Render( vtkRenderer *ren, vtkVolume
         (this->SampleDistance - this->OldSampleDistance) /
         this->OldSampleDistance ) );
 
+    if ( this->ProgressiveRefinement )
+    {
+        this->RefinementComplete =
+            ( this->ImageSampleDistance <= this->MinimumImageSampleDistance &&
+            this->SampleDistance == this->OldSampleDistance );
+    }
+
     this->SampleDistance = this->OldSampleDistance;
+
+    if ( this->ProgressiveRefinement && !this->RefinementComplete )
+    {
+        this->InvokeEvent( vtkSlicerFixedPointVolumeRayCastMapper::RefinementRequiredEvent );
+    }
 }
 
 VTK_THREAD_RETURN_TYPE SlicerFixedPointVolumeRayCastMapper_CastRays( void *arg )
@@ -2522,127 +2306,63 @@ void vtkSlicerFixedPointVolumeRayCastMapper::ComputeGradients( vtkVolume *vol )
 {
     vtkImageData *input = this->GetInput();
 
-    void *dataPtr = input->GetScalarPointer();
-
-    int scalarType   = input->GetScalarType();
     int components   = input->GetPointData()->GetScalars()->GetNumberOfComponents();
     int independent  = vol->GetProperty()->GetIndependentComponents();
 
     int dim[3];
-    double spacing[3];
     input->GetDimensions(dim);
-    input->GetSpacing(spacing);
 
-    // Find the scalar range
-    double scalarRange[4][2];
-    int c;
-    for ( c = 0; c < components; c++ )
+    // The gradients only depend on the input, they are computed once and
+    // shared with the other mappers rendering it (e.g. in other views)
+    vtkSmartPointer<vtkUnsignedShortArray> gradientNormal;
+    vtkSmartPointer<vtkUnsignedCharArray>  gradientMagnitude;
+    vtkSlicerFixedPointVolumeRayCastCache::GetInstance()->GetGradients(
+        input, independent, this, gradientNormal, gradientMagnitude );
+    if ( !gradientNormal || !gradientMagnitude )
     {
-        input->GetPointData()->GetScalars()->GetRange(scalarRange[c], c);
+        vtkErrorMacro( "Problem computing gradients" );
+        this->ReleaseGradients();
+        return;
     }
 
-    int sliceSize = dim[0]*dim[1]*((independent)?(components):(1));
-    int numSlices = dim[2];
-
-    int i;
-
-    // Delete the prior gradient normal information
-    if ( this->GradientNormal )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientNormal )
-        {
-            delete [] this->ContiguousGradientNormal;
-            this->ContiguousGradientNormal = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientNormal[i];
-            }
-        }
-        delete [] this->GradientNormal;
-        this->GradientNormal = NULL;
-    }
+    // Registered before releasing the prior gradients, they may be the same
+    gradientNormal->Register( this );
+    gradientMagnitude->Register( this );
+    this->ReleaseGradients();
+    this->GradientNormalArray = gradientNormal;
+    this->GradientMagnitudeArray = gradientMagnitude;
 
-    // Delete the prior gradient magnitude information
-    if ( this->GradientMagnitude )
-    {
-        // Contiguous? Delete in one chunk otherwise delete slice by slice
-        if ( this->ContiguousGradientMagnitude )
-        {
-            delete [] this->ContiguousGradientMagnitude;
-            this->ContiguousGradientMagnitude = NULL;
-        }
-        else
-        {
-            for ( i = 0; i < this->NumberOfGradientSlices; i++ )
-            {
-                delete [] this->GradientMagnitude[i];
-            }
-        }
-        delete [] this->GradientMagnitude;
-        this->GradientMagnitude = NULL;
-    }
+    vtkIdType sliceSize = static_cast<vtkIdType>(dim[0])*dim[1]*((independent)?(components):(1));
+    int numSlices = dim[2];
 
     this->NumberOfGradientSlices = numSlices;
     this->GradientNormal  = new unsigned short *[numSlices];
     this->GradientMagnitude = new unsigned char *[numSlices];
-
-    // first, attempt contiguous memory. If this fails, then go
-    // for non-contiguous
-    this->ContiguousGradientNormal = new unsigned short [numSlices * sliceSize];
-    this->ContiguousGradientMagnitude = new unsigned char [numSlices * sliceSize];
-
-    if ( this->ContiguousGradientNormal )
+    for ( int i = 0; i < numSlices; i++ )
     {
-        // We were able to allocate contiguous space - we just need to set the
-        // slice pointers here
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientNormal[i]  = this->ContiguousGradientNormal + i*sliceSize;
-        }
-    }
-    else
-    {
-        // We were not able to allocate contigous space - allocate it slice by slice
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientNormal[i]  = new unsigned short [sliceSize];
-        }
+        this->GradientNormal[i]    = gradientNormal->GetPointer(0) + i*sliceSize;
+        this->GradientMagnitude[i] = gradientMagnitude->GetPointer(0) + i*sliceSize;
     }
+}
 
-    if ( this->ContiguousGradientMagnitude )
-    {
-        // We were able to allocate contiguous space - we just need to set the
-        // slice pointers here
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientMagnitude[i]  = this->ContiguousGradientMagnitude + i*sliceSize;
-        }
-    }
-    else
+void vtkSlicerFixedPointVolumeRayCastMapper::ReleaseGradients()
+{
+    // The arrays are shared, only the slice pointers belong to the mapper
+    delete [] this->GradientNormal;
+    this->GradientNormal = NULL;
+    delete [] this->GradientMagnitude;
+    this->GradientMagnitude = NULL;
+    this->NumberOfGradientSlices = 0;
+
+    if ( this->GradientNormalArray )
     {
-        // We were not able to allocate contigous space - allocate it slice by slice
-        for ( i = 0; i < numSlices; i++ )
-        {
-            this->GradientMagnitude[i] = new unsigned char [sliceSize];
-        }
+        this->GradientNormalArray->UnRegister( this );
+        this->GradientNormalArray = NULL;
     }
-
-
-
-    switch ( scalarType )
+    if ( this->GradientMagnitudeArray )
     {
-        vtkTemplateMacro(
-            vtkSlicerFixedPointVolumeRayCastMapperComputeGradients(
-            (VTK_TT *)(dataPtr), dim, spacing, components,
-            independent, scalarRange,
-            this->GradientNormal,
-            this->GradientMagnitude,
-            this->DirectionEncoder,
-            this) );
+        this->GradientMagnitudeArray->UnRegister( this );
+        this->GradientMagnitudeArray = NULL;
     }
 }
 
@@ -3122,6 +2842,14 @@ void vtkSlicerFixedPointVolumeRayCastMapper::PrintSelf(ostream& os, vtkIndent in
         << this->AutoAdjustSampleDistances << endl;
     os << indent << "Intermix Intersecting Geometry: "
         << (this->IntermixIntersectingGeometry ? "On\n" : "Off\n");
+    os << indent << "Progressive Refinement: "
+        << (this->ProgressiveRefinement ? "On\n" : "Off\n");
+    os << indent << "Render Time Budget: " << this->RenderTimeBudget << endl;
+    os << indent << "Refinement Complete: " << this->RefinementComplete << endl;
+    os << indent << "Number Of Cast Rays: " << this->NumberOfCastRays << endl;
+    os << indent << "Number Of Early Terminated Rays: "
+        << this->NumberOfEarlyTerminatedRays << endl;
+    os << indent << "Number Of Stolen Tiles: " << this->NumberOfStolenTiles << endl;
 
     os << indent << "ShadingRequired: " << this->ShadingRequired << endl;
     os << indent << "GradientOpacityRequired: " << this->GradientOpacityRequired
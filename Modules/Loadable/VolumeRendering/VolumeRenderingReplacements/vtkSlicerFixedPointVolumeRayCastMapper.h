@@ -19,7 +19,10 @@
 // composite or MIP rendering, and can be intermixed with geometric data.
 // Space leaping is used to speed up the rendering process. In addition,
 // calculation are performed in 15 bit fixed point precision. This mapper
-// is threaded, and will interleave scan lines across processors.
+// is threaded: the scan lines are grouped into tiles, each thread renders
+// its own range of tiles then steals tiles from the busiest thread.
+// In progressive refinement mode, a coarse image is rendered first and is
+// refined by the following renders.
 //
 // This mapper is a good replacement for vtkVolumeRayCastMapper EXCEPT:
 //   - it does not do isosurface ray casting
@@ -46,13 +49,19 @@
 // the neighborhood (an unsigned char) and the flag that is filled
 // in for the current lookup tables to indicate whether this region
 // can be skipped.
+//
+// The gradients and the min, max and maximum gradient values only depend
+// on the input: they are computed once per input by
+// vtkSlicerFixedPointVolumeRayCastCache and shared by all the mappers
+// rendering it. Only the flags are computed by each mapper.
 
 // .SECTION see also
-// vtkVolumeMapper
+// vtkVolumeMapper vtkSlicerFixedPointVolumeRayCastCache
 
 #ifndef __vtkSlicerFixedPointVolumeRayCastMapper_h
 #define __vtkSlicerFixedPointVolumeRayCastMapper_h
 
+#include "vtkCommand.h"
 #include "vtkVolumeMapper.h"
 #include "VolumeRenderingReplacementsExport.h"
 
@@ -70,6 +79,7 @@ class vtkTimerLog;
 class vtkVolume;
 class vtkTransform;
 class vtkRenderWindow;
+class vtkSimpleCriticalSection;
 class vtkColorTransferFunction;
 class vtkPiecewiseFunction;
 class vtkSlicerFixedPointVolumeRayCastMIPHelper;
@@ -80,6 +90,8 @@ class vtkSlicerFixedPointVolumeRayCastCompositeShadeHelper;
 class vtkDirectionEncoder;
 class vtkEncodedGradientShader;
 class vtkFiniteDifferenceGradientEstimator;
+class vtkUnsignedCharArray;
+class vtkUnsignedShortArray;
 #include "vtkSlicerRayCastImageDisplayHelper.h"
 class vtkSlicerFixedPointRayCastImage;
 
@@ -103,6 +115,14 @@ public:
   vtkTypeMacro(vtkSlicerFixedPointVolumeRayCastMapper,vtkVolumeMapper);
   void PrintSelf( ostream& os, vtkIndent indent );
 
+  // Description:
+  // Invoked at the end of a progressive refinement pass that is not the
+  // last one: the view should be rendered again to refine the image.
+  enum
+    {
+    RefinementRequiredEvent = vtkCommand::UserEvent + 1
+    };
+
   // Description:
   // Set/Get the distance between samples used for rendering
   // when AutoAdjustSampleDistances is off, or when this mapper
@@ -152,6 +172,45 @@ public:
   vtkGetMacro( AutoAdjustSampleDistances, int );
   vtkBooleanMacro( AutoAdjustSampleDistances, int );
 
+  // Description:
+  // If ProgressiveRefinement is on, the first render after the camera, the
+  // volume, its property, the input or the mapper has changed uses the image
+  // sample distance (and the InteractiveSampleDistance along the rays)
+  // expected to fit in RenderTimeBudget. Each following render halves the
+  // image sample distance until it reaches MinimumImageSampleDistance and
+  // invokes RefinementRequiredEvent while the image is not final. A render
+  // aborted by the render window (see vtkRenderWindow::SetAbortRender(),
+  // typically set by an AbortCheckEvent observer when interaction events
+  // are pending) also invokes RefinementRequiredEvent and restarts the
+  // refinement from a coarse image. The abort status is checked before
+  // each tile. AutoAdjustSampleDistances is ignored in this mode.
+  vtkSetClampMacro( ProgressiveRefinement, int, 0, 1 );
+  vtkGetMacro( ProgressiveRefinement, int );
+  vtkBooleanMacro( ProgressiveRefinement, int );
+
+  // Description:
+  // Time in seconds allocated to the first, coarse, pass of the
+  // progressive refinement. 0.1s by default.
+  vtkSetClampMacro( RenderTimeBudget, double, 0.001, 100.0 );
+  vtkGetMacro( RenderTimeBudget, double );
+
+  // Description:
+  // Return 1 if the last render was the final pass of the progressive
+  // refinement.
+  vtkGetMacro( RefinementComplete, int );
+
+  // Description:
+  // Make the next render start a new progressive refinement.
+  void RestartRefinement();
+
+  // Description:
+  // Statistics of the last render: number of rays cast (rays that miss
+  // the volume are not counted), number of rays terminated early because
+  // they were opaque, and number of tiles stolen by idle threads.
+  vtkGetMacro( NumberOfCastRays, vtkTypeInt64 );
+  vtkGetMacro( NumberOfEarlyTerminatedRays, vtkTypeInt64 );
+  vtkGetMacro( NumberOfStolenTiles, int );
+
   // Description:
   // Set/Get the number of threads to use. This by default is equal to
   // the number of available processors detected.
@@ -256,6 +315,19 @@ public:
   void RenderSubVolume();
   void DisplayRenderedImage( vtkRenderer *, vtkVolume * );
   void AbortRender();
+  void AbortRefinementPass();
+
+  // Description:
+  // WARNING: INTERNAL METHOD - NOT INTENDED FOR GENERAL USE
+  // Give the rows [firstRow, endRow) of the next tile to render by the
+  // thread threadID. Return 0 when all the tiles are rendered or when the
+  // render is aborted.
+  int GetNextTile( int threadID, int &firstRow, int &endRow );
+
+  // Description:
+  // WARNING: INTERNAL METHOD - NOT INTENDED FOR GENERAL USE
+  // Accumulate the ray statistics of a thread.
+  void AddRayStatistics( vtkTypeInt64 castRays, vtkTypeInt64 terminatedRays );
 
 
 protected:
@@ -286,6 +358,34 @@ protected:
   float                        OldSampleDistance;
   float                        OldImageSampleDistance;
 
+  // Progressive refinement
+  int                          ProgressiveRefinement;
+  double                       RenderTimeBudget;
+  int                          RefinementComplete;
+  double                       RefinementCamera[11];
+  int                          RefinementSize[2];
+  unsigned long                RefinementMTime;
+
+  // Choose the sample distances of the current refinement pass
+  void UpdateRefinement( vtkRenderer *ren, vtkVolume *vol );
+
+  // Work stealing scheduling of the tiles of rows. Each thread owns the
+  // range [TileRanges[2*t], TileRanges[2*t+1]) of tiles.
+  vtkSimpleCriticalSection    *TileLock;
+  int                         *TileRanges;
+  int                          NumberOfTileRanges;
+  int                          NumberOfTiles;
+  int                          NumberOfStartedTiles;
+  int                          RowsPerTile;
+  int                          NumberOfRows;
+
+  void InitializeTiles();
+
+  // Statistics of the last render
+  vtkTypeInt64                 NumberOfCastRays;
+  vtkTypeInt64                 NumberOfEarlyTerminatedRays;
+  int                          NumberOfStolenTiles;
+
   // Internal method for computing matrices needed during
   // ray casting
   void ComputeMatrices( double volumeOrigin[3],
@@ -365,8 +465,10 @@ protected:
 
   unsigned short           **GradientNormal;
   unsigned char            **GradientMagnitude;
-  unsigned short            *ContiguousGradientNormal;
-  unsigned char             *ContiguousGradientMagnitude;
+  // Arrays shared through vtkSlicerFixedPointVolumeRayCastCache,
+  // GradientNormal and GradientMagnitude point to their slices.
+  vtkUnsignedShortArray     *GradientNormalArray;
+  vtkUnsignedCharArray      *GradientMagnitudeArray;
 
   int                        NumberOfGradientSlices;
 
@@ -397,6 +499,7 @@ protected:
   void          UpdateCroppingRegions();
 
   void          ComputeGradients( vtkVolume *vol );
+  void          ReleaseGradients();
 
   int           ClipRayAgainstClippingPlanes( float  rayStart[3],
                                               float  rayEnd[3],
@@ -439,8 +542,6 @@ protected:
   vtkTimeStamp    SavedMinMaxFlagTime;
 
   void            UpdateMinMaxVolume( vtkVolume *vol );
-  void            FillInMaxGradientMagnitudes( int fullDim[3],
-                                               int smallDim[3] );
 
 private:
   vtkSlicerFixedPointVolumeRayCastMapper(const vtkSlicerFixedPointVolumeRayCastMapper&);  // Not implemented.
@@ -63,6 +63,8 @@ void qSlicerCPURayCastVolumeRenderingPropertiesWidgetPrivate
   this->populateRenderingTechniqueComboBox();
   QObject::connect(this->RenderingTechniqueComboBox, SIGNAL(currentIndexChanged(int)),
                    widget, SLOT(setRenderingTechnique(int)));
+  QObject::connect(this->RenderTimeBudgetSpinBox, SIGNAL(valueChanged(double)),
+                   widget, SLOT(setRenderTimeBudget(double)));
 }
 
 // --------------------------------------------------------------------------
@@ -123,6 +125,8 @@ void qSlicerCPURayCastVolumeRenderingPropertiesWidget
     index = 0;
     }
   d->RenderingTechniqueComboBox->setCurrentIndex(index);
+  d->RenderTimeBudgetSpinBox->setValue(
+    this->mrmlCPURayCastDisplayNode()->GetRenderTimeBudget());
 }
 
 //-----------------------------------------------------------------------------
@@ -137,3 +141,14 @@ void qSlicerCPURayCastVolumeRenderingPropertiesWidget
   int technique = d->RenderingTechniqueComboBox->itemData(index).toInt();
   this->mrmlCPURayCastDisplayNode()->SetRaycastTechnique(technique);
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerCPURayCastVolumeRenderingPropertiesWidget
+::setRenderTimeBudget(double budget)
+{
+  if (!this->mrmlCPURayCastDisplayNode())
+    {
+    return;
+    }
+  this->mrmlCPURayCastDisplayNode()->SetRenderTimeBudget(budget);
+}
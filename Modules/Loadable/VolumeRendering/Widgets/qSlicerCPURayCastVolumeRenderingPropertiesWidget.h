@@ -40,6 +40,7 @@ public:
 
 public slots:
   void setRenderingTechnique(int index);
+  void setRenderTimeBudget(double budget);
 
 protected slots:
   virtual void updateWidgetFromMRML();
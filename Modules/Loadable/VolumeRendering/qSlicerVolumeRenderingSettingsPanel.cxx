@@ -105,6 +105,12 @@ void qSlicerVolumeRenderingSettingsPanelPrivate::init()
 
   q->registerProperty("VolumeRendering/GPUMemorySize", q, "gpuMemory",
                       SIGNAL(gpuMemoryChanged(int)));
+
+  QObject::connect(this->PersistentAccelerationStructuresCheckBox, SIGNAL(toggled(bool)),
+                   q, SLOT(onPersistentAccelerationStructuresChanged(bool)));
+  q->registerProperty("VolumeRendering/PersistentAccelerationStructures", q,
+                      "persistentAccelerationStructures",
+                      SIGNAL(persistentAccelerationStructuresChanged(bool)));
 }
 
 // --------------------------------------------------------------------------
@@ -301,3 +307,27 @@ void qSlicerVolumeRenderingSettingsPanel
   d->VolumeRenderingLogic->SetDefaultRenderingMethod(
     this->defaultRenderingMethod().toLatin1());
 }
+
+// --------------------------------------------------------------------------
+bool qSlicerVolumeRenderingSettingsPanel::persistentAccelerationStructures()const
+{
+  Q_D(const qSlicerVolumeRenderingSettingsPanel);
+  return d->PersistentAccelerationStructuresCheckBox->isChecked();
+}
+
+// --------------------------------------------------------------------------
+void qSlicerVolumeRenderingSettingsPanel
+::setPersistentAccelerationStructures(bool persistent)
+{
+  Q_D(qSlicerVolumeRenderingSettingsPanel);
+  d->PersistentAccelerationStructuresCheckBox->setChecked(persistent);
+}
+
+// --------------------------------------------------------------------------
+void qSlicerVolumeRenderingSettingsPanel
+::onPersistentAccelerationStructuresChanged(bool persistent)
+{
+  vtkMRMLVolumeRenderingDisplayableManager::SetPersistentAccelerationStructures(
+    persistent);
+  emit persistentAccelerationStructuresChanged(persistent);
+}
@@ -37,6 +37,7 @@ class Q_SLICER_QTMODULES_VOLUMERENDERING_EXPORT qSlicerVolumeRenderingSettingsPa
   QVTK_OBJECT
   Q_PROPERTY(int gpuMemory READ gpuMemory WRITE setGPUMemory NOTIFY gpuMemoryChanged)
   Q_PROPERTY(QString defaultRenderingMethod READ defaultRenderingMethod WRITE setDefaultRenderingMethod NOTIFY defaultRenderingMethodChanged)
+  Q_PROPERTY(bool persistentAccelerationStructures READ persistentAccelerationStructures WRITE setPersistentAccelerationStructures NOTIFY persistentAccelerationStructuresChanged)
 public:
   /// Superclass typedef
   typedef ctkSettingsPanel Superclass;
@@ -56,17 +57,24 @@ public:
   void setGPUMemory(int gpuMemory);
 
   QString defaultRenderingMethod()const;
+
+  /// CPU ray casting acceleration structures are saved next to the volumes.
+  /// \sa vtkMRMLVolumeRenderingDisplayableManager::SetPersistentAccelerationStructures
+  bool persistentAccelerationStructures()const;
 public slots:
   void setDefaultRenderingMethod(const QString& method);
+  void setPersistentAccelerationStructures(bool persistent);
 
 signals:
   void gpuMemoryChanged(int);
   void defaultRenderingMethodChanged(const QString&);
+  void persistentAccelerationStructuresChanged(bool);
 
 protected slots:
   void onVolumeRenderingLogicModified();
   void onGPUMemoryChanged();
   void onDefaultRenderingMethodChanged(int);
+  void onPersistentAccelerationStructuresChanged(bool);
   void updateVolumeRenderingLogicDefaultRenderingMethod();
 
 protected:
@@ -33,6 +33,7 @@
 #include "vtkMRMLDiffusionWeightedVolumeNode.h"
 #include "vtkMRMLLabelMapVolumeDisplayNode.h"
 #include "vtkMRMLLabelMapVolumeNode.h"
+#include "vtkMRMLModelNode.h"
 #include "vtkMRMLNRRDStorageNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLVectorVolumeDisplayNode.h"
@@ -40,15 +41,22 @@
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
 #include "vtkMRMLTransformNode.h"
 
+// vtkAddon includes
+#include <vtkPolyDataToLabelMapFilter.h>
+
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
 #include <vtkGeneralTransform.h>
 #include <vtkImageData.h>
 #include <vtkImageThreshold.h>
+#include <vtkIntArray.h>
 #include <vtkMathUtilities.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
 #include <vtksys/SystemTools.hxx>
@@ -1004,6 +1012,81 @@ vtkSlicerVolumesLogic::FillLabelVolumeFromTemplate(vtkMRMLScene *scene,
   return labelNode;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerVolumesLogic::PaintModelsIntoLabelVolume(vtkMRMLLabelMapVolumeNode *labelNode,
+                                                       vtkCollection *modelNodes,
+                                                       vtkIntArray *labelValues)
+{
+  if (labelNode == NULL || labelNode->GetImageData() == NULL || modelNodes == NULL)
+    {
+    vtkErrorMacro("PaintModelsIntoLabelVolume: invalid label map or models");
+    return false;
+    }
+
+  // The surfaces are voxelized in the IJK coordinate system of the label map
+  vtkNew<vtkGeneralTransform> worldToIJK;
+  worldToIJK->PostMultiply();
+  vtkMRMLTransformNode* labelTransformNode = labelNode->GetParentTransformNode();
+  if (labelTransformNode)
+    {
+    worldToIJK->Concatenate(labelTransformNode->GetCompiledTransformFromWorld());
+    }
+  vtkNew<vtkMatrix4x4> rasToIJK;
+  labelNode->GetRASToIJKMatrix(rasToIJK.GetPointer());
+  worldToIJK->Concatenate(rasToIJK.GetPointer());
+
+  vtkNew<vtkPolyDataToLabelMapFilter> voxelizer;
+#if (VTK_MAJOR_VERSION <= 5)
+  voxelizer->SetInput(labelNode->GetImageData());
+#else
+  voxelizer->SetInputData(labelNode->GetImageData());
+#endif
+  int surfaceIndex = 0;
+  for (int i = 0; i < modelNodes->GetNumberOfItems(); ++i)
+    {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(modelNodes->GetItemAsObject(i));
+    if (modelNode == NULL || modelNode->GetPolyData() == NULL ||
+        modelNode->GetPolyData()->GetPoints() == NULL)
+      {
+      continue;
+      }
+    vtkPolyData* polyData = modelNode->GetPolyData();
+    vtkNew<vtkPoints> worldPoints;
+    vtkMRMLTransformNode* modelTransformNode = modelNode->GetParentTransformNode();
+    if (modelTransformNode)
+      {
+      modelTransformNode->TransformPointsToWorld(polyData->GetPoints(), worldPoints.GetPointer());
+      }
+    else
+      {
+      worldPoints->DeepCopy(polyData->GetPoints());
+      }
+    vtkNew<vtkPoints> ijkPoints;
+    worldToIJK->TransformPoints(worldPoints.GetPointer(), ijkPoints.GetPointer());
+
+    vtkNew<vtkPolyData> surface;
+    surface->ShallowCopy(polyData);
+    surface->SetPoints(ijkPoints.GetPointer());
+#if (VTK_MAJOR_VERSION <= 5)
+    voxelizer->AddInputSurface(surface.GetPointer());
+#else
+    voxelizer->AddInputSurfaceData(surface.GetPointer());
+#endif
+    voxelizer->SetLabelValue(surfaceIndex++,
+      (labelValues && i < labelValues->GetNumberOfTuples()) ? labelValues->GetValue(i) : i + 1);
+    }
+  if (surfaceIndex == 0)
+    {
+    return true;
+    }
+  voxelizer->Update();
+
+  vtkNew<vtkImageData> paintedImageData;
+  paintedImageData->DeepCopy(voxelizer->GetOutput());
+  labelNode->SetAndObserveImageData(paintedImageData.GetPointer());
+  return true;
+}
+
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerVolumesLogic::CheckForLabelVolumeValidity(vtkMRMLScalarVolumeNode *volumeNode,
@@ -1534,9 +1617,8 @@ vtkSlicerVolumesLogic
     scene->GetNodeByID(inputVolumeNode->GetTransformNodeID()));
   if (inputVolumeNodeTransformNode.GetPointer() != NULL)
     {
-    vtkSmartPointer<vtkGeneralTransform> inputVolumeRAS2RAS = vtkSmartPointer<vtkGeneralTransform>::New();
-    inputVolumeNodeTransformNode->GetTransformToWorld(inputVolumeRAS2RAS);
-    outputVolumeResliceTransform->Concatenate(inputVolumeRAS2RAS);
+    outputVolumeResliceTransform->Concatenate(
+      inputVolumeNodeTransformNode->GetCompiledTransformToWorld());
     }
 
   vtkSmartPointer<vtkMRMLTransformNode> referenceVolumeNodeTransformNode = vtkMRMLTransformNode::SafeDownCast(
@@ -1544,9 +1626,8 @@ vtkSlicerVolumesLogic
   if (referenceVolumeNodeTransformNode.GetPointer() != NULL &&
       inputVolumeNodeTransformNode.GetPointer() != NULL)
     {
-    vtkSmartPointer<vtkGeneralTransform> ras2referenceVolumeRAS = vtkSmartPointer<vtkGeneralTransform>::New();
-    inputVolumeNodeTransformNode->GetTransformFromWorld(ras2referenceVolumeRAS);
-    outputVolumeResliceTransform->Concatenate(ras2referenceVolumeRAS);
+    outputVolumeResliceTransform->Concatenate(
+      inputVolumeNodeTransformNode->GetCompiledTransformFromWorld());
     }
 
   vtkSmartPointer<vtkMatrix4x4> referenceVolumeRAS2IJKMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -35,6 +35,8 @@
 
 #include "vtkSlicerVolumesModuleLogicExport.h"
 
+class vtkCollection;
+class vtkIntArray;
 class vtkMRMLLabelMapVolumeNode;
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLScalarVolumeDisplayNode;
@@ -177,6 +179,18 @@ public:
                                                        vtkMRMLLabelMapVolumeNode *labelNode,
                                                        vtkMRMLVolumeNode *templateNode);
 
+  /// Set the voxels of the label map whose center is inside the closed
+  /// surface of a model to the label value of that model.
+  /// The i-th model node of \a modelNodes is painted with the i-th value of
+  /// \a labelValues, or with i+1 if no value is given. Later models overwrite
+  /// earlier ones. Parent transforms of the models and of the label map are
+  /// taken into account. All the models are voxelized in a single pass.
+  /// Return false if the label map has no image data.
+  /// \sa vtkPolyDataToLabelMapFilter
+  bool PaintModelsIntoLabelVolume(vtkMRMLLabelMapVolumeNode *labelNode,
+                                  vtkCollection *modelNodes,
+                                  vtkIntArray *labelValues = 0);
+
   /// Return a string listing any warnings about the spatial validity of
   /// the labelmap with respect to the volume.  An empty string indicates
   /// that the two volumes are identical samplings of the same spatial
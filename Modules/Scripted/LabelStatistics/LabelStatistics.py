@@ -268,75 +268,28 @@ class LabelStatisticsLogic:
     self.labelStats = {}
     self.labelStats['Labels'] = []
 
-    stataccum = vtk.vtkImageAccumulate()
+    # all the labels are computed in a single pass over the volumes
+    stats = slicer.vtkImageLabelStatistics()
     if vtk.VTK_MAJOR_VERSION <= 5:
-      stataccum.SetInput(labelNode.GetImageData())
+      stats.SetInput(labelNode.GetImageData())
+      stats.SetGrayscale(grayscaleNode.GetImageData())
     else:
-      stataccum.SetInputConnection(labelNode.GetImageDataConnection())
-    stataccum.Update()
-    lo = int(stataccum.GetMin()[0])
-    hi = int(stataccum.GetMax()[0])
-
-    for i in xrange(lo,hi+1):
-
-      # this->SetProgress((float)i/hi);
-      # std::string event_message = "Label "; std::stringstream s; s << i; event_message.append(s.str());
-      # this->InvokeEvent(vtkLabelStatisticsLogic::LabelStatsOuterLoop, (void*)event_message.c_str());
-
-      # logic copied from slicer3 LabelStatistics
-      # to create the binary volume of the label
-      # //logic copied from slicer2 LabelStatistics MaskStat
-      # // create the binary volume of the label
-      thresholder = vtk.vtkImageThreshold()
-      if vtk.VTK_MAJOR_VERSION <= 5:
-        thresholder.SetInput(labelNode.GetImageData())
-      else:
-        thresholder.SetInputConnection(labelNode.GetImageDataConnection())
-      thresholder.SetInValue(1)
-      thresholder.SetOutValue(0)
-      thresholder.ReplaceOutOn()
-      thresholder.ThresholdBetween(i,i)
-      thresholder.SetOutputScalarType(grayscaleNode.GetImageData().GetScalarType())
-      thresholder.Update()
-
-      # this.InvokeEvent(vtkLabelStatisticsLogic::LabelStatsInnerLoop, (void*)"0.25");
-
-      #  use vtk's statistics class with the binary labelmap as a stencil
-      stencil = vtk.vtkImageToImageStencil()
-      if vtk.VTK_MAJOR_VERSION <= 5:
-        stencil.SetInput(thresholder.GetOutput())
-      else:
-        stencil.SetInputConnection(thresholder.GetOutputPort())
-      stencil.ThresholdBetween(1, 1)
-
-      # this.InvokeEvent(vtkLabelStatisticsLogic::LabelStatsInnerLoop, (void*)"0.5")
-
-      stat1 = vtk.vtkImageAccumulate()
-      if vtk.VTK_MAJOR_VERSION <= 5:
-        stat1.SetInput(grayscaleNode.GetImageData())
-        stat1.SetStencil(stencil.GetOutput())
-      else:
-        stat1.SetInputConnection(grayscaleNode.GetImageDataConnection())
-        stencil.Update()
-        stat1.SetStencilData(stencil.GetOutput())
-
-      stat1.Update()
-
-      # this.InvokeEvent(vtkLabelStatisticsLogic::LabelStatsInnerLoop, (void*)"0.75")
-
-      if stat1.GetVoxelCount() > 0:
-        # add an entry to the LabelStats list
-        self.labelStats["Labels"].append(i)
-        self.labelStats[i,"Index"] = i
-        self.labelStats[i,"Count"] = stat1.GetVoxelCount()
-        self.labelStats[i,"Volume mm^3"] = self.labelStats[i,"Count"] * cubicMMPerVoxel
-        self.labelStats[i,"Volume cc"] = self.labelStats[i,"Volume mm^3"] * ccPerCubicMM
-        self.labelStats[i,"Min"] = stat1.GetMin()[0]
-        self.labelStats[i,"Max"] = stat1.GetMax()[0]
-        self.labelStats[i,"Mean"] = stat1.GetMean()[0]
-        self.labelStats[i,"StdDev"] = stat1.GetStandardDeviation()[0]
-
-        # this.InvokeEvent(vtkLabelStatisticsLogic::LabelStatsInnerLoop, (void*)"1")
+      stats.SetInputConnection(labelNode.GetImageDataConnection())
+      stats.SetGrayscaleConnection(grayscaleNode.GetImageDataConnection())
+    stats.Update()
+
+    for index in xrange(stats.GetNumberOfLabels()):
+      i = stats.GetLabel(index)
+      # add an entry to the LabelStats list
+      self.labelStats["Labels"].append(i)
+      self.labelStats[i,"Index"] = i
+      self.labelStats[i,"Count"] = stats.GetCount(i)
+      self.labelStats[i,"Volume mm^3"] = self.labelStats[i,"Count"] * cubicMMPerVoxel
+      self.labelStats[i,"Volume cc"] = self.labelStats[i,"Volume mm^3"] * ccPerCubicMM
+      self.labelStats[i,"Min"] = stats.GetMin(i)
+      self.labelStats[i,"Max"] = stats.GetMax(i)
+      self.labelStats[i,"Mean"] = stats.GetMean(i)
+      self.labelStats[i,"StdDev"] = stats.GetStandardDeviation(i)
 
     # this.InvokeEvent(vtkLabelStatisticsLogic::EndLabelStats, (void*)"end label stats")
 